@@ -27,8 +27,10 @@ You should have received a copy of the GNU Lesser General Public
 ----------------------------------------------------------------------------
 */
 #include <iostream>
+#include <sstream>
 
 #include "CoiledCoils.h"
+#include "CoiledCoilScanner.h"
 #include "System.h"
 #include "CharmmSystemBuilder.h"
 #include "SystemRotamerLoader.h"
@@ -36,7 +38,6 @@ You should have received a copy of the GNU Lesser General Public
 #include "SelfPairManager.h"
 #include "MslTools.h"
 #include "DeadEndElimination.h"
-#include "Enumerator.h"
 #include "MonteCarloManager.h"
 #include "SelfConsistentMeanField.h"
 #include "HydrogenBondBuilder.h"
@@ -93,6 +94,8 @@ struct Options {
 	// RUN SETTINGS
 	string rotamerSamplingSize;
 	int seed;
+	int threads; // number of threads for the scan (0 = all cores, requires MSL_OPENMP=T)
+	double minCaDistance; // pre-screening: reject the bundles with CA atoms of different helices closer than this
 	bool setState;
 	vector<unsigned int> rotamerStates;
 	string rotamerLibrary; //filename of rotamer library file
@@ -162,6 +165,35 @@ void version();
 void help(Options defaults);
 void saveMin(double _boundE, vector<unsigned int> _stateVec, vector<double> & _minBound, vector<vector<unsigned int> > & _minStates, int _maxSaved, Options & _opt);
 
+/******************************************
+ *  Evaluates a point of the coiled coil scan:
+ *  adds the side chains, loads the rotamers
+ *  and repacks them.  Every thread of the
+ *  scan has its own copy, with its own System
+ *  and rotamer loader
+ ******************************************/
+class CoilEvaluator : public CoiledCoilScanner::Evaluator {
+	public:
+		CoilEvaluator(const Options & _opt, const map<string, map<string, int> > & _rotLevel, const vector<string> & _registerPos);
+		~CoilEvaluator();
+
+		CoiledCoilScanner::Evaluator * clone() const;
+		bool setup(System & _sys);
+		bool evaluate(System & _sys, const CoiledCoilScanner::Parameters & _parameters, double & _energy, string & _annotation);
+
+		bool loadRotamers(System & _sys);
+
+	private:
+		CoilEvaluator(const CoilEvaluator & _evaluator); // not copiable
+		void operator=(const CoilEvaluator & _evaluator);
+
+		Options opt;
+		map<string, map<string, int> > rotLevel;
+		vector<string> registerPos;
+		SystemRotamerLoader * pSysRot;
+		RandomNumberGenerator rng; // private to this clone, seeded per grid point
+};
+
 
 /******************************************
  *  
@@ -434,60 +466,18 @@ int main(int argc, char *argv[]) {
 		rotLevel["VAL"]["H"] = 10;
 
 
-	// Read in Sequence
-	cout << "Reading Polymer sequence" << endl;
-	PolymerSequence seq(opt.sequence);
-
-	// Build Sequence
-	CharmmSystemBuilder CSB(sys, "/library/charmmTopPar/top_all22_prot.inp", "/library/charmmTopPar/par_all22_prot.inp");
-	CSB.setDielectricConstant(80.0);
-	CSB.setVdwRescalingFactor(0.95);
-	CSB.buildSystem(seq);
-
-	// Add Hydrogen Bonds
-	HydrogenBondBuilder HBB(sys, "/data00/bkmueller/dataFiles/hbondlist.txt");
-	HBB.buildInteractions(10.0);
-
-
-	vector<unsigned int> enumCounter;
-
-	// Create Enumerator to Loop over states
-	// Adding 0.00001 is to avoid rounding errors and have the loop go to the end step, this will be fixed later
-	vector<double> r0_vec;
-	for (double r0 = opt.r0_start; r0 <= opt.r0_end + 0.00001; r0+=opt.r0_step) {
-		r0_vec.push_back(r0);
-	}
-	enumCounter.push_back(r0_vec.size());
-	vector<double> r1_vec;
-	for (double r1 = opt.r1_start; r1 <= opt.r1_end + 0.00001; r1+=opt.r1_step) {
-		r1_vec.push_back(r1);
-	}
-	enumCounter.push_back(r1_vec.size());
-	vector<double> w1_vec;
-	for (double w1 = opt.w1_start; w1 <= opt.w1_end + 0.00001; w1+=opt.w1_step) {
-		w1_vec.push_back(w1);
-	}
-	enumCounter.push_back(w1_vec.size());
-	vector<double> phi1_vec;
-	for (double phi1 = opt.phi1_start; phi1 <= opt.phi1_end + 0.00001; phi1+=opt.phi1_step) {
-		phi1_vec.push_back(phi1);
-	}
-	enumCounter.push_back(phi1_vec.size());
-	vector<double> rpr_vec;
-	for (double rpr = opt.rpr_start; rpr <= opt.rpr_end + 0.00001; rpr+=opt.rpr_step) {
-		rpr_vec.push_back(rpr);
+	if (opt.startRegPos.size() != 1 || string("ABCDEFG").find(opt.startRegPos) == string::npos) {
+		cerr << "Incorrect register position entry" << endl;
+		exit(0);
 	}
-	enumCounter.push_back(rpr_vec.size());
-	vector<double> pitch_vec;
-	for (double pitch = opt.pitch_start; pitch <= opt.pitch_end + 0.00001; pitch+=opt.pitch_step) {
-		pitch_vec.push_back(pitch);
+
+	// Build the System (sequence, energy function and hydrogen bonds)
+	cout << "Reading Polymer sequence" << endl;
+	CoilEvaluator evaluator(opt, rotLevel, registerPos);
+	if (!evaluator.setup(sys)) {
+		exit(1);
 	}
-	enumCounter.push_back(pitch_vec.size());
 
-	Enumerator coilStates(enumCounter);
-	vector<double> savedEnergyVector;
-	vector<vector<unsigned int> > savedMCOState;
-	vector<unsigned int> energyVectorIndex;
 
 	if (opt.setState) {
 		cout << "Setting specific rotameric state..." << endl;
@@ -547,162 +537,43 @@ int main(int argc, char *argv[]) {
 		exit(0);
 	}
 
-	// START LOOP!
-	for (int k=0; k < coilStates.size(); k++) {
-		SelfPairManager spm;
-		time_t startTime, endTime;
-		double diffTime;
+	// Scan the parameters
+	vector<string> startingPositions;
+	for (int i = 0; i < opt.startPos.size(); i++) {
+		startingPositions.push_back(opt.startPos[i]);
+	}
 
-		time (&startTime);
+	CoiledCoilScanner scanner;
+	scanner.setR0Range(opt.r0_start, opt.r0_end, opt.r0_step);
+	scanner.setR1Range(opt.r1_start, opt.r1_end, opt.r1_step);
+	scanner.setW1Range(opt.w1_start, opt.w1_end, opt.w1_step);
+	scanner.setPhi1Range(opt.phi1_start, opt.phi1_end, opt.phi1_step);
+	scanner.setRprRange(opt.rpr_start, opt.rpr_end, opt.rpr_step);
+	scanner.setPitchRange(opt.pitch_start, opt.pitch_end, opt.pitch_step);
+	scanner.setBundle(opt.nRes, opt.symmetry, opt.N, startingPositions);
+	scanner.setMinimumCaDistance(opt.minCaDistance);
+	scanner.setNumThreads(opt.threads);
+	scanner.setOutputFile(opt.outputdir + "/energies.txt");
+
+	cout << "Scanning " << scanner.getNumberOfPoints() << " coiled coils on " << scanner.getNumThreads() << " thread(s)" << endl;
+	if (!scanner.scan(evaluator)) {
+		cerr << "ERROR: the scan failed" << endl;
+		exit(1);
+	}
+	cout << "Evaluated " << scanner.getNumberOfResults() << ", pre-screened " << scanner.getNumberOfPrescreened() << ", rejected " << scanner.getNumberOfRejected() << ", failed " << scanner.getNumberOfFailed() << " in " << scanner.getScanTime() << " seconds" << endl;
 
-		// Build Coiled Coil
+	// the variable positions are the same for all points, get them from the best one
+	vector<unsigned int> variablePos;
+	if (scanner.getNumberOfResults() > 0) {
+		const CoiledCoilScanner::Parameters & best = scanner.getResult(0).parameters;
 		sys.wipeAllCoordinates();
-		vector<string> startingPositions;
-		//startingPositions.clear();
-
-		cout << endl;
-		cout << "Building Coiled Coil" << endl;
-		for (int i = 0; i < opt.startPos.size(); i++) {
-			startingPositions.push_back(opt.startPos[i]);
-		}
-
-		if(!cc.setSystemToCoiledCoil(r0_vec[coilStates[k][0]], rpr_vec[coilStates[k][4]], pitch_vec[coilStates[k][5]], r1_vec[coilStates[k][1]], w1_vec[coilStates[k][2]], phi1_vec[coilStates[k][3]], 0.0, opt.nRes, opt.symmetry, opt.N, sys, startingPositions)){
-			cerr << "Error.256" << endl;
-			exit(0);
-		}
-
-		cout << "#################################" << endl;
-		cout << "CYCLE: " << k << " / " << coilStates.size()-1 << endl;
-		cout << "r0: " << setiosflags(ios::fixed) << setprecision(2) << r0_vec[coilStates[k][0]] << endl;
-		cout << "r1: " << r1_vec[coilStates[k][1]] << endl;
-		cout << "w1: " << w1_vec[coilStates[k][2]] << endl;
-		cout << "phi1: " << phi1_vec[coilStates[k][3]] << endl;
-		cout << "rpr: " << rpr_vec[coilStates[k][4]] << endl;
-		cout << "pitch: " << pitch_vec[coilStates[k][5]] << endl;
-		cout << "#################################" << endl;
-
-
-		// Add Side Chains
-		sys.buildAtoms();
-		//Build rotamers
-		time_t startRotTime, endRotTime;
-		double rotTime;
-
-		time (&startRotTime);
-
-		cout << "Adding Rotamers" << endl;
-		SystemRotamerLoader sysRot(sys, opt.rotamerLibrary);
-
-		string rotSamplingLevel;
-		int rotamerAdderPosition = 0;
-		if (!opt.startRegPos.compare("A")) { 
-			rotSamplingLevel = registerPos[0]; 
-			rotamerAdderPosition = 0;
-		}
-		else if (!opt.startRegPos.compare("B")) { 
-			rotSamplingLevel = registerPos[1];
-			rotamerAdderPosition = 1;
-		}
-		else if (!opt.startRegPos.compare("C")) { 
-			rotSamplingLevel = registerPos[2];
-			rotamerAdderPosition = 2;
-		}
-		else if (!opt.startRegPos.compare("D")) { 
-			rotSamplingLevel = registerPos[3];
-			rotamerAdderPosition = 3;
-		}
-		else if (!opt.startRegPos.compare("E")) { 
-			rotSamplingLevel = registerPos[4];
-			rotamerAdderPosition = 4;
-		}
-		else if (!opt.startRegPos.compare("F")) { 
-			rotSamplingLevel = registerPos[5];
-			rotamerAdderPosition = 5;
-		}
-		else if (!opt.startRegPos.compare("G")) { 
-			rotSamplingLevel = registerPos[6];
-			rotamerAdderPosition = 6;
-		}
-		else {
-			cerr << "Incorrect register position entry" << endl;
-			exit(0);
-		}
-
-		for (uint i = 0; i < sys.positionSize();i++){
-			Position &pos = sys.getPosition(i);
-
-			rotSamplingLevel = registerPos[rotamerAdderPosition];
-
-			//if (!sysRot.loadRotamers(&pos, "BALANCED-200", sys.getPosition(i).getResidueName(), 0, rotLevel[sys.getPosition(i).getResidueName()][rotSamplingLevel])) {
-			if (!sysRot.loadRotamers(&pos, sys.getPosition(i).getResidueName(), 0, rotLevel[sys.getPosition(i).getResidueName()][rotSamplingLevel])) {
-				cerr << "ERROR 2: Cannot load rotamers " << sys.getPosition(i).getResidueName() << endl;
-				exit(2);
-			}
-
-			if (rotamerAdderPosition < registerPos.size()-1) {
-				rotamerAdderPosition++;
-			}
-			else {
-				rotamerAdderPosition = 0;
-			}
-
+		if (cc.setSystemToCoiledCoil(best.r0, best.rpr, best.pitch, best.r1, best.w1, best.phi1, 0.0, opt.nRes, opt.symmetry, opt.N, sys, startingPositions)) {
+			sys.buildAtoms();
+			evaluator.loadRotamers(sys);
+			variablePos = sys.getVariablePositions();
 		}
-
-		char c[1000];
-		sprintf(c, "coil-%06u.pdb", k);
-		//char d[1000];
-		//sprintf(d, "%8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f", r0_vec[coilStates[k][0]], w0_vec[coilStates[k][1]], r1_vec[coilStates[k][2]], w1_vec[coilStates[k][3]], phi1_vec[coilStates[k][4]], rpr_vec[coilStates[k][5]], pitch_vec[coilStates[k][6]]);
-		sys.writePdb(c);
-		cout << "Written PDB " << c << endl;
-
-		// Rotamer Addition Time
-		time (&endRotTime);
-		rotTime = difftime (endRotTime, startRotTime);
-		cout << "Rotamer Addition Time: " << rotTime << " seconds" << endl;
-
-		// Calculating Energies
-		time (&startRotTime);
-		spm.setSystem(&sys);
-		spm.calculateEnergies(); 
-		time (&endRotTime);
-		rotTime = difftime (endRotTime, startRotTime);
-		cout << "Energy Calc time: " << rotTime << " seconds" << endl;
-
-		// Run Optimization
-		spm.setRunDEE(opt.runDEE);
-		spm.setRunEnum(opt.runEnum);
-		spm.setRunSCMF(opt.runSCMF);
-		spm.setRunSCMFBiasedMC(opt.runMCO);
-		spm.setVerbose(false);
-		spm.seed(opt.seed);
-
-		spm.runOptimizer();
-
-		// Final Output
-		vector<unsigned int> MCOfinal = spm.getBestSCMFBiasedMCState();
-
-		cout << "MCO accepted state: ";
-		for (int i = 0; i < MCOfinal.size(); i++) {
-			cout << MCOfinal[i] << ",";
-		}
-		cout << endl;
-		cout << "Energy: " << setiosflags(ios::fixed) << setprecision(10) << spm.getStateEnergy(MCOfinal) << endl; 
-
-		// Save the energy, MCO state and the Enumerator state
-		savedEnergyVector.push_back(spm.getStateEnergy(MCOfinal));
-		savedMCOState.push_back(MCOfinal);
-		energyVectorIndex.push_back(k);
-
-		time (&endTime);
-		diffTime = difftime (endTime, startTime);
-		cout << "Seed value: " << spm.getSeed() << endl;
-		cout << "Total Time: " << setiosflags(ios::fixed) << setprecision(0) << diffTime << " seconds" << endl;
 	}
 
-	// Sort Energy Low to High
-	MslTools::quickSortWithIndex(savedEnergyVector, energyVectorIndex);
-	vector<unsigned int> variablePos = sys.getVariablePositions();
-
 	ofstream resultsFile_fs;
 	resultsFile_fs.open(opt.resultsFile.c_str());
 	if (resultsFile_fs.fail()) {
@@ -718,42 +589,9 @@ int main(int argc, char *argv[]) {
 		resultsFile_fs << c;
 	}
 	resultsFile_fs << endl;
-	
-	for (int i=0; i < savedEnergyVector.size(); i++) {
-		// energy
-		sprintf(c, "%25.4f", savedEnergyVector[i]);
-		resultsFile_fs << c;
-
-		// coiled coil parameters
-		sprintf(c, "%10.4f%10.4f%10.4f%10.4f%10.4f%10.4f", r0_vec[coilStates[energyVectorIndex[i]][0]], r1_vec[coilStates[energyVectorIndex[i]][1]], w1_vec[coilStates[energyVectorIndex[i]][2]], phi1_vec[coilStates[energyVectorIndex[i]][3]], rpr_vec[coilStates[energyVectorIndex[i]][4]], pitch_vec[coilStates[energyVectorIndex[i]][5]]);
-		resultsFile_fs << c;
 
-		// rotamer index of each variable position
-		string line;
-		for (int j = 0; j < savedMCOState[energyVectorIndex[i]].size(); j++) {
-			sprintf(c, "%4u", savedMCOState[energyVectorIndex[i]][j]);
-			line += c;
-		}
-		resultsFile_fs << line << endl;
-
-		/*
-		opt.resultsFile += "NO. " + MslTools::intToString(i) + "\n";
-		opt.resultsFile += "Energy: " + savedEnergyVector[i] + "\n";
-		opt.resultsFile += "MCO state: ";
-		for (int j = 0; j < savedMCOState[energyVectorIndex[i]].size(); j++) {
-			opt.resultsFile += savedMCOState[energyVectorIndex[i]][j] + ",";
-		}
-		opt.resultsFile += "\n";
-		opt.resultsFile += "r0: " + setiosflags(ios::fixed) + setprecision(2) + r0_vec[coilStates[energyVectorIndex[i]][0]];
-		opt.resultsFile += "\tr1: " + r1_vec[coilStates[energyVectorIndex[i]][1]];
-		opt.resultsFile += "\tw1: " + w1_vec[coilStates[energyVectorIndex[i]][2]];
-		opt.resultsFile += "\tphi1: " + phi1_vec[coilStates[energyVectorIndex[i]][3]];
-		opt.resultsFile += "\trpr: " + rpr_vec[coilStates[energyVectorIndex[i]][4]];
-		opt.resultsFile += "\tpitch: " + pitch_vec[coilStates[energyVectorIndex[i]][5]] + "\n";
-		*/
-	}
-
-	//resultsFile_fs << opt.resultsFile;
+	// energy, coiled coil parameters and rotamer index of each variable position, sorted by energy
+	scanner.writeResults(resultsFile_fs);
 	resultsFile_fs.close();
 
 	// Key File Output
@@ -778,6 +616,9 @@ int main(int argc, char *argv[]) {
 	resultsFile_fs << "9) Rotameric state of the second variable position" << endl;
 	resultsFile_fs << "10) ... etc (up to the number of variable positions)" << endl;
 	resultsFile_fs << "" << endl;
+	resultsFile_fs << "The file energies.txt has the same fields, preceded by the index of the coiled coil" << endl;
+	resultsFile_fs << "(the number of its coil-XXXXXX.pdb file), in order of evaluation" << endl;
+	resultsFile_fs << "" << endl;
 
 	resultsFile_fs.close();
 
@@ -793,6 +634,143 @@ int main(int argc, char *argv[]) {
 /*****************************************
  *       OTHER FUNCTIONS
  ****************************************/
+CoilEvaluator::CoilEvaluator(const Options & _opt, const map<string, map<string, int> > & _rotLevel, const vector<string> & _registerPos) {
+	opt = _opt;
+	rotLevel = _rotLevel;
+	registerPos = _registerPos;
+	pSysRot = NULL;
+}
+
+CoilEvaluator::~CoilEvaluator() {
+	delete pSysRot;
+}
+
+CoiledCoilScanner::Evaluator * CoilEvaluator::clone() const {
+	return new CoilEvaluator(opt, rotLevel, registerPos);
+}
+
+bool CoilEvaluator::setup(System & _sys) {
+	// Read in Sequence
+	PolymerSequence seq(opt.sequence);
+
+	// Build Sequence
+	CharmmSystemBuilder CSB(_sys, "/library/charmmTopPar/top_all22_prot.inp", "/library/charmmTopPar/par_all22_prot.inp");
+	CSB.setDielectricConstant(80.0);
+	CSB.setVdwRescalingFactor(0.95);
+	if (!CSB.buildSystem(seq)) {
+		cerr << "ERROR: Cannot build the system" << endl;
+		return false;
+	}
+
+	// Add Hydrogen Bonds
+	HydrogenBondBuilder HBB(_sys, "/data00/bkmueller/dataFiles/hbondlist.txt");
+	HBB.buildInteractions(10.0);
+
+	// the rotamer library is read once per system
+	delete pSysRot;
+	pSysRot = new SystemRotamerLoader(_sys, opt.rotamerLibrary);
+	return true;
+}
+
+bool CoilEvaluator::loadRotamers(System & _sys) {
+	// the number of rotamers depends on the heptad position
+	int rotamerAdderPosition = string("ABCDEFG").find(opt.startRegPos);
+	for (uint i = 0; i < _sys.positionSize();i++){
+		Position &pos = _sys.getPosition(i);
+
+		string rotSamplingLevel = registerPos[rotamerAdderPosition];
+
+		if (!pSysRot->loadRotamers(&pos, _sys.getPosition(i).getResidueName(), 0, rotLevel[_sys.getPosition(i).getResidueName()][rotSamplingLevel])) {
+			cerr << "ERROR 2: Cannot load rotamers " << _sys.getPosition(i).getResidueName() << endl;
+			return false;
+		}
+
+		if (rotamerAdderPosition < registerPos.size()-1) {
+			rotamerAdderPosition++;
+		}
+		else {
+			rotamerAdderPosition = 0;
+		}
+	}
+	return true;
+}
+
+bool CoilEvaluator::evaluate(System & _sys, const CoiledCoilScanner::Parameters & _parameters, double & _energy, string & _annotation) {
+	time_t startTime, endTime;
+	time (&startTime);
+
+	// the output of each point is printed at once, the points are evaluated in parallel
+	stringstream out;
+	out << endl;
+	out << "#################################" << endl;
+	out << "CYCLE: " << _parameters.index << endl;
+	out << "r0: " << setiosflags(ios::fixed) << setprecision(2) << _parameters.r0 << endl;
+	out << "r1: " << _parameters.r1 << endl;
+	out << "w1: " << _parameters.w1 << endl;
+	out << "phi1: " << _parameters.phi1 << endl;
+	out << "rpr: " << _parameters.rpr << endl;
+	out << "pitch: " << _parameters.pitch << endl;
+	out << "#################################" << endl;
+
+	// Add Side Chains
+	_sys.buildAtoms();
+
+	//Build rotamers
+	if (!loadRotamers(_sys)) {
+		return false;
+	}
+
+	char c[1000];
+	sprintf(c, "coil-%06u.pdb", _parameters.index);
+	_sys.writePdb(c);
+	out << "Written PDB " << c << endl;
+
+	// Calculating Energies
+	SelfPairManager spm;
+	spm.setSystem(&_sys);
+	spm.calculateEnergies(); 
+
+	// Run Optimization
+	spm.setRunDEE(opt.runDEE);
+	spm.setRunEnum(opt.runEnum);
+	spm.setRunSCMF(opt.runSCMF);
+	spm.setRunSCMFBiasedMC(opt.runMCO);
+	spm.setVerbose(false);
+	// the stream of each grid point depends only on the seed and the grid
+	// index, not on which clone or thread evaluates it
+	rng.setSeed(opt.seed, _parameters.index);
+	spm.setRandomNumberGenerator(&rng);
+
+	spm.runOptimizer();
+
+	// Final Output
+	vector<unsigned int> MCOfinal = spm.getBestSCMFBiasedMCState();
+	_energy = spm.getStateEnergy(MCOfinal);
+
+	// rotamer index of each variable position
+	_annotation = "";
+	out << "MCO accepted state: ";
+	for (int i = 0; i < MCOfinal.size(); i++) {
+		out << MCOfinal[i] << ",";
+		sprintf(c, "%4u", MCOfinal[i]);
+		_annotation += c;
+	}
+	out << endl;
+	out << "Energy: " << setiosflags(ios::fixed) << setprecision(10) << _energy << endl; 
+
+	time (&endTime);
+	out << "Seed value: " << spm.getSeed() << endl;
+	out << "Total Time: " << setiosflags(ios::fixed) << setprecision(0) << difftime(endTime, startTime) << " seconds" << endl;
+#ifdef __OPENMP__
+	#pragma omp critical(coilEvaluatorOutput)
+#endif
+	{
+		cout << out.str() << flush;
+	}
+
+	return true;
+}
+
 void saveMin(double _boundE, vector<unsigned int> _stateVec, vector<double> & _minBound, vector<vector<unsigned int> > & _minStates, int _maxSaved, Options & _opt) {
 
 	// case the list is emtpy
@@ -907,6 +885,8 @@ Options parseOptions(int _argc, char * _argv[], Options defaults) {
 
 	opt.allowed.push_back("rotamerSamplingSize");
 	opt.allowed.push_back("seed");
+	opt.allowed.push_back("threads");
+	opt.allowed.push_back("minCaDistance");
 	opt.required.push_back("rotamerLibrary"); //filename of rotamer library file
 	opt.allowed.push_back("outputdir");
 	opt.allowed.push_back("outputfile"); //filename of output file
@@ -1168,6 +1148,14 @@ Options parseOptions(int _argc, char * _argv[], Options defaults) {
 
 	opt.rotamerSamplingSize = OP.getString("rotamerSamplingSize");
 	opt.seed = OP.getInt("seed");
+	opt.threads = OP.getInt("threads");
+	if (OP.fail()) {
+		opt.threads = 0;
+	}
+	opt.minCaDistance = OP.getDouble("minCaDistance");
+	if (OP.fail()) {
+		opt.minCaDistance = 0.0;
+	}
 	opt.runDEE = OP.getBool("runDEE");
 	opt.runEnum = OP.getBool("runEnum");
 	opt.runSCMF = OP.getBool("runSCMF");
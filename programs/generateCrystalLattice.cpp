@@ -47,7 +47,12 @@ int main(int argc, char *argv[]){
 	CrystalLattice cl(opt.pdb);
 
 	cout << "Generating Crystal Lattice"<<endl;
-	cl.generateCrystal();
+	if (opt.contactDistance > 0.0) {
+		// only the units within contactDistance of the original
+		cl.generateContactingUnits(opt.contactDistance);
+	} else {
+		cl.generateCrystal();
+	}
 	cout << "Writing out Crystal Lattice"<<endl;
 	cl.writeCrystalUnits(opt.outfile,true,opt.singleFile,opt.renameChainsExcept,false);
 
@@ -73,6 +78,7 @@ Options setupOptions(int theArgc, char * theArgv[]){
 		cout << "#outfile FILE\n";
 		cout << "#singleFile 1\n";
 		cout << "#renameChains Z\n";
+		cout << "#contactDistance 5.0\n";
 		cout << endl;
 		exit(0);
 	}
@@ -118,5 +124,10 @@ Options setupOptions(int theArgc, char * theArgv[]){
 		opt.renameChainsExcept = "";
 	}
 
+	opt.contactDistance = OP.getDouble("contactDistance");
+	if (OP.fail()){
+		opt.contactDistance = 0.0;
+	}
+
 	return opt;
 }
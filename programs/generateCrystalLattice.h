@@ -43,6 +43,7 @@ struct Options {
 		optional.push_back("singleFile");
 		optional.push_back("nmrStyleFile");
 		optional.push_back("renameChainsExcept");
+		optional.push_back("contactDistance");
 
 		// Debug,help options
 		optional.push_back("debug");
@@ -64,6 +65,7 @@ struct Options {
 	bool singleFile;
 	bool nmrStyleFile;
 	std::string renameChainsExcept;
+	double contactDistance;
 
 	bool debug;
 	bool help;
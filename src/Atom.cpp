@@ -548,112 +548,141 @@ unsigned int Atom::getGroupNumber() const {
 	}
 }
 
+void Atom::addBond(Atom * _pAtom2) {
+	vector<Atom*>::iterator found = lower_bound(bonds.begin(), bonds.end(), _pAtom2);
+	if (found == bonds.end() || *found != _pAtom2) {
+		bonds.insert(found, _pAtom2);
+	}
+}
+
+void Atom::addOneThree(Atom * _pAtom3, Atom * _pAtom2) {
+	pair<Atom*, Atom*> entry(_pAtom3, _pAtom2);
+	vector<pair<Atom*, Atom*> >::iterator found = lower_bound(oneThreeAtoms.begin(), oneThreeAtoms.end(), entry);
+	if (found == oneThreeAtoms.end() || *found != entry) {
+		oneThreeAtoms.insert(found, entry);
+	}
+}
+
+void Atom::addOneFour(Atom * _pAtom4, Atom * _pAtom2, Atom * _pAtom3) {
+	pair<Atom*, pair<Atom*, Atom*> > entry(_pAtom4, pair<Atom*, Atom*>(_pAtom2, _pAtom3));
+	vector<pair<Atom*, pair<Atom*, Atom*> > >::iterator found = lower_bound(oneFourAtoms.begin(), oneFourAtoms.end(), entry);
+	if (found == oneFourAtoms.end() || *found != entry) {
+		oneFourAtoms.insert(found, entry);
+	}
+}
+
+vector<Atom*> Atom::getOneThreeAtomsThrough(Atom * _pAtom2) const {
+	vector<Atom*> thirdAtoms;
+	for (vector<pair<Atom*, Atom*> >::const_iterator k=oneThreeAtoms.begin(); k!=oneThreeAtoms.end(); k++) {
+		if (k->second == _pAtom2) {
+			thirdAtoms.push_back(k->first);
+		}
+	}
+	return thirdAtoms;
+}
+
 void Atom::setBoundTo(Atom * _pAtom) {
-	boundAtoms[_pAtom]; // create 1-2
-	_pAtom->boundAtoms[this]; // create reciprocal 1-2
+	addBond(_pAtom); // create 1-2
+	_pAtom->addBond(this); // create reciprocal 1-2
 
 	// to all 1-2 atoms of this atom, add a 1-3 through _pAtom
-	for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k=_pAtom->boundAtoms.begin(); k!=_pAtom->boundAtoms.end(); k++) {
-		if (k->first == this) {
+	vector<Atom*> bonded = _pAtom->bonds;
+	for (vector<Atom*>::iterator k=bonded.begin(); k!=bonded.end(); k++) {
+		if (*k == this) {
 			continue;
 		}
-		if (this->getParentPosition() == k->first->getParentPosition() && this->getParentResidue() != k->first->getParentResidue()) {
+		if (this->getParentPosition() == (*k)->getParentPosition() && this->getParentResidue() != (*k)->getParentResidue()) {
 			// exclude if the atoms that are on different identities of the same position
 			continue;
 		}
-		boundAtoms[_pAtom][k->first]; // create 1-3
-		k->first->boundAtoms[_pAtom][this]; // create reciprocal 1-3
-		oneThreeAtoms[k->first][_pAtom] = true;
-		k->first->oneThreeAtoms[this][_pAtom] = true;
+		addOneThree(*k, _pAtom); // create 1-3
+		(*k)->addOneThree(this, _pAtom); // create reciprocal 1-3
 
 
 		// to all 1-2 atoms of the 1-2 atom, add a 1-4 through _pAtom and its 1-2 atom
-		for (map<Atom*, map<Atom*, bool> >::iterator l=k->second.begin(); l!=k->second.end(); l++) {
-			if (l->first == this || l->first == _pAtom) {
+		vector<Atom*> fourthAtoms = _pAtom->getOneThreeAtomsThrough(*k);
+		for (vector<Atom*>::iterator l=fourthAtoms.begin(); l!=fourthAtoms.end(); l++) {
+			if (*l == this || *l == _pAtom) {
 				continue;
 			}
-			if (this->getParentPosition() == l->first->getParentPosition() && this->getParentResidue() != l->first->getParentResidue()) {
+			if (this->getParentPosition() == (*l)->getParentPosition() && this->getParentResidue() != (*l)->getParentResidue()) {
 				// exclude if the atoms that are on different identities of the same position
 				continue;
 			}
-			boundAtoms[_pAtom][k->first][l->first] = true; // create 1-4
-			l->first->boundAtoms[k->first][_pAtom][this] = true; // create reciprocal 1-4
-			oneFourAtoms[l->first][_pAtom][k->first] = true;
-			l->first->oneFourAtoms[this][k->first][_pAtom] = true;
+			addOneFour(*l, _pAtom, *k); // create 1-4
+			(*l)->addOneFour(this, *k, _pAtom); // create reciprocal 1-4
 		}
 	}
 	// to all 1-2 atoms of _pAtom, add a 1-3 through this atom
-	for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-		if (k->first == _pAtom) {
+	bonded = bonds;
+	for (vector<Atom*>::iterator k=bonded.begin(); k!=bonded.end(); k++) {
+		if (*k == _pAtom) {
 			continue;
 		}
-		if (_pAtom->getParentPosition() == k->first->getParentPosition() && _pAtom->getParentResidue() != k->first->getParentResidue()) {
+		if (_pAtom->getParentPosition() == (*k)->getParentPosition() && _pAtom->getParentResidue() != (*k)->getParentResidue()) {
 			// exclude if the atoms that are on different identities of the same position
 			continue;
 		}
-		_pAtom->boundAtoms[this][k->first]; // create 1-3
-		k->first->boundAtoms[this][_pAtom]; // create reciprocal 1-3
-		_pAtom->oneThreeAtoms[k->first][this] = true;
-		k->first->oneThreeAtoms[_pAtom][this] = true;
+		_pAtom->addOneThree(*k, this); // create 1-3
+		(*k)->addOneThree(_pAtom, this); // create reciprocal 1-3
 
 
 		// to all 1-2 atoms of the 1-2 atom, add a 1-4 through _pAtom and its 1-2 atom
-		for (map<Atom*, map<Atom*, bool> >::iterator l=k->second.begin(); l!=k->second.end(); l++) {
-			if (l->first == this || l->first == _pAtom) {
+		vector<Atom*> fourthAtoms = getOneThreeAtomsThrough(*k);
+		for (vector<Atom*>::iterator l=fourthAtoms.begin(); l!=fourthAtoms.end(); l++) {
+			if (*l == this || *l == _pAtom) {
 				continue;
 			}
-			if (_pAtom->getParentPosition() == l->first->getParentPosition() && _pAtom->getParentResidue() != l->first->getParentResidue()) {
+			if (_pAtom->getParentPosition() == (*l)->getParentPosition() && _pAtom->getParentResidue() != (*l)->getParentResidue()) {
 				// exclude if the atoms that are on different identities of the same position
 				continue;
 			}
-			_pAtom->boundAtoms[this][k->first][l->first] = true; // create 1-4
-			l->first->boundAtoms[k->first][this][_pAtom] = true; // create reciprocal 1-4
-			_pAtom->oneFourAtoms[l->first][this][k->first] = true;
-			l->first->oneFourAtoms[_pAtom][k->first][this] = true;
+			_pAtom->addOneFour(*l, this, *k); // create 1-4
+			(*l)->addOneFour(_pAtom, *k, this); // create reciprocal 1-4
 		}
 	}
 	
 	// finally, combinatorially add 1-4 relationships between all 1-2 atoms of this atom and _pAtom
-	for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-		if (k->first == _pAtom) {
+	vector<Atom*> bondedToOther = _pAtom->bonds;
+	for (vector<Atom*>::iterator k=bonded.begin(); k!=bonded.end(); k++) {
+		if (*k == _pAtom) {
 			continue;
 		}
-		if (_pAtom->getParentPosition() == k->first->getParentPosition() && _pAtom->getParentResidue() != k->first->getParentResidue()) {
+		if (_pAtom->getParentPosition() == (*k)->getParentPosition() && _pAtom->getParentResidue() != (*k)->getParentResidue()) {
 			// exclude if the atoms that are on different identities of the same position
 			continue;
 		}
-		for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator l=_pAtom->boundAtoms.begin(); l!=_pAtom->boundAtoms.end(); l++) {
-			if (l->first == this || l->first == k->first) {
+		for (vector<Atom*>::iterator l=bondedToOther.begin(); l!=bondedToOther.end(); l++) {
+			if (*l == this || *l == *k) {
 				continue;
 			}
-			if (this->getParentPosition() == l->first->getParentPosition() && this->getParentResidue() != l->first->getParentResidue()) {
+			if (this->getParentPosition() == (*l)->getParentPosition() && this->getParentResidue() != (*l)->getParentResidue()) {
 				// exclude if the atoms that are on different identities of the same position
 				continue;
 			}
-			if (k->first->getParentPosition() == l->first->getParentPosition() && k->first->getParentResidue() != l->first->getParentResidue()) {
+			if ((*k)->getParentPosition() == (*l)->getParentPosition() && (*k)->getParentResidue() != (*l)->getParentResidue()) {
 				// exclude if the atoms that are on different identities of the same position
 				continue;
 			}
-			k->first->boundAtoms[this][_pAtom][l->first] = true; // create 1-4 beetween the 1-2 or this and the 1-2 of _pAtom
-			l->first->boundAtoms[_pAtom][this][k->first] = true; // create reciprocal 1-4
-			k->first->oneFourAtoms[l->first][this][_pAtom] = true;
-			l->first->oneFourAtoms[k->first][_pAtom][this] = true;
+			(*k)->addOneFour(*l, this, _pAtom); // create 1-4 beetween the 1-2 or this and the 1-2 of _pAtom
+			(*l)->addOneFour(*k, _pAtom, this); // create reciprocal 1-4
 		}
 	}
 }
 
 void Atom::setUnboundFromAll(bool _propagate) {
 	// return if there are no bonds
-	if (boundAtoms.size() == 0) {
+	if (bonds.size() == 0) {
 		return;
 	}
 	if (_propagate) {
 		// remove the bond to this atoms from all bound atoms
-		for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k = boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-			k->first->setUnboundFrom(this, false);
+		vector<Atom*> bonded = bonds;
+		for (vector<Atom*>::iterator k = bonded.begin(); k!=bonded.end(); k++) {
+			(*k)->setUnboundFrom(this, false);
 		}
 	}
-	boundAtoms.clear();
+	bonds.clear();
 	oneThreeAtoms.clear();
 	oneFourAtoms.clear();
 
@@ -661,16 +690,11 @@ void Atom::setUnboundFromAll(bool _propagate) {
 
 void Atom::setUnboundFrom(Atom * _pAtom, bool _propagate) {
 
-	map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator found = boundAtoms.find(_pAtom);
-	if (found != boundAtoms.end()) {
+	if (isBoundTo(_pAtom)) {
 		// atom is bound: erase it
 
 		// find all atoms that are connected through _pAtom
-		vector<Atom *> thirdAtoms;
-		for (map<Atom*, map<Atom*, bool> >::iterator k = found->second.begin(); k!=found->second.end(); k++) {
-			thirdAtoms.push_back(k->first);
-		}
-
+		vector<Atom *> thirdAtoms = getOneThreeAtomsThrough(_pAtom);
 
 		// remove all the 1-3 and 1-4 references through _pAtom
 		for (vector<Atom*>::iterator third=thirdAtoms.begin(); third!=thirdAtoms.end(); third++) {
@@ -678,18 +702,18 @@ void Atom::setUnboundFrom(Atom * _pAtom, bool _propagate) {
 			purge13(_pAtom, *third);
 		}
 
-		// erase the bond (it was most likely erased by the purge functions but just in case)
-		boundAtoms.erase(found);
+		// erase the bond
+		bonds.erase(lower_bound(bonds.begin(), bonds.end(), _pAtom));
 
 
 		// remove all the 1-3 and 1-4 through _pAtom from the atoms bound to this
-		for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k = boundAtoms.begin(); k!=boundAtoms.end(); k++) {
+		for (vector<Atom*>::iterator k = bonds.begin(); k!=bonds.end(); k++) {
 
-			k->first->purge14mid(this, _pAtom);
-			k->first->purge13(this, _pAtom);
+			(*k)->purge14mid(this, _pAtom);
+			(*k)->purge13(this, _pAtom);
 			// and remove all the 1-4 through this and _pAtom from the atoms bound to those atoms
-			for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator kk = k->first->boundAtoms.begin(); kk!=k->first->boundAtoms.end(); kk++) {
-				kk->first->purge14end(this, _pAtom);
+			for (vector<Atom*>::iterator kk = (*k)->bonds.begin(); kk!=(*k)->bonds.end(); kk++) {
+				(*kk)->purge14end(this, _pAtom);
 			}
 		}
 		// call the same function on the other atoms (the _propagate=false means to call this back)
@@ -703,30 +727,16 @@ void Atom::setUnboundFrom(Atom * _pAtom, bool _propagate) {
 
 void Atom::purge13(Atom * _pAtom2, Atom * _pAtom3) {
 	/*********************************************************
-	 *  Remove all 1-3 references that are 
+	 *  Remove the 1-3 reference
 	 *
 	 *    this -- _pAtom2 -- _pAtom3
 	 *
-	 *  corresponding to
-	 *    boundAtoms[_pAtom2][_pAtom3]
-	 *    oneThreeAtoms[_pAtom3][_pAtom2]
+	 *  corresponding to oneThreeAtoms (_pAtom3,_pAtom2)
 	 *********************************************************/
-	map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator found1=boundAtoms.find(_pAtom2);
-	if (found1 != boundAtoms.end()) {
-		map<Atom*, map<Atom*, bool> >::iterator found2 = found1->second.find(_pAtom3);
-		if (found2 != found1->second.end()) {
-			found1->second.erase(found2);
-		}
-	}
-	map<Atom*, map<Atom*, bool> >::iterator found3 = oneThreeAtoms.find(_pAtom3);
-	if (found3 != oneThreeAtoms.end()) {
-		map<Atom*, bool>::iterator found4 = found3->second.find(_pAtom2);
-		if (found4 != found3->second.end()) {
-			found3->second.erase(found4);
-		}
-		if (found3->second.size() == 0) {
-			oneThreeAtoms.erase(found3);
-		}
+	pair<Atom*, Atom*> entry(_pAtom3, _pAtom2);
+	vector<pair<Atom*, Atom*> >::iterator found = lower_bound(oneThreeAtoms.begin(), oneThreeAtoms.end(), entry);
+	if (found != oneThreeAtoms.end() && *found == entry) {
+		oneThreeAtoms.erase(found);
 	}
 }
 
@@ -736,40 +746,16 @@ void Atom::purge14mid(Atom * _pAtom2, Atom * _pAtom3) {
 	 *
 	 *    this -- _pAtom2 -- _pAtom3 -- any atom
 	 *
-	 *  corresponding to
-	 *    boundAtoms[_pAtom2][_pAtom3][any]
-	 *    oneFourAtoms[any][_pAtom2][_pAtom3]
+	 *  corresponding to oneFourAtoms (any,(_pAtom2,_pAtom3))
 	 *********************************************************/
-	vector<Atom*> fourthAtoms;
-	map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator found1=boundAtoms.find(_pAtom2);
-	if (found1 != boundAtoms.end()) {
-		map<Atom*, map<Atom*, bool> >::iterator found2 = found1->second.find(_pAtom3);
-		if (found2 != found1->second.end()) {
-			for (map<Atom*, bool>::iterator k=found2->second.begin(); k!=found2->second.end(); k++) {
-				fourthAtoms.push_back(k->first);
-			}
-			found1->second.erase(found2);
-		}
-	}
-
-	for (vector<Atom*>::iterator k=fourthAtoms.begin(); k!=fourthAtoms.end(); k++) {
-		map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator found3 = oneFourAtoms.find(*k);
-		if (found3 != oneFourAtoms.end()) {
-			map<Atom*, map<Atom*, bool> >::iterator found4 = found3->second.find(_pAtom2);
-			if (found4 != found3->second.end()) {
-				map<Atom*, bool>::iterator found5 = found4->second.find(_pAtom3);
-				if (found5 != found4->second.end()) {
-					found4->second.erase(found5);
-				}
-				if (found4->second.size() == 0) {
-					found3->second.erase(found4);
-				}
-			}
-			if (found3->second.size() == 0) {
-				oneFourAtoms.erase(found3);
-			}
+	vector<pair<Atom*, pair<Atom*, Atom*> > >::iterator last = oneFourAtoms.begin();
+	for (vector<pair<Atom*, pair<Atom*, Atom*> > >::iterator k=oneFourAtoms.begin(); k!=oneFourAtoms.end(); k++) {
+		if (k->second.first != _pAtom2 || k->second.second != _pAtom3) {
+			*last = *k;
+			last++;
 		}
 	}
+	oneFourAtoms.erase(last, oneFourAtoms.end());
 }
 
 void Atom::purge14end(Atom * _pAtom3, Atom * _pAtom4) {
@@ -778,34 +764,14 @@ void Atom::purge14end(Atom * _pAtom3, Atom * _pAtom4) {
 	 *
 	 *    this -- any atom -- _pAtom3 -- _pAtom4
 	 *
-	 *  corresponding to
-	 *    boundAtoms[any][_pAtom3][_pAtom4]
-	 *    oneFourAtoms[_pAtom4][any][_pAtom3]
+	 *  corresponding to oneFourAtoms (_pAtom4,(any,_pAtom3))
 	 *********************************************************/
-	for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-		map<Atom*, map<Atom*, bool> >::iterator found1 = k->second.find(_pAtom3);
-		if (found1 != k->second.end()) {
-			map<Atom*, bool>::iterator found2 = found1->second.find(_pAtom4);
-			if (found2 != found1->second.end()) {
-				found1->second.erase(found2);
-			}
-		}
-	}
-	map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator found3 = oneFourAtoms.find(_pAtom4);
-	if (found3 != oneFourAtoms.end()) {
-		for (map<Atom*, map<Atom*, bool> >::iterator k=found3->second.begin(); k!=found3->second.end();) {
-			map<Atom*, bool>::iterator found4 = k->second.find(_pAtom3);
-			if (found4 != k->second.end()) {
-				k->second.erase(found4);
-			}
-			map<Atom*, map<Atom*, bool> >::iterator tmp = k;
+	vector<pair<Atom*, pair<Atom*, Atom*> > >::iterator k = lower_bound(oneFourAtoms.begin(), oneFourAtoms.end(), make_pair(_pAtom4, pair<Atom*, Atom*>((Atom*)NULL, (Atom*)NULL)));
+	while (k!=oneFourAtoms.end() && k->first == _pAtom4) {
+		if (k->second.second == _pAtom3) {
+			k = oneFourAtoms.erase(k);
+		} else {
 			k++;
-			if (tmp->second.size() == 0) {
-				found3->second.erase(tmp);
-			}
-		}
-		if (found3->second.size() == 0) {
-			oneFourAtoms.erase(found3);
 		}
 	}
 }
@@ -865,16 +831,20 @@ set<Atom*> Atom::findLinkedAtoms(const set<Atom*> & _excluded) {
 //	// get all the atoms that are directly bonded to _pAtom
 //	map<Atom*, bool> bonded = _pAtom->getBonds();
 
+	// walk the bonds with a stack of atoms to visit (a recursion that copied the
+	// exclusion list at every step made it quadratic on the size of the protein)
 	set<Atom*> linked;
-	for (map<Atom*, map<Atom*, map<Atom*, bool> > >::iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-		if (_excluded.find(k->first) != _excluded.end()) {
-			continue;
+	vector<Atom*> toVisit(1, this);
+	while (toVisit.size() > 0) {
+		Atom * pAtom = toVisit.back();
+		toVisit.pop_back();
+		for (vector<Atom*>::iterator k=pAtom->bonds.begin(); k!=pAtom->bonds.end(); k++) {
+			if (*k == this || _excluded.find(*k) != _excluded.end() || linked.find(*k) != linked.end()) {
+				continue;
+			}
+			linked.insert(*k);
+			toVisit.push_back(*k);
 		}
-		linked.insert(k->first);
-		set<Atom*> localExcluded = _excluded;
-		localExcluded.insert(this);
-		set<Atom*> linkedToBonded = k->first->findLinkedAtoms(localExcluded);
-		linked.insert(linkedToBonded.begin(), linkedToBonded.end());
 	}
 	return linked;
 /*
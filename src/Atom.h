@@ -38,6 +38,7 @@ You should have received a copy of the GNU Lesser General Public
 #include <string>
 #include <map>
 #include <set>
+#include <algorithm>
 
 
 // MSL Includes
@@ -458,6 +459,10 @@ class Atom : public Selectable<Atom> {
 		void deletePointers();
 		void updateResidueMap();
 		void updateContainerMap();
+		void addBond(Atom * _pAtom2);
+		void addOneThree(Atom * _pAtom3, Atom * _pAtom2); // this-_pAtom2-_pAtom3
+		void addOneFour(Atom * _pAtom4, Atom * _pAtom2, Atom * _pAtom3); // this-_pAtom2-_pAtom3-_pAtom4
+		std::vector<Atom*> getOneThreeAtomsThrough(Atom * _pAtom2) const; // all the 1-3 atoms through the bound atom _pAtom2
 		void purge13(Atom * _pAtom2, Atom * _pAtom3);
 		void purge14mid(Atom * _pAtom2, Atom * _pAtom3);
 		void purge14end(Atom * _pAtom3, Atom * _pAtom4);
@@ -509,27 +514,24 @@ class Atom : public Selectable<Atom> {
 
 		/*********************************************************
 		 *  Structure that record what other atoms are bound (directly
-		 *  or indirectly up to 1-4) to this atom
+		 *  or indirectly up to 1-4) to this atom.  They are sorted
+		 *  arrays, searched with a binary search
 		 *
 		 *      E   F          bound atoms of A (this)
-		 *       \ /             boundAtoms[B]            A-B 1-2
-		 *        B                boundAtoms[B][E]       A-B-E: 1-3
-		 *        |                boundAtoms[B][F]
-		 *       *A      K       boundAtoms[D]            A-D: 1-2
-		 *       / \    /          boundAtoms[D][I]       A-D-I: 1-3
-		 *   G--C   D--I             boundAtoms[D][I][K]  A-D-I-K: 1-4
-		 *      |   |   \
-		 *      H   J    L     1-3 atoms of A
-		 *         /             oneThreeAtoms[E][B]      E is 1-3 through B
-		 *        M              oneThreeAtoms[I][D]      D is 1-3 through D
-		 *                         
-		 *                     1-4 atoms of A (note the unexpected order 4->2->3)
-		 *                       oneFourAtoms[K][D][I]    K is 1-4 through D-I
-		 *                       oneFourAtoms[M][D][J]    M is 1-4 through D-J
+		 *       \ /             bonds: B C D             A-B A-C A-D: 1-2
+		 *        B
+		 *        |            1-3 atoms of A
+		 *       *A      K       oneThreeAtoms (E,B)      E is 1-3 through B
+		 *       / \    /        oneThreeAtoms (I,D)      I is 1-3 through D
+		 *   G--C   D--I
+		 *      |   |   \      1-4 atoms of A (note the order 4->2->3)
+		 *      H   J    L       oneFourAtoms (K,(D,I))   K is 1-4 through D-I
+		 *         /             oneFourAtoms (M,(D,J))   M is 1-4 through D-J
+		 *        M
 		 *********************************************************/
-		std::map<Atom*, std::map<Atom*, std::map<Atom*, bool> > > boundAtoms;
-		std::map<Atom*, std::map<Atom*, bool> > oneThreeAtoms; // oneThreeAtoms[X][Y] corresponds to this-Y-X
-		std::map<Atom*, std::map<Atom*, std::map<Atom*, bool> > > oneFourAtoms; // oneFourAtoms[X][Y][Z] corresponds to this-Y-Z-X
+		std::vector<Atom*> bonds;
+		std::vector<std::pair<Atom*, Atom*> > oneThreeAtoms; // (X,Y) corresponds to this-Y-X
+		std::vector<std::pair<Atom*, std::pair<Atom*, Atom*> > > oneFourAtoms; // (X,(Y,Z)) corresponds to this-Y-Z-X
 
 		// BOOST-RELATED FUNCTIONS , keep them away from main class def.
 #ifdef __BOOST__
@@ -781,21 +783,20 @@ inline bool Atom::applySavedCoor(std::string _coordName) {
 //inline std::vector<Atom*> Atom::getBoundAtoms() const {std::vector<Atom*> bonded; for (std::map<Atom*, std::map<Atom*, std::map<Atom*, bool> > >::const_iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {bonded.push_back(k->first);} return bonded;}
 //inline std::map<Atom*, bool> & Atom::getBonds() {return bonds;}
 inline std::vector<Atom*> Atom::getBonds() {
-	std::vector<Atom*> bonded;
-	for (std::map<Atom*, std::map<Atom*, std::map<Atom*, bool> > >::const_iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-		bonded.push_back(k->first);
-	}
-	return bonded;
+	return bonds;
 }
 
 inline std::vector<std::vector<Atom*> > Atom::getBoundAtoms() const {
 	std::vector<std::vector<Atom*> > bonded;
-	for (std::map<Atom*, std::map<Atom*, std::map<Atom*, bool> > >::const_iterator k=boundAtoms.begin(); k!=boundAtoms.end(); k++) {
-		bonded.push_back(std::vector<Atom*>(1, k->first));
-		for (std::map<Atom*, std::map<Atom*, bool> >::const_iterator l=k->second.begin(); l!=k->second.end(); l++) {
-			bonded.back().push_back(l->first);
-			for (std::map<Atom*, bool>::const_iterator m=l->second.begin(); m!=l->second.end(); m++) {
-				bonded.back().push_back(m->first);
+	for (std::vector<Atom*>::const_iterator k=bonds.begin(); k!=bonds.end(); k++) {
+		bonded.push_back(std::vector<Atom*>(1, *k));
+		std::vector<Atom*> thirdAtoms = getOneThreeAtomsThrough(*k);
+		for (std::vector<Atom*>::const_iterator l=thirdAtoms.begin(); l!=thirdAtoms.end(); l++) {
+			bonded.back().push_back(*l);
+			for (std::vector<std::pair<Atom*, std::pair<Atom*, Atom*> > >::const_iterator m=oneFourAtoms.begin(); m!=oneFourAtoms.end(); m++) {
+				if (m->second.first == *k && m->second.second == *l) {
+					bonded.back().push_back(m->first);
+				}
 			}
 		}
 	}
@@ -803,25 +804,21 @@ inline std::vector<std::vector<Atom*> > Atom::getBoundAtoms() const {
 }
 inline std::vector<Atom*> Atom::getOneThreeMiddleAtoms(Atom *_pAtom) const {
 	std::vector<Atom*> middle;
-	std::map<Atom*, std::map<Atom*, bool> >::const_iterator found=oneThreeAtoms.find(_pAtom);
-	if (found != oneThreeAtoms.end()) {
-		for (std::map<Atom*, bool>::const_iterator k=found->second.begin(); k!=found->second.end(); k++) {
-			middle.push_back(k->first);
-		}
+	std::vector<std::pair<Atom*, Atom*> >::const_iterator k = std::lower_bound(oneThreeAtoms.begin(), oneThreeAtoms.end(), std::pair<Atom*, Atom*>(_pAtom, (Atom*)NULL));
+	for (; k!=oneThreeAtoms.end() && k->first == _pAtom; k++) {
+		middle.push_back(k->second);
 	}
 	return middle;
 }
 inline std::vector<std::vector<Atom*> > Atom::getOneFourMiddleAtoms(Atom *_pAtom) const {
 	std::vector<std::vector<Atom*> > middle;
-	std::map<Atom*, std::map<Atom*, std::map<Atom*, bool> > >::const_iterator found=oneFourAtoms.find(_pAtom);
-	if (found != oneFourAtoms.end()) {
-		for (std::map<Atom*, std::map<Atom*, bool> >::const_iterator k=found->second.begin(); k!=found->second.end(); k++) {
+	std::vector<std::pair<Atom*, std::pair<Atom*, Atom*> > >::const_iterator k = std::lower_bound(oneFourAtoms.begin(), oneFourAtoms.end(), std::make_pair(_pAtom, std::pair<Atom*, Atom*>((Atom*)NULL, (Atom*)NULL)));
+	for (; k!=oneFourAtoms.end() && k->first == _pAtom; k++) {
+		if (middle.size() == 0 || middle.back()[0] != k->second.first) {
 			middle.push_back(std::vector<Atom*>());
-			middle.back().push_back(k->first); // second atom of the 1-4 relationship
-			for (std::map<Atom*, bool>::const_iterator l=k->second.begin(); l!=k->second.end(); l++) {
-				middle.back().push_back(l->first); // 3rd atom
-			}
+			middle.back().push_back(k->second.first); // second atom of the 1-4 relationship
 		}
+		middle.back().push_back(k->second.second); // 3rd atom
 	}
 	return middle;
 }
@@ -830,9 +827,15 @@ inline std::vector<std::vector<Atom*> > Atom::getOneFourMiddleAtoms(Atom *_pAtom
 //inline bool Atom::isOneThree(Atom * _pAtom, const Atom * _14caller) const {if (_pAtom == this) {return false;} for (std::map<Atom*, bool>::const_iterator k=bonds.begin(); k!=bonds.end(); k++) {if (k->first == _pAtom) {return false;} else if (k->first->isBoundTo(_pAtom) && k->first != _14caller) {return true;}} return false;}
 //inline bool Atom::isOneFour(Atom * _pAtom) const {if (_pAtom == this) {return false;} for (std::map<Atom*, bool>::const_iterator k=bonds.begin(); k!=bonds.end(); k++) {if (k->first == _pAtom) {return false;} else if (k->first->isOneThree(_pAtom, this)) {return true;}} return false;}
 
-inline bool Atom::isBoundTo(Atom * _pAtom) const { return boundAtoms.find(_pAtom) != boundAtoms.end(); }
-inline bool Atom::isOneThree(Atom * _pAtom) const { return oneThreeAtoms.find(_pAtom) != oneThreeAtoms.end(); }
-inline bool Atom::isOneFour(Atom * _pAtom) const { return oneFourAtoms.find(_pAtom) != oneFourAtoms.end(); }
+inline bool Atom::isBoundTo(Atom * _pAtom) const { return std::binary_search(bonds.begin(), bonds.end(), _pAtom); }
+inline bool Atom::isOneThree(Atom * _pAtom) const {
+	std::vector<std::pair<Atom*, Atom*> >::const_iterator found = std::lower_bound(oneThreeAtoms.begin(), oneThreeAtoms.end(), std::pair<Atom*, Atom*>(_pAtom, (Atom*)NULL));
+	return found != oneThreeAtoms.end() && found->first == _pAtom;
+}
+inline bool Atom::isOneFour(Atom * _pAtom) const {
+	std::vector<std::pair<Atom*, std::pair<Atom*, Atom*> > >::const_iterator found = std::lower_bound(oneFourAtoms.begin(), oneFourAtoms.end(), std::make_pair(_pAtom, std::pair<Atom*, Atom*>((Atom*)NULL, (Atom*)NULL)));
+	return found != oneFourAtoms.end() && found->first == _pAtom;
+}
 inline bool Atom::isInAlternativeIdentity(Atom * _pAtom) const {return getParentPosition() == _pAtom->getParentPosition() && getParentResidue() != _pAtom->getParentResidue();}
 inline double Atom::groupDistance(Atom & _atom, unsigned int _stamp) {
 	return MSL::CartesianGeometry::distance(getGroupGeometricCenter(_stamp), _atom.getGroupGeometricCenter(_stamp));
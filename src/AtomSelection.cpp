@@ -29,6 +29,8 @@ You should have received a copy of the GNU Lesser General Public
 
 
 #include "AtomSelection.h"
+#include "CellList.h"
+#include <cmath>
 
 using namespace MSL;
 using namespace std;
@@ -154,45 +156,311 @@ AtomPointerVector& AtomSelection::select(string _selectString, bool _selectAllAt
 
 		// find any atom that is within the range of selection 2
 		AtomPointerVector aroundSele2;
-		for (AtomPointerVector::iterator avIt = data->begin();avIt != data->end();avIt++){
-			if (!(*avIt)->hasCoor()) {
-				// skip atoms that do not have coordinates
-				continue;
+		selectWithin(sele2atoms, radius, aroundSele2);
+
+		// delete the temporary selection and return
+		clearStoredSelection("_TMP1_");
+		return logicalSelect(seleString1, name, aroundSele2, _selectAllAtoms);
+
+	} else {
+		// regular logical statement, parse, select and return
+		return logicalSelect(selectString, name, *data, _selectAllAtoms);
+	}
+}
+
+void AtomSelection::selectWithin(AtomPointerVector & _sele2atoms, double _radius, AtomPointerVector & _result) {
+	/*********************************************************
+	 *  Adds to _result, in the order of data, the atoms that
+	 *  are part of the temporary selection _TMP1_ or within
+	 *  _radius of any of its atoms.  The atoms of selection 2
+	 *  are hashed in a CellList with cells of _radius so that
+	 *  only the 27 neighboring cells are checked
+	 *********************************************************/
+	vector<Atom*> targets;
+	vector<double> xyz;
+	double min[3] = {0.0, 0.0, 0.0};
+	double max[3] = {0.0, 0.0, 0.0};
+	for (AtomPointerVector::iterator avJt = _sele2atoms.begin();avJt != _sele2atoms.end();avJt++){
+		if ((*avJt)->hasCoor()) { 
+			double c[3] = {(*avJt)->getX(), (*avJt)->getY(), (*avJt)->getZ()};
+			for (unsigned int k=0; k < 3; k++) {
+				if (targets.size() == 0 || c[k] < min[k]) min[k] = c[k];
+				if (targets.size() == 0 || c[k] > max[k]) max[k] = c[k];
+				xyz.push_back(c[k]);
 			}
-			if((*avIt)->getSelectionFlag("_TMP1_")) {
-				// it is part of the sele1, it goes in
-				aroundSele2.push_back(*avIt);
-				continue;
+			targets.push_back(*avJt);
+		}
+	}
+
+	bool useGrid = _radius > 0.0 && targets.size() > 0;
+	CellList grid;
+	vector<unsigned int> cells;
+	if (useGrid) {
+		grid.build(xyz, _radius);
+	}
+
+	for (AtomPointerVector::iterator avIt = data->begin();avIt != data->end();avIt++){
+		if (!(*avIt)->hasCoor()) {
+			// skip atoms that do not have coordinates
+			continue;
+		}
+		if((*avIt)->getSelectionFlag("_TMP1_")) {
+			// it is part of the sele1, it goes in
+			_result.push_back(*avIt);
+			continue;
+		}
+		if (!useGrid) {
+			continue;
+		}
+		double p[3] = {(*avIt)->getX(), (*avIt)->getY(), (*avIt)->getZ()};
+		bool outside = false;
+		for (unsigned int k=0; k < 3; k++) {
+			if (p[k] < min[k] - _radius || p[k] > max[k] + _radius) {
+				outside = true;
+				break;
 			}
-			for (AtomPointerVector::iterator avJt = sele2atoms.begin();avJt != sele2atoms.end();avJt++){
-				if (!(*avJt)->hasCoor()) { 
-					// skip atoms that do not have coordinates
-					continue;
-				}
-				if ((*avIt)->distance(**avJt) < radius) {
+		}
+		if (outside) {
+			continue;
+		}
+		bool found = false;
+		grid.getNeighborCells(p, cells);
+		for (unsigned int i=0; i < cells.size() && !found; i++) {
+			for (unsigned int n=grid.getFirstPoint(cells[i]); n != grid.size(); n = grid.getNextPoint(n)) {
+				if ((*avIt)->distance(*targets[n]) < _radius) {
 					// atom within the radius of sele 2
-					aroundSele2.push_back(*avIt);
+					found = true;
 					break;
 				}
 			}
 		}
+		if (found) {
+			_result.push_back(*avIt);
+		}
+	}
+}
 
-		// delete the temporary selection and return
-		clearStoredSelection("_TMP1_");
-		return logicalSelect(seleString1, name, aroundSele2, _selectAllAtoms);
+AtomSelection::CompiledSelection * AtomSelection::compileSelection(const string & _selectString) {
+	map<string, CompiledSelection>::iterator found = compiledSelections.find(_selectString);
+	if (found != compiledSelections.end()) {
+		return &(found->second);
+	}
+	if (compiledSelections.size() > 1000) {
+		// do not grow without limits
+		compiledSelections.clear();
+	}
 
-	} else {
-		// regular logical statement, parse, select and return
-		return logicalSelect(selectString, name, *data, _selectAllAtoms);
+	CompiledSelection & compiled = compiledSelections[_selectString];
+	compiled.valid = false;
+	if (!cond.setLogic(_selectString)) {
+		condLogic = "";
+		return &compiled;
+	}
+	condLogic = _selectString;
+
+	// the questions do not depend on the answers, record them once
+	cond.restartQuery();
+	while (!cond.logicComplete()) {
+		vector<string> tokens = cond.getLogicalCondition();
+		if (tokens.size() < 1) {
+			// let the interpreted selection deal with it
+			return &compiled;
+		}
+		cond.setLogicalConditionValue(false);
+
+		SelectionTerm term;
+		term.hasCoor = true;
+		if (tokens[0] == "ALL" && tokens.size() == 1) {
+			term.type = SelectionTerm::ALL;
+		} else if (tokens[0] == "NAME" && tokens.size() == 2) {
+			term.type = SelectionTerm::NAME;
+			term.values = MslTools::tokenize(tokens[1], "+");
+		} else if (tokens[0] == "RESI" && tokens.size() == 2) {
+			term.type = SelectionTerm::RESI;
+			vector<string> vals = MslTools::tokenize(tokens[1], "+");
+			for (unsigned int i=0; i<vals.size(); i++) {
+				ResiValue value;
+				vector<string> range = MslTools::tokenize(vals[i], "-");
+				value.isRange = range.size() == 2;
+				value.literal = vals[i];
+				value.numeric = false;
+				if (value.isRange) {
+					value.start = MslTools::toInt(range[0]);
+					value.end = MslTools::toInt(range[1]);
+				} else {
+					// "37" or "37A": a residue number as %d writes it and an insertion code
+					const char * begin = vals[i].c_str();
+					char * end = NULL;
+					long number = strtol(begin, &end, 10);
+					value.start = (int)number;
+					value.end = value.start;
+					if (end != begin && number == (long)value.start) {
+						char c [100];
+						sprintf(c, "%d", value.start);
+						value.numeric = vals[i].substr(0, end - begin) == (string)c;
+						value.icode = vals[i].substr(end - begin);
+					}
+				}
+				term.resiValues.push_back(value);
+			}
+		} else if (tokens[0] == "RESN" && tokens.size() == 2) {
+			term.type = SelectionTerm::RESN;
+			term.values = MslTools::tokenize(tokens[1], "+");
+		} else if (tokens[0] == "CHAIN" && tokens.size() == 2) {
+			term.type = SelectionTerm::CHAIN;
+			term.values = MslTools::tokenize(tokens[1], "+");
+		} else if (tokens[0] == "HASCRD" || tokens[0] == "HASCOOR") {
+			term.type = SelectionTerm::HASCRD;
+			if (tokens.size() == 2) {
+				term.hasCoor = MslTools::toBool(tokens[1]);
+			}
+		} else if (tokens.size() == 1) {
+			// a stored selection, checked at every call since they can change
+			term.type = SelectionTerm::FLAG;
+			term.values = tokens;
+		} else {
+			// unrecognized, the interpreted selection will give the warning
+			return &compiled;
+		}
+		compiled.terms.push_back(term);
+	}
+	if (compiled.terms.size() <= 16) {
+		compiled.truthTable.assign(1 << compiled.terms.size(), -1);
 	}
+	compiled.valid = true;
+	return &compiled;
+}
+
+bool AtomSelection::evaluateTerm(const SelectionTerm & _term, Atom * _pAtom) {
+	switch (_term.type) {
+		case SelectionTerm::ALL:
+			return true;
+		case SelectionTerm::NAME:
+		case SelectionTerm::RESN:
+		case SelectionTerm::CHAIN: {
+			string value;
+			if (_term.type == SelectionTerm::NAME) {
+				value = _pAtom->getName();
+			} else if (_term.type == SelectionTerm::RESN) {
+				value = _pAtom->getResidueName();
+			} else {
+				value = _pAtom->getChainId();
+			}
+			for (unsigned int i=0; i<_term.values.size(); i++) {
+				if (_term.values[i] == value) {
+					return true;
+				}
+			}
+			return false;
+		}
+		case SelectionTerm::RESI: {
+			int resnum = _pAtom->getResidueNumber();
+			string icode = _pAtom->getResidueIcode();
+			bool noIcode = icode.empty() || MslTools::trim(icode).empty();
+			for (unsigned int i=0; i<_term.resiValues.size(); i++) {
+				const ResiValue & value = _term.resiValues[i];
+				if (value.isRange) {
+					if (value.start <= resnum && value.end >= resnum) {
+						return true;
+					}
+				} else if (noIcode) {
+					// same as comparing with getPositionId(1) without building the string
+					if (value.numeric && value.icode.empty() && value.start == resnum) {
+						return true;
+					}
+				} else if (value.literal == _pAtom->getPositionId(1)) {
+					return true;
+				}
+			}
+			return false;
+		}
+		case SelectionTerm::HASCRD:
+			return _pAtom->hasCoor() == _term.hasCoor;
+		case SelectionTerm::FLAG:
+			return _pAtom->getSelectionFlag(_term.values[0]);
+	}
+	return false;
+}
+
+bool AtomSelection::evaluateLogic(CompiledSelection & _compiled, const string & _selectString, const vector<bool> & _values) {
+	unsigned int index = 0;
+	if (!_compiled.truthTable.empty()) {
+		for (unsigned int i=0; i<_values.size(); i++) {
+			if (_values[i]) {
+				index |= 1 << i;
+			}
+		}
+		if (_compiled.truthTable[index] != -1) {
+			return _compiled.truthTable[index] == 1;
+		}
+	}
+
+	// not seen yet, let the LogicalCondition work it out
+	if (condLogic != _selectString) {
+		cond.setLogic(_selectString);
+		condLogic = _selectString;
+	}
+	cond.restartQuery();
+	unsigned int i = 0;
+	while (!cond.logicComplete()) {
+		cond.getLogicalCondition();
+		cond.setLogicalConditionValue(_values[i++]);
+	}
+	bool selected = cond.getOverallBooleanState();
+	if (!_compiled.truthTable.empty()) {
+		_compiled.truthTable[index] = selected;
+	}
+	return selected;
 }
 
 AtomPointerVector& AtomSelection::logicalSelect(string _selectString, string _name, AtomPointerVector & _atoms, bool _selectAllAtoms){
 
+	CompiledSelection * pCompiled = NULL;
+	if (!debug) {
+		pCompiled = compileSelection(_selectString);
+	}
+	bool compiled = pCompiled != NULL && pCompiled->valid;
+	if (compiled) {
+		// the stored selections used in the logic must exist at this time
+		for (unsigned int i=0; i<pCompiled->terms.size(); i++) {
+			if (pCompiled->terms[i].type == SelectionTerm::FLAG && storedSelections.find(pCompiled->terms[i].values[0]) == storedSelections.end()) {
+				compiled = false;
+				break;
+			}
+		}
+	}
+	if (!compiled) {
+		return interpretedSelect(_selectString, _name, _atoms, _selectAllAtoms);
+	}
+
+	AtomPointerVector & selection = storedSelections[_name];
+	vector<bool> values(pCompiled->terms.size(), false);
+	for (AtomPointerVector::iterator avIt = _atoms.begin();avIt != _atoms.end();avIt++){
+		// first check if the atoms should be discarded because inactive
+		if (_selectAllAtoms || (*avIt)->getActive()) {
+			for (unsigned int i=0; i<values.size(); i++) {
+				values[i] = evaluateTerm(pCompiled->terms[i], *avIt);
+			}
+			bool selected = evaluateLogic(*pCompiled, _selectString, values);
+			if (selected) {
+				selection.push_back(*avIt);
+			}
+			// turn the atom's selection flag on/off
+			(*avIt)->setSelectionFlag(_name, selected);
+		}
+	}
+
+	return selection;
+}
+
+AtomPointerVector& AtomSelection::interpretedSelect(string _selectString, string _name, AtomPointerVector & _atoms, bool _selectAllAtoms){
+
 	if (!cond.setLogic(_selectString)) {
+		condLogic = "";
 		cerr << "WARNING 32773: selection statement " << _selectString << " not valid in AtomPointerVector& AtomSelection::logicalSelect(string _selectString, string _name, AtomPointerVector & _atoms, bool _selectAllAtoms)" << endl;
 		return storedSelections[_name];
 	}
+	condLogic = _selectString;
 	if (debug){
 		cout << "Reconstructed selection logic: " << cond.printLogicalConditions() << endl;
 	}
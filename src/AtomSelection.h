@@ -33,6 +33,7 @@ You should have received a copy of the GNU Lesser General Public
 
 // STL includes
 #include <sstream>
+#include <map>
 //#include <tr1/unordered_map>
 
 // MSL includes
@@ -72,7 +73,43 @@ class AtomSelection {
 	private:
 #ifndef __TESTING__
 		AtomPointerVector& logicalSelect(std::string _selectString, std::string _name, AtomPointerVector & _atoms, bool _selectAllAtoms);
+		AtomPointerVector& interpretedSelect(std::string _selectString, std::string _name, AtomPointerVector & _atoms, bool _selectAllAtoms);
+		void selectWithin(AtomPointerVector & _sele2atoms, double _radius, AtomPointerVector & _result);
 		LogicalCondition cond;
+		std::string condLogic; // the statement currently set in cond
+
+		/***************************************************
+		 *  Selections are compiled once and cached by their
+		 *  logic string.  The LogicalCondition asks its
+		 *  questions always in the same order, so each one is
+		 *  pre-parsed into a term (literals already split and
+		 *  converted), and the overall answer is memoized by the
+		 *  pattern of true/false values of the terms.
+		 ***************************************************/
+		struct ResiValue {
+			bool isRange;
+			int start; // first of the range, or the number of a literal such as "37A"
+			int end;
+			std::string literal; // compared to the position id of atoms with an insertion code
+			std::string icode; // what follows the number in the literal
+			bool numeric; // the literal starts with a number written as %d would write it
+		};
+		struct SelectionTerm {
+			enum TermType { ALL, NAME, RESI, RESN, CHAIN, HASCRD, FLAG };
+			unsigned int type;
+			std::vector<std::string> values;
+			std::vector<ResiValue> resiValues;
+			bool hasCoor;
+		};
+		struct CompiledSelection {
+			bool valid;
+			std::vector<SelectionTerm> terms;
+			std::vector<signed char> truthTable; // indexed by the term values, -1 if not computed yet
+		};
+		CompiledSelection * compileSelection(const std::string & _selectString);
+		bool evaluateTerm(const SelectionTerm & _term, Atom * _pAtom);
+		bool evaluateLogic(CompiledSelection & _compiled, const std::string & _selectString, const std::vector<bool> & _values);
+		std::map<std::string, CompiledSelection> compiledSelections;
 #else
 		LogicalParser lp;
 #endif
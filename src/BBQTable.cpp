@@ -48,12 +48,16 @@ using namespace MSL;
 
 
 BBQTable::BBQTable(string _bbqTableFileName){
+	debugFlag = false;
+	compiled = false;
 	openReader(_bbqTableFileName);
 
 
 }
 void BBQTable::openReader(string _bbqTableFileName){
 
+    // the compiled lookup belongs to the entries read before
+    compiled = false;
     BBQTableReader bbqTableReader(_bbqTableFileName);
     bbqTableReader.open();
     bbqTableReader.read(*this);
@@ -71,38 +75,35 @@ void BBQTable::openReader(string _bbqTableFileName){
  **/
 
 void BBQTable::fillInMissingBBAtoms(vector<Residue *> &_rv) {
-    map<ResiduePtrPair, Real> rDistances;
-    map<Residue *, CoordAxes> lCoords;
+    // We need at least 4 C-alpha's...
+    if( _rv.size() < 4 )
+        return;
 
-    calcRDistances(_rv, rDistances);
-    calcLCoords(_rv, lCoords);
+    vector<CartesianPoint> cAlphas(_rv.size());
+    for(int currIndex = 0; currIndex < (int)_rv.size(); ++currIndex) {
+        if(_rv[currIndex]->atomExists("CA"))
+            cAlphas[currIndex] = _rv[currIndex]->getAtom("CA").getCoor();
+    }
 
-    for(int currIndex = 0; currIndex <= (int)_rv.size()-4; ++currIndex) {
-        // Skip this if it is not a legal quadrilateral
-        if(isLegalQuad( _rv[currIndex], _rv[currIndex+1], _rv[currIndex+2], _rv[currIndex+3]) == false)
-            continue;
-        
-        Real distances[3];
-        CoordAxes axes = lCoords[_rv[currIndex]];
+    vector<bool> legalQuads(_rv.size()-3);
+    for(int currIndex = 0; currIndex < (int)legalQuads.size(); ++currIndex)
+        legalQuads[currIndex] = isLegalQuad( _rv[currIndex], _rv[currIndex+1], _rv[currIndex+2], _rv[currIndex+3]);
 
-        distances[0] = rDistances[ResiduePtrPair(_rv[currIndex], _rv[currIndex+2])];
-        // We store the information regarding whether the dihedral is positive
-        // or negative on the distance metric between the current atom and current atom + 2.
-        // ignore the signs on other distances.
-        distances[1] = fabs(rDistances[ResiduePtrPair(_rv[currIndex], _rv[currIndex+3])]);
-        distances[2] = fabs(rDistances[ResiduePtrPair(_rv[currIndex+1], _rv[currIndex+3])]);
+    vector<int> entries;
+    vector<double> coor;
+    calcBackboneCoordinates(cAlphas, legalQuads, entries, coor);
 
-        Residue newRes;
-        addAtomsToResidue(distances[0], distances[1], distances[2], axes, newRes);
-        // The position of the C, O, and N atoms are relative to their C-alpha atoms.
-        newRes.getAtom("C").getCoor() += _rv[currIndex+1]->getAtom("CA").getCoor();
-        newRes.getAtom("O").getCoor() += _rv[currIndex+1]->getAtom("CA").getCoor();
-        newRes.getAtom("N").getCoor() += _rv[currIndex+2]->getAtom("CA").getCoor();
+    for(int currIndex = 0; currIndex < (int)legalQuads.size(); ++currIndex) {
+        // Skip this if it is not a legal quadrilateral
+        if(!legalQuads[currIndex])
+            continue;
 
         // The C and O atoms belong to residue 1, while the N atom belongs to residue 2.
-        _rv[currIndex+1]->addAtom( newRes.getAtom("C") );
-        _rv[currIndex+1]->addAtom( newRes.getAtom("O") );
-        _rv[currIndex+2]->addAtom( newRes.getAtom("N") );
+        for(int i = 0; i < 3; ++i) {
+            Atom newAtom(*entryAtoms[3*entries[currIndex] + i]);
+            newAtom.setCoor(coor[9*currIndex + 3*i], coor[9*currIndex + 3*i + 1], coor[9*currIndex + 3*i + 2]);
+            _rv[currIndex + (i < 2 ? 1 : 2)]->addAtom(newAtom);
+        }
     }
 }
 
@@ -113,93 +114,128 @@ int BBQTable::fillInMissingBBAtoms(Chain &_chain) {
 		return -1;
 	}
 
-	map<ResiduePtrPair, Real> rDistances;
-	map<Residue *, CoordAxes> lCoords;
-
-	calcRDistances(_chain, rDistances);
-	calcLCoords(_chain, lCoords);
+	int size = _chain.positionSize();
+	vector<CartesianPoint> cAlphas(size);
+	for(int currIndex = 0; currIndex < size; currIndex++) {
+		if (_chain.getResidue(currIndex).atomExists("CA")) {
+			cAlphas[currIndex] = _chain.getResidue(currIndex).getAtom("CA").getCoor();
+		}
+	}
 
 	int illegalQuads = 0;
-	for(int currIndex = 0; currIndex < (int)_chain.positionSize()-3; currIndex++) {
-
-
-		AtomPointerVector ats;
-		if (isLegalQuad( &_chain.getResidue(currIndex), &_chain.getResidue(currIndex+1),&_chain.getResidue(currIndex+2),  &_chain.getResidue(currIndex+3)) == false){
+	vector<bool> legalQuads(size > 3 ? size-3 : 0);
+	for(int currIndex = 0; currIndex < (int)legalQuads.size(); currIndex++) {
+		legalQuads[currIndex] = isLegalQuad( &_chain.getResidue(currIndex), &_chain.getResidue(currIndex+1),&_chain.getResidue(currIndex+2),  &_chain.getResidue(currIndex+3));
+		if (!legalQuads[currIndex]){
 			fprintf(stdout,"ILLEGAL QUAD %d\n",currIndex);
 			illegalQuads++;
-			continue;
-		} else {
+		}
+	}
+
+	vector<int> entries;
+	vector<double> coor;
+	calcBackboneCoordinates(cAlphas, legalQuads, entries, coor);
 
-			Real distances[3];
-			CoordAxes axes = lCoords[&_chain.getResidue(currIndex)];
-			CartesianPoint cAlphaCoord = _chain.getResidue(currIndex).getAtom("CA").getCoor();
-
-			distances[0] = rDistances[ResiduePtrPair(&_chain.getResidue(currIndex), &_chain.getResidue(currIndex+2))];
-			// We store the information regarding whether the dihedral is positive
-			// or negative on the distance metric between the current atom and current atom + 2.
-			// ignore the signs on other distances.
-			distances[1] = fabs(rDistances[ResiduePtrPair(&_chain.getResidue(currIndex), &_chain.getResidue(currIndex+3))]);
-			distances[2] = fabs(rDistances[ResiduePtrPair(&_chain.getResidue(currIndex+1), &_chain.getResidue(currIndex+3))]);
-
-			Residue newRes;
-
-			//AtomPointerVector av = getAtomPointerVector(distances[0], distances[1], distances[2], axes, cAlphaCoord);
-			addAtomsToResidue(distances[0], distances[1], distances[2], axes, newRes);
-
-			newRes.getAtom("C").getCoor() += _chain.getResidue(currIndex+1).getAtom("CA").getCoor();
-			newRes.getAtom("O").getCoor() += _chain.getResidue(currIndex+1).getAtom("CA").getCoor();
-			newRes.getAtom("N").getCoor() += _chain.getResidue(currIndex+2).getAtom("CA").getCoor();
-
-			/*
-			  newRes.setChainId(_chain.getResidue(currIndex).getChainId());
-			  newRes.setResidueName(_chain.getResidue(currIndex).getResidueName());
-			  newRes.setResidueNumber(_chain.getResidue(currIndex).getResidueNumber());
-			  newRes.setResidueIcode(_chain.getResidue(currIndex).getResidueIcode());
-			*/
-
-
-			ats.push_back(new Atom(newRes.getAtom("C")));
-			ats.back()->setChainId(_chain.getResidue(currIndex+1).getChainId());
-			ats.back()->setResidueName(_chain.getResidue(currIndex+1).getResidueName());
-			ats.back()->setResidueNumber(_chain.getResidue(currIndex+1).getResidueNumber());
-			ats.back()->setResidueIcode(_chain.getResidue(currIndex+1).getResidueIcode());
-			ats.back()->setElement("C");
-
-			ats.push_back(new Atom(newRes.getAtom("O")));
-			ats.back()->setChainId(_chain.getResidue(currIndex+1).getChainId());
-			ats.back()->setResidueName(_chain.getResidue(currIndex+1).getResidueName());
-			ats.back()->setResidueNumber(_chain.getResidue(currIndex+1).getResidueNumber());
-			ats.back()->setResidueIcode(_chain.getResidue(currIndex+1).getResidueIcode());
-			ats.back()->setElement("O");
-
-			ats.push_back(new Atom(newRes.getAtom("N")));
-			ats.back()->setChainId(_chain.getResidue(currIndex+2).getChainId());
-			ats.back()->setResidueName(_chain.getResidue(currIndex+2).getResidueName());
-			ats.back()->setResidueNumber(_chain.getResidue(currIndex+2).getResidueNumber());
-			ats.back()->setResidueIcode(_chain.getResidue(currIndex+2).getResidueIcode());
-			ats.back()->setElement("N");
+	// Create the C and O atoms of residue 1 and the N atom of residue 2 of
+	// each quadrilateral, and add them to the chain all at once
+	AtomPointerVector ats;
+	string elements[3] = {"C", "O", "N"};
+	for(int currIndex = 0; currIndex < (int)legalQuads.size(); currIndex++) {
+		if (!legalQuads[currIndex]){
+			continue;
+		}
+		for (int i=0; i < 3; i++) {
+			Residue &res = _chain.getResidue(currIndex + (i < 2 ? 1 : 2));
+			ats.push_back(new Atom(*entryAtoms[3*entries[currIndex] + i]));
+			ats.back()->setCoor(coor[9*currIndex + 3*i], coor[9*currIndex + 3*i + 1], coor[9*currIndex + 3*i + 2]);
+			ats.back()->setChainId(res.getChainId());
+			ats.back()->setResidueName(res.getResidueName());
+			ats.back()->setResidueNumber(res.getResidueNumber());
+			ats.back()->setResidueIcode(res.getResidueIcode());
+			ats.back()->setElement(elements[i]);
 		}
-		
+	}
+
+	if (ats.size() > 0) {
 		if (_chain.getParentSystem() != NULL){
 			_chain.getParentSystem()->addAtoms(ats);
 		} else {
 			_chain.addAtoms(ats);
 		}
-
 		ats.deletePointers();
+	}
 
-		// Force updating of atomvectors in chain/system
+	// Force updating of atomvectors in chain/system
+	for(int currIndex = 0; currIndex < size; currIndex++) {
 		_chain.getPosition(currIndex).setActiveIdentity(_chain.getResidue(currIndex).getResidueName());
-
 	}
-        
-        for(int currIndex = (int)_chain.positionSize()-3; currIndex < (int)_chain.positionSize(); currIndex++)
-            _chain.getPosition(currIndex).setActiveIdentity(_chain.getResidue(currIndex).getResidueName());
-
 
 	return illegalQuads;
 }
 
+/**
+ * This function places the backbone atoms of all legal quadrilaterals of a
+ * C-alpha trace.  For each quadrilateral it computes the r coordinates (the
+ * distance between c-alpha's 0 and 2, signed by the C-alpha dihedral, 0 and 3,
+ * and 1 and 3), looks up the closest table entry and rotates its local-frame
+ * offsets onto the axes of the quadrilateral.
+ *
+ * @param _ca       The coordinates of the C-alpha's.
+ * @param _legal    Whether each quadrilateral (starting at that C-alpha) is legal.
+ * @param _entries  Output: the table entry used for each quadrilateral.
+ * @param _coor     Output: the packed coordinates of the C and O atoms of residue 1
+ *                  and the N atom of residue 2 of each quadrilateral, 9 per quadrilateral.
+ */
+void BBQTable::calcBackboneCoordinates(const vector<CartesianPoint> &_ca, const vector<bool> &_legal, vector<int> &_entries, vector<double> &_coor) {
+    _entries.assign(_legal.size(), -1);
+    _coor.assign(9 * _legal.size(), 0.0);
+
+    for(int currIndex = 0; currIndex < (int)_legal.size(); ++currIndex) {
+        if(!_legal[currIndex])
+            continue;
+
+        const CartesianPoint &p0 = _ca[currIndex], &p1 = _ca[currIndex+1], &p2 = _ca[currIndex+2], &p3 = _ca[currIndex+3];
+
+        // We store the information regarding whether the dihedral is positive
+        // or negative on the distance metric between the current atom and current atom + 2.
+        Real r02 = CartesianGeometry::distance(p0, p2);
+        if(CartesianGeometry::dihedral(p0, p1, p2, p3) < 0)
+            r02 = -r02;
+        Real r03 = CartesianGeometry::distance(p0, p3);
+        Real r13 = CartesianGeometry::distance(p1, p3);
+
+        int entry = getTableEntry(r02, r03, r13);
+        _entries[currIndex] = entry;
+
+        // The axes of the quadrilateral (see calcLCoords)
+        CartesianPoint versor01, versor02, axes[3];
+        versor01 = p1 - p0;
+        versor01 = versor01.getUnit();
+        versor02 = p2 - p0;
+        versor02 = versor02.getUnit();
+
+        axes[0] = versor01 + versor02;
+        axes[0] = axes[0].getUnit();
+        axes[1] = versor01 - versor02;
+        axes[1] = axes[1].getUnit();
+        axes[2] = axes[0].cross(axes[1]);
+        for(int i = 0; i < 3; ++i)
+            axes[i] = axes[i].getUnit();
+
+        // Rotate the offsets out of the local frame.  The positions of the C, O, and N
+        // atoms are relative to their C-alpha atoms.
+        const double *offset = &entryOffsets[9*entry];
+        double *out = &_coor[9*currIndex];
+        for(int i = 0; i < 3; ++i) {
+            const CartesianPoint &origin = (i < 2) ? p1 : p2;
+            const double *local = offset + 3*i;
+            out[3*i]   = axes[0].getX()*local[0] + axes[1].getX()*local[1] + axes[2].getX()*local[2] + origin.getX();
+            out[3*i+1] = axes[0].getY()*local[0] + axes[1].getY()*local[1] + axes[2].getY()*local[2] + origin.getY();
+            out[3*i+2] = axes[0].getZ()*local[0] + axes[1].getZ()*local[1] + axes[2].getZ()*local[2] + origin.getZ();
+        }
+    }
+}
+
 /**
  * This function is used when building a BBQTable (not simply reading from file.)
  * The user will pass in the given r coordinates, and the vector of atoms associated
@@ -219,6 +255,7 @@ void BBQTable::addAtomPointerVector(Real _r02, Real _r03, Real _r13, AtomPointer
     AtomPointerVector *oldAv;
     Frame newFrame;
 
+    compiled = false;
     newFrame.computeFrameFromAxes(_axes);
 
     // Transform to global basis.
@@ -261,47 +298,104 @@ void BBQTable::addAtomPointerVector(Real _r02, Real _r03, Real _r13, AtomPointer
 
 
 /**
- * This function will get a vector of atoms from the bin
+ * This function compiles the table into a dense 3-D array of bins covering
+ * the range of its keys, and packs the local-frame offsets of the C, O and N
+ * atoms of every entry.  It is called on the first lookup after the table
+ * has been read or changed.
+ */
+void BBQTable::compileTable() {
+    binEntries.clear();
+    binClosest.clear();
+    entryOffsets.clear();
+    entryAtoms.clear();
+    entryKeys.clear();
+    for(int i = 0; i < 3; ++i) {
+        keyMin[i] = 0;
+        keyDims[i] = 0;
+    }
+    compiled = true;
+
+    if(empty())
+        return;
+
+    int keyMax[3];
+    for(BBQTable::iterator currIter = begin(); currIter != end(); ++currIter) {
+        int key[3] = {(int)MslTools::round(currIter->first.getX()), (int)MslTools::round(currIter->first.getY()), (int)MslTools::round(currIter->first.getZ())};
+        for(int i = 0; i < 3; ++i) {
+            if(currIter == begin() || key[i] < keyMin[i])
+                keyMin[i] = key[i];
+            if(currIter == begin() || key[i] > keyMax[i])
+                keyMax[i] = key[i];
+        }
+    }
+    for(int i = 0; i < 3; ++i)
+        keyDims[i] = keyMax[i] - keyMin[i] + 1;
+    binEntries.assign(keyDims[0] * keyDims[1] * keyDims[2], -1);
+
+    string names[3] = {"C", "O", "N"};
+    for(BBQTable::iterator currIter = begin(); currIter != end(); ++currIter) {
+        int entry = entryKeys.size();
+        entryKeys.push_back(currIter->first);
+
+        AtomPointerVector &av = *(currIter->second);
+        for(int i = 0; i < 3; ++i) {
+            Atom *found = NULL;
+            for(AtomPointerVector::iterator currAtomIter = av.begin(); currAtomIter != av.end(); ++currAtomIter) {
+                if((*currAtomIter)->getName() == names[i]) {
+                    found = *currAtomIter;
+                    break;
+                }
+            }
+            if(found == NULL) {
+                cerr << "ERROR 6724: table entry " << currIter->first << " has no " << names[i] << " atom in void BBQTable::compileTable()" << endl;
+                exit(6724);
+            }
+            entryAtoms.push_back(found);
+            entryOffsets.push_back(found->getX());
+            entryOffsets.push_back(found->getY());
+            entryOffsets.push_back(found->getZ());
+        }
+
+        int x = (int)MslTools::round(currIter->first.getX()) - keyMin[0];
+        int y = (int)MslTools::round(currIter->first.getY()) - keyMin[1];
+        int z = (int)MslTools::round(currIter->first.getZ()) - keyMin[2];
+        binEntries[(x * keyDims[1] + y) * keyDims[2] + z] = entry;
+    }
+    binClosest = binEntries;
+}
+
+/**
+ * This function returns the index of the table entry for the bin
  * closest to the given r coordinates (the distance between
- * c-alpha's for residues 0 and 2, 0 and 3, and 1 and 3).  These
- * atoms will be added to the residue provided.
+ * c-alpha's for residues 0 and 2, 0 and 3, and 1 and 3).
  *
  * @param r02           The distance between the 0th and 2nd c-alpha.
  * @param r03           The distance between the 0th and 3rd c-alpha.
  * @param r13           The distance between the 1st and 3rd c-alpha.
- * @param axes          The axes relative to standard x, y, and z.
- * @param res           The residue to which we should add the atoms.  Note: this should be an empty residue.
- *                      We will place the C and O atoms for residue 1 in our quadrilateral, and the N atom for
- *                      residue 2 in our quadrilateral in this residue, and return it.
  */
-void BBQTable::addAtomsToResidue(Real _r02, Real _r03, Real _r13, CoordAxes &_axes, Residue &_res) {
-    CartesianPoint key;
-    AtomPointerVector av;
-    Frame newFrame;
-    
-    newFrame.computeFrameFromAxes(_axes);
-    try {
-        map<CartesianPoint, AtomPointerVector *>::iterator searchResult;
-
-        key.setX( MslTools::round( _r02 / binSizes[0] ) );
-        key.setY( MslTools::round( _r03 / binSizes[1] ) );
-        key.setZ( MslTools::round( _r13 / binSizes[2] ) );
-
-        searchResult = find(key);
-        if(searchResult != end()) 
-            _res.addAtoms(*(searchResult->second));
-        else 
-            findClosestTableEntry(_res, key);
-
-        // Get the new atom vector from the residue.
-        AtomPointerVector &resAV = _res.getAtomPointers();
-        // Rotate atoms around the given axes.
-        newFrame.transformFromGlobalBasis(resAV);
-    }
-    catch (...) {
-        cout << "Error in BBQTable::getAtomPointerVector.\n";
+int BBQTable::getTableEntry(Real _r02, Real _r03, Real _r13) {
+    if(!compiled)
+        compileTable();
+    if(entryKeys.empty()) {
+        cout << "Error in BBQTable::getTableEntry, the table is empty.\n";
         exit(1);
     }
+
+    int x = (int)MslTools::round( _r02 / binSizes[0] );
+    int y = (int)MslTools::round( _r03 / binSizes[1] );
+    int z = (int)MslTools::round( _r13 / binSizes[2] );
+
+    int bx = x - keyMin[0];
+    int by = y - keyMin[1];
+    int bz = z - keyMin[2];
+    if(bx < 0 || bx >= keyDims[0] || by < 0 || by >= keyDims[1] || bz < 0 || bz >= keyDims[2])
+        return findClosestTableEntry(x, y, z);
+
+    // Empty bins are resolved once and remembered
+    int &closest = binClosest[(bx * keyDims[1] + by) * keyDims[2] + bz];
+    if(closest < 0)
+        closest = findClosestTableEntry(x, y, z);
+    return closest;
 }
 
 /**
@@ -309,6 +403,7 @@ void BBQTable::addAtomsToResidue(Real _r02, Real _r03, Real _r13, CoordAxes &_ax
  * added to our table.
  */
 void BBQTable::normalize() {
+    compiled = false;
     // Loop over all of the counts that we have.
     for(map<CartesianPoint, unsigned int>::iterator currIter = counts.begin(); currIter != counts.end(); ++currIter) {
         // Find the atom vector that corresponds to this count entry.
@@ -393,41 +488,6 @@ void BBQTable::calcRDistances(vector<Residue *> &_rv, map<ResiduePtrPair, Real>
     }
 }
 
-void BBQTable::calcRDistances(Chain &_ch, map<ResiduePtrPair, Real> &_rDistances) {
-    // We need at least 4 C-alpha's...
-    if( _ch.positionSize() < 4 )
-        return;
-
-    Residue *pRes0 = &_ch.getResidue(0), *pRes1 = NULL, *pRes2 = &_ch.getResidue(2), *pRes3 = NULL;
-
-    ResiduePtrPair key(pRes0, pRes2);
-    _rDistances[key] = pRes0->distance(*pRes2, "CA");
-
-    // Loop over the residues in the residue vector calculating the r distances.
-    for(int currIndex = 0; currIndex <= (int)_ch.positionSize()-4; ++currIndex){
-        pRes0 = &_ch.getResidue(currIndex);
-        pRes1 = &_ch.getResidue(currIndex + 1);
-        pRes2 = &_ch.getResidue(currIndex + 2);
-        pRes3 = &_ch.getResidue(currIndex + 3);
-
-        key.first = pRes0;
-        key.second = pRes3;
-        _rDistances[key] = pRes0->distance(*pRes3, "CA");
-        
-        key.first = pRes1;
-        key.second = pRes3;
-        _rDistances[key] = pRes1->distance(*pRes3, "CA");
-
-        // If the dihedral angle is positive, then leave
-        // the distance between 0 and 2 positive.  If the
-        // dihedral is negative, then make it negative.
-        key.first = pRes0;
-        key.second = pRes2;
-        if(calcCADihedral(pRes0, pRes1, pRes2, pRes3) < 0)
-            _rDistances[key] = -_rDistances[key];
-    }
-}
-
 /**
  * This function will loop through all of the residues in the
  * given residue vector and form quadrilaterals.  It will then add entries
@@ -523,34 +583,6 @@ void BBQTable::calcLCoords(vector<Residue *> &_rv, map<Residue *, CoordAxes> &_l
     }
 }
 
-void BBQTable::calcLCoords(Chain &_ch, map<Residue *, CoordAxes> &_lCoords) {
-    // We need at least 3 C-alpha's...
-    if( _ch.positionSize() < 3 )
-        return;
-    
-    for(int currIndex = 0; currIndex <= (int)_ch.positionSize()-3; ++currIndex) {
-        CartesianPoint points[3], versor01, versor02;
-        CoordAxes axes;
-
-        points[0] = _ch.getResidue(currIndex).getAtom("CA").getCoor();
-        points[1] = _ch.getResidue(currIndex+1).getAtom("CA").getCoor();
-        points[2] = _ch.getResidue(currIndex+2).getAtom("CA").getCoor();
-        
-        versor01 = points[1] - points[0];
-        versor01 = versor01.getUnit();
-
-        versor02 = points[2] - points[0];
-        versor02 = versor02.getUnit();
-
-        axes.first = versor01 + versor02;
-        axes.first = axes.first.getUnit();
-        axes.second = versor01 - versor02;
-        axes.second = axes.second.getUnit();
-        axes.third = axes.first.cross(axes.second);
-
-        _lCoords[&_ch.getResidue(currIndex)] = axes;
-    }
-}
 /**
  * This function will take the coordinates from all of the atoms in
  * _av2 and add them to the corresponding atom's coords in _av1.
@@ -592,92 +624,46 @@ void BBQTable::sumAtomPointerVectors(AtomPointerVector *_av1, AtomPointerVector
 }
 
 /**
- * This function will attempt to find the best atom vector for a set of R distances
- * that don't have an entry in our table.  Basically, since each entry is a key into
+ * This function will attempt to find the best entry for a key that doesn't
+ * have an entry in our table.  Basically, since each entry is a key into
  * a 3-D LUT, this function will first look in the 26 neighboring entries to the given
- * key, and return the first entry that it finds.  If none of the 26 neighboring keys
+ * key, and return the first entry that it finds.  In the future we could
+ * look into taking an average of all entries found in the 3x3 neighborhood,
+ * but since this function should be called relatively infrequently, its probably
+ * not worth the effort.  If none of the 26 neighboring keys
  * have entries either, it will then do a brute force calculation, looking to see what
  * key that is in the table minimizes the distance between keys.
  *
- * @param _res  This is the Residue where we will place the atom vector that best matches the key.
- * @param _key This is the key that we wanted to use, but doesn't have an entry.
- */
-void BBQTable::findClosestTableEntry(Residue &_res, CartesianPoint &_key) {
-    if( !search3x3Neighborhood(_res, _key) )
-        bruteForceFindClosestTableEntry(_res, _key);
-}
-
-/**
- * This function will look at all entries in the 3x3 cube surrounding the
- * given key.  It is called by findClosestTableEntry, which is in turn
- * called when there is no entry for the given key.  In searching the 3x3
- * area around this key, we are searching bins that are have r distances
- * very similar to the r distances we desire.  At the first entry this
- * function finds in the 3x3 neighborhood, it will set the atom vector
- * to the atom vector in this entry, and return true.  In the future we could
- * look into taking an average of all atom vectors found in the 3x3 neighborhood,
- * but since this function should be called relatively infrequently, its probably
- * not worth the effort.
- *
- * @param _res This is the Residue where we will place the atom vector that best matches the key.
- * @param _key This is the key that we wanted to use, but doesn't have an entry.
- * @return We return true if we found an entry in the 3x3 neighborhood, false otherwise.
+ * @param _x, _y, _z  The key that we wanted to use.
+ * @return The index of the closest entry.
  */
-bool BBQTable::search3x3Neighborhood(Residue &_res, CartesianPoint &_key) {
-    CartesianPoint newKey;
-    map<CartesianPoint, AtomPointerVector *>::iterator searchResult;
-
+int BBQTable::findClosestTableEntry(int _x, int _y, int _z) {
     // Loop over the 3x3 region surrounding the key which did not
-    // have an entry.  If any of these indices has an entry,
-    // return that atom vector.  (Should we instead average
-    // the results of all neighbors that have an entry?)
-    // If none fo the 3x3 neighbors has an entry, return false.
-    for(int x = int(_key.getX())-1; x <= int(_key.getX())+1; ++x) {
-        for(int y = int(_key.getY())-1; y <= int(_key.getY())+1; ++y) {
-            for(int z = int(_key.getZ())-1; z <= int(_key.getZ())+1; ++z){
-                newKey.setCoor(x, y, z);
-                searchResult = find(newKey);
-
-                if( searchResult != end() ) {
-                    _res.addAtoms( *(searchResult->second) );
-                    return true;
-                }
+    // have an entry.
+    for(int x = _x-1; x <= _x+1; ++x) {
+        for(int y = _y-1; y <= _y+1; ++y) {
+            for(int z = _z-1; z <= _z+1; ++z){
+                int entry = getBinEntry(x, y, z);
+                if(entry >= 0)
+                    return entry;
             }
         }
     }
 
-    return false;
-}
-
-/**
- * This function is called as a last resort to find the best entry in our
- * LUT.  Basically, first we look for an entry with the given key.  If that doesn't
- * work, then we call search3x3Neighborhood and look for an entry in any of the
- * 26 neighboring locations (3x3 neighborhood).  If none of those has an entry,
- * then we iterate through all entries in our table, and calculate the cartesian
- * distance between the key for that entry and our desired key.  We return the value
- * in the entry which minimizes this distance.
- *
- * @param _res This is the Residue where we will place the atom vector that best matches the key.
- * @param _key This is the key that we wanted to use, but doesn't have an entry.
- */
-void BBQTable::bruteForceFindClosestTableEntry(Residue &_res, CartesianPoint &_key) {
-    Real minDistance = MslTools::floatMax;
-    map<CartesianPoint, AtomPointerVector *>::iterator searchResult;
-
     // Loop over all entries in our table and find the entry that minimizes
-    // the squared distance between the given key and the key of that entry.
-    for(BBQTable::iterator currIter = begin(); currIter != end(); ++currIter) {
-        CartesianPoint currKey = currIter->first;
-        Real newDistance = currKey.distance(_key);
+    // the distance between the given key and the key of that entry.
+    CartesianPoint key(_x, _y, _z);
+    Real minDistance = MslTools::floatMax;
+    int closest = 0;
+    for(int entry = 0; entry < (int)entryKeys.size(); ++entry) {
+        Real newDistance = entryKeys[entry].distance(key);
 
         if(newDistance < minDistance) {
             minDistance = newDistance;
-            searchResult = currIter;
+            closest = entry;
         }
     }
-    
-    _res.addAtoms( *(searchResult->second) );
+    return closest;
 }
 
 /**
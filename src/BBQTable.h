@@ -31,6 +31,7 @@ You should have received a copy of the GNU Lesser General Public
 #define BBQ_TABLE_H
 
 #include <map>
+#include <vector>
 #include "CoordAxes.h"
 #include "AtomPointerVector.h"
 #include "CartesianPoint.h"
@@ -47,6 +48,13 @@ typedef std::pair<MSL::Residue *, MSL::Residue *> ResiduePtrPair;
  * in a C-alpha backbone chain.  See "Backbone Building from Quadrilaterals:..."
  * by Dominik Gront, Sebastian Kmiecik, and Andrezej Kolinski in the
  * Journal of Compuatational Chemistry Vol 28: 1593-1597, 2007 for more details.
+ *
+ * The map holds the table as read from (or written to) file.  Lookups
+ * go through a dense bin array over the range of keys of the table,
+ * compiled on first use, which stores the packed local-frame C, O and N
+ * offsets of each entry.  Empty bins are resolved to their closest entry
+ * the first time they are hit and the result is cached, so a table should
+ * not be shared between threads while building backbones.
  */
 namespace MSL { 
     
@@ -74,23 +82,23 @@ public:
     void deleteTableEntries();
     void openReader(std::string _bbqTableFileName);
 private:
-    void addAtomsToResidue(Real _r02, Real _r03, Real _r13, CoordAxes &_axes, Residue &_res);
+    void calcBackboneCoordinates(const std::vector<CartesianPoint> &_ca, const std::vector<bool> &_legal, std::vector<int> &_entries, std::vector<double> &_coor);
     void addAtomPointerVector(Real _r02, Real _r03, Real _r13, AtomPointerVector *_av, CoordAxes &_axes);
     
     void calcRDistances(std::vector<Residue *> &_rv, std::map<ResiduePtrPair, Real> &_rDistances);
-    void calcRDistances(Chain &_ch, std::map<ResiduePtrPair, Real> &_rDistances);
 
     void calcLCoords(std::vector<Residue *> &_rv, std::map<Residue *, CoordAxes> &_lCoords);
-    void calcLCoords(Chain &_ch, std::map<Residue *, CoordAxes> &_lCoords);
 
 
     void sumAtomPointerVectors(AtomPointerVector *_av1, AtomPointerVector *_av2);
     double calcCADihedral(Residue *pRes0, Residue *pRes1, Residue *pRes2, Residue *pRes3);
     bool isLegalQuad(Residue *pRes0, Residue *pRes1, Residue *pRes2, Residue *pRes3);
 
-    void findClosestTableEntry(Residue &_res, CartesianPoint &_key);
-    bool search3x3Neighborhood(Residue &_res, CartesianPoint &_key);
-    void bruteForceFindClosestTableEntry(Residue &_res, CartesianPoint &_key);
+    void compileTable();
+    int getTableEntry(Real _r02, Real _r03, Real _r13);
+    int getBinEntry(int _x, int _y, int _z) const;
+    int findClosestTableEntry(int _x, int _y, int _z);
+
     bool doCADistanceCheck(Residue *pRes0, Residue *pRes1);
     bool doAllFourResiduesHaveGivenAtom(Residue *pRes0, Residue *pRes1, Residue *pRes2, Residue *pRes3, std::string atomName);
 
@@ -98,11 +106,22 @@ private:
     Real binSizes[3];
     bool debugFlag;
     std::map<CartesianPoint, unsigned int, CartesianPointCompare> counts;
+
+    // the compiled lookup (see compileTable)
+    bool compiled;
+    int keyMin[3];
+    int keyDims[3];
+    std::vector<int> binEntries;            // entry in each bin, -1 if the bin is empty
+    std::vector<int> binClosest;            // entry used for each bin, -1 until resolved
+    std::vector<double> entryOffsets;       // local-frame C, O and N offsets, 9 per entry
+    std::vector<Atom *> entryAtoms;         // the C, O and N atoms of each entry
+    std::vector<CartesianPoint> entryKeys;  // keys of the entries, in map order
 };
 
 // inlines
 inline BBQTable::BBQTable() {
     debugFlag = false;
+    compiled = false;
 }
 /**
  * This function will delete all AtomPointerVectors in our table.
@@ -119,6 +138,9 @@ inline void BBQTable::deleteTableEntries() {
 
         delete currAv;
     }
+    clear();
+    counts.clear();
+    compiled = false;
 }
 /**
  * This is the destructor for the BBQTable object.
@@ -136,6 +158,7 @@ inline void BBQTable::setBinSizes(Real x, Real y, Real z) {
     binSizes[0] = x;
     binSizes[1] = y;
     binSizes[2] = z;
+    compiled = false;
 };
 
 inline void BBQTable::getBinSizes(Real &x, Real &y, Real &z) {
@@ -144,6 +167,20 @@ inline void BBQTable::getBinSizes(Real &x, Real &y, Real &z) {
     z = binSizes[2];
 }
 
+/**
+ * This function returns the entry stored in the bin with the given
+ * (integer) key of the compiled table, or -1 if the bin is empty or
+ * outside of the range of the table.
+ */
+inline int BBQTable::getBinEntry(int _x, int _y, int _z) const {
+    _x -= keyMin[0];
+    _y -= keyMin[1];
+    _z -= keyMin[2];
+    if(_x < 0 || _x >= keyDims[0] || _y < 0 || _y >= keyDims[1] || _z < 0 || _z >= keyDims[2])
+        return -1;
+    return binEntries[(_x * keyDims[1] + _y) * keyDims[2] + _z];
+}
+
 }
 
 #endif // BBQ_TABLE_H
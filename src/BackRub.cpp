@@ -32,6 +32,8 @@ You should have received a copy of the GNU Lesser General Public
 #include "RandomNumberGenerator.h"
 #include "PDBWriter.h"
 #include "PyMolVisualization.h"
+#include "RigidTransform.h"
+
 
 using namespace MSL;
 using namespace std;
@@ -41,6 +43,9 @@ using namespace std;
 static MslOut MSLOUT("BackRub");
 
 BackRub::BackRub(){
+	pESet = NULL;
+	energyCutoff = 10.0;
+	numThreads = 0;
 }
 
 BackRub::~BackRub(){
@@ -236,3 +241,275 @@ void BackRub::doMinorRotation(Residue &_r1, Residue &_r2, CartesianPoint &_targe
 }
 
 
+
+int BackRub::getNumThreads() const {
+	return MslTools::getNumThreads(numThreads);
+}
+
+unsigned int BackRub::sampleEnsemble(Chain &_ch, int _startResIndex, int _endResIndex, unsigned int _numMoves, unsigned int _seed){
+
+	windows.clear();
+	moves.clear();
+	moveCoor.clear();
+
+	if (!_ch.getResidue(_startResIndex).atomExists("CA") || !_ch.getResidue(_endResIndex).atomExists("CA")){
+		cerr << "ERROR BackRub::sampleEnsemble() one or both stem residues does not contain a 'CA' atom."<<endl;	
+		return 0;
+	}
+	int randRange = _endResIndex - _startResIndex - 3;
+	if (randRange < 0) {
+		cerr << "ERROR BackRub::sampleEnsemble() the stem residues are less than 3 residues apart."<<endl;
+		return 0;
+	}
+
+	if (_seed == 0) {
+		RandomNumberGenerator rng;
+		rng.setTimeBasedSeed();
+		_seed = rng.getSeed();
+	}
+	MSLOUT.stream() << "SEED: "<<_seed<<endl;
+
+	/***********************************************************
+	 *  Draw the moves (window and omega, with the same
+	 *  distributions of localSample) and lay out the buffer:
+	 *  each move gets the slots for the atoms of its window
+	 ***********************************************************/
+	windows.resize(randRange + 1);
+	vector<bool> windowSet(windows.size(), false);
+	moves.resize(_numMoves);
+	unsigned int offset = 0;
+	for (unsigned int i=0; i<_numMoves; i++) {
+		RandomStream stream(_seed, i);
+		Move & m = moves[i];
+		m.window = stream.getRandomInt(randRange);
+		m.startRes = _startResIndex + m.window;
+		m.omega = 0.0;
+		while (m.omega == 0.0){
+			m.omega = stream.getRandomInt(20);
+		}
+		// assign  +/- randomly.
+		if (stream.getRandomDouble() > 0.5){
+			m.omega *= -1;
+		}
+		m.accepted = false;
+		m.energy = 0.0;
+
+		if (!windowSet[m.window]) {
+			if (!setupWindow(_ch, m.startRes, windows[m.window])) {
+				windows.clear();
+				moves.clear();
+				return 0;
+			}
+			windowSet[m.window] = true;
+		}
+		m.offset = offset;
+		offset += windows[m.window].atoms.size();
+	}
+	moveCoor.resize(offset);
+
+	/***********************************************************
+	 *  Generate the moves: each one only reads its window and
+	 *  writes its own slots of the buffer
+	 ***********************************************************/
+#ifdef __OPENMP__
+	#pragma omp parallel for schedule(dynamic, 16) num_threads(getNumThreads())
+#endif
+	for (int i=0; i<(int)_numMoves; i++) {
+		generateMove(moves[i]);
+	}
+
+	/***********************************************************
+	 *  Screen the moves by local energy change (serial, it
+	 *  needs to set the coordinates of the atoms)
+	 ***********************************************************/
+	if (pESet != NULL) {
+		for (unsigned int w=0; w<windows.size(); w++) {
+			if (!windowSet[w] || !windows[w].valid) {
+				continue;
+			}
+			pESet->saveEnergySubset("__BackRub_window__" + MslTools::intToString(w), windows[w].atoms);
+			windows[w].startEnergy = pESet->calcEnergyOfSubset("__BackRub_window__" + MslTools::intToString(w));
+		}
+		for (unsigned int i=0; i<moves.size(); i++) {
+			Move & m = moves[i];
+			if (!m.accepted) {
+				continue;
+			}
+			Window & w = windows[m.window];
+			setWindowCoor(w, &moveCoor[m.offset]);
+			m.energy = pESet->calcEnergyOfSubset("__BackRub_window__" + MslTools::intToString(m.window)) - w.startEnergy;
+			setWindowCoor(w, &w.start[0]);
+			if (m.energy > energyCutoff) {
+				m.accepted = false;
+			}
+		}
+		for (unsigned int w=0; w<windows.size(); w++) {
+			pESet->removeEnergySubset("__BackRub_window__" + MslTools::intToString(w));
+		}
+	}
+
+	/***********************************************************
+	 *  Materialize the accepted moves
+	 ***********************************************************/
+	stringstream ss;
+	unsigned int accepted = 0;
+	for (unsigned int i=0; i<moves.size(); i++) {
+		Move & m = moves[i];
+		if (!m.accepted) {
+			continue;
+		}
+		Window & w = windows[m.window];
+		setWindowCoor(w, &moveCoor[m.offset]);
+
+		sys.addAtoms(_ch.getAtomPointers());
+
+		ss << "MODEL"<<endl;
+		PDBWriter pss;
+		pss.open(ss);
+		pss.write(_ch.getAtomPointers());
+		pss.close();		
+		ss << "ENDMDL"<<endl;
+
+		setWindowCoor(w, &w.start[0]);
+		accepted++;
+	}
+	sysNMRFormat = ss.str();
+
+	return accepted;
+}
+
+bool BackRub::setupWindow(Chain &_ch, int _startRes, Window & _w) {
+	Residue &res1 = _ch.getResidue(_startRes);
+	Residue &res2 = _ch.getResidue(_startRes+1);
+	Residue &res3 = _ch.getResidue(_startRes+2);
+
+	_w.atoms.clear();
+	_w.start.clear();
+	_w.res2Atoms.clear();
+	_w.startEnergy = 0.0;
+
+	// Weird things happen when PRO is at residue 2 (see localSample)
+	_w.valid = res2.getResidueName() != "PRO";
+	if (!_w.valid) {
+		return true;
+	}
+
+	if (!res1.atomExists("CA")  || !res2.atomExists("CA") || !res3.atomExists("CA")){
+		cerr << "ERROR BackRub::sampleEnsemble() res1,res2,res3 for defining mainRotationAxis does not have CA atom.\n";
+		return false;
+	}
+	if (!res2.atomExists("O")  || !res3.atomExists("O")){
+		cerr << "ERROR BackRub::sampleEnsemble() res2,res3 for defining mainRotationAxis does not have O atom.\n";
+		return false;
+	}
+	if (!res1.atomExists("C") || !res1.atomExists("O") || !res2.atomExists("N") || !res2.atomExists("C") || !res3.atomExists("N")){
+		cerr << "ERROR BackRub::sampleEnsemble() res1,res2,res3 do not have the C, O and N backbone atoms.\n";
+		return false;
+	}
+
+	// the atoms that localSample moves: C=O of res1, all of res2, N-H of res3
+	_w.C1 = _w.atoms.size();
+	_w.atoms.push_back(&res1("C"));
+	_w.O1 = _w.atoms.size();
+	_w.atoms.push_back(&res1("O"));
+	AtomPointerVector & res2Atoms = res2.getAtomPointers();
+	for (unsigned int i=0; i<res2Atoms.size(); i++) {
+		_w.res2Atoms.push_back(_w.atoms.size());
+		_w.atoms.push_back(res2Atoms[i]);
+	}
+	_w.N3 = _w.atoms.size();
+	_w.atoms.push_back(&res3("N"));
+	_w.H3 = _w.atoms.size();
+	if (res3.atomExists("H")){
+		_w.atoms.push_back(&res3("H"));
+	}
+
+	// the indices of the res2 atoms used by the minor rotations
+	_w.N2 = _w.CA2 = _w.C2 = _w.O2 = _w.H2 = _w.atoms.size();
+	for (unsigned int i=0; i<_w.res2Atoms.size(); i++) {
+		string name = _w.atoms[_w.res2Atoms[i]]->getName();
+		if (name == "N") {
+			_w.N2 = _w.res2Atoms[i];
+		} else if (name == "CA") {
+			_w.CA2 = _w.res2Atoms[i];
+		} else if (name == "C") {
+			_w.C2 = _w.res2Atoms[i];
+		} else if (name == "O") {
+			_w.O2 = _w.res2Atoms[i];
+		} else if (name == "H") {
+			_w.H2 = _w.res2Atoms[i];
+		}
+	}
+
+	for (unsigned int i=0; i<_w.atoms.size(); i++) {
+		_w.start.push_back(_w.atoms[i]->getCoor());
+	}
+	_w.CA1 = res1("CA").getCoor();
+	_w.CA3 = res3("CA").getCoor();
+
+	// For second minor rotation we will try to use Oxygen of endRes+1 residue, if it doesn't exist use Nitrogen of endRes (see localSample).
+	_w.preAt2 = res2("N").getCoor();
+	if (_startRes+3 < _ch.positionSize() && _ch.getResidue(_startRes+3).atomExists("O")){
+		_w.preAt2 = _ch.getResidue(_startRes+3)("O").getCoor();
+	}
+	return true;
+}
+
+void BackRub::generateMove(Move & _move) {
+	/***********************************************************
+	 *  The rotations of localSample and doMinorRotation applied
+	 *  to the buffer: major rotation of all the window atoms
+	 *  by omega around CA1-CA3, then the two compensatory
+	 *  rotations of the peptide bonds around CA1-CA2 and CA2-CA3
+	 ***********************************************************/
+	const Window & w = windows[_move.window];
+	if (!w.valid) {
+		_move.accepted = false;
+		return;
+	}
+	unsigned int n = w.atoms.size();
+	CartesianPoint * p = &moveCoor[_move.offset];
+	for (unsigned int i=0; i<n; i++) {
+		p[i] = w.start[i];
+	}
+
+	// major rotation
+	RigidTransform major(CartesianGeometry::getRotationMatrix(_move.omega, w.CA3 - w.CA1), w.CA1);
+	for (unsigned int i=0; i<n; i++) {
+		major.apply(p[i]);
+	}
+
+	// minor rotation 1: put O1 back, around CA1-CA2
+	CartesianPoint CA2 = p[w.CA2];
+	double preDihedral = w.start[w.O1].dihedral(w.CA1, CA2, w.start[w.O2]);
+	double postDihedral = p[w.O1].dihedral(w.CA1, CA2, w.start[w.O2]);
+	RigidTransform minor1(CartesianGeometry::getRotationMatrix(postDihedral - preDihedral, CA2 - w.CA1), w.CA1);
+	minor1.apply(p[w.O1]);
+	minor1.apply(p[w.C1]);
+	minor1.apply(p[w.N2]);
+	if (w.H2 < n) {
+		minor1.apply(p[w.H2]);
+	}
+
+	// minor rotation 2: put O2 back, around CA2-CA3
+	preDihedral = w.start[w.O2].dihedral(CA2, w.CA3, w.preAt2);
+	postDihedral = p[w.O2].dihedral(CA2, w.CA3, w.preAt2);
+	RigidTransform minor2(CartesianGeometry::getRotationMatrix(postDihedral - preDihedral, w.CA3 - CA2), CA2);
+	minor2.apply(p[w.O2]);
+	minor2.apply(p[w.C2]);
+	minor2.apply(p[w.N3]);
+	if (w.H3 < n) {
+		minor2.apply(p[w.H3]);
+	}
+
+	// Quick check. make sure the Ca-Ca distances are still ok.
+	double dist1 = w.CA1.distance(CA2);
+	double dist2 = CA2.distance(w.CA3);
+	_move.accepted = fabs(dist1 - 3.8) <= 0.1 && fabs(dist2 - 3.8) <= 0.1;
+}
+
+void BackRub::setWindowCoor(const Window & _w, const CartesianPoint * _coor) {
+	for (unsigned int i=0; i<_w.atoms.size(); i++) {
+		_w.atoms[i]->setCoor(_coor[i]);
+	}
+}
@@ -34,6 +34,7 @@ You should have received a copy of the GNU Lesser General Public
 #include "Chain.h"
 #include "AtomPointerVector.h"
 #include "System.h"
+#include "EnergySet.h"
 
 namespace MSL { 
 class BackRub {
@@ -44,6 +45,45 @@ class BackRub {
 		
 		void localSample(Chain &_ch, int _startResIndex, int _endResIndex, int _numFragments);
 
+		/***********************************************************
+		 *  Ensemble sampling
+		 *
+		 *  Unlike localSample, which applies its moves cumulatively,
+		 *  sampleEnsemble generates _numMoves independent backrub
+		 *  moves of the current conformation of the chain. Each move
+		 *  only stores the new coordinates of the atoms it moves (C
+		 *  and O of the first residue, the middle residue, N and H
+		 *  of the third) in a preallocated buffer.  The moves are
+		 *  generated in parallel if MSL is compiled with OpenMP;
+		 *  move i uses the random stream (seed, i), so the ensemble
+		 *  does not depend on the number of threads.
+		 *
+		 *  If an EnergySet is given, the local energy change of each
+		 *  move (the interactions that involve the moved atoms) is
+		 *  calculated and the moves above the cutoff are rejected
+		 *  before they are materialized.  The accepted moves are
+		 *  added to the internal System and NMR string as in
+		 *  localSample, and the chain is left in its starting
+		 *  conformation.  Only the current coordinates are moved.
+		 *
+		 *  Returns the number of accepted moves.
+		 ***********************************************************/
+		unsigned int sampleEnsemble(Chain &_ch, int _startResIndex, int _endResIndex, unsigned int _numMoves, unsigned int _seed=0);
+
+		void setEnergySet(EnergySet * _pESet); // NULL (default) to skip the energy screening
+		void setEnergyCutoff(double _cutoff); // reject moves with a larger energy change (default 10.0)
+		void setNumThreads(int _threads); // 0 (default) for all cores (OpenMP only)
+		int getNumThreads() const;
+
+		// the moves of the last ensemble
+		unsigned int getNumberOfMoves() const;
+		bool getMoveAccepted(unsigned int _i) const;
+		int getMoveStartResidue(unsigned int _i) const; // index of the first of the three residues in the chain
+		double getMoveOmega(unsigned int _i) const;
+		double getMoveEnergy(unsigned int _i) const; // the energy change (0.0 if not screened)
+		std::vector<Atom*> getMoveAtoms(unsigned int _i) const; // the atoms moved (none if the middle residue is a PRO)
+		std::vector<CartesianPoint> getMoveCoor(unsigned int _i) const; // their coordinates after the move
+
 		
 		AtomPointerVector&  getAtomPointers() { return sys.getAllAtomPointers(); }
 		std::string getNMRString() { return sysNMRFormat; }
@@ -51,10 +91,59 @@ class BackRub {
 		
 		void doMinorRotation(Residue &_r1, Residue &_r2, CartesianPoint &_targetAtom1, CartesianPoint &_targetAtom2);
 
+		/***********************************************************
+		 *  A window of three residues (res1, res2, res3) that a move
+		 *  rotates: the moved atoms and their starting coordinates,
+		 *  with the indices of the atoms that the move uses
+		 ***********************************************************/
+		struct Window {
+			bool valid; // false if the middle residue is a PRO (skipped as in localSample)
+			std::vector<Atom*> atoms; // C1 O1 res2-atoms N3 [H3]
+			std::vector<CartesianPoint> start;
+			unsigned int C1, O1, N2, H2, CA2, C2, O2, N3, H3; // H2, H3 = atoms.size() if missing
+			CartesianPoint CA1, CA3, preAt2;
+			std::vector<unsigned int> res2Atoms;
+			double startEnergy;
+		};
+		struct Move {
+			int startRes;
+			unsigned int window;
+			double omega;
+			unsigned int offset; // in moveCoor
+			bool accepted;
+			double energy;
+		};
+
+		bool setupWindow(Chain &_ch, int _startRes, Window & _w);
+		void generateMove(Move & _move);
+		void setWindowCoor(const Window & _w, const CartesianPoint * _coor);
+
 		System sys;
 		std::string sysNMRFormat;
+
+		EnergySet * pESet;
+		double energyCutoff;
+		int numThreads;
+
+		std::vector<Window> windows;
+		std::vector<Move> moves;
+		std::vector<CartesianPoint> moveCoor;
 };
 
+inline void BackRub::setEnergySet(EnergySet * _pESet) {pESet = _pESet;}
+inline void BackRub::setEnergyCutoff(double _cutoff) {energyCutoff = _cutoff;}
+inline void BackRub::setNumThreads(int _threads) {numThreads = _threads;}
+inline unsigned int BackRub::getNumberOfMoves() const {return moves.size();}
+inline bool BackRub::getMoveAccepted(unsigned int _i) const {return moves[_i].accepted;}
+inline int BackRub::getMoveStartResidue(unsigned int _i) const {return moves[_i].startRes;}
+inline double BackRub::getMoveOmega(unsigned int _i) const {return moves[_i].omega;}
+inline double BackRub::getMoveEnergy(unsigned int _i) const {return moves[_i].energy;}
+inline std::vector<Atom*> BackRub::getMoveAtoms(unsigned int _i) const {return windows[moves[_i].window].atoms;}
+inline std::vector<CartesianPoint> BackRub::getMoveCoor(unsigned int _i) const {
+	std::vector<CartesianPoint>::const_iterator start = moveCoor.begin() + moves[_i].offset;
+	return std::vector<CartesianPoint>(start, start + windows[moves[_i].window].atoms.size());
+}
+
 }
 
 #endif
@@ -28,6 +28,8 @@ You should have received a copy of the GNU Lesser General Public
 */
 #include "CCD.h"
 #include "AtomContainer.h"
+#include "RigidTransform.h"
+
 
 using namespace MSL;
 using namespace std;
@@ -35,11 +37,17 @@ using namespace std;
 
 CCD::CCD(){
 	useBBQ = false;
+	pESet = NULL;
+	energyCutoff = 10.0;
+	numThreads = 0;
 }
 
 CCD::CCD(string _BBQTableForBackboneAtoms){
 	bbqT.openReader(_BBQTableForBackboneAtoms);
 	useBBQ = true;
+	pESet = NULL;
+	energyCutoff = 10.0;
+	numThreads = 0;
 }
 
 CCD::~CCD(){
@@ -200,12 +208,20 @@ void CCD::closeFragment(AtomPointerVector &_av, Atom &_fixedEnd){
 
 
 double CCD::getMinimumAngle(AtomPointerVector &_av, int _indexOfPivot, Atom &_fixedEnd){
+	double angle = getMinimumAngle(_av(_indexOfPivot).getCoor(), _av(_indexOfPivot+1).getCoor(), _av(_av.size()-1).getCoor(), _fixedEnd.getCoor());
+	if (angle == MslTools::doubleMax) {
+		cout << "Failed second derivate test"<<endl;
+	}
+	return angle;
+}
+
+double CCD::getMinimumAngle(const CartesianPoint & _pivot, const CartesianPoint & _next, const CartesianPoint & _end, const CartesianPoint & _fixedEnd){
 	
 	// Get Pid and Pih
-	CartesianPoint pid  = (_fixedEnd.getCoor()            - _av(_indexOfPivot).getCoor());
-	CartesianPoint pih  = (_av(_av.size()-1).getCoor()    - _av(_indexOfPivot).getCoor());
+	CartesianPoint pid  = (_fixedEnd - _pivot);
+	CartesianPoint pih  = (_end      - _pivot);
 	
-	CartesianPoint pivotBondVector =  (_av(_indexOfPivot+1).getCoor() - _av(_indexOfPivot).getCoor());
+	CartesianPoint pivotBondVector =  (_next - _pivot);
 	pivotBondVector = pivotBondVector.getUnit();
 
 	// Compute Ks
@@ -227,7 +243,6 @@ double CCD::getMinimumAngle(AtomPointerVector &_av, int _indexOfPivot, Atom &_fi
 	double secondDerviative = (k1-k2)*cos(psi) - k3* sin(psi);
 	//cout << "Second derviative: "<<secondDerviative<<endl;
 	if (secondDerviative >= 0) {
-		cout << "Failed second derivate test"<<endl;
 		return MslTools::doubleMax;
 	}
 
@@ -250,11 +265,200 @@ void CCD::rotateFragment(AtomPointerVector &_av, int _indexOfPivot, double _angl
 
 	// Axis of rotation
 	CartesianPoint axisOfRotation = _av(_indexOfPivot+1).getCoor();
+	CartesianPoint center = _av(_indexOfPivot).getCoor();
 
-	// Transform each atom downstream.
+	// Transform each atom downstream (the rotation matrix is the same for all)
+	Matrix m = CartesianGeometry::getRotationMatrix(_angleOfRotation, axisOfRotation - center);
 	Transforms t;
 	for (uint i = _indexOfPivot+2; i < _av.size();i++){
-		t.rotate(_av(i),_angleOfRotation, axisOfRotation,_av(_indexOfPivot).getCoor());
+		t.rotate(_av(i), m, center);
 	}
 	
 }
+
+void CCD::rotateFragment(CartesianPoint * _coor, unsigned int _size, int _indexOfPivot, double _angleOfRotation){
+	RigidTransform t(CartesianGeometry::getRotationMatrix(_angleOfRotation, _coor[_indexOfPivot+1] - _coor[_indexOfPivot]), _coor[_indexOfPivot]);
+	for (unsigned int i = _indexOfPivot+2; i < _size; i++){
+		t.apply(_coor[i]);
+	}
+}
+
+bool CCD::closeFragment(CartesianPoint * _coor, unsigned int _size, const CartesianPoint & _fixedEnd, unsigned int & _iterations){
+	// same as closeFragment(AtomPointerVector &, Atom &) on a coordinate buffer
+	_iterations = 0;
+	while (true) {
+		for (unsigned int i = _size-3; i > 1;i--){
+			double angle = getMinimumAngle(_coor[i], _coor[i+1], _coor[_size-1], _fixedEnd);
+			if (angle == MslTools::doubleMax) continue;
+			rotateFragment(_coor, _size, i, angle);
+			if (_fixedEnd.distance(_coor[_size-1]) < 0.02){
+				return true;
+			}
+		}
+
+		for (unsigned int i = 0; i < _size-2;i++){
+			double angle = getMinimumAngle(_coor[i], _coor[i+1], _coor[_size-1], _fixedEnd);
+			if (angle == MslTools::doubleMax) continue;
+			rotateFragment(_coor, _size, i, angle);
+			if (_fixedEnd.distance(_coor[_size-1]) < 0.02){
+				_iterations++;
+				return true;
+			}
+		}
+
+		_iterations++;
+		if (_iterations > 1000000) return false;
+	}
+}
+
+int CCD::getNumThreads() const {
+	return MslTools::getNumThreads(numThreads);
+}
+
+unsigned int CCD::sampleEnsemble(AtomPointerVector &_av, unsigned int _numFragments, int _maxDegree, unsigned int _seed){
+
+	fragments.clear();
+	fragmentCoor.clear();
+	startCoor.clear();
+	if (_av.size() < 6) {
+		cerr << "ERROR CCD::sampleEnsemble() the loop needs at least 6 atoms." << endl;
+		return 0;
+	}
+
+	// Take one atom off each end for BBQ purposes (as localSample)
+	Atom *forBBQ_N = new Atom(_av(_av.size()-1));
+	Atom *forBBQ_C = new Atom(_av(0));
+	AtomPointerVector av;
+	for (unsigned int i=1; i<_av.size()-1; i++) {
+		av.push_back(_av[i]);
+	}
+
+	AtomPointerVector forBBQ;
+	forBBQ.push_back(forBBQ_N);
+	forBBQ.push_back(forBBQ_C);
+
+	if (_seed == 0) {
+		RandomNumberGenerator rng;
+		rng.setTimeBasedSeed();
+		_seed = rng.getSeed();
+	}
+
+	unsigned int n = av.size();
+	for (unsigned int i=0; i<n; i++) {
+		startCoor.push_back(av[i]->getCoor());
+	}
+	fragments.resize(_numFragments);
+	fragmentCoor.resize(_numFragments * n);
+
+	// perturb and close the fragments, each in its own slot
+#ifdef __OPENMP__
+	#pragma omp parallel for schedule(dynamic, 1) num_threads(getNumThreads())
+#endif
+	for (int i=0; i<(int)_numFragments; i++) {
+		generateFragment(i, _seed, _maxDegree);
+	}
+
+	// screen them by energy change (serial, it sets the coordinates of the atoms)
+	if (pESet != NULL) {
+		pESet->saveEnergySubset("__CCD_loop__", av);
+		double startEnergy = pESet->calcEnergyOfSubset("__CCD_loop__");
+		for (unsigned int f=0; f<fragments.size(); f++) {
+			if (!fragments[f].accepted) {
+				continue;
+			}
+			for (unsigned int i=0; i<n; i++) {
+				av[i]->setCoor(fragmentCoor[f*n + i]);
+			}
+			fragments[f].energy = pESet->calcEnergyOfSubset("__CCD_loop__") - startEnergy;
+			if (fragments[f].energy > energyCutoff) {
+				fragments[f].accepted = false;
+			}
+		}
+		for (unsigned int i=0; i<n; i++) {
+			av[i]->setCoor(startCoor[i]);
+		}
+		pESet->removeEnergySubset("__CCD_loop__");
+	}
+
+	// materialize the accepted fragments
+	stringstream ss;
+	PDBWriter pout;
+	AtomContainer allAtoms;
+	unsigned int accepted = 0;
+	for (unsigned int f=0; f<fragments.size(); f++) {
+		if (!fragments[f].accepted) {
+			continue;
+		}
+		for (unsigned int i=0; i<n; i++) {
+			av[i]->setCoor(fragmentCoor[f*n + i]);
+		}
+
+		Chain c;
+		if (useBBQ){
+			c.addAtoms(forBBQ);
+			c.addAtoms(av);
+			bbqT.fillInMissingBBAtoms(c);
+		} else {
+			c.addAtoms(av);
+		}
+
+		allAtoms.addAtoms(forBBQ);
+		allAtoms.addAtoms(c.getAtomPointers());
+
+		ss << "MODEL "<<endl;
+		stringstream tmp;
+		pout.open(tmp);
+		pout.write(c.getAtomPointers());
+		pout.close();
+
+		ss << tmp.str()<< "ENDMDL\n";
+		accepted++;
+	}
+	for (unsigned int i=0; i<n; i++) {
+		av[i]->setCoor(startCoor[i]);
+	}
+
+	closedSystem.addAtoms(allAtoms.getAtomPointers());
+	closedSystem_NMRString = ss.str();
+
+	delete forBBQ_N;
+	delete forBBQ_C;
+	return accepted;
+}
+
+void CCD::generateFragment(unsigned int _i, unsigned int _seed, int _maxDegree) {
+	/***********************************************************
+	 *  The perturbation and closure of localSample on the slot
+	 *  of fragment _i of the buffer, with its own stream
+	 ***********************************************************/
+	RandomStream stream(_seed, _i);
+	unsigned int n = startCoor.size();
+	CartesianPoint * p = &fragmentCoor[_i * n];
+
+	// Figure out which way to order the loop
+	bool reversed = stream.getRandomDouble() > 0.5;
+	for (unsigned int k=0; k<n; k++) {
+		p[k] = reversed ? startCoor[n-1-k] : startCoor[k];
+	}
+
+	// Fixed atom is last Atom.
+	CartesianPoint fixedEnd = p[n-1];
+
+	// Now move the loop
+	for (unsigned int i = 1; i < n-2;i++){
+		double angle = stream.getRandomInt(_maxDegree);
+		RigidTransform t(CartesianGeometry::getRotationMatrix(angle, p[i+1] - p[i]), p[i]);
+		for (unsigned int j=i+2; j < n;j++){
+			t.apply(p[j]);
+		}
+	}
+
+	Fragment & f = fragments[_i];
+	f.closed = closeFragment(p, n, fixedEnd, f.iterations);
+	f.accepted = f.closed;
+	f.energy = 0.0;
+
+	if (reversed){
+		std::reverse(p, p + n);
+	}
+}
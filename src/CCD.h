@@ -41,6 +41,7 @@ You should have received a copy of the GNU Lesser General Public
 #include "RandomNumberGenerator.h"
 #include "PDBWriter.h"
 #include "System.h"
+#include "EnergySet.h"
 
 
 namespace MSL { 
@@ -56,12 +57,69 @@ class CCD {
 		void closeFragment(AtomPointerVector &_av, Atom &_fixedEnd);
 		AtomPointerVector& getAtomPointers() { return closedSystem.getAllAtomPointers(); }
 		std::string getNMRString() { return closedSystem_NMRString; }
+
+		/***********************************************************
+		 *  Ensemble sampling
+		 *
+		 *  As localSample, but the _numFragments perturbations of
+		 *  the loop are generated and closed in parallel (if MSL is
+		 *  compiled with OpenMP), each in its own slot of a
+		 *  preallocated coordinate buffer and with its own random
+		 *  stream (seed, i), so the ensemble does not depend on the
+		 *  number of threads.  The loop atoms are not modified
+		 *  while sampling, and only their current coordinates are
+		 *  used.
+		 *
+		 *  If an EnergySet is given, the energy change of the
+		 *  interactions that involve the loop atoms is calculated
+		 *  for each closed fragment, and those above the cutoff are
+		 *  rejected before they are materialized (the others are
+		 *  added to the System and NMR string as in localSample).
+		 *  Unlike localSample, _av is not modified.
+		 *
+		 *  Returns the number of accepted fragments.
+		 ***********************************************************/
+		unsigned int sampleEnsemble(AtomPointerVector &_av, unsigned int _numFragments, int _maxDegree, unsigned int _seed=0);
+
+		void setEnergySet(EnergySet * _pESet); // NULL (default) to skip the energy screening
+		void setEnergyCutoff(double _cutoff); // reject fragments with a larger energy change (default 10.0)
+		void setNumThreads(int _threads); // 0 (default) for all cores (OpenMP only)
+		int getNumThreads() const;
+
+		// the fragments of the last ensemble
+		unsigned int getNumberOfFragments() const;
+		bool getFragmentClosed(unsigned int _i) const;
+		bool getFragmentAccepted(unsigned int _i) const;
+		unsigned int getFragmentIterations(unsigned int _i) const;
+		double getFragmentEnergy(unsigned int _i) const; // the energy change (0.0 if not screened)
+		std::vector<CartesianPoint> getFragmentCoor(unsigned int _i) const; // the coordinates of the loop atoms (without the two end atoms)
 		
 	private:
 
 		double getMinimumAngle(AtomPointerVector &_av, int _indexOfPivot, Atom &_fixedEnd);
 		void rotateFragment(AtomPointerVector &_av, int _indexOfPivot, double _angleOfRotation);
 
+		// the same on a coordinate buffer
+		static double getMinimumAngle(const CartesianPoint & _pivot, const CartesianPoint & _next, const CartesianPoint & _end, const CartesianPoint & _fixedEnd);
+		static void rotateFragment(CartesianPoint * _coor, unsigned int _size, int _indexOfPivot, double _angleOfRotation);
+		static bool closeFragment(CartesianPoint * _coor, unsigned int _size, const CartesianPoint & _fixedEnd, unsigned int & _iterations);
+
+		struct Fragment {
+			bool closed;
+			bool accepted;
+			unsigned int iterations;
+			double energy;
+		};
+		void generateFragment(unsigned int _i, unsigned int _seed, int _maxDegree);
+
+		EnergySet * pESet;
+		double energyCutoff;
+		int numThreads;
+
+		std::vector<CartesianPoint> startCoor;
+		std::vector<CartesianPoint> fragmentCoor; // numFragments x loop size
+		std::vector<Fragment> fragments;
+
 
 		BBQTable bbqT;
 		bool useBBQ;
@@ -71,6 +129,19 @@ class CCD {
 		
 };
 
+inline void CCD::setEnergySet(EnergySet * _pESet) {pESet = _pESet;}
+inline void CCD::setEnergyCutoff(double _cutoff) {energyCutoff = _cutoff;}
+inline void CCD::setNumThreads(int _threads) {numThreads = _threads;}
+inline unsigned int CCD::getNumberOfFragments() const {return fragments.size();}
+inline bool CCD::getFragmentClosed(unsigned int _i) const {return fragments[_i].closed;}
+inline bool CCD::getFragmentAccepted(unsigned int _i) const {return fragments[_i].accepted;}
+inline unsigned int CCD::getFragmentIterations(unsigned int _i) const {return fragments[_i].iterations;}
+inline double CCD::getFragmentEnergy(unsigned int _i) const {return fragments[_i].energy;}
+inline std::vector<CartesianPoint> CCD::getFragmentCoor(unsigned int _i) const {
+	unsigned int n = startCoor.size();
+	return std::vector<CartesianPoint>(fragmentCoor.begin() + _i * n, fragmentCoor.begin() + (_i + 1) * n);
+}
+
 }
 
 #endif
@@ -0,0 +1,157 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "CellList.h"
+
+using namespace MSL;
+using namespace std;
+
+CellList::CellList() {
+	clear();
+}
+
+CellList::CellList(const vector<double> & _xyz, double _minCellSize) {
+	build(_xyz, _minCellSize);
+}
+
+CellList::~CellList() {
+}
+
+void CellList::clear() {
+	for (unsigned int k = 0; k < 3; k++) {
+		boxMin[k] = 0.0;
+		gridSize[k] = 0;
+	}
+	cellSize = 0.0;
+	firstPoint.clear();
+	nextPoint.clear();
+	pointCell.clear();
+}
+
+void CellList::build(const vector<double> & _xyz, double _minCellSize) {
+	clear();
+	unsigned int n = _xyz.size() / 3;
+	if (n == 0) {
+		return;
+	}
+
+	double boxMax[3];
+	for (unsigned int i = 0; i < n; i++) {
+		for (unsigned int k = 0; k < 3; k++) {
+			double x = _xyz[3*i+k];
+			if (i == 0 || x < boxMin[k]) boxMin[k] = x;
+			if (i == 0 || x > boxMax[k]) boxMax[k] = x;
+		}
+	}
+
+	// grow the cells for sparse sets so that the grid stays proportional to the number of points
+	cellSize = _minCellSize > 0.0 ? _minCellSize : 1.0;
+	while (true) {
+		for (unsigned int k = 0; k < 3; k++) {
+			gridSize[k] = (unsigned int)((boxMax[k] - boxMin[k]) / cellSize) + 1;
+		}
+		if ((double)gridSize[0] * gridSize[1] * gridSize[2] <= 8.0 * n + 27) {
+			break;
+		}
+		cellSize *= 1.5;
+	}
+
+	// the points are added in reverse, so that each cell lists them in increasing order
+	firstPoint.assign(gridSize[0] * gridSize[1] * gridSize[2], n);
+	nextPoint.assign(n, n);
+	pointCell.assign(n, 0);
+	for (unsigned int i = n; i > 0; i--) {
+		unsigned int c = getCell(&_xyz[3*(i-1)]);
+		pointCell[i-1] = c;
+		nextPoint[i-1] = firstPoint[c];
+		firstPoint[c] = i-1;
+	}
+}
+
+void CellList::getNeighborCells(const double * _p, vector<unsigned int> & _cells) const {
+	_cells.clear();
+	if (firstPoint.size() == 0) {
+		return;
+	}
+	int c[3];
+	cellIndices(_p, c);
+	for (int x = c[0] - 1; x <= c[0] + 1; x++) {
+		if (x < 0 || x >= (int)gridSize[0]) continue;
+		for (int y = c[1] - 1; y <= c[1] + 1; y++) {
+			if (y < 0 || y >= (int)gridSize[1]) continue;
+			for (int z = c[2] - 1; z <= c[2] + 1; z++) {
+				if (z < 0 || z >= (int)gridSize[2]) continue;
+				_cells.push_back((x * gridSize[1] + y) * gridSize[2] + z);
+			}
+		}
+	}
+}
+
+void CellList::getNeighbors(const double * _p, vector<unsigned int> & _points) const {
+	vector<unsigned int> cells;
+	getNeighborCells(_p, cells);
+	for (unsigned int c = 0; c < cells.size(); c++) {
+		for (unsigned int i = firstPoint[cells[c]]; i != size(); i = nextPoint[i]) {
+			_points.push_back(i);
+		}
+	}
+}
+
+void CellList::movePoint(unsigned int _point, const double * _p) {
+	unsigned int newCell = getCell(_p);
+	unsigned int oldCell = pointCell[_point];
+	if (newCell == oldCell) {
+		return;
+	}
+
+	// unlink from the old cell
+	if (firstPoint[oldCell] == _point) {
+		firstPoint[oldCell] = nextPoint[_point];
+	} else {
+		unsigned int i = firstPoint[oldCell];
+		while (nextPoint[i] != _point) {
+			i = nextPoint[i];
+		}
+		nextPoint[i] = nextPoint[_point];
+	}
+
+	// and insert in the new one keeping the increasing order
+	pointCell[_point] = newCell;
+	if (firstPoint[newCell] == size() || firstPoint[newCell] > _point) {
+		nextPoint[_point] = firstPoint[newCell];
+		firstPoint[newCell] = _point;
+	} else {
+		unsigned int i = firstPoint[newCell];
+		while (nextPoint[i] != size() && nextPoint[i] < _point) {
+			i = nextPoint[i];
+		}
+		nextPoint[_point] = nextPoint[i];
+		nextPoint[i] = _point;
+	}
+}
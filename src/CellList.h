@@ -0,0 +1,125 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef CELLLIST_H
+#define CELLLIST_H
+
+#include <vector>
+#include <cmath>
+
+/*******************************************************************
+   Cell list of points (packed x, y, z coordinates): the points are
+   binned in cubic cells at least as large as a given distance, so all
+   the points within that distance of a position are in the 27 cells
+   around it.  The cells are grown (x 1.5) for sparse sets so that the
+   grid stays proportional to the number of points.
+
+   The points of a cell are a linked list (in increasing index order
+   after build()), so a point can be moved to another cell cheaply.
+   Positions outside of the box of the original points are assigned
+   to the border cells, which keeps the 27 cells search complete.
+
+   Usage:
+      CellList grid;
+      grid.build(xyz, cutoff);
+      grid.getNeighborCells(p, cells);
+      for (unsigned int c = 0; c < cells.size(); c++) {
+         for (unsigned int i = grid.getFirstPoint(cells[c]); i != grid.size(); i = grid.getNextPoint(i)) {
+            ...
+         }
+      }
+ *******************************************************************/
+
+namespace MSL { 
+class CellList {
+	public:
+		CellList();
+		CellList(const std::vector<double> & _xyz, double _minCellSize);
+		~CellList();
+
+		void build(const std::vector<double> & _xyz, double _minCellSize);
+		void clear();
+
+		unsigned int size() const; // the number of points, also the end of the cell lists
+		unsigned int getNumberOfCells() const;
+		double getCellSize() const;
+
+		// the cell of a position (clamped to the grid)
+		unsigned int getCell(const double * _p) const;
+		// the cell of a position and the (up to) 26 cells around it
+		void getNeighborCells(const double * _p, std::vector<unsigned int> & _cells) const;
+		// appends the points of the neighbor cells of a position
+		void getNeighbors(const double * _p, std::vector<unsigned int> & _points) const;
+
+		unsigned int getPointCell(unsigned int _point) const;
+		unsigned int getFirstPoint(unsigned int _cell) const; // size() if the cell is empty
+		unsigned int getNextPoint(unsigned int _point) const; // size() at the end of the cell
+
+		// moves a point to the cell of its new position
+		void movePoint(unsigned int _point, const double * _p);
+
+	private:
+		void cellIndices(const double * _p, int * _c) const;
+
+		double boxMin[3];
+		unsigned int gridSize[3];
+		double cellSize;
+
+		std::vector<unsigned int> firstPoint;
+		std::vector<unsigned int> nextPoint;
+		std::vector<unsigned int> pointCell;
+};
+
+inline unsigned int CellList::size() const { return pointCell.size(); }
+inline unsigned int CellList::getNumberOfCells() const { return firstPoint.size(); }
+inline double CellList::getCellSize() const { return cellSize; }
+inline unsigned int CellList::getPointCell(unsigned int _point) const { return pointCell[_point]; }
+inline unsigned int CellList::getFirstPoint(unsigned int _cell) const { return firstPoint[_cell]; }
+inline unsigned int CellList::getNextPoint(unsigned int _point) const { return nextPoint[_point]; }
+inline void CellList::cellIndices(const double * _p, int * _c) const {
+	for (unsigned int k = 0; k < 3; k++) {
+		double c = floor((_p[k] - boxMin[k]) / cellSize);
+		if (c < 0.0) {
+			_c[k] = 0;
+		} else if (c >= (double)gridSize[k]) {
+			_c[k] = gridSize[k] - 1;
+		} else {
+			_c[k] = (int)c;
+		}
+	}
+}
+inline unsigned int CellList::getCell(const double * _p) const {
+	int c[3];
+	cellIndices(_p, c);
+	return (c[0] * gridSize[1] + c[1]) * gridSize[2] + c[2];
+}
+
+}
+
+#endif
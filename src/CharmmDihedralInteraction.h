@@ -116,6 +116,19 @@ inline double CharmmDihedralInteraction::getEnergy() {
 }
 inline double CharmmDihedralInteraction::getEnergy(double _angleRadians,std::vector<double> *_ad) {
 	double energy = 0.0;
+	if (_ad && multipleParams.size() > 1) {
+		// dihedralEner scales _ad in place, so with multiple terms the
+		// angle derivative has to be scaled once by the summed dE/dchi
+		double dEdChi = 0.0;
+		for (unsigned int i=0; i<multipleParams.size(); i++) {
+			energy += CharmmEnergy::instance()->dihedralEner(_angleRadians, multipleParams[i][0], multipleParams[i][1], multipleParams[i][2]);
+			dEdChi -= multipleParams[i][0] * sin(multipleParams[i][1] * _angleRadians - multipleParams[i][2]) * multipleParams[i][1];
+		}
+		for (unsigned int j=0; j<_ad->size(); j++) {
+			(*_ad)[j] *= dEdChi;
+		}
+		return energy;
+	}
 	for (unsigned int i=0; i<multipleParams.size(); i++) {
 		energy += CharmmEnergy::instance()->dihedralEner(_angleRadians, multipleParams[i][0], multipleParams[i][1], multipleParams[i][2],_ad);
 	}
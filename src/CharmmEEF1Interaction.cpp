@@ -59,6 +59,7 @@ void CharmmEEF1Interaction::setup(Atom * _pA1, Atom * _pA2, double _V_i, double
 	pAtoms = vector<Atom*> (2, (Atom*)NULL);
 	setAtoms(*_pA1, *_pA2);	
 	params = vector<double>(8, 0.0);
+	pTable = NULL;
 	setParams(_V_i, _Gfree_i, _Sigw_i, _rmin_i, _V_j, _Gfree_j, _Sigw_j, _rmin_j);
 	useNonBondCutoffs = false;
 	nonBondCutoffOn = 997;
@@ -71,5 +72,14 @@ void CharmmEEF1Interaction::copy(const CharmmEEF1Interaction & _interaction) {
 	useNonBondCutoffs = _interaction.useNonBondCutoffs;
 	nonBondCutoffOn = _interaction.nonBondCutoffOn;
 	nonBondCutoffOff = _interaction.nonBondCutoffOff;
+	pTable = _interaction.pTable;
+}
+
+void CharmmEEF1Interaction::setUseTable(bool _flag, double _spacing) {
+	pTable = NULL;
+	if (_flag) {
+		// NULL on invalid spacing, the exact function is used
+		pTable = CharmmEnergy::instance()->getEEF1Table(params, _spacing);
+	}
 }
 
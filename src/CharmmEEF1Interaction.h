@@ -80,8 +80,15 @@ namespace MSL {
 			double getNonBondCutoffOn() const;
 			double getNonBondCutoffOff() const;
 			std::pair<double,std::vector<double> > partialDerivative();
+
+			// interpolate the energy from a shared table (see CharmmEnergy::EEF1Table), _spacing in Angstroms
+			void setUseTable(bool _flag, double _spacing=0.2);
+			bool getUseTable() const;
+			const CharmmEnergy::EEF1Table * getTable() const;
 		
 		private:
+			double solvationEnergy(double _distance) const;
+
 			void setup(Atom * _a1, Atom * _a2, double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j);
 			void copy(const CharmmEEF1Interaction & _interaction);
 
@@ -92,16 +99,22 @@ namespace MSL {
 			double nonBondCutoffOn;
 			double nonBondCutoffOff;
 
+			const CharmmEnergy::EEF1Table * pTable;
+
 	};
 
-	inline void CharmmEEF1Interaction::setParams(std::vector<double> _params) { if (_params.size() != 8) {std::cerr << "ERROR 91235: invalid number of parameters in inline void CharmmEEF1Interaction::setParams(std::vector<double> _params)" << std::endl; exit(91235);} params = _params;}
-	inline void CharmmEEF1Interaction::setParams(double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j) {params[0] = _V_i; params[1] = _Gfree_i; params[2] = _Sigw_i; params[3] = _rmin_i; params[4] = _V_j; params[5] = _Gfree_j; params[6] = _Sigw_j; params[7] = _rmin_j;}
+	inline void CharmmEEF1Interaction::setParams(std::vector<double> _params) { if (_params.size() != 8) {std::cerr << "ERROR 91235: invalid number of parameters in inline void CharmmEEF1Interaction::setParams(std::vector<double> _params)" << std::endl; exit(91235);} params = _params; if (pTable != NULL) {setUseTable(true, pTable->spacing);}}
+	inline void CharmmEEF1Interaction::setParams(double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j) {params[0] = _V_i; params[1] = _Gfree_i; params[2] = _Sigw_i; params[3] = _rmin_i; params[4] = _V_j; params[5] = _Gfree_j; params[6] = _Sigw_j; params[7] = _rmin_j; if (pTable != NULL) {setUseTable(true, pTable->spacing);}}
 	inline std::vector<double> CharmmEEF1Interaction::getParams() const {return params;};
 	inline double CharmmEEF1Interaction::getEnergy() {
 		double distance = 0.0;
 		if (useNonBondCutoffs) {
-			// with cutoffs
-		        return getEnergy(pAtoms[0]->distance(*pAtoms[1]), pAtoms[0]->groupDistance(*pAtoms[1]));
+			// with cutoffs, skip the atom distance if the groups are out of cutofnb
+			double groupDistance = pAtoms[0]->groupDistance(*pAtoms[1]);
+			if (groupDistance > nonBondCutoffOff) {
+				return 0.0;
+			}
+		        return getEnergy(pAtoms[0]->distance(*pAtoms[1]), groupDistance);
 		} else {
 			// no cutoffs
 			distance = pAtoms[0]->distance(*pAtoms[1]);
@@ -121,7 +134,7 @@ namespace MSL {
 			_dd->resize(pAtoms.size() * 2,0.0);
 		}
 		// if cutoffs are in force, this function is not the one to call - use CharmmEEF1Interaction::getEnergy(double _distance, double _groupDistance)
-		return CharmmEnergy::instance()->EEF1Ener(_distance, params[0], params[1], params[2], params[3], params[4], params[5], params[6], params[7]); 
+		return solvationEnergy(_distance);
 	}
 	inline double CharmmEEF1Interaction::getEnergy(double _distance, double _groupDistance) {
 		// called if there are cutoffs
@@ -134,7 +147,13 @@ namespace MSL {
 			// between the geometric centers of the atom groups that the two atoms belong to
 			factor = CharmmEnergy::instance()->switchingFunction(_groupDistance, nonBondCutoffOn, nonBondCutoffOff);
 		}
-		return CharmmEnergy::instance()->EEF1Ener(_distance, params[0], params[1], params[2], params[3], params[4], params[5], params[6], params[7]) * factor;
+		return solvationEnergy(_distance) * factor;
+	}
+	inline double CharmmEEF1Interaction::solvationEnergy(double _distance) const {
+		if (pTable != NULL) {
+			return CharmmEnergy::instance()->EEF1EnerTable(*pTable, _distance);
+		}
+		return CharmmEnergy::instance()->EEF1Ener(_distance, params[0], params[1], params[2], params[3], params[4], params[5], params[6], params[7]);
 	}
 	inline std::vector<double> CharmmEEF1Interaction::getEnergyGrad(){
 		std::cerr << "WARNING 12234:  CharmmEEF1Interaction::getEnergyGrad() is not implemented to get the gradient" << std::endl;
@@ -152,6 +171,8 @@ namespace MSL {
 	inline bool CharmmEEF1Interaction::getUseNonBondCutoffs() const {return useNonBondCutoffs;}
 	inline double CharmmEEF1Interaction::getNonBondCutoffOn() const {return nonBondCutoffOn;}
 	inline double CharmmEEF1Interaction::getNonBondCutoffOff() const {return nonBondCutoffOff;}
+	inline bool CharmmEEF1Interaction::getUseTable() const {return pTable != NULL;}
+	inline const CharmmEnergy::EEF1Table * CharmmEEF1Interaction::getTable() const {return pTable;}
 
 	inline std::pair<double,std::vector<double> > CharmmEEF1Interaction::partialDerivative() {
 		std::pair<double, std::vector<double> > partials;
@@ -48,6 +48,13 @@ CharmmEnergy::CharmmEnergy() {
 
 }
 
+CharmmEnergy::~CharmmEnergy() {
+	for (map<vector<double>, EEF1Table*>::iterator k=eef1Tables.begin(); k!=eef1Tables.end(); k++) {
+		delete k->second;
+	}
+	eef1Tables.clear();
+}
+
 CharmmEnergy::CharmmEnergy(const CharmmEnergy & _instance) {
 }
 
@@ -332,11 +339,13 @@ double CharmmEnergy::EEF1Ener(double _d, double _V_i, double _Gfree_i, double _S
 	double fV_j = 0.0;
 	
 	if (_Sigw_i != 0.0 && _Gfree_i != 0.0 && _V_j != 0.0) {
-		double x2_i = -pow((_d - _rmin_i) / _Sigw_i, 2.0);
+		double x_i = (_d - _rmin_i) / _Sigw_i;
+		double x2_i = -x_i * x_i;
 		fV_i = eef1_constant * _Gfree_i * exp(x2_i) * _V_j / (_Sigw_i * d2);
 	}
 	if (_Sigw_j != 0.0 && _Gfree_j != 0.0 && _V_i != 0.0) {
-		double x2_j = -pow((_d - _rmin_j) / _Sigw_j, 2.0);
+		double x_j = (_d - _rmin_j) / _Sigw_j;
+		double x2_j = -x_j * x_j;
 		fV_j = eef1_constant * _Gfree_j * exp(x2_j) * _V_i / (_Sigw_j * d2);
 	}
 	return -fV_i - fV_j;
@@ -406,6 +415,113 @@ double CharmmEnergy::LJSwitched(double _d, double _Rmin, double _Emin,double _gr
 	}
 	return energy;
 }
+const CharmmEnergy::EEF1Table * CharmmEnergy::getEEF1Table(const vector<double> & _params, double _spacing) {
+	if (_params.size() != 8 || _spacing <= 0.0) {
+		cerr << "ERROR 91236: invalid parameters or table spacing " << _spacing << " in const CharmmEnergy::EEF1Table * CharmmEnergy::getEEF1Table(const vector<double> & _params, double _spacing)" << endl;
+		return NULL;
+	}
+	vector<double> key = _params;
+	key.push_back(_spacing);
+	EEF1Table * pTable = NULL;
+#ifdef __OPENMP__
+	#pragma omp critical(CharmmEnergyEEF1Tables)
+#endif
+	{
+		map<vector<double>, EEF1Table*>::iterator found = eef1Tables.find(key);
+		if (found != eef1Tables.end()) {
+			pTable = found->second;
+		} else {
+			pTable = new EEF1Table;
+			buildEEF1Table(*pTable, _params, _spacing);
+			eef1Tables[key] = pTable;
+		}
+	}
+	return pTable;
+}
+
+void CharmmEnergy::buildEEF1Table(EEF1Table & _table, const vector<double> & _params, double _spacing) const {
+	/******************************************************
+	 *  d^2 * E(d) = - a_i exp(-x_i^2) - a_j exp(-x_j^2)
+	 *
+	 *  with a_i = eef1_constant * Gfree_i * V_j / Sigw_i
+	 *  and x_i = (d - rmin_i) / Sigw_i, as in EEF1Ener
+	 ******************************************************/
+	_table.params = _params;
+	_table.spacing = _spacing;
+	_table.invSpacing = 1.0 / _spacing;
+	_table.maxDistance = 0.0;
+	_table.maxError = 0.0;
+	_table.knots.clear();
+
+	double a[2];
+	double rmin[2];
+	double sigw[2];
+	unsigned int nTerms = 0;
+	double range = 0.0;
+	for (unsigned int i=0; i<2; i++) {
+		const double * p = &_params[4 * i];
+		const double * q = &_params[4 * (1 - i)];
+		if (p[2] != 0.0 && p[1] != 0.0 && q[0] != 0.0) {
+			a[nTerms] = eef1_constant * p[1] * q[0] / p[2];
+			rmin[nTerms] = p[3];
+			sigw[nTerms] = p[2];
+			double end = p[3] + 6.0 * fabs(p[2]);
+			if (end > range) {
+				range = end;
+			}
+			nTerms++;
+		}
+	}
+	if (nTerms == 0 || range <= 0.0) {
+		// no active term, the energy is always zero
+		return;
+	}
+
+	// one knot past maxDistance keeps the last interval in the table
+	unsigned int n = (unsigned int)ceil(range / _spacing) + 2;
+	_table.maxDistance = (n - 2) * _spacing;
+	_table.knots.resize(2 * n);
+	for (unsigned int k=0; k<n; k++) {
+		double d = k * _spacing;
+		double g = 0.0;
+		double dg = 0.0;
+		for (unsigned int i=0; i<nTerms; i++) {
+			double x = (d - rmin[i]) / sigw[i];
+			double f = a[i] * exp(-x * x);
+			g -= f;
+			dg += 2.0 * x * f / sigw[i];
+		}
+		_table.knots[2 * k] = g;
+		_table.knots[2 * k + 1] = dg * _spacing;
+	}
+
+	// measure the interpolation error at the interval midpoints
+	double peak = 0.0;
+	double maxDiff = 0.0;
+	for (unsigned int k=0; k<n-1; k++) {
+		double d = (k + 0.5) * _spacing;
+		double g = 0.0;
+		for (unsigned int i=0; i<nTerms; i++) {
+			double x = (d - rmin[i]) / sigw[i];
+			g -= a[i] * exp(-x * x);
+		}
+		const double * knot = &_table.knots[2 * k];
+		double interpolated = 0.5 * (knot[0] + knot[2]) + 0.125 * (knot[1] - knot[3]);
+		if (fabs(g) > peak) {
+			peak = fabs(g);
+		}
+		if (fabs(knot[0]) > peak) {
+			peak = fabs(knot[0]);
+		}
+		if (fabs(interpolated - g) > maxDiff) {
+			maxDiff = fabs(interpolated - g);
+		}
+	}
+	if (peak > 0.0) {
+		_table.maxError = maxDiff / peak;
+	}
+}
+
 double CharmmEnergy::IMM1ZtransFunction(double _Z, double _halfThickness, double _exponent) {
 	/*************************************
 	 *  Zrel = Z / (thickness / 2
@@ -33,6 +33,7 @@ You should have received a copy of the GNU Lesser General Public
 
 #include <iostream>
 #include <vector>
+#include <map>
 #include <math.h>
 
 
@@ -68,6 +69,35 @@ class CharmmEnergy {
 
 		double EEF1Ener(double _d, double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j) const;
 		double IMM1ZtransFunction(double _Z, double _halfThickness, double _exponent);
+
+		/******************************************************
+		 *  Tabulated EEF1 kernel.  The numerator d^2 * E(d)
+		 *  is a sum of two gaussians, smooth down to d = 0, so
+		 *  it is stored at regular knots with its derivative
+		 *  and interpolated with a cubic Hermite spline.  The
+		 *  spacing controls the accuracy: maxError is the
+		 *  largest error found at the interval midpoints,
+		 *  relative to the peak of |d^2 * E|.  Past maxDistance
+		 *  both gaussians are below exp(-36) of their peak and
+		 *  the energy is taken as zero.
+		 *
+		 *  Tables are shared by all pairs with the same
+		 *  parameters, owned by the CharmmEnergy instance and
+		 *  never freed while it lives
+		 ******************************************************/
+		struct EEF1Table {
+			std::vector<double> params; // V_i, Gfree_i, Sigw_i, rmin_i, V_j, Gfree_j, Sigw_j, rmin_j
+			double spacing;
+			double invSpacing;
+			double maxDistance;
+			double maxError;
+			std::vector<double> knots; // d^2 * E and its derivative times the spacing, interleaved
+		};
+		const EEF1Table * getEEF1Table(const std::vector<double> & _params, double _spacing);
+		unsigned int getNumberOfEEF1Tables() const;
+		double EEF1EnerTable(const EEF1Table & _table, double _d) const;
+		// same as IMM1ZtransFunction, with an integer power when the exponent is a small integer
+		double IMM1ZtransFunctionFast(double _Z, double _halfThickness, double _exponent);
 		// For ureyBradley and Angle -- Call spring with angle in Radians and appropriate prameters
 		
 		// parameter settings
@@ -92,6 +122,7 @@ class CharmmEnergy {
 	protected:
 		// disallow instantiation
 		CharmmEnergy();
+		~CharmmEnergy();
 		// disallow copy
 		CharmmEnergy(const CharmmEnergy & _instance);
 		void operator =(const CharmmEnergy & _instance);
@@ -100,6 +131,8 @@ class CharmmEnergy {
 //		double dielectricConstant;
 //		bool useRdielectric;
 
+		void buildEEF1Table(EEF1Table & _table, const std::vector<double> & _params, double _spacing) const;
+		std::map<std::vector<double>, EEF1Table*> eef1Tables; // keyed by the 8 parameters plus the spacing
 
 
 };
@@ -116,6 +149,37 @@ class CharmmEnergy {
 
 	return _Kd * (diff*diff);
 }
+inline unsigned int CharmmEnergy::getNumberOfEEF1Tables() const {return eef1Tables.size();}
+inline double CharmmEnergy::EEF1EnerTable(const EEF1Table & _table, double _d) const {
+	if (_d == 0 || _d >= _table.maxDistance) {
+		// overlapping atoms or beyond the gaussians, zero energy
+		return 0.0;
+	}
+	double x = _d * _table.invSpacing;
+	unsigned int i = (unsigned int)x;
+	double t = x - i;
+	double t1 = 1.0 - t;
+	const double * k = &_table.knots[2 * i];
+	// Hermite basis: (1+2t)(1-t)^2, t(1-t)^2, t^2(3-2t), -t^2(1-t)
+	double g = t1 * t1 * ((1.0 + 2.0 * t) * k[0] + t * k[1]) + t * t * ((3.0 - 2.0 * t) * k[2] - t1 * k[3]);
+	return g / (_d * _d);
+}
+inline double CharmmEnergy::IMM1ZtransFunctionFast(double _Z, double _halfThickness, double _exponent) {
+	int n = (int)_exponent;
+	if (n != _exponent || n < 1 || n > 64) {
+		return IMM1ZtransFunction(_Z, _halfThickness, _exponent);
+	}
+	double zRel = fabs(_Z / _halfThickness);
+	double z_n = 1.0;
+	while (n) {
+		if (n & 1) {
+			z_n *= zRel;
+		}
+		zRel *= zRel;
+		n >>= 1;
+	}
+	return z_n / (1 + z_n);
+}
 //inline void CharmmEnergy::setElec14factor(double _e14) {elec14factor = _e14;}
 //inline double CharmmEnergy::getElec14factor() const {return elec14factor;}
 //inline void CharmmEnergy::setDielectricConstant(double _diel) {dielectricConstant = _diel;}
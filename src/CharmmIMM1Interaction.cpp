@@ -72,6 +72,7 @@ void CharmmIMM1Interaction::setup( Atom* _pA1, Atom* _pA2) {
 	pAtoms = vector<Atom*> (2, (Atom*)NULL);
 	setAtoms(*_pA1, *_pA2);	
 	params = vector<double>(2, 0.0);
+	useTables = false;
 	pEEFW = new CharmmEEF1Interaction;
 	pEEFW->setAtoms(*_pA1, *_pA2);	
 	pEEFC = new CharmmEEF1Interaction;
@@ -82,6 +83,7 @@ void CharmmIMM1Interaction::setup( Atom* _pA1, Atom* _pA2) {
 void CharmmIMM1Interaction::copy(const CharmmIMM1Interaction & _interaction) {
 	pAtoms = _interaction.pAtoms;
 	params = _interaction.params;
+	useTables = _interaction.useTables;
 	pEEFW = new CharmmEEF1Interaction(*(_interaction.pEEFW));
 	pEEFC = new CharmmEEF1Interaction(*(_interaction.pEEFC));
 }
@@ -74,6 +74,10 @@ namespace MSL {
 			std::vector<double> getEnergyGrad();
 			std::pair<double,std::vector<double> > partialDerivative();
 
+			// tabulated EEF1 terms (see CharmmEEF1Interaction::setUseTable) and an integer power membrane transfer function
+			void setUseTables(bool _flag, double _spacing=0.2);
+			bool getUseTables() const;
+
 		
 		private:
 			void copy(const CharmmIMM1Interaction & _interaction);
@@ -84,6 +88,7 @@ namespace MSL {
 			static const std::string typeName;
 			CharmmEEF1Interaction* pEEFW;
 			CharmmEEF1Interaction* pEEFC;
+			bool useTables;
 			
 
 	};
@@ -91,8 +96,18 @@ namespace MSL {
 	inline void CharmmIMM1Interaction::setParams(std::vector<double>& _imm1W, std::vector<double>& _imm1C,double _halfThickness, double _exponent)  {params[0] = _halfThickness; params[1] = _exponent; pEEFW->setParams(_imm1W); pEEFC->setParams(_imm1C);}
 	inline double CharmmIMM1Interaction::getEnergy() {
 		if(pEEFW) {
-			double fz = CharmmEnergy::instance()->IMM1ZtransFunction(pAtoms[0]->getZ(),params[0],params[1]);
-			return (fz * pEEFW->getEnergy() + (1-fz) * pEEFC->getEnergy());
+			double fz = useTables ? CharmmEnergy::instance()->IMM1ZtransFunctionFast(pAtoms[0]->getZ(),params[0],params[1]) : CharmmEnergy::instance()->IMM1ZtransFunction(pAtoms[0]->getZ(),params[0],params[1]);
+			// both terms share the atoms and the cutoffs, compute the distances once
+			if (pEEFW->getUseNonBondCutoffs()) {
+				double groupDistance = pAtoms[0]->groupDistance(*pAtoms[1]);
+				if (groupDistance > pEEFW->getNonBondCutoffOff()) {
+					return 0.0;
+				}
+				double distance = pAtoms[0]->distance(*pAtoms[1]);
+				return (fz * pEEFW->getEnergy(distance, groupDistance) + (1-fz) * pEEFC->getEnergy(distance, groupDistance));
+			}
+			double distance = pAtoms[0]->distance(*pAtoms[1]);
+			return (fz * pEEFW->getEnergy(distance) + (1-fz) * pEEFC->getEnergy(distance));
 		} else {
 			std::cerr << "ERROR 12345: CharmmIMM1Interaction::getEnergy() is called without setting up the EEF1 interactions" << std::endl;
 			return 0;
@@ -126,6 +141,14 @@ namespace MSL {
 			pEEFC->setUseNonBondCutoffs(_flag,_ctonnb,_ctofnb);
 		}
 	}
+	inline void CharmmIMM1Interaction::setUseTables(bool _flag, double _spacing) {
+		useTables = _flag;
+		if(pEEFW && pEEFC) {
+			pEEFW->setUseTable(_flag, _spacing);
+			pEEFC->setUseTable(_flag, _spacing);
+		}
+	}
+	inline bool CharmmIMM1Interaction::getUseTables() const {return useTables;}
 	inline std::pair<double,std::vector<double> > CharmmIMM1Interaction::partialDerivative() {
 		std::pair<double, std::vector<double> > partials;
 		partials.first = CartesianGeometry::distanceDerivative(pAtoms[0]->getCoor(),pAtoms[1]->getCoor(),&(partials.second));
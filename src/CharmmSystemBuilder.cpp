@@ -88,7 +88,10 @@ void CharmmSystemBuilder::setup() {
 	useGroupCutoffs = true;
 	halfThickness = 15;
 	exponent = 10;
+	useSolvationTables = false;
+	solvationTableSpacing = 0.2;
 	solvent = pEEF1ParReader->getDefaultSolvent();
+	pSymmetry = NULL;
 }
 
 void CharmmSystemBuilder::copy(const CharmmSystemBuilder & _sysBuild) {
@@ -102,6 +105,9 @@ void CharmmSystemBuilder::copy(const CharmmSystemBuilder & _sysBuild) {
 	dielectricConstant = _sysBuild.dielectricConstant;
 	useRdielectric = _sysBuild.useRdielectric;
 	termsToBuild = _sysBuild.termsToBuild;
+	useSolvationTables = _sysBuild.useSolvationTables;
+	solvationTableSpacing = _sysBuild.solvationTableSpacing;
+	pSymmetry = _sysBuild.pSymmetry;
 }
 
 void CharmmSystemBuilder::deletePointers() {
@@ -1653,6 +1659,31 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 	ESet->eraseTerm("CHARMM_IMM1REF");
 	AtomPointerVector atoms = pSystem->getAllAtomPointers();
 
+	/********************************************************************************
+	 *  Symmetric energy mode (see setSymmetry): the images of all atoms under
+	 *  the unique operators are appended after the atoms of the asymmetric unit.
+	 *  Only the atoms of the unit are used as the first atom of a pair, the
+	 *  second can be an atom of the unit or an image.  The bonded checks and
+	 *  the alternative identities of an image are those of its source atom,
+	 *  an image is never bonded to the unit.
+	 ********************************************************************************/
+	unsigned int nUnit = atoms.size();
+	vector<unsigned int> imageSource;
+	vector<unsigned int> imageOperator;
+	vector<double> imageWeight;
+	if (pSymmetry != NULL && pSymmetry->isSet()) {
+		pSymmetry->clearImages(); // the old interactions have been erased above
+		for (unsigned int n = 0; n < pSymmetry->getNumberOfUniqueOperators(); n++) {
+			unsigned int op = pSymmetry->getUniqueOperator(n);
+			for (unsigned int i = 0; i < nUnit; i++) {
+				atoms.push_back(pSymmetry->getImage(op, atoms[i]));
+				imageSource.push_back(i);
+				imageOperator.push_back(op);
+				imageWeight.push_back(pSymmetry->getUniqueOperatorWeight(n));
+			}
+		}
+	}
+
 	bool useSolvation_local = useSolvation;
 	if (!pEEF1ParReader->solventExists(solvent)) {
 		useSolvation_local = false;
@@ -1668,9 +1699,12 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 	vector<bool> fixed;
 	if (_ignoreNonVariable) {
 		fixed.resize(atoms.size(), true);
-		for (int i = 0; i < atoms.size(); i++) {
+		for (int i = 0; i < nUnit; i++) {
 			if (atoms[i]->getParentPosition()->getTotalNumberOfRotamers() > 1) fixed[i] = false;
 		}
+		for (int i = nUnit; i < atoms.size(); i++) {
+			fixed[i] = fixed[imageSource[i - nUnit]];
+		}
 	}
 
 	/**********************************************************************
@@ -1729,7 +1763,7 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 	 *                            0             2                3             vdw 0
 	 *    void setParams(double _V_i, double _Gfree_i, double _Sigw_i, double _rmin_i, double _V_j, double _Gfree_j, double _Sigw_j, double _rmin_j);
 	 **********************************************************************************/
-	for(AtomPointerVector::iterator atomI = atoms.begin(); atomI < atoms.end(); atomI++) {
+	for(AtomPointerVector::iterator atomI = atoms.begin(); atomI < atoms.begin() + nUnit; atomI++) {
 		int ai = atomI - atoms.begin();
 		if (_cutnb > 0.0 && !(*atomI)->hasCoor()) {
 			// no coordinates, skip this atom
@@ -1769,7 +1803,16 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 		
 		for(AtomPointerVector::iterator atomJ = atomI+1; atomJ < atoms.end() ; atomJ++) {
 			int aj = atomJ - atoms.begin();
-			if ((*atomI)->isInAlternativeIdentity(*atomJ)) {
+			// for an image, the source atom and the operator that creates it
+			Atom * sourceJ = NULL;
+			unsigned int opJ = 0;
+			double weightJ = 1.0;
+			if (aj >= nUnit) {
+				sourceJ = atoms[imageSource[aj - nUnit]];
+				opJ = imageOperator[aj - nUnit];
+				weightJ = imageWeight[aj - nUnit];
+			}
+			if ((*atomI)->isInAlternativeIdentity(sourceJ == NULL ? *atomJ : sourceJ)) {
 				continue;
 			}
 			if (_ignoreNonVariable && fixed[ai] && fixed[aj]) continue;
@@ -1806,7 +1849,10 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 							} else {
 								pCSI->setUseNonBondCutoffs(false, 0.0, 0.0);
 							}
-							ESet->addInteraction(pCSI);
+							if (useSolvationTables) {
+								pCSI->setUseTable(true, solvationTableSpacing);
+							}
+							ESet->addInteraction(sourceJ == NULL ? (Interaction*)pCSI : new SymmetricInteraction(pCSI, **atomI, *sourceJ, *pSymmetry, opJ, weightJ, _cutnb > 0.0));
 						}
 					} else {
 						cerr << "WARNING 49387: EEF1 parameters not found for type " << atomJtype << ", solvent " << solvent << " in bool CharmmSystemBuilder::updateSolvation(System & _system, string _solvent, double _ctonnb, double _ctofnb, double _cutnb)" << endl;
@@ -1841,7 +1887,10 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 							} else {
 								pCIMM1->setUseNonBondCutoffs(false, 0.0, 0.0);
 							}
-							ESet->addInteraction(pCIMM1);
+							if (useSolvationTables) {
+								pCIMM1->setUseTables(true, solvationTableSpacing);
+							}
+							ESet->addInteraction(sourceJ == NULL ? (Interaction*)pCIMM1 : new SymmetricInteraction(pCIMM1, **atomI, *sourceJ, *pSymmetry, opJ, weightJ, _cutnb > 0.0));
 						}
 					}
 				}
@@ -1860,7 +1909,7 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 						} else {
 							pCEI->setUseNonBondCutoffs(false, 0.0, 0.0);
 						}
-						ESet->addInteraction(pCEI);
+						ESet->addInteraction(sourceJ == NULL ? (Interaction*)pCEI : new SymmetricInteraction(pCEI, **atomI, *sourceJ, *pSymmetry, opJ, weightJ, _cutnb > 0.0));
 					}
 					if (foundVdw && foundVdw2) {
 						if (termsToBuild["CHARMM_VDW"]) {
@@ -1872,7 +1921,7 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 							} else {
 								pCVI->setUseNonBondCutoffs(false, 0.0, 0.0);
 							}
-							ESet->addInteraction(pCVI);
+							ESet->addInteraction(sourceJ == NULL ? (Interaction*)pCVI : new SymmetricInteraction(pCVI, **atomI, *sourceJ, *pSymmetry, opJ, weightJ, _cutnb > 0.0));
 						}
 						
 
@@ -1890,7 +1939,7 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 					} else {
 						pCEI->setUseNonBondCutoffs(false, 0.0, 0.0);
 					}
-					ESet->addInteraction(pCEI);
+					ESet->addInteraction(sourceJ == NULL ? (Interaction*)pCEI : new SymmetricInteraction(pCEI, **atomI, *sourceJ, *pSymmetry, opJ, weightJ, _cutnb > 0.0));
 				}
 				if (foundVdw && foundVdw2) {
 					if (termsToBuild["CHARMM_VDW"]) {
@@ -1902,7 +1951,7 @@ bool CharmmSystemBuilder::updateNonBonded(double _ctonnb, double _ctofnb, double
 						} else {
 							pCVI->setUseNonBondCutoffs(false, 0.0, 0.0);
 						}
-						ESet->addInteraction(pCVI);
+						ESet->addInteraction(sourceJ == NULL ? (Interaction*)pCVI : new SymmetricInteraction(pCVI, **atomI, *sourceJ, *pSymmetry, opJ, weightJ, _cutnb > 0.0));
 					}
 				}
 			}
@@ -53,6 +53,8 @@ You should have received a copy of the GNU Lesser General Public
 #include "CharmmEEF1Interaction.h"
 #include "CharmmEEF1RefInteraction.h"
 #include "RandomNumberGenerator.h"
+#include "Symmetry.h"
+#include "SymmetricInteraction.h"
 
 
 namespace MSL { 
@@ -140,8 +142,36 @@ class CharmmSystemBuilder {
 		void setUseGroupCutoffs(bool _flag);
 		bool getUseGroupCutoffs() const;
 
+		// interpolate the EEF1/IMM1 solvation terms from tables with knots every _spacing
+		// Angstroms (see CharmmEnergy::EEF1Table), applied when updateNonBonded builds them
+		void setUseSolvationTables(bool _flag, double _spacing=0.2);
+		bool getUseSolvationTables() const;
+		double getSolvationTableSpacing() const;
+
 		bool fail() const; // return false if reading toppar failed
 
+		/********************************************************************
+		 *  Symmetric energy mode: if a Symmetry with its operators set
+		 *  (setCN/setDN) is given, the System is treated as the asymmetric
+		 *  unit of the oligomer.  updateNonBonded adds, next to the normal
+		 *  non-bonded terms, the interactions between the unit and the
+		 *  images of its atoms under the unique operators (as
+		 *  SymmetricInteraction, weighted by their multiplicity), so that
+		 *  the energy of the EnergySet is the energy of the oligomer
+		 *  divided by Symmetry::getNumberOfCopies().  The copies are never
+		 *  built; use Symmetry::applySymmetry to write out the oligomer.
+		 *
+		 *     Symmetry sym;
+		 *     sym.setCN(3);
+		 *     CSB.setSymmetry(&sym);
+		 *     CSB.buildSystem(seq); // or updateNonBonded after building
+		 *
+		 *  The Symmetry must outlive the interactions (the images belong
+		 *  to it).  Set it to NULL to go back to the normal mode.
+		 ********************************************************************/
+		void setSymmetry(Symmetry * _pSymmetry);
+		Symmetry * getSymmetry() const;
+
 
 		/********************************************************************
 		 *
@@ -204,9 +234,13 @@ class CharmmSystemBuilder {
 		std::string solvent;
 		double halfThickness;
 		double exponent;
+		bool useSolvationTables;
+		double solvationTableSpacing;
 
 		bool fail_flag;
 
+		Symmetry * pSymmetry;
+
 };
 inline void CharmmSystemBuilder::setSystem(System & _system) {
 	reset();
@@ -284,7 +318,12 @@ inline void CharmmSystemBuilder::setUseRdielectric(bool _flag) {useRdielectric =
 inline bool CharmmSystemBuilder::getUseRdielectric() const {return useRdielectric;}
 inline void CharmmSystemBuilder::setUseGroupCutoffs(bool _flag) { useGroupCutoffs = _flag;}
 inline bool CharmmSystemBuilder::getUseGroupCutoffs() const { return useGroupCutoffs; }
+inline void CharmmSystemBuilder::setUseSolvationTables(bool _flag, double _spacing) {useSolvationTables = _flag; solvationTableSpacing = _spacing;}
+inline bool CharmmSystemBuilder::getUseSolvationTables() const {return useSolvationTables;}
+inline double CharmmSystemBuilder::getSolvationTableSpacing() const {return solvationTableSpacing;}
 inline bool CharmmSystemBuilder::fail() const { return fail_flag;}
+inline void CharmmSystemBuilder::setSymmetry(Symmetry * _pSymmetry) {pSymmetry = _pSymmetry;}
+inline Symmetry * CharmmSystemBuilder::getSymmetry() const {return pSymmetry;}
 inline void CharmmSystemBuilder::setSolvent(std::string _solvent) {solvent = _solvent;}
 inline void CharmmSystemBuilder::setIMM1Params(double _halfThickness, double _exponent) {halfThickness = _halfThickness; exponent = _exponent;}
 
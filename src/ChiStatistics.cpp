@@ -39,6 +39,7 @@ ChiStatistics::ChiStatistics(){
 }
 
 bool ChiStatistics::read(string _dofFile){
+	chiAtoms.clear();
 	return dofReader.read(_dofFile);
 }
 
@@ -56,10 +57,11 @@ void ChiStatistics::operator=(const ChiStatistics &_chiStat){
 void ChiStatistics::copy(const ChiStatistics &_chiStat){
 	// Emtpy for now..
 	dofReader = _chiStat.dofReader;
+	chiAtoms = _chiStat.chiAtoms;
 }
 
 int ChiStatistics::getNumberChis(Residue &_n){
-	vector< vector<string> > chis = dofReader.getChiAtoms(_n.getResidueName());
+	const vector< vector<string> > & chis = getChiAtoms(_n.getResidueName());
 	return chis.size();
 }
 
@@ -68,12 +70,12 @@ bool ChiStatistics::atomsExist(Residue &_n, int _chiNumber){
 	// Change from 1 based chi numbering to zero based..
 	_chiNumber -= 1;
 
-	vector< vector<string> > chis = dofReader.getChiAtoms(_n.getResidueName());
+	const vector< vector<string> > & chis = getChiAtoms(_n.getResidueName());
 	if  (chis.size() < 1){
 		cerr << "ERROR 4232 residue "<<_n.getResidueName()<<" is not found in chi table in ChiStatistics."<<endl;
 		return false;
 	}
-	if (chis.size() < _chiNumber){
+	if (chis.size() <= _chiNumber){
 		cerr << "ERROR 4233 residue "<<_n.getResidueName()<<" does not have chi"<<_chiNumber << " in chi table in ChiStatistics."<<endl;
 		return false;
 	}
@@ -97,7 +99,7 @@ double ChiStatistics::getChi(Residue &_n, int _chiNumber,bool _angleInRadians){
 	// Change from 1 based chi numbering to zero based..
 	_chiNumber -= 1;
 
-	vector< vector<string> > chis = dofReader.getChiAtoms(_n.getResidueName());
+	const vector< vector<string> > & chis = getChiAtoms(_n.getResidueName());
 		
 	if (_angleInRadians) {
 		return _n(chis[_chiNumber][0]).dihedralRadians(_n(chis[_chiNumber][1]), _n(chis[_chiNumber][2]),_n(chis[_chiNumber][3]));
@@ -110,6 +112,7 @@ double ChiStatistics::getChi(Residue &_n, int _chiNumber,bool _angleInRadians){
 vector<double> ChiStatistics::getChis(Residue &_n,bool _angleInRadians) {
 	int nChis = getNumberChis(_n);
 	vector<double> chis;
+	chis.reserve(nChis);
 	for(unsigned i = 1 ; i <= nChis; i++) {
 		chis.push_back(getChi(_n,i,_angleInRadians));
 	}
@@ -36,6 +36,7 @@ You should have received a copy of the GNU Lesser General Public
 #include "SysEnv.h"
 
 // STL Includes
+#include <map>
 
 namespace MSL { 
 class ChiStatistics {
@@ -72,14 +73,26 @@ class ChiStatistics {
 	private:
 		
 		void copy(const ChiStatistics &_phiPsiStat);
+		const std::vector<std::vector<std::string> > & getChiAtoms(const std::string & _resName);
 		DegreeOfFreedomReader dofReader;
 
+		// chi atom names by residue name, looked up once per residue type
+		std::map<std::string, std::vector<std::vector<std::string> > > chiAtoms;
+
 		/*
 		double getChiBin(double _angle);
 		std::map<std::string,std::vector<int> >  chiTable;
 		*/
 
 };
+
+inline const std::vector<std::vector<std::string> > & ChiStatistics::getChiAtoms(const std::string & _resName) {
+	std::map<std::string, std::vector<std::vector<std::string> > >::iterator found = chiAtoms.find(_resName);
+	if (found == chiAtoms.end()) {
+		found = chiAtoms.insert(std::pair<std::string, std::vector<std::vector<std::string> > >(_resName, dofReader.getChiAtoms(_resName))).first;
+	}
+	return found->second;
+}
 }
 
 #endif
@@ -21,25 +21,80 @@ You should have received a copy of the GNU Lesser General Public
 */
 
 
+
 #include "CoiledCoilFitter.h"
 
 using namespace MSL;
 
 #include "MslTools.h"
 #include "CoiledCoils.h"
-#include "Timer.h"
+#include "LBFGSMinimizer.h"
+#include "OptimalRMSDCalculator.h"
+
+
+// fixed parameters of the model
+static const double fixedRisePerRes = 1.51;
+static const double fixedR1 = 2.26;
+static const double fixedW1 = 102.8;
+
+// the variables of the LBFGS are r0, pitch/10 and phi1/10 so that they have similar effects on the deviation
+static const double variableScale[3] = {1.0, 10.0, 10.0};
+
+/*******************************************************************
+ *  L-BFGS over the (scaled) parameters of the fitter instead of
+ *  the Cartesian coordinates
+ *******************************************************************/
+class CoiledCoilFitter::ParameterMinimizer : public LBFGSMinimizer {
+	public:
+		ParameterMinimizer(CoiledCoilFitter & _fitter, const vector<double> & _start) : fitter(_fitter), start(_start), failed(false) {}
+		const vector<double> & getVariables() const { return current; }
+		bool getFailed() const { return failed; } // the deviation could not be computed at some point
+	protected:
+		bool setupVariables(vector<double> & _x) {
+			_x = start;
+			current = start;
+			return true;
+		}
+		void setVariables(const vector<double> & _x) {
+			current = _x;
+		}
+		double energyAndGradient(const vector<double> & _x, vector<double> & _g) {
+			vector<double> parameters(_x.size());
+			for (unsigned int i = 0; i < _x.size(); i++) {
+				parameters[i] = _x[i] * variableScale[i];
+			}
+			bool suc = false;
+			double msd = fitter.deviation(parameters, &_g, &suc);
+			if (!suc) {
+				failed = true;
+			}
+			for (unsigned int i = 0; i < _g.size(); i++) {
+				_g[i] *= variableScale[i];
+			}
+			return msd;
+		}
+	private:
+		CoiledCoilFitter & fitter;
+		vector<double> start;
+		vector<double> current;
+		bool failed;
+};
 
 CoiledCoilFitter::CoiledCoilFitter(){	
 
   numHelices_ = 0;
   numResidues_ = 0;
+  numBundleHelices_ = 0;
   stepsize = 0.1;
   tolerance = 0.01;
+  gradientTolerance = 0.00001;
   maxIterations = 200;
   symmetry_ = "C";
   parameterSize = 3;
-  minimizeAlgorithm = NELDERMEAD1;
-  minIndex = 1;
+  minimizeAlgorithm = LBFGS;
+  rmsd = MslTools::doubleMax;
+  converged = false;
+  verbose = false;
 }
 
 	
@@ -60,91 +115,287 @@ void CoiledCoilFitter::addNextHelix(AtomPointerVector *_helix){
      numHelices_++;
 }
 
-bool CoiledCoilFitter::fit(){
-
-      if (pAtoms.size() == 0){
+bool CoiledCoilFitter::setupBundle(int & _N) {
+	if (pAtoms.size() == 0){
 		cerr << "ERROR CoiledCoilFitter::fit() no atoms to minimize.\n";
 		return false;	 
 	}
+	if (pAtoms.size() != 4 * numResidues_ * numHelices_) {
+		cerr << "ERROR 23424 CoiledCoilFitter::fit() each residue needs 4 backbone atoms (N, CA, C, O)" << endl;
+		return false;
+	}
 
-	// Variable declaration
-	int retval,iter,status;
-	double size;
-	size = retval = iter = status = 0;
-	int parameterSize = 3;
+	// the D symmetry generates the helices in pairs
+	_N = numHelices_;
+	if (symmetry_ == "D" || symmetry_ == "d") {
+		if (numHelices_ % 2 != 0) {
+			cerr << "ERROR 23425 CoiledCoilFitter::fit() D symmetry requires an even number of helices (" << numHelices_ << ")" << endl;
+			return false;
+		}
+		_N = numHelices_ / 2;
+	} else if (symmetry_ != "C" && symmetry_ != "c") {
+		cerr << "ERROR 23426 CoiledCoilFitter::fit() unknown symmetry " << symmetry_ << endl;
+		return false;
+	}
 
-	// Compute the initial value
-	double initialValue, minimizedValue, deltaValue;
-	minimizedValue = deltaValue = initialValue = MslTools::doubleMax;
+	AtomPointerVector & atoms = pAtoms.getAtomPointers();
+	target.resize(3 * atoms.size());
+	for (unsigned int i = 0; i < atoms.size(); i++) {
+		target[3*i]   = atoms[i]->getX();
+		target[3*i+1] = atoms[i]->getY();
+		target[3*i+2] = atoms[i]->getZ();
+	}
+	return true;
+}
 
+bool CoiledCoilFitter::fit(){
 
-	//cout << "Setting up, initial value: "<<initialValue<<","<<coordinateSize<<endl;
+	params.clear();
+	rmsd = MslTools::doubleMax;
+	converged = false;
+	if (!setupBundle(numBundleHelices_)) {
+		return false;
+	}
 
-	// Double data in GSL
-	gsl_vector *gslData = NULL;
+	// starting point
+	vector<double> x(parameterSize);
+	x[0] = 5.0;                           // superhelical radius = r0 = 5
+	x[1] = (2*M_PI*5)/tan(M_PI*12/180);   // super-helical pitch (12 degrees converted into Angstroms = distance between superhelical repeats)
+	x[2] = 0.0;                           // phi1 = alpha helical phase = 0
 
-	// Create gsl version of our data..
-	gslData = gsl_vector_alloc( parameterSize );
-	gsl_vector_set(gslData,0,5.0);                           // superhelical radius = r0 = 5
-	gsl_vector_set(gslData,1,(2*M_PI*5)/tan(M_PI*12/180)); // super-helical pitch (12 degrees converted into Angstroms = distance between superhelical repeats)
-	gsl_vector_set(gslData,2,0.0);                           // phi1 = alpha helical phase = 0
-	
+	switch (minimizeAlgorithm) {
+		case LBFGS:
+			converged = fitLBFGS(x);
+			break;
+#ifdef __GSL__
+		case NELDERMEAD1:
+#ifndef __GSL_OLD__
+		case NELDERMEAD2:
+		case NELDERMEAD2RAND:
+#endif
+			converged = fitSimplex(x);
+			break;
+#endif
+		default:
+			cerr << "CoiledCoilFitter::Minimize() undefined minimization algorithm: "<<minimizeAlgorithm<<endl;
+			return false;
+	}
+
+	if (!converged) {
+		cerr << "ERROR CoiledCoilFitter did not converge!\n";
+		return true;
+	}
+
+	bool suc = false;
+	double msd = deviation(x, NULL, &suc);
+	if (!suc) {
+		converged = false;
+		cerr << "ERROR CoiledCoilFitter did not converge!\n";
+		return true;
+	}
+	rmsd = sqrt(msd);
+	if (verbose) {
+		fprintf(stdout,"%8.3f, %8.3f, %8.3f, %8.3f, %8.3f, %8.3f, %8.3f\n", x[0], fixedRisePerRes, x[1], fixedR1, fixedW1, x[2], 0.0);
+		fprintf(stdout, "RSMD Final = %8.3f\n",rmsd);
+	}
+
+	// Store these parameters
+	params.push_back(x[0]); //r0
+	params.push_back(fixedRisePerRes); //risePerRes
+	params.push_back(x[1]); //pitch
+	params.push_back(fixedR1); //r1
+	params.push_back(fixedW1); //w1
+	params.push_back(x[2]); //phi1
+	params.push_back(0.0); //dZ
 
+	return true;
+}
+
+bool CoiledCoilFitter::fitBatch(vector<CoiledCoilFitter*> & _fitters, int _threads) {
+	// the fitters are independent, the bundles are generated without atoms
+	int failed = 0;
+	int n = _fitters.size();
+#ifdef __OPENMP__
+	#pragma omp parallel for schedule(dynamic,1) reduction(+:failed) num_threads(MslTools::getNumThreads(_threads))
+#endif
+	for (int i = 0; i < n; i++) {
+		if (!_fitters[i]->fit() || !_fitters[i]->getConverged()) {
+			failed++;
+		}
+	}
+	return failed == 0;
+}
+
+bool CoiledCoilFitter::fitLBFGS(vector<double> & _x) {
+
+	/***************************************************
+	 *  The deviation has local minima along the phase
+	 *  and the handedness cannot change continuously:
+	 *  start from the best point of a 30 degree scan of
+	 *  the phase at the starting radius, with the
+	 *  starting pitch and its opposite
+	 ***************************************************/
+	vector<double> x(_x);
+	vector<double> best(_x);
+	double bestMSD = MslTools::doubleMax;
+	for (unsigned int hand = 0; hand < 2; hand++) {
+		x[1] = hand == 0 ? _x[1] : -_x[1];
+		for (unsigned int i = 0; i < 12; i++) {
+			x[2] = _x[2] + i * 30.0;
+			double msd = deviation(x, NULL);
+			if (msd < bestMSD) {
+				bestMSD = msd;
+				best = x;
+			}
+		}
+	}
+	x = best;
+
+	vector<double> start(parameterSize);
+	for (unsigned int i = 0; i < parameterSize; i++) {
+		start[i] = x[i] / variableScale[i];
+	}
+
+	ParameterMinimizer min(*this, start);
+	min.setStepSize(stepsize);
+	min.setTolerance(gradientTolerance);
+	min.setMaxIterations(maxIterations);
+	min.minimize();
+
+	if (min.getFailed()) {
+		// a zero gradient returned on a failed superposition is not a minimum
+		cerr << "WARNING 23427: the superposition of the bundle failed during the minimization in bool CoiledCoilFitter::fitLBFGS(vector<double> & _x)" << endl;
+	}
+
+	const vector<double> & scaled = min.getVariables();
+	for (unsigned int i = 0; i < parameterSize; i++) {
+		_x[i] = scaled[i] * variableScale[i];
+	}
+	// bring the phase within [0,360)
+	_x[2] = fmod(_x[2], 360.0);
+	if (_x[2] < 0.0) {
+		_x[2] += 360.0;
+	}
+	return min.getConverged() && !min.getFailed();
+}
+
+double CoiledCoilFitter::deviation(const vector<double> & _x, vector<double> * _g, bool * _suc) {
+
+	double r0 = _x[0];
+	double pitch = _x[1];
+	double phi1 = _x[2];
+
+	CoiledCoils cc;
+	vector<double> model;
+	vector<vector<double> > gradient;
+	if (_g == NULL) {
+		cc.getCoiledCoilBundleCoordinates(r0, fixedRisePerRes, pitch, fixedR1, fixedW1, phi1, 0.0, numResidues_, symmetry_, numBundleHelices_, model);
+	} else {
+		cc.getCoiledCoilBundleGradient(r0, fixedRisePerRes, pitch, fixedR1, fixedW1, phi1, 0.0, numResidues_, symmetry_, numBundleHelices_, model, gradient);
+	}
+
+	OptimalRMSDCalculator calc;
+	bool suc = false;
+	calc.bestRMSD(model, target, &suc, true);
+	if (_suc != NULL) {
+		*_suc = suc;
+	}
+	if (!suc) {
+		if (_g != NULL) {
+			_g->assign(parameterSize, 0.0);
+		}
+		return MslTools::doubleMax;
+	}
+	vector<double> t = calc.lastTranslation();
+	vector<vector<double> > u = calc.lastRotation();
+
+	/***************************************************
+	 *  MSD = sum |u m + t - y|^2 / n at the optimal u, t:
+	 *  its derivative with respect to the model point m
+	 *  is 2/n u^T (u m + t - y)
+	 ***************************************************/
+	unsigned int n = model.size() / 3;
+	double msd = 0.0;
+	unsigned int gradientIndex[3] = {0, 2, 5}; // r0, pitch and phi1 in the gradient of the coordinates
+	if (_g != NULL) {
+		_g->assign(parameterSize, 0.0);
+	}
+	for (unsigned int i = 0; i < n; i++) {
+		const double * m = &model[3*i];
+		const double * y = &target[3*i];
+		double r[3];
+		for (unsigned int j = 0; j < 3; j++) {
+			r[j] = u[j][0]*m[0] + u[j][1]*m[1] + u[j][2]*m[2] + t[j] - y[j];
+			msd += r[j] * r[j];
+		}
+		if (_g != NULL) {
+			for (unsigned int j = 0; j < 3; j++) {
+				double back = 2.0/n * (u[0][j]*r[0] + u[1][j]*r[1] + u[2][j]*r[2]);
+				for (unsigned int p = 0; p < parameterSize; p++) {
+					(*_g)[p] += back * gradient[gradientIndex[p]][3*i+j];
+				}
+			}
+		}
+	}
+	return msd / n;
+}
+
+#ifdef __GSL__
+bool CoiledCoilFitter::fitSimplex(vector<double> & _x){
+
+	// Variable declaration
+	int retval,iter,status;
+	double size;
+	size = retval = iter = status = 0;
+
+	// Create gsl version of our data..
+	gsl_vector *gslData = gsl_vector_alloc( parameterSize );
+	for (unsigned int i = 0; i < parameterSize; i++) {
+		gsl_vector_set(gslData,i,_x[i]);
+	}
 
 	// Step size vector in GSL
 	gsl_vector *ss =  NULL;
 	ss = gsl_vector_alloc(parameterSize);
-	gsl_vector_set_all(ss,stepsize);  // Set all step sizes to .5
+	gsl_vector_set_all(ss,stepsize);
 
 	// Setup GSL Minimizer objects
 	gsl_multimin_function f;
 	f.f = &CoiledCoilFitter::my_static_f;   // the function itself
-	f.n = parameterSize;                     // ASSUMES cartieasan minimization
-	f.params = (this);                     // MUST UPDATE THIS PARAMETER!!!
+	f.n = parameterSize;
+	f.params = (this);
 
 	// GSL Constants for Minimization Algorithm Types
 	const gsl_multimin_fminimizer_type    *R = NULL;
 
-	// Mulit-dimensional minimizer objects
-	gsl_multimin_fminimizer     *s1 = NULL;
-
 	// set up minimizer
 	switch (minimizeAlgorithm) {
 		case NELDERMEAD1:
 			R      = gsl_multimin_fminimizer_nmsimplex;
-			s1     = gsl_multimin_fminimizer_alloc(R,parameterSize); // initalize minimizer
-			retval = gsl_multimin_fminimizer_set(s1, &f, gslData, ss);
 			break;
 #ifndef __GSL_OLD__
 		// the following two functions compile only with GSL V.1.14 or above
 		// set a $GSL_OLD = T environmental variable to avoid compiling them
 		case NELDERMEAD2:
 			R      = gsl_multimin_fminimizer_nmsimplex2;
-			s1     = gsl_multimin_fminimizer_alloc(R,parameterSize); // initalize minimizer
-			retval = gsl_multimin_fminimizer_set(s1, &f, gslData, ss);
 			break;
 		case NELDERMEAD2RAND:
 			R      = gsl_multimin_fminimizer_nmsimplex2rand;
-			s1     = gsl_multimin_fminimizer_alloc(R,parameterSize); // initalize minimizer
-			retval = gsl_multimin_fminimizer_set(s1, &f, gslData, ss);
 			break;
 #endif
-		default:
-			cerr << "CoiledCoilFitter::Minimize() undefined minimization algorithm: "<<minimizeAlgorithm<<endl;
-			return false;
 	}
 
-
+	// Mulit-dimensional minimizer objects
+	gsl_multimin_fminimizer     *s1 = gsl_multimin_fminimizer_alloc(R,parameterSize); // initalize minimizer
 	if (s1 == NULL){
 		cerr << "CoiledCoilFitter::Minimize() problem no minimizer object set up\n";
+		gsl_vector_free(ss);
+		gsl_vector_free(gslData);
 		return false;
 	}
+	retval = gsl_multimin_fminimizer_set(s1, &f, gslData, ss);
 
-
-	//  Store positions before minimization .... ????
-	bool converged = false;
-	
-	//cout << "RUN MINIMIZATION"<<endl;
+	bool simplexConverged = false;
 	do {
 		iter++;
 
@@ -153,7 +404,6 @@ bool CoiledCoilFitter::fit(){
 
 		// Check for errors, handling should be better
 		if (status != GSL_SUCCESS && status != GSL_CONTINUE) {
-
 	 		cerr << "Error 13425: " << gsl_strerror(status) << endl;
 			break;  
 		}
@@ -164,123 +414,35 @@ bool CoiledCoilFitter::fit(){
 
 		// Check status to see if we have minimized (converged)
 		if (status == GSL_SUCCESS) {  
-		  converged = true;
-		  break;
+			simplexConverged = true;
+			break;
 		}           
 
-		
 	} while (status == GSL_CONTINUE && iter < maxIterations);
 
-
-	// Print out values..
-	minimizedValue  = 0.0;
-	deltaValue     = 0.0;
-	minimizedValue = gsl_multimin_fminimizer_minimum(s1);
-	deltaValue     = (minimizedValue - initialValue);
-
-	if (converged){
-	  CoiledCoils cc;
-	  AtomPointerVector &ats = cc.getCoiledCoilBundle(
-					    gsl_vector_get(s1->x,0), //r0
-					    1.51, //risePerRes
-					    gsl_vector_get(s1->x,1), //pitch
-					    2.26, //r1
-					    102.8, //w1
-					    gsl_vector_get(s1->x,2), //phi1
-					    0.0, //dZ
-					    numResidues_,
-					    symmetry_,
-					    numHelices_);
-  
-  
-	  fprintf(stdout,"%8.3f, %8.3f, %8.3f, %8.3f, %8.3f, %8.3f, %8.3f\n",
-					    gsl_vector_get(s1->x,0), //r0
-					    1.51, //risePerRes
-					    gsl_vector_get(s1->x,1), //pitch
-					    2.26, //r1
-					    102.8, //w1
-					    gsl_vector_get(s1->x,2), //phi1
-					    0.0 //dZ
-		  );
-
-
-
-	  Transforms t;
-	  t.rmsdAlignment(ats,pAtoms.getAtomPointers());
-
-	  PDBWriter pout;
-	  pout.open("/tmp/ccf_min.pdb");
-	  pout.write(ats);
-	  pout.close();
-
-	  // Compute and return rmsd
-	  double rmsd = pAtoms.getAtomPointers().rmsd(ats);
-	  fprintf(stdout, "RSMD Final = %8.3f\n",rmsd);
-
-	  // Store these parameters
-	  params.push_back(gsl_vector_get(s1->x,0));
-	  params.push_back(1.51); //risePerRes
-	  params.push_back(gsl_vector_get(s1->x,1)); //pitch
-	  params.push_back(2.26); //r1
-	  params.push_back(102.8); //w1
-	  params.push_back(gsl_vector_get(s1->x,2)); //phi1
-	  params.push_back(0.0); //dZ
-
-
-	} else {
-	  cerr << "ERROR CoiledCoilFitter did not converge!\n";
+	for (unsigned int i = 0; i < parameterSize; i++) {
+		_x[i] = gsl_vector_get(s1->x,i);
 	}
 
-
-
+	// clean up and free memory
 	gsl_vector_free(ss);
 	gsl_vector_free(gslData);
-
-	// clean up and free memory
 	gsl_multimin_fminimizer_free(s1);      
 
-	return true;
-	
+	return simplexConverged;
 }
 
-
 double CoiledCoilFitter::my_static_f(const gsl_vector *_xvec_ptr, void *_params){
-	double temp;
-	//((CoiledCoilFitter *)_params)->resetCoordinates(_xvec_ptr);// why?
-	temp = ((CoiledCoilFitter *)_params)->my_f(_xvec_ptr,NULL);
-	return temp;
+	return ((CoiledCoilFitter *)_params)->my_f(_xvec_ptr,NULL);
 }
 
 double CoiledCoilFitter::my_f(const gsl_vector *_xvec_ptr, void *_params){
 
-  // Create coiled coil given gsl_vector parameters and number of helices
-  CoiledCoils cc;
-  AtomPointerVector &ats = cc.getCoiledCoilBundle(
-					    gsl_vector_get(_xvec_ptr,0), //super-helical radius
-					    1.51, //risePerRes
-					    gsl_vector_get(_xvec_ptr,1), //super-helical pitch
-					    2.26, //r1
-					    102.8, //w1
-					    gsl_vector_get(_xvec_ptr,2), //alpha-helical phase
-					    0.0, //dZ
-					    numResidues_,
-					    symmetry_,
-					    numHelices_);
-
-  PDBWriter pout;
-  pout.open(MslTools::stringf("/tmp/min_%025d.pdb",minIndex++));
-  pout.write(ats);
-  pout.close();
-
-  Transforms t;
-  t.rmsdAlignment(ats,pAtoms.getAtomPointers());
-  
-
-  // Compute and return rmsd
-  double rmsd = pAtoms.getAtomPointers().rmsd(ats);
-  fprintf(stdout, "RSMD[%20d] = %8.3f\n",minIndex,rmsd);
-  return rmsd;
-
+	// RMSD of the coiled coil generated from the parameters (r0, pitch, phi1), after superposition
+	vector<double> x(parameterSize);
+	for (unsigned int i = 0; i < parameterSize; i++) {
+		x[i] = gsl_vector_get(_xvec_ptr,i);
+	}
+	return sqrt(deviation(x, NULL));
 }
-
-
+#endif
@@ -23,13 +23,34 @@ You should have received a copy of the GNU Lesser General Public
 #ifndef COILEDCOILFITTER_H
 #define COILEDCOILFITTER_H
 
+#include "AtomContainer.h"
 
-#ifndef __GSL__
-#error message("CoiledCoilFitter can't compile unless GSL libraries are present")
+#ifdef __GSL__
+#include <gsl/gsl_multimin.h>
 #endif
 
-#include "AtomContainer.h"
-#include <gsl/gsl_multimin.h>
+/*******************************************************************
+ *  Fits the North parameters of a coiled coil (super-helical
+ *  radius, pitch and alpha-helical phase; rise per residue, r1
+ *  and w1 are kept at 1.51, 2.26 and 102.8) to the backbone of a
+ *  bundle:
+ *
+ *     CoiledCoilFitter ccf;
+ *     ccf.addNextHelix(&sys.getChain("A").getAtomPointers());
+ *     ccf.addNextHelix(&sys.getChain("B").getAtomPointers());
+ *     ccf.setSymmetry("C");
+ *     ccf.fit();
+ *     vector<double> params = ccf.getMinimizedParameters(); // r0, risePerRes, pitch, r1, w1, phi1, dZ
+ *
+ *  The default algorithm (LBFGS) minimizes the mean square deviation
+ *  after optimal superposition with the analytic derivatives of the
+ *  coordinates (CoiledCoils::getCoiledCoilBundleGradient), starting
+ *  from the best point of a scan of the phase.  It does not need
+ *  GSL; the simplex algorithms (NELDERMEAD*) require it.
+ *
+ *  Many bundles can be fit in parallel with fitBatch when MSL is
+ *  compiled with OpenMP (MSL_OPENMP=T).
+ *******************************************************************/
 
 using namespace std;
 
@@ -43,7 +64,7 @@ class CoiledCoilFitter  {
 
 		/*
 		  Must add helices in order. A,B,C,D means A neighbors D and B.  B neighbors A and C. C neighbors B and D.  
-		  // Add N,Ca,C,Cb only
+		  // Add N,Ca,C,O only
 		 */
 		void addNextHelix(AtomPointerVector *_av);
 
@@ -51,15 +72,24 @@ class CoiledCoilFitter  {
 		//TODO: LOOK INTO CREATING ENERGY SUBSETS
 		bool fit();
 
+		// fit() of all the fitters, on multiple threads when compiled with OpenMP (0 = all cores).
+		// Returns false if any of the fits failed
+		static bool fitBatch(std::vector<CoiledCoilFitter*> & _fitters, int _threads = 0);
+
 		// Get, Sets
 		void setSystem(System& _sys);
 
 		void setStepSize(double _stepsize);
 		double getStepSize();
 		
+		// size of the simplex at convergence (NELDERMEAD*)
 		void setTolerance(double _tol);
 		double getTolerance();
 
+		// norm of the gradient of the MSD at convergence (LBFGS)
+		void setGradientTolerance(double _tol);
+		double getGradientTolerance();
+
 		void setMaxIterations(int _maxIter);
 		int getMaxIterations();
 
@@ -69,34 +99,54 @@ class CoiledCoilFitter  {
 		void setSymmetry(string _sym);
 		string getSymmetry();
 
+		// print the fitted parameters and RMSD to stdout
+		void setVerbose(bool _verbose);
+		bool getVerbose();
+
 		vector<double> getMinimizedParameters();
+		double getMinimizedRMSD(); // RMSD after superposition of the fitted bundle
+		bool getConverged();
 
 		//void printData();
-		enum MinimizingAlgorithms { NELDERMEAD1=1, NELDERMEAD2=2,NELDERMEAD2RAND=3};
+		enum MinimizingAlgorithms { NELDERMEAD1=1, NELDERMEAD2=2,NELDERMEAD2RAND=3,LBFGS=4};
 
 
 	private:
 
+		class ParameterMinimizer;
+
+		// MSD after superposition of the bundle generated from _x (r0, pitch, phi1) on the target, and its gradient if _g is not NULL
+		// (if the superposition fails _suc is set to false and doubleMax is returned, with a zero gradient)
+		double deviation(const vector<double> & _x, vector<double> * _g, bool * _suc=NULL);
+		bool setupBundle(int & _N);
+		bool fitLBFGS(vector<double> & _x);
+
 		AtomContainer pAtoms;
+		vector<double> target; // packed coordinates of the helices
 
 		double stepsize;
 		double tolerance;
+		double gradientTolerance;
 		int    maxIterations;
 		int    minimizeAlgorithm;    
 		string symmetry_;
 		int numHelices_;
 		int numResidues_;
+		int numBundleHelices_; // N of the C or D bundle
 		int parameterSize;
-		int minIndex;
 		vector<double> params;
+		double rmsd;
+		bool converged;
+		bool verbose;
 
+#ifdef __GSL__
 		// Defining function pointers
 		double  my_f   (const gsl_vector *xvec_ptr, void *params);
 		static double  my_static_f   (const gsl_vector *xvec_ptr, void *params);
-
+		bool fitSimplex(vector<double> & _x);
+#endif
 
 };
-#endif
 
 //INLINES
 
@@ -107,6 +157,9 @@ inline double CoiledCoilFitter::getStepSize(){ return stepsize;}
 inline void CoiledCoilFitter::setTolerance(double _tol){ tolerance = _tol; }
 inline double CoiledCoilFitter::getTolerance(){ return tolerance;}
 
+inline void CoiledCoilFitter::setGradientTolerance(double _tol){ gradientTolerance = _tol; }
+inline double CoiledCoilFitter::getGradientTolerance(){ return gradientTolerance;}
+
 inline void CoiledCoilFitter::setMaxIterations(int _maxIter){ maxIterations = _maxIter; }
 inline int CoiledCoilFitter::getMaxIterations(){ return maxIterations;}
 
@@ -117,5 +170,11 @@ inline int CoiledCoilFitter::getMinimizeAlgorithm(){ return minimizeAlgorithm;}
 inline void CoiledCoilFitter::setSymmetry(string _sym) { symmetry_ = _sym; }
 inline string  CoiledCoilFitter::getSymmetry() { return symmetry_;}
 
+inline void CoiledCoilFitter::setVerbose(bool _verbose) { verbose = _verbose; }
+inline bool CoiledCoilFitter::getVerbose() { return verbose;}
+
  inline vector<double> CoiledCoilFitter::getMinimizedParameters() { return params; }
+inline double CoiledCoilFitter::getMinimizedRMSD() { return rmsd; }
+inline bool CoiledCoilFitter::getConverged() { return converged; }
 };
+#endif
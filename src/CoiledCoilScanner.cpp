@@ -0,0 +1,295 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "CoiledCoilScanner.h"
+#include "Timer.h"
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+
+using namespace MSL;
+using namespace std;
+
+namespace {
+	// by energy, ties by grid index so that the ranking does not depend on the order of evaluation
+	bool lowerEnergy(const CoiledCoilScanner::Result & _a, const CoiledCoilScanner::Result & _b) {
+		if (_a.energy != _b.energy) {
+			return _a.energy < _b.energy;
+		}
+		return _a.parameters.index < _b.parameters.index;
+	}
+}
+
+CoiledCoilScanner::CoiledCoilScanner() {
+	setup();
+}
+
+CoiledCoilScanner::~CoiledCoilScanner() {
+}
+
+void CoiledCoilScanner::setup() {
+	nRes = 0;
+	symmetry = "C";
+	N = 0;
+	minCaDistance = 0.0;
+	energyCutoff = 0.0;
+	energyCutoff_flag = false;
+	maxResults = 0;
+	outputFile = "";
+	numThreads = 0;
+	numberOfPrescreened = 0;
+	numberOfRejected = 0;
+	numberOfFailed = 0;
+	scanTime = 0.0;
+}
+
+vector<double> CoiledCoilScanner::getRangeValues(double _start, double _end, double _step) {
+	vector<double> out;
+	if (_step <= 0.0) {
+		out.push_back(_start);
+		return out;
+	}
+	// Adding 0.00001 is to avoid rounding errors and have the loop go to the end step
+	for (double value = _start; value <= _end + 0.00001; value += _step) {
+		out.push_back(value);
+	}
+	return out;
+}
+
+void CoiledCoilScanner::setBundle(int _nRes, string _symmetry, int _N, vector<string> _startingPositions) {
+	nRes = _nRes;
+	symmetry = _symmetry;
+	N = _N;
+	startingPositions = _startingPositions;
+}
+
+int CoiledCoilScanner::getNumThreads() const {
+	return MslTools::getNumThreads(numThreads);
+}
+
+unsigned int CoiledCoilScanner::getNumberOfPoints() const {
+	return r0Values.size() * r1Values.size() * w1Values.size() * phi1Values.size() * rprValues.size() * pitchValues.size();
+}
+
+CoiledCoilScanner::Parameters CoiledCoilScanner::getPoint(unsigned int _index) const {
+	// r0 varies fastest
+	Parameters out;
+	out.index = _index;
+	out.r0 = r0Values[_index % r0Values.size()];
+	_index /= r0Values.size();
+	out.r1 = r1Values[_index % r1Values.size()];
+	_index /= r1Values.size();
+	out.w1 = w1Values[_index % w1Values.size()];
+	_index /= w1Values.size();
+	out.phi1 = phi1Values[_index % phi1Values.size()];
+	_index /= phi1Values.size();
+	out.rpr = rprValues[_index % rprValues.size()];
+	_index /= rprValues.size();
+	out.pitch = pitchValues[_index % pitchValues.size()];
+	return out;
+}
+
+bool CoiledCoilScanner::caClash(const vector<double> & _backbone) const {
+	// the CA is the second of the four atoms of each residue
+	unsigned int residues = _backbone.size() / 12;
+	double min2 = minCaDistance * minCaDistance;
+	for (unsigned int i=0; i < residues; i++) {
+		const double * a = &_backbone[12*i + 3];
+		unsigned int helixEnd = (i / nRes + 1) * nRes;
+		for (unsigned int j=helixEnd; j < residues; j++) {
+			const double * b = &_backbone[12*j + 3];
+			double dx = a[0] - b[0];
+			double dy = a[1] - b[1];
+			double dz = a[2] - b[2];
+			if (dx*dx + dy*dy + dz*dz < min2) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool CoiledCoilScanner::scan(Evaluator & _evaluator) {
+	results.clear();
+	numberOfPrescreened = 0;
+	numberOfRejected = 0;
+	numberOfFailed = 0;
+	scanTime = 0.0;
+
+	if (startingPositions.size() == 0) {
+		cerr << "ERROR 62301: bundle not set in bool CoiledCoilScanner::scan(Evaluator & _evaluator)" << endl;
+		return false;
+	}
+
+	Timer timer;
+	double start = timer.getWallTime();
+
+	ofstream out_fs;
+	ostream * pOut = NULL;
+	if (outputFile != "") {
+		out_fs.open(outputFile.c_str());
+		if (out_fs.fail()) {
+			cerr << "ERROR 62302: cannot write output file " << outputFile << " in bool CoiledCoilScanner::scan(Evaluator & _evaluator)" << endl;
+			return false;
+		}
+		pOut = &out_fs;
+	}
+
+	int size = getNumberOfPoints();
+	bool error = false;
+
+#ifdef __OPENMP__
+	#pragma omp parallel num_threads(getNumThreads())
+#endif
+	{
+		// every worker has its own system, evaluator and coiled coil generator
+		System sys;
+		CoiledCoils cc;
+		vector<double> backbone;
+		Evaluator * pEvaluator = NULL;
+
+		// the setup (reading topology, parameters, rotamer libraries...) is done one thread at the time
+#ifdef __OPENMP__
+		#pragma omp critical(CoiledCoilScanner_setup)
+#endif
+		{
+			pEvaluator = _evaluator.clone();
+			if (!pEvaluator->setup(sys)) {
+				cerr << "ERROR 62303: cannot setup the evaluator in bool CoiledCoilScanner::scan(Evaluator & _evaluator)" << endl;
+				error = true;
+			}
+		}
+#ifdef __OPENMP__
+		#pragma omp barrier
+#endif
+
+		if (!error) {
+#ifdef __OPENMP__
+			#pragma omp for schedule(dynamic, 1)
+#endif
+			for (int i=0; i < size; i++) {
+				Parameters parameters = getPoint(i);
+
+				// backbone only pre-screening
+				if (!cc.getCoiledCoilBundleCoordinates(parameters.r0, parameters.rpr, parameters.pitch, parameters.r1, parameters.w1, parameters.phi1, 0.0, nRes, symmetry, N, backbone)) {
+#ifdef __OPENMP__
+					#pragma omp atomic
+#endif
+					numberOfFailed++;
+					continue;
+				}
+				if ((minCaDistance > 0.0 && caClash(backbone)) || !pEvaluator->prescreen(backbone, parameters)) {
+#ifdef __OPENMP__
+					#pragma omp atomic
+#endif
+					numberOfPrescreened++;
+					continue;
+				}
+
+				sys.wipeAllCoordinates();
+				if (!cc.setSystemToBundleCoordinates(backbone, nRes, symmetry, N, sys, startingPositions)) {
+#ifdef __OPENMP__
+					#pragma omp atomic
+#endif
+					numberOfFailed++;
+					continue;
+				}
+
+				Result result;
+				result.parameters = parameters;
+				result.energy = 0.0;
+				if (!pEvaluator->evaluate(sys, parameters, result.energy, result.annotation) || (energyCutoff_flag && result.energy > energyCutoff)) {
+#ifdef __OPENMP__
+					#pragma omp atomic
+#endif
+					numberOfRejected++;
+					continue;
+				}
+
+#ifdef __OPENMP__
+				#pragma omp critical(CoiledCoilScanner_results)
+#endif
+				addResult(result, pOut);
+			}
+		}
+		delete pEvaluator;
+	}
+
+	rankResults();
+	if (pOut != NULL) {
+		out_fs.close();
+	}
+	scanTime = timer.getWallTime() - start;
+	return !error;
+}
+
+void CoiledCoilScanner::addResult(const Result & _result, ostream * _pOut) {
+	if (_pOut != NULL) {
+		char c[100];
+		sprintf(c, "%8u", _result.parameters.index);
+		(*_pOut) << c << formatResult(_result) << endl;
+	}
+	results.push_back(_result);
+	if (maxResults > 0 && results.size() >= 2 * maxResults) {
+		// keep the memory bounded in long scans
+		rankResults();
+	}
+}
+
+void CoiledCoilScanner::rankResults() {
+	sort(results.begin(), results.end(), lowerEnergy);
+	if (maxResults > 0 && results.size() > maxResults) {
+		results.resize(maxResults);
+	}
+}
+
+string CoiledCoilScanner::formatResult(const Result & _result) const {
+	char c[1000];
+	const Parameters & p = _result.parameters;
+	sprintf(c, "%25.4f%10.4f%10.4f%10.4f%10.4f%10.4f%10.4f", _result.energy, p.r0, p.r1, p.w1, p.phi1, p.rpr, p.pitch);
+	return (string)c + _result.annotation;
+}
+
+void CoiledCoilScanner::writeResults(ostream & _os) const {
+	for (unsigned int i=0; i < results.size(); i++) {
+		_os << formatResult(results[i]) << endl;
+	}
+}
+
+bool CoiledCoilScanner::writeResults(string _filename) const {
+	ofstream fs;
+	fs.open(_filename.c_str());
+	if (fs.fail()) {
+		cerr << "ERROR 62304: cannot write " << _filename << " in bool CoiledCoilScanner::writeResults(string _filename) const" << endl;
+		return false;
+	}
+	writeResults(fs);
+	fs.close();
+	return true;
+}
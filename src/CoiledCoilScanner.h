@@ -0,0 +1,241 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef COILEDCOILSCANNER_H
+#define COILEDCOILSCANNER_H
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "System.h"
+#include "CoiledCoils.h"
+
+/*************************************************************************
+ *  Scans a grid of coiled coil parameters (r0, r1, w1, phi1, rise per
+ *  residue and pitch, North notation, see CoiledCoils.h) and evaluates
+ *  each point with a user defined Evaluator.
+ *
+ *  The grid is enumerated with r0 varying fastest (the same order of
+ *  the Enumerator used by the coiledCoilBuilder program).  When MSL is
+ *  compiled with OpenMP (MSL_OPENMP=T) the points are distributed to
+ *  multiple threads.  Every thread has its own System, built by its own
+ *  copy of the Evaluator (Evaluator::clone() and Evaluator::setup()),
+ *  and its own CoiledCoils object.
+ *
+ *  For every point:
+ *   1) the backbone of the bundle is generated in a packed buffer
+ *      (CoiledCoils::getCoiledCoilBundleCoordinates) and pre-screened:
+ *      points with any pair of CA atoms of different helices closer
+ *      than the minimum CA distance (if set) and points that fail
+ *      Evaluator::prescreen() are rejected;
+ *   2) the coordinates of the System are wiped and the backbone is
+ *      applied to it (CoiledCoils::setSystemToBundleCoordinates);
+ *   3) Evaluator::evaluate() builds whatever it needs (side chains,
+ *      rotamers, optimization...) and returns the energy, or false to
+ *      reject the point.
+ *  Points above the energy cutoff (if set) are discarded.  Accepted
+ *  points are written to the output file (if set) as soon as they are
+ *  evaluated, in no particular order, and are kept ranked by energy
+ *  (the best maxResults if set).
+ *
+ *  Evaluators must not share non-constant data between their copies.
+ *  Stochastic evaluations (i.e. Monte Carlo) should give each copy its
+ *  own RandomNumberGenerator and seed it at every point with
+ *  setSeed(seed, Parameters::index): without GSL a generator seeded
+ *  with setSeed(seed) draws from the global rand(), and the results
+ *  would depend on the threads.
+ *
+ *  Usage:
+ *     class MyEvaluator : public CoiledCoilScanner::Evaluator {
+ *        ...
+ *     };
+ *     CoiledCoilScanner scanner;
+ *     scanner.setR0Range(6.5, 7.5, 0.1);
+ *     ... (the other five ranges)
+ *     scanner.setBundle(28, "C", 2, startingPositions);
+ *     scanner.setMinimumCaDistance(4.0);
+ *     scanner.setOutputFile("scan.txt");
+ *     MyEvaluator evaluator;
+ *     scanner.scan(evaluator);
+ *     scanner.writeResults("sortedEnergies.txt");
+ *************************************************************************/
+
+namespace MSL { 
+class CoiledCoilScanner {
+	public:
+		// a point of the grid
+		struct Parameters {
+			unsigned int index;
+			double r0;
+			double r1;
+			double w1;
+			double phi1;
+			double rpr; // rise per residue
+			double pitch;
+		};
+
+		struct Result {
+			Parameters parameters;
+			double energy;
+			std::string annotation; // evaluator defined, i.e. the rotameric state
+		};
+
+		class Evaluator {
+			public:
+				virtual ~Evaluator() {}
+				// a new copy of the evaluator for a worker thread (deleted by the scanner)
+				virtual Evaluator * clone() const = 0;
+				// build the System of the worker (called once per thread, one thread at the time)
+				virtual bool setup(System & _sys) = 0;
+				// optional check on the backbone of the bundle, before it is applied to the System
+				// (packed x,y,z of N, CA, C and O of each residue, helix after helix)
+				virtual bool prescreen(const std::vector<double> & _backbone, const Parameters & _parameters) {return true;}
+				// evaluate the System at the point, return false to reject it
+				virtual bool evaluate(System & _sys, const Parameters & _parameters, double & _energy, std::string & _annotation) = 0;
+		};
+
+		CoiledCoilScanner();
+		~CoiledCoilScanner();
+
+		/***************************************************
+		 *  The grid: each range goes from start to end
+		 *  (inclusive, with a 1e-5 tolerance) by step
+		 ***************************************************/
+		void setR0Range(double _start, double _end, double _step);
+		void setR1Range(double _start, double _end, double _step);
+		void setW1Range(double _start, double _end, double _step);
+		void setPhi1Range(double _start, double _end, double _step);
+		void setRprRange(double _start, double _end, double _step);
+		void setPitchRange(double _start, double _end, double _step);
+
+		// the bundle, see CoiledCoils::setSystemToCoiledCoil
+		void setBundle(int _nRes, std::string _symmetry, int _N, std::vector<std::string> _startingPositions);
+
+		unsigned int getNumberOfPoints() const;
+		Parameters getPoint(unsigned int _index) const;
+
+		/***************************************************
+		 *  Pre-screening and ranking
+		 ***************************************************/
+		// reject points with CA atoms of different helices closer than this (0 = no check)
+		void setMinimumCaDistance(double _distance);
+		// discard the points with an energy above the cutoff
+		void setEnergyCutoff(double _cutoff);
+		void unsetEnergyCutoff();
+		// keep only the best results (0 = all)
+		void setMaxResults(unsigned int _max);
+
+		// stream the accepted points to a file as they are evaluated ("" = none)
+		void setOutputFile(std::string _filename);
+
+		// 0 = all cores
+		void setNumThreads(int _threads);
+		int getNumThreads() const;
+
+		/***************************************************
+		 *  Scan the grid.  Returns false if a worker cannot
+		 *  be set up or the output cannot be written
+		 ***************************************************/
+		bool scan(Evaluator & _evaluator);
+
+		/***************************************************
+		 *  The accepted points of the last scan, by
+		 *  increasing energy
+		 ***************************************************/
+		unsigned int getNumberOfResults() const;
+		const Result & getResult(unsigned int _n) const;
+		// one line per result: energy, r0, r1, w1, phi1, rpr, pitch, annotation
+		void writeResults(std::ostream & _os) const;
+		bool writeResults(std::string _filename) const;
+
+		/***************************************************
+		 *  Counters of the last scan
+		 ***************************************************/
+		unsigned int getNumberOfPrescreened() const; // rejected by the backbone pre-screening
+		unsigned int getNumberOfRejected() const; // rejected by the evaluator or above the energy cutoff
+		unsigned int getNumberOfFailed() const; // the bundle could not be generated or applied to the System
+		double getScanTime() const; // wall clock seconds
+
+	private:
+		void setup();
+		static std::vector<double> getRangeValues(double _start, double _end, double _step);
+		bool caClash(const std::vector<double> & _backbone) const;
+		void addResult(const Result & _result, std::ostream * _pOut);
+		void rankResults();
+		std::string formatResult(const Result & _result) const;
+
+		std::vector<double> r0Values;
+		std::vector<double> r1Values;
+		std::vector<double> w1Values;
+		std::vector<double> phi1Values;
+		std::vector<double> rprValues;
+		std::vector<double> pitchValues;
+
+		int nRes;
+		std::string symmetry;
+		int N;
+		std::vector<std::string> startingPositions;
+
+		double minCaDistance;
+		double energyCutoff;
+		bool energyCutoff_flag;
+		unsigned int maxResults;
+		std::string outputFile;
+		int numThreads;
+
+		std::vector<Result> results;
+		unsigned int numberOfPrescreened;
+		unsigned int numberOfRejected;
+		unsigned int numberOfFailed;
+		double scanTime;
+
+};
+inline void CoiledCoilScanner::setR0Range(double _start, double _end, double _step) {r0Values = getRangeValues(_start, _end, _step);}
+inline void CoiledCoilScanner::setR1Range(double _start, double _end, double _step) {r1Values = getRangeValues(_start, _end, _step);}
+inline void CoiledCoilScanner::setW1Range(double _start, double _end, double _step) {w1Values = getRangeValues(_start, _end, _step);}
+inline void CoiledCoilScanner::setPhi1Range(double _start, double _end, double _step) {phi1Values = getRangeValues(_start, _end, _step);}
+inline void CoiledCoilScanner::setRprRange(double _start, double _end, double _step) {rprValues = getRangeValues(_start, _end, _step);}
+inline void CoiledCoilScanner::setPitchRange(double _start, double _end, double _step) {pitchValues = getRangeValues(_start, _end, _step);}
+inline void CoiledCoilScanner::setMinimumCaDistance(double _distance) {minCaDistance = _distance;}
+inline void CoiledCoilScanner::setEnergyCutoff(double _cutoff) {energyCutoff = _cutoff; energyCutoff_flag = true;}
+inline void CoiledCoilScanner::unsetEnergyCutoff() {energyCutoff_flag = false;}
+inline void CoiledCoilScanner::setMaxResults(unsigned int _max) {maxResults = _max;}
+inline void CoiledCoilScanner::setOutputFile(std::string _filename) {outputFile = _filename;}
+inline void CoiledCoilScanner::setNumThreads(int _threads) {numThreads = _threads;}
+inline unsigned int CoiledCoilScanner::getNumberOfResults() const {return results.size();}
+inline const CoiledCoilScanner::Result & CoiledCoilScanner::getResult(unsigned int _n) const {return results[_n];}
+inline unsigned int CoiledCoilScanner::getNumberOfPrescreened() const {return numberOfPrescreened;}
+inline unsigned int CoiledCoilScanner::getNumberOfRejected() const {return numberOfRejected;}
+inline unsigned int CoiledCoilScanner::getNumberOfFailed() const {return numberOfFailed;}
+inline double CoiledCoilScanner::getScanTime() const {return scanTime;}
+
+}
+
+#endif
@@ -28,10 +28,23 @@ You should have received a copy of the GNU Lesser General Public
 */
 
 #include "CoiledCoils.h"
+#include "RigidTransform.h"
 
 using namespace MSL;
 using namespace std;
 
+/***************************
+ * Each residue has N, CA, C and O,
+ * each atom type has its own
+ * radius offset, phase offset (radians)
+ * and correction
+ ***************************/
+static const double backboneOffsets[4][3] = {
+	{-0.75,  0.555, -1.015}, // Nitrogen
+	{ 0.0,   0.0,    0.0},   // C-alpha
+	{-0.54, -0.71,   1.19},  // Carbonyl Carbon
+	{-0.18, -2.092,  2.512}  // Carbonyl Oxygen
+};
 
 CoiledCoils::CoiledCoils(){
 	//sys = new System();
@@ -63,8 +76,17 @@ bool CoiledCoils::primarySequenceToCoiledCoil(double _r0, double _risePerRes, do
  *
  ********************************************/
 bool CoiledCoils::setSystemToCoiledCoil(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes, string _symmetry, int _N, System& _sys, vector<string> _startingPositions) {
-	CartesianPoint cp;
-	string atomId;
+	//Create the coiled coil bundle coordinates (and the atoms, available with getAtomPointers())
+	vector<double> xyz;
+	if (!getCoiledCoilBundleCoordinates(_r0, _risePerRes, _pitch, _r1, _w1, _phi1, _dZ, _nRes, _symmetry, _N, xyz)) {
+		return false;
+	}
+	createAtoms(xyz, _nRes);
+
+	return setSystemToBundleCoordinates(xyz, _nRes, _symmetry, _N, _sys, _startingPositions);
+}
+
+bool CoiledCoils::setSystemToBundleCoordinates(const vector<double> & _xyz, int _nRes, string _symmetry, int _N, System& _sys, vector<string> _startingPositions) {
 	int bundleSize = _N;
 	if (_symmetry == "D" || _symmetry == "d") {
 		bundleSize = 2*_N;
@@ -72,10 +94,12 @@ bool CoiledCoils::setSystemToCoiledCoil(double _r0, double _risePerRes, double _
 	vector<int> startPositionIndices; 
 
 	//Test to see if the number of parameters matches the bundle size
-	//if (_symmetry == "C" || _symmetry == "c") bundleSize = _N; 
-	//else 
 	if (_startingPositions.size() != bundleSize) {
-		cerr << "WARNING No. of starting positions does not match no. of bundles in bool CoiledCoils::primarySequenceToCoiledCoil(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes, string _symmetry, int _N, System& _sys, vector<string> _startingPositions)" << endl;
+		cerr << "WARNING No. of starting positions does not match no. of bundles in bool CoiledCoils::setSystemToBundleCoordinates(const vector<double> & _xyz, int _nRes, string _symmetry, int _N, System& _sys, vector<string> _startingPositions)" << endl;
+		return false;
+	}
+	if (_xyz.size() < 12 * _nRes * bundleSize) {
+		cerr << "WARNING The coordinates do not match the size of the bundle in bool CoiledCoils::setSystemToBundleCoordinates(const vector<double> & _xyz, int _nRes, string _symmetry, int _N, System& _sys, vector<string> _startingPositions)" << endl;
 		return false;
 	}
 
@@ -84,7 +108,7 @@ bool CoiledCoils::setSystemToCoiledCoil(double _r0, double _risePerRes, double _
 		if (_sys.positionExists(_startingPositions[i])) {
 			startPositionIndices.push_back(_sys.getPositionIndex(&_sys.getLastFoundPosition()));
 		} else {
-			cerr << "WARNING Not all starting positions are contained within the bundle in bool CoiledCoils::primarySequenceToCoiledCoil(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes, string _symmetry, int _N, System& _sys, vector<string> _startingPositions)" << endl;
+			cerr << "WARNING Not all starting positions are contained within the bundle in bool CoiledCoils::setSystemToBundleCoordinates(const vector<double> & _xyz, int _nRes, string _symmetry, int _N, System& _sys, vector<string> _startingPositions)" << endl;
 			return false;
 		}
 	}
@@ -92,52 +116,27 @@ bool CoiledCoils::setSystemToCoiledCoil(double _r0, double _risePerRes, double _
 	//Test to see if starting positions overlap with one another 
 	for (int i = 0; i < startPositionIndices.size()-1; i++) {
 		if (abs(startPositionIndices[i] - startPositionIndices[i+1]) > _nRes) {
-			cerr << "WARNING Starting positions overlap with one another in bool CoiledCoils::primarySequenceToCoiledCoil(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes, string _symmetry, int _N, System& _sys, vector<string> _startingPositions)" << endl;
+			cerr << "WARNING Starting positions overlap with one another in bool CoiledCoils::setSystemToBundleCoordinates(const vector<double> & _xyz, int _nRes, string _symmetry, int _N, System& _sys, vector<string> _startingPositions)" << endl;
 			return false;
 		}
 	}
 	if ((startPositionIndices[startPositionIndices.size()-1] + _nRes) > _sys.positionSize()) {
-		cerr << "WARNING Starting position overlaps with end of the sequence in bool CoiledCoils::primarySequenceToCoiledCoil(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes, string _symmetry, int _N, System& _sys, vector<string> _startingPositions)" << endl;
+		cerr << "WARNING Starting position overlaps with end of the sequence in bool CoiledCoils::setSystemToBundleCoordinates(const vector<double> & _xyz, int _nRes, string _symmetry, int _N, System& _sys, vector<string> _startingPositions)" << endl;
 		return false;
 	}
 
-	//Create the coiled coil bundle in the atomPointerVector atoms
-	getCoiledCoilBundle(_r0, _risePerRes, _pitch, _r1, _w1, _phi1, _dZ, _nRes, _symmetry, _N);
-
-	//Divide out the APV into the chainVector
-	vector< vector< map<string, Atom*> > > chainVector = atoms.subdivideByChainAndPosition();
-
-	// apply the coordinates of the backbone atoms to the system
+	// apply the coordinates of the backbone atoms to the system (N, CA, C and O of each residue)
+	string names[4] = {Nname, CAname, Cname, Oname};
 	for (int k = 0; k < bundleSize; k++) {
-		int resCount = 0;
+		const double * pCoor = &_xyz[12 * _nRes * k];
 		for (int j = startPositionIndices[k]; j < (startPositionIndices[k]+_nRes); j++) {
 			Residue * pRes = &(_sys.getIdentity(j));
-
-			if (pRes->atomExists(Nname) && chainVector[k][resCount].find(Nname) != chainVector[k][resCount].end()) {
-				pRes->getLastFoundAtom().setCoor(chainVector[k][resCount][Nname]->getCoor());
-			}
-
-			if (pRes->atomExists(CAname) && chainVector[k][resCount].find(CAname) != chainVector[k][resCount].end()) {
-				pRes->getLastFoundAtom().setCoor(chainVector[k][resCount][CAname]->getCoor());
-			}
-
-			if (pRes->atomExists(Cname) && chainVector[k][resCount].find(Cname) != chainVector[k][resCount].end()) {
-				pRes->getLastFoundAtom().setCoor(chainVector[k][resCount][Cname]->getCoor());
-			}
-
-			if (pRes->atomExists(Oname) && chainVector[k][resCount].find(Oname) != chainVector[k][resCount].end()) {
-				pRes->getLastFoundAtom().setCoor(chainVector[k][resCount][Oname]->getCoor());
-			}
-
-			/*
-			for (int i = 0; i < _sys.getPosition(j).atomSize(); i++) {
-				string atomName = _sys.getPosition(j).getAtom(i).getName();
-				if (atomName == "CA" || atomName == "C" || atomName == "O" || atomName == "N") {
-					_sys.getPosition(j).getAtom(i).setCoor(chainVector[k][resCount][atomName]->getCoor());
+			for (unsigned int a = 0; a < 4; a++) {
+				if (pRes->atomExists(names[a])) {
+					pRes->getLastFoundAtom().setCoor(pCoor[0], pCoor[1], pCoor[2]);
 				}
+				pCoor += 3;
 			}
-			*/
-			resCount++;
 		}
 	}
 
@@ -151,32 +150,111 @@ bool CoiledCoils::setSystemToCoiledCoil(double _r0, double _risePerRes, double _
  ********************************************/
 AtomPointerVector& CoiledCoils::getCoiledCoilBundle(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes,  string _symmetry, int _N){
 
-	getCoiledCoil(_r0, _risePerRes, _pitch, _r1, _w1, _phi1, _dZ, _nRes);
+	// with an unknown symmetry the coordinates are those of the first helix
+	vector<double> xyz;
+	getCoiledCoilBundleCoordinates(_r0, _risePerRes, _pitch, _r1, _w1, _phi1, _dZ, _nRes, _symmetry, _N, xyz);
+	createAtoms(xyz, _nRes);
+
+	return atoms; 
+}
+
+bool CoiledCoils::getCoiledCoilBundleCoordinates(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes,  string _symmetry, int _N, vector<double> & _xyz) const {
+
+	getCoiledCoilCoordinates(_r0, _risePerRes, _pitch, _r1, _w1, _phi1, _dZ, _nRes, _xyz);
+
+	bool dihedral = false;
+	if (_symmetry == "d" || _symmetry == "D") {
+		dihedral = true;
+	} else if (_symmetry != "c" && _symmetry != "C") {
+		cerr << "Must specify 'C' or 'D' symmetry" << endl;
+		return false;
+	}
+	if (_nRes <= 0 || _N <= 0) {
+		return true;
+	}
+	applyBundleSymmetry(_xyz, _nRes, dihedral, _N);
+
+	return true;
+}
+
+bool CoiledCoils::getCoiledCoilBundleGradient(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes,  string _symmetry, int _N, vector<double> & _xyz, vector<vector<double> > & _gradient) const {
+
+	bool dihedral = false;
+	if (_symmetry == "d" || _symmetry == "D") {
+		dihedral = true;
+	} else if (_symmetry != "c" && _symmetry != "C") {
+		cerr << "Must specify 'C' or 'D' symmetry" << endl;
+		return false;
+	}
+
+	_gradient.resize(6);
+	getCoiledCoilCoordinates(_r0, _risePerRes, _pitch, _r1, _w1, _phi1, _dZ, _nRes, _xyz);
+	if (_nRes <= 0) {
+		for (unsigned int p = 0; p < 6; p++) {
+			_gradient[p].clear();
+		}
+		return true;
+	}
+
+	// the derivatives of the first helix, then the same symmetry operations of the coordinates
+	double * pGrad[6];
+	for (unsigned int p = 0; p < 6; p++) {
+		_gradient[p].assign(12 * _nRes, 0.0);
+		pGrad[p] = &_gradient[p][0];
+	}
+	radCoiledCoilGradient(_r0, _risePerRes, _pitch, _r1, _w1 * (M_PI/180), _phi1 * (M_PI/180), _nRes, &_xyz[0], pGrad);
+
+	if (_N > 0) {
+		applyBundleSymmetry(_xyz, _nRes, dihedral, _N);
+	}
+	for (unsigned int p = 0; p < 6; p++) {
+		// angles are in degrees
+		if (p >= 4) {
+			for (unsigned int i = 0; i < _gradient[p].size(); i++) {
+				_gradient[p][i] *= M_PI/180;
+			}
+		}
+		if (_N > 0) {
+			applyBundleSymmetry(_gradient[p], _nRes, dihedral, _N);
+		}
+	}
+	return true;
+}
+
+void CoiledCoils::applyBundleSymmetry(vector<double> & _xyz, int _nRes, bool _dihedral, int _N) const {
 
-	Transforms tr;
-	Symmetry symm;
-	//double angle = 0;
+	// _xyz contains the first helix, the rotations are linear so they also apply to derivatives
+	unsigned int helixAtoms = 4 * _nRes;
+	unsigned int helixSize = 3 * helixAtoms;
+	_xyz.resize(helixSize * (_dihedral ? 2*_N : _N));
 
 	/***************************
-	 * C2 Symmetry
+	 * D2 Symmetry: orient the
+	 * first helix
 	 **************************/
-	if (_symmetry == "c" || _symmetry == "C"){
-		symm.applyCN(atoms, _N, CartesianPoint(0.0,0.0,1.0), true);
+	if (_dihedral && _N%2 == 0) {
+		RigidTransform(CartesianGeometry::getZRotationMatrix(45.0 / (_N/2))).apply(&_xyz[0], helixAtoms);
 	}
+
 	/***************************
-	 * D2 Symmetry
+	 * CN: copies of the first
+	 * helix around the Z axis
 	 **************************/
-	else if (_symmetry == "d" || _symmetry == "D"){
-		if (_N%2 == 0) {
-			tr.Zrotate(atoms, (45.0 / (_N/2)));
-		}
-		symm.applyDN(atoms, _N, CartesianPoint(0.0,0.0,1.0), CartesianPoint(0.0,1.0,0.0), true);
-	}
-	else {
-		cerr << "Must specify 'C' or 'D' symmetry" << endl;
+	double angle = 0.0;
+	for (int i = 1; i < _N; i++) {
+		angle += 360.0/_N;
+		copy(_xyz.begin(), _xyz.begin() + helixSize, _xyz.begin() + i * helixSize);
+		RigidTransform(CartesianGeometry::getRotationMatrix(angle, CartesianPoint(0.0,0.0,1.0))).apply(&_xyz[i * helixSize], helixAtoms);
 	}
 
-	return atoms; 
+	/***************************
+	 * DN: the CN bundle rotated
+	 * 180 degrees around the Y axis
+	 **************************/
+	if (_dihedral) {
+		copy(_xyz.begin(), _xyz.begin() + _N * helixSize, _xyz.begin() + _N * helixSize);
+		RigidTransform(CartesianGeometry::getRotationMatrix(180.0, CartesianPoint(0.0,1.0,0.0))).apply(&_xyz[_N * helixSize], _N * helixAtoms);
+	}
 }
 
  
@@ -203,6 +281,16 @@ AtomPointerVector& CoiledCoils::getCoiledCoil(double _r0, double _risePerRes, do
 	return atoms;
 }
 
+void CoiledCoils::getCoiledCoilCoordinates(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes, vector<double> & _xyz) const {
+	double radW1 = _w1 * (M_PI/180);
+	double radPhi1 = _phi1 * (M_PI/180);
+
+	_xyz.resize(12 * (_nRes > 0 ? _nRes : 0));
+	if (_nRes > 0) {
+		radCoiledCoilCoordinates(_r0, _risePerRes, _pitch, _r1, radW1, radPhi1, _dZ, _nRes, &_xyz[0]);
+	}
+}
+
 /********************************************
  *
  *  DEGREE CALL WITH CRICKS PARAM
@@ -231,8 +319,47 @@ AtomPointerVector& CoiledCoils::getCoiledCoilCricks(double _r0, double _w0, doub
  *
  ********************************************/
 void CoiledCoils::radCoiledCoil(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes){
+	vector<double> xyz(12 * (_nRes > 0 ? _nRes : 0));
+	if (_nRes > 0) {
+		radCoiledCoilCoordinates(_r0, _risePerRes, _pitch, _r1, _w1, _phi1, _dZ, _nRes, &xyz[0]);
+	}
+	createAtoms(xyz, _nRes);
+}
 
+void CoiledCoils::createAtoms(const vector<double> & _xyz, int _nRes) {
+
+	// the atoms of the previous coil are owned by this object
+	for (AtomPointerVector::iterator k=atoms.begin(); k!=atoms.end(); k++) {
+		delete *k;
+	}
 	atoms.clear();
+	if (_nRes <= 0) {
+		return;
+	}
+
+	string names[4] = {Nname, CAname, Cname, Oname};
+	string elements[4] = {"N", "C", "C", "O"};
+	string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	unsigned int helices = _xyz.size() / (12 * _nRes);
+	const double * pCoor = _xyz.size() > 0 ? &_xyz[0] : NULL;
+	for (unsigned int h = 0; h < helices; h++) {
+		for (uint i = 0; i < _nRes; i++){
+			for (unsigned int a = 0; a < 4; a++) {
+				Atom *pAtom = new Atom();
+				pAtom->setResidueName("ALA");
+				pAtom->setName(names[a]);
+				pAtom->setElement(elements[a]);
+				pAtom->setResidueNumber(i+1);
+				pAtom->setChainId(alphabet.substr(h % alphabet.size(), 1));
+				pAtom->setCoor(pCoor[0], pCoor[1], pCoor[2]);
+				atoms.push_back(pAtom);
+				pCoor += 3;
+			}
+		}
+	}
+}
+
+void CoiledCoils::radCoiledCoilCoordinates(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes, double * _xyz) const {
 
 	/***************************
 	 * Calculated L, 
@@ -243,95 +370,14 @@ void CoiledCoils::radCoiledCoil(double _r0, double _risePerRes, double _pitch, d
 	double t = _risePerRes / (-L);
 	double zCenter =  (-1.0)*(_pitch*(-(t*_nRes)/(2*M_PI)) +   _r1*(2*M_PI*_r0/sqrt(pow((2*M_PI*_r0),2) + pow(_pitch,2)))*sin((t*_nRes)*wa + _phi1)) / 2;
 
-	for (uint i = 0; i < _nRes; i++){
-
-		/***************************
-		 * Nitrogen placement
-		 ***************************/
-		Atom *N = new Atom();
-		N->setResidueName("ALA");
-		//N->setName("N");
-		N->setName(Nname);
-		N->setElement("N");
-		N->setResidueNumber(i+1);
-		N->setChainId("A");
-
-		double Nphase = _phi1+ 0.555;
-		double nR1 = _r1 + -0.75;
-		double corr = -1.015;
-
-
-		generateNorthCoor(N, i, nR1, wa, Nphase, _r0, _pitch, _risePerRes, L, corr, zCenter);
-
-
-		/***************************
-		 * C-alpha placement
-		 ***************************/
-		Atom *CA = new Atom();
-		CA->setResidueName("ALA");
-		//CA->setName("CA");
-		CA->setName(CAname);
-		CA->setElement("C");
-		CA->setResidueNumber(i+1);
-		CA->setChainId("A");
-
-		corr = 0;
-
-
-		generateNorthCoor(CA, i, _r1, wa, _phi1, _r0, _pitch, _risePerRes, L, corr, zCenter);
-
-		/***************************
-		 * Carbonyl Carbon placement
-		 ***************************/
-		Atom *C = new Atom();
-		C->setResidueName("ALA");
-		//C->setName("C");
-		C->setName(Cname);
-		C->setElement("C");
-		C->setResidueNumber(i+1);
-		C->setChainId("A");
-
-		double Cphase = _phi1+ -0.71;
-		double cR1 = _r1 + -0.54;
-		corr = 1.19;
-
-
-		generateNorthCoor(C, i, cR1, wa, Cphase, _r0, _pitch, _risePerRes, L, corr, zCenter);
-
-		/***************************
-		 * Carbonyl Oxygen placement
-		 ***************************/
-		Atom *O = new Atom();
-		O->setResidueName("ALA");
-		//O->setName("O");
-		O->setName(Oname);
-		O->setElement("O");
-		O->setResidueNumber(i+1);
-		O->setChainId("A");
-
-		double Ophase = _phi1+ -2.092;
-		double oR1 = _r1 + -0.18;
-		corr = 2.512;
-
-
-		generateNorthCoor(O, i, oR1, wa, Ophase, _r0, _pitch, _risePerRes, L, corr, zCenter);
-
-
-		/***************************
-		 * Add Atoms to atoms 
-		 ***************************/
-		atoms.push_back(N);
-		atoms.push_back(CA);
-		atoms.push_back(C);
-		atoms.push_back(O);
-
-		N = CA = C = O = NULL;
+	// one pass per backbone atom type
+	for (unsigned int k = 0; k < 4; k++) {
+		generateNorthCoor(_xyz + 3*k, _nRes, _r1 + backboneOffsets[k][0], wa, _phi1 + backboneOffsets[k][1], _r0, _pitch, _risePerRes, L, backboneOffsets[k][2], zCenter);
 	}
 
 	/***************************
 	 * Rotate to X-axis 
 	 **************************/
-	Transforms tr;
 	double angle = 0;
 	double x = _r0 * cos( ((double)(_nRes)/2.0) *(t));
 	double y = _r0 * sin( ((double)(_nRes)/2.0) *(t));
@@ -342,19 +388,163 @@ void CoiledCoils::radCoiledCoil(double _r0, double _risePerRes, double _pitch, d
 	angle = CartesianGeometry::angle(CartesianPoint(x,y,0.0) , CartesianPoint(0.0,0.0,0.0), CartesianPoint(1.0,0.0,0.0));
 	Matrix rotMat = CartesianGeometry::getRotationMatrix(quad*angle, CartesianPoint(0.0,0.0,1.0));
 
-	tr.rotate(atoms, rotMat);
+	RigidTransform(rotMat).apply(_xyz, 4 * _nRes);
+}
+
+void CoiledCoils::radCoiledCoilGradient(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, int _nRes, const double * _xyz, double ** _grad) const {
+
+	/***************************
+	 * Derivatives of the coordinates of the
+	 * first helix (_xyz, already rotated to
+	 * the X-axis) with respect to r0, rise
+	 * per residue, pitch, r1, w1 and phi1
+	 * (angles in radians), in _grad[0..5].
+	 *
+	 * With t = -h/L and wa = -w1*L/h the
+	 * helical angle b = a*wa + phi is
+	 * w1*i + corr + phi for every atom, and
+	 * a = t*(i + corr/w1)
+	 ***************************/
+	double n = (double)_nRes;
+	double twoPi = 2*M_PI;
+	double L = sqrt(pow(_r0,2)+pow((_pitch /twoPi),2));
+	double t = _risePerRes / (-L);
+	double S = sqrt(pow((twoPi*_r0),2)+pow(_pitch,2));
+	double S3 = S*S*S;
+	double k = _pitch/S;
+	double m = twoPi*_r0/S;
+
+	// derivatives of L, t, k, m (index of the parameter as in _grad)
+	double dL[3] = {_r0/L, 0.0, _pitch/(twoPi*twoPi*L)};
+	double dt[3] = {-t/L*dL[0], -1.0/L, -t/L*dL[2]};
+	double dk[3] = {-twoPi*twoPi*_r0*_pitch/S3, 0.0, twoPi*twoPi*_r0*_r0/S3};
+	double dm[3] = {twoPi*_pitch*_pitch/S3, 0.0, -twoPi*_r0*_pitch/S3};
+
+	// the rotation to the X-axis (by -n*t/2) and its derivative
+	double cosR = cos(n*t/2.0);
+	double sinR = sin(n*t/2.0);
+	double dPsi[3];
+	for (unsigned int p = 0; p < 3; p++) {
+		dPsi[p] = -n/2.0 * dt[p];
+	}
+
+	// zCenter = -(pitch * (-t*n/2pi) + r1 * m * sin(n*w1 + phi1)) / 2
+	double sinC = sin(n*_w1 + _phi1);
+	double cosC = cos(n*_w1 + _phi1);
+	double dzCenter[6];
+	dzCenter[0] = -(-_pitch*n/twoPi*dt[0] + _r1*sinC*dm[0]) / 2;
+	dzCenter[1] = -(-_pitch*n/twoPi*dt[1]) / 2;
+	dzCenter[2] = -(-t*n/twoPi - _pitch*n/twoPi*dt[2] + _r1*sinC*dm[2]) / 2;
+	dzCenter[3] = -(m*sinC) / 2;
+	dzCenter[4] = -(_r1*m*cosC*n) / 2;
+	dzCenter[5] = -(_r1*m*cosC) / 2;
+
+	for (unsigned int type = 0; type < 4; type++) {
+		double r1 = _r1 + backboneOffsets[type][0];
+		double phi = _phi1 + backboneOffsets[type][1];
+		double corr = backboneOffsets[type][2];
+		for (unsigned int i = 0; i < _nRes; i++) {
+			unsigned int offset = 12*i + 3*type;
+			double X = _xyz[offset];
+			double Y = _xyz[offset+1];
+
+			double q = i + corr/_w1;
+			double a = t*q;
+			double b = _w1*i + corr + phi;
+			double cosA = cos(a);
+			double sinA = sin(a);
+			double cosB = cos(b);
+			double sinB = sin(b);
+
+			// derivatives before the rotation to the X-axis (x and y, the z is not rotated)
+			double dB[3]  = {-r1*cosA*sinB - r1*k*sinA*cosB, -r1*sinA*sinB + r1*k*cosA*cosB, r1*m*cosB};
+			double dK[2]  = {-r1*sinA*sinB, r1*cosA*sinB};
+			double dR1[3] = {cosA*cosB - k*sinA*sinB, sinA*cosB + k*cosA*sinB, m*sinB};
+
+			// da/dp for r0, h, pitch and w1
+			double da[3];
+			for (unsigned int p = 0; p < 3; p++) {
+				da[p] = q*dt[p];
+			}
+			double daW1 = t*(-corr/(_w1*_w1));
+
+			// r0, h, pitch: along a (dx/da = -y, dy/da = x, the same as the rotation), k, m
+			for (unsigned int p = 0; p < 3; p++) {
+				double rawX = dK[0]*dk[p];
+				double rawY = dK[1]*dk[p];
+				if (p == 0) {
+					rawX += cosA;
+					rawY += sinA;
+				}
+				double * pGrad = _grad[p] + offset;
+				pGrad[0] = cosR*rawX + sinR*rawY - Y*(da[p] + dPsi[p]);
+				pGrad[1] = -sinR*rawX + cosR*rawY + X*(da[p] + dPsi[p]);
+				pGrad[2] = -_pitch/twoPi*da[p] + r1*sinB*dm[p] + dzCenter[p];
+				if (p == 2) {
+					pGrad[2] += -a/twoPi;
+				}
+			}
+
+			// r1
+			double * pGrad = _grad[3] + offset;
+			pGrad[0] = cosR*dR1[0] + sinR*dR1[1];
+			pGrad[1] = -sinR*dR1[0] + cosR*dR1[1];
+			pGrad[2] = dR1[2] + dzCenter[3];
+
+			// w1: through b (db/dw1 = i) and a
+			pGrad = _grad[4] + offset;
+			pGrad[0] = i*(cosR*dB[0] + sinR*dB[1]) - Y*daW1;
+			pGrad[1] = i*(-sinR*dB[0] + cosR*dB[1]) + X*daW1;
+			pGrad[2] = i*dB[2] - _pitch/twoPi*daW1 + dzCenter[4];
+
+			// phi1: through b only
+			pGrad = _grad[5] + offset;
+			pGrad[0] = cosR*dB[0] + sinR*dB[1];
+			pGrad[1] = -sinR*dB[0] + cosR*dB[1];
+			pGrad[2] = dB[2] + dzCenter[5];
+		}
+	}
 }
 
 
-void CoiledCoils::generateNorthCoor(Atom * _pAtom, unsigned int i, double _r1, double _wa, double _phi1, double _r0, double _pitch, double _risePerRes, double _L, double _corr, double _zCenter){
+void CoiledCoils::generateNorthCoor(double * _xyz, unsigned int _nRes, double _r1, double _wa, double _phi1, double _r0, double _pitch, double _risePerRes, double _L, double _corr, double _zCenter) const {
 
+	/***************************
+	 * Places one atom type in all residues
+	 * (every 4th atom of the packed _xyz).
+	 * The sines and cosines are computed 
+	 * first on contiguous arrays, then
+	 * combined with the factors that 
+	 * do not depend on the residue
+	 ***************************/
 	double t = (_risePerRes/(-_L));
 	double _c2 = _corr / _wa;
+	double sqrtTerm = sqrt(pow((2*M_PI*_r0),2)+pow(_pitch,2));
+	double pitchFactor = _r1*(_pitch/sqrtTerm);
+	double radiusFactor = _r1*(2*M_PI*_r0/sqrtTerm);
+
+	vector<double> trig(5 * _nRes);
+	double * a = &trig[0];
+	double * cosA = a + _nRes;
+	double * sinA = cosA + _nRes;
+	double * cosB = sinA + _nRes;
+	double * sinB = cosB + _nRes;
+	for (unsigned int i = 0; i < _nRes; i++) {
+		a[i] = t*i+_c2;
+	}
+	for (unsigned int i = 0; i < _nRes; i++) {
+		cosA[i] = cos(a[i]);
+		sinA[i] = sin(a[i]);
+	}
+	for (unsigned int i = 0; i < _nRes; i++) {
+		cosB[i] = cos(a[i]*_wa + _phi1);
+		sinB[i] = sin(a[i]*_wa + _phi1);
+	}
 
-	double x = _r0*cos((t*i+_c2))           +   _r1*cos((t*i+_c2))*cos((t*i+_c2)*_wa + _phi1)      -   _r1*(_pitch/sqrt(pow((2*M_PI*_r0),2)+pow(_pitch,2)))*sin((t*i+_c2))*sin((t*i+_c2)*_wa + _phi1);
-	double y = _r0*sin((t*i+_c2))           +   _r1*sin((t*i+_c2))*cos((t*i+_c2)*_wa + _phi1)      +   _r1*(_pitch/sqrt(pow((2*M_PI*_r0),2)+pow(_pitch,2)))*cos((t*i+_c2))*sin((t*i+_c2)*_wa + _phi1);
-	double z = _pitch*(-(t*i+_c2)/(2*M_PI)) +   _r1*(2*M_PI*_r0/sqrt(pow((2*M_PI*_r0),2) + pow(_pitch,2)))*sin((t*i+_c2)*_wa + _phi1)    +   _zCenter;
-
-	_pAtom->setCoor(x,y,z);	
+	for (unsigned int i = 0; i < _nRes; i++) {
+		double * pCoor = _xyz + 12 * i;
+		pCoor[0] = _r0*cosA[i]           +   _r1*cosA[i]*cosB[i]      -   pitchFactor*sinA[i]*sinB[i];
+		pCoor[1] = _r0*sinA[i]           +   _r1*sinA[i]*cosB[i]      +   pitchFactor*cosA[i]*sinB[i];
+		pCoor[2] = _pitch*(-a[i]/(2*M_PI)) +   radiusFactor*sinB[i]    +   _zCenter;
+	}
 }
-
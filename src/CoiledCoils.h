@@ -107,6 +107,26 @@ class CoiledCoils {
 
 		AtomPointerVector& getAtomPointers();
 
+		/*
+		  Closed form generation of the backbone without creating any atom: the N, CA, C
+		  and O atoms of each residue are written as packed x,y,z coordinates in _xyz
+		  (4 * _nRes atoms per helix, 12 doubles per residue), in the same order and with
+		  the same coordinates of the atoms of getCoiledCoil and getCoiledCoilBundle
+		  (helix after helix, the chains would be A, B, C...).  The symmetry copies are
+		  obtained by rotating the first helix.
+		 */
+		void getCoiledCoilCoordinates(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes, std::vector<double> & _xyz) const;
+		bool getCoiledCoilBundleCoordinates(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes,  std::string _symmetry, int _N, std::vector<double> & _xyz) const;
+		/*
+		  Same coordinates with their analytic derivatives: _gradient[p] has the derivative
+		  of every coordinate of _xyz with respect to the parameter p, in the order r0,
+		  risePerRes, pitch, r1, w1 and phi1 (per degree for w1 and phi1; dZ does not
+		  move the atoms)
+		 */
+		bool getCoiledCoilBundleGradient(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes,  std::string _symmetry, int _N, std::vector<double> & _xyz, std::vector<std::vector<double> > & _gradient) const;
+		// apply the backbone coordinates of a bundle (as from getCoiledCoilBundleCoordinates) to the system
+		bool setSystemToBundleCoordinates(const std::vector<double> & _xyz, int _nRes, std::string _symmetry, int _N, System& _sys, std::vector<std::string> _startingPositions);
+
 		void setBackboneAtomNames(std::string _CAname, std::string _Nname, std::string _Cname, std::string _Oname); // Defaults CA N C O
 
 		/*
@@ -127,6 +147,10 @@ class CoiledCoils {
 		//System *sys;
 
 		void radCoiledCoil(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes);
+		void radCoiledCoilCoordinates(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, double _dZ, int _nRes, double * _xyz) const;
+		void createAtoms(const std::vector<double> & _xyz, int _nRes);
+		void radCoiledCoilGradient(double _r0, double _risePerRes, double _pitch, double _r1, double _w1, double _phi1, int _nRes, const double * _xyz, double ** _grad) const;
+		void applyBundleSymmetry(std::vector<double> & _xyz, int _nRes, bool _dihedral, int _N) const;
 
 		std::string CAname;
 		std::string Nname;
@@ -143,7 +167,7 @@ class CoiledCoils {
 		//std::vector<double> npP0;
 		//std::vector<int> npParamFuncs;
 		
-		void generateNorthCoor(Atom *_pAtom, unsigned int i, double _r1, double _wa, double _phi1, double _r0, double _pitch, double _risePerRes, double _L, double _corr, double _zCenter); 
+		void generateNorthCoor(double * _xyz, unsigned int _nRes, double _r1, double _wa, double _phi1, double _r0, double _pitch, double _risePerRes, double _L, double _corr, double _zCenter) const; 
 		AtomPointerVector atoms;
 		//void generateGevorgCoor(Atom *_pAtom, unsigned int i, double _r0, double _w0, double _a, double _r1, double _w1, double _p1, double _dZ, int _nRes);
 		//void generateGevorgCoor(Atom *_pAtom, unsigned int i, double _r0, double _w0, double _a, double _r1, double _w1, double _phi1, double _dZ, double _corr, double _wa, double _zCenter);
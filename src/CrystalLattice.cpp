@@ -27,6 +27,8 @@ You should have received a copy of the GNU Lesser General Public
 ----------------------------------------------------------------------------
 */
 #include "CrystalLattice.h"
+#include "RigidTransform.h"
+#include "CellList.h"
 
 using namespace MSL;
 using namespace std;
@@ -85,24 +87,12 @@ vector<AtomPointerVector *> CrystalLattice::generateCrystal(bool (*inContact)(At
 
 
 	// Store starting structure
-	AtomPointerVector *ats = new AtomPointerVector(pin.getAtomPointers()); // note, this creates a new vector, but not new atoms!
-	//ats->updateGeometricCenter();
-	crystalUnits["orig"] = ats;
+	AtomPointerVector *ats = getOriginalUnit();
 	vector<AtomPointerVector*> newUnits;
 	vector<CartesianPoint> newUnitCentroids;
 
 	// Invert the Scale Matrix to go from fractional to ortho..
-	Matrix scaleMatInv(3,3,0.0);
-	double det=scaleMat[0][0]*(scaleMat[1][1]*scaleMat[2][2]-scaleMat[2][1]*scaleMat[1][2])-scaleMat[0][1]*(scaleMat[1][0]*scaleMat[2][2]-scaleMat[1][2]*scaleMat[2][0])+scaleMat[0][2]*(scaleMat[1][0]*scaleMat[2][1]-scaleMat[1][1]*scaleMat[2][0]);//adjoin
-    	scaleMatInv[0][0]=(scaleMat[1][1]*scaleMat[2][2]-scaleMat[2][1]*scaleMat[1][2])/det;
-    	scaleMatInv[0][1]=-(scaleMat[1][0]*scaleMat[2][2]-scaleMat[1][2]*scaleMat[2][0])/det;
-    	scaleMatInv[0][2]=(scaleMat[1][0]*scaleMat[2][1]-scaleMat[2][0]*scaleMat[1][1])/det;
-    	scaleMatInv[1][0]=-(scaleMat[0][1]*scaleMat[2][2]-scaleMat[0][2]*scaleMat[2][1])/det;
-    	scaleMatInv[1][1]=(scaleMat[0][0]*scaleMat[2][2]-scaleMat[0][2]*scaleMat[2][0])/det;
-    	scaleMatInv[1][2]=-(scaleMat[0][0]*scaleMat[2][1]-scaleMat[2][0]*scaleMat[0][1])/det;
-    	scaleMatInv[2][0]=(scaleMat[0][1]*scaleMat[1][2]-scaleMat[0][2]*scaleMat[1][1])/det;
-    	scaleMatInv[2][1]=-(scaleMat[0][0]*scaleMat[1][2]-scaleMat[1][0]*scaleMat[0][2])/det;
-    	scaleMatInv[2][2]=(scaleMat[0][0]*scaleMat[1][1]-scaleMat[1][0]*scaleMat[0][1])/det;
+	Matrix scaleMatInv = getFractionalToOrthogonal(scaleMat);
 
 	Transforms tr;
 	// For each symmetry matrix generate +/- 1 Unit Cell (unless asked to generate all units in contact with the original)
@@ -162,6 +152,7 @@ vector<AtomPointerVector *> CrystalLattice::generateCrystal(bool (*inContact)(At
 			
 								// Store atoms under approriate key
 								if (crystalUnits.find(key) != crystalUnits.end()) deleteAtoms(crystalUnits[key]);
+								unitCoordinates.erase(key);
 								AtomPointerVector *newAts = new AtomPointerVector(); copyAtoms(tmpAts, newAts);
 								crystalUnits[key] = newAts;
 								newUnits.push_back(newAts);
@@ -214,6 +205,203 @@ vector<AtomPointerVector *> CrystalLattice::generateCrystal(bool (*inContact)(At
 		
 }
 
+vector<string> CrystalLattice::generateContactingUnits(double _distance) {
+
+	vector<string> keys;
+
+	// forget the units of a previous call, and the atoms created for them
+	for (map<string, vector<double> >::iterator k = unitCoordinates.begin(); k != unitCoordinates.end(); k++) {
+		map<string, AtomPointerVector *>::iterator found = crystalUnits.find(k->first);
+		if (found != crystalUnits.end()) {
+			deleteAtoms(found->second);
+			crystalUnits.erase(found);
+		}
+	}
+	unitCoordinates.clear();
+
+	// Read PDB file if haven't already.
+	if (pdbFile != "" && !pdbFileRead){
+		readPdb();
+	}
+
+	Matrix &scaleMat                    = pin.getScaleRotation();
+	vector<Matrix  *> &symMats          = pin.getSymmetryRotations();
+	vector<CartesianPoint  *> &symTrans = pin.getSymmetryTranslations();
+
+	if (symMats.size() == 0){
+		cerr << "ERROR 1915 CrystalLattice::generateContactingUnits() PDB file missing SCALE and/or REMARK 290, which are required in MSL for crystal lattice generation\n";
+		return keys;
+	}
+	if (_distance <= 0.0) {
+		cerr << "ERROR 1916 CrystalLattice::generateContactingUnits() the contact distance must be positive (" << _distance << ")\n";
+		return keys;
+	}
+
+	AtomPointerVector *ats = getOriginalUnit();
+	unsigned int n = ats->size();
+	if (n == 0) {
+		return keys;
+	}
+	Matrix scaleMatInv = getFractionalToOrthogonal(scaleMat);
+
+	/**********************************************************************
+	 *  Packed coordinates of the original unit, its bounding box and
+	 *  bounding sphere (around the geometric center)
+	 **********************************************************************/
+	vector<double> orig(3 * n);
+	double center[3] = {0.0, 0.0, 0.0};
+	double boxMin[3];
+	double boxMax[3];
+	for (unsigned int i = 0; i < n; i++) {
+		for (unsigned int k = 0; k < 3; k++) {
+			orig[3*i+k] = (*ats)[i]->getCoor()[k];
+			center[k] += orig[3*i+k];
+			if (i == 0 || orig[3*i+k] < boxMin[k]) boxMin[k] = orig[3*i+k];
+			if (i == 0 || orig[3*i+k] > boxMax[k]) boxMax[k] = orig[3*i+k];
+		}
+	}
+	for (unsigned int k = 0; k < 3; k++) {
+		center[k] /= n;
+	}
+	double radius2 = 0.0;
+	for (unsigned int i = 0; i < n; i++) {
+		double d2 = 0.0;
+		for (unsigned int k = 0; k < 3; k++) {
+			d2 += (orig[3*i+k] - center[k]) * (orig[3*i+k] - center[k]);
+		}
+		radius2 = max(radius2, d2);
+	}
+	CartesianPoint origCenter(center[0], center[1], center[2]);
+	// two units can contact only if their centers are closer than this
+	double reach = 2 * sqrt(radius2) + _distance;
+
+	/**********************************************************************
+	 *  Cell list of the original unit: cells at least as large as the
+	 *  contact distance, so that only the surrounding cells need to be
+	 *  checked for each atom of a symmetry mate
+	 **********************************************************************/
+	CellList grid(orig, _distance);
+	vector<unsigned int> cells;
+
+	double distance2 = _distance * _distance;
+	vector<double> xyz(3 * n);
+	vector<CartesianPoint> centroids(1, origCenter); // the original and the units generated so far
+
+	for (uint i = 0; i < symMats.size(); i++) {
+
+		// the same operations of generateCrystal
+		RigidTransform toOrigin(*symTrans[i] * -1);
+		RigidTransform symRotation(*symMats[i]);
+		CartesianPoint symCenter(origCenter);
+		toOrigin.apply(symCenter);
+		symRotation.apply(symCenter);
+
+		/**********************************************************************
+		 *  Range of unit cell translations that can bring the center within
+		 *  reach: the fractional coordinates of a sphere of radius reach
+		 *  span +/- reach times the norm of each row of the SCALE matrix
+		 **********************************************************************/
+		CartesianPoint diff = origCenter - symCenter;
+		int range[3][2];
+		for (unsigned int k = 0; k < 3; k++) {
+			double fract = scaleMat[k][0] * diff.getX() + scaleMat[k][1] * diff.getY() + scaleMat[k][2] * diff.getZ();
+			double width = reach * sqrt(scaleMat[k][0] * scaleMat[k][0] + scaleMat[k][1] * scaleMat[k][1] + scaleMat[k][2] * scaleMat[k][2]);
+			range[k][0] = (int)floor(fract - width);
+			range[k][1] = (int)ceil(fract + width);
+		}
+
+		for (int a = range[0][0]; a <= range[0][1]; a++) {
+			for (int b = range[1][0]; b <= range[1][1]; b++) {
+				for (int c = range[2][0]; c <= range[2][1]; c++) {
+
+					CartesianPoint translateP = CartesianGeometry::matrixTransposeTimesCartesianPoint(CartesianPoint(a,b,c), scaleMatInv);
+					CartesianPoint unitCenter = symCenter + translateP;
+					if (unitCenter.distance(origCenter) > reach) {
+						continue;
+					}
+					// crystal units should not overlap, 1.0 A is a conservative cutoff (as in generateCrystal)
+					bool redundant = false;
+					for (unsigned int pi = 0; pi < centroids.size(); pi++) {
+						if (centroids[pi].distance(unitCenter) < 1.0) {
+							redundant = true;
+							break;
+						}
+					}
+					if (redundant) {
+						continue;
+					}
+
+					// transformed coordinates, checked against the grid
+					copy(orig.begin(), orig.end(), xyz.begin());
+					toOrigin.apply(&xyz[0], n);
+					symRotation.apply(&xyz[0], n);
+					RigidTransform(translateP).apply(&xyz[0], n);
+
+					bool contact = false;
+					for (unsigned int j = 0; j < n && !contact; j++) {
+						const double * p = &xyz[3*j];
+						if (p[0] < boxMin[0] - _distance || p[0] > boxMax[0] + _distance ||
+						    p[1] < boxMin[1] - _distance || p[1] > boxMax[1] + _distance ||
+						    p[2] < boxMin[2] - _distance || p[2] > boxMax[2] + _distance) {
+							continue;
+						}
+						grid.getNeighborCells(p, cells);
+						for (unsigned int g = 0; g < cells.size() && !contact; g++) {
+							for (unsigned int m = grid.getFirstPoint(cells[g]); m != grid.size(); m = grid.getNextPoint(m)) {
+								const double * q = &orig[3*m];
+								double d2 = (p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) + (p[2]-q[2])*(p[2]-q[2]);
+								if (d2 <= distance2) {
+									contact = true;
+									break;
+								}
+							}
+						}
+					}
+					if (!contact) {
+						continue;
+					}
+
+					// Store coordinates under approriate key
+					char key[80];
+					sprintf(key,"%02d%02d%02d%02d",i,a,b,c);
+					if (crystalUnits.find(key) != crystalUnits.end()) {
+						deleteAtoms(crystalUnits[key]);
+						crystalUnits.erase(key);
+					}
+					unitCoordinates[key] = xyz;
+					keys.push_back(key);
+					centroids.push_back(unitCenter);
+				}
+			}
+		}
+	}
+
+	return keys;
+}
+
+AtomPointerVector* CrystalLattice::getCrystalUnit(string _unit) {
+	map<string, AtomPointerVector *>::iterator found = crystalUnits.find(_unit);
+	if (found != crystalUnits.end()) {
+		return found->second;
+	}
+
+	// create the atoms of a unit generated by generateContactingUnits
+	map<string, vector<double> >::iterator coor = unitCoordinates.find(_unit);
+	if (coor == unitCoordinates.end()) {
+		return NULL;
+	}
+	AtomPointerVector *ats = getOriginalUnit();
+	AtomPointerVector *newAts = new AtomPointerVector();
+	const vector<double> & xyz = coor->second;
+	for (uint i = 0; i < ats->size(); i++) {
+		Atom * pAtom = new Atom(*(*ats)[i]);
+		pAtom->setCoor(xyz[3*i], xyz[3*i+1], xyz[3*i+2]);
+		newAts->push_back(pAtom);
+	}
+	crystalUnits[_unit] = newAts;
+	return newAts;
+}
+
 void CrystalLattice::writeCrystalUnits(string _pathAndPrefix,bool _closeContactsOnly,bool _singleFile, string _renameChainsExcept,bool _nmrStyleFile){
 
 	// sqrt3 * largest dimension should be length of diagnol (worse case)?
@@ -232,6 +420,11 @@ void CrystalLattice::writeCrystalUnits(string _pathAndPrefix,bool _closeContacts
 
 	AtomPointerVector *ats = it->second;
 
+	// create the atoms of the units that have only coordinates
+	for (map<string, vector<double> >::iterator k = unitCoordinates.begin(); k != unitCoordinates.end(); k++) {
+		getCrystalUnit(k->first);
+	}
+
 	// For each crystal unit we have
 	int numUnitsPrinted = 1;
 
@@ -332,6 +525,33 @@ void CrystalLattice::copyCoordinates(AtomPointerVector * _atoms, AtomPointerVect
 	}
 }
 
+AtomPointerVector * CrystalLattice::getOriginalUnit() {
+	map<string, AtomPointerVector *>::iterator found = crystalUnits.find("orig");
+	if (found != crystalUnits.end()) {
+		return found->second;
+	}
+	AtomPointerVector *ats = new AtomPointerVector(pin.getAtomPointers()); // note, this creates a new vector, but not new atoms!
+	crystalUnits["orig"] = ats;
+	return ats;
+}
+
+Matrix CrystalLattice::getFractionalToOrthogonal(Matrix & _scaleMat) {
+	// Invert the Scale Matrix to go from fractional to ortho (transposed, see matrixTransposeTimesCartesianPoint)
+	Matrix &scaleMat = _scaleMat;
+	Matrix scaleMatInv(3,3,0.0);
+	double det=scaleMat[0][0]*(scaleMat[1][1]*scaleMat[2][2]-scaleMat[2][1]*scaleMat[1][2])-scaleMat[0][1]*(scaleMat[1][0]*scaleMat[2][2]-scaleMat[1][2]*scaleMat[2][0])+scaleMat[0][2]*(scaleMat[1][0]*scaleMat[2][1]-scaleMat[1][1]*scaleMat[2][0]);//adjoin
+    	scaleMatInv[0][0]=(scaleMat[1][1]*scaleMat[2][2]-scaleMat[2][1]*scaleMat[1][2])/det;
+    	scaleMatInv[0][1]=-(scaleMat[1][0]*scaleMat[2][2]-scaleMat[1][2]*scaleMat[2][0])/det;
+    	scaleMatInv[0][2]=(scaleMat[1][0]*scaleMat[2][1]-scaleMat[2][0]*scaleMat[1][1])/det;
+    	scaleMatInv[1][0]=-(scaleMat[0][1]*scaleMat[2][2]-scaleMat[0][2]*scaleMat[2][1])/det;
+    	scaleMatInv[1][1]=(scaleMat[0][0]*scaleMat[2][2]-scaleMat[0][2]*scaleMat[2][0])/det;
+    	scaleMatInv[1][2]=-(scaleMat[0][0]*scaleMat[2][1]-scaleMat[2][0]*scaleMat[0][1])/det;
+    	scaleMatInv[2][0]=(scaleMat[0][1]*scaleMat[1][2]-scaleMat[0][2]*scaleMat[1][1])/det;
+    	scaleMatInv[2][1]=-(scaleMat[0][0]*scaleMat[1][2]-scaleMat[1][0]*scaleMat[0][2])/det;
+    	scaleMatInv[2][2]=(scaleMat[0][0]*scaleMat[1][1]-scaleMat[1][0]*scaleMat[0][1])/det;
+	return scaleMatInv;
+}
+
 void CrystalLattice::deleteAtoms(AtomPointerVector * _atoms) {
 	for (int i = 0; i < _atoms->size(); i++) {
 		delete((*_atoms)[i]);
@@ -55,7 +55,20 @@ class CrystalLattice {
 		void setPdbFile(std::string _pdbFile);
 
 		std::vector<AtomPointerVector*> generateCrystal(bool (*inContact)(AtomPointerVector*, AtomPointerVector*) = NULL);
-		AtomPointerVector* getCrystalUnit(std::string _unit);
+
+		/*
+		  Generates only the units that have at least one atom within _distance of an atom of
+		  the original unit (the original itself is not a neighbor), returning their keys.
+		  The translations are limited by the bounding spheres of the units, and the atoms
+		  are tested on a grid over the original unit without creating any atom: only the
+		  transformed coordinates of the contacting units are stored (packed x,y,z in the
+		  order of the original atoms).  The atoms of a unit are created by getCrystalUnit
+		  (and by writeCrystalUnits) when requested
+		 */
+		std::vector<std::string> generateContactingUnits(double _distance);
+		const std::vector<double> * getCrystalUnitCoordinates(std::string _unit) const; // NULL if not generated
+
+		AtomPointerVector* getCrystalUnit(std::string _unit); // NULL if not generated
 
 		void writeCrystalUnits(std::string _pathAndPrefix, bool closeContactsOnly=true, bool singleFile=false, std::string _renameChains="", bool _nmrStyleFile=false);
 		
@@ -65,6 +78,8 @@ class CrystalLattice {
 		void copyAtoms(AtomPointerVector * _atoms, AtomPointerVector *newAts);
 		void copyCoordinates(AtomPointerVector * _atoms, AtomPointerVector *newAts);
 		void deleteAtoms(AtomPointerVector * _atoms);
+		AtomPointerVector * getOriginalUnit();
+		Matrix getFractionalToOrthogonal(Matrix & _scaleMat);
 
 		std::string pdbFile;
 		bool pdbFileRead;
@@ -72,13 +87,17 @@ class CrystalLattice {
 		PDBReader pin;
 		PDBWriter pout;
 		std::map<std::string, AtomPointerVector *> crystalUnits;
+		std::map<std::string, std::vector<double> > unitCoordinates; // units from generateContactingUnits
 
 
 };
 
 inline std::string CrystalLattice::getPdbFile() { return pdbFile; }
 inline void CrystalLattice::setPdbFile(std::string _pdbFile) { pdbFile = _pdbFile; }
-inline AtomPointerVector* CrystalLattice::getCrystalUnit(std::string _unit) { return crystalUnits[_unit]; }
+inline const std::vector<double> * CrystalLattice::getCrystalUnitCoordinates(std::string _unit) const {
+	std::map<std::string, std::vector<double> >::const_iterator found = unitCoordinates.find(_unit);
+	return found == unitCoordinates.end() ? NULL : &found->second;
+}
 }
 
 #endif
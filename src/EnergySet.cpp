@@ -310,6 +310,38 @@ void EnergySet::saveEnergySubset(string _subsetName, string _selection1, string
 	}
 }
 
+void EnergySet::saveEnergySubset(string _subsetName, const vector<Atom*> & _atoms) {
+	/*********************************************************
+	 *  Save the interactions that involve any of the atoms,
+	 *  i.e. the energy that changes when the atoms move
+	 *  (calcEnergyOfSubset before and after a move gives
+	 *  the local energy difference)
+	 *********************************************************/
+	set<Atom*> atoms(_atoms.begin(), _atoms.end());
+	energyTermsSubsets[_subsetName].clear(); // reset the subset if existing
+	for (map<string, vector<Interaction*> >::iterator k=energyTerms.begin(); k!=energyTerms.end(); k++) {
+		// for all the terms
+		if (activeEnergyTerms.find(k->first) == activeEnergyTerms.end() || !activeEnergyTerms[k->first]) {
+			// inactive term, don't calculate it
+			continue;
+		}
+		for (vector<Interaction*>::const_iterator l=k->second.begin(); l!=k->second.end(); l++) {
+			// for all the interactions
+			if (!(*l)->isActive() || (checkForCoordinates_flag && !(*l)->atomsHaveCoordinates())) {
+				continue;
+			}
+			vector<Atom*> & pAtoms = (*l)->getAtomPointers();
+			for (vector<Atom*>::iterator m=pAtoms.begin(); m!=pAtoms.end(); m++) {
+				if (atoms.find(*m) != atoms.end()) {
+					// add the interaction to the subset
+					energyTermsSubsets[_subsetName][k->first].push_back(*l);
+					break;
+				}
+			}
+		}
+	}
+}
+
 /*   FUNCTIONS FOR ENERGY CALCULATION: DONE   */
 
 string EnergySet::getSummary(unsigned int _precision) const{
@@ -375,6 +407,11 @@ double EnergySet::getTermEnergy(string _name) const {
 
 
 double EnergySet::calcEnergyAndEnergyGradient(vector<double> &_gradients){
+	// the vector must already be sized to 3 * (number of minimized atoms)
+	return calcEnergyAndEnergyGradient(_gradients.empty() ? NULL : &_gradients[0]);
+}
+
+double EnergySet::calcEnergyAndEnergyGradient(double * _gradients){
 	
 	// TODO: should we use term weights in minimization?
 	// For each interaction
@@ -383,7 +420,8 @@ double EnergySet::calcEnergyAndEnergyGradient(vector<double> &_gradients){
 
 
 		// Only compute active energy terms
-		if (activeEnergyTerms.find(k->first) == activeEnergyTerms.end() || !activeEnergyTerms[k->first]) {
+		map<string, bool>::const_iterator active = activeEnergyTerms.find(k->first);
+		if (active == activeEnergyTerms.end() || !active->second) {
 			// inactive term
 			continue;
 		}
@@ -396,29 +434,33 @@ double EnergySet::calcEnergyAndEnergyGradient(vector<double> &_gradients){
 			if ((*l)->isActive()){  
 
 				vector<Atom *> &ats = (*l)->getAtomPointers();
-				/*
-				cout << "Calculating gradient of "<<(*l)->getName()<<endl;
-				for (uint a = 0; a < ats.size();a++){
-					cout << "\t"<<ats[a]->toString()<<endl;
-				}
-				*/
-				// TODO: combine partialDerivative and getEnergy with the gradients into a single function
-				//cout << "Partials: "<<partials.first<<" "<<partials.second.size()<<endl;
-				vector<double> gradient;
-				double e  = (*l)->getEnergy(&gradient);
+				unsigned int localSize = 3 * ats.size();
+
+				// clear() keeps the capacity, so the resize(n,0) done by the
+				// interactions only zeroes the entries without reallocating
+				gradientScratch.clear();
+				double e  = (*l)->getEnergy(&gradientScratch);
 				energy += e;
 
+				// some terms (EEF1, IMM1, Scwrl4HBond) do not fill the whole
+				// 3 * natoms block, pad with zeros instead of reading past the end
+				if (gradientScratch.size() < localSize) {
+					gradientScratch.resize(localSize, 0.0);
+				}
+				const double * gradient = &gradientScratch[0];
+
 				for (uint a = 0; a < ats.size();a++){
 					
-					if (ats[a]->getMinimizationIndex() == -1){
+					int minIndex = ats[a]->getMinimizationIndex();
+					if (minIndex == -1){
 						continue;
 					}
-					int fullGradIndex = 3*ats[a]->getMinimizationIndex();
-					int localGradIndex = 3*(a+1);
+					double * full = _gradients + 3 * (minIndex - 1);
+					const double * local = gradient + 3 * a;
 					
-					_gradients[fullGradIndex-3] += gradient[localGradIndex-3];
-					_gradients[fullGradIndex-2] += gradient[localGradIndex-2];
-					_gradients[fullGradIndex-1] += gradient[localGradIndex-1];
+					full[0] += local[0];
+					full[1] += local[1];
+					full[2] += local[2];
 
 				}
 			}
@@ -107,6 +107,15 @@ class EnergySet {
 
 		void calcEnergyGradient(std::vector<double> &_gradients);
 		double calcEnergyAndEnergyGradient(std::vector<double> &_gradients);
+		/***********************************************************
+		 *  Same as above but accumulates dE/dx into a flat buffer
+		 *  of 3 * (number of minimized atoms) doubles owned by the
+		 *  caller (i.e. the minimizer's own gsl vector).  The
+		 *  per-interaction derivatives go through a scratch vector
+		 *  kept by the EnergySet, so no memory is allocated once
+		 *  the first call has sized it.
+		 ***********************************************************/
+		double calcEnergyAndEnergyGradient(double * _gradients);
 
 		double calcEnergyWithoutSwitchingFunction();
 
@@ -123,6 +132,8 @@ class EnergySet {
 		void saveEnergySubsetAllAtoms(std::string _subsetName);
 		void saveEnergySubsetAllAtoms(std::string _subsetName, std::string _selection);
 		void saveEnergySubsetAllAtoms(std::string _subsetName, std::string _selection1, std::string _selection2);
+		// save the (active) interactions that involve at least one of the atoms
+		void saveEnergySubset(std::string _subsetName, const std::vector<Atom*> & _atoms);
 
 		void removeEnergySubset(std::string _subsetName);
 
@@ -188,6 +199,11 @@ class EnergySet {
 
 		std::map<std::string, double> weights; // weights for the individual terms
 
+		// reused by calcEnergyAndEnergyGradient for the per-interaction derivatives:
+		// calcEnergyAndEnergyGradient is therefore not reentrant, do not call it
+		// concurrently on the same EnergySet
+		std::vector<double> gradientScratch;
+
 
 
 
@@ -155,16 +155,16 @@ bool GSLMinimizer::minimize(){
 
 	//cout << "Setting up, initial value: "<<initialValue<<","<<coordinateSize<<endl;
 
-	// Double data in GSL
-	gsl_vector *gslData = NULL;
-	// Create gsl version of our data..
-	gslData = gsl_vector_alloc( coordinateSize);
+	// Starting coordinates, GSL sees them through a view (no copy)
+	coordinateBuffer.resize(coordinateSize);
 	uint i = 0;
 	for (uint a = 0; a < pAtoms->size();a++){
-		gsl_vector_set(gslData,i++,(*pAtoms)[a]->getX());
-		gsl_vector_set(gslData,i++,(*pAtoms)[a]->getY());
-		gsl_vector_set(gslData,i++,(*pAtoms)[a]->getZ());
+		coordinateBuffer[i++] = (*pAtoms)[a]->getX();
+		coordinateBuffer[i++] = (*pAtoms)[a]->getY();
+		coordinateBuffer[i++] = (*pAtoms)[a]->getZ();
 	}
+	gsl_vector_view dataView = gsl_vector_view_array(&coordinateBuffer[0], coordinateSize);
+	gsl_vector *gslData = &dataView.vector;
 
 
 	// Step size vector in GSL
@@ -306,7 +306,6 @@ bool GSLMinimizer::minimize(){
 		//fprintf(stdout,"==> Minimized Value: %8.3f.  Value before minimization: %8.3f\n",minimizedValue,initialValue);
 	}
 	gsl_vector_free(ss);
-	gsl_vector_free(gslData);
 
 	// clean up and free memory
 	if (derivateMinimization){
@@ -344,25 +343,14 @@ double GSLMinimizer::my_f(const gsl_vector *_xvec_ptr, void *_params){
 }
 
 void GSLMinimizer::my_df(const gsl_vector *_xvec_ptr, void *_params, gsl_vector *_df) {
-
-	vector<double> gradient(pAtoms->size()*3,0.0);
-	pEset->calcEnergyGradient(gradient);
-
-	for (uint i=0; i < gradient.size();i+=1){
-		gsl_vector_set(_df, i, gradient[i]);
-	}
+	accumulateGradient(_df);
 }
 
 void GSLMinimizer::my_fdf(const gsl_vector *_x, void *_params, double *_f, gsl_vector *_df) {
 	// New way compute Energy and Gradient with single EnergySet Function
-	vector<double> gradient(pAtoms->size() * 3,0.0);
-	
-	*_f = pEset->calcEnergyAndEnergyGradient(gradient);
+	*_f = accumulateGradient(_df);
 	//cout << "Energy: " << *_f << endl;
 
-	for (uint i=0; i < gradient.size();i+=1){
-		gsl_vector_set(_df, i, gradient[i]);
-	}
 	// Old way, this works but is less efficient.
 	/*
        *f = my_f(x, params); 
@@ -370,14 +358,31 @@ void GSLMinimizer::my_fdf(const gsl_vector *_x, void *_params, double *_f, gsl_v
 	*/
 }
 
+double GSLMinimizer::accumulateGradient(gsl_vector *_df) {
+	// The EnergySet adds the forces straight into GSL's own gradient
+	// vector when it is contiguous (always the case for the multimin
+	// workspaces), otherwise into a reused buffer that is then copied
+	if (_df->stride == 1) {
+		gsl_vector_set_zero(_df);
+		return pEset->calcEnergyAndEnergyGradient(_df->data);
+	}
+
+	gradientBuffer.assign(_df->size, 0.0);
+	double energy = pEset->calcEnergyAndEnergyGradient(&gradientBuffer[0]);
+	gsl_vector_view gradientView = gsl_vector_view_array(&gradientBuffer[0], gradientBuffer.size());
+	gsl_vector_memcpy(_df, &gradientView.vector);
+	return energy;
+}
+
 
 void GSLMinimizer::resetCoordinates(const gsl_vector *_xvec_ptr){
 	
 	//cout << "Reset Coords "<<(*pAtoms).size()<<","<<(*pAtoms).size()*3<<endl;
-	uint a = 0;
-	for (uint i=0;i<pAtoms->size()*3;i+=3) {
-		(*pAtoms)[a]->setCoor(gsl_vector_get(_xvec_ptr,i),gsl_vector_get(_xvec_ptr,i+1),gsl_vector_get(_xvec_ptr,i+2));
-		a++;
+	const double * x = _xvec_ptr->data;
+	size_t stride = _xvec_ptr->stride;
+	for (uint a=0; a < pAtoms->size(); a++) {
+		(*pAtoms)[a]->setCoor(x[0], x[stride], x[2*stride]);
+		x += 3*stride;
 	}
 
 }
@@ -111,6 +111,11 @@ class GSLMinimizer  {
 
 		void setup(EnergySet* _es, AtomPointerVector* _av);
 		void resetCoordinates(const gsl_vector *xvec_ptr);
+		double accumulateGradient(gsl_vector *df_ptr); // energy and gradient (into df_ptr) without allocating
+
+		// reused between calls so that the minimization loop does not allocate
+		std::vector<double> coordinateBuffer;
+		std::vector<double> gradientBuffer;
 
 		// Defining function pointers
 		double  my_f   (const gsl_vector *xvec_ptr, void *params);
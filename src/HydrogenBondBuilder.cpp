@@ -29,6 +29,8 @@ You should have received a copy of the GNU Lesser General Public
 
 
 #include "HydrogenBondBuilder.h"
+#include "CellList.h"
+#include <algorithm>
 
 using namespace MSL;
 using namespace std;
@@ -60,6 +62,7 @@ void HydrogenBondBuilder::operator=( HydrogenBondBuilder & _sysBuild) {
 
 void HydrogenBondBuilder::setup() {
 	pSystem = NULL;
+	useFastEnergy = false;
 }
 
 void HydrogenBondBuilder::reset() {
@@ -70,6 +73,12 @@ void HydrogenBondBuilder::reset() {
 	donorAtom.clear();
 	lonePairAngleAtom.clear();
 	lonePairDihedralAtom.clear();
+	donorTypes.clear();
+	acceptorTypes.clear();
+	donorParams.clear();
+	acceptorParams.clear();
+	donorType.clear();
+	acceptorType.clear();
 
 	deletePointers();
 	setup();
@@ -78,6 +87,7 @@ void HydrogenBondBuilder::reset() {
 void HydrogenBondBuilder::copy( HydrogenBondBuilder & _sysBuild) {
 	reset();
 	pSystem = _sysBuild.pSystem;
+	useFastEnergy = _sysBuild.useFastEnergy;
 	acceptors = _sysBuild.acceptors;
 	donors = _sysBuild.donors;
 	acceptorData = _sysBuild.acceptorData;
@@ -85,6 +95,12 @@ void HydrogenBondBuilder::copy( HydrogenBondBuilder & _sysBuild) {
 	donorAtom = _sysBuild.donorAtom;
 	lonePairAngleAtom = _sysBuild.lonePairAngleAtom;
 	lonePairDihedralAtom = _sysBuild.lonePairDihedralAtom;
+	donorTypes = _sysBuild.donorTypes;
+	acceptorTypes = _sysBuild.acceptorTypes;
+	donorParams = _sysBuild.donorParams;
+	acceptorParams = _sysBuild.acceptorParams;
+	donorType = _sysBuild.donorType;
+	acceptorType = _sysBuild.acceptorType;
 }
 
 void HydrogenBondBuilder::deletePointers() {
@@ -134,9 +150,47 @@ bool HydrogenBondBuilder::readParameters(std::string _parameterFile) {
 	}
 
 	pParReader.close();
+	compileParameters();
 	return true;
 }
 
+void HydrogenBondBuilder::compileParameters() {
+	donorTypes.clear();
+	acceptorTypes.clear();
+	donorParams.clear();
+	acceptorParams.clear();
+
+	for(map<string,vector<double> >::iterator it = donorData.begin(); it != donorData.end(); it++) {
+		if (it->second.size() < 5) {
+			cerr << "WARNING 134465: incomplete donor parameters for " << it->first << " in void HydrogenBondBuilder::compileParameters()" << endl;
+			continue;
+		}
+		donorTypes[it->first] = donorParams.size();
+		vector<double> & d = it->second;
+		donorParams.push_back(vector<double>(5));
+		vector<double> & params = donorParams.back();
+		params[0] = d[0];
+		params[1] = d[1];
+		params[2] = d[2];
+		params[3] = (d[3] * M_PI)/180.0;
+		params[4] = (d[4] * M_PI)/180.0;
+	}
+	for(map<string,vector<double> >::iterator it = acceptorData.begin(); it != acceptorData.end(); it++) {
+		if (it->second.size() < 4) {
+			cerr << "WARNING 134466: incomplete acceptor parameters for " << it->first << " in void HydrogenBondBuilder::compileParameters()" << endl;
+			continue;
+		}
+		acceptorTypes[it->first] = acceptorParams.size();
+		vector<double> & a = it->second;
+		acceptorParams.push_back(vector<double>(4));
+		vector<double> & params = acceptorParams.back();
+		params[0] = a[0];
+		params[1] = (a[1] * M_PI)/180.0;
+		params[2] = (a[2] * M_PI)/180.0;
+		params[3] = (a[3] * M_PI)/180.0;
+	}
+}
+
 void HydrogenBondBuilder::printParameters () {
 	cout << "Donors " << endl;
 	
@@ -161,12 +215,15 @@ void HydrogenBondBuilder::printParameters () {
 void HydrogenBondBuilder::collectDonorsAndAcceptors() {
 	acceptors.clear();
 	donors.clear();
+	acceptorType.clear();
+	donorType.clear();
 	
 	
 	AtomPointerVector& atoms = pSystem->getAllAtomPointers();
 	for(int i = 0; i < atoms.size(); i++) {
 		string atomId = atoms[i]->getResidueName() + " " + atoms[i]->getName();
-		if(acceptorData.find(atomId) != acceptorData.end() ) {
+		map<string,unsigned int>::iterator found = acceptorTypes.find(atomId);
+		if(found != acceptorTypes.end()) {
 			Residue* res = atoms[i]->getParentResidue();
 			Atom* angleAtom = NULL;
 			if(res->atomExists(lonePairAngleAtom[atomId])) {
@@ -181,11 +238,13 @@ void HydrogenBondBuilder::collectDonorsAndAcceptors() {
 				acceptors.back().push_back(atoms[i]);
 				acceptors.back().push_back(angleAtom);
 				acceptors.back().push_back(dihedralAtom);
+				acceptorType.push_back(found->second);
 			}
 
 			continue;
 		}
-		if(donorData.find(atomId) != donorData.end()) {
+		found = donorTypes.find(atomId);
+		if(found != donorTypes.end()) {
 			Residue* res = atoms[i]->getParentResidue();
 			Atom* dAtom = NULL;
 			if(res->atomExists(donorAtom[atomId])) {
@@ -195,12 +254,95 @@ void HydrogenBondBuilder::collectDonorsAndAcceptors() {
 				donors.push_back(vector<Atom*>());
 				donors.back().push_back(atoms[i]);
 				donors.back().push_back(dAtom);
+				donorType.push_back(found->second);
 			}
 			continue;
 		}
 	}
 }
 
+void HydrogenBondBuilder::findPairs(double _cutoff, vector<pair<unsigned int, unsigned int> > & _pairs) {
+	/**********************************************************************
+	 *  The (acceptor, donor) pairs that need an interaction, in acceptor
+	 *  major order.  With a cutoff, a pair is kept if the hydrogen and the
+	 *  acceptor are within the cutoff in any of their alternative
+	 *  conformations.  The coordinates of all the conformations of the
+	 *  acceptors are binned in a CellList (cells at least as large as
+	 *  the cutoff) so that each hydrogen coordinate is only compared with
+	 *  the acceptors in the surrounding cells.
+	 **********************************************************************/
+	_pairs.clear();
+	if (_cutoff <= 0.0) {
+		_pairs.reserve(acceptors.size() * donors.size());
+		for (unsigned int i = 0; i < acceptors.size(); i++) {
+			for (unsigned int j = 0; j < donors.size(); j++) {
+				_pairs.push_back(pair<unsigned int, unsigned int>(i, j));
+			}
+		}
+		return;
+	}
+
+	vector<double> points;
+	vector<unsigned int> pointAcceptor;
+	double boxMin[3];
+	double boxMax[3];
+	for (unsigned int i = 0; i < acceptors.size(); i++) {
+		vector<CartesianPoint*> & coor = acceptors[i][0]->getAllCoor();
+		for (unsigned int c = 0; c < coor.size(); c++) {
+			for (unsigned int k = 0; k < 3; k++) {
+				double x = (*coor[c])[k];
+				if (points.size() < 3) {
+					boxMin[k] = boxMax[k] = x;
+				} else {
+					boxMin[k] = min(boxMin[k], x);
+					boxMax[k] = max(boxMax[k], x);
+				}
+				points.push_back(x);
+			}
+			pointAcceptor.push_back(i);
+		}
+	}
+	unsigned int n = pointAcceptor.size();
+	if (n == 0 || donors.size() == 0) {
+		return;
+	}
+
+	CellList grid(points, _cutoff);
+	vector<unsigned int> cells;
+
+	double cutoff2 = _cutoff * _cutoff;
+	// the last donor that was paired with each acceptor, to add each pair once
+	vector<unsigned int> lastDonor(acceptors.size(), donors.size());
+	for (unsigned int j = 0; j < donors.size(); j++) {
+		vector<CartesianPoint*> & coor = donors[j][0]->getAllCoor();
+		for (unsigned int c = 0; c < coor.size(); c++) {
+			double p[3] = {coor[c]->getX(), coor[c]->getY(), coor[c]->getZ()};
+			if (p[0] < boxMin[0] - _cutoff || p[0] > boxMax[0] + _cutoff ||
+			    p[1] < boxMin[1] - _cutoff || p[1] > boxMax[1] + _cutoff ||
+			    p[2] < boxMin[2] - _cutoff || p[2] > boxMax[2] + _cutoff) {
+				continue;
+			}
+			grid.getNeighborCells(p, cells);
+			for (unsigned int g = 0; g < cells.size(); g++) {
+				for (unsigned int m = grid.getFirstPoint(cells[g]); m != grid.size(); m = grid.getNextPoint(m)) {
+					unsigned int i = pointAcceptor[m];
+					if (lastDonor[i] == j) {
+						continue;
+					}
+					const double * q = &points[3*m];
+					double d2 = (p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) + (p[2]-q[2])*(p[2]-q[2]);
+					if (d2 <= cutoff2) {
+						lastDonor[i] = j;
+						_pairs.push_back(pair<unsigned int, unsigned int>(i, j));
+					}
+				}
+			}
+		}
+	}
+	// same order as the all pairs loop
+	sort(_pairs.begin(), _pairs.end());
+}
+
 bool HydrogenBondBuilder::buildInteractions(double _cutoff) {
 	collectDonorsAndAcceptors();
 	return update(_cutoff);
@@ -211,52 +353,38 @@ bool HydrogenBondBuilder::update(double _cutoff) {
 	EnergySet* ESet = pSystem->getEnergySet();
 	// delete all existing scwrl4HBondinteractions
 	ESet->eraseTerm("SCWRL4_HBOND");
-	//cout << "UUUU Size: " << atoms.size() << endl;
 
-	// create a map of acceptors and 
+	vector<pair<unsigned int, unsigned int> > pairs;
+	findPairs(_cutoff, pairs);
 
-	for(int i = 0; i < acceptors.size(); i++) {
+	for(unsigned int p = 0; p < pairs.size(); p++) {
+		unsigned int i = pairs[p].first;
+		unsigned int j = pairs[p].second;
 		Atom* acceptor = acceptors[i][0];
-		string accPosId = acceptor->getPositionId();
-		string accResName =  acceptor->getResidueName();
-		string acceptorId = accResName + " " + acceptor->getName();
-		vector<double>& accData = acceptorData[acceptorId];
-
-		for(int j = 0; j < donors.size(); j++) {
-			Atom* hydrogen = donors[j][0];
-			string donPosId = hydrogen->getPositionId();
-			string donResName =  hydrogen->getResidueName();
-			if(accPosId == donPosId) { 
-				// If acceptor and donor belong to the same position ,
-				// make sure they are indeed distinct 
-				// make sure that we build interactions only if the identities are same
-				if(accResName != donResName) {
-					// atoms from different identity - skip
-					continue;	
-				}
-				if(donors[j][1]->getName() == acceptor->getName()) {
-					// both atoms are from the same identity
-					// make sure they are indeed different
-					continue;
-				}
+		Atom* hydrogen = donors[j][0];
+		if(acceptor->getParentPosition() == hydrogen->getParentPosition()) { 
+			// If acceptor and donor belong to the same position ,
+			// make sure they are indeed distinct 
+			// make sure that we build interactions only if the identities are same
+			if(acceptor->getResidueName() != hydrogen->getResidueName()) {
+				// atoms from different identity - skip
+				continue;	
 			}
-			string hydrogenId = hydrogen->getResidueName() + " " + hydrogen->getName(); 
-			
-			if(_cutoff > 0) {
-				// a cutoff has been specified
-				if(hydrogen->distance(*acceptor) > _cutoff) {
-					continue;
-				}
+			if(donors[j][1]->getName() == acceptor->getName()) {
+				// both atoms are from the same identity
+				// make sure they are indeed different
+				continue;
 			}
+		}
 
-			vector<double>& donData = donorData[hydrogenId];
+		vector<double>& accData = acceptorParams[acceptorType[i]];
+		vector<double>& donData = donorParams[donorType[j]];
 
-			Scwrl4HBondInteraction* interaction = new Scwrl4HBondInteraction(*hydrogen,*donors[j][1],*acceptor,*acceptors[i][1],*acceptors[i][2], // atoms involved
-				accData[0],(accData[1] * M_PI)/180.0,(accData[2] * M_PI)/180.0,(accData[3] * M_PI)/180.0, // acceptor data - angles in radians
-				donData[0],donData[1],donData[2],(donData[3] * M_PI)/180.0,(donData[4] * M_PI)/180.0); // donor data - angles in radians
-			ESet->addInteraction(interaction);
-		}
+		Scwrl4HBondInteraction* interaction = new Scwrl4HBondInteraction(*hydrogen,*donors[j][1],*acceptor,*acceptors[i][1],*acceptors[i][2], // atoms involved
+			accData[0],accData[1],accData[2],accData[3], // acceptor data - angles in radians
+			donData[0],donData[1],donData[2],donData[3],donData[4]); // donor data - angles in radians
+		interaction->setFastEnergy(useFastEnergy);
+		ESet->addInteraction(interaction);
 	}
 	return true;
 }
-
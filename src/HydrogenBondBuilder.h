@@ -59,6 +59,10 @@ namespace MSL {
 
 			void printParameters();
 
+			// build the interactions with the fast SCWRL4 hbond evaluation (see Scwrl4HBondInteraction::setFastEnergy)
+			void setUseFastEnergy(bool _fast);
+			bool getUseFastEnergy() const;
+
 			/**************************************************
 			 * Add one or more new identities to a position,
 			 * if a series of backbone atoms are specified
@@ -71,10 +75,13 @@ namespace MSL {
 			void setup();
 			void copy(HydrogenBondBuilder & _sysBuild);
 			void collectDonorsAndAcceptors();
+			void compileParameters();
+			void findPairs(double _cutoff, std::vector<std::pair<unsigned int, unsigned int> > & _pairs);
 			void deletePointers();
 			void reset();
 
 			System * pSystem;
+			bool useFastEnergy;
 
 			std::vector<std::vector<Atom*> > acceptors; // 0 - acceptor(O), 1 - lonePairAngleAtom(C), 2 - lonePairDihedralAtom  (CA)
 			std::vector<std::vector<Atom*> > donors; // 0- hydrogen(HN), 1 - donorAtom (N)
@@ -87,7 +94,21 @@ namespace MSL {
 
 			std::map<std::string,std::vector<double> > acceptorData; // [ASP O ] [1 120 0 180]
 
+			/**************************************************
+			 *  The parameters resolved to integer types once
+			 *  (angles in radians), the type of each donor and
+			 *  acceptor is found when they are collected
+			 **************************************************/
+			std::map<std::string,unsigned int> donorTypes; // [ARG HN] = 3
+			std::map<std::string,unsigned int> acceptorTypes; // [ASP O] = 5
+			std::vector<std::vector<double> > donorParams;
+			std::vector<std::vector<double> > acceptorParams;
+			std::vector<unsigned int> donorType;
+			std::vector<unsigned int> acceptorType;
+
 	};
+	inline void HydrogenBondBuilder::setUseFastEnergy(bool _fast) {useFastEnergy = _fast;}
+	inline bool HydrogenBondBuilder::getUseFastEnergy() const {return useFastEnergy;}
 	inline void HydrogenBondBuilder::setSystem(System & _system) {
 		reset();
 		pSystem = &_system;
@@ -0,0 +1,409 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "IcBuildPlanner.h"
+#include "Timer.h"
+#include <cmath>
+
+using namespace MSL;
+using namespace std;
+
+
+IcBuildPlanner::IcBuildPlanner() {
+	setup();
+}
+
+IcBuildPlanner::IcBuildPlanner(System & _sys) {
+	setup();
+	pSystem = &_sys;
+}
+
+IcBuildPlanner::IcBuildPlanner(const IcBuildPlanner & _planner) {
+	setup();
+	copy(_planner);
+}
+
+IcBuildPlanner::~IcBuildPlanner() {
+}
+
+void IcBuildPlanner::operator=(const IcBuildPlanner & _planner) {
+	copy(_planner);
+}
+
+void IcBuildPlanner::setup() {
+	pSystem = NULL;
+	numThreads = 0;
+	parallelThreshold = 256;
+	resetCounters();
+}
+
+void IcBuildPlanner::copy(const IcBuildPlanner & _planner) {
+	pSystem = _planner.pSystem;
+	activePlan = _planner.activePlan;
+	allPlan = _planner.allPlan;
+	numThreads = _planner.numThreads;
+	parallelThreshold = _planner.parallelThreshold;
+	numberOfBuilds = _planner.numberOfBuilds;
+	numberOfCompilations = _planner.numberOfCompilations;
+	checkingTime = _planner.checkingTime;
+	planningTime = _planner.planningTime;
+	placingTime = _planner.placingTime;
+	numberOfSteps = _planner.numberOfSteps;
+	numberOfLevels = _planner.numberOfLevels;
+}
+
+void IcBuildPlanner::reset() {
+	activePlan = Plan();
+	allPlan = Plan();
+}
+
+void IcBuildPlanner::resetCounters() {
+	numberOfBuilds = 0;
+	numberOfCompilations = 0;
+	checkingTime = 0.0;
+	planningTime = 0.0;
+	placingTime = 0.0;
+	numberOfSteps = 0;
+	numberOfLevels = 0;
+}
+
+int IcBuildPlanner::getNumThreads() const {
+	return MslTools::getNumThreads(numThreads);
+}
+
+void IcBuildPlanner::buildAtoms() {
+	if (pSystem == NULL) {
+		cerr << "ERROR 62105: System not set in void IcBuildPlanner::buildAtoms()" << endl;
+		return;
+	}
+	build(activePlan, pSystem->getAtomPointers(), true);
+}
+
+void IcBuildPlanner::buildAllAtoms(string _bbAtoms) {
+	if (pSystem == NULL) {
+		cerr << "ERROR 62105: System not set in void IcBuildPlanner::buildAllAtoms(string _bbAtoms)" << endl;
+		return;
+	}
+	build(activePlan, pSystem->getAtomPointers(), true);
+	vector<string> bbAtoms = MslTools::tokenize(_bbAtoms);
+	pSystem->copyCoordinatesOfAtomsInPosition(bbAtoms);
+	build(allPlan, pSystem->getAllAtomPointers(), false);
+}
+
+void IcBuildPlanner::snapshot(Plan & _plan, const vector<Atom*> & _atoms) const {
+	_plan.atoms = _atoms;
+	_plan.atomState.resize(_atoms.size());
+	_plan.numIcEntries.resize(_atoms.size());
+	_plan.icEntries.clear();
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		_plan.atomState[i] = (_atoms[i]->hasCoor() ? 1 : 0) + (_atoms[i]->getActive() ? 2 : 0);
+		vector<IcEntry*> & icEntries = _atoms[i]->getIcEntries();
+		_plan.numIcEntries[i] = icEntries.size();
+		_plan.icEntries.insert(_plan.icEntries.end(), icEntries.begin(), icEntries.end());
+	}
+}
+
+bool IcBuildPlanner::isCurrent(const Plan & _plan, const vector<Atom*> & _atoms) const {
+	if (_plan.levelStart.size() == 0 || _plan.atoms != _atoms) {
+		return false;
+	}
+	unsigned int n = 0;
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		if (_plan.atomState[i] != (_atoms[i]->hasCoor() ? 1 : 0) + (_atoms[i]->getActive() ? 2 : 0)) {
+			return false;
+		}
+		vector<IcEntry*> & icEntries = _atoms[i]->getIcEntries();
+		if (_plan.numIcEntries[i] != icEntries.size()) {
+			return false;
+		}
+		for (vector<IcEntry*>::iterator k=icEntries.begin(); k!=icEntries.end(); k++) {
+			if (*k != _plan.icEntries[n]) {
+				return false;
+			}
+			n++;
+		}
+	}
+	// the path taken depends on which values are zero
+	for (vector<double*>::const_iterator k=_plan.zeroValues.begin(); k!=_plan.zeroValues.end(); k++) {
+		if (**k != 0.0) {
+			return false;
+		}
+	}
+	for (vector<BuildStep>::const_iterator k=_plan.steps.begin(); k!=_plan.steps.end(); k++) {
+		if (*(k->pDistance) == 0.0 || *(k->pAngle) == 0.0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void IcBuildPlanner::build(Plan & _plan, const vector<Atom*> & _atoms, bool _onlyFromActive) {
+	Timer timer;
+	double start = timer.getWallTime();
+	bool current = isCurrent(_plan, _atoms);
+	double end = timer.getWallTime();
+	checkingTime += end - start;
+
+	if (!current) {
+		start = end;
+		snapshot(_plan, _atoms);
+		vector<BuildStep> steps;
+		compile(_atoms, _onlyFromActive, steps, _plan.zeroValues);
+
+		// sort the steps by level
+		_plan.levelStart.assign(1, 0);
+		for (vector<BuildStep>::iterator k=steps.begin(); k!=steps.end(); k++) {
+			if (k->level >= _plan.levelStart.size()) {
+				_plan.levelStart.resize(k->level + 1, 0);
+			}
+			_plan.levelStart[k->level]++;
+		}
+		// levels start from 1, levelStart[0] becomes the start of level 1
+		unsigned int total = 0;
+		for (unsigned int i=0; i<_plan.levelStart.size(); i++) {
+			unsigned int count = _plan.levelStart[i];
+			_plan.levelStart[i] = total;
+			total += count;
+		}
+		_plan.levelStart.push_back(total);
+		_plan.levelStart.erase(_plan.levelStart.begin());
+		vector<unsigned int> next(_plan.levelStart.begin(), _plan.levelStart.end() - 1);
+		_plan.steps.resize(steps.size());
+		for (vector<BuildStep>::iterator k=steps.begin(); k!=steps.end(); k++) {
+			_plan.steps[next[k->level - 1]++] = *k;
+		}
+		numberOfCompilations++;
+		end = timer.getWallTime();
+		planningTime += end - start;
+	}
+
+	start = end;
+	execute(_plan);
+	placingTime += timer.getWallTime() - start;
+	numberOfBuilds++;
+	numberOfSteps = _plan.steps.size();
+	numberOfLevels = _plan.levelStart.size() - 1;
+}
+
+void IcBuildPlanner::execute(Plan & _plan) {
+	for (unsigned int i=0; i+1<_plan.levelStart.size(); i++) {
+		int levelStart = _plan.levelStart[i];
+		int levelEnd = _plan.levelStart[i+1];
+		// the atoms of a level only depend on atoms of the previous levels
+#ifdef __OPENMP__
+		#pragma omp parallel for schedule(static) num_threads(getNumThreads()) if(levelEnd - levelStart >= (int)parallelThreshold)
+#endif
+		for (int j=levelStart; j<levelEnd; j++) {
+			placeAtom(_plan.steps[j]);
+		}
+	}
+}
+
+void IcBuildPlanner::compile(const vector<Atom*> & _atoms, bool _onlyFromActive, vector<BuildStep> & _steps, vector<double*> & _zeroValues) {
+	/***********************************************************************
+	 *  Follows the same path of Atom::buildFromIc() and IcEntry::build()
+	 *  without building anything, recording the placements in order.
+	 *
+	 *  The level of an atom is one more than the highest level of the
+	 *  three atoms it is placed from (the atoms that already have
+	 *  coordinates are level 0)
+	 ***********************************************************************/
+	_steps.clear();
+	_zeroValues.clear();
+	map<Atom*, unsigned int> levels;
+	for (vector<Atom*>::const_iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
+		map<IcEntry*, bool> exclude;
+		if (levels.find(*k) != levels.end() || (*k)->hasCoor()) {
+			continue;
+		}
+		vector<IcEntry*> & icEntries = (*k)->getIcEntries();
+		for (vector<IcEntry*>::iterator l=icEntries.begin(); l!=icEntries.end(); l++) {
+			if (planIcEntry(*l, *k, _onlyFromActive, exclude, levels, _steps, _zeroValues)) {
+				break;
+			}
+		}
+	}
+}
+
+bool IcBuildPlanner::planAtom(Atom * _pAtom, bool _onlyFromActive, map<IcEntry*, bool> & _exclude, map<Atom*, unsigned int> & _levels, vector<BuildStep> & _steps, vector<double*> & _zeroValues) {
+	if (_levels.find(_pAtom) != _levels.end() || _pAtom->hasCoor()) {
+		return true;
+	}
+	vector<IcEntry*> & icEntries = _pAtom->getIcEntries();
+	for (vector<IcEntry*>::iterator k=icEntries.begin(); k!=icEntries.end(); k++) {
+		if (_exclude.find(*k) != _exclude.end()) {
+			continue;
+		}
+		if (planIcEntry(*k, _pAtom, _onlyFromActive, _exclude, _levels, _steps, _zeroValues)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool IcBuildPlanner::planIcEntry(IcEntry * _pIc, Atom * _pAtom, bool _onlyFromActive, map<IcEntry*, bool> & _exclude, map<Atom*, unsigned int> & _levels, vector<BuildStep> & _steps, vector<double*> & _zeroValues) {
+	Atom * pAtom1 = _pIc->getAtom1();
+	Atom * pAtom2 = _pIc->getAtom2();
+	Atom * pAtom3 = _pIc->getAtom3();
+	Atom * pAtom4 = _pIc->getAtom4();
+	vector<double> & vals = _pIc->getValues();
+
+	BuildStep step;
+	step.pAtom = _pAtom;
+	step.pDihedral = &vals[2];
+	step.dihedralSign = 1.0;
+	Atom * pFirst = NULL;
+	Atom * pSecond = NULL;
+	Atom * pThird = NULL;
+	if (pAtom1 == _pAtom) {
+		// atom 1, the build order is 2 3 4
+		if (pAtom2 == NULL || pAtom3 == NULL || pAtom4 == NULL) {
+			return false;
+		}
+		if (vals[0] == 0.0 || vals[1] == 0.0) {
+			_zeroValues.push_back(vals[0] == 0.0 ? &vals[0] : &vals[1]);
+			return false;
+		}
+		pFirst = pAtom2;
+		pSecond = pAtom3;
+		pThird = pAtom4;
+		step.pDistance = &vals[0];
+		step.pAngle = &vals[1];
+		if (_pIc->isImproper()) {
+			step.pDistAtom = pAtom3;
+			step.pAngleAtom = pAtom2;
+			step.dihedralSign = -1.0;
+		} else {
+			step.pDistAtom = pAtom2;
+			step.pAngleAtom = pAtom3;
+		}
+		step.pDihedralAtom = pAtom4;
+	} else if (pAtom4 == _pAtom) {
+		// atom 4, the build order is 3 2 1
+		if (pAtom3 == NULL || pAtom2 == NULL || pAtom1 == NULL) {
+			return false;
+		}
+		if (vals[4] == 0.0 || vals[3] == 0.0) {
+			_zeroValues.push_back(vals[4] == 0.0 ? &vals[4] : &vals[3]);
+			return false;
+		}
+		pFirst = pAtom3;
+		pSecond = pAtom2;
+		pThird = pAtom1;
+		step.pDistance = &vals[4];
+		step.pAngle = &vals[3];
+		step.pDistAtom = pAtom3;
+		step.pAngleAtom = pAtom2;
+		step.pDihedralAtom = pAtom1;
+	} else {
+		return false;
+	}
+	if (_onlyFromActive && (!pFirst->getActive() || !pSecond->getActive() || !pThird->getActive())) {
+		// some atoms are in inactive identities
+		return false;
+	}
+	_exclude[_pIc] = true;
+	if (planAtom(pFirst, _onlyFromActive, _exclude, _levels, _steps, _zeroValues) && planAtom(pSecond, _onlyFromActive, _exclude, _levels, _steps, _zeroValues) && planAtom(pThird, _onlyFromActive, _exclude, _levels, _steps, _zeroValues)) {
+		step.level = 0;
+		Atom * from[3] = {pFirst, pSecond, pThird};
+		for (unsigned int i=0; i<3; i++) {
+			map<Atom*, unsigned int>::iterator found = _levels.find(from[i]);
+			if (found != _levels.end() && found->second > step.level) {
+				step.level = found->second;
+			}
+		}
+		step.level++;
+		setTrigonometry(step);
+		_levels[_pAtom] = step.level;
+		_steps.push_back(step);
+		return true;
+	}
+	return false;
+}
+
+void IcBuildPlanner::setTrigonometry(BuildStep & _step) {
+	_step.angle = *(_step.pAngle);
+	_step.dihedral = *(_step.pDihedral);
+	double angle2 = M_PI - _step.angle;
+	double dihe2 = M_PI + _step.dihedralSign * _step.dihedral;
+	_step.sinAngle = sin(angle2);
+	_step.cosAngle = cos(angle2);
+	_step.sinDihe = sin(dihe2);
+	_step.cosDihe = cos(dihe2);
+}
+
+void IcBuildPlanner::placeAtom(BuildStep & _step) {
+	/***********************************************************************
+	 *  Same arithmetic of CartesianGeometry::buildRadians, on plain
+	 *  doubles (see the function for the geometry)
+	 ***********************************************************************/
+	const CartesianPoint & B = _step.pDistAtom->getCoor();
+	const CartesianPoint & C = _step.pAngleAtom->getCoor();
+	const CartesianPoint & D = _step.pDihedralAtom->getCoor();
+	double dihedral = _step.dihedralSign * *(_step.pDihedral);
+
+	double uCB[3] = {B.getX() - C.getX(), B.getY() - C.getY(), B.getZ() - C.getZ()};
+	double dDC[3] = {C.getX() - D.getX(), C.getY() - D.getY(), C.getZ() - D.getZ()};
+	double lengthCB = sqrt(uCB[0]*uCB[0] + uCB[1]*uCB[1] + uCB[2]*uCB[2]);
+	if (lengthCB == 0.0) {
+		// degenerate, let the general function deal with it
+		_step.pAtom->setCoor(CartesianGeometry::buildRadians(B, C, D, *(_step.pDistance), *(_step.pAngle), dihedral));
+		return;
+	}
+	for (unsigned int k=0; k<3; k++) {
+		uCB[k] = uCB[k] / lengthCB;
+	}
+
+	if (*(_step.pAngle) != _step.angle || *(_step.pDihedral) != _step.dihedral) {
+		setTrigonometry(_step);
+	}
+	double rsin = *(_step.pDistance) * _step.sinAngle;
+	double rcos = *(_step.pDistance) * _step.cosAngle;
+	double rsinsin = rsin * _step.sinDihe;
+	double rsincos = rsin * _step.cosDihe;
+
+	// component on the B-C-D plane, orthogonal to B-C
+	double dot = dDC[0]*uCB[0] + dDC[1]*uCB[1] + dDC[2]*uCB[2];
+	double inPlane[3] = {dDC[0] - uCB[0] * dot, dDC[1] - uCB[1] * dot, dDC[2] - uCB[2] * dot};
+	// component orthogonal to the B-C-D plane
+	double normal[3] = {uCB[1]*dDC[2] - uCB[2]*dDC[1], uCB[2]*dDC[0] - uCB[0]*dDC[2], uCB[0]*dDC[1] - uCB[1]*dDC[0]};
+	double lengthInPlane = sqrt(inPlane[0]*inPlane[0] + inPlane[1]*inPlane[1] + inPlane[2]*inPlane[2]);
+	double lengthNormal = sqrt(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+	if (lengthInPlane == 0.0 || lengthNormal == 0.0) {
+		_step.pAtom->setCoor(CartesianGeometry::buildRadians(B, C, D, *(_step.pDistance), *(_step.pAngle), dihedral));
+		return;
+	}
+
+	double A[3];
+	double origin[3] = {B.getX(), B.getY(), B.getZ()};
+	for (unsigned int k=0; k<3; k++) {
+		A[k] = uCB[k] * rcos + (inPlane[k] / lengthInPlane) * rsincos + (normal[k] / lengthNormal) * rsinsin + origin[k];
+	}
+	_step.pAtom->setCoor(A[0], A[1], A[2]);
+}
@@ -0,0 +1,183 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef ICBUILDPLANNER_H
+#define ICBUILDPLANNER_H
+
+#include <vector>
+#include <map>
+#include <string>
+
+#include "System.h"
+
+/*************************************************************************
+ *  Builds the atoms of a System from the IC table like System::buildAtoms()
+ *  and System::buildAllAtoms(), with the same result, but it replays a
+ *  compiled building order.
+ *
+ *  The order that the recursive Atom::buildFromIc() would follow is
+ *  resolved once (a plan), and grouped in levels: an atom is placed
+ *  only from atoms of lower levels, so the atoms of a level (i.e. of
+ *  different chains and positions) are placed in parallel when MSL is
+ *  compiled with OpenMP.
+ *
+ *  The plan is reused as long as the atoms, their IC entries, active
+ *  identities, which atoms have coordinates before the build and the
+ *  IC values that are zero are the same, otherwise it is recompiled
+ *  automatically.
+ *
+ *  Usage:
+ *     IcBuildPlanner planner(sys);
+ *     sys.wipeAllCoordinates();
+ *     planner.buildAllAtoms();
+ *     ...
+ *     cout << planner.getPlanningTime() << " " << planner.getPlacingTime() << endl;
+ *************************************************************************/
+
+namespace MSL { 
+class IcBuildPlanner {
+	public:
+		IcBuildPlanner();
+		IcBuildPlanner(System & _sys);
+		IcBuildPlanner(const IcBuildPlanner & _planner);
+		~IcBuildPlanner();
+
+		void operator=(const IcBuildPlanner & _planner);
+
+		void setSystem(System & _sys);
+
+		void buildAtoms(); // as System::buildAtoms (active atoms only)
+		void buildAllAtoms(std::string _bbAtoms="N CA C O HN"); // as System::buildAllAtoms (active and inactive atoms)
+
+		// discard the compiled plans
+		void reset();
+
+		// atoms of the same level are placed on multiple threads when MSL is compiled 
+		// with OpenMP (MSL_OPENMP=T): 0 = all cores
+		void setNumThreads(int _threads);
+		int getNumThreads() const;
+		// levels with fewer atoms than the threshold are placed on a single thread (default 256)
+		void setParallelThreshold(unsigned int _threshold);
+		unsigned int getParallelThreshold() const;
+
+		/***************************************************
+		 *  Counters, cumulative since the last resetCounters()
+		 *  (times are wall clock seconds)
+		 ***************************************************/
+		void resetCounters();
+		unsigned int getNumberOfBuilds() const; // number of plans executed
+		unsigned int getNumberOfCompilations() const; // number of plans compiled
+		double getCheckingTime() const; // checking that a plan is still valid
+		double getPlanningTime() const; // compiling the plans
+		double getPlacingTime() const; // placing the atoms
+		unsigned int getNumberOfSteps() const; // atoms placed by the last plan
+		unsigned int getNumberOfLevels() const; // levels of the last plan
+
+		/***************************************************
+		 *  The building order, also used by the
+		 *  SystemRotamerLoader
+		 ***************************************************/
+		struct BuildStep {
+			Atom * pAtom;
+			Atom * pDistAtom;
+			Atom * pAngleAtom;
+			Atom * pDihedralAtom;
+			double * pDistance;
+			double * pAngle;
+			double * pDihedral;
+			double dihedralSign; // -1 for atom 1 of improper IC entries
+			unsigned int level; // depends only on atoms of lower levels
+			// sin and cos of the angle and dihedral terms, recomputed only when the values change
+			double angle;
+			double dihedral;
+			double sinAngle;
+			double cosAngle;
+			double sinDihe;
+			double cosDihe;
+		};
+		// follows the path of Atom::buildFromIc() for each atom without building anything.
+		// The IC values that are zero and made an IC entry unusable are listed in _zeroValues
+		static void compile(const std::vector<Atom*> & _atoms, bool _onlyFromActive, std::vector<BuildStep> & _steps, std::vector<double*> & _zeroValues);
+		// same arithmetic of CartesianGeometry::buildRadians on plain doubles
+		static void placeAtom(BuildStep & _step);
+
+	private:
+		struct Plan {
+			std::vector<Atom*> atoms;
+			std::vector<unsigned char> atomState; // 1 = has coordinates, 2 = active
+			std::vector<unsigned int> numIcEntries;
+			std::vector<IcEntry*> icEntries;
+			std::vector<double*> zeroValues;
+			std::vector<BuildStep> steps; // sorted by level
+			std::vector<unsigned int> levelStart; // the steps of level i are levelStart[i]..levelStart[i+1]
+		};
+
+		void setup();
+		void copy(const IcBuildPlanner & _planner);
+		void snapshot(Plan & _plan, const std::vector<Atom*> & _atoms) const;
+		bool isCurrent(const Plan & _plan, const std::vector<Atom*> & _atoms) const;
+		void build(Plan & _plan, const std::vector<Atom*> & _atoms, bool _onlyFromActive);
+		void execute(Plan & _plan);
+
+		static bool planAtom(Atom * _pAtom, bool _onlyFromActive, std::map<IcEntry*, bool> & _exclude, std::map<Atom*, unsigned int> & _levels, std::vector<BuildStep> & _steps, std::vector<double*> & _zeroValues);
+		static void setTrigonometry(BuildStep & _step);
+		static bool planIcEntry(IcEntry * _pIc, Atom * _pAtom, bool _onlyFromActive, std::map<IcEntry*, bool> & _exclude, std::map<Atom*, unsigned int> & _levels, std::vector<BuildStep> & _steps, std::vector<double*> & _zeroValues);
+
+		System * pSystem;
+
+		Plan activePlan;
+		Plan allPlan;
+
+		int numThreads;
+		unsigned int parallelThreshold;
+
+		unsigned int numberOfBuilds;
+		unsigned int numberOfCompilations;
+		double checkingTime;
+		double planningTime;
+		double placingTime;
+		unsigned int numberOfSteps;
+		unsigned int numberOfLevels;
+
+};
+inline void IcBuildPlanner::setSystem(System & _sys) {pSystem = &_sys; reset();}
+inline void IcBuildPlanner::setNumThreads(int _threads) {numThreads = _threads;}
+inline void IcBuildPlanner::setParallelThreshold(unsigned int _threshold) {parallelThreshold = _threshold;}
+inline unsigned int IcBuildPlanner::getParallelThreshold() const {return parallelThreshold;}
+inline unsigned int IcBuildPlanner::getNumberOfBuilds() const {return numberOfBuilds;}
+inline unsigned int IcBuildPlanner::getNumberOfCompilations() const {return numberOfCompilations;}
+inline double IcBuildPlanner::getCheckingTime() const {return checkingTime;}
+inline double IcBuildPlanner::getPlanningTime() const {return planningTime;}
+inline double IcBuildPlanner::getPlacingTime() const {return placingTime;}
+inline unsigned int IcBuildPlanner::getNumberOfSteps() const {return numberOfSteps;}
+inline unsigned int IcBuildPlanner::getNumberOfLevels() const {return numberOfLevels;}
+
+}
+
+#endif
@@ -242,6 +242,68 @@ bool IcTable::editDihedral(Atom * _pAtom1, Atom * _pAtom2, Atom * _pAtom3, Atom
 	return false;
 }
 
+bool IcTable::getBondValuePointers(Atom * _pAtom1, Atom * _pAtom2, vector<double*> & _values) const {
+	_values.clear();
+	map<Atom*, map<Atom*, vector<double*> > >::const_iterator found1 = bondMap.find(_pAtom1);
+	if (found1 == bondMap.end()) {
+		return false;
+	}
+	map<Atom*, vector<double*> >::const_iterator found2 = found1->second.find(_pAtom2);
+	if (found2 == found1->second.end()) {
+		return false;
+	}
+	_values = found2->second;
+	return true;
+}
+
+bool IcTable::getAngleValuePointers(Atom * _pAtom1, Atom * _pAtom2, Atom * _pAtom3, vector<double*> & _values) const {
+	_values.clear();
+	map<Atom*, map<Atom*, map<Atom*, vector<double*> > > >::const_iterator found1 = angleMap.find(_pAtom1);
+	if (found1 == angleMap.end()) {
+		return false;
+	}
+	map<Atom*, map<Atom*, vector<double*> > >::const_iterator found2 = found1->second.find(_pAtom2);
+	if (found2 == found1->second.end()) {
+		return false;
+	}
+	map<Atom*, vector<double*> >::const_iterator found3 = found2->second.find(_pAtom3);
+	if (found3 == found2->second.end()) {
+		return false;
+	}
+	_values = found3->second;
+	return true;
+}
+
+bool IcTable::getDihedralValuePointers(Atom * _pAtom1, Atom * _pAtom2, Atom * _pAtom3, Atom * _pAtom4, vector<double*> & _values, bool & _inverted) const {
+	_values.clear();
+	_inverted = false;
+	map<Atom*, map<Atom*, map<Atom*, map<Atom*, vector<double*> > > > >::const_iterator found1 = dihedralMap.find(_pAtom1);
+	if (found1 == dihedralMap.end()) {
+		return false;
+	}
+	// same order first, then atoms 2-3 inverted (see editDihedral)
+	for (unsigned int i=0; i<2; i++) {
+		Atom * pMiddle1 = i == 0 ? _pAtom2 : _pAtom3;
+		Atom * pMiddle2 = i == 0 ? _pAtom3 : _pAtom2;
+		map<Atom*, map<Atom*, map<Atom*, vector<double*> > > >::const_iterator found2 = found1->second.find(pMiddle1);
+		if (found2 == found1->second.end()) {
+			continue;
+		}
+		map<Atom*, map<Atom*, vector<double*> > >::const_iterator found3 = found2->second.find(pMiddle2);
+		if (found3 == found2->second.end()) {
+			continue;
+		}
+		map<Atom*, vector<double*> >::const_iterator found4 = found3->second.find(_pAtom4);
+		if (found4 == found3->second.end()) {
+			continue;
+		}
+		_values = found4->second;
+		_inverted = i == 1;
+		return true;
+	}
+	return false;
+}
+
 bool IcTable::seed() {
 	/*********************************************************
 	 *  Auto seeding, finds the first IC that seems proper for
@@ -75,6 +75,16 @@ class IcTable : public std::vector<IcEntry*> {
 		bool editAngle(Atom * _pAtom1, Atom * _pAtom2, Atom * _pAtom3, double _newValue);
 		bool editDihedral(Atom * _pAtom1, Atom * _pAtom2, Atom * _pAtom3, Atom * _pAtom4, double _newValue);
 
+		/********************************************************
+		 *  The addresses of the values that the edit functions
+		 *  above would change.  For the dihedral, _inverted is
+		 *  set if the values are stored with atoms 2 and 3 swapped
+		 *  (and the edit would change their sign)
+		 ********************************************************/
+		bool getBondValuePointers(Atom * _pAtom1, Atom * _pAtom2, std::vector<double*> & _values) const;
+		bool getAngleValuePointers(Atom * _pAtom1, Atom * _pAtom2, Atom * _pAtom3, std::vector<double*> & _values) const;
+		bool getDihedralValuePointers(Atom * _pAtom1, Atom * _pAtom2, Atom * _pAtom3, Atom * _pAtom4, std::vector<double*> & _values, bool & _inverted) const;
+
 		bool seed(Atom * _pAtom1, Atom * _pAtom2, Atom * _pAtom3);
 		bool seed();
 
@@ -0,0 +1,361 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "LBFGSMinimizer.h"
+
+using namespace MSL;
+using namespace std;
+
+LBFGSMinimizer::LBFGSMinimizer(){	
+	setup(NULL,NULL);
+}
+
+LBFGSMinimizer::LBFGSMinimizer(System& _sys){
+	setup(_sys.getEnergySet(),&(_sys.getAtomPointers()));
+}
+
+LBFGSMinimizer::LBFGSMinimizer(EnergySet* _es, AtomPointerVector* _av){
+	setup(_es,_av);
+}
+	
+LBFGSMinimizer::~LBFGSMinimizer(){
+	if (pEset != NULL) {
+		removeConstraints();
+	}
+}
+
+void LBFGSMinimizer::setSystem(System& _sys) {
+	setup(_sys.getEnergySet(),&(_sys.getAtomPointers()));
+}
+
+void LBFGSMinimizer::setup(EnergySet* _es, AtomPointerVector* _av){
+	pEset = _es; 
+	pAtoms = _av;
+	// By default minimize all pAtoms
+	if(pAtoms) {
+		for(int i = 0; i < pAtoms->size(); i++) {
+			// The minimization index has to start from 1
+			(*pAtoms)[i]->setMinimizationIndex(i+1);
+		}
+	}
+	
+	stepsize = 0.1;
+	tolerance = 0.01;
+	maxIterations = 200;
+	historySize = 8;
+
+	initialEnergy = 0.0;
+	minimizedEnergy = 0.0;
+	iterations = 0;
+	converged = false;
+	historyStart = 0;
+	historyCount = 0;
+}
+
+void LBFGSMinimizer::resetConstraints() {
+
+	// reset each interaction to zero energy
+	for(map<Atom*,SpringConstraintInteraction*>::iterator it = springInteractionPointers.begin(); it != springInteractionPointers.end(); it++) {
+		(it->second)->reset();
+	}
+}
+
+void LBFGSMinimizer::fixAtoms(string _selection) {
+	AtomSelection sel(*pAtoms);
+	fixAtoms(sel.select(_selection));
+}
+
+void LBFGSMinimizer::fixAtoms(AtomPointerVector &_av) {
+	for(AtomPointerVector::iterator it = _av.begin(); it != _av.end(); it++) {
+		if(*it) {
+			(*it)->setMinimizationIndex(-1);
+		}
+	}
+}
+
+void LBFGSMinimizer::setConstraintForce(string _selection, double _springConstant) {
+	AtomSelection sel(*pAtoms);
+	setConstraintForce(sel.select(_selection),_springConstant);
+}
+
+void LBFGSMinimizer::setConstraintForce(AtomPointerVector &_av, double _springConstant) {
+	for(AtomPointerVector::iterator it = _av.begin(); it != _av.end(); it++) {
+		// if the interaction already exists just change the spring constant
+		map<Atom*,SpringConstraintInteraction*>::iterator found = springInteractionPointers.find(*it);
+		if(found == springInteractionPointers.end()) {
+			addSpringInteraction(*it,_springConstant);
+		} else {
+			found->second->setSpringConstant(_springConstant);
+		}
+	}
+}
+
+void LBFGSMinimizer::addSpringInteraction(Atom* _a1, double _springConstant) {
+	SpringConstraintInteraction* scI = new SpringConstraintInteraction(*_a1,_springConstant,0.0);
+	springInteractionPointers[_a1] = scI;
+	pEset->addInteraction(scI);
+}
+
+void LBFGSMinimizer::removeConstraints() {
+	pEset->eraseTerm("SPRING_CONSTRAINT");
+	springInteractionPointers.clear();
+}
+
+void LBFGSMinimizer::setupAtomGradient() {
+	unsigned int gradientSize = 0;
+	for (unsigned int a=0; a < pAtoms->size(); a++) {
+		int index = (*pAtoms)[a]->getMinimizationIndex();
+		if (3 * index > (int)gradientSize) {
+			gradientSize = 3 * index;
+		}
+	}
+	atomGradient.resize(gradientSize);
+}
+
+double LBFGSMinimizer::calcAtomGradient() {
+	atomGradient.assign(atomGradient.size(), 0.0);
+	return pEset->calcEnergyAndEnergyGradient(atomGradient);
+}
+
+bool LBFGSMinimizer::setupVariables(vector<double> & _x) {
+	if (pAtoms == NULL  || pEset == NULL){
+		cerr << "ERROR LBFGSMinimizer::minimize() either pAtoms or energySet is NULL.\n";
+		return false;	 
+	}
+	setupAtomGradient();
+
+	// the variables are the coordinates of the atoms that are not fixed
+	freeAtoms.clear();
+	freeSlots.clear();
+	_x.clear();
+	for (unsigned int a=0; a < pAtoms->size(); a++) {
+		int index = (*pAtoms)[a]->getMinimizationIndex();
+		if (index == -1) {
+			continue;
+		}
+		freeAtoms.push_back((*pAtoms)[a]);
+		freeSlots.push_back(3 * (index - 1));
+		_x.push_back((*pAtoms)[a]->getX());
+		_x.push_back((*pAtoms)[a]->getY());
+		_x.push_back((*pAtoms)[a]->getZ());
+	}
+	return true;
+}
+
+void LBFGSMinimizer::setVariables(const vector<double> & _x) {
+	for (unsigned int i=0; i < freeAtoms.size(); i++) {
+		freeAtoms[i]->setCoor(_x[3*i], _x[3*i+1], _x[3*i+2]);
+	}
+}
+
+double LBFGSMinimizer::energyAndGradient(const vector<double> & _x, vector<double> & _g) {
+	setVariables(_x);
+	double energy = calcAtomGradient();
+
+	for (unsigned int i=0; i < freeAtoms.size(); i++) {
+		const double * grad = &atomGradient[freeSlots[i]];
+		_g[3*i]   = grad[0];
+		_g[3*i+1] = grad[1];
+		_g[3*i+2] = grad[2];
+	}
+	return energy;
+}
+
+void LBFGSMinimizer::searchDirection(const vector<double> & _g, vector<double> & _d) {
+	unsigned int n = _g.size();
+	_d = _g;
+
+	// newest to oldest
+	for (unsigned int k=historyCount; k > 0; k--) {
+		unsigned int slot = (historyStart + k - 1) % historySize;
+		double sq = 0.0;
+		for (unsigned int i=0; i < n; i++) {
+			sq += s[slot][i] * _d[i];
+		}
+		alpha[slot] = rho[slot] * sq;
+		for (unsigned int i=0; i < n; i++) {
+			_d[i] -= alpha[slot] * y[slot][i];
+		}
+	}
+
+	// initial inverse hessian scaled by s'y/y'y of the newest pair
+	unsigned int newest = (historyStart + historyCount - 1) % historySize;
+	double yy = 0.0;
+	for (unsigned int i=0; i < n; i++) {
+		yy += y[newest][i] * y[newest][i];
+	}
+	double gamma = 1.0 / (rho[newest] * yy);
+	for (unsigned int i=0; i < n; i++) {
+		_d[i] *= gamma;
+	}
+
+	// oldest to newest
+	for (unsigned int k=0; k < historyCount; k++) {
+		unsigned int slot = (historyStart + k) % historySize;
+		double yr = 0.0;
+		for (unsigned int i=0; i < n; i++) {
+			yr += y[slot][i] * _d[i];
+		}
+		double beta = rho[slot] * yr;
+		for (unsigned int i=0; i < n; i++) {
+			_d[i] += (alpha[slot] - beta) * s[slot][i];
+		}
+	}
+
+	for (unsigned int i=0; i < n; i++) {
+		_d[i] = -_d[i];
+	}
+}
+
+bool LBFGSMinimizer::minimize(){
+
+	vector<double> x;
+	if (!setupVariables(x)) {
+		return false;
+	}
+
+	unsigned int n = x.size();
+	vector<double> g(n);
+	vector<double> d(n);
+	vector<double> xNew(n);
+	vector<double> gNew(n);
+
+	s.assign(historySize, vector<double>(n, 0.0));
+	y.assign(historySize, vector<double>(n, 0.0));
+	rho.assign(historySize, 0.0);
+	alpha.assign(historySize, 0.0);
+	historyStart = 0;
+	historyCount = 0;
+	iterations = 0;
+	converged = false;
+
+	double f = energyAndGradient(x, g);
+	initialEnergy = f;
+
+	while (iterations < maxIterations) {
+
+		// same test as gsl_multimin_test_gradient
+		double gnorm = 0.0;
+		for (unsigned int i=0; i < n; i++) {
+			gnorm += g[i] * g[i];
+		}
+		gnorm = sqrt(gnorm);
+		if (gnorm < tolerance) {
+			converged = true;
+			break;
+		}
+		iterations++;
+
+		double t = 1.0;
+		double dg = 0.0;
+		if (historyCount > 0) {
+			searchDirection(g, d);
+			for (unsigned int i=0; i < n; i++) {
+				dg += d[i] * g[i];
+			}
+		}
+		if (historyCount == 0 || dg >= 0.0) {
+			// steepest descent with a first step of length stepsize
+			historyCount = 0;
+			for (unsigned int i=0; i < n; i++) {
+				d[i] = -g[i];
+			}
+			dg = -gnorm * gnorm;
+			t = stepsize / gnorm;
+		}
+
+		// backtracking line search (sufficient decrease)
+		bool accepted = false;
+		double fNew = f;
+		for (unsigned int trial=0; trial < 30; trial++) {
+			for (unsigned int i=0; i < n; i++) {
+				xNew[i] = x[i] + t * d[i];
+			}
+			fNew = energyAndGradient(xNew, gNew);
+			if (fNew <= f + 1.0e-4 * t * dg) {
+				accepted = true;
+				break;
+			}
+			// minimum of the quadratic through f, dg and fNew, kept within [0.1t, 0.5t]
+			double denominator = 2.0 * (fNew - f - dg * t);
+			double tNext = 0.5 * t;
+			if (denominator > 0.0) {
+				tNext = -dg * t * t / denominator;
+			}
+			if (tNext < 0.1 * t) {
+				tNext = 0.1 * t;
+			} else if (tNext > 0.5 * t) {
+				tNext = 0.5 * t;
+			}
+			t = tNext;
+		}
+
+		if (!accepted) {
+			if (historyCount > 0) {
+				// the quasi-Newton direction failed, restart from steepest descent
+				historyCount = 0;
+				energyAndGradient(x, g);
+				continue;
+			}
+			// no progress possible along the gradient
+			break;
+		}
+
+		// store the correction pair if the curvature condition holds
+		unsigned int slot = (historyStart + historyCount) % historySize;
+		double sy = 0.0;
+		for (unsigned int i=0; i < n; i++) {
+			s[slot][i] = xNew[i] - x[i];
+			y[slot][i] = gNew[i] - g[i];
+			sy += s[slot][i] * y[slot][i];
+		}
+		if (sy > 1.0e-10) {
+			rho[slot] = 1.0 / sy;
+			if (historyCount < historySize) {
+				historyCount++;
+			} else {
+				historyStart = (historyStart + 1) % historySize;
+			}
+		} else if (historyCount == historySize) {
+			// the slot held the oldest pair, which is now overwritten
+			historyStart = (historyStart + 1) % historySize;
+			historyCount--;
+		}
+
+		x.swap(xNew);
+		g.swap(gNew);
+		f = fNew;
+	}
+
+	// leave the atoms at the best point
+	setVariables(x);
+	minimizedEnergy = f;
+
+	return true;
+}
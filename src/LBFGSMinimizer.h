@@ -0,0 +1,186 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef LBFGSMINIMIZER_H
+#define LBFGSMINIMIZER_H
+
+#include "EnergySet.h"
+#include "AtomPointerVector.h"
+#include "AtomSelection.h"
+#include "System.h"
+#include "SpringConstraintInteraction.h"
+
+/*******************************************************************
+ *  Limited memory BFGS minimizer of the Cartesian coordinates,
+ *  driven by EnergySet::calcEnergyAndEnergyGradient.  It does not
+ *  need GSL and has the same interface as the GSLMinimizer:
+ *
+ *     LBFGSMinimizer min(sys);
+ *     min.fixAtoms("chain B");                  // fixed atoms are removed from the variables
+ *     min.setConstraintForce("name CA", 10.0);  // CA on springs
+ *     min.minimize();
+ *     min.removeConstraints();
+ *
+ *  Convergence uses the same test as the GSL derivative minimizers
+ *  (norm of the gradient below the tolerance). Each line search
+ *  starts with a step of length "stepsize" in the first iteration
+ *  and with the unit quasi-Newton step afterwards (Armijo
+ *  backtracking with a quadratic interpolation).
+ *******************************************************************/
+
+namespace MSL {
+class LBFGSMinimizer  {
+
+	public:
+
+		LBFGSMinimizer();  
+		LBFGSMinimizer(System& _sys);  
+		LBFGSMinimizer(EnergySet* _es, AtomPointerVector* _av);
+		virtual ~LBFGSMinimizer();
+
+		// Minimize
+		bool minimize();	
+
+		// Get, Sets
+		void setSystem(System& _sys);
+
+		void setStepSize(double _stepsize);
+		double getStepSize() const;
+		
+		void setTolerance(double _tol);
+		double getTolerance() const;
+
+		void setMaxIterations(int _maxIter);
+		int getMaxIterations() const;
+
+		// number of (s,y) correction pairs kept (default 8)
+		void setHistorySize(unsigned int _size);
+		unsigned int getHistorySize() const;
+
+		// results of the last minimization
+		double getInitialEnergy() const;
+		double getMinimizedEnergy() const;
+		unsigned int getNumberOfIterations() const;
+		bool getConverged() const;
+
+		/* Restrict Minimization when using pAtoms...
+		* Adds CONSTRAINT interactions to the system's energySet to simulate pAtoms on a spring
+		* So once minimization is done, a single call to removeConstraints is necessary
+		*/
+		void setConstraintForce(std::string _selection, double _springConstant); // overwrites springConstant of existing interactions if selected
+		void setConstraintForce(AtomPointerVector &_av, double _springConstant); // overwrites springConstant of existing interactions if selected
+
+		// exclude pAtoms from minimization - sets their minimization index to -1
+		void fixAtoms(AtomPointerVector &_av);
+		void fixAtoms(std::string _selection);
+
+		void resetConstraints(); // resets all constraint terms to 0.0
+		void removeConstraints(); // deletes all constraint energy terms
+
+	protected:
+
+		/***************************************************
+		 *  The variables being optimized.  By default they are
+		 *  the Cartesian coordinates of the atoms that are
+		 *  not fixed; derived classes (see TorsionMinimizer)
+		 *  can minimize over other degrees of freedom
+		 ***************************************************/
+		// fills _x with the starting values, returns false if minimization is not possible.
+		// The base version requires the atoms and the EnergySet and sizes the atomGradient
+		virtual bool setupVariables(std::vector<double> & _x);
+		// moves the atoms to the point _x
+		virtual void setVariables(const std::vector<double> & _x);
+		// moves the atoms to _x and returns the energy, the gradient with respect to the variables goes in _g
+		virtual double energyAndGradient(const std::vector<double> & _x, std::vector<double> & _g);
+
+		// energy and Cartesian gradient of all atoms (in atomGradient, at 3 * (minimization index - 1))
+		double calcAtomGradient();
+		void setupAtomGradient();
+
+		AtomPointerVector* pAtoms;
+		EnergySet* pEset;
+		std::vector<double> atomGradient;
+
+		double stepsize;
+		double tolerance;
+		int    maxIterations;
+
+	private:
+
+		void setup(EnergySet* _es, AtomPointerVector* _av);
+		void addSpringInteraction(Atom* a1, double _springConstant);
+
+		// L-BFGS two loop recursion: _d = -H * _g
+		void searchDirection(const std::vector<double> & _g, std::vector<double> & _d);
+
+		std::map<Atom*,SpringConstraintInteraction*> springInteractionPointers;
+
+		unsigned int historySize;
+
+		double initialEnergy;
+		double minimizedEnergy;
+		unsigned int iterations;
+		bool converged;
+
+		// the atoms that move (minimization index != -1) and their slot in atomGradient
+		std::vector<Atom*> freeAtoms;
+		std::vector<unsigned int> freeSlots;
+
+		// correction pairs, used as a circular buffer
+		std::vector<std::vector<double> > s;
+		std::vector<std::vector<double> > y;
+		std::vector<double> rho;
+		std::vector<double> alpha;
+		unsigned int historyStart;
+		unsigned int historyCount;
+
+};
+
+//INLINES
+
+inline void LBFGSMinimizer::setStepSize(double _stepsize){ stepsize = _stepsize; }
+inline double LBFGSMinimizer::getStepSize() const { return stepsize;}
+
+inline void LBFGSMinimizer::setTolerance(double _tol){ tolerance = _tol; }
+inline double LBFGSMinimizer::getTolerance() const { return tolerance;}
+
+inline void LBFGSMinimizer::setMaxIterations(int _maxIter){ maxIterations = _maxIter; }
+inline int LBFGSMinimizer::getMaxIterations() const { return maxIterations;}
+
+inline void LBFGSMinimizer::setHistorySize(unsigned int _size){ historySize = _size == 0 ? 1 : _size; }
+inline unsigned int LBFGSMinimizer::getHistorySize() const { return historySize;}
+
+inline double LBFGSMinimizer::getInitialEnergy() const { return initialEnergy;}
+inline double LBFGSMinimizer::getMinimizedEnergy() const { return minimizedEnergy;}
+inline unsigned int LBFGSMinimizer::getNumberOfIterations() const { return iterations;}
+inline bool LBFGSMinimizer::getConverged() const { return converged;}
+
+}
+
+#endif
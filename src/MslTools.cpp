@@ -31,6 +31,9 @@ You should have received a copy of the GNU Lesser General Public
 #include "MslTools.h"
 #include <numeric>    //inner_product
 #include <functional> //plus, equal_to, not2
+#ifdef __OPENMP__
+#include <omp.h>
+#endif
 
 using namespace MSL;
 using namespace std;
@@ -1847,3 +1850,14 @@ vector<double> MslTools::getBoltzmannProbabilities(double _temp, vector<double>&
 	}
 	return probs;
 }
+
+int MslTools::getNumThreads(int _threads) {
+#ifdef __OPENMP__
+	if (_threads <= 0){
+		return omp_get_max_threads();
+	}
+	return _threads;
+#else
+	return 1;
+#endif
+}
@@ -294,6 +294,15 @@ namespace MSL{
 	std::vector<double> getRGB(std::vector<double> &_startRGB, std::vector <double> &_endRGB, double _minValue, double _maxValue, double _value);
 	void rgb2hsv(std::vector<double> &_rgb, std::vector<double> &_hsv);
 	void hsv2rgb(std::vector<double> &_hsv, std::vector<double> &_rgb);
+
+	/*
+             ******************************************
+	     *          THREADS
+	     ******************************************
+	*/
+	// threads for a parallel region when MSL is compiled with OpenMP (MSL_OPENMP=T):
+	// _threads, or all cores if 0 or less (always 1 without OpenMP)
+	int getNumThreads(int _threads);
 	
     }
 };
@@ -59,6 +59,20 @@ double OptimalRMSDCalculator::bestRMSD(AtomPointerVector &_align, AtomPointerVec
     return rmsd;
 }
 
+double OptimalRMSDCalculator::bestRMSD(const vector<double> &_align, const vector<double> &_ref, bool* _suc, bool setTransRot) {
+    rmsd = 999999.0;
+    bool suc = false;
+    if (_align.size() != _ref.size()) {
+		cout << "Two proteins have different length!" << endl;
+    } else if (_align.size() % 3 != 0 || _align.size() == 0) {
+		cout << "Protein length is zero!" << endl;
+    } else {
+		suc = Kabsch(&_align[0], &_ref[0], _align.size() / 3, setTransRot);
+    }
+    if (_suc != NULL) *_suc = suc;
+    return rmsd;
+}
+
 bool OptimalRMSDCalculator::align(AtomPointerVector &_align, AtomPointerVector &_ref, AtomPointerVector& _moveable) {
     rmsd = 999999.0;
 	bool suc = Kabsch(_align, _ref, 1);
@@ -92,6 +106,31 @@ bool OptimalRMSDCalculator::align(AtomPointerVector &_align, AtomPointerVector &
   t    - t(i)   is translation vector for best superposition  (output)
 **************************************************************************/
 bool OptimalRMSDCalculator::Kabsch(AtomPointerVector &_align, AtomPointerVector &_ref, int mode) {
+	int n=_ref.size();
+	if(n != _align.size()) {
+		cout << "Two proteins have different length!" << endl;
+		return false;
+	}
+	if (n<1) {
+		cout << "Protein length is zero!" << endl;
+		return false;
+	} 
+
+	// packed coordinates
+	vector<double> x(3*n);
+	vector<double> y(3*n);
+	for(int i=0; i<n; i++){
+		x[3*i]   = _align[i]->getX();
+		x[3*i+1] = _align[i]->getY();
+		x[3*i+2] = _align[i]->getZ();
+		y[3*i]   = _ref[i]->getX();
+		y[3*i+1] = _ref[i]->getY();
+		y[3*i+2] = _ref[i]->getZ();
+	}
+	return Kabsch(&x[0], &y[0], n, mode);
+}
+
+bool OptimalRMSDCalculator::Kabsch(const double * _align, const double * _ref, int n, int mode) {
 	int i, j, m, m1, l, k;
 	double e0, rms1, d, h, g;
 	double cth, sth, sqrth, p, det, sigma;  
@@ -104,12 +143,6 @@ bool OptimalRMSDCalculator::Kabsch(AtomPointerVector &_align, AtomPointerVector
 	int a_failed=0, b_failed=0;
 	double epsilon=0.00000001;
 	
-	int n=_ref.size();
-	if(n != _align.size()) {
-		cout << "Two proteins have different length!" << endl;
-		return false;
-	}
-	
 	//initializtation
 	rmsd=0;
 	rms1=0;
@@ -136,13 +169,13 @@ bool OptimalRMSDCalculator::Kabsch(AtomPointerVector &_align, AtomPointerVector
 
 	//compute centers for vector sets x, y
 	for(i=0; i<n; i++){
-		xc[0] += _align[i]->getX();
-		xc[1] += _align[i]->getY();
-		xc[2] += _align[i]->getZ();
+		xc[0] += _align[3*i];
+		xc[1] += _align[3*i+1];
+		xc[2] += _align[3*i+2];
 		
-		yc[0] += _ref[i]->getX();
-		yc[1] += _ref[i]->getY();
-		yc[2] += _ref[i]->getZ();
+		yc[0] += _ref[3*i];
+		yc[1] += _ref[3*i+1];
+		yc[2] += _ref[3*i+2];
 	}
 	for(i=0; i<3; i++){
 		xc[i] = xc[i]/(double)n;
@@ -151,21 +184,21 @@ bool OptimalRMSDCalculator::Kabsch(AtomPointerVector &_align, AtomPointerVector
 	
 	//compute e0 and matrix r
 	for (m=0; m<n; m++) {
-		e0 += (_align[m]->getX()-xc[0])*(_align[m]->getX()-xc[0]) \
-		  +(_ref[m]->getX()-yc[0])*(_ref[m]->getX()-yc[0]);
-		e0 += (_align[m]->getY()-xc[1])*(_align[m]->getY()-xc[1]) \
-		  +(_ref[m]->getY()-yc[1])*(_ref[m]->getY()-yc[1]);
-		e0 += (_align[m]->getZ()-xc[2])*(_align[m]->getZ()-xc[2]) \
-		  +(_ref[m]->getZ()-yc[2])*(_ref[m]->getZ()-yc[2]);
-		r[0][0] += (_ref[m]->getX() - yc[0])*(_align[m]->getX() - xc[0]);
-		r[0][1] += (_ref[m]->getX() - yc[0])*(_align[m]->getY() - xc[1]);
-		r[0][2] += (_ref[m]->getX() - yc[0])*(_align[m]->getZ() - xc[2]);
-		r[1][0] += (_ref[m]->getY() - yc[1])*(_align[m]->getX() - xc[0]);
-		r[1][1] += (_ref[m]->getY() - yc[1])*(_align[m]->getY() - xc[1]);
-		r[1][2] += (_ref[m]->getY() - yc[1])*(_align[m]->getZ() - xc[2]);
-		r[2][0] += (_ref[m]->getZ() - yc[2])*(_align[m]->getX() - xc[0]);
-		r[2][1] += (_ref[m]->getZ() - yc[2])*(_align[m]->getY() - xc[1]);
-		r[2][2] += (_ref[m]->getZ() - yc[2])*(_align[m]->getZ() - xc[2]);
+		e0 += (_align[3*m+0]-xc[0])*(_align[3*m+0]-xc[0]) \
+		  +(_ref[3*m+0]-yc[0])*(_ref[3*m+0]-yc[0]);
+		e0 += (_align[3*m+1]-xc[1])*(_align[3*m+1]-xc[1]) \
+		  +(_ref[3*m+1]-yc[1])*(_ref[3*m+1]-yc[1]);
+		e0 += (_align[3*m+2]-xc[2])*(_align[3*m+2]-xc[2]) \
+		  +(_ref[3*m+2]-yc[2])*(_ref[3*m+2]-yc[2]);
+		r[0][0] += (_ref[3*m+0] - yc[0])*(_align[3*m+0] - xc[0]);
+		r[0][1] += (_ref[3*m+0] - yc[0])*(_align[3*m+1] - xc[1]);
+		r[0][2] += (_ref[3*m+0] - yc[0])*(_align[3*m+2] - xc[2]);
+		r[1][0] += (_ref[3*m+1] - yc[1])*(_align[3*m+0] - xc[0]);
+		r[1][1] += (_ref[3*m+1] - yc[1])*(_align[3*m+1] - xc[1]);
+		r[1][2] += (_ref[3*m+1] - yc[1])*(_align[3*m+2] - xc[2]);
+		r[2][0] += (_ref[3*m+2] - yc[2])*(_align[3*m+0] - xc[0]);
+		r[2][1] += (_ref[3*m+2] - yc[2])*(_align[3*m+1] - xc[1]);
+		r[2][2] += (_ref[3*m+2] - yc[2])*(_align[3*m+2] - xc[2]);
 	}
 	//compute determinat of matrix r
 	det = r[0][0] * ( r[1][1]*r[2][2] - r[1][2]*r[2][1] )		\
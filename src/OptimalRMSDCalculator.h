@@ -52,10 +52,13 @@ class OptimalRMSDCalculator {
 	bool align(AtomPointerVector &_align, AtomPointerVector &_ref, AtomPointerVector& _moveable);
 	// quickly calculate RMSD upon optimal superposition without generating the rotation matrix
 	double bestRMSD(AtomPointerVector &_align, AtomPointerVector &_ref, bool* _suc = NULL, bool setTransRot = false);
+	// same on packed x,y,z coordinates (3 doubles per point), the transformation maps _align onto _ref
+	double bestRMSD(const vector<double> &_align, const vector<double> &_ref, bool* _suc = NULL, bool setTransRot = false);
 
  protected:
 	// implemetation of Kabsch algoritm for optimal superposition
 	bool Kabsch(AtomPointerVector &_align, AtomPointerVector &_ref, int mode);
+	bool Kabsch(const double * _align, const double * _ref, int n, int mode);
 
  private:
 	double rmsd;
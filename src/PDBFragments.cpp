@@ -31,10 +31,16 @@ You should have received a copy of the GNU Lesser General Public
 #include "PDBFragments.h"
 #include "BBQTable.h"
 #include "Transforms.h"
+#include "OptimalRMSDCalculator.h"
 #include "AtomSelection.h"
 #include "MslExceptions.h"
 #include "MslOut.h"
 
+#include <algorithm>
+#ifdef __OPENMP__
+#include <omp.h>
+#endif
+
 // BOOST Includes
 #include <boost/regex.hpp>
 
@@ -43,6 +49,20 @@ static MslOut MSLOUT("PDBFragments");
 using namespace MSL;
 using namespace std;
 
+// Find an atom by name in the residue of _res (same chain, number and insertion code)
+static Atom * findAtom(AtomPointerVector &_ats, Atom &_res, string _name){
+	for (uint a = 0; a < _ats.size();a++){
+		if (_ats[a]->getName() == _name &&
+		    _ats[a]->getResidueNumber() == _res.getResidueNumber() &&
+		    _ats[a]->getChainId() == _res.getChainId() &&
+		    _ats[a]->getResidueIcode() == _res.getResidueIcode()){
+			return _ats[a];
+		}
+	}
+	return NULL;
+}
+
+
 int PDBFragments::searchForMatchingDualFragments(System &_sys1, std::vector<std::string> &_stemResidues1,
 						 System &_sys2, std::vector<std::string> &_stemResidues2,
 						 int _loop1min, int _loop1max, int _loop2min, int _loop2max, double _distanceStem1, double _distanceStem2, double _stemRmsdTol, double _totalRmsdTol, bool _matchFirstStemOnly){
@@ -218,42 +238,37 @@ int PDBFragments::searchForMatchingDualFragments(System &_sys1, std::vector<std:
 		     }
 
 
-		     // Load PDB and extract region
-		     string allAtomFileName = MslTools::stringf("%s/%s.pdb",pdbDir.c_str(),loop1Res1.getSegID().c_str());
-		     
-		     System allAtomSys;
-		     allAtomSys.readPdb(allAtomFileName);
-
-		     // Reset segid..
-		     for (uint ats = 0; ats < allAtomSys.getAtomPointers().size();ats++){
-		       allAtomSys.getAtom(ats).setSegID("");
+		     // Load PDB and extract region (the cached System is not modified, its atoms are copied below)
+		     System *allAtomSys = getCachedStructure(loop1Res1.getSegID());
+		     if (allAtomSys == NULL){
+		       continue;
 		     }
 
 		     // Good stem1,stem2 alignment, move the loops onto 
 		     AtomContainer *dualLoops = new AtomContainer();
 
 		     for (uint m = r1; m <= r2;m++){
-		       (*dualLoops).addAtoms(allAtomSys.getPosition(fragDB(m).getPositionId()).getAtomPointers());
+		       (*dualLoops).addAtoms(allAtomSys->getPosition(fragDB(m).getPositionId()).getAtomPointers());
 		     }
 
 		     for (uint m = r3; m <= r4;m++){
-		       (*dualLoops).addAtoms(allAtomSys.getPosition(fragDB(m).getPositionId()).getAtomPointers());
+		       (*dualLoops).addAtoms(allAtomSys->getPosition(fragDB(m).getPositionId()).getAtomPointers());
 		     }
 
 
 		     AtomContainer fullBB;
-		     fullBB.addAtom(allAtomSys.getPosition(fragDB(r1).getPositionId()).getAtom("N"));
-		     fullBB.addAtom(allAtomSys.getPosition(fragDB(r1).getPositionId()).getAtom("CA"));
-		     fullBB.addAtom(allAtomSys.getPosition(fragDB(r1).getPositionId()).getAtom("C"));
-		     fullBB.addAtom(allAtomSys.getPosition(fragDB(r2).getPositionId()).getAtom("N"));
-		     fullBB.addAtom(allAtomSys.getPosition(fragDB(r2).getPositionId()).getAtom("CA"));
-		     fullBB.addAtom(allAtomSys.getPosition(fragDB(r2).getPositionId()).getAtom("C"));
-		     fullBB.addAtom(allAtomSys.getPosition(fragDB(r3).getPositionId()).getAtom("N"));
-		     fullBB.addAtom(allAtomSys.getPosition(fragDB(r3).getPositionId()).getAtom("CA"));
-		     fullBB.addAtom(allAtomSys.getPosition(fragDB(r3).getPositionId()).getAtom("C"));
-		     fullBB.addAtom(allAtomSys.getPosition(fragDB(r4).getPositionId()).getAtom("N"));
-		     fullBB.addAtom(allAtomSys.getPosition(fragDB(r4).getPositionId()).getAtom("CA"));
-		     fullBB.addAtom(allAtomSys.getPosition(fragDB(r4).getPositionId()).getAtom("C"));		     
+		     fullBB.addAtom(allAtomSys->getPosition(fragDB(r1).getPositionId()).getAtom("N"));
+		     fullBB.addAtom(allAtomSys->getPosition(fragDB(r1).getPositionId()).getAtom("CA"));
+		     fullBB.addAtom(allAtomSys->getPosition(fragDB(r1).getPositionId()).getAtom("C"));
+		     fullBB.addAtom(allAtomSys->getPosition(fragDB(r2).getPositionId()).getAtom("N"));
+		     fullBB.addAtom(allAtomSys->getPosition(fragDB(r2).getPositionId()).getAtom("CA"));
+		     fullBB.addAtom(allAtomSys->getPosition(fragDB(r2).getPositionId()).getAtom("C"));
+		     fullBB.addAtom(allAtomSys->getPosition(fragDB(r3).getPositionId()).getAtom("N"));
+		     fullBB.addAtom(allAtomSys->getPosition(fragDB(r3).getPositionId()).getAtom("CA"));
+		     fullBB.addAtom(allAtomSys->getPosition(fragDB(r3).getPositionId()).getAtom("C"));
+		     fullBB.addAtom(allAtomSys->getPosition(fragDB(r4).getPositionId()).getAtom("N"));
+		     fullBB.addAtom(allAtomSys->getPosition(fragDB(r4).getPositionId()).getAtom("CA"));
+		     fullBB.addAtom(allAtomSys->getPosition(fragDB(r4).getPositionId()).getAtom("C"));		     
 
 		     // Move the dualLoops onto the correct frame		       
 		     if (!t.rmsdAlignment(fullBB.getAtomPointers(),stemsFullBB.getAtomPointers(),(*dualLoops).getAtomPointers())) 
@@ -709,56 +724,55 @@ int PDBFragments::searchForMatchingFragmentsSpots(System &_sys, std::vector<std:
 			              Atom &at1 = fullFragCA.getAtom(0);
 			              Atom &at2 = fullFragCA.getAtom(fullFragCA.size()-1);
 
-				      string allAtomFileName = MslTools::stringf("%s/%s.pdb",pdbDir.c_str(),at1.getSegID().c_str());
-
-				      System allAtomSys;
-				      allAtomSys.readPdb(allAtomFileName);
-				      for (uint ats = 0; ats < allAtomSys.getAtomPointers().size();ats++){
-					allAtomSys.getAtom(ats).setSegID("");
+				      // Copy of the matching region of the (cached) all-atom structure
+				      AtomContainer *region = new AtomContainer();
+				      if (!copyFromCachedStructure(at1.getSegID(),at1.getChainId(),at1.getResidueNumber(),at2.getResidueNumber(),region)){
+					delete region;
+					continue;
 				      }
 
-				      AtomSelection sel2(allAtomSys.getAtomPointers());
-
-			    	      stringstream ss;
-				      char tmpstr[100];
-				      //sprintf(tmpstr,"chain %1s and resi %d-%-d and name CA",at1.getChainId().c_str(),at1.getResidueNumber(),at2.getResidueNumber());
-				      sprintf(tmpstr,"chain %1s and resi %d-%-d and name CA",	fragDB[i]->getChainId().c_str(),fragDB[i]->getResidueNumber(),fragDB[thirdPositionIndex]->getResidueNumber());
-				      ss << tmpstr;
-				      AtomPointerVector caAts = sel2.select(ss.str());
-
+				      AtomPointerVector caAts;
+				      for (uint a = 0; a < region->size();a++){
+					if ((*region)[a].getName() == "CA"){
+					  caAts.push_back(&(*region)[a]);
+					}
+				      }
 
-				      if (!tm.rmsdAlignment(caAts,fullFragCA.getAtomPointers(),allAtomSys.getAtomPointers())){
+				      if (!tm.rmsdAlignment(caAts,fullFragCA.getAtomPointers(),region->getAtomPointers())){
 					MSLOUT.stream() << "Problem aligning all atoms using the C-alpha trace"<<endl;
-					MSLOUT.stream() << "PDB: "<<allAtomFileName<<endl;
-					MSLOUT.stream() << "\tTrying to align with: "<<ss.str()<<endl;
-					MSLOUT.stream() << "\tSystem: "<<allAtomSys.getSizes();
-					MSLOUT.stream() << "\tSelected: "<<caAts.size()<<" atoms using '"<<ss.str()<<"'"<<endl;
+					MSLOUT.stream() << "PDB: "<<at1.getSegID()<<endl;
+					MSLOUT.stream() << "\tSelected: "<<caAts.size()<<" CA atoms"<<endl;
 					MSLOUT.stream() << "\tReference: "<<fullFragCA.getAtomPointers().size()<<" atoms"<<endl;
 					MSLOUT.stream() << fullFragCA.getAtomPointers();
+					delete region;
 					continue;
 				      } 
 
 				      // Get BB atoms from stem-equivalent residues
+				      AtomPointerVector regionAts = region->getAtomPointers();
 				      AtomPointerVector allAts_stemBBats;
-				      Position &stem1eq  = allAtomSys.getPosition(MslTools::getPositionId(fragDB[i]->getChainId(),fragDB[i]->getResidueNumber(),fragDB[i]->getResidueIcode()));
-				      allAts_stemBBats.push_back(&stem1eq.getAtom("N"));
-				      allAts_stemBBats.push_back(&stem1eq.getAtom("CA"));
-				      allAts_stemBBats.push_back(&stem1eq.getAtom("C"));
-
-				      Position &stem2eq  = allAtomSys.getPosition(MslTools::getPositionId(fragDB[secondPositionIndex]->getChainId(),fragDB[secondPositionIndex]->getResidueNumber(),fragDB[secondPositionIndex]->getResidueIcode()));
-				      allAts_stemBBats.push_back(&stem2eq.getAtom("N"));
-				      allAts_stemBBats.push_back(&stem2eq.getAtom("CA"));
-				      allAts_stemBBats.push_back(&stem2eq.getAtom("C"));
-
-				      Position &stem3eq  = allAtomSys.getPosition(MslTools::getPositionId(fragDB[thirdPositionIndex]->getChainId(),fragDB[thirdPositionIndex]->getResidueNumber(),fragDB[thirdPositionIndex]->getResidueIcode()));
-				      allAts_stemBBats.push_back(&stem3eq.getAtom("N"));
-				      allAts_stemBBats.push_back(&stem3eq.getAtom("CA"));
-				      allAts_stemBBats.push_back(&stem3eq.getAtom("C"));
+				      allAts_stemBBats.push_back(findAtom(regionAts,*fragDB[i],"N"));
+				      allAts_stemBBats.push_back(findAtom(regionAts,*fragDB[i],"CA"));
+				      allAts_stemBBats.push_back(findAtom(regionAts,*fragDB[i],"C"));
+
+				      allAts_stemBBats.push_back(findAtom(regionAts,*fragDB[secondPositionIndex],"N"));
+				      allAts_stemBBats.push_back(findAtom(regionAts,*fragDB[secondPositionIndex],"CA"));
+				      allAts_stemBBats.push_back(findAtom(regionAts,*fragDB[secondPositionIndex],"C"));
+
+				      allAts_stemBBats.push_back(findAtom(regionAts,*fragDB[thirdPositionIndex],"N"));
+				      allAts_stemBBats.push_back(findAtom(regionAts,*fragDB[thirdPositionIndex],"CA"));
+				      allAts_stemBBats.push_back(findAtom(regionAts,*fragDB[thirdPositionIndex],"C"));
+
+				      if (find(allAts_stemBBats.begin(),allAts_stemBBats.end(),(Atom *)NULL) != allAts_stemBBats.end()){
+					delete region;
+					continue;
+				      }
 				      	
 				      double bbRMSD = allAts_stemBBats.rmsd(stemBBats);
 
 
 				      if (bbRMSD > _rmsdTol){
+					delete region;
 					continue;
 				      }
 				      fprintf(stdout,"(%4s and chain %1s and resi %3d-%3d)  %8.3f ",
@@ -770,13 +784,7 @@ int PDBFragments::searchForMatchingFragmentsSpots(System &_sys, std::vector<std:
 
 				      fprintf(stdout, "%8.3f",bbRMSD);
 
-				      ss.str("");
-				      char tmpstr2[100];
-				      sprintf(tmpstr2,"chain %1s and resi %d-%-d",at1.getChainId().c_str(),at1.getResidueNumber(),at2.getResidueNumber());
-				      ss << tmpstr2;
-				      AtomPointerVector allAts = sel2.select(ss.str());
-				      lastResults.push_back(new AtomContainer());
-				      lastResults.back()->addAtoms(allAts);
+				      lastResults.push_back(region);
 
 
 
@@ -828,46 +836,28 @@ int PDBFragments::searchForMatchingFragmentsLinear(System &_sys, string &_startR
 
 
   MSLOUT.stream() << "FragDB.size(): "<<fragDB.size()<<endl;
+
   // Now loop over all fragments in database checking for ones of the correct size
-  int matchIndex = 0; // Index for keeping track of matches
-  Transforms tm;
-  stringstream ss;
-  for (uint i = 0 ; i < fragDB.size()-residueSeparation;i++){
+  vector<FragmentHit> hits;
+  scanLinear(bbAts,_rmsdTol,hits);
 
-    // Filter by pdb/chain breaks
-    if (fragDB(i).getSegID() != fragDB(i+residueSeparation).getSegID()){
-      continue;
-    }
-    if (fragDB(i).getChainId() != fragDB(i+residueSeparation).getChainId()){
-      continue;
-    }
+  // Sequence filter, in database order so that the match indices do not depend on the threads
+  boost::regex re;
+  if (_regex != ""){
+    re = boost::regex(_regex);
+  }
+  vector<FragmentHit> accepted;
+  for (uint h = 0; h < hits.size();h++){
+    int matchIndex = h+1; // Index for keeping track of matches
+    uint i = hits[h].index;
 
-    AtomPointerVector fragBB;
     string matchSeq = "";
     for (uint j = 0; j <= residueSeparation;j++){
-      fragBB.push_back(&fragDB(i+j));
       matchSeq += MslTools::getOneLetterCode(fragDB(i+j).getResidueName());
     }
 
-
-    fragBB.saveCoor("pre");
-    if (!tm.rmsdAlignment(fragBB,bbAts)){
-      cerr << "ERROR in alignment: "<<fragBB.size()<<" "<<bbAts.size()<<endl;
-      continue;
-    }
-
-    double rmsd = fragBB.rmsd(bbAts);
-    if (rmsd > _rmsdTol){
-      continue;
-    }
-
-    
-    matchIndex++;
-    
-
-
     if (_regex != ""){
-      if (!boost::regex_search(matchSeq.c_str(),boost::regex(_regex))){
+      if (!boost::regex_search(matchSeq.c_str(),re)){
 	MSLOUT.stream() << "RegEx NOT Matched. "<<matchSeq<<endl;
 	continue;
       } else {
@@ -880,66 +870,136 @@ int PDBFragments::searchForMatchingFragmentsLinear(System &_sys, string &_startR
 				   fragDB(i).getChainId().c_str(),
 				   fragDB(i).getResidueNumber(),
 				   fragDB(i).getResidueIcode().c_str(),
-				   fragBB(fragBB.size()-1).getChainId().c_str(),
-				   fragBB(fragBB.size()-1).getResidueNumber(),
-				   fragBB(fragBB.size()-1).getResidueIcode().c_str());
+				   fragDB(i+residueSeparation).getChainId().c_str(),
+				   fragDB(i+residueSeparation).getResidueNumber(),
+				   fragDB(i+residueSeparation).getResidueIcode().c_str());
       matchedSequences[key] = matchSeq;
     }
+    accepted.push_back(hits[h]);
+  }
 
+  // Superimpose the fragments (or their all-atom structure) onto the query
+  int numHits = accepted.size();
+#ifdef __OPENMP__
+  #pragma omp parallel num_threads(getNumThreads())
+#endif
+  {
+    Transforms tm;
+    AtomPointerVector fragBB;
+
+#ifdef __OPENMP__
+    #pragma omp for schedule(dynamic)
+#endif
+    for (int h = 0; h < numHits;h++){
+      FragmentHit &hit = accepted[h];
+
+      fragBB.clear();
+      for (uint j = 0; j <= residueSeparation;j++){
+	fragBB.push_back(fragDB[hit.index+j]);
+      }
+
+      hit.result = new AtomContainer();
+      if (pdbDir != ""){
+	Atom &at1 = fragBB(0);
+	Atom &at2 = fragBB(fragBB.size()-1);
+	if (includeFullFile){
+	  hit.successful = copyFromCachedStructure(at1.getSegID(),at1.getChainId(),at1.getResidueNumber(),at2.getResidueNumber(),NULL,hit.result);
+	} else {
+	  hit.successful = copyFromCachedStructure(at1.getSegID(),at1.getChainId(),at1.getResidueNumber(),at2.getResidueNumber(),hit.result);
+	}
+      } else {
+	// Add CA only atoms..
+	hit.result->addAtoms(fragBB);
+      }
+
+      // The database atoms define the transformation, only the copies are moved
+      if (hit.successful && !tm.rmsdAlignment(fragBB,bbAts,hit.result->getAtomPointers())){
+	hit.successful = false;
+      }
+    }
+  }
+
+  for (uint h = 0; h < accepted.size();h++){
+    FragmentHit &hit = accepted[h];
+    uint i = hit.index;
 
     fprintf(stdout,"(%4s and chain %1s and resi %3d-%3d)  %8.3f \n",
 	    fragDB[i]->getSegID().c_str(),
 	    fragDB[i]->getChainId().c_str(),
 	    fragDB[i]->getResidueNumber(),
-	    fragBB[fragBB.size()-1]->getResidueNumber(),
-	    rmsd);
+	    fragDB[i+residueSeparation]->getResidueNumber(),
+	    hit.rmsd);
 
+    if (!hit.successful){
+      cerr << "ERROR in alignment2: "<<residueSeparation+1<<" "<<bbAts.size()<<endl;
+      delete hit.result;
+      continue;
+    }
 
-    if (pdbDir != ""){
-      fragBB.applySavedCoor("pre");
-      Atom &at1 = fragBB(0);
-      Atom &at2 = fragBB(fragBB.size()-1);
-      string allAtomFileName = MslTools::stringf("%s/%s.pdb",pdbDir.c_str(),at1.getSegID().c_str());
+    lastResults.push_back(hit.result);
+    numFrags++;
+  }
 
 
-      System allAtomSys;
-      allAtomSys.readPdb(allAtomFileName);
-      for (uint ats = 0; ats < allAtomSys.getAtomPointers().size();ats++){
-	allAtomSys.getAtom(ats).setSegID("");
-      }
+  return numFrags;
+}
 
-      if (!tm.rmsdAlignment(fragBB,bbAts,allAtomSys.getAtomPointers())){
-	cerr << "ERROR in alignment2: "<<fragBB.size()<<" "<<bbAts.size()<<endl;
-	continue;
-      }
+void PDBFragments::scanLinear(AtomPointerVector &_bbAts, double _rmsdTol, vector<FragmentHit> &_hits){
+
+  int residueSeparation = _bbAts.size()-1;
+  int numWindows = (int)fragDB.size() - residueSeparation;
+  vector<vector<FragmentHit> > threadHits(getNumThreads());
+
+#ifdef __OPENMP__
+  #pragma omp parallel num_threads(threadHits.size())
+#endif
+  {
+    int tid = 0;
+#ifdef __OPENMP__
+    tid = omp_get_thread_num();
+#endif
+    // Each thread has its own RMSD calculator and pointer list, the database is only read
+    OptimalRMSDCalculator rmsdCalc;
+    AtomPointerVector fragBB;
+    fragBB.reserve(_bbAts.size());
 
+#ifdef __OPENMP__
+    #pragma omp for schedule(static)
+#endif
+    for (int i = 0; i < numWindows;i++){
 
-      lastResults.push_back(new AtomContainer());
-      if (includeFullFile){
-	lastResults.back()->addAtoms(allAtomSys.getAtomPointers());
-      } else {
-	AtomSelection sel2(allAtomSys.getAtomPointers());
-	ss.str("");
-	char tmpstr2[100];
-	sprintf(tmpstr2,"chain %1s and resi %d-%-d",at1.getChainId().c_str(),at1.getResidueNumber(),at2.getResidueNumber());
-	ss << tmpstr2;
-	AtomPointerVector allAts = sel2.select(ss.str());
-	lastResults.back()->addAtoms(allAts);
+      // Filter by pdb/chain breaks
+      if (fragDB[i]->getSegID() != fragDB[i+residueSeparation]->getSegID()){
+	continue;
+      }
+      if (fragDB[i]->getChainId() != fragDB[i+residueSeparation]->getChainId()){
+	continue;
       }
 
-    } else {
+      fragBB.clear();
+      for (uint j = 0; j <= residueSeparation;j++){
+	fragBB.push_back(fragDB[i+j]);
+      }
 
-      // Add CA only atoms..
-      lastResults.push_back(new AtomContainer());
-      lastResults.back()->addAtoms(fragDB);
+      bool success = false;
+      double rmsd = rmsdCalc.bestRMSD(fragBB,_bbAts,&success);
+      if (!success){
+	cerr << "ERROR in alignment: "<<fragBB.size()<<" "<<_bbAts.size()<<endl;
+	continue;
+      }
+      if (rmsd > _rmsdTol){
+	continue;
+      }
 
+      threadHits[tid].push_back(FragmentHit(i,rmsd));
     }
-
-    numFrags++;
   }
 
-
-  return numFrags;
+  _hits.clear();
+  for (uint t = 0; t < threadHits.size();t++){
+    _hits.insert(_hits.end(),threadHits[t].begin(),threadHits[t].end());
+  }
+  sort(_hits.begin(),_hits.end());
 }
 
 /*
@@ -1033,354 +1093,389 @@ int PDBFragments::searchForMatchingFragmentsStems(System &_sys, vector<string> &
 			}
 		}
 
-
-		// BBQTable is used for adding backbone-atoms to a c-alpha trace.
-		BBQTable bbqT;
-		//bbqT.setDebugFlag(true);
-		if (fragType == caOnly){
-
-			// BBQ Table for adding backbone atoms
-			bbqT.openReader(bbqTable);
-		}
-
 		MSLOUT.stream() << "FragDB.size(): "<<fragDB.size()<<endl;
-		// Now loop over all fragments in database checking for ones of the correct size
-		double tol = 64; // Tolerance of distance to be deviant from stems in Angstroms^2
-		int matchIndex = 0; // Index for keeping track of matches
-		for (uint i = 0 ; i < fragDB.size()-(_numResiduesInFragment+stem1.size()+stem2.size());i++){
 
-			// Get proposed ctermStem
-			AtomPointerVector ctermStem;
-			for (uint n = 0; n < stem1.size();n++){
-				ctermStem.push_back(fragDB[i+n]);
-			}
+		// Candidate windows (stem1 + fragment + stem2) from the same pdb and chain, without gaps
+		uint windowSize = _numResiduesInFragment+stem1.size()+stem2.size();
+		vector<uint> windows;
+		for (uint i = 0 ; i < fragDB.size()-windowSize;i++){
 
-			// Get proposed ntermStem
-			AtomPointerVector ntermStem;
-			for (uint n = 0; n < stem2.size();n++){
-				ntermStem.push_back(fragDB[i+stem1.size()+_numResiduesInFragment+n]);
-			}
+			Atom &ctermFirst = fragDB(i);
+			Atom &ctermLast  = fragDB(i+stem1.size()-1);
+			Atom &ntermFirst = fragDB(i+stem1.size()+_numResiduesInFragment);
+			Atom &ntermLast  = fragDB(i+windowSize-1);
 
 			// Check for same PDB
-			if (ctermStem(0).getSegID() != ntermStem(ntermStem.size()-1).getSegID()){
-			  //fprintf(stdout,"New PDB: %4s to %4s\n",ctermStem[0]->getSegID().c_str(),ntermStem(ntermStem.size()-1).getSegID().c_str());
-
+			if (ctermFirst.getSegID() != ntermLast.getSegID()){
 				// Jump ahead to move past all pdb1 v pdb2 tests
 				i = i + _numResiduesInFragment+stem1.size();
 				continue;
 			}
 
-
 			// Check for same Chain
-			if (ctermStem(0).getChainId() != ntermStem(ntermStem.size()-1).getChainId()){
-				/*
-				fprintf(stdout,"New Chain: %4s %1s to %4s %1s\n",
-					ctermStem[0]->getSegID().c_str(),
-					ctermStem[0]->getChainId().c_str(),					
-					ntermStem(ntermStem.size()-1).getSegID().c_str(),
-					ntermStem(ntermStem.size()-1).getChainId().c_str());
-				*/
+			if (ctermFirst.getChainId() != ntermLast.getChainId()){
 				// Jump ahead to move past all chain1 v chain2 tests
 				i = i + _numResiduesInFragment+stem1.size();
 				continue;
 			}
 
-
 			// Check for a gap (PDB Structures have gaps).
-			if ( abs(ctermStem[ctermStem.size()-1]->getResidueNumber() - ntermStem[0]->getResidueNumber()) != _numResiduesInFragment+1){
-				/*
-				fprintf(stdout," Gap found at residue %4s %1s %4d %3s and %4s %1s %4d %3s\n",
-					ctermStem[ctermStem.size()-1]->getSegID().c_str(),
-					ctermStem[ctermStem.size()-1]->getChainId().c_str(),
-					ctermStem[ctermStem.size()-1]->getResidueNumber(),
-					ctermStem[ctermStem.size()-1]->getResidueName().c_str(),
-					ntermStem[0]->getSegID().c_str(),
-					ntermStem[0]->getChainId().c_str(),
-					ntermStem[0]->getResidueNumber(),
-					ntermStem[0]->getResidueName().c_str());
-				*/
+			if ( abs(ctermLast.getResidueNumber() - ntermFirst.getResidueNumber()) != _numResiduesInFragment+1){
 				// Jump ahead to move past gap
 				i = i + _numResiduesInFragment+stem1.size();
 				continue;
 			}
-			
-
-			// Distance Filter... are the proposed stems close enough ?
-			bool passDistanceFilter = true;
-			int index = 0;
-
-			// Check against compiled list of distance-squared's
-			for (uint c = 0; c < ctermStem.size();c++){
-
-			  /*
-				  fprintf(stdout," Checking residue %1s %4d %3s\n",
-				  ctermStem[c]->getChainId().c_str(),
-				  ctermStem[c]->getResidueNumber(),
-				  ctermStem[c]->getResidueName().c_str());
-			  */
-				for (uint n = 0; n < ntermStem.size();n++){
-
-					double distSq = ctermStem[c]->distance2(*ntermStem[n]);
-
-					/*
-					  fprintf(stdout," \t%1s %4d %3s = %8.3f vs %8.3f\n",
-					  ntermStem[n]->getChainId().c_str(),
-					  ntermStem[n]->getResidueNumber(),
-					  ntermStem[n]->getResidueName().c_str(),distSq,stemDistanceSq[index]);
-					*/
-					if (fabs(stemDistanceSq[index++] - distSq) > tol){
-						passDistanceFilter = false;
-						break;
-					}
-				}
-
-				if (!passDistanceFilter){
-					break;
-				}
-			}
-
-
-
-			// Continue if the distance filter not passed
-			if (!passDistanceFilter) {
-				continue;
-			}
-			MSLOUT.stream() << "PASSED DISTANCE FILTER!"<<endl;
-
-			// align and print winning fragment
-
-			// Make a copy of frag stem, so not to effect original atoms
-			AtomPointerVector fragStem;
-			for (uint ct = 0; ct < ctermStem.size();ct++){
-				fragStem.push_back(new Atom(ctermStem(ct)));
-			}
-			for (uint nt = 0; nt < ntermStem.size();nt++){
-				fragStem.push_back(new Atom(ntermStem(nt)));
-			}
-
-			// Align the fragStem to stem to see if it matches well enough...
-			Transforms tm;
-			fragStem.saveCoor("pre");
-			tm.rmsdAlignment(fragStem,stems);
-			
-			double rmsd = fragStem.rmsd(stems);
-			MSLOUT.stream() << "RMSD: "<<rmsd<<endl;
-
-			// Continue if the RMSD filter not passed
-			if (rmsd > _rmsdTol){
-				continue;
-			}
-
-
 
+			windows.push_back(i);
+		}
 
-			matchIndex++;
-			fragStem.applySavedCoor("pre");
+		// Distance and RMSD filters
+		double tol = 64; // Tolerance of distance to be deviant from stems in Angstroms^2
+		vector<FragmentHit> hits;
+		scanStems(windows,stems,stemDistanceSq,stem1.size(),_numResiduesInFragment,tol,_rmsdTol,hits);
 
-			//lastResults->writePdb("/tmp/preAdd.pdb");
+		// Sequence filter, in database order so that the match indices do not depend on the threads
+		boost::regex re;
+		if (_regex != ""){
+			re = boost::regex(_regex);
+		}
+		vector<FragmentHit> accepted;
+		for (uint h = 0; h < hits.size();h++){
+			int matchIndex = h+1; // Index for keeping track of matches
+			uint i = hits[h].index;
 
-			// Create new atoms for middle atoms..
-			AtomPointerVector tmp;
-			index = 1;
 			string matchSeq = "";
-			for (uint f = 0; f < ctermStem.size();f++){
-			        //fragStem(f).setResidueNumber(index++);
-				//fragStem(f).setResidueName("FRG");
-				//fragStem(f).setChainId("A");
-				//fragStem(f).setSegID("");
-				tmp.push_back(&fragStem(f));
-				//cout << "C-ADD: "<<fragStem(f)<<" "<<fragStem(f).getSegID()<<endl;
-				matchSeq += MslTools::getOneLetterCode(fragStem(f).getResidueName());
+			for (uint f = 0; f < windowSize;f++){
+				matchSeq += MslTools::getOneLetterCode(fragDB(i+f).getResidueName());
 			}
 
-
-			for (int f = 0; f < _numResiduesInFragment;f++){
-			        Atom *a =new Atom(fragDB(i+ctermStem.size()+f));
-				//a->setCoor(fragDB(i+ctermStem.size()+f).getCoor());
-				//a->setResidueNumber(index++);
-				//a->setResidueName("FRG");
-				//a->setChainId("A");
-				//a->setSegID("");
-				tmp.push_back(a);
-				//cout << "F-ADD: "<<*a<<" "<<a->getSegID()<<endl;
-
-				matchSeq += MslTools::getOneLetterCode(fragDB(i+ctermStem.size()+f).getResidueName());
-			} 		
-
-
-			for (uint f = 0; f < ntermStem.size();f++){
-				//fragStem(f+ctermStem.size()).setResidueNumber(index++);
-				//fragStem(f+ctermStem.size()).setResidueName("FRG");
-				//fragStem(f+ctermStem.size()).setChainId("A");
-				//fragStem(f+ctermStem.size()).setSegID("");
-				tmp.push_back(&fragStem(f+ctermStem.size()));
-				matchSeq += MslTools::getOneLetterCode(fragStem(f+ctermStem.size()).getResidueName());
-				//cout << "N-ADD: "<<fragStem(f+ctermStem.size())<<" "<<fragStem(f+ctermStem.size()).getSegID()<<endl;
-			}
 			string key = MslTools::stringf("%06d-%s-%1s_%04d%s-%1s_%04d%s",
 						       matchIndex,
-						       fragDB(i+ctermStem.size()).getSegID().c_str(),
-						       fragDB(i+ctermStem.size()).getChainId().c_str(),
-						       fragDB(i+ctermStem.size()).getResidueNumber(),
-						       fragDB(i+ctermStem.size()).getResidueIcode().c_str(),
-						       fragDB(i+ctermStem.size()+_numResiduesInFragment-1).getChainId().c_str(),
-						       fragDB(i+ctermStem.size()+_numResiduesInFragment-1).getResidueNumber(),
-						       fragDB(i+ctermStem.size()+_numResiduesInFragment-1).getResidueIcode().c_str());
+						       fragDB(i+stem1.size()).getSegID().c_str(),
+						       fragDB(i+stem1.size()).getChainId().c_str(),
+						       fragDB(i+stem1.size()).getResidueNumber(),
+						       fragDB(i+stem1.size()).getResidueIcode().c_str(),
+						       fragDB(i+stem1.size()+_numResiduesInFragment-1).getChainId().c_str(),
+						       fragDB(i+stem1.size()+_numResiduesInFragment-1).getResidueNumber(),
+						       fragDB(i+stem1.size()+_numResiduesInFragment-1).getResidueIcode().c_str());
 
 			matchedSequences[key] = matchSeq;
 
 			if (_regex != ""){
-
-
-			  if (!boost::regex_search(matchSeq.c_str(),boost::regex(_regex))){
+			  if (!boost::regex_search(matchSeq.c_str(),re)){
 			    MSLOUT.stream() << "RegEx NOT Matched. "<<matchSeq<<endl;
 			    continue;
 			  } else {
 			    MSLOUT.stream() << "RegEx Matched."<<endl;
 			  }
-
 			}
-			
+			accepted.push_back(hits[h]);
+		}
 
-			Chain tmpChain;
-			tmpChain.addAtoms(tmp);			
+		// Build the matching fragments, each thread with its own BBQTable and Transforms
+		int numHits = accepted.size();
+#ifdef __OPENMP__
+		#pragma omp parallel num_threads(getNumThreads())
+#endif
+		{
+			Transforms tm;
+			BBQTable *bbqT = NULL;
+			AtomPointerVector fragStem;
+			AtomPointerVector window;
+
+#ifdef __OPENMP__
+			#pragma omp for schedule(dynamic)
+#endif
+			for (int h = 0; h < numHits;h++){
+				FragmentHit &hit = accepted[h];
+				uint i = hit.index;
+
+				// The stems of the database fragment define the superposition
+				fragStem.clear();
+				window.clear();
+				for (uint f = 0; f < windowSize;f++){
+					window.push_back(fragDB[i+f]);
+					if (f < stem1.size() || f >= stem1.size()+_numResiduesInFragment){
+						fragStem.push_back(fragDB[i+f]);
+					}
+				}
+				Atom &ctermFirst = fragDB(i);
+				Atom &ntermLast  = fragDB(i+windowSize-1);
+
+				Chain tmpChain;
+				tmpChain.addAtoms(window);
+				tm.rmsdAlignment(fragStem,stems,tmpChain.getAtomPointers());
+
+				hit.report = MslTools::stringf("(%4s and chain %1s and resi %3d-%3d)  %8.3f ",
+							       ctermFirst.getSegID().c_str(),
+							       ctermFirst.getChainId().c_str(),
+							       ctermFirst.getResidueNumber(),
+							       ntermLast.getResidueNumber(),
+							       hit.rmsd);
+
+				if (fragType == caOnly){
+				  if (pdbDir != ""){
+
+					      Atom &at1 = tmpChain.getAtom(0);
+					      Atom &at2 = tmpChain.getAtom(tmpChain.atomSize()-1);
+
+					      hit.result = new AtomContainer();
+					      AtomContainer region;
+					      AtomContainer *fragRegion = includeFullFile ? &region : hit.result;
+					      if (!copyFromCachedStructure(at1.getSegID(),at1.getChainId(),at1.getResidueNumber(),at2.getResidueNumber(),fragRegion,includeFullFile ? hit.result : NULL)){
+						      delete hit.result;
+						      hit.result = NULL;
+						      hit.successful = false;
+						      continue;
+					      }
+
+					      AtomPointerVector caAts;
+					      for (uint a = 0; a < fragRegion->size();a++){
+						      if ((*fragRegion)[a].getName() == "CA"){
+							      caAts.push_back(&(*fragRegion)[a]);
+						      }
+					      }
+					      AtomPointerVector moveable = fragRegion->getAtomPointers();
+					      if (includeFullFile){
+						      moveable += hit.result->getAtomPointers();
+					      }
+
+					      if (!tm.rmsdAlignment(caAts,tmpChain.getAtomPointers(),moveable)){
+						      hit.message = MslTools::stringf("Problem aligning all atoms using the C-alpha trace\n\tSelected: %d CA atoms\n\tReference: %d atoms\n",caAts.size(),tmpChain.getAtomPointers().size());
+						      delete hit.result;
+						      hit.result = NULL;
+						      hit.successful = false;
+						      continue;
+					      } 
+
+					      // Get BB atoms from stem-equivalent residues
+					      AtomPointerVector allAts_stemBBats;
+					      AtomPointerVector regionAts = fragRegion->getAtomPointers();
+					      allAts_stemBBats.push_back(findAtom(regionAts,ctermFirst,"N"));
+					      allAts_stemBBats.push_back(findAtom(regionAts,ctermFirst,"CA"));
+					      allAts_stemBBats.push_back(findAtom(regionAts,ctermFirst,"C"));
+					      allAts_stemBBats.push_back(findAtom(regionAts,ntermLast,"N"));
+					      allAts_stemBBats.push_back(findAtom(regionAts,ntermLast,"CA"));
+					      allAts_stemBBats.push_back(findAtom(regionAts,ntermLast,"C"));
+					      if (find(allAts_stemBBats.begin(),allAts_stemBBats.end(),(Atom *)NULL) != allAts_stemBBats.end()){
+						      hit.message = "Stem backbone atoms not found in the all-atom structure\n";
+						      delete hit.result;
+						      hit.result = NULL;
+						      hit.successful = false;
+						      continue;
+					      }
+
+					      double bbRMSD = allAts_stemBBats.rmsd(stemBBats);
+
+					      hit.message = MslTools::stringf("BB RMSD: %f\n",bbRMSD);
+					      hit.report += MslTools::stringf("%8.3f",bbRMSD);
+					      if (bbRMSD > 1.51){
+						      delete hit.result;
+						      hit.result = NULL;
+						      hit.successful = false;
+						      continue;
+					      }
+
+				  } else if (bbqTable != ""){
+
+					  // BBQTable is used for adding backbone-atoms to a c-alpha trace.
+					  if (bbqT == NULL){
+						  bbqT = new BBQTable();
+						  bbqT->openReader(bbqTable);
+					  }
+					  hit.illegalQuads = bbqT->fillInMissingBBAtoms(tmpChain);
+					  hit.result = new AtomContainer(tmpChain.getAtomPointers());
+				  }
+
+				} else {
+				  hit.message = " ALL ATOMS \n";
+				}
+				hit.report += "\n";
+			}
 
-			
-			tm.rmsdAlignment(fragStem,stems,tmpChain.getAtomPointers());
+			delete bbqT;
+		}
 
+		// Merge the results in database order
+		for (uint h = 0; h < accepted.size();h++){
+			FragmentHit &hit = accepted[h];
 
-			fprintf(stdout,"(%4s and chain %1s and resi %3d-%3d)  %8.3f ",
-				ctermStem[0]->getSegID().c_str(),
-				ctermStem[0]->getChainId().c_str(),
-				ctermStem[0]->getResidueNumber(),
-				ntermStem[ntermStem.size()-1]->getResidueNumber(),
-			        rmsd);
+			fprintf(stdout,"%s",hit.report.c_str());
+			MSLOUT.stream() << hit.message;
 
-			
-			bool successful = true;
-			if (fragType == caOnly){
-			  if (pdbDir != ""){
-			    
-			              Atom &at1 = tmpChain.getAtom(0);
-			              Atom &at2 = tmpChain.getAtom(tmpChain.atomSize()-1);
-
-				      string allAtomFileName = MslTools::stringf("%s/%s.pdb",pdbDir.c_str(),at1.getSegID().c_str());
-				      MSLOUT.stream() << "Opening "<<allAtomFileName<<endl;
-				      System allAtomSys;
-				      allAtomSys.readPdb(allAtomFileName);
-				      for (uint ats = 0; ats < allAtomSys.getAtomPointers().size();ats++){
-					allAtomSys.getAtom(ats).setSegID("");
-				      }
+			illegalQuads += hit.illegalQuads;
+			if (illegalQuads > 0){
+				exit(0);
+			}
 
-				      AtomSelection sel2(allAtomSys.getAtomPointers());
+			if (hit.result != NULL){
+				lastResults.push_back(hit.result);
+			}
 
-			    	      stringstream ss;
-				      char tmpstr[100];
-				      //sprintf(tmpstr,"chain %1s and resi %d-%-d and name CA",at1.getChainId().c_str(),at1.getResidueNumber(),at2.getResidueNumber());
-				      sprintf(tmpstr,"chain %1s and resi %d-%-d and name CA",	ctermStem[0]->getChainId().c_str(),ctermStem[0]->getResidueNumber(),ntermStem[ntermStem.size()-1]->getResidueNumber());
-				      ss << tmpstr;
-				      AtomPointerVector caAts = sel2.select(ss.str());
+			if (hit.successful){
+				numFrags++;
+			}
+		}
 
+		fprintf(stdout,"Number of succesful fragments: %10d, illegal quads: %10d\n",numFrags,illegalQuads);
 
-				      if (!tm.rmsdAlignment(caAts,tmpChain.getAtomPointers(),allAtomSys.getAtomPointers())){
-					MSLOUT.stream() << "Problem aligning all atoms using the C-alpha trace"<<endl;
-					MSLOUT.stream() << "PDB: "<<allAtomFileName<<endl;
-					MSLOUT.stream() << "\tTrying to align with: "<<ss.str()<<endl;
-					MSLOUT.stream() << "\tSystem: "<<allAtomSys.getSizes();
-					MSLOUT.stream() << "\tSelected: "<<caAts.size()<<" atoms using '"<<ss.str()<<"'"<<endl;
-					MSLOUT.stream() << "\tReference: "<<tmpChain.getAtomPointers().size()<<" atoms"<<endl;
-					MSLOUT.stream() << tmpChain.getAtomPointers();
-					successful = false;
-					continue;
-				      } 
+	}
+	
+	
+	return numFrags;
+}
 
-				      // Get BB atoms from stem-equivalent residues
-				      AtomPointerVector allAts_stemBBats;
-				      //Position &stem1eq  = allAtomSys.getPosition(MslTools::getPositionId(at1.getChainId(),at1.getResidueNumber(),at1.getResidueIcode()));
-				      Position &stem1eq  = allAtomSys.getPosition(MslTools::getPositionId(ctermStem[0]->getChainId(),ctermStem[0]->getResidueNumber(),ctermStem[0]->getResidueIcode()));
-				      allAts_stemBBats.push_back(&stem1eq.getAtom("N"));
-				      allAts_stemBBats.push_back(&stem1eq.getAtom("CA"));
-				      allAts_stemBBats.push_back(&stem1eq.getAtom("C"));
-
-				      //Position &stem2eq  = allAtomSys.getPosition(MslTools::getPositionId(at2.getChainId(),at2.getResidueNumber()+stem2.size()-1,at2.getResidueIcode()));
-				      Position &stem2eq  = allAtomSys.getPosition(MslTools::getPositionId(ntermStem[ntermStem.size()-1]->getChainId(),ntermStem[ntermStem.size()-1]->getResidueNumber(),ntermStem[ntermStem.size()-1]->getResidueIcode()));
-				      allAts_stemBBats.push_back(&stem2eq.getAtom("N"));
-				      allAts_stemBBats.push_back(&stem2eq.getAtom("CA"));
-				      allAts_stemBBats.push_back(&stem2eq.getAtom("C"));
-				      	
-				      double bbRMSD = allAts_stemBBats.rmsd(stemBBats);
+void PDBFragments::scanStems(vector<uint> &_windows, AtomPointerVector &_stems, vector<double> &_stemDistanceSq, uint _stem1Size, int _numResiduesInFragment, double _tol, double _rmsdTol, vector<FragmentHit> &_hits){
+
+	uint stem2Size = _stems.size() - _stem1Size;
+	int numWindows = _windows.size();
+	vector<vector<FragmentHit> > threadHits(getNumThreads());
+
+#ifdef __OPENMP__
+	#pragma omp parallel num_threads(threadHits.size())
+#endif
+	{
+		int tid = 0;
+#ifdef __OPENMP__
+		tid = omp_get_thread_num();
+#endif
+		// Each thread has its own RMSD calculator and pointer list, the database is only read
+		OptimalRMSDCalculator rmsdCalc;
+		AtomPointerVector fragStem;
+		fragStem.reserve(_stems.size());
+
+#ifdef __OPENMP__
+		#pragma omp for schedule(static)
+#endif
+		for (int w = 0; w < numWindows;w++){
+			uint i = _windows[w];
+
+			// Proposed ctermStem and ntermStem
+			fragStem.clear();
+			for (uint n = 0; n < _stem1Size;n++){
+				fragStem.push_back(fragDB[i+n]);
+			}
+			for (uint n = 0; n < stem2Size;n++){
+				fragStem.push_back(fragDB[i+_stem1Size+_numResiduesInFragment+n]);
+			}
 
-				      MSLOUT.stream() << "BB RMSD: "<<bbRMSD<<endl;
-				      fprintf(stdout, "%8.3f",bbRMSD);
-				      if (bbRMSD > 1.51){
-					successful = false;
-					continue;
-				      }
-				      MSLOUT.stream() << "ADDDDDDDDDDDDDDDDDING COORDS"<<endl;
-
-
-				      lastResults.push_back(new AtomContainer());
-				      if (includeFullFile){
-					lastResults.back()->addAtoms(allAtomSys.getAtomPointers());
-				      } else {
-					ss.str("");
-					char tmpstr2[100];
-					sprintf(tmpstr2,"chain %1s and resi %d-%-d",at1.getChainId().c_str(),at1.getResidueNumber(),at2.getResidueNumber());
-					ss << tmpstr2;
-					AtomPointerVector allAts = sel2.select(ss.str());
-					lastResults.back()->addAtoms(allAts);
-				      }
+			// Distance Filter... are the proposed stems close enough ?
+			// Check against compiled list of distance-squared's
+			bool passDistanceFilter = true;
+			int index = 0;
+			for (uint c = 0; c < _stem1Size && passDistanceFilter;c++){
+				for (uint n = 0; n < stem2Size;n++){
+					double distSq = fragStem[c]->distance2(*fragStem[_stem1Size+n]);
+					if (fabs(_stemDistanceSq[index++] - distSq) > _tol){
+						passDistanceFilter = false;
+						break;
+					}
+				}
+			}
 
+			// Continue if the distance filter not passed
+			if (!passDistanceFilter) {
+				continue;
+			}
 
+			// Continue if the RMSD filter not passed
+			double rmsd = rmsdCalc.bestRMSD(fragStem,_stems);
+			if (rmsd > _rmsdTol){
+				continue;
+			}
 
+			threadHits[tid].push_back(FragmentHit(i,rmsd));
+		}
+	}
 
+	_hits.clear();
+	for (uint t = 0; t < threadHits.size();t++){
+		_hits.insert(_hits.end(),threadHits[t].begin(),threadHits[t].end());
+	}
+	sort(_hits.begin(),_hits.end());
+}
 
 
-			  } else if (bbqTable != ""){
-			  
-				illegalQuads += bbqT.fillInMissingBBAtoms(tmpChain);
+int PDBFragments::getNumThreads() const {
+	return MslTools::getNumThreads(numThreads);
+}
 
-				if (illegalQuads > 0){
-				  successful = false;
-			  	  exit(0);
-				}
+void PDBFragments::setStructureCacheSize(unsigned int _size){
+	structureCacheSize = _size;
+	while (structureCache.size() > structureCacheSize){
+		map<string, pair<System *, list<string>::iterator> >::iterator oldest = structureCache.find(structureCacheOrder.back());
+		delete oldest->second.first;
+		structureCache.erase(oldest);
+		structureCacheOrder.pop_back();
+	}
+}
 
-				lastResults.push_back(new AtomContainer(tmpChain.getAtomPointers()));
-			  }
-				
-			} else {
-			  MSLOUT.stream() <<" ALL ATOMS "<<endl;
-			}
-			fprintf(stdout,"\n");
+/*
+  Returns the all-atom structure _pdbId from pdbDir (segids are reset), reading it
+  only if it is not already in the cache.  The cached Systems must not be modified,
+  copy the atoms before moving them.  At least one structure is always kept.
+*/
+System * PDBFragments::getCachedStructure(string _pdbId){
+	map<string, pair<System *, list<string>::iterator> >::iterator found = structureCache.find(_pdbId);
+	if (found != structureCache.end()){
+		// move to the front as most recently used
+		structureCacheOrder.splice(structureCacheOrder.begin(),structureCacheOrder,found->second.second);
+		return found->second.first;
+	}
 
-			fragStem.applySavedCoor("pre");
+	string allAtomFileName = MslTools::stringf("%s/%s.pdb",pdbDir.c_str(),_pdbId.c_str());
+	MSLOUT.stream() << "Opening "<<allAtomFileName<<endl;
 
-			if (successful){
-				numFrags++;
-			}
+	System *allAtomSys = new System();
+	if (!allAtomSys->readPdb(allAtomFileName)){
+		cerr << "ERROR 2344 PDBFragments::getCachedStructure(), could not read "<<allAtomFileName<<endl;
+		delete allAtomSys;
+		return NULL;
+	}
+	for (uint ats = 0; ats < allAtomSys->getAtomPointers().size();ats++){
+		allAtomSys->getAtom(ats).setSegID("");
+	}
 
-			/*					
-			stringstream ss;
-			PDBWriter pout;
-			pout.open(ss);
-			pout.write(sys.getAtomPointers());
-			pout.close();
+	// Make room by removing the least recently used structures
+	while (!structureCacheOrder.empty() && structureCache.size() >= structureCacheSize){
+		map<string, pair<System *, list<string>::iterator> >::iterator oldest = structureCache.find(structureCacheOrder.back());
+		delete oldest->second.first;
+		structureCache.erase(oldest);
+		structureCacheOrder.pop_back();
+	}
 
-			matchingFragments.push(pair<double,string>(rmsd,ss.str()));
-			*/
+	structureCacheOrder.push_front(_pdbId);
+	structureCache[_pdbId] = pair<System *, list<string>::iterator>(allAtomSys,structureCacheOrder.begin());
 
+	return allAtomSys;
+}
 
+/*
+  Copies the atoms of residues _startRes to _endRes of chain _chainId (into _region) 
+  and/or all atoms (into _fullFile) of the cached all-atom structure _pdbId.  This is
+  the only access to the cache from the threads.
+*/
+bool PDBFragments::copyFromCachedStructure(string _pdbId, string _chainId, int _startRes, int _endRes, AtomContainer *_region, AtomContainer *_fullFile){
+	bool found = false;
+#ifdef __OPENMP__
+	#pragma omp critical(PDBFragmentsStructureCache)
+#endif
+	{
+		System *allAtomSys = getCachedStructure(_pdbId);
+		if (allAtomSys != NULL){
+			found = true;
+			AtomPointerVector &ats = allAtomSys->getAtomPointers();
+			if (_region != NULL){
+				for (uint a = 0; a < ats.size();a++){
+					if (ats[a]->getChainId() == _chainId && ats[a]->getResidueNumber() >= _startRes && ats[a]->getResidueNumber() <= _endRes){
+						_region->addAtom(*ats[a]);
+					}
+				}
+			}
+			if (_fullFile != NULL){
+				_fullFile->addAtoms(ats);
+			}
 		}
-
-		//fprintf(stdout, "Best RMSD: %8.3f\n",matchingFragments.top().first);
-
-
-		fprintf(stdout,"Number of succesful fragments: %10d, illegal quads: %10d\n",numFrags,illegalQuads);
-
 	}
-	
-	
-	return numFrags;
+	return found;
 }
-
-
@@ -31,6 +31,7 @@ You should have received a copy of the GNU Lesser General Public
 #define PDBFRAGMENTS_H
 
 #include <string>
+#include <list>
 
 #include "AtomPointerVector.h"
 #include "AtomContainer.h"
@@ -75,7 +76,52 @@ class PDBFragments{
 		void printMe();
 
 		void setIncludeFullFile(bool _flag); 
+
+		/*
+		  The linear and stem searches scan the fragment database on
+		  multiple threads when MSL is compiled with MSL_OPENMP=T
+		  (0 = use all available cores).  Hits are always reported
+		  in database order, independently of the number of threads.
+		*/
+		void setNumThreads(int _threads);
+		int getNumThreads() const;
+
+		/*
+		  The all-atom PDBs (see setPdbDir) are read once and kept in
+		  a least-recently-used cache, so that multiple hits from the
+		  same structure do not re-read the same file.
+		*/
+		void setStructureCacheSize(unsigned int _size);
+		unsigned int getStructureCacheSize() const;
+		void clearStructureCache();
+
 	private:
+		// Not copyable, the structure cache owns its Systems
+		PDBFragments(const PDBFragments &_frag);
+		void operator=(const PDBFragments &_frag);
+
+		// A fragment that passed the RMSD filter during a database scan
+		struct FragmentHit {
+			FragmentHit(uint _index, double _rmsd) : index(_index), rmsd(_rmsd), successful(true), illegalQuads(0), result(NULL) {}
+			bool operator<(const FragmentHit &_hit) const { return index < _hit.index; }
+
+			uint index;   // first atom of the fragment in fragDB
+			double rmsd;
+			std::string report;   // printed to stdout when the hits are merged
+			std::string message;  // printed to MSLOUT when the hits are merged
+			bool successful;
+			int illegalQuads;
+			AtomContainer *result;
+		};
+
+		// Candidate scans, they do not change the coordinates of the fragment database
+		void scanLinear(AtomPointerVector &_bbAts, double _rmsdTol, std::vector<FragmentHit> &_hits);
+		void scanStems(std::vector<uint> &_windows, AtomPointerVector &_stems, std::vector<double> &_stemDistanceSq, uint _stem1Size, int _numResiduesInFragment, double _tol, double _rmsdTol, std::vector<FragmentHit> &_hits);
+
+		// Cached all-atom structures from pdbDir
+		System * getCachedStructure(std::string _pdbId);
+		bool copyFromCachedStructure(std::string _pdbId, std::string _chainId, int _startRes, int _endRes, AtomContainer *_region, AtomContainer *_fullFile=NULL);
+
 		std::string fragDbFile;
 		dbAtoms fragType;
 		std::string bbqTable;
@@ -84,6 +130,11 @@ class PDBFragments{
 		bool includeFullFile;
 		map<std::string,std::string> matchedSequences;
 		vector<AtomContainer *> lastResults;
+
+		int numThreads;
+		unsigned int structureCacheSize;
+		std::list<std::string> structureCacheOrder; // most recently used first
+		std::map<std::string, std::pair<System *, std::list<std::string>::iterator> > structureCache;
 };
 
 inline void PDBFragments::setFragDB(std::string _fragdb) { fragDbFile = _fragdb;}
@@ -97,10 +148,13 @@ inline AtomPointerVector PDBFragments::getAtomPointers() {
   }
   return ats;
 }
-inline PDBFragments::PDBFragments() { 	fragType   = caOnly; pdbDir = ""; fragDbFile = ""; bbqTable="";}
+inline PDBFragments::PDBFragments() { 	fragType   = caOnly; pdbDir = ""; fragDbFile = ""; bbqTable=""; includeFullFile = false; numThreads = 0; structureCacheSize = 50;}
 inline PDBFragments::PDBFragments(std::string _fragDbFile,std::string _BBQTableForBackboneAtoms) {
 	fragDbFile = _fragDbFile;
 	pdbDir = "";
+	includeFullFile = false;
+	numThreads = 0;
+	structureCacheSize = 50;
 
 	if (_BBQTableForBackboneAtoms == ""){
 		fragType   = allAtoms;
@@ -111,6 +165,7 @@ inline PDBFragments::PDBFragments(std::string _fragDbFile,std::string _BBQTableF
 
 }
 inline PDBFragments::~PDBFragments() {
+	clearStructureCache();
 }
 inline void PDBFragments::loadFragmentDatabase(){
 	fragDB.load_checkpoint(fragDbFile);
@@ -138,6 +193,22 @@ inline void PDBFragments::setIncludeFullFile(bool _flag){
   includeFullFile = _flag;
 }
 
+inline void PDBFragments::setNumThreads(int _threads){
+  numThreads = _threads;
+}
+
+inline unsigned int PDBFragments::getStructureCacheSize() const {
+  return structureCacheSize;
+}
+
+inline void PDBFragments::clearStructureCache(){
+  for (std::map<std::string, std::pair<System *, std::list<std::string>::iterator> >::iterator it = structureCache.begin(); it != structureCache.end();it++){
+    delete it->second.first;
+  }
+  structureCache.clear();
+  structureCacheOrder.clear();
+}
+
 }
 
 #endif
@@ -29,6 +29,8 @@ You should have received a copy of the GNU Lesser General Public
 
 
 #include "PhiPsiReader.h"
+#include <fstream>
+#include <cstring>
 
 using namespace MSL;
 using namespace std;
@@ -40,6 +42,9 @@ bool PhiPsiReader::read() {
 		return false;
 	}
 
+	if (getFileName() != "" && isBinaryFile(getFileName())) {
+		return readBinary(getFileName());
+	}
 	
 	try { 
 		string residue = "";
@@ -78,3 +83,116 @@ bool PhiPsiReader::read() {
     return true;
 }
 
+/*
+  Binary tables: the file is read with a single read and then
+  parsed from memory
+*/
+static bool readBytes(const vector<char> &_data, size_t &_pos, void *_value, size_t _bytes){
+	if (_data.size() - _pos < _bytes) {
+		return false;
+	}
+	if (_bytes > 0) {
+		memcpy(_value,&_data[_pos],_bytes);
+	}
+	_pos += _bytes;
+	return true;
+}
+static bool readUInt(const vector<char> &_data, size_t &_pos, unsigned int &_value){
+	return readBytes(_data,_pos,&_value,sizeof(unsigned int));
+}
+static bool readString(const vector<char> &_data, size_t &_pos, string &_value){
+	unsigned int size = 0;
+	if (!readUInt(_data,_pos,size) || _data.size() - _pos < size) return false;
+	_value.assign(&_data[0] + _pos,size);
+	_pos += size;
+	return true;
+}
+static bool readStrings(const vector<char> &_data, size_t &_pos, vector<string> &_values){
+	unsigned int size = 0;
+	if (!readUInt(_data,_pos,size) || size > _data.size() - _pos) return false;
+	_values.resize(size);
+	for (unsigned int i=0; i<size; i++) {
+		if (!readString(_data,_pos,_values[i])) return false;
+	}
+	return true;
+}
+static bool readInts(const vector<char> &_data, size_t &_pos, vector<int> &_values, size_t _size){
+	if (_size > (_data.size() - _pos) / sizeof(int)) return false;
+	_values.resize(_size);
+	return _size == 0 || readBytes(_data,_pos,&_values[0],_size * sizeof(int));
+}
+
+bool PhiPsiReader::isBinaryFile(const string & _filename) {
+	ifstream fin(_filename.c_str(),std::ios::binary);
+	if (!fin.is_open()) {
+		return false;
+	}
+	char magic[sizeof(PhiPsiStatistics::binaryMagic)];
+	fin.read(magic,sizeof(magic));
+	return fin.good() && memcmp(magic,PhiPsiStatistics::binaryMagic,sizeof(magic)) == 0;
+}
+
+bool PhiPsiReader::readBinary(const string & _filename) {
+	ifstream fin(_filename.c_str(),std::ios::binary);
+	if (!fin.is_open()){
+		return false;
+	}
+	fin.seekg(0, std::ios::end);
+	vector<char> data((size_t)fin.tellg());
+	fin.seekg(0, std::ios::beg);
+	if (data.size() > 0) {
+		fin.read(&data[0], data.size());
+	}
+	if (!fin.good()) {
+		return false;
+	}
+
+	size_t pos = 0;
+	char magic[sizeof(PhiPsiStatistics::binaryMagic)];
+	unsigned int version = 0;
+	if (!readBytes(data,pos,magic,sizeof(magic)) || memcmp(magic,PhiPsiStatistics::binaryMagic,sizeof(magic)) != 0 || !readUInt(data,pos,version) || version != PhiPsiStatistics::binaryVersion) {
+		cerr << "ERROR 5724: " << _filename << " is not a binary phi/psi table (version " << PhiPsiStatistics::binaryVersion << ") in bool PhiPsiReader::readBinary(const string & _filename)" << endl;
+		return false;
+	}
+
+	// read into local tables, the statistics are changed only if the whole file is valid
+	double gridSize = 0.0;
+	vector<string> residueNames;
+	vector<string> phiBinLabels;
+	vector<string> psiBinLabels;
+	vector<int> residueCounts;
+	vector<int> binCounts;
+	bool ok = readBytes(data,pos,&gridSize,sizeof(double)) && readStrings(data,pos,residueNames) && readStrings(data,pos,phiBinLabels) && readStrings(data,pos,psiBinLabels);
+	ok = ok && readInts(data,pos,residueCounts,residueNames.size());
+	ok = ok && readInts(data,pos,binCounts,(size_t)residueNames.size() * phiBinLabels.size() * psiBinLabels.size());
+	if (!ok || pos != data.size()) {
+		cerr << "ERROR 5725: " << _filename << " is truncated or corrupted in bool PhiPsiReader::readBinary(const string & _filename)" << endl;
+		return false;
+	}
+
+	PhiPsiStatistics & S = phiPsiStat;
+	S.compiled = false;
+	S.gridSize = gridSize;
+	S.residueNames.swap(residueNames);
+	S.phiBinLabels.swap(phiBinLabels);
+	S.psiBinLabels.swap(psiBinLabels);
+	S.residueCounts.swap(residueCounts);
+	S.binCounts.swap(binCounts);
+
+	S.residueIndex.clear();
+	for (unsigned int i=0; i<S.residueNames.size(); i++) {
+		S.residueIndex[S.residueNames[i]] = i;
+	}
+	S.phiBins.resize(S.phiBinLabels.size());
+	for (unsigned int i=0; i<S.phiBinLabels.size(); i++) {
+		S.phiBins[i] = MslTools::toDouble(S.phiBinLabels[i]);
+	}
+	S.psiBins.resize(S.psiBinLabels.size());
+	for (unsigned int i=0; i<S.psiBinLabels.size(); i++) {
+		S.psiBins[i] = MslTools::toDouble(S.psiBinLabels[i]);
+	}
+	S.expandTable();
+	S.computeLookupTables();
+
+	return true;
+}
\ No newline at end of file
@@ -62,6 +62,9 @@ class PhiPsiReader : public Reader {
 		virtual ~PhiPsiReader();
 
 		bool read();
+		// the compiled tables written by PhiPsiWriter::writeBinary (read() detects them)
+		bool readBinary(const std::string & _filename);
+		static bool isBinaryFile(const std::string & _filename);
 
 		PhiPsiStatistics & getPhiPsiStatistics();
 
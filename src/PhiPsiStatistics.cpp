@@ -32,10 +32,15 @@ You should have received a copy of the GNU Lesser General Public
 using namespace MSL;
 using namespace std;
 
+const char PhiPsiStatistics::binaryMagic[8] = {'M','S','L','P','H','P','S','B'};
+const unsigned int PhiPsiStatistics::binaryVersion = 1;
 
 
 PhiPsiStatistics::PhiPsiStatistics(){
     gridSize = 0.0f;
+    compiled = false;
+    phiBinStep = 0.0;
+    psiBinStep = 0.0;
 }
 PhiPsiStatistics::PhiPsiStatistics(const PhiPsiStatistics &_phiPsiStat){
 	copy(_phiPsiStat);
@@ -50,6 +55,7 @@ void PhiPsiStatistics::copy(const PhiPsiStatistics &_phiPsiStat){
 
     phiPsiTable = _phiPsiStat.getPhiPsiCounts();
     gridSize = _phiPsiStat.gridSize;
+    compiled = false;
 }
 
 void PhiPsiStatistics::addStatisitics(string _residueType, string _phiBin, string _psiBin, int _count){
@@ -71,6 +77,7 @@ void PhiPsiStatistics::addStatisitics(string _residueType, string _phiBin, strin
      //cout << "Adding: "<<ss.str()<<" "<<_count<<endl;
      phiPsiTable[ss.str()]     += _count;
      phiPsiTable[_residueType] += _count;
+     compiled = false;
 
     
 }
@@ -88,18 +95,15 @@ int PhiPsiStatistics::operator()(string _key){
 }
 
 int PhiPsiStatistics::getCounts(string resName, double phi, double psi){
-    stringstream ss;
-	ss << resName <<":"<<getPhiPsiBin(phi)<<":"<<getPhiPsiBin(psi);
-
-	//cout << "Key: "<<ss.str()<<"."<<endl;
-	map<string, int>::iterator it;
-	it = phiPsiTable.find(ss.str());
-	if (it == phiPsiTable.end()){
-		cout << "No Phi/Psi entry found for " << ss.str() << "." <<endl;
-		return MslTools::intMax;
+	int index = getTableIndex(resName, phi, psi);
+	if (index >= 0) {
+		return binCounts[index];
 	}
-	
-	return it->second;
+
+	stringstream ss;
+	ss << resName <<":"<<getPhiPsiBin(phi)<<":"<<getPhiPsiBin(psi);
+	cout << "No Phi/Psi entry found for " << ss.str() << "." <<endl;
+	return MslTools::intMax;
 }
 
 int PhiPsiStatistics::getCounts(const Residue &nMinus1, const Residue &n, const Residue &nPlus1){
@@ -117,52 +121,25 @@ double PhiPsiStatistics::getFreqInBin(string resName, double phi, double psi){
 	if (AAxyz == MslTools::intMax) {
 		return MslTools::doubleMax;
 	}
-	double AAxyzDouble = (double)AAxyz;
 
-	stringstream allkey;
-	allkey << "ALL" << ":" << getPhiPsiBin(phi) << ":" << getPhiPsiBin(psi);
-
-	map<string,int>::iterator it;
-	it = phiPsiTable.find(allkey.str());
-	if (it == phiPsiTable.end()){
+	// Counts for all residues in the same bin
+	int allIndex = getTableIndex("ALL", phi, psi);
+	if (allIndex < 0) {
 		return MslTools::doubleMax;
 	}
-	int AAallyz = it->second;
-	double AAallyzDouble = (double)AAallyz;
-
 
-	return (AAxyzDouble  / AAallyzDouble);
+	return ((double)AAxyz  / (double)binCounts[allIndex]);
 
 	
 }
 double PhiPsiStatistics::getProbability(string &resName, double phi, double psi){
-
-        // Counts for residue type in phi,psi bin
-	int AAxyz = getCounts(resName, phi, psi);
-	if (AAxyz == MslTools::intMax) {
-		return MslTools::doubleMax;
-	}
-
-	// Total number of counts for residue type "resName"
-	map<string,int>::iterator it;
-	it = phiPsiTable.find(resName);
-	if (it == phiPsiTable.end()) {
+	int index = getTableIndex(resName, phi, psi);
+	if (index < 0) {
+		// print the missing entry
+		getCounts(resName, phi, psi);
 		return MslTools::doubleMax;
 	}
-	int AAx   = it->second;
-	
-	double AAxyzDouble = (double)AAxyz;
-	double AAxDouble   = (double)AAx;
-
-	//double mlogprob = 0.0;
-	if (AAxyzDouble > 0.00001 && AAxDouble > 0.00001){
-		//mlogprob = -log(AAxyzDouble / AAxDouble);
-                //cout << "Vals: "<<phi<<","<<psi<<" "<<AAxyzDouble<<" "<<AAxDouble<<endl;
-		return AAxyzDouble/ AAxDouble;
-	}
-
-	//return mlogprob;
-	return 0.0;
+	return binProbability[index];
 }
 
 double PhiPsiStatistics::getProbability(const Residue &nMinus1, const Residue &n, const Residue &nPlus1){
@@ -175,29 +152,16 @@ double PhiPsiStatistics::getProbability(const Residue &nMinus1, const Residue &n
 
 double PhiPsiStatistics::getProbabilityAll(double phi, double psi){
 	// (#AA-Phi-Psi(all,y,z) / #AA(all)) 
-	int AAallyz = 0;
-	int AAall   = 0;
-
-	stringstream allkey;
-	allkey << "ALL" << ":" << getPhiPsiBin(phi) << ":" << getPhiPsiBin(psi);
-
-	map<string,int>::iterator it;
-	it = phiPsiTable.find(allkey.str());
-	if (it == phiPsiTable.end()){
+	int index = getTableIndex("ALL", phi, psi);
+	if (index < 0) {
 		return MslTools::doubleMax;
 	}
-	AAallyz = it->second;
-	double AAallyzDouble = (double)AAallyz;
-
-	it = phiPsiTable.find("ALL");
-	if (it == phiPsiTable.end()){
+	int AAall = residueCounts[residueIndex["ALL"]];
+	if (AAall == MslTools::intMax) {
 		return MslTools::doubleMax;
 	}
-	AAall = it->second;
 
-	double AAallDouble   = (double)AAall;
-
-	return AAallyzDouble / AAallDouble;
+	return (double)binCounts[index] / (double)AAall;
 }
 
 double PhiPsiStatistics::getProbabilityAll(const Residue &nMinus1, const Residue &n, const Residue &nPlus1){
@@ -208,40 +172,13 @@ double PhiPsiStatistics::getProbabilityAll(const Residue &nMinus1, const Residue
 }
 
 double PhiPsiStatistics::getPropensity(string &resName, double phi, double psi){
-	//  propensity(x,y,z) = 
-	//	  (#AA-Phi-Psi(x,y,z)   / #AA(x)) 
-	//	  -------------------------------
-	//	  (#AA-Phi-Psi(all,y,z) / #AA(all)) 
-    double small = 0.0001;
-    double bigProp = 30.0f;
-
-	double probRes = getProbability(resName, phi, psi);
-	double probAll = getProbabilityAll(phi, psi);
-
-    if( (probRes == MslTools::doubleMax) || (probAll == MslTools::doubleMax))
-        return MslTools::doubleMax;
-
-	// If this Phi/Psi combination is rare in general and for this
-    // AA in particular, return 1.  In other words, this Amino Acid
-    // is no more or less likely than the average to have this Phi/Psi comb.
-    // Also, cap the probability of this Phi/Psi combination for the average
-    // AA to some small number.
-    if( (probRes < small) && (probAll < small) )
-        return 1.0;
-    else if( (probAll < small) ) {
-        // Note, we should never have a case where probAll == 0 but probRes
-        // doesn't.  That wouldn't really make sense.  However, I suppose
-        // due to some float imprecision, it is better to be safe here and
-        // explicitly check for that.
-        if(probAll == 0.0)
-            return bigProp;
-            
-        double prop = probRes/probAll;
-        if(prop > bigProp)
-            return bigProp;
-    }
-
-	return probRes/probAll;
+	int index = getTableIndex(resName, phi, psi);
+	if (index < 0) {
+		// print the missing entry
+		getCounts(resName, phi, psi);
+		return MslTools::doubleMax;
+	}
+	return binPropensity[index];
 }
 
 double PhiPsiStatistics::getPropensity(const Residue &nMinus1, const Residue &n, const Residue &nPlus1){
@@ -288,6 +225,182 @@ void PhiPsiStatistics::computeTotalCounts(){
 	}
 
 	phiPsiTable["ALL"] = runningTotal;
+	compiled = false;
+}
+
+void PhiPsiStatistics::compile() {
+	/*************************************************************
+	 *  Collect the residue types and the phi and psi bins from the
+	 *  keys ("RES:phiBin:psiBin" and "RES") and fill the dense
+	 *  count tables, then derive the probabilities
+	 *************************************************************/
+	residueNames.clear();
+	residueIndex.clear();
+	phiBinLabels.clear();
+	psiBinLabels.clear();
+
+	map<double,string> phiLabels;
+	map<double,string> psiLabels;
+	vector<vector<string> > keys;
+	keys.reserve(phiPsiTable.size());
+	for (map<string,int>::iterator it = phiPsiTable.begin(); it != phiPsiTable.end(); it++) {
+		keys.push_back(vector<string>());
+		vector<string> & toks = keys.back();
+		string::size_type start = 0;
+		string::size_type colon;
+		while ((colon = it->first.find(':', start)) != string::npos) {
+			toks.push_back(it->first.substr(start, colon - start));
+			start = colon + 1;
+		}
+		toks.push_back(it->first.substr(start));
+		if (toks.size() != 3 && toks.size() != 1) {
+			continue;
+		}
+		if (residueIndex.find(toks[0]) == residueIndex.end()) {
+			residueIndex[toks[0]] = residueNames.size();
+			residueNames.push_back(toks[0]);
+		}
+		if (toks.size() == 3) {
+			phiLabels.insert(pair<double,string>(MslTools::toDouble(toks[1]), toks[1]));
+			psiLabels.insert(pair<double,string>(MslTools::toDouble(toks[2]), toks[2]));
+		}
+	}
+
+	phiBins.clear();
+	psiBins.clear();
+	for (map<double,string>::iterator it = phiLabels.begin(); it != phiLabels.end(); it++) {
+		phiBins.push_back(it->first);
+		phiBinLabels.push_back(it->second);
+	}
+	for (map<double,string>::iterator it = psiLabels.begin(); it != psiLabels.end(); it++) {
+		psiBins.push_back(it->first);
+		psiBinLabels.push_back(it->second);
+	}
+
+	residueCounts.assign(residueNames.size(), MslTools::intMax);
+	binCounts.assign(residueNames.size() * phiBins.size() * psiBins.size(), MslTools::intMax);
+	unsigned int k = 0;
+	for (map<string,int>::iterator it = phiPsiTable.begin(); it != phiPsiTable.end(); it++, k++) {
+		vector<string> & toks = keys[k];
+		if (toks.size() == 1) {
+			residueCounts[residueIndex[toks[0]]] = it->second;
+		} else if (toks.size() == 3) {
+			unsigned int phi = lower_bound(phiBins.begin(), phiBins.end(), MslTools::toDouble(toks[1])) - phiBins.begin();
+			unsigned int psi = lower_bound(psiBins.begin(), psiBins.end(), MslTools::toDouble(toks[2])) - psiBins.begin();
+			binCounts[(residueIndex[toks[0]] * phiBins.size() + phi) * psiBins.size() + psi] = it->second;
+		}
+	}
+
+	computeLookupTables();
+}
+
+void PhiPsiStatistics::computeLookupTables() {
+	// the bins are looked up by index if they form a regular grid
+	phiBinStep = 0.0;
+	psiBinStep = 0.0;
+	if (phiBins.size() > 1) {
+		phiBinStep = (phiBins.back() - phiBins[0]) / (phiBins.size() - 1);
+		for (unsigned int i=1; i<phiBins.size(); i++) {
+			if (fabs(phiBins[i] - phiBins[i-1] - phiBinStep) > 0.001 * phiBinStep) {
+				phiBinStep = 0.0;
+				break;
+			}
+		}
+	}
+	if (psiBins.size() > 1) {
+		psiBinStep = (psiBins.back() - psiBins[0]) / (psiBins.size() - 1);
+		for (unsigned int i=1; i<psiBins.size(); i++) {
+			if (fabs(psiBins[i] - psiBins[i-1] - psiBinStep) > 0.001 * psiBinStep) {
+				psiBinStep = 0.0;
+				break;
+			}
+		}
+	}
+
+	unsigned int binsPerResidue = phiBins.size() * psiBins.size();
+	binProbability.assign(binCounts.size(), MslTools::doubleMax);
+	binPropensity.assign(binCounts.size(), MslTools::doubleMax);
+	cumulative.assign(binCounts.size(), 0.0);
+
+	std::map<std::string,unsigned int>::iterator found = residueIndex.find("ALL");
+	int all = found == residueIndex.end() ? -1 : found->second;
+
+	for (unsigned int r=0; r<residueNames.size(); r++) {
+		double AAx = (double)residueCounts[r];
+		double total = 0.0;
+		for (unsigned int b=0; b<binsPerResidue; b++) {
+			unsigned int i = r * binsPerResidue + b;
+			if (binCounts[i] == MslTools::intMax) {
+				cumulative[i] = total;
+				continue;
+			}
+			total += (double)binCounts[i];
+			cumulative[i] = total;
+
+			// (#AA-Phi-Psi(x,y,z) / #AA(x))
+			if (residueCounts[r] == MslTools::intMax) {
+				continue;
+			}
+			double AAxyz = (double)binCounts[i];
+			double probRes = 0.0;
+			if (AAxyz > 0.00001 && AAx > 0.00001){
+				probRes = AAxyz / AAx;
+			}
+			binProbability[i] = probRes;
+
+			//  propensity(x,y,z) = 
+			//	  (#AA-Phi-Psi(x,y,z)   / #AA(x)) 
+			//	  -------------------------------
+			//	  (#AA-Phi-Psi(all,y,z) / #AA(all)) 
+			if (all < 0 || residueCounts[all] == MslTools::intMax || binCounts[all * binsPerResidue + b] == MslTools::intMax) {
+				continue;
+			}
+			double probAll = (double)binCounts[all * binsPerResidue + b] / (double)residueCounts[all];
+
+			double small = 0.0001;
+			double bigProp = 30.0f;
+
+			// If this Phi/Psi combination is rare in general and for this
+			// AA in particular, return 1.  In other words, this Amino Acid
+			// is no more or less likely than the average to have this Phi/Psi comb.
+			// Also, cap the probability of this Phi/Psi combination for the average
+			// AA to some small number.
+			if( (probRes < small) && (probAll < small) ) {
+				binPropensity[i] = 1.0;
+			} else if( (probAll < small) && (probAll == 0.0 || probRes/probAll > bigProp) ) {
+				binPropensity[i] = bigProp;
+			} else {
+				binPropensity[i] = probRes/probAll;
+			}
+		}
+
+		// normalized cumulative distribution for getRandomPhiPsi
+		if (total > 0.0) {
+			for (unsigned int b=0; b<binsPerResidue; b++) {
+				cumulative[r * binsPerResidue + b] /= total;
+			}
+		}
+	}
+
+	compiled = true;
+}
+
+void PhiPsiStatistics::expandTable() {
+	// rebuild the keys from the compiled tables (binary input)
+	phiPsiTable.clear();
+	unsigned int binsPerResidue = phiBins.size() * psiBins.size();
+	for (unsigned int r=0; r<residueNames.size(); r++) {
+		if (residueCounts[r] != MslTools::intMax) {
+			phiPsiTable[residueNames[r]] = residueCounts[r];
+		}
+		for (unsigned int b=0; b<binsPerResidue; b++) {
+			int count = binCounts[r * binsPerResidue + b];
+			if (count == MslTools::intMax) {
+				continue;
+			}
+			phiPsiTable[residueNames[r] + ":" + phiBinLabels[b / psiBins.size()] + ":" + psiBinLabels[b % psiBins.size()]] = count;
+		}
+	}
 }
 
 double PhiPsiStatistics::getPhiPsiBin(double _in){
@@ -338,71 +451,30 @@ double PhiPsiStatistics::getOmega(const Residue &n, const Residue &nPlus1){
 
 
 pair<double,double> PhiPsiStatistics::getRandomPhiPsi(std::string _resType){
+	if (!compiled) {
+		compile();
+	}
 
-
-    std::map<std::string,PhiPsiRNG *>::iterator itRand = phiPsiRandom.find(_resType);
-
-
-    // If we do not have a random number generator, then build one for this residue type
-    if (itRand == phiPsiRandom.end()){
-	    std::map<std::string,int>::iterator itPhiPsi = phiPsiTable.find(_resType);
-
-	    // If we have no data on this residue type then error.
-	    if (itPhiPsi == phiPsiTable.end()){
+	// If we have no data on this residue type then error.
+	int res = getResidueIndex(_resType);
+	unsigned int binsPerResidue = phiBins.size() * psiBins.size();
+	if (res < 0 || binsPerResidue == 0 || cumulative[(res + 1) * binsPerResidue - 1] == 0.0){
 		cerr << "ERROR 6495 PhiPsiStatistics::getRandomPhiPsi(string resType) could not find resType in dataset("<<_resType<<")\n";
-	        exit(6495);
-	    }
-
-	    // We don't have a random number generator, but we do have data for this residueType.
-	    PhiPsiRNG *ppRNG = new PhiPsiRNG();
-
-	    // Iterate over keys in phiPsiTable, look for ones with data for this residue, store
-	    for (itPhiPsi = phiPsiTable.begin();itPhiPsi != phiPsiTable.end();itPhiPsi++){
-
-		std::string key = itPhiPsi->first;
-		std::vector<std::string> tokens = MslTools::tokenize(key, ":");
-
-		// Skip keys that are not in this format 'resName:phiBin:psiBin"
-		if (tokens.size() != 3) continue;
-
-		double phiMid = MslTools::toDouble(tokens[1]) + gridSize/2;
-		double psiMid = MslTools::toDouble(tokens[2]) + gridSize/2;
-
-		ppRNG->counts.push_back((double)itPhiPsi->second);
-		ppRNG->phiPsiValues.push_back(std::pair<double,double>(phiMid,psiMid));
-
-	    }	    
-
-
-	/*  CONVERSION NO LONGER NEEDED
-	    // Convert to c-style array for GSL
-	    double arr[ppRNG->counts.size()];
-	    for (uint i = 0; i  < ppRNG->counts.size();i++){
-		arr[i] = ppRNG->counts[i];
-	    }
-	*/
-
-	    //ppRNG->rng.setDiscreteProb(arr, ppRNG->counts.size());
-	    ppRNG->rng.setDiscreteProb(ppRNG->counts);
-
-
-	    phiPsiRandom[_resType] = ppRNG;
-	    ppRNG = NULL;
-
-
-	    // Now find it!
-	    itRand = phiPsiRandom.find(_resType);
-	    
-    }
+		exit(6495);
+	}
 
+	// binary search of the cumulative distribution of the residue type
+	vector<double>::iterator begin = cumulative.begin() + res * binsPerResidue;
+	vector<double>::iterator end = begin + binsPerResidue;
+	vector<double>::iterator found = upper_bound(begin, end, rng.getRandomDouble());
+	if (found == end) {
+		found--;
+	}
+	// skip the empty bins that precede the last one with counts
+	unsigned int b = found - begin;
+	while (binCounts[res * binsPerResidue + b] == MslTools::intMax || binCounts[res * binsPerResidue + b] <= 0) {
+		b--;
+	}
 
-    PhiPsiRNG *ppRNG = itRand->second;    
-    
-    
-    return ppRNG->getRandomAngles();
+	return pair<double,double>(phiBins[b / psiBins.size()] + gridSize/2, psiBins[b % psiBins.size()] + gridSize/2);
 }
-    
-
-
-
-
@@ -37,6 +37,23 @@ You should have received a copy of the GNU Lesser General Public
 
 // STL Includes
 #include <stdio.h>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+
+/*************************************************************************
+ *  The counts are stored under string keys ("RES:phiBin:psiBin", "RES"
+ *  for the residue totals) as they are read.  On the first lookup they
+ *  are compiled into dense per-residue-type tables indexed by phi and psi
+ *  bin (see compile()), with the normalized probabilities, propensities
+ *  and the cumulative distributions for sampling precomputed, so that
+ *  getCounts/getProbability/getPropensity are O(1) and getRandomPhiPsi
+ *  is a binary search.  Adding statistics invalidates the tables.
+ *
+ *  The compiled tables can be saved in binary form with
+ *  PhiPsiWriter::writeBinary, PhiPsiReader::read recognizes the format.
+ *************************************************************************/
 
 namespace MSL { 
 class PhiPsiStatistics {
@@ -72,50 +89,115 @@ class PhiPsiStatistics {
 		 */
 		
 		std::pair<double,double> getRandomPhiPsi(std::string _resType);
+		RandomNumberGenerator & getRandomNumberGenerator(); // to seed the sampling
 
 		std::map<std::string,int>  getPhiPsiCounts() const { return phiPsiTable; }
 		double getPhiPsiBin(double _angle);
+
+		// build the lookup tables (called automatically by the first lookup)
+		void compile();
+		bool isCompiled() const;
+
 	private:
      
+		friend class PhiPsiReader;
+		friend class PhiPsiWriter;
+
+		// header of the binary tables (PhiPsiWriter::writeBinary)
+		static const char binaryMagic[8];
+		static const unsigned int binaryVersion;
 
 		void copy(const PhiPsiStatistics &_phiPsiStat);
+		void computeLookupTables();
+		void expandTable();
+		int getResidueIndex(const std::string & _resName);
+		int getBinIndex(const std::vector<double> & _bins, double _binStep, double _value) const;
+		int getTableIndex(const std::string & _resName, double _phi, double _psi); // -1 if there is no entry
+
                 double gridSize;
 
 		std::map<std::string,int> phiPsiTable;
 
-		struct PhiPsiRNG {
-		    RandomNumberGenerator rng;
-		    std::vector<double> counts;
-		    std::vector<std::pair<double,double> > phiPsiValues;
-
-		    /* NO LONGER NEEDED, DEFAULTED IN THE OBJECT
-		    PhiPsiRNG(){
-			rng.setRNGType("knuthran2002");
-			rng.setRNGTimeBasedSeed();
-		    }
-		    */
-
-		    std::pair<double,double>& getRandomAngles(){
-			    int randomIndex = rng.getRandomDiscreteIndex();
-			    if (randomIndex < 0 || randomIndex > phiPsiValues.size()){
-				    std::cerr << "ERROR 3432 PhiPsiStatistics::PhiPsiRNG::getRandomAngles(), index is bigger than data size..."<<randomIndex<<" size: "<<phiPsiValues.size()<<"\n";
-				exit(3432);
-			    }
-			    return phiPsiValues[randomIndex];
-		    }
-		};
-
-		std::map<std::string,PhiPsiRNG *> phiPsiRandom;
-
+		/*************************************************************
+		 *  Compiled tables.  The bins are sorted by value (the labels
+		 *  are the strings of the input, used to rebuild the keys),
+		 *  the residue types include ALL.  The per-bin tables are
+		 *  [residue][phi][psi], MslTools::intMax (counts) or
+		 *  MslTools::doubleMax (probability, propensity) if the
+		 *  table has no entry; the cumulative distribution is
+		 *  normalized and includes only the entries of the residue.
+		 *************************************************************/
+		bool compiled;
+		std::vector<std::string> residueNames;
+		std::map<std::string,unsigned int> residueIndex;
+		std::vector<double> phiBins;
+		std::vector<double> psiBins;
+		std::vector<std::string> phiBinLabels;
+		std::vector<std::string> psiBinLabels;
+		double phiBinStep;
+		double psiBinStep;
+		std::vector<int> residueCounts;
+		std::vector<int> binCounts;
+		std::vector<double> binProbability;
+		std::vector<double> binPropensity;
+		std::vector<double> cumulative;
+
+		RandomNumberGenerator rng;
 
 };
 
 inline	void   PhiPsiStatistics::setGridSize(double _gridSize){
   gridSize = _gridSize;
+  compiled = false;
 }
 inline 	double PhiPsiStatistics::getGridSize(){
   return gridSize;
 }	
+inline bool PhiPsiStatistics::isCompiled() const { return compiled; }
+inline RandomNumberGenerator & PhiPsiStatistics::getRandomNumberGenerator() { return rng; }
+inline int PhiPsiStatistics::getResidueIndex(const std::string & _resName) {
+	std::map<std::string,unsigned int>::const_iterator found = residueIndex.find(_resName);
+	if (found == residueIndex.end()) {
+		return -1;
+	}
+	return found->second;
+}
+inline int PhiPsiStatistics::getBinIndex(const std::vector<double> & _bins, double _binStep, double _value) const {
+	// regular grids are indexed directly, otherwise binary search
+	if (_bins.empty()) {
+		return -1;
+	}
+	if (_binStep > 0.0) {
+		int i = (int)floor((_value - _bins[0]) / _binStep + 0.5);
+		if (i >= 0 && i < _bins.size() && _bins[i] == _value) {
+			return i;
+		}
+	}
+	std::vector<double>::const_iterator found = std::lower_bound(_bins.begin(), _bins.end(), _value);
+	if (found == _bins.end() || *found != _value) {
+		return -1;
+	}
+	return found - _bins.begin();
+}
+inline int PhiPsiStatistics::getTableIndex(const std::string & _resName, double _phi, double _psi) {
+	if (!compiled) {
+		compile();
+	}
+	int res = getResidueIndex(_resName);
+	if (res < 0) {
+		return -1;
+	}
+	int phi = getBinIndex(phiBins, phiBinStep, getPhiPsiBin(_phi));
+	int psi = getBinIndex(psiBins, psiBinStep, getPhiPsiBin(_psi));
+	if (phi < 0 || psi < 0) {
+		return -1;
+	}
+	int index = (res * phiBins.size() + phi) * psiBins.size() + psi;
+	if (binCounts[index] == MslTools::intMax) {
+		return -1;
+	}
+	return index;
+}
 
 }
 
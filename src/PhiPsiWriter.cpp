@@ -28,6 +28,7 @@ You should have received a copy of the GNU Lesser General Public
 */
 
 #include "PhiPsiWriter.h"
+#include <fstream>
 
 using namespace MSL;
 using namespace std;
@@ -62,4 +63,55 @@ bool PhiPsiWriter::write(PhiPsiStatistics &_stat) {
 	return true;
 }
 
+/*
+  Binary tables
+*/
+static void writeUInt(ofstream &_fout, unsigned int _value){
+	_fout.write((const char*)&_value,sizeof(unsigned int));
+}
+static void writeString(ofstream &_fout, const string &_value){
+	writeUInt(_fout,_value.size());
+	_fout.write(_value.c_str(),_value.size());
+}
+static void writeStrings(ofstream &_fout, const vector<string> &_values){
+	writeUInt(_fout,_values.size());
+	for (unsigned int i=0; i<_values.size(); i++) {
+		writeString(_fout,_values[i]);
+	}
+}
+
+bool PhiPsiWriter::writeBinary(PhiPsiStatistics &_stat, const string & _filename) {
+	/***************************************************************
+	 *  Layout (native byte order, unsigned int sizes):
+	 *    magic, version
+	 *    grid size (double), residue names, phi and psi bin labels,
+	 *    residue counts, then the bin counts as a single block
+	 *    of ints ([residue][phi][psi], MslTools::intMax for the
+	 *    missing entries)
+	 ***************************************************************/
+	if (!_stat.isCompiled()) {
+		_stat.compile();
+	}
 
+	ofstream fout(_filename.c_str(),std::ios::binary);
+	if (!fout.is_open()){
+		cerr << "WARNING 23480: cannot open " << _filename << " for writing in bool PhiPsiWriter::writeBinary(PhiPsiStatistics &_stat, const string & _filename)" << endl;
+		return false;
+	}
+
+	fout.write(PhiPsiStatistics::binaryMagic,sizeof(PhiPsiStatistics::binaryMagic));
+	writeUInt(fout,PhiPsiStatistics::binaryVersion);
+
+	fout.write((const char*)&_stat.gridSize,sizeof(double));
+	writeStrings(fout,_stat.residueNames);
+	writeStrings(fout,_stat.phiBinLabels);
+	writeStrings(fout,_stat.psiBinLabels);
+	if (_stat.residueCounts.size() > 0) {
+		fout.write((const char*)&_stat.residueCounts[0],_stat.residueCounts.size() * sizeof(int));
+	}
+	if (_stat.binCounts.size() > 0) {
+		fout.write((const char*)&_stat.binCounts[0],_stat.binCounts.size() * sizeof(int));
+	}
+
+	return fout.good();
+}
@@ -54,6 +54,8 @@ class PhiPsiWriter : public Writer {
 
 		// Member Functions
 		bool write(PhiPsiStatistics &_stat);
+		// the compiled tables (read back by PhiPsiReader::read)
+		bool writeBinary(PhiPsiStatistics &_stat, const std::string & _filename);
 
 		bool open();               // There is a default implementation
 		bool open(const std::string &_filename); // There is a default implementation
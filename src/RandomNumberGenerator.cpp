@@ -62,6 +62,7 @@ RandomNumberGenerator::RandomNumberGenerator(bool includeUpperLimit){
 
 #else
 	// seed it with time by default
+	privateStream = false;
 	setTimeBasedSeed();
 	randType = "";
 #endif
@@ -172,15 +173,41 @@ void RandomNumberGenerator::setSeed(int _seed){
 	randSeed = _seed;
 
 #ifndef __GSL__
+	privateStream = false;
 	srand(_seed);
 #else
 	gsl_rng_set(rngObj, _seed);
 #endif
 }
 
+void RandomNumberGenerator::setSeed(int _seed, unsigned int _stream){
+	if (_seed == 0) {
+		_seed = (unsigned int)time((time_t *)NULL);
+	}
+	randSeed = _seed;
+
+#ifndef __GSL__
+	privateStream = true;
+	stream.setSeed(_seed, _stream);
+#else
+	// GSL generators are already private, derive the seed from the stream
+	RandomStream derived(_seed, _stream);
+	gsl_rng_set(rngObj, derived.getRandomInt(4294967294UL) + 1);
+#endif
+}
+
+#ifndef __GSL__
+int RandomNumberGenerator::nextRand(){
+	if (privateStream) {
+		return (int)stream.getRandomInt(RAND_MAX);
+	}
+	return rand();
+}
+#endif
+
 double RandomNumberGenerator::getRandomDouble(){
 #ifndef __GSL__
-	return (double)rand() / (double)RAND_MAX;
+	return (double)nextRand() / (double)RAND_MAX;
 #else
 	return gsl_rng_uniform(rngObj); 
 #endif
@@ -188,14 +215,14 @@ double RandomNumberGenerator::getRandomDouble(){
 
 double RandomNumberGenerator::getRandomDouble(double _upperLimit) {
 #ifndef __GSL__
-	return _upperLimit * (double)rand() / (double)RAND_MAX;
+	return _upperLimit * (double)nextRand() / (double)RAND_MAX;
 #else
 	return getRandomDouble() * _upperLimit;
 #endif
 }
 double RandomNumberGenerator::getRandomDouble(double _lowerLimit, double _upperLimit) {
 #ifndef __GSL__
-	return ((_upperLimit - _lowerLimit) * (double)rand() / (double)RAND_MAX) + _lowerLimit;
+	return ((_upperLimit - _lowerLimit) * (double)nextRand() / (double)RAND_MAX) + _lowerLimit;
 #else
 	return getRandomDouble() * (_upperLimit - _lowerLimit) + _lowerLimit;
 #endif
@@ -203,7 +230,7 @@ double RandomNumberGenerator::getRandomDouble(double _lowerLimit, double _upperL
 
 unsigned long int RandomNumberGenerator::getRandomInt(){
 #ifndef __GSL__
-	return rand();
+	return nextRand();
 #else
 	return gsl_rng_get(rngObj); 
 #endif
@@ -212,7 +239,7 @@ unsigned long int RandomNumberGenerator::getRandomInt(){
 
 unsigned long int RandomNumberGenerator::getRandomInt(unsigned long int _upperLimit){
 #ifndef __GSL__
-	return rand() % (_upperLimit + upperLimitOffset);
+	return nextRand() % (_upperLimit + upperLimitOffset);
 #else
 	return gsl_rng_uniform_int(rngObj,_upperLimit+upperLimitOffset); 
 #endif
@@ -220,7 +247,7 @@ unsigned long int RandomNumberGenerator::getRandomInt(unsigned long int _upperLi
 
 long int RandomNumberGenerator::getRandomInt(long int _lowerLimit, long int _upperLimit){
 #ifndef __GSL__
-	return _lowerLimit + rand() % (_upperLimit + upperLimitOffset - _lowerLimit);
+	return _lowerLimit + nextRand() % (_upperLimit + upperLimitOffset - _lowerLimit);
 #else
 	return gsl_rng_uniform_int(rngObj,_upperLimit+upperLimitOffset-_lowerLimit) + _lowerLimit; 
 #endif
@@ -49,6 +49,27 @@ You should have received a copy of the GNU Lesser General Public
 
 
 namespace MSL { 
+/*************************************************************************
+ *  A small random stream (xorshift64*) with its own state, for code
+ *  that draws random numbers from several threads (without GSL the
+ *  RandomNumberGenerator uses the global rand()).
+ *
+ *  Streams with the same seed and different indices are independent,
+ *  so a parallel sampler can give each of its N samples the stream
+ *  (seed, i) and the result does not depend on the number of threads.
+ *************************************************************************/
+class RandomStream {
+	public:
+		RandomStream(unsigned int _seed=0, unsigned int _stream=0);
+		void setSeed(unsigned int _seed, unsigned int _stream=0);
+
+		double getRandomDouble(); // between 0 and 1 (excluded)
+		unsigned long int getRandomInt(unsigned long int _upperLimit); // between 0 and _upperLimit (included)
+
+	private:
+		unsigned long long state;
+};
+
 class RandomNumberGenerator {
 	
 	public:
@@ -62,6 +83,10 @@ class RandomNumberGenerator {
 		std::string getRNGTypeGSL(); // Directly from GSL
 
 		void setSeed(int _seed);
+		// seed a private stream from (seed, stream): without GSL the
+		// generator then stops drawing from the global rand(), so each
+		// object used on its own thread gives reproducible numbers
+		void setSeed(int _seed, unsigned int _stream);
 		void setTimeBasedSeed();
 		unsigned int getSeed() const;
 
@@ -96,7 +121,10 @@ class RandomNumberGenerator {
 		
 
 #ifndef __GSL__
+		int nextRand(); // rand() or the private stream
 		std::vector<double> cumulProb;
+		bool privateStream;
+		RandomStream stream;
 #else
 		const gsl_rng_type *Type;
 		gsl_rng *rngObj;
@@ -110,6 +138,30 @@ inline unsigned int RandomNumberGenerator::getSeed() const {
 	return randSeed;
 }
 
+inline RandomStream::RandomStream(unsigned int _seed, unsigned int _stream) {
+	setSeed(_seed, _stream);
+}
+inline void RandomStream::setSeed(unsigned int _seed, unsigned int _stream) {
+	// splitmix64 of the seed and the stream index (the state cannot be 0)
+	unsigned long long z = (((unsigned long long)_seed << 32) | _stream) + 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	state = z ^ (z >> 31);
+	if (state == 0) {
+		state = 0x9E3779B97F4A7C15ULL;
+	}
+}
+inline double RandomStream::getRandomDouble() {
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	// the top 53 bits
+	return (double)((state * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+}
+inline unsigned long int RandomStream::getRandomInt(unsigned long int _upperLimit) {
+	return (unsigned long int)(getRandomDouble() * ((double)_upperLimit + 1.0));
+}
+
 }
 
 #endif
@@ -0,0 +1,189 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "RigidTransform.h"
+
+using namespace MSL;
+using namespace std;
+
+RigidTransform::RigidTransform() {
+	setIdentity();
+}
+
+RigidTransform::RigidTransform(const CartesianPoint & _translation) {
+	setIdentity();
+	setTranslation(_translation);
+}
+
+RigidTransform::RigidTransform(const Matrix & _rotation, const CartesianPoint & _rotCenter) {
+	setIdentity();
+	if (!setRotation(_rotation, _rotCenter)) {
+		// same as rotating a CartesianPoint by a matrix that is not 3x3
+		cerr << "ERROR 9143: incorrect matrix size (" << _rotation.getRows() << "x" << _rotation.getCols() << ") in RigidTransform::RigidTransform(const Matrix & _rotation, const CartesianPoint & _rotCenter)" << endl;
+		exit(9143);
+	}
+}
+
+RigidTransform::RigidTransform(const RigidTransform & _transform) {
+	operator=(_transform);
+}
+
+RigidTransform::~RigidTransform() {
+}
+
+void RigidTransform::operator=(const RigidTransform & _transform) {
+	for (unsigned int i=0; i<9; i++) {
+		rot[i] = _transform.rot[i];
+	}
+	for (unsigned int i=0; i<3; i++) {
+		center[i] = _transform.center[i];
+		shift[i] = _transform.shift[i];
+	}
+	rotate_flag = _transform.rotate_flag;
+	shift_flag = _transform.shift_flag;
+}
+
+void RigidTransform::setIdentity() {
+	for (unsigned int i=0; i<9; i++) {
+		rot[i] = 0.0;
+	}
+	rot[0] = 1.0;
+	rot[4] = 1.0;
+	rot[8] = 1.0;
+	for (unsigned int i=0; i<3; i++) {
+		center[i] = 0.0;
+		shift[i] = 0.0;
+	}
+	rotate_flag = false;
+	shift_flag = false;
+}
+
+void RigidTransform::setTranslation(const CartesianPoint & _translation) {
+	shift[0] = _translation.getX();
+	shift[1] = _translation.getY();
+	shift[2] = _translation.getZ();
+	shift_flag = true;
+}
+
+bool RigidTransform::setRotation(const Matrix & _rotation, const CartesianPoint & _rotCenter) {
+	if (_rotation.getRows() != 3 || _rotation.getCols() != 3) {
+		cerr << "ERROR 9144: incorrect matrix size (" << _rotation.getRows() << "x" << _rotation.getCols() << ") in bool RigidTransform::setRotation(const Matrix & _rotation, const CartesianPoint & _rotCenter)" << endl;
+		return false;
+	}
+	for (unsigned int i=0; i<3; i++) {
+		for (unsigned int j=0; j<3; j++) {
+			rot[i*3+j] = _rotation.getElement(i, j);
+		}
+	}
+	setRotationCenter(_rotCenter);
+	rotate_flag = true;
+	return true;
+}
+
+bool RigidTransform::setRotation(const Quaternion & _q, const CartesianPoint & _rotCenter) {
+	Quaternion q(_q);
+	Matrix m(3, 3, 0.0);
+	if (!q.convertToRotationMatrix(m)) {
+		return false;
+	}
+	return setRotation(m, _rotCenter);
+}
+
+void RigidTransform::setRotationCenter(const CartesianPoint & _rotCenter) {
+	center[0] = _rotCenter.getX();
+	center[1] = _rotCenter.getY();
+	center[2] = _rotCenter.getZ();
+}
+
+Matrix RigidTransform::getRotationMatrix() const {
+	Matrix m(3, 3, 0.0);
+	for (unsigned int i=0; i<3; i++) {
+		for (unsigned int j=0; j<3; j++) {
+			m[i][j] = rot[i*3+j];
+		}
+	}
+	return m;
+}
+
+void RigidTransform::apply(CartesianPoint ** _points, unsigned int _n) const {
+	/***************************************************************
+	 *  The elements are copied to locals so that the compiler can
+	 *  keep them in registers (the points could alias the members
+	 *  otherwise) and the two flags are tested once per batch
+	 ***************************************************************/
+	const double r0 = rot[0], r1 = rot[1], r2 = rot[2];
+	const double r3 = rot[3], r4 = rot[4], r5 = rot[5];
+	const double r6 = rot[6], r7 = rot[7], r8 = rot[8];
+	const double cx = center[0], cy = center[1], cz = center[2];
+	const double tx = shift[0], ty = shift[1], tz = shift[2];
+
+	if (rotate_flag) {
+		for (unsigned int i=0; i<_n; i++) {
+			CartesianPoint & p = *_points[i];
+			double x = p.getX() - cx;
+			double y = p.getY() - cy;
+			double z = p.getZ() - cz;
+			p.setCoor((r0*x + r1*y + r2*z) + cx, (r3*x + r4*y + r5*z) + cy, (r6*x + r7*y + r8*z) + cz);
+		}
+	}
+	if (shift_flag) {
+		for (unsigned int i=0; i<_n; i++) {
+			CartesianPoint & p = *_points[i];
+			p.setCoor(p.getX() + tx, p.getY() + ty, p.getZ() + tz);
+		}
+	}
+}
+
+void RigidTransform::apply(double * _xyz, unsigned int _n) const {
+	const double r0 = rot[0], r1 = rot[1], r2 = rot[2];
+	const double r3 = rot[3], r4 = rot[4], r5 = rot[5];
+	const double r6 = rot[6], r7 = rot[7], r8 = rot[8];
+	const double cx = center[0], cy = center[1], cz = center[2];
+	const double tx = shift[0], ty = shift[1], tz = shift[2];
+
+	double * p = _xyz;
+	double * end = _xyz + 3 * (size_t)_n;
+	if (rotate_flag) {
+		for (; p != end; p += 3) {
+			double x = p[0] - cx;
+			double y = p[1] - cy;
+			double z = p[2] - cz;
+			p[0] = (r0*x + r1*y + r2*z) + cx;
+			p[1] = (r3*x + r4*y + r5*z) + cy;
+			p[2] = (r6*x + r7*y + r8*z) + cz;
+		}
+	}
+	if (shift_flag) {
+		for (p = _xyz; p != end; p += 3) {
+			p[0] += tx;
+			p[1] += ty;
+			p[2] += tz;
+		}
+	}
+}
@@ -0,0 +1,140 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef RIGIDTRANSFORM_H
+#define RIGIDTRANSFORM_H
+
+#include <vector>
+
+#include "CartesianPoint.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+
+/*************************************************************************
+ *  A fixed size rigid body transformation (a 3x3 rotation around a
+ *  center followed by a translation), applied with batch kernels.
+ *
+ *  The Matrix class is a std::vector<std::vector<double> >, and rotating
+ *  a CartesianPoint by it goes through a size check and two levels of
+ *  indirection per element.  RigidTransform keeps the nine elements in
+ *  a plain array and applies them to a whole list of coordinates (or
+ *  to a packed x,y,z buffer) in one tight loop.
+ *
+ *  The operations are carried out in the same order as
+ *     p -= center;  p *= rotation;  p += center;  p += translation;
+ *  so the result is identical to the CartesianPoint operators.
+ *
+ *  Usage:
+ *     RigidTransform t;
+ *     t.setRotation(CartesianGeometry::getRotationMatrix(30.0, axis), center);
+ *     t.apply(atom.getAllCoor());
+ *************************************************************************/
+
+namespace MSL { 
+class RigidTransform {
+	public:
+		RigidTransform(); // identity
+		RigidTransform(const CartesianPoint & _translation);
+		RigidTransform(const Matrix & _rotation, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0)); // exits if the matrix is not 3x3
+		RigidTransform(const RigidTransform & _transform);
+		~RigidTransform();
+
+		void operator=(const RigidTransform & _transform);
+
+		void setIdentity();
+		void setTranslation(const CartesianPoint & _translation);
+		bool setRotation(const Matrix & _rotation, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0)); // false if not 3x3
+		bool setRotation(const Quaternion & _q, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0));
+		void setRotationCenter(const CartesianPoint & _rotCenter);
+
+		bool isIdentity() const;
+		bool hasRotation() const;
+		bool hasTranslation() const;
+		Matrix getRotationMatrix() const;
+		CartesianPoint getRotationCenter() const;
+		CartesianPoint getTranslation() const;
+
+		// single point
+		void apply(CartesianPoint & _point) const;
+		CartesianPoint transform(const CartesianPoint & _point) const;
+
+		// batch kernels
+		void apply(std::vector<CartesianPoint*> & _points) const;
+		void apply(CartesianPoint ** _points, unsigned int _n) const;
+		void apply(double * _xyz, unsigned int _n) const; // packed x0 y0 z0 x1 y1 z1...
+
+	private:
+		double rot[9]; // row major
+		double center[3];
+		double shift[3];
+		bool rotate_flag;
+		bool shift_flag;
+};
+
+// INLINE FUNCTIONS
+inline bool RigidTransform::isIdentity() const {return !rotate_flag && !shift_flag;}
+inline bool RigidTransform::hasRotation() const {return rotate_flag;}
+inline bool RigidTransform::hasTranslation() const {return shift_flag;}
+inline CartesianPoint RigidTransform::getRotationCenter() const {return CartesianPoint(center[0], center[1], center[2]);}
+inline CartesianPoint RigidTransform::getTranslation() const {return CartesianPoint(shift[0], shift[1], shift[2]);}
+inline void RigidTransform::apply(CartesianPoint & _point) const {
+	double x = _point.getX();
+	double y = _point.getY();
+	double z = _point.getZ();
+	if (rotate_flag) {
+		x -= center[0];
+		y -= center[1];
+		z -= center[2];
+		double rx = rot[0]*x + rot[1]*y + rot[2]*z;
+		double ry = rot[3]*x + rot[4]*y + rot[5]*z;
+		double rz = rot[6]*x + rot[7]*y + rot[8]*z;
+		x = rx + center[0];
+		y = ry + center[1];
+		z = rz + center[2];
+	}
+	if (shift_flag) {
+		x += shift[0];
+		y += shift[1];
+		z += shift[2];
+	}
+	_point.setCoor(x, y, z);
+}
+inline CartesianPoint RigidTransform::transform(const CartesianPoint & _point) const {
+	CartesianPoint out(_point);
+	apply(out);
+	return out;
+}
+inline void RigidTransform::apply(std::vector<CartesianPoint*> & _points) const {
+	if (!_points.empty()) {
+		apply(&_points[0], _points.size());
+	}
+}
+}
+
+#endif
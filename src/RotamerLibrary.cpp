@@ -36,6 +36,9 @@ You should have received a copy of the GNU Lesser General Public
 using namespace MSL;
 using namespace std;
 
+const char RotamerLibrary::binaryMagic[8] = {'M','S','L','R','O','T','L','B'};
+const unsigned int RotamerLibrary::binaryVersion = 1;
+
 
 RotamerLibrary::RotamerLibrary() {
 	setup();
@@ -511,7 +514,12 @@ bool RotamerLibrary::readFile(string _filename, string _beblFile, bool _append)
 		reset();  // Remove this??
 	}
 	
-	if (!rotReader->open(_filename) || !rotReader->read()) { 
+	if (RotamerLibraryReader::isBinaryFile(_filename)) {
+		if (!rotReader->readBinary(_filename)) {
+			cerr << "WARNING 3836: cannot read binary rotamer library file " << _filename << " in bool SystemRotamerLoader::readFile(string _filename, string _beblFile,bool append)" << endl;
+			return false;
+		}
+	} else if (!rotReader->open(_filename) || !rotReader->read()) { 
 		cerr << "WARNING 3836: cannot read rotamer library file " << _filename << " in bool SystemRotamerLoader::readFile(string _filename, string _beblFile,bool append)" << endl;
 		return false;
 	 }
@@ -545,6 +553,10 @@ bool RotamerLibrary::writeFile(string _filename, string _beblFile) {
 }
 
 
+bool RotamerLibrary::writeBinaryFile(string _filename) {
+	return rotWriter->writeBinary(this, _filename);
+}
+
 vector<vector<double> > RotamerLibrary::getInternalCoor(std::string _libName, std::string _resName, double _phi, double _psi) {
 	
 	if(!beblResidueExists(_resName)) {
@@ -552,14 +564,30 @@ vector<vector<double> > RotamerLibrary::getInternalCoor(std::string _libName, st
 	}
 
 	vector<vector<double> > internalCoor;
+	if (!residueExists(_libName, _resName)) {
+		return internalCoor;
+	}
+	// use the conformations in place, without copying them all
+	const vector<vector<double> > & conformers = lastFoundRes->second.internalCoor;
 	pair<int,int> phiPsiBin = getPhiPsiBin(_resName, _phi, _psi);
 	vector<unsigned>& confIndices = bebl[_resName][phiPsiBin.first][phiPsiBin.second].confIndices;
-	vector<vector<double> > conformers = getInternalCoor(_libName,_resName);   
+	internalCoor.reserve(confIndices.size());
 	for(int i = 0; i < confIndices.size(); i++) {
 		internalCoor.push_back(conformers[confIndices[i]]);	
 	}
 	return internalCoor;
 }
+
+unsigned int RotamerLibrary::size(std::string _libName, std::string _resName, double _phi, double _psi) {
+	if(!beblResidueExists(_resName)) {
+		return size(_libName, _resName);
+	}
+	if (!residueExists(_libName, _resName)) {
+		return 0;
+	}
+	pair<int,int> phiPsiBin = getPhiPsiBin(_resName, _phi, _psi);
+	return bebl[_resName][phiPsiBin.first][phiPsiBin.second].confIndices.size();
+}
 unsigned int RotamerLibrary::getLevel(std::string _levelName, std::string _resName, double _phi, double _psi) {
 	int levelIdx = 0;
 	for(levelIdx = 0; levelIdx < levelLabels.size(); levelIdx++) {
@@ -605,8 +633,10 @@ pair<int,int> RotamerLibrary::getPhiPsiBin(string _resName, double _phi, double
 	pair<int,int> phiPsiBins = make_pair(getDefaultBin(), getDefaultBin());
 
 	//cout << "UUUU " << _resName << " " << _phi << " " << _psi << " " << phiBin << " " << psiBin << endl;
-	if(bebl.find(_resName) != bebl.end() && bebl[_resName].find(phiBin) != bebl[_resName].end()) {
-		if(bebl[_resName][phiBin].find(psiBin) != bebl[_resName][phiBin].end()) {
+	map<string,map<int,map<int,BeblBinInfo> > >::iterator foundRes = bebl.find(_resName);
+	if(foundRes != bebl.end()) {
+		map<int,map<int,BeblBinInfo> >::iterator foundPhi = foundRes->second.find(phiBin);
+		if(foundPhi != foundRes->second.end() && foundPhi->second.find(psiBin) != foundPhi->second.end()) {
 			phiPsiBins.first = phiBin;
 			phiPsiBins.second = psiBin;
 		}
@@ -73,8 +73,11 @@ class RotamerLibrary {
 		unsigned int size(std::string _libName, std::string _resName, double phi, double psi);
 
 		/* I/O */
+		// readFile also recognizes the binary format (the BEBL is included in it)
 		bool readFile(std::string _filename, std::string _beblFile="", bool _append=false);
 		bool writeFile(std::string _filename, std::string beblFile="");
+		// compiled binary library with the conformations and the BEBL bins, fast to load
+		bool writeBinaryFile(std::string _filename);
 
 		/*********************************************************
 		 *  Getters
@@ -149,6 +152,12 @@ class RotamerLibrary {
 
 	protected:		
 	private:
+		// the binary format is read and written directly from/to the data structures
+		friend class RotamerLibraryReader;
+		friend class RotamerLibraryWriter;
+		static const char binaryMagic[8];
+		static const unsigned int binaryVersion;
+
 		void setup();
 		void copy(const RotamerLibrary & _rotlib);
 		void deletePointers();
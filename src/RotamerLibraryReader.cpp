@@ -29,6 +29,8 @@ You should have received a copy of the GNU Lesser General Public
 
 
 #include "RotamerLibraryReader.h"
+#include <fstream>
+#include <cstring>
 
 using namespace MSL;
 using namespace std;
@@ -366,4 +368,230 @@ bool RotamerLibraryReader::readBebl() {
 	return true;
 }
 
+/*
+  Binary library: the file is read with a single read and then
+  parsed from memory
+*/
+static bool readBytes(const vector<char> &_data, size_t &_pos, void *_value, size_t _bytes){
+	if (_data.size() - _pos < _bytes) {
+		return false;
+	}
+	if (_bytes > 0) {
+		memcpy(_value,&_data[_pos],_bytes);
+	}
+	_pos += _bytes;
+	return true;
+}
+static bool readUInt(const vector<char> &_data, size_t &_pos, unsigned int &_value){
+	return readBytes(_data,_pos,&_value,sizeof(unsigned int));
+}
+static bool readInt(const vector<char> &_data, size_t &_pos, int &_value){
+	return readBytes(_data,_pos,&_value,sizeof(int));
+}
+static bool readString(const vector<char> &_data, size_t &_pos, string &_value){
+	unsigned int size = 0;
+	if (!readUInt(_data,_pos,size) || _data.size() - _pos < size) return false;
+	_value.assign(&_data[0] + _pos,size);
+	_pos += size;
+	return true;
+}
+static bool readStrings(const vector<char> &_data, size_t &_pos, vector<string> &_values){
+	unsigned int size = 0;
+	if (!readUInt(_data,_pos,size) || size > _data.size() - _pos) return false;
+	_values.resize(size);
+	for (unsigned int i=0; i<size; i++) {
+		if (!readString(_data,_pos,_values[i])) return false;
+	}
+	return true;
+}
+static bool readUInts(const vector<char> &_data, size_t &_pos, vector<unsigned int> &_values, unsigned int _size){
+	if (_size > (_data.size() - _pos) / sizeof(unsigned int)) return false;
+	_values.resize(_size);
+	return _size == 0 || readBytes(_data,_pos,&_values[0],_size * sizeof(unsigned int));
+}
 
+bool RotamerLibraryReader::isBinaryFile(const string & _filename) {
+	ifstream fin(_filename.c_str(),std::ios::binary);
+	if (!fin.is_open()) {
+		return false;
+	}
+	char magic[sizeof(RotamerLibrary::binaryMagic)];
+	fin.read(magic,sizeof(magic));
+	return fin.good() && memcmp(magic,RotamerLibrary::binaryMagic,sizeof(magic)) == 0;
+}
+
+bool RotamerLibraryReader::readBinary(const string & _filename) {
+	if (pRotLib == NULL) {
+		return false;
+	}
+
+	ifstream fin(_filename.c_str(),std::ios::binary);
+	if (!fin.is_open()){
+		return false;
+	}
+	fin.seekg(0, std::ios::end);
+	vector<char> data((size_t)fin.tellg());
+	fin.seekg(0, std::ios::beg);
+	if (data.size() > 0) {
+		fin.read(&data[0], data.size());
+	}
+	if (!fin.good()) {
+		return false;
+	}
+
+	size_t pos = 0;
+	char magic[sizeof(RotamerLibrary::binaryMagic)];
+	unsigned int version = 0;
+	if (!readBytes(data,pos,magic,sizeof(magic)) || memcmp(magic,RotamerLibrary::binaryMagic,sizeof(magic)) != 0 || !readUInt(data,pos,version) || version != RotamerLibrary::binaryVersion) {
+		cerr << "ERROR 5628: " << _filename << " is not a binary rotamer library (version " << RotamerLibrary::binaryVersion << ") in bool RotamerLibraryReader::readBinary(const string & _filename)" << endl;
+		return false;
+	}
+	/*
+	  The whole file is parsed and validated into local structures
+	  first, the library is only changed if the file is complete
+	*/
+	string defaultLibrary;
+	unsigned int isBbdep = 0;
+	int phiBinSize = 0;
+	int psiBinSize = 0;
+	vector<string> levelLabels;
+	bool ok = readString(data,pos,defaultLibrary) && readUInt(data,pos,isBbdep) && readInt(data,pos,phiBinSize) && readInt(data,pos,psiBinSize) && readStrings(data,pos,levelLabels);
+
+	// the levels (level name, residue name and number of rotamers)
+	vector<string> levelNames;
+	vector<string> levelResidues;
+	vector<unsigned int> levelRotamers;
+	unsigned int numLevels = 0;
+	ok = ok && readUInt(data,pos,numLevels);
+	for (unsigned int i=0; ok && i<numLevels; i++) {
+		string levelName;
+		unsigned int numRes = 0;
+		ok = readString(data,pos,levelName) && readUInt(data,pos,numRes);
+		for (unsigned int j=0; ok && j<numRes; j++) {
+			string resName;
+			unsigned int numRots = 0;
+			ok = readString(data,pos,resName) && readUInt(data,pos,numRots);
+			levelNames.push_back(levelName);
+			levelResidues.push_back(resName);
+			levelRotamers.push_back(numRots);
+		}
+	}
+
+	// the libraries, in the order of the file
+	vector<string> libNames;
+	vector<vector<pair<string, RotamerLibrary::Res> > > libResidues;
+	unsigned int numLibs = 0;
+	ok = ok && readUInt(data,pos,numLibs);
+	for (unsigned int i=0; ok && i<numLibs; i++) {
+		string libName;
+		unsigned int numRes = 0;
+		ok = readString(data,pos,libName) && readUInt(data,pos,numRes);
+		libNames.push_back(libName);
+		libResidues.push_back(vector<pair<string, RotamerLibrary::Res> >());
+		for (unsigned int j=0; ok && j<numRes; j++) {
+			libResidues.back().push_back(pair<string, RotamerLibrary::Res>());
+			string & resName = libResidues.back().back().first;
+			RotamerLibrary::Res & R = libResidues.back().back().second;
+			unsigned int numDefi = 0;
+			ok = readString(data,pos,resName) && readStrings(data,pos,R.mobileAtoms) && readUInt(data,pos,numDefi) && numDefi <= data.size() - pos;
+			for (unsigned int k=0; ok && k<numDefi; k++) {
+				RotamerLibrary::InternalCoorDefi D;
+				ok = readUInt(data,pos,D.type) && readStrings(data,pos,D.atomNames);
+				R.defi.push_back(D);
+			}
+			unsigned int numConfs = 0;
+			ok = ok && readUInt(data,pos,numConfs) && (numDefi == 0 || numConfs <= (data.size() - pos) / (numDefi * sizeof(double)));
+			if (!ok) {
+				break;
+			}
+			R.internalCoor.assign(numConfs, vector<double>(numDefi, 0.0));
+			for (unsigned int k=0; ok && k<numConfs; k++) {
+				ok = numDefi == 0 || readBytes(data,pos,&R.internalCoor[k][0],numDefi * sizeof(double));
+			}
+			unsigned int numBins = 0;
+			ok = ok && readUInt(data,pos,numBins) && readUInts(data,pos,R.rotamerBins,numBins);
+		}
+	}
+
+	// the BEBL bins (residue, phi, psi, level counts and conformation indices)
+	vector<string> binResidues;
+	vector<int> binPhis;
+	vector<int> binPsis;
+	vector<vector<unsigned> > binLevelCounts;
+	vector<vector<unsigned> > binConfIndices;
+	unsigned int numBeblRes = 0;
+	ok = ok && readUInt(data,pos,numBeblRes);
+	for (unsigned int i=0; ok && i<numBeblRes; i++) {
+		string resName;
+		unsigned int numBins = 0;
+		ok = readString(data,pos,resName) && readUInt(data,pos,numBins) && numBins <= data.size() - pos;
+		if (!ok) {
+			break;
+		}
+		// the bin table: phi, psi and the offset and size of the level counts and conformation indices
+		vector<int> phiBins(numBins);
+		vector<int> psiBins(numBins);
+		vector<unsigned int> offsets;
+		vector<unsigned int> binOffsets;
+		for (unsigned int j=0; ok && j<numBins; j++) {
+			ok = readInt(data,pos,phiBins[j]) && readInt(data,pos,psiBins[j]) && readUInts(data,pos,binOffsets,4);
+			offsets.insert(offsets.end(), binOffsets.begin(), binOffsets.end());
+		}
+		unsigned int numLevelCounts = 0;
+		unsigned int numConfIndices = 0;
+		vector<unsigned int> levelCounts;
+		vector<unsigned int> confIndices;
+		ok = ok && readUInt(data,pos,numLevelCounts) && readUInts(data,pos,levelCounts,numLevelCounts);
+		ok = ok && readUInt(data,pos,numConfIndices) && readUInts(data,pos,confIndices,numConfIndices);
+		for (unsigned int j=0; ok && j<numBins; j++) {
+			unsigned int * o = &offsets[4*j];
+			if (o[0] > numLevelCounts || o[1] > numLevelCounts - o[0] || o[2] > numConfIndices || o[3] > numConfIndices - o[2]) {
+				ok = false;
+				break;
+			}
+			binResidues.push_back(resName);
+			binPhis.push_back(phiBins[j]);
+			binPsis.push_back(psiBins[j]);
+			binLevelCounts.push_back(vector<unsigned>(levelCounts.begin() + o[0], levelCounts.begin() + o[0] + o[1]));
+			binConfIndices.push_back(vector<unsigned>(confIndices.begin() + o[2], confIndices.begin() + o[2] + o[3]));
+		}
+	}
+
+	if (!ok || pos != data.size()) {
+		cerr << "ERROR 5629: truncated or corrupted binary rotamer library " << _filename << " in bool RotamerLibraryReader::readBinary(const string & _filename)" << endl;
+		return false;
+	}
+
+	// the file is valid, add its content to the library
+	bool firstLibraries = pRotLib->getNumberOfLibraries() == 0;
+	for (unsigned int i=0; i<levelNames.size(); i++) {
+		pRotLib->setLevel(levelNames[i], levelResidues[i], levelRotamers[i]);
+	}
+	for (unsigned int i=0; i<libNames.size(); i++) {
+		pRotLib->addLibrary(libNames[i]);
+		for (unsigned int j=0; j<libResidues[i].size(); j++) {
+			// replaces the residue if it was already there
+			pRotLib->libraries[libNames[i]][libResidues[i][j].first] = libResidues[i][j].second;
+		}
+	}
+	for (unsigned int i=0; i<binResidues.size(); i++) {
+		pRotLib->addBeblBin(binResidues[i], binPhis[i], binPsis[i], binLevelCounts[i], binConfIndices[i]);
+	}
+	if (firstLibraries && pRotLib->libraryExists(defaultLibrary)) {
+		pRotLib->defaultLibrary = defaultLibrary;
+	}
+	if (numBeblRes > 0) {
+		pRotLib->setBeblLevelLabels(levelLabels);
+		pRotLib->setPhiBinSize(phiBinSize);
+		pRotLib->setPsiBinSize(psiBinSize);
+	}
+	if (isBbdep) {
+		pRotLib->isBbdep = true;
+	}
+
+	if (!pRotLib->calculateBuildingICentries()) {
+		cerr << "ERROR 5023: error in crating the IC building instructions " << _filename << ", in bool RotamerLibraryReader::readBinary(const string & _filename)" << endl;
+		return false;
+	}
+	return true;
+}
@@ -62,6 +62,10 @@ class RotamerLibraryReader : public Reader {
 		bool read();
 		bool readBebl();
 
+		// the compiled binary library written by RotamerLibraryWriter::writeBinary
+		bool readBinary(const std::string & _filename);
+		static bool isBinaryFile(const std::string & _filename);
+
 		void setRotamerLibrary(RotamerLibrary * _rotlib);
 
 	protected:		
@@ -1,4 +1,5 @@
 #include "RotamerLibraryWriter.h"
+#include <fstream>
 
 using namespace MSL;
 using namespace std;
@@ -124,12 +125,137 @@ bool RotamerLibraryWriter::writeBebl(RotamerLibrary * _rotlib) {
 	return false;
 }
 
+/*
+  Binary library
+*/
+static void writeUInt(ofstream &_fout, unsigned int _value){
+	_fout.write((const char*)&_value,sizeof(unsigned int));
+}
+static void writeInt(ofstream &_fout, int _value){
+	_fout.write((const char*)&_value,sizeof(int));
+}
+static void writeString(ofstream &_fout, const string &_value){
+	writeUInt(_fout,_value.size());
+	_fout.write(_value.data(),_value.size());
+}
+static void writeStrings(ofstream &_fout, const vector<string> &_values){
+	writeUInt(_fout,_values.size());
+	for (unsigned int i=0; i<_values.size(); i++) {
+		writeString(_fout,_values[i]);
+	}
+}
 
+bool RotamerLibraryWriter::writeBinary(RotamerLibrary * _rotlib, const string & _filename) {
+	/***************************************************************
+	 *  Layout (native byte order, unsigned int sizes):
+	 *    magic, version
+	 *    default library, backbone dependent flag, phi and psi bin sizes,
+	 *    BEBL level labels, levels
+	 *    for each library and residue: mobile atoms, definitions,
+	 *      number of conformations, then all the values as a single
+	 *      block of doubles (conformation major) and the rotamer bins
+	 *      (prefixed by their number)
+	 *    for each BEBL residue: a table of the phi/psi bins with the
+	 *      offsets of their level counts and conformation indices,
+	 *      followed by the two blocks they point into
+	 ***************************************************************/
+	if(_rotlib == NULL) {
+		return false;
+	}
 
+	ofstream fout(_filename.c_str(),std::ios::binary);
+	if (!fout.is_open()){
+		cerr << "WARNING 23460: cannot open " << _filename << " for writing in bool RotamerLibraryWriter::writeBinary(RotamerLibrary * _rotlib, const string & _filename)" << endl;
+		return false;
+	}
 
+	fout.write(RotamerLibrary::binaryMagic,sizeof(RotamerLibrary::binaryMagic));
+	writeUInt(fout,RotamerLibrary::binaryVersion);
+
+	writeString(fout,_rotlib->defaultLibrary);
+	writeUInt(fout,_rotlib->isBbdep);
+	writeInt(fout,_rotlib->phiBinSize);
+	writeInt(fout,_rotlib->psiBinSize);
+	writeStrings(fout,_rotlib->levelLabels);
+
+	writeUInt(fout,_rotlib->levels.size());
+	for (map<string,map<string,unsigned int> >::iterator lev=_rotlib->levels.begin(); lev!=_rotlib->levels.end(); lev++) {
+		writeString(fout,lev->first);
+		writeUInt(fout,lev->second.size());
+		for (map<string,unsigned int>::iterator res=lev->second.begin(); res!=lev->second.end(); res++) {
+			writeString(fout,res->first);
+			writeUInt(fout,res->second);
+		}
+	}
 
+	writeUInt(fout,_rotlib->libraries.size());
+	for (map<string, map<string, RotamerLibrary::Res> >::iterator lib=_rotlib->libraries.begin(); lib!=_rotlib->libraries.end(); lib++) {
+		writeString(fout,lib->first);
+		writeUInt(fout,lib->second.size());
+		for (map<string, RotamerLibrary::Res>::iterator res=lib->second.begin(); res!=lib->second.end(); res++) {
+			RotamerLibrary::Res & R = res->second;
+			writeString(fout,res->first);
+			writeStrings(fout,R.mobileAtoms);
+			writeUInt(fout,R.defi.size());
+			for (unsigned int i=0; i<R.defi.size(); i++) {
+				writeUInt(fout,R.defi[i].type);
+				writeStrings(fout,R.defi[i].atomNames);
+			}
+			writeUInt(fout,R.internalCoor.size());
+			vector<double> values;
+			values.reserve(R.internalCoor.size() * R.defi.size());
+			for (unsigned int i=0; i<R.internalCoor.size(); i++) {
+				if (R.internalCoor[i].size() != R.defi.size()) {
+					cerr << "WARNING 23465: conformation " << i << " of " << res->first << " does not match the definitions in bool RotamerLibraryWriter::writeBinary(RotamerLibrary * _rotlib, const string & _filename)" << endl;
+					return false;
+				}
+				values.insert(values.end(), R.internalCoor[i].begin(), R.internalCoor[i].end());
+			}
+			if (values.size() > 0) {
+				fout.write((const char*)&values[0],values.size() * sizeof(double));
+			}
+			writeUInt(fout,R.rotamerBins.size());
+			if (R.rotamerBins.size() > 0) {
+				fout.write((const char*)&R.rotamerBins[0],R.rotamerBins.size() * sizeof(unsigned int));
+			}
+		}
+	}
 
+	writeUInt(fout,_rotlib->bebl.size());
+	for (map<string,map<int,map<int,RotamerLibrary::BeblBinInfo> > >::iterator res=_rotlib->bebl.begin(); res!=_rotlib->bebl.end(); res++) {
+		writeString(fout,res->first);
+		vector<unsigned int> levelCounts;
+		vector<unsigned int> confIndices;
+		unsigned int numBins = 0;
+		for (map<int,map<int,RotamerLibrary::BeblBinInfo> >::iterator phi=res->second.begin(); phi!=res->second.end(); phi++) {
+			numBins += phi->second.size();
+		}
+		writeUInt(fout,numBins);
+		for (map<int,map<int,RotamerLibrary::BeblBinInfo> >::iterator phi=res->second.begin(); phi!=res->second.end(); phi++) {
+			for (map<int,RotamerLibrary::BeblBinInfo>::iterator psi=phi->second.begin(); psi!=phi->second.end(); psi++) {
+				writeInt(fout,phi->first);
+				writeInt(fout,psi->first);
+				writeUInt(fout,levelCounts.size());
+				writeUInt(fout,psi->second.numConfsPerLevel.size());
+				writeUInt(fout,confIndices.size());
+				writeUInt(fout,psi->second.confIndices.size());
+				levelCounts.insert(levelCounts.end(), psi->second.numConfsPerLevel.begin(), psi->second.numConfsPerLevel.end());
+				confIndices.insert(confIndices.end(), psi->second.confIndices.begin(), psi->second.confIndices.end());
+			}
+		}
+		writeUInt(fout,levelCounts.size());
+		if (levelCounts.size() > 0) {
+			fout.write((const char*)&levelCounts[0],levelCounts.size() * sizeof(unsigned int));
+		}
+		writeUInt(fout,confIndices.size());
+		if (confIndices.size() > 0) {
+			fout.write((const char*)&confIndices[0],confIndices.size() * sizeof(unsigned int));
+		}
+	}
 
-
-
-
+	if (!fout.good()){
+		cerr << "WARNING 23470: failed writing " << _filename << " in bool RotamerLibraryWriter::writeBinary(RotamerLibrary * _rotlib, const string & _filename)" << endl;
+		return false;
+	}
+	return true;
+}
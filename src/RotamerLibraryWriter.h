@@ -30,6 +30,8 @@ class RotamerLibraryWriter : public Writer {
 
 		bool write(RotamerLibrary * _rotlib, std::string _charmm = "CHARMMPAR 22 27");
 		bool writeBebl(RotamerLibrary * _rotlib);
+		// the compiled binary library (read back by RotamerLibrary::readFile)
+		bool writeBinary(RotamerLibrary * _rotlib, const std::string & _filename);
 		bool open();
 		bool open(const std::string &_filename); // There is a default implementation
 		bool open(const std::string &_filename, int mode); // There is a default implementation
@@ -1,6 +1,7 @@
 #include<SasaAtom.h>
 
 using namespace MSL;
+using namespace std;
 
 
 SasaAtom::SasaAtom() {
@@ -77,6 +78,71 @@ void SasaAtom::removeOccluded(CartesianPoint & _center, double _radius, bool _pu
 }
 
 
+double SasaAtom::calcSasa(const vector<double> & _unitSphere, const vector<double> & _neighbors, vector<double> & _buffer) {
+	numberOfPoints = _unitSphere.size() / 3;
+	if (numberOfPoints == 0) {
+		sasa = 0.0;
+		return 0.0;
+	}
+
+	// place the points on the sphere (same arithmetic as SurfaceSphere::buildOcclusionPoints)
+	// layout of the buffer: x[0..n) y[0..n) z[0..n) d2[0..n)
+	unsigned int n = numberOfPoints;
+	_buffer.resize(4 * n);
+	double * px = &_buffer[0];
+	double * py = px + n;
+	double * pz = py + n;
+	double * d2 = pz + n;
+	const double * ux = &_unitSphere[0];
+	const double * uy = ux + n;
+	const double * uz = uy + n;
+	double cx = pCenter->getX();
+	double cy = pCenter->getY();
+	double cz = pCenter->getZ();
+	for (unsigned int i = 0; i < n; i++) {
+		px[i] = ux[i] * totalRadius + cx;
+		py[i] = uy[i] * totalRadius + cy;
+		pz[i] = uz[i] * totalRadius + cz;
+	}
+
+	unsigned int exposed = n;
+	for (unsigned int k = 0; k + 3 < _neighbors.size() && exposed > 0; k += 4) {
+		double nx = _neighbors[k];
+		double ny = _neighbors[k+1];
+		double nz = _neighbors[k+2];
+		double effectiveRadius = _neighbors[k+3] + probeRadius;
+		double effectiveRadius2 = effectiveRadius * effectiveRadius;
+
+		// squared distances of all remaining points, a loop without branches the compiler can vectorize
+		for (unsigned int i = 0; i < exposed; i++) {
+			double dx = px[i] - nx;
+			double dy = py[i] - ny;
+			double dz = pz[i] - nz;
+			d2[i] = dx*dx + dy*dy + dz*dz;
+		}
+
+		// keep the points that are not occluded, packed at the front.  The
+		// original test is distance <= effectiveRadius: the sqrt is only taken
+		// for the (rare) points within rounding error of the boundary
+		double low = effectiveRadius2 * (1.0 - 1.0e-10);
+		double high = effectiveRadius2 * (1.0 + 1.0e-10);
+		unsigned int kept = 0;
+		for (unsigned int i = 0; i < exposed; i++) {
+			bool occluded = d2[i] <= low || (d2[i] <= high && sqrt(d2[i]) <= effectiveRadius);
+			if (!occluded) {
+				px[kept] = px[i];
+				py[kept] = py[i];
+				pz[kept] = pz[i];
+				kept++;
+			}
+		}
+		exposed = kept;
+	}
+
+	sasa = (double)exposed/(double)numberOfPoints * 4.0 * M_PI * pow(totalRadius,2.0);
+	return sasa;
+}
+
 void SasaAtom::setup(CartesianPoint * _center, double _radius, double _probeRadius, unsigned int _numberOfPoints) {
 	pCenter = _center;
 	probeRadius = _probeRadius;
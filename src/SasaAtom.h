@@ -27,6 +27,7 @@ class SasaAtom {
 		double getSasa() const;
 		//void setSasa(double _s);
 		CartesianPoint * getCenter() const;
+		void setCenter(CartesianPoint * _center);
 
 		bool buildOcclusionPoints(unsigned int _n);
 
@@ -45,6 +46,15 @@ class SasaAtom {
 
 		double distance(const SasaAtom & _sasaAtom) const;
 
+		/*
+		  Computes (and stores) the SASA without building the SurfaceSphere:
+		  _unitSphere is the output of SurfaceSphere::getUnitSpherePoints and
+		  _neighbors packs the x, y, z and radius of each potentially occluding
+		  atom.  _buffer is scratch space, reused between calls.  Gives the same
+		  result as buildOcclusionPoints + removeOccluded + calcSasa
+		*/
+		double calcSasa(const std::vector<double> & _unitSphere, const std::vector<double> & _neighbors, std::vector<double> & _buffer);
+
 	private:
 		void setup(CartesianPoint * _center, double _radius, double _probeRadius, unsigned int _numberOfPoints);
 
@@ -73,6 +83,7 @@ inline double SasaAtom::calcSasa() {
 
 inline double SasaAtom::getSasa() const { return sasa;}
 inline CartesianPoint * SasaAtom::getCenter() const { return pCenter;}
+inline void SasaAtom::setCenter(CartesianPoint * _center) { pCenter = _center;}
 inline void SasaAtom::deleteOcclusionPoints() { ss->deleteAllPoints();}
 inline bool SasaAtom::buildOcclusionPoints(unsigned int _n) { numberOfPoints = _n; return ss->buildOcclusionPoints(*pCenter, totalRadius, numberOfPoints);}
 inline double SasaAtom::getProbeRadius() const { return probeRadius;}
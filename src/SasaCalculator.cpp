@@ -27,6 +27,7 @@ You should have received a copy of the GNU Lesser General Public
 ----------------------------------------------------------------------------
 */
 #include<SasaCalculator.h>
+#include <algorithm>
 
 using namespace MSL;
 using namespace std;
@@ -59,6 +60,12 @@ SasaCalculator::SasaCalculator(SasaCalculator &_sasaCalculator) {
 	probeRadius = _sasaCalculator.probeRadius;
 	atomRadii = _sasaCalculator.atomRadii;
 	setTFactor = _sasaCalculator.setTFactor;
+	numThreads = _sasaCalculator.numThreads;
+	neighborLists = _sasaCalculator.neighborLists;
+	atomIndex = _sasaCalculator.atomIndex;
+	grid = _sasaCalculator.grid;
+	gridPoint = _sasaCalculator.gridPoint;
+	gridAtom = _sasaCalculator.gridAtom;
 }
 
 
@@ -86,6 +93,7 @@ void SasaCalculator::setup(int _noOcclusionPoints, double _probeRadius) {
 	atomRadii["CU"] = 1.38;
 	atomRadii["P"] = 2.15;
 	setTFactor = false;
+	numThreads = 0;
 	
 	// TODO : Find proper values for these
 	//	SasaCalculator::atomRadii["F"] = 1.38;
@@ -120,37 +128,132 @@ void SasaCalculator::deletePointers() {
 
 
 void SasaCalculator::calcSasa() {
-	//vector<vector<SasaAtom*> > distList = findNeighbors(sasaAtoms);
-	vector<AtomPointerVector> distList = findNeighbors();
+	neighborLists = findNeighbors();
 
-//	AtomSasa.clear();
-//	ResidueSasa.clear();
-//	ChainSasa.clear();
+	atomIndex.clear();
+	vector<unsigned int> all(atoms.size());
+	for (unsigned int i = 0; i < atoms.size(); i++) {
+		atomIndex[atoms[i]] = i;
+		all[i] = i;
+	}
+	calcSasa(all);
+}
 
-	for(int curAtom = 0; curAtom < sasaAtoms.size(); curAtom++) {
-		//Atom* thisAtom = sasaAtoms[curAtom]->getAtom();
-		sasaAtoms[curAtom]->buildOcclusionPoints(noOcclusionPoints);
+AtomPointerVector SasaCalculator::updateSasa(AtomPointerVector & _movedAtoms) {
+	/*
+	  Incremental update: only the moved atoms and their neighbors (before
+	  and after the move) can change SASA.  The neighbor lists of the moved
+	  atoms are rebuilt and the moved atoms are removed from/added to the
+	  lists of the atoms around them; the result is the same as calcSasa()
+	*/
+	AtomPointerVector updated;
+	if (neighborLists.size() != atoms.size()) {
+		// no previous calculation
+		calcSasa();
+		return atoms;
+	}
 
-		bool purge_flag = false;
-		for (unsigned int neighbour = 0; neighbour < distList[curAtom].size(); neighbour++) {
-			if (neighbour == distList[curAtom].size() - 1) {
-				purge_flag = true;
+	vector<bool> moved(atoms.size(), false);
+	vector<unsigned int> movedIndices;
+	for (unsigned int m = 0; m < _movedAtoms.size(); m++) {
+		map<Atom*, unsigned int>::iterator found = atomIndex.find(_movedAtoms[m]);
+		if (found == atomIndex.end() || moved[found->second]) {
+			continue;
+		}
+		moved[found->second] = true;
+		movedIndices.push_back(found->second);
+	}
+
+	vector<bool> affected(moved);
+
+	// take the moved atoms out of their old neighborhoods
+	for (unsigned int m = 0; m < movedIndices.size(); m++) {
+		vector<unsigned int> & oldList = neighborLists[movedIndices[m]];
+		for (unsigned int n = 0; n < oldList.size(); n++) {
+			unsigned int j = oldList[n];
+			affected[j] = true;
+			if (moved[j]) {
+				continue;
 			}
-			sasaAtoms[curAtom]->removeOccluded(*distList[curAtom][neighbour], purge_flag);	
-			if (sasaAtoms[curAtom]->getSurfaceSphereCurrentSize() == 0) {
-				break;
+			vector<unsigned int> & list = neighborLists[j];
+			list.erase(std::remove(list.begin(), list.end(), movedIndices[m]), list.end());
+		}
+		oldList.clear();
+	}
+
+	// update the cells of the moved atoms and find their new neighbors
+	for (unsigned int m = 0; m < movedIndices.size(); m++) {
+		unsigned int i = movedIndices[m];
+		if (gridPoint[i] != grid.size()) {
+			double p[3] = {atoms[i]->getX(), atoms[i]->getY(), atoms[i]->getZ()};
+			grid.movePoint(gridPoint[i], p);
+		}
+	}
+#ifdef __OPENMP__
+	#pragma omp parallel for schedule(dynamic,1) num_threads(getNumThreads())
+#endif
+	for (int m = 0; m < (int)movedIndices.size(); m++) {
+		findNeighbors(movedIndices[m], neighborLists[movedIndices[m]]);
+	}
+
+	// and add them to the lists of their new neighbors
+	for (unsigned int m = 0; m < movedIndices.size(); m++) {
+		vector<unsigned int> & newList = neighborLists[movedIndices[m]];
+		for (unsigned int n = 0; n < newList.size(); n++) {
+			unsigned int j = newList[n];
+			affected[j] = true;
+			if (!moved[j]) {
+				neighborLists[j].push_back(movedIndices[m]);
 			}
 		}
+	}
 
-		atoms[curAtom]->setSasa(sasaAtoms[curAtom]->calcSasa());
-		if (setTFactor) {
-			atoms[curAtom]->setTempFactor(sasaAtoms[curAtom]->getSasa());
+	vector<unsigned int> affectedIndices;
+	for (unsigned int i = 0; i < atoms.size(); i++) {
+		if (affected[i]) {
+			affectedIndices.push_back(i);
+			updated.push_back(atoms[i]);
 		}
-	//	ChainSasa[atoms[curAtom]->getChainId()] += sasaAtoms[curAtom]->getSasa();
-	//	string resnumIcode
-	//	ResidueSasa[[atoms[curAtom]->getChainId()]
-		sasaAtoms[curAtom]->deleteOcclusionPoints();		 // Delete the built occlusion points
+	}
+	calcSasa(affectedIndices);
+
+	return updated;
+}
 
+void SasaCalculator::calcSasa(const vector<unsigned int> & _atomIndices) {
+
+	// the sphere is the same for all atoms, only scaled and translated
+	vector<double> unitSphere;
+	SurfaceSphere::getUnitSpherePoints(noOcclusionPoints, unitSphere);
+
+	// each atom only writes its own SasaAtom and Atom, so the atoms are independent
+#ifdef __OPENMP__
+	#pragma omp parallel num_threads(getNumThreads())
+#endif
+	{
+		vector<double> neighbors;
+		vector<double> buffer;
+#ifdef __OPENMP__
+		#pragma omp for schedule(dynamic,16)
+#endif
+		for(int n = 0; n < (int)_atomIndices.size(); n++) {
+			unsigned int curAtom = _atomIndices[n];
+			neighbors.clear();
+			for (unsigned int neighbour = 0; neighbour < neighborLists[curAtom].size(); neighbour++) {
+				Atom * pAtom = atoms[neighborLists[curAtom][neighbour]];
+				neighbors.push_back(pAtom->getX());
+				neighbors.push_back(pAtom->getY());
+				neighbors.push_back(pAtom->getZ());
+				neighbors.push_back(pAtom->getRadius());
+			}
+
+			// follow the atom if its active conformation has changed
+			sasaAtoms[curAtom]->setCenter(&atoms[curAtom]->getCoor());
+			atoms[curAtom]->setSasa(sasaAtoms[curAtom]->calcSasa(unitSphere, neighbors, buffer));
+			if (setTFactor) {
+				atoms[curAtom]->setTempFactor(sasaAtoms[curAtom]->getSasa());
+			}
+		}
 	} 
 }
  
@@ -219,103 +322,79 @@ string SasaCalculator::getSasaTable(bool _byAtom) {
 	return ss.str();
 }
 
-vector<AtomPointerVector> SasaCalculator::findNeighbors() {
-	vector<AtomPointerVector> distList(atoms.size());
-	//vector<vector<SasaAtom*> > distList(_sasaAtoms.size());
-	vector<vector<double> > distVals(atoms.size());
-//	unsigned int dCounter = 0;
-	if (atoms.size() < DEFAULT_MIN_ATOMSIZE_FOR_ATOMGRID) {
-		for (int i = 0; i< atoms.size(); i++) {
-			double r1 = atoms[i]->getRadius();
-			if (r1 <= 0) {
-				continue;
-			}
-
-			// build a list of neighbors for each atom
-			for (unsigned int j=i+1; j < atoms.size(); j++) {
-
-				double r2 = atoms[j]->getRadius();
-				if (r2 <= 0.0) {
-					continue;
-				}
-				double d = atoms[i]->distance(*atoms[j]);
-		//		dCounter++;
-				if(d < (r1 + r2 + 2 * probeRadius )) {
-					distList[i].push_back(atoms[j]);
-					distVals[i].push_back(d);
-					distList[j].push_back(atoms[i]);
-					distVals[j].push_back(d);
-				} 
-			}
-			// sort the lists by distance, this way the majority of the surface is
-			// taken away immediately, speeding up the process
-			vector<unsigned int> index(distVals[i].size(), 0);
-			for (unsigned int j=0; j<index.size(); j++) {
-				index[j] = j;
-			}
-			MslTools::quickSortWithIndex(distVals[i], index);
-			AtomPointerVector tmpDistList (distList[i].size(), NULL);
-			for (unsigned int j=0; j<index.size(); j++) {
-				tmpDistList[j] = distList[i][ index[j] ];
-			}
-			distList[i] = tmpDistList;
+vector<vector<unsigned int> > SasaCalculator::findNeighbors() {
+	/*
+	  Cell list: the atoms (with a radius) are binned in cubic cells at least 
+	  as large as the longest possible overlap distance, so only the 27 
+	  surrounding cells need to be checked for each atom.  The grid is kept
+	  for updateSasa
+	*/
+	vector<vector<unsigned int> > distList(atoms.size());
+
+	vector<double> xyz;
+	double maxRadius = 0.0;
+	gridPoint.assign(atoms.size(), 0);
+	gridAtom.clear();
+	for (unsigned int i = 0; i < atoms.size(); i++) {
+		double r = atoms[i]->getRadius();
+		if (r <= 0.0) {
+			continue;
 		}
-	} else {
-		/*
-		double rMax1;
-		double rMax2;
-		for (int i = 0; i< atoms.size(); i++) {
-			double r = atoms[i]->getRadius();
-			if (i==0 || r >= rMax1) {
-				rMax2 = rMax1;
-				rMax1 = r;
-			} else if (i==1 || r >= rMax2) {
-				rMax2 = r;
-			}
+		xyz.push_back(atoms[i]->getX());
+		xyz.push_back(atoms[i]->getY());
+		xyz.push_back(atoms[i]->getZ());
+		if (r > maxRadius) maxRadius = r;
+		gridPoint[i] = gridAtom.size();
+		gridAtom.push_back(i);
+	}
+	grid.build(xyz, 2 * maxRadius + 2 * probeRadius);
+	for (unsigned int i = 0; i < atoms.size(); i++) {
+		if (atoms[i]->getRadius() <= 0.0) {
+			gridPoint[i] = grid.size();
 		}
-		cout << "UUUU " << rMax1 << " " << rMax2 << endl;
-		Atom3DGrid grid(atoms, rMax1+rMax2+2*probeRadius);
-		*/
-		Atom3DGrid grid(atoms, 5+2*probeRadius);
-		for (int i = 0; i< atoms.size(); i++) {
-			double r1 = atoms[i]->getRadius();
-			if (r1 <= 0) {
-				continue;
-			}
-			AtomPointerVector neighbors = grid.getNeighbors(i);	
-			// build a list of neighbors for each atom
-			for (unsigned int j=0; j < neighbors.size(); j++) {
+	}
 
-				double r2 = neighbors[j]->getRadius();
-				if (r2 <= 0.0) {
-					continue;
-				}
-				double d = atoms[i]->distance(*neighbors[j]);
-			//	dCounter++;
-				if(d < (r1 + r2 + 2 * probeRadius )) {
-					distList[i].push_back(neighbors[j]);
-					distVals[i].push_back(d);
-					//distList[j].push_back(atoms[i]);
-					//distVals[j].push_back(d);
-				} 
-			}
-			// sort the lists by distance, this way the majority of the surface is
-			// taken away immediately, speeding up the process
-			vector<unsigned int> index(distVals[i].size(), 0);
-			for (unsigned int j=0; j<index.size(); j++) {
-				index[j] = j;
+#ifdef __OPENMP__
+	#pragma omp parallel for schedule(dynamic,64) num_threads(getNumThreads())
+#endif
+	for (int n = 0; n < (int)gridAtom.size(); n++) {
+		findNeighbors(gridAtom[n], distList[gridAtom[n]]);
+	}
+
+	return distList;
+}
+
+void SasaCalculator::findNeighbors(unsigned int _atom, vector<unsigned int> & _list) const {
+	_list.clear();
+	double r1 = atoms[_atom]->getRadius();
+	if (r1 <= 0.0) {
+		return;
+	}
+	double p[3] = {atoms[_atom]->getX(), atoms[_atom]->getY(), atoms[_atom]->getZ()};
+	vector<unsigned int> cells;
+	grid.getNeighborCells(p, cells);
+
+	vector<pair<double, unsigned int> > found;
+	for (unsigned int c = 0; c < cells.size(); c++) {
+		for (unsigned int k = grid.getFirstPoint(cells[c]); k != grid.size(); k = grid.getNextPoint(k)) {
+			unsigned int j = gridAtom[k];
+			if (j == _atom) {
+				continue;
 			}
-			MslTools::quickSortWithIndex(distVals[i], index);
-			AtomPointerVector tmpDistList (distList[i].size(), NULL);
-			for (unsigned int j=0; j<index.size(); j++) {
-				tmpDistList[j] = distList[i][ index[j] ];
+			double d = atoms[_atom]->distance(*atoms[j]);
+			if(d < (r1 + atoms[j]->getRadius() + 2 * probeRadius )) {
+				found.push_back(pair<double, unsigned int>(d, j));
 			}
-			distList[i] = tmpDistList;
-
 		}
 	}
-	//cout << "UUUU d counter " << dCounter << endl;
-	return distList;
+
+	// sort the lists by distance, this way the majority of the surface is
+	// taken away immediately, speeding up the process
+	sort(found.begin(), found.end());
+	_list.resize(found.size());
+	for (unsigned int j=0; j<found.size(); j++) {
+		_list[j] = found[j].second;
+	}
 }
 
 void SasaCalculator::printSasaTable(bool _byAtom) {
@@ -323,6 +402,10 @@ void SasaCalculator::printSasaTable(bool _byAtom) {
 }
 
 
+int SasaCalculator::getNumThreads() const {
+	return MslTools::getNumThreads(numThreads);
+}
+
 double SasaCalculator::getTotalSasa(){
 	double sasa = 0.0;
 	for (int i = 0 ; i < atoms.size();  i++) {
@@ -34,14 +34,12 @@ You should have received a copy of the GNU Lesser General Public
 #include "AtomPointerVector.h"
 #include "SurfaceSphere.h"
 #include "SasaAtom.h"
-#include "SurfaceSphere.h"
-#include "Atom3DGrid.h"
+#include "CellList.h"
 
 //#include "math.h"
 //#include "Real.h"
 
 #define DEFAULT_OCCLUSION_POINTS (2000)
-#define DEFAULT_MIN_ATOMSIZE_FOR_ATOMGRID (2000)
 
 #define DEFAULT_PROBE_RADIUS 1.4
 #define INVALID_SASA -1.0
@@ -64,6 +62,17 @@ class SasaCalculator {
 		void addAtoms(AtomPointerVector& _atoms);
 		std::vector<SasaAtom*> & getAtomPointers();
 		void calcSasa();
+
+		/*
+		  Incremental SASA after a local change (e.g. a rotamer of the same
+		  identity on one Position): only the moved atoms and the atoms around
+		  them (before and after the move) are recomputed, using the neighbor
+		  lists and the cell list kept from the previous calcSasa/updateSasa
+		  (the cells of the moved atoms are updated).  The set of atoms 
+		  must not change (rebuild the calculator after a change of identity).
+		  Returns the atoms whose SASA was recomputed
+		*/
+		AtomPointerVector updateSasa(AtomPointerVector & _movedAtoms);
 	//	double getAtomSasa(std::string _atomId); // use "A 7 CA" or "A,7,CA"
 		double getResidueSasa(std::string _positionId); // use "A 7" or "A,7"
 		std::string getSasaTable(bool _byAtom=true); // if _byAtom == false print residue sasa
@@ -87,12 +96,28 @@ class SasaCalculator {
 		void setTempFactorWithSasa(bool _flag); // if true saves the sasa also on the B factor
 		bool getTempFactorWithSasa() const;
 
+		// atoms are processed on multiple threads when MSL is compiled 
+		// with MSL_OPENMP=T (0 = use all available cores)
+		void setNumThreads(int _threads);
+		int getNumThreads() const;
+
 //		bool readRadiiMap(std::string _mapFile); TO BE IMPLEMENTED!!!
 
 	private:
 		void setup(int _noOcclusionPoints, double _probeRadius);
 		//std::vector<std::vector<SasaAtom*> > findNeighbors();
-		std::vector<AtomPointerVector> findNeighbors();
+		// builds the cell list and returns the indices of the overlapping atoms sorted by distance
+		std::vector<std::vector<unsigned int> > findNeighbors();
+		// the overlapping atoms of one atom, from the current cell list
+		void findNeighbors(unsigned int _atom, std::vector<unsigned int> & _list) const;
+		void calcSasa(const std::vector<unsigned int> & _atomIndices);
+
+		// state kept for updateSasa
+		std::vector<std::vector<unsigned int> > neighborLists;
+		std::map<Atom*, unsigned int> atomIndex;
+		CellList grid; // the atoms with a radius
+		std::vector<unsigned int> gridPoint; // the point of each atom in the grid (grid.size() if none)
+		std::vector<unsigned int> gridAtom; // the atom of each grid point
 
 		std::map <std::string,double> atomRadii;
 	//	std::map <std::string, std::map<std::string, std::map<std::string, double> > > AtomSasa;
@@ -107,6 +132,7 @@ class SasaCalculator {
 		double probeRadius;
 
 		bool setTFactor;
+		int numThreads;
 };
 
 
@@ -118,6 +144,7 @@ inline std::map <std::string,double> SasaCalculator::getRadiiMap() const {return
 inline void SasaCalculator::setRadiiMap(const std::map <std::string,double> & _radiiMap) {atomRadii = _radiiMap;}
 inline void SasaCalculator::setTempFactorWithSasa(bool _flag) {setTFactor = _flag;}
 inline bool SasaCalculator::getTempFactorWithSasa() const {return setTFactor;}
+inline void SasaCalculator::setNumThreads(int _threads) {numThreads = _threads;}
 inline std::string SasaCalculator::getResidueSasaTable() {return getSasaTable(false);}
 inline void SasaCalculator::printResidueSasaTable() {printSasaTable(false);}
 //inline double getAtomSasa(std::string _chain_resnumr_name) {
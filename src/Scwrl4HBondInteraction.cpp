@@ -73,12 +73,33 @@ void Scwrl4HBondInteraction::setup(Atom * _pA1, Atom * _pA2, Atom * _pA3, Atom *
 	params.push_back(cos(_alpha_max)); // store cos_alpha_max
 	params.push_back(cos(_beta_max )); // store cos_beta_max 
 	scalingFactor = _scalingFactor;
+	fastEnergy = false;
+	computeLonePairDirections();
 }
 
 void Scwrl4HBondInteraction::copy(const Scwrl4HBondInteraction & _interaction) {
 	pAtoms = _interaction.pAtoms;
 	params = _interaction.params;
 	scalingFactor = _interaction.scalingFactor;
+	fastEnergy = _interaction.fastEnergy;
+	computeLonePairDirections();
+}
+
+void Scwrl4HBondInteraction::computeLonePairDirections() {
+	/*********************************************************
+	 *  CartesianGeometry::buildRadians places the lone pair
+	 *  at (uCB * rcos) + (m * rsincos) + (k * rsinsin) from
+	 *  the acceptor, where uCB (acceptor - bonded atom), m and
+	 *  k are the orthonormal acceptor frame, so the unit
+	 *  vector of each lone pair has constant components
+	 *********************************************************/
+	double angle2 = M_PI - params[1];
+	for (unsigned int i = 0; i < 2; i++) {
+		double dihe2 = M_PI + params[2 + i];
+		lonePairDir[i][0] = cos(angle2);
+		lonePairDir[i][1] = sin(angle2) * cos(dihe2);
+		lonePairDir[i][2] = sin(angle2) * sin(dihe2);
+	}
 }
 double Scwrl4HBondInteraction::getEnergy(double _d, std::vector<double> *_paramDerivatives) {
 		if(_paramDerivatives) {
@@ -110,6 +131,9 @@ void Scwrl4HBondInteraction::printParameters() {
 
 
 double Scwrl4HBondInteraction::getW() {
+	if (fastEnergy) {
+		return getWFast();
+	}
 	double d = pAtoms[0]->distance(*pAtoms[2]);
 	if(d >= (params[4] + params[5]) || d <= (params[4] - params[5]) ) {
 		// this means d is outside the maximum allowed range i.e) d0 +- sig_d 
@@ -198,6 +222,65 @@ double Scwrl4HBondInteraction::getW() {
 	}
 }	
  
+double Scwrl4HBondInteraction::getWFast() {
+	// same function as getW(), see the description there
+	CartesianPoint & H = pAtoms[0]->getCoor();
+	CartesianPoint & A = pAtoms[2]->getCoor();
+
+	// n = H - A
+	double n[3] = {H.getX() - A.getX(), H.getY() - A.getY(), H.getZ() - A.getZ()};
+	// d0 +- sig_d range checked on the squared distance
+	double d2 = n[0]*n[0] + n[1]*n[1] + n[2]*n[2];
+	double dMax = params[4] + params[5];
+	double dMin = params[4] - params[5];
+	if(d2 >= dMax * dMax || (dMin >= 0.0 && d2 <= dMin * dMin) || dMax <= 0.0) {
+		return 0;
+	}
+	double d = sqrt(d2);
+
+	// cos(alpha): angle between -n and e0 = H - D
+	CartesianPoint & D = pAtoms[1]->getCoor();
+	double e0[3] = {H.getX() - D.getX(), H.getY() - D.getY(), H.getZ() - D.getZ()};
+	double e0Len = sqrt(e0[0]*e0[0] + e0[1]*e0[1] + e0[2]*e0[2]);
+	double cos_alpha = -(n[0]*e0[0] + n[1]*e0[1] + n[2]*e0[2]) / (d * e0Len);
+	double t2 = cos_alpha - params[7];
+	if(t2 <= 0) {
+		return 0;
+	}
+
+	// acceptor frame (as in CartesianGeometry::buildRadians)
+	CartesianPoint & B = pAtoms[3]->getCoor();
+	CartesianPoint & C = pAtoms[4]->getCoor();
+	double u[3] = {A.getX() - B.getX(), A.getY() - B.getY(), A.getZ() - B.getZ()};
+	double uLen = sqrt(u[0]*u[0] + u[1]*u[1] + u[2]*u[2]);
+	u[0] /= uLen; u[1] /= uLen; u[2] /= uLen;
+	double dc[3] = {B.getX() - C.getX(), B.getY() - C.getY(), B.getZ() - C.getZ()};
+	double dcu = dc[0]*u[0] + dc[1]*u[1] + dc[2]*u[2];
+	double m[3] = {dc[0] - u[0]*dcu, dc[1] - u[1]*dcu, dc[2] - u[2]*dcu};
+	double mLen = sqrt(m[0]*m[0] + m[1]*m[1] + m[2]*m[2]);
+	double k[3] = {u[1]*dc[2] - u[2]*dc[1], u[2]*dc[0] - u[0]*dc[2], u[0]*dc[1] - u[1]*dc[0]};
+	double kLen = sqrt(k[0]*k[0] + k[1]*k[1] + k[2]*k[2]);
+
+	// projections of the unit H-A vector on the frame
+	double nu = (n[0]*u[0] + n[1]*u[1] + n[2]*u[2]) / d;
+	double nm = (n[0]*m[0] + n[1]*m[1] + n[2]*m[2]) / (d * mLen);
+	double nk = (n[0]*k[0] + n[1]*k[1] + n[2]*k[2]) / (d * kLen);
+
+	double cos_beta = lonePairDir[0][0] * nu + lonePairDir[0][1] * nm + lonePairDir[0][2] * nk;
+	double cos_beta_e2 = lonePairDir[1][0] * nu + lonePairDir[1][1] * nm + lonePairDir[1][2] * nk;
+	if (cos_beta_e2 > cos_beta) {
+		cos_beta = cos_beta_e2;
+	}
+	if (cos_beta <= params[8]) {
+		return 0;
+	}
+
+	double t1 = (params[5] *params[5]) - (d - params[4]) * (d -params[4]);
+	double t3 = cos_beta - params[8];
+	double denominator = params[5] * sqrt((1-params[7]) * (1-params[8])); 
+	return sqrt(t1 * t2 * t3)/denominator;
+}
+
 double Scwrl4HBondInteraction::getEnergy() {
 	return(scalingFactor * getW() * pAtoms[0]->getCharge() * pAtoms[2]->getCharge() * params[6]);
 }
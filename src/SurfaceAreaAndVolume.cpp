@@ -35,6 +35,12 @@ You should have received a copy of the GNU Lesser General Public
 #include <functional>
 #include "RandomNumberGenerator.h"
 #include "CartesianGeometry.h"
+#include "SurfaceSphere.h"
+#include "CellList.h"
+
+#ifdef __OPENMP__
+#include <omp.h>
+#endif
 
 using namespace MSL;
 using namespace std;
@@ -44,6 +50,8 @@ SurfaceAreaAndVolume::SurfaceAreaAndVolume() {
     volume = 0.0;
     probeRadius = 1.4;
     debug = false;
+    method = stereographic;
+    numberOfSurfacePoints = 2000;
 }
 
 SurfaceAreaAndVolume::~SurfaceAreaAndVolume() {
@@ -217,6 +225,17 @@ void SurfaceAreaAndVolume::computeSurfaceAreaAndVolume(AtomPointerVector &_atoms
       AVRO algorithm : 
       Jan Busa, Jozef Dzurina, Edik Hayryan, Shura Hayryan, Chin-Kun Hu, Jan Plavka, Imrich Pokorny, Jaroslav Skrivanek, Ming-Chya Wu, ARVO: A Fortran package for computing the solvent accessible surface area and the excluded volume of overlapping spheres via analytic equations, Computer Physics Communications, Volume 165, Issue 1, 1 January 2005, Pages 59-96, ISSN 0010-4655, DOI: 10.1016/j.cpc.2004.08.002.
      */
+    if (method == surfacePoints) {
+        atomicRadiiSurfaceAreaAndVolume.clear();
+        for (uint i = 0; i < _atoms.size(); i++) {
+            atomicRadiiSurfaceAreaAndVolume[_atoms[i]].push_back(_radii[i]);
+            atomicRadiiSurfaceAreaAndVolume[_atoms[i]].push_back(0.0);
+            atomicRadiiSurfaceAreaAndVolume[_atoms[i]].push_back(0.0);
+        }
+        computeSurfacePoints(_atoms, _radii);
+        return;
+    }
+
     _atoms.saveCoor("preSurfaceArea");
     bool rotatedMolecule;
     rotatedMolecule = false;
@@ -300,6 +319,20 @@ void SurfaceAreaAndVolume::computeSurfaceAreaAndVolume() {
     /*
       AVRO algorithm
      */
+    if (method == surfacePoints) {
+        AtomPointerVector activeAtoms;
+        vector<double> radii;
+        for (uint i = 0; i < atoms.size(); i++) {
+            atomicRadiiSurfaceAreaAndVolume[atoms[i]][1] = 0.0;
+            atomicRadiiSurfaceAreaAndVolume[atoms[i]][2] = 0.0;
+            if (!atoms(i).getActive()) continue;
+            activeAtoms.push_back(atoms[i]);
+            radii.push_back(atomicRadiiSurfaceAreaAndVolume[atoms[i]][0]);
+        }
+        computeSurfacePoints(activeAtoms, radii);
+        return;
+    }
+
     atoms.saveCoor("preSurfaceArea");
     bool rotatedMolecule;
     rotatedMolecule = false;
@@ -1235,3 +1268,133 @@ void SurfaceAreaAndVolume::integrateArcs(AtomPointerVector &_atoms, bool _debug)
     surfaceArea = totalSurfaceArea;
     volume = totalVolume;
 }
+
+void SurfaceAreaAndVolume::computeSurfacePoints(AtomPointerVector &_atoms, vector<double> &_radii) {
+    /*
+      Each sphere is covered with numberOfSurfacePoints points (same spiral as
+      SurfaceSphere).  A point is exposed if it is not inside any other sphere.
+
+        area_i   = 4 pi r_i^2 * exposed / total
+        volume_i = 1/3 * sum over exposed points of (x - O) . n dA     (divergence theorem)
+                 = 1/3 * ( r_i * area_i + (c_i - O) . N_i ),   N_i = sum of exposed normals * dA
+
+      The origin O (the centroid of the atoms) cancels out in the total volume
+      since the normals of a closed surface sum to zero; using the centroid
+      keeps the per-atom volumes translation invariant
+    */
+    surfaceArea = 0.0;
+    volume = 0.0;
+    uint numAtoms = _atoms.size();
+    if (numAtoms == 0) {
+        return;
+    }
+
+    vector<double> unitSphere;
+    SurfaceSphere::getUnitSpherePoints(numberOfSurfacePoints, unitSphere);
+    uint n = numberOfSurfacePoints;
+
+    vector<double> centers(3 * numAtoms);
+    CartesianPoint origin(0.0, 0.0, 0.0);
+    double maxRadius = 0.0;
+    for (uint i = 0; i < numAtoms; i++) {
+        centers[3*i]   = _atoms(i).getX();
+        centers[3*i+1] = _atoms(i).getY();
+        centers[3*i+2] = _atoms(i).getZ();
+        origin += _atoms(i).getCoor();
+        if (_radii[i] > maxRadius) maxRadius = _radii[i];
+    }
+    origin /= (double)numAtoms;
+
+    /*
+      Cell list of cubes of side 2 * max radius: the overlapping spheres are in
+      the 27 surrounding cells
+    */
+    CellList grid(centers, 2.0 * maxRadius);
+
+    vector<double> atomArea(numAtoms, 0.0);
+    vector<double> atomVolume(numAtoms, 0.0);
+
+#ifdef __OPENMP__
+    #pragma omp parallel
+#endif
+    {
+        vector<double> neighbors; // x, y, z, r^2 of the overlapping spheres
+        vector<double> px(n), py(n), pz(n);
+        vector<char> exposed(n);
+        vector<uint> cells;
+#ifdef __OPENMP__
+        #pragma omp for schedule(dynamic,16)
+#endif
+        for (int i = 0; i < (int)numAtoms; i++) {
+            double ri = _radii[i];
+            double xi = centers[3*i], yi = centers[3*i+1], zi = centers[3*i+2];
+
+            bool engulfed = ri <= 0.0;
+            neighbors.clear();
+            grid.getNeighborCells(&centers[3*i], cells);
+            for (uint c = 0; c < cells.size() && !engulfed; c++) {
+                for (uint j = grid.getFirstPoint(cells[c]); j != grid.size(); j = grid.getNextPoint(j)) {
+                    if (j == (uint)i) continue;
+                    double rj = _radii[j];
+                    double dx = centers[3*j] - xi;
+                    double dy = centers[3*j+1] - yi;
+                    double dz = centers[3*j+2] - zi;
+                    double dist = sqrt(dx*dx + dy*dy + dz*dz);
+                    if (dist >= ri + rj) continue;
+                    // same engulfment rule as the stereographic engine
+                    if (dist + ri < rj) {
+                        engulfed = true;
+                        break;
+                    }
+                    neighbors.push_back(centers[3*j]);
+                    neighbors.push_back(centers[3*j+1]);
+                    neighbors.push_back(centers[3*j+2]);
+                    neighbors.push_back(rj * rj);
+                }
+            }
+            if (engulfed) {
+                continue;
+            }
+
+            for (uint p = 0; p < n; p++) {
+                px[p] = xi + ri * unitSphere[p];
+                py[p] = yi + ri * unitSphere[n + p];
+                pz[p] = zi + ri * unitSphere[2*n + p];
+                exposed[p] = 1;
+            }
+            for (uint k = 0; k < neighbors.size(); k += 4) {
+                double nx = neighbors[k], ny = neighbors[k+1], nz = neighbors[k+2], r2 = neighbors[k+3];
+                for (uint p = 0; p < n; p++) {
+                    double dx = px[p] - nx;
+                    double dy = py[p] - ny;
+                    double dz = pz[p] - nz;
+                    exposed[p] &= (char)(dx*dx + dy*dy + dz*dz >= r2);
+                }
+            }
+
+            uint count = 0;
+            double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+            for (uint p = 0; p < n; p++) {
+                if (exposed[p]) {
+                    count++;
+                    sumX += unitSphere[p];
+                    sumY += unitSphere[n + p];
+                    sumZ += unitSphere[2*n + p];
+                }
+            }
+            double dA = 4.0 * M_PI * ri * ri / (double)n;
+            atomArea[i] = dA * count;
+            atomVolume[i] = (ri * atomArea[i] + dA * ((xi - origin.getX()) * sumX + (yi - origin.getY()) * sumY + (zi - origin.getZ()) * sumZ)) / 3.0;
+        }
+    }
+
+    for (uint i = 0; i < numAtoms; i++) {
+        atomicRadiiSurfaceAreaAndVolume[_atoms[i]][1] = atomArea[i];
+        atomicRadiiSurfaceAreaAndVolume[_atoms[i]][2] = atomVolume[i];
+        surfaceArea += atomArea[i];
+        volume += atomVolume[i];
+    }
+    if (debug) {
+        fprintf(stdout, "Surface points (%u per sphere): Surface Area %16.3f Volume %16.3f\n", n, surfaceArea, volume);
+    }
+}
@@ -36,6 +36,24 @@ namespace MSL {
         SurfaceAreaAndVolume();
         ~SurfaceAreaAndVolume();
 
+        /*
+          Two engines, selectable at runtime:
+            stereographic : analytic ARVO integration (default)
+            surfacePoints : numerical, the spheres are covered with points (see
+                            setNumberOfSurfacePoints); the area is the exposed 
+                            fraction of the points and the volume is obtained from 
+                            the exposed points with the divergence theorem.  Same
+                            per-atom output, much faster on proteins.  Against the
+                            analytic engine (tests/sandbox/testSurfaceAreaAndVolume)
+                            totals are within ~0.1% with the default 2000 points
+                            per sphere (error decreases with more points)
+        */
+        enum ComputeMethod { stereographic=0, surfacePoints=1 };
+        void setMethod(ComputeMethod _method);
+        ComputeMethod getMethod() const;
+        void setNumberOfSurfacePoints(unsigned int _n);
+        unsigned int getNumberOfSurfacePoints() const;
+
         // Standalone functions
         void computeSurfaceAreaOccludingPoints(AtomPointerVector &_atoms, std::vector<double> &_radii);
         void computeSurfaceAreaAndVolume(AtomPointerVector &_atoms, std::vector<double> &_radii);
@@ -61,6 +79,13 @@ namespace MSL {
         void setup();
         void copy(const SurfaceAreaAndVolume &_sav);
 
+        /*
+
+          Surface Points engine
+
+         */
+        void computeSurfacePoints(AtomPointerVector &_atoms, std::vector<double> &_radii);
+
 
         /*
 
@@ -101,6 +126,9 @@ namespace MSL {
         double volume;
         bool debug;
 
+        ComputeMethod method;
+        unsigned int numberOfSurfacePoints;
+
 
     };
 
@@ -120,6 +148,22 @@ namespace MSL {
         debug = _debug;
     }
 
+    inline void SurfaceAreaAndVolume::setMethod(ComputeMethod _method) {
+        method = _method;
+    }
+
+    inline SurfaceAreaAndVolume::ComputeMethod SurfaceAreaAndVolume::getMethod() const {
+        return method;
+    }
+
+    inline void SurfaceAreaAndVolume::setNumberOfSurfacePoints(unsigned int _n) {
+        numberOfSurfacePoints = _n;
+    }
+
+    inline unsigned int SurfaceAreaAndVolume::getNumberOfSurfacePoints() const {
+        return numberOfSurfacePoints;
+    }
+
     inline double SurfaceAreaAndVolume::getProbeRadius() {
         return probeRadius;
     }
@@ -90,6 +90,23 @@ bool SurfaceSphere::buildOcclusionPoints(CartesianPoint & _pt, double _rad, unsi
 	return true;
 }
 
+void SurfaceSphere::getUnitSpherePoints(unsigned int _n, vector<double> & _xyz) {
+	// same spiral as buildOcclusionPoints
+	_xyz.assign(3 * _n, 0.0);
+	double dlongitude = M_PI*(3-sqrt(5));
+	double longitude = 0.0;
+	double dz = 2.0/(double)_n;
+	double z = 1.0 - dz/2.0;
+	for (unsigned int i=0; i < _n; i++) {
+		double r = sqrt(1-z*z);
+		_xyz[i] = cos(longitude)*r;
+		_xyz[_n + i] = sin(longitude)*r;
+		_xyz[2*_n + i] = z;
+		z = z-dz;
+		longitude = longitude + dlongitude;
+	}
+}
+
 void SurfaceSphere::purgeOccluded() {
 	unsigned int counter = 0;
 	vector<CartesianPoint*> tmp;
@@ -22,6 +22,10 @@ class SurfaceSphere {
 		CartesianPoint & operator[](size_t _n);
 		bool buildOcclusionPoints(CartesianPoint & _pt, double _rad, unsigned int _n);
 
+		// the same points as buildOcclusionPoints on a unit sphere at the origin,
+		// packed as x[0..n) y[0..n) z[0..n) for fast occlusion tests
+		static void getUnitSpherePoints(unsigned int _n, std::vector<double> & _xyz);
+
 		void setOccluded(unsigned int _n);
 		bool getOccluded(unsigned int _n) const;
 		void purgeOccluded();
@@ -0,0 +1,61 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "SymmetricInteraction.h"
+
+using namespace MSL;
+using namespace std;
+
+
+SymmetricInteraction::SymmetricInteraction(Interaction * _pInteraction, Atom & _a1, Atom & _a2, Symmetry & _symmetry, unsigned int _operator, double _weight, bool _groupDistance) {
+	pAtoms = vector<Atom*>(2, (Atom*)NULL);
+	setAtoms(_a1, _a2);
+	pInteraction = _pInteraction;
+	pSymmetry = &_symmetry;
+	op = _operator;
+	weight = _weight;
+	groupDistance = _groupDistance;
+	pImage = pSymmetry->getImage(op, &_a2);
+}
+
+SymmetricInteraction::~SymmetricInteraction() {
+	delete pInteraction;
+}
+
+void SymmetricInteraction::backRotate(vector<double> & _grad) const {
+	// the second block is the gradient on the image, some terms
+	// (EEF1, IMM1) do not fill it
+	if (_grad.size() < 6) {
+		_grad.resize(6, 0.0);
+	}
+	for (vector<double>::iterator k=_grad.begin(); k!=_grad.end(); k++) {
+		*k *= weight;
+	}
+	pSymmetry->rotateGradient(op, &_grad[3]);
+}
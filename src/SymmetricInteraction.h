@@ -0,0 +1,161 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef SYMMETRICINTERACTION_H
+#define SYMMETRICINTERACTION_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "TwoBodyInteraction.h"
+#include "Symmetry.h"
+
+/*************************************************************************
+ *  A two body interaction between an atom of the asymmetric unit and
+ *  the symmetry image of another (or the same) atom of the unit.
+ *
+ *  The wrapped interaction (owned and deleted by this object) is built
+ *  on the first atom and the image.  Before each evaluation the image
+ *  is moved to the current position of its source atom, the energy is
+ *  multiplied by the weight of the operator (see Symmetry) and the
+ *  gradient of the image is rotated back on the source atom, so that
+ *  the minimizer moves the unit as the whole oligomer would move.
+ *
+ *  The atoms of the interaction (getAtomPointers) are the two source
+ *  atoms, so selections, active flags and the minimization indices work
+ *  as for any other interaction.  The name is that of the wrapped
+ *  interaction: the energies go to the same terms of the EnergySet.
+ *
+ *  With non-bonded cutoffs (_groupDistance true) getEnergy() also moves
+ *  the other images of the group of the image, so that the group
+ *  distance used by the switching function is that of the oligomer
+ *************************************************************************/
+
+namespace MSL { 
+class SymmetricInteraction: public TwoBodyInteraction {
+
+	public:
+		SymmetricInteraction(Interaction * _pInteraction, Atom & _a1, Atom & _a2, Symmetry & _symmetry, unsigned int _operator, double _weight, bool _groupDistance=false);
+		~SymmetricInteraction();
+
+		Interaction * getInteraction();
+		Atom * getImage();
+		unsigned int getOperator() const;
+		double getWeight() const;
+
+		double getDistance(); // distance between the first atom and the image
+
+		double getEnergy();
+		double getEnergy(std::vector<double> *_dd);
+		double getEnergy(double _param, std::vector<double> *_dd=NULL);
+		std::vector<double> getEnergyGrad();
+		std::pair<double,std::vector<double> > partialDerivative();
+
+		friend std::ostream & operator<<(std::ostream &_os, SymmetricInteraction & _term) {_os << _term.toString(); return _os;};
+		std::string toString();
+		std::string getName() const;
+
+	private:
+		SymmetricInteraction(const SymmetricInteraction & _interaction); // the wrapped interaction cannot be shared
+
+		void placeImage();
+		void placeImageGroup();
+		void backRotate(std::vector<double> & _grad) const;
+
+		Interaction * pInteraction;
+		Symmetry * pSymmetry;
+		Atom * pImage;
+		unsigned int op;
+		double weight;
+		bool groupDistance;
+
+};
+
+inline Interaction * SymmetricInteraction::getInteraction() {return pInteraction;}
+inline Atom * SymmetricInteraction::getImage() {return pImage;}
+inline unsigned int SymmetricInteraction::getOperator() const {return op;}
+inline double SymmetricInteraction::getWeight() const {return weight;}
+inline void SymmetricInteraction::placeImage() {pSymmetry->placeImage(op, *pAtoms[1], *pImage);}
+inline void SymmetricInteraction::placeImageGroup() {
+	if (groupDistance) {
+		pSymmetry->placeImageGroup(op, *pAtoms[1], *pImage);
+	} else {
+		pSymmetry->placeImage(op, *pAtoms[1], *pImage);
+	}
+}
+inline double SymmetricInteraction::getDistance() {
+	placeImage();
+	return pAtoms[0]->distance(*pImage);
+}
+inline double SymmetricInteraction::getEnergy() {
+	placeImageGroup();
+	return weight * pInteraction->getEnergy();
+}
+inline double SymmetricInteraction::getEnergy(std::vector<double> *_dd) {
+	placeImage();
+	double E = pInteraction->getEnergy(_dd);
+	if (_dd) {
+		backRotate(*_dd);
+	}
+	return weight * E;
+}
+inline double SymmetricInteraction::getEnergy(double _param, std::vector<double> *_dd) {
+	// _dd holds the partial derivatives from partialDerivative(), already rotated
+	double E = pInteraction->getEnergy(_param, _dd);
+	if (_dd) {
+		for (std::vector<double>::iterator k=_dd->begin(); k!=_dd->end(); k++) {
+			*k *= weight;
+		}
+	}
+	return weight * E;
+}
+inline std::vector<double> SymmetricInteraction::getEnergyGrad() {
+	placeImage();
+	std::vector<double> grad = pInteraction->getEnergyGrad();
+	backRotate(grad);
+	return grad;
+}
+inline std::pair<double,std::vector<double> > SymmetricInteraction::partialDerivative() {
+	placeImage();
+	std::pair<double,std::vector<double> > partials = pInteraction->partialDerivative();
+	if (partials.second.size() >= 6) {
+		pSymmetry->rotateGradient(op, &partials.second[3]);
+	}
+	return partials;
+}
+inline std::string SymmetricInteraction::toString() {
+	placeImageGroup();
+	return pInteraction->toString();
+}
+inline std::string SymmetricInteraction::getName() const {return pInteraction->getName();}
+
+}
+
+#endif
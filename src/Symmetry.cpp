@@ -37,13 +37,18 @@ using namespace std;
 
 
 Symmetry::Symmetry(){
+	N = 0;
+	dihedral = false;
 }
 
 Symmetry::~Symmetry(){
 	deletePointers();
+	clearImages();
 }
 
 Symmetry::Symmetry(const Symmetry & _symmetry) {
+	N = 0;
+	dihedral = false;
 	copy(_symmetry);
 }
 
@@ -63,6 +68,194 @@ void Symmetry::copy(const Symmetry & _symmetry) {
 	for (AtomPointerVector::const_iterator k=_symmetry.atoms.begin(); k!=_symmetry.atoms.end(); k++) {
 		atoms.push_back(new Atom(**k));
 	}
+
+	// the operators are copied, the images are not (they are used by
+	// the interactions built with the original object)
+	clearImages();
+	N = _symmetry.N;
+	dihedral = _symmetry.dihedral;
+	primaryAxis = _symmetry.primaryAxis;
+	secondaryAxis = _symmetry.secondaryAxis;
+	if (N > 0) {
+		setOperators();
+	}
+}
+
+void Symmetry::setCN(int _N, const CartesianPoint & _primaryAxis) {
+	if (_N < 1) {
+		cerr << "ERROR 71301: invalid number of symmetry mates " << _N << " in void Symmetry::setCN(int _N, const CartesianPoint & _primaryAxis)" << endl;
+		return;
+	}
+	clearImages();
+	N = _N;
+	dihedral = false;
+	primaryAxis = _primaryAxis;
+	setOperators();
+}
+
+void Symmetry::setDN(int _N) {
+	// same default axes as applyDN(_ats, _N)
+	double secondaryAngle = M_PI/_N;
+	setDN(_N, CartesianPoint(0,0,1), CartesianPoint(cos(secondaryAngle),sin(secondaryAngle),0));
+}
+
+void Symmetry::setDN(int _N, const CartesianPoint & _primaryAxis, const CartesianPoint & _secondaryAxis) {
+	if (_N < 1) {
+		cerr << "ERROR 71302: invalid number of symmetry mates " << _N << " in void Symmetry::setDN(int _N, const CartesianPoint & _primaryAxis, const CartesianPoint & _secondaryAxis)" << endl;
+		return;
+	}
+	clearImages();
+	N = _N;
+	dihedral = true;
+	primaryAxis = _primaryAxis;
+	secondaryAxis = _secondaryAxis;
+	setOperators();
+}
+
+void Symmetry::setOperators() {
+	/*************************************************************
+	 *  The rotation matrices are built exactly as in applyCN
+	 *  (accumulated angle) and applyDN so that the images
+	 *  are identical to the atoms of the full oligomer.
+	 *
+	 *  Unique operators: g and g^-1 give the same interface
+	 *  energy, so for the rotations only k = 1..N/2 are kept,
+	 *  with half weight for k = N/2 (N even), which is its own
+	 *  inverse.  All DN flips are their own inverse and have
+	 *  half weight.
+	 *************************************************************/
+	rotations.assign(N, RigidTransform());
+	double angle = 0.0;
+	for (unsigned int k=1; k < N; k++) {
+		angle += 360.0/N;
+		rotations[k].setRotation(CartesianGeometry::getRotationMatrix(angle, primaryAxis));
+	}
+	flip.setIdentity();
+	if (dihedral) {
+		flip.setRotation(CartesianGeometry::getRotationMatrix(180.0, secondaryAxis));
+	}
+
+	unsigned int copies = getNumberOfCopies();
+	operatorMatrices.resize(9 * copies);
+	Matrix flipMatrix = flip.getRotationMatrix();
+	for (unsigned int op=0; op < copies; op++) {
+		Matrix m = rotations[op % N].getRotationMatrix();
+		if (op >= N) {
+			m = flipMatrix * m;
+		}
+		for (unsigned int i=0; i < 3; i++) {
+			for (unsigned int j=0; j < 3; j++) {
+				operatorMatrices[9*op + 3*i + j] = m[i][j];
+			}
+		}
+	}
+
+	uniqueOperators.clear();
+	uniqueWeights.clear();
+	for (unsigned int k=1; 2*k <= N; k++) {
+		uniqueOperators.push_back(k);
+		uniqueWeights.push_back(2*k == N ? 0.5 : 1.0);
+	}
+	if (dihedral) {
+		for (unsigned int k=0; k < N; k++) {
+			uniqueOperators.push_back(N + k);
+			uniqueWeights.push_back(0.5);
+		}
+	}
+	images.resize(copies);
+	imageGroups.resize(copies);
+}
+
+void Symmetry::rotateGradient(unsigned int _op, double * _xyz) const {
+	const double * m = &operatorMatrices[9 * _op];
+	double x = _xyz[0];
+	double y = _xyz[1];
+	double z = _xyz[2];
+	_xyz[0] = m[0]*x + m[3]*y + m[6]*z;
+	_xyz[1] = m[1]*x + m[4]*y + m[7]*z;
+	_xyz[2] = m[2]*x + m[5]*y + m[8]*z;
+}
+
+Atom * Symmetry::getImage(unsigned int _op, Atom * _pSource) {
+	if (_op >= images.size()) {
+		cerr << "ERROR 71303: invalid symmetry operator " << _op << " in Atom * Symmetry::getImage(unsigned int _op, Atom * _pSource)" << endl;
+		return NULL;
+	}
+	map<Atom*, Atom*>::iterator found = images[_op].find(_pSource);
+	if (found != images[_op].end()) {
+		return found->second;
+	}
+
+	/*************************************************************
+	 *  The images are copies with all the alternative
+	 *  conformations moved, so that cutoff boxes can be computed
+	 *  on them directly.  The atoms of the source group are
+	 *  imaged together, in the same order, in a new group.
+	 *************************************************************/
+	string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	string chainId = _op < alphabet.size() ? alphabet.substr(_op, 1) : _pSource->getChainId();
+	AtomGroup * pSourceGroup = _pSource->getParentGroup();
+	AtomGroup * pImageGroup = NULL;
+	vector<Atom*> sources;
+	if (pSourceGroup != NULL) {
+		pImageGroup = new AtomGroup;
+		pImageGroup->setResidueName(pSourceGroup->getResidueName());
+		pImageGroup->setResidueNumber(pSourceGroup->getResidueNumber());
+		pImageGroup->setResidueIcode(pSourceGroup->getResidueIcode());
+		pImageGroup->setChainId(chainId);
+		imageGroups[_op][pSourceGroup] = pImageGroup;
+		sources.insert(sources.end(), pSourceGroup->begin(), pSourceGroup->end());
+	} else {
+		sources.push_back(_pSource);
+	}
+
+	Atom * pOut = NULL;
+	for (vector<Atom*>::iterator k=sources.begin(); k!=sources.end(); k++) {
+		Atom * pImage = new Atom(**k);
+		vector<CartesianPoint*> & coor = pImage->getAllCoor();
+		for (vector<CartesianPoint*>::iterator l=coor.begin(); l!=coor.end(); l++) {
+			**l = transform(_op, **l);
+		}
+		if (pImageGroup != NULL) {
+			pImage->setParentGroup(pImageGroup);
+			pImageGroup->push_back(pImage);
+		} else {
+			pImage->setChainId(chainId);
+		}
+		pImage->setMinimizationIndex(-1);
+		images[_op][*k] = pImage;
+		if (*k == _pSource) {
+			pOut = pImage;
+		}
+	}
+	return pOut;
+}
+
+void Symmetry::clearImages() {
+	for (unsigned int i=0; i < images.size(); i++) {
+		for (map<Atom*, Atom*>::iterator k=images[i].begin(); k!=images[i].end(); k++) {
+			delete k->second;
+		}
+		images[i].clear();
+	}
+	for (unsigned int i=0; i < imageGroups.size(); i++) {
+		for (map<AtomGroup*, AtomGroup*>::iterator k=imageGroups[i].begin(); k!=imageGroups[i].end(); k++) {
+			delete k->second;
+		}
+		imageGroups[i].clear();
+	}
+}
+
+void Symmetry::applySymmetry(AtomPointerVector &_ats, bool _addToOriginalVector) {
+	if (N == 0) {
+		cerr << "WARNING 71304: symmetry operators not set in void Symmetry::applySymmetry(AtomPointerVector &_ats, bool _addToOriginalVector)" << endl;
+		return;
+	}
+	if (dihedral) {
+		applyDN(_ats, N, primaryAxis, secondaryAxis, _addToOriginalVector);
+	} else {
+		applyCN(_ats, N, primaryAxis, _addToOriginalVector);
+	}
 }
 
 // Generic C_N symmetry written from C2 template by David Slochower
@@ -30,8 +30,41 @@ You should have received a copy of the GNU Lesser General Public
 #ifndef SYMMETRY_H
 #define SYMMETRY_H
 
+#include <map>
+
 #include "AtomPointerVector.h"
+#include "AtomGroup.h"
 #include "Transforms.h"
+#include "RigidTransform.h"
+
+/*************************************************************************
+ *  Symmetric energy mode
+ *
+ *  applyCN/applyDN create every copy of the asymmetric unit.  For energy
+ *  evaluation only the unit itself and one of each pair of equivalent
+ *  interfaces are needed: setCN/setDN store the operators and
+ *
+ *     E(oligomer) / getNumberOfCopies() = E(unit) + sum_g w_g E(unit, g unit)
+ *
+ *  where g runs over the unique operators (getUniqueOperator) with weight
+ *  w_g (getUniqueOperatorWeight): 1, or 0.5 for operators that are their
+ *  own inverse (the C2 rotation of an even CN, the DN flips).
+ *
+ *  Operators are numbered as the copies made by applyCN/applyDN: 0..N-1
+ *  are the rotations by k*360/N about the primary axis (0 is the
+ *  identity), N..2N-1 are the same rotations followed by the 180 degree
+ *  flip around the secondary axis (DN only).  The axes go through the
+ *  origin and, for DN, must be perpendicular.
+ *
+ *  getImage returns an atom (owned by the Symmetry) that stands for the
+ *  copy of a source atom, placeImage moves it to the current position of
+ *  the source (see SymmetricInteraction, which is what the
+ *  CharmmSystemBuilder uses when setSymmetry is called).  If the source
+ *  belongs to an AtomGroup, the images of the whole group are created
+ *  together in an image group, and placeImageGroup moves all of them so
+ *  that group distances (non-bonded cutoffs) are those of the oligomer.
+ *  The full oligomer can still be generated for output with applySymmetry.
+ *************************************************************************/
 
 namespace MSL { 
 class Symmetry {
@@ -50,14 +83,84 @@ class Symmetry {
 		void applyDN(AtomPointerVector &_ats, int _N, const CartesianPoint & _primaryAxis, const CartesianPoint & _secondaryAxis,  bool _addToOriginalVector=false); // N is number of symmetry mates
 
 		AtomPointerVector& getAtomPointers();
+
+		// Symmetric energy mode: store the operators without creating the copies
+		void setCN(int _N, const CartesianPoint & _primaryAxis=CartesianPoint(0.,0.,1.));
+		void setDN(int _N); // default axes, as in applyDN(_ats, _N)
+		void setDN(int _N, const CartesianPoint & _primaryAxis, const CartesianPoint & _secondaryAxis);
+		bool isSet() const;
+		bool isDihedral() const;
+		int getN() const;
+
+		unsigned int getNumberOfCopies() const; // N for CN, 2N for DN
+		unsigned int getNumberOfUniqueOperators() const;
+		unsigned int getUniqueOperator(unsigned int _n) const;
+		double getUniqueOperatorWeight(unsigned int _n) const;
+
+		CartesianPoint transform(unsigned int _op, const CartesianPoint & _point) const;
+		void rotateGradient(unsigned int _op, double * _xyz) const; // back to the frame of the source: g = M^T g'
+
+		Atom * getImage(unsigned int _op, Atom * _pSource); // created on first request
+		void placeImage(unsigned int _op, Atom & _source, Atom & _image) const;
+		void placeImageGroup(unsigned int _op, Atom & _source, Atom & _image) const;
+		void clearImages();
+
+		// generate the full oligomer (as applyCN/applyDN) with the stored operators
+		void applySymmetry(AtomPointerVector &_ats, bool _addToOriginalVector=false);
+
 	private:
 		void deletePointers();
 		void copy(const Symmetry & _symmetry);
+		void setOperators();
 
 		AtomPointerVector atoms;
+
+		int N; // 0 if the operators are not set
+		bool dihedral;
+		CartesianPoint primaryAxis;
+		CartesianPoint secondaryAxis;
+		std::vector<RigidTransform> rotations; // rotations[k], k*360/N around the primary axis
+		RigidTransform flip;
+		std::vector<double> operatorMatrices; // 9 per operator, row major, for the gradients
+		std::vector<unsigned int> uniqueOperators;
+		std::vector<double> uniqueWeights;
+		std::vector<std::map<Atom*, Atom*> > images; // images[op][source]
+		std::vector<std::map<AtomGroup*, AtomGroup*> > imageGroups; // imageGroups[op][source group]
 	
 };
 inline AtomPointerVector& Symmetry::getAtomPointers() { return atoms; }
+inline bool Symmetry::isSet() const { return N > 0; }
+inline bool Symmetry::isDihedral() const { return dihedral; }
+inline int Symmetry::getN() const { return N; }
+inline unsigned int Symmetry::getNumberOfCopies() const { return dihedral ? 2 * N : N; }
+inline unsigned int Symmetry::getNumberOfUniqueOperators() const { return uniqueOperators.size(); }
+inline unsigned int Symmetry::getUniqueOperator(unsigned int _n) const { return uniqueOperators[_n]; }
+inline double Symmetry::getUniqueOperatorWeight(unsigned int _n) const { return uniqueWeights[_n]; }
+inline CartesianPoint Symmetry::transform(unsigned int _op, const CartesianPoint & _point) const {
+	// same two steps as applyDN (rotate the CN copy, then flip it) so that
+	// the images match the atoms of the full oligomer exactly
+	CartesianPoint out(_point);
+	rotations[_op % N].apply(out);
+	if (_op >= (unsigned int)N) {
+		flip.apply(out);
+	}
+	return out;
+}
+inline void Symmetry::placeImage(unsigned int _op, Atom & _source, Atom & _image) const {
+	_image.setCoor(transform(_op, _source.getCoor()));
+}
+inline void Symmetry::placeImageGroup(unsigned int _op, Atom & _source, Atom & _image) const {
+	// the atoms of an image group are in the same order as in the source group
+	AtomGroup * pSourceGroup = _source.getParentGroup();
+	AtomGroup * pImageGroup = _image.getParentGroup();
+	if (pSourceGroup == NULL || pImageGroup == NULL) {
+		placeImage(_op, _source, _image);
+		return;
+	}
+	for (unsigned int i=0; i < pImageGroup->size(); i++) {
+		(*pImageGroup)[i]->setCoor(transform(_op, (*pSourceGroup)[i]->getCoor()));
+	}
+}
 
 }
 
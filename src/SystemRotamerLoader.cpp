@@ -357,12 +357,63 @@ bool SystemRotamerLoader::loadRotamers(Position * _pPos, string _resName, unsign
 		}
 
 	}
+	/***********************************************************************
+	 *
+	 *   Resolve once the IC values that each definition edits (what
+	 *   editBond, editAngle and editDihedral would change for both
+	 *   directions of the IC)
+	 *   
+	 ************************************************************************/
+	vector<vector<ValueEdit> > valueEdits(defiAtoms.size());
+	for (unsigned int j=0; j<defiAtoms.size(); j++) {
+		vector<double*> pointers;
+		bool inverted = false;
+		for (unsigned int dir=0; dir<2; dir++) {
+			double sign = 1.0;
+			bool degrees = true;
+			if (defiAtoms[j].size() == 2) {
+				degrees = false;
+				pIcTable->getBondValuePointers(defiAtoms[j][dir], defiAtoms[j][1-dir], pointers);
+			} else if (defiAtoms[j].size() == 3) {
+				pIcTable->getAngleValuePointers(defiAtoms[j][2*dir], defiAtoms[j][1], defiAtoms[j][2-2*dir], pointers);
+			} else if (defiAtoms[j].size() == 4) {
+				pIcTable->getDihedralValuePointers(defiAtoms[j][3*dir], defiAtoms[j][1], defiAtoms[j][2], defiAtoms[j][3-3*dir], pointers, inverted);
+				// the reverse IC gets the opposite value, and the inverted order another sign change
+				if ((dir == 1) != inverted) {
+					sign = -1.0;
+				}
+			} else {
+				pointers.clear();
+			}
+			for (unsigned int k=0; k<pointers.size(); k++) {
+				ValueEdit edit;
+				edit.pValue = pointers[k];
+				edit.sign = sign;
+				edit.degrees = degrees;
+				valueEdits[j].push_back(edit);
+			}
+		}
+	}
+
 	/***********************************************************************
 	 *
 	 *   Now apply the values for the desired rotamers and rebuild,
 	 *   saving alternate conformations
+	 *
+	 *   The building order is compiled at the first rotamer and
+	 *   replayed for the others.  It is recompiled if the previous
+	 *   one built atoms that are not rotamer atoms (they will have
+	 *   coordinates now) or if the path depends on IC values that 
+	 *   are zero
 	 *   
 	 ************************************************************************/
+	map<Atom*, bool> mobileAtomMap;
+	for (vector<Atom*>::iterator k=initAtomPointers.begin(); k!=initAtomPointers.end(); k++) {
+		mobileAtomMap[*k] = true;
+	}
+	vector<IcBuildPlanner::BuildStep> buildSteps;
+	vector<double*> zeroValues;
+	bool recompile = true;
 
 	for (unsigned int i=_start; i<=_end; i++) {
 
@@ -372,20 +423,13 @@ bool SystemRotamerLoader::loadRotamers(Position * _pPos, string _resName, unsign
 		}
 		
 		for (unsigned int j=0; j<icValues[i].size(); j++) {
-			if (defiAtoms[j].size() == 2) {
-				//cout << "IC BOND["<<i<<"]: "<<(*defiAtoms[j][0]).getName()<<" "<<(*defiAtoms[j][1]).getName()<<" "<<icValues[i][j]<<endl;
-				pIcTable->editBond(defiAtoms[j][0], defiAtoms[j][1], icValues[i][j]);
-				pIcTable->editBond(defiAtoms[j][1], defiAtoms[j][0], icValues[i][j]);
-			} else if (defiAtoms[j].size() == 3) {
-				//cout << "IC ANGLE["<<i<<"]: "<<(*defiAtoms[j][0]).getName()<<" "<<(*defiAtoms[j][1]).getName()<<" "<<(*defiAtoms[j][2]).getName()<<" "<<icValues[i][j]<<endl;
-				pIcTable->editAngle(defiAtoms[j][0], defiAtoms[j][1], defiAtoms[j][2], icValues[i][j]);
-				pIcTable->editAngle(defiAtoms[j][2], defiAtoms[j][1], defiAtoms[j][0], icValues[i][j]);
-			} else if (defiAtoms[j].size() == 4) {
-				//cout << "IC DIHEDRAL["<<i<<"]: "<<(*defiAtoms[j][0]).getName()<<" "<<(*defiAtoms[j][1]).getName()<<" "<<(*defiAtoms[j][2]).getName()<<" "<<(*defiAtoms[j][3]).getName()<<" "<<icValues[i][j]<<endl;
-				pIcTable->editDihedral(defiAtoms[j][0], defiAtoms[j][1], defiAtoms[j][2], defiAtoms[j][3], icValues[i][j]);
-				pIcTable->editDihedral(defiAtoms[j][3], defiAtoms[j][1], defiAtoms[j][2], defiAtoms[j][0], -icValues[i][j]);
+			for (vector<ValueEdit>::iterator k=valueEdits[j].begin(); k!=valueEdits[j].end(); k++) {
+				if (k->degrees) {
+					*(k->pValue) = k->sign * (icValues[i][j] / 180.0 * M_PI);
+				} else {
+					*(k->pValue) = icValues[i][j];
+				}
 			}
-
 		}
 		for (vector<Atom*>::iterator k=initAtomPointers.begin(); k!=initAtomPointers.end(); k++) {
 			//if (i>0 && (*k)->getNumberOfAltConformations() != 0) {
@@ -397,11 +441,27 @@ bool SystemRotamerLoader::loadRotamers(Position * _pPos, string _resName, unsign
 			(*k)->wipeCoordinates();
 		}
 
-		
+		if (!recompile && zeroValues.size() == 0) {
+			for (vector<IcBuildPlanner::BuildStep>::iterator k=buildSteps.begin(); k!=buildSteps.end(); k++) {
+				if (*(k->pDistance) == 0.0 || *(k->pAngle) == 0.0) {
+					recompile = true;
+					break;
+				}
+			}
+		}
+		if (recompile || zeroValues.size() > 0) {
+			IcBuildPlanner::compile(initAtomPointers, true, buildSteps, zeroValues);
+			recompile = false;
+		}
 
-		for (vector<Atom*>::iterator k=initAtomPointers.begin(); k!=initAtomPointers.end(); k++) {
-			//cout << "Trying to build from IC: "<<(*k)->getName()<<endl;
-			(*k)->buildFromIc();
+		for (vector<IcBuildPlanner::BuildStep>::iterator k=buildSteps.begin(); k!=buildSteps.end(); k++) {
+			if (k->pAtom->hasCoor()) {
+				continue;
+			}
+			IcBuildPlanner::placeAtom(*k);
+			if (mobileAtomMap.find(k->pAtom) == mobileAtomMap.end()) {
+				recompile = true;
+			}
 		}
 		//pSystem->printIcTable();
 	}
@@ -34,6 +34,7 @@ You should have received a copy of the GNU Lesser General Public
 
 #include "RotamerLibrary.h"
 #include "System.h"
+#include "IcBuildPlanner.h"
 
 
 namespace MSL { 
@@ -93,6 +94,17 @@ class SystemRotamerLoader {
 	private:
 		void setup(System * _pSys, std::string _libraryFile, std::string _beblFile="");
 		void deletePointers();
+
+		/***************************************************
+		 *  An IC value that a rotamer library definition
+		 *  edits (the building order is compiled by the
+		 *  IcBuildPlanner and replayed for every conformation)
+		 ***************************************************/
+		struct ValueEdit {
+			double * pValue;
+			double sign;
+			bool degrees;
+		};
 	
 		bool deleteRotLib_flag;
 		
@@ -0,0 +1,207 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include "TorsionMinimizer.h"
+
+using namespace MSL;
+using namespace std;
+
+TorsionMinimizer::TorsionMinimizer() : LBFGSMinimizer() {
+	pIcTable = NULL;
+	minimizeBackbone = false;
+}
+
+TorsionMinimizer::TorsionMinimizer(System& _sys) : LBFGSMinimizer(_sys) {
+	pIcTable = &(_sys.getIcTable());
+	minimizeBackbone = false;
+}
+
+TorsionMinimizer::TorsionMinimizer(EnergySet* _es, AtomPointerVector* _av, IcTable* _icTable) : LBFGSMinimizer(_es, _av) {
+	pIcTable = _icTable;
+	minimizeBackbone = false;
+}
+
+TorsionMinimizer::~TorsionMinimizer() {
+}
+
+void TorsionMinimizer::setSystem(System& _sys) {
+	LBFGSMinimizer::setSystem(_sys);
+	pIcTable = &(_sys.getIcTable());
+}
+
+bool TorsionMinimizer::isBackboneBond(Atom * _pAtom1, Atom * _pAtom2) const {
+	string name1 = _pAtom1->getName();
+	string name2 = _pAtom2->getName();
+	if (name1 > name2) {
+		name1.swap(name2);
+	}
+	// phi (N-CA) and psi (C-CA)
+	return (name1 == "CA" && name2 == "N") || (name1 == "C" && name2 == "CA");
+}
+
+bool TorsionMinimizer::findMovingAtoms(Torsion & _torsion, const set<Atom*> & _active) const {
+	// walk the bonds from pAxis2 without crossing pAxis1
+	set<Atom*> visited;
+	visited.insert(_torsion.pAxis1);
+	visited.insert(_torsion.pAxis2);
+	vector<Atom*> stack(1, _torsion.pAxis2);
+	_torsion.moving.clear();
+	while (!stack.empty()) {
+		Atom * pAtom = stack.back();
+		stack.pop_back();
+		_torsion.moving.push_back(pAtom);
+		vector<Atom*> bonded = pAtom->getBonds();
+		for (unsigned int i=0; i < bonded.size(); i++) {
+			if (bonded[i] == _torsion.pAxis1 && pAtom != _torsion.pAxis2) {
+				// back to the other side of the bond: it is in a ring
+				return false;
+			}
+			if (_active.find(bonded[i]) == _active.end() || !visited.insert(bonded[i]).second) {
+				continue;
+			}
+			stack.push_back(bonded[i]);
+		}
+	}
+
+	// pAxis2 is on the axis, something else has to move
+	if (_torsion.moving.size() < 2) {
+		return false;
+	}
+
+	_torsion.slots.resize(_torsion.moving.size());
+	for (unsigned int i=0; i < _torsion.moving.size(); i++) {
+		int index = _torsion.moving[i]->getMinimizationIndex();
+		if (index == -1) {
+			// it would move a fixed atom
+			return false;
+		}
+		_torsion.slots[i] = 3 * (index - 1);
+	}
+	return true;
+}
+
+bool TorsionMinimizer::setupVariables(vector<double> & _x) {
+	if (pAtoms == NULL  || pEset == NULL){
+		cerr << "ERROR TorsionMinimizer::minimize() either pAtoms or energySet is NULL.\n";
+		return false;	 
+	}
+	if (pIcTable == NULL) {
+		cerr << "ERROR TorsionMinimizer::minimize() the IcTable is NULL.\n";
+		return false;
+	}
+	setupAtomGradient();
+
+	set<Atom*> active(pAtoms->begin(), pAtoms->end());
+	set<pair<Atom*, Atom*> > bonds;
+
+	torsions.clear();
+	for (IcTable::iterator k=pIcTable->begin(); k!=pIcTable->end(); k++) {
+		if ((*k)->isImproper()) {
+			continue;
+		}
+		Torsion torsion;
+		torsion.pAxis1 = (*k)->getAtom2();
+		torsion.pAxis2 = (*k)->getAtom3();
+		if (torsion.pAxis1 == NULL || torsion.pAxis2 == NULL || active.find(torsion.pAxis1) == active.end() || active.find(torsion.pAxis2) == active.end()) {
+			continue;
+		}
+		// the peptide bond and any other bond between residues are not rotated
+		if (torsion.pAxis1->getParentResidue() != torsion.pAxis2->getParentResidue()) {
+			continue;
+		}
+		if (!minimizeBackbone && isBackboneBond(torsion.pAxis1, torsion.pAxis2)) {
+			continue;
+		}
+		// several IC entries share the same rotatable bond
+		pair<Atom*, Atom*> bond(min(torsion.pAxis1, torsion.pAxis2), max(torsion.pAxis1, torsion.pAxis2));
+		if (!bonds.insert(bond).second) {
+			continue;
+		}
+		if (findMovingAtoms(torsion, active)) {
+			torsions.push_back(torsion);
+		}
+	}
+
+	_x.assign(torsions.size(), 0.0);
+	currentRotation.assign(torsions.size(), 0.0);
+	return true;
+}
+
+void TorsionMinimizer::rotate(const Torsion & _torsion, double _radians) {
+	// Rodrigues rotation about the pAxis1 -> pAxis2 bond
+	CartesianPoint origin = _torsion.pAxis1->getCoor();
+	CartesianPoint u = (_torsion.pAxis2->getCoor() - origin).getUnit();
+	double c = cos(_radians);
+	double s = sin(_radians);
+	for (unsigned int i=0; i < _torsion.moving.size(); i++) {
+		CartesianPoint r = _torsion.moving[i]->getCoor() - origin;
+		CartesianPoint rotated = r * c + u.cross(r) * s + u * ((u * r) * (1.0 - c));
+		_torsion.moving[i]->setCoor(rotated + origin);
+	}
+}
+
+void TorsionMinimizer::setVariables(const vector<double> & _x) {
+	// each rotation changes only its own dihedral (the atoms of the
+	// other torsions move rigidly) so the order does not matter
+	for (unsigned int k=0; k < torsions.size(); k++) {
+		double delta = _x[k] - currentRotation[k];
+		if (delta != 0.0) {
+			rotate(torsions[k], delta);
+			currentRotation[k] = _x[k];
+		}
+	}
+}
+
+double TorsionMinimizer::energyAndGradient(const vector<double> & _x, vector<double> & _g) {
+	setVariables(_x);
+	double energy = calcAtomGradient();
+
+	for (unsigned int k=0; k < torsions.size(); k++) {
+		const Torsion & torsion = torsions[k];
+		CartesianPoint origin = torsion.pAxis1->getCoor();
+		CartesianPoint u = (torsion.pAxis2->getCoor() - origin).getUnit();
+
+		// torque of the Cartesian gradient about the axis
+		double tx = 0.0;
+		double ty = 0.0;
+		double tz = 0.0;
+		for (unsigned int i=0; i < torsion.moving.size(); i++) {
+			const CartesianPoint & p = torsion.moving[i]->getCoor();
+			double rx = p.getX() - origin.getX();
+			double ry = p.getY() - origin.getY();
+			double rz = p.getZ() - origin.getZ();
+			const double * grad = &atomGradient[torsion.slots[i]];
+			tx += ry * grad[2] - rz * grad[1];
+			ty += rz * grad[0] - rx * grad[2];
+			tz += rx * grad[1] - ry * grad[0];
+		}
+		_g[k] = u.getX() * tx + u.getY() * ty + u.getZ() * tz;
+	}
+	return energy;
+}
@@ -0,0 +1,106 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#ifndef TORSIONMINIMIZER_H
+#define TORSIONMINIMIZER_H
+
+#include "LBFGSMinimizer.h"
+#include "IcTable.h"
+
+/*******************************************************************
+ *  Minimization in torsion space.  The rotatable bonds are taken
+ *  from the dihedral (non improper) entries of the IcTable and each
+ *  one becomes a variable.  Bond lengths and angles are not touched.
+ *
+ *     TorsionMinimizer min(sys);
+ *     min.fixAtoms("chain B");     // torsions that would move a fixed atom are left out
+ *     min.minimize();
+ *
+ *  By default only the side chain torsions (chi and the terminal
+ *  methyl, hydroxyl... rotations) are used; setMinimizeBackbone(true)
+ *  adds phi and psi, which move the C-terminal side of the chain.
+ *  Bonds within rings (PRO, aromatics) are skipped.
+ *
+ *  The Cartesian gradient of the EnergySet is converted to
+ *  dE/dtheta with the chain rule: for a rotation about the unit
+ *  axis u through atom2, dE/dtheta = u . sum_i (r_i - r_2) x dE/dr_i
+ *  over the atoms moved by the torsion.  The optimization is the
+ *  L-BFGS of the base class.
+ *******************************************************************/
+
+namespace MSL {
+class TorsionMinimizer : public LBFGSMinimizer {
+
+	public:
+
+		TorsionMinimizer();  
+		TorsionMinimizer(System& _sys);  
+		TorsionMinimizer(EnergySet* _es, AtomPointerVector* _av, IcTable* _icTable);
+		~TorsionMinimizer();
+
+		void setSystem(System& _sys);
+
+		// also minimize phi and psi (default false)
+		void setMinimizeBackbone(bool _flag);
+		bool getMinimizeBackbone() const;
+
+		// number of torsions used in the last minimization
+		unsigned int getNumberOfTorsions() const;
+
+	protected:
+		bool setupVariables(std::vector<double> & _x);
+		void setVariables(const std::vector<double> & _x);
+		double energyAndGradient(const std::vector<double> & _x, std::vector<double> & _g);
+
+	private:
+		struct Torsion {
+			Atom * pAxis1; // the rotation is about the pAxis1 -> pAxis2 bond
+			Atom * pAxis2;
+			std::vector<Atom*> moving; // the atoms on the pAxis2 side
+			std::vector<unsigned int> slots; // their position in atomGradient
+		};
+
+		bool isBackboneBond(Atom * _pAtom1, Atom * _pAtom2) const;
+		bool findMovingAtoms(Torsion & _torsion, const std::set<Atom*> & _active) const;
+		void rotate(const Torsion & _torsion, double _radians);
+
+		IcTable * pIcTable;
+		bool minimizeBackbone;
+
+		std::vector<Torsion> torsions;
+		std::vector<double> currentRotation; // radians applied to each torsion from the start
+};
+
+inline void TorsionMinimizer::setMinimizeBackbone(bool _flag) {minimizeBackbone = _flag;}
+inline bool TorsionMinimizer::getMinimizeBackbone() const {return minimizeBackbone;}
+inline unsigned int TorsionMinimizer::getNumberOfTorsions() const {return torsions.size();}
+
+}
+
+#endif
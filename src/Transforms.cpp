@@ -62,62 +62,53 @@ Transforms::~Transforms() {
 }
 
 /* -- PRIVATE TRANSFORM FUNCTIONS THAT DO NOT UPDATE THE HISTORY AND LAST TRANSFORM MEMORY -- */
-void Transforms::translateAtom(Atom & _atom, const CartesianPoint & _p) {
+void Transforms::transformAtom(Atom & _atom, const RigidTransform & _transform) {
 	if (transformAllCoors_flag) {
-		for (vector<CartesianPoint *>::iterator m=_atom.getAllCoor().begin(); m!=_atom.getAllCoor().end(); m++) {
-			*(*m) += _p;
-		}
+		_transform.apply(_atom.getAllCoor());
 		// hidden alt coors
-		for (vector<CartesianPoint *>::iterator m=_atom.getHiddenCoor().begin(); m!=_atom.getHiddenCoor().end(); m++) {
-			*(*m) += _p;
-		}
+		_transform.apply(_atom.getHiddenCoor());
 	} else {
-		_atom.getCoor() += _p;
+		_transform.apply(_atom.getCoor());
 	}
 }
 
-void Transforms::rotateAtom(Atom & _atom, const Matrix & _rotMatrix, const CartesianPoint & _rotCenter) {
-	if (transformAllCoors_flag) {
-		for (vector<CartesianPoint *>::iterator m=_atom.getAllCoor().begin(); m!=_atom.getAllCoor().end(); m++) {
-			*(*m) -= _rotCenter;
-			*(*m) *= _rotMatrix;
-			*(*m) += _rotCenter;
-		}
-		// hidden alt coors
-		for (vector<CartesianPoint *>::iterator m=_atom.getHiddenCoor().begin(); m!=_atom.getHiddenCoor().end(); m++) {
-			*(*m) -= _rotCenter;
-			*(*m) *= _rotMatrix;
-			*(*m) += _rotCenter;
-		}
-	} else {
-		_atom.getCoor() -= _rotCenter;
-		_atom.getCoor() *= _rotMatrix;
-		_atom.getCoor() += _rotCenter;
+void Transforms::transformAtoms(AtomPointerVector & _atoms, const RigidTransform & _transform) {
+	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
+		transformAtom(**k, _transform);
+	}
+}
+
+void Transforms::transformAtoms(set<Atom*> & _atoms, const RigidTransform & _transform) {
+	for (set<Atom*>::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
+		transformAtom(**k, _transform);
 	}
 }
 
+void Transforms::translateAtom(Atom & _atom, const CartesianPoint & _p) {
+	transformAtom(_atom, RigidTransform(_p));
+}
+
+void Transforms::rotateAtom(Atom & _atom, const Matrix & _rotMatrix, const CartesianPoint & _rotCenter) {
+	transformAtom(_atom, RigidTransform(_rotMatrix, _rotCenter));
+}
+
 bool Transforms::alignAtom(Atom & _atom, const CartesianPoint & _target, const CartesianPoint & _rotCenter) {
 	// apply to the active atom in the if statement
 	if (align(_atom.getCoor(), _target, _rotCenter)) {
 
 		if (transformAllCoors_flag && _atom.getNumberOfAltConformations() > 1) {
 			// apply to all alt confs the same transform
+			RigidTransform t(lastRotMatrix, _rotCenter);
 			unsigned int active = _atom.getActiveConformation();
 			vector<CartesianPoint *> & pts = _atom.getAllCoor();
 			for (unsigned int i=0; i<pts.size(); i++) {
 				// the active was already transformed
 				if (i != active) {
-					*pts[i] -= _rotCenter;
-					*pts[i] *= lastRotMatrix;
-					*pts[i] += _rotCenter;
+					t.apply(*pts[i]);
 				}
 			}
 			// hidden alt coors
-			for (vector<CartesianPoint *>::iterator m=_atom.getHiddenCoor().begin(); m!=_atom.getHiddenCoor().end(); m++) {
-				*(*m) -= _rotCenter;
-				*(*m) *= lastRotMatrix;
-				*(*m) += _rotCenter;
-			}
+			t.apply(_atom.getHiddenCoor());
 		}
 		return true;
 	}
@@ -128,22 +119,17 @@ bool Transforms::orientAtom(Atom & _atom, const CartesianPoint & _target, const
 	if (orient(_atom.getCoor(), _target, _axis1, _axis2)) {
 		if (transformAllCoors_flag && _atom.getNumberOfAltConformations() > 1) {
 			// apply to all alt confs
+			RigidTransform t(lastRotMatrix, _axis1);
 			unsigned int active = _atom.getActiveConformation();
 			vector<CartesianPoint *> & pts = _atom.getAllCoor();
 			for (unsigned int i=0; i<pts.size(); i++) {
 				// the active was already transformed
 				if (i != active) {
-					*pts[i] -= _axis1;
-					*pts[i] *= lastRotMatrix;
-					*pts[i] += _axis1;
+					t.apply(*pts[i]);
 				}
 			}
 			// hidden alt coors
-			for (vector<CartesianPoint *>::iterator m=_atom.getHiddenCoor().begin(); m!=_atom.getHiddenCoor().end(); m++) {
-				*(*m) -= _axis1;
-				*(*m) *= lastRotMatrix;
-				*(*m) += _axis1;
-			}
+			t.apply(_atom.getHiddenCoor());
 		}
 		return true;
 	}
@@ -239,9 +225,7 @@ bool Transforms::orient(Atom & _atom, const CartesianPoint & _target, const Cart
 }
 
 void Transforms::translate(AtomPointerVector & _atoms, CartesianPoint _p) {
-	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-		translateAtom(*(*k), _p);
-	} 
+	transformAtoms(_atoms, RigidTransform(_p));
 	if (saveHistory_flag) {
 		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
 			k->second += _p;
@@ -253,9 +237,7 @@ void Transforms::translate(AtomPointerVector & _atoms, CartesianPoint _p) {
 void Transforms::Xrotate(AtomPointerVector & _atoms, double _degrees) {
 	lastRotMatrix = CartesianGeometry::getXRotationMatrix(_degrees);
 
-	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-		rotateAtom(*(*k), lastRotMatrix);
-	} 
+	transformAtoms(_atoms, RigidTransform(lastRotMatrix));
 	if (saveHistory_flag) {
 		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
 			k->second *= lastRotMatrix;
@@ -266,9 +248,7 @@ void Transforms::Xrotate(AtomPointerVector & _atoms, double _degrees) {
 void Transforms::Yrotate(AtomPointerVector & _atoms, double _degrees) {
 	lastRotMatrix = CartesianGeometry::getYRotationMatrix(_degrees);
 
-	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-		rotateAtom(*(*k), lastRotMatrix);
-	} 
+	transformAtoms(_atoms, RigidTransform(lastRotMatrix));
 	if (saveHistory_flag) {
 		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
 			k->second *= lastRotMatrix;
@@ -279,9 +259,7 @@ void Transforms::Yrotate(AtomPointerVector & _atoms, double _degrees) {
 void Transforms::Zrotate(AtomPointerVector & _atoms, double _degrees) {
 	lastRotMatrix = CartesianGeometry::getZRotationMatrix(_degrees);
 
-	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-		rotateAtom(*(*k), lastRotMatrix);
-	} 
+	transformAtoms(_atoms, RigidTransform(lastRotMatrix));
 	if (saveHistory_flag) {
 		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
 			k->second *= lastRotMatrix;
@@ -295,9 +273,7 @@ void Transforms::rotate(AtomPointerVector & _atoms, double _degrees, const Carte
 }
 
 void Transforms::rotate(AtomPointerVector & _atoms, const Matrix & _rotMatrix, const CartesianPoint & _rotCenter) {
-	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-		rotateAtom(*(*k), _rotMatrix, _rotCenter);
-	} 
+	transformAtoms(_atoms, RigidTransform(_rotMatrix, _rotCenter));
 	if (saveHistory_flag) {
 		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
 			k->second -= _rotCenter;
@@ -312,9 +288,7 @@ void Transforms::rotate(AtomPointerVector & _atoms, const Matrix & _rotMatrix, c
 bool Transforms::align(AtomPointerVector & _atoms, const CartesianPoint & _reference, const CartesianPoint & _target, const CartesianPoint & _rotCenter) {
 	CartesianPoint refCopy(_reference);
 	if (align(refCopy, _target, _rotCenter)) {
-		for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-			rotateAtom(*(*k), lastRotMatrix, _rotCenter);
-		}
+		transformAtoms(_atoms, RigidTransform(lastRotMatrix, _rotCenter));
 		if (saveHistory_flag) {
 			for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
 				k->second -= _rotCenter;
@@ -384,9 +358,7 @@ bool Transforms::align(CartesianPoint & _object, const CartesianPoint & _target,
 bool Transforms::orient(AtomPointerVector & _atoms, const CartesianPoint & _reference, const CartesianPoint & _target, const CartesianPoint & _axis1, const CartesianPoint & _axis2) {
 	CartesianPoint refCopy(_reference);
 	if (orient(refCopy, _target, _axis1, _axis2)) {
-		for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-			rotateAtom(*(*k), lastRotMatrix, _axis1);
-		}
+		transformAtoms(_atoms, RigidTransform(lastRotMatrix, _axis1));
 		return true;
 	}
 	return false;
@@ -560,10 +532,8 @@ bool Transforms::rmsdAlignment(AtomPointerVector &_align, AtomPointerVector &_re
 	
 	Matrix rotMatrix = lastRotMatrix.getTranspose();
 
-	for (AtomPointerVector::iterator k=_moveable.begin(); k!=_moveable.end(); k++) {
-		translateAtom(*(*k), pt); // GC2->origin
-		rotateAtom(*(*k), rotMatrix, GC1);
-	}
+	transformAtoms(_moveable, RigidTransform(pt)); // GC2->GC1
+	transformAtoms(_moveable, RigidTransform(rotMatrix, GC1));
 	if (saveHistory_flag) {
 		for (map<string, CartesianPoint>::iterator k=frame.begin(); k!=frame.end(); k++) {
 			k->second -= GC2;
@@ -593,10 +563,8 @@ bool Transforms::revertRmsdAlignment(AtomPointerVector &_align, AtomPointerVecto
 	CartesianPoint oldGC2 = GC1 - lastTranslation;
 	CartesianPoint pt = oldGC2 - GC2;
 
-	for (AtomPointerVector::iterator k = _moveable.begin(); k != _moveable.end(); k++) {
-		translateAtom(*(*k), pt);
-		rotateAtom(*(*k), lastRotMatrix, oldGC2);
-	}
+	transformAtoms(_moveable, RigidTransform(pt));
+	transformAtoms(_moveable, RigidTransform(lastRotMatrix, oldGC2));
 
 	return true;
 }
@@ -640,8 +608,10 @@ void Transforms::applyHistory(Atom & _atom) {
 	orient(tY, frame["Y"], frame["O"], frame["X"]);
 	Matrix rot2 = lastRotMatrix * rot1;
 
-	rotateAtom(_atom, rot2);
-	translateAtom(_atom, frame["O"]);
+	// rotate and then translate
+	RigidTransform t(rot2);
+	t.setTranslation(frame["O"]);
+	transformAtom(_atom, t);
 
 }
 
@@ -653,10 +623,11 @@ void Transforms::applyHistory(AtomPointerVector & _atoms) {
 	CartesianPoint tY = frame["O"] + (CartesianPoint(0.0, 1.0, 0.0) * lastRotMatrix);
 	orient(tY, frame["Y"], frame["O"], frame["X"]);
 	Matrix rot2 = lastRotMatrix * rot1;
-	for (AtomPointerVector::iterator k=_atoms.begin(); k!=_atoms.end(); k++) {
-		rotateAtom(*(*k), rot2);
-		translateAtom(*(*k), frame["O"]);
-	}
+
+	// rotate and then translate
+	RigidTransform t(rot2);
+	t.setTranslation(frame["O"]);
+	transformAtoms(_atoms, t);
 }
 
 
@@ -697,9 +668,7 @@ bool Transforms::setBondDistance(Atom & _atom1, Atom & _atom2, double _distance)
 
 	if (!naturalMovementOnSetDOF_flag) {
 		// move the atoms
-		for (set<Atom*>::iterator k=moveList.begin(); k!=moveList.end(); k++) {
-			translateAtom(**k, traslation); 
-		}
+		transformAtoms(moveList, RigidTransform(traslation));
 	} else {
 		double f1 = (double)moveList.size();
 		double f2 = (double)secondMoveList.size();
@@ -714,12 +683,8 @@ bool Transforms::setBondDistance(Atom & _atom1, Atom & _atom2, double _distance)
 		CartesianPoint t2 = traslation * f1;
 
 		cout << traslation << " " << f1 << " " << t1 << " " << f2 << " " << t2 << endl;
-		for (set<Atom*>::iterator k=moveList.begin(); k!=moveList.end(); k++) {
-			translateAtom(**k, t1); 
-		}
-		for (set<Atom*>::iterator k=secondMoveList.begin(); k!=secondMoveList.end(); k++) {
-			translateAtom(**k, t2); 
-		}
+		transformAtoms(moveList, RigidTransform(t1));
+		transformAtoms(secondMoveList, RigidTransform(t2));
 	}
 	return true;
 }
@@ -779,9 +744,7 @@ bool Transforms::setBondAngle(Atom & _atom1, Atom & _atom2, Atom & _atom3, doubl
 		Matrix m = CartesianGeometry::getRotationMatrix(rotation, rotAxis);
 
 		// move the atoms
-		for (set<Atom*>::iterator k=moveList.begin(); k!=moveList.end(); k++) {
-			rotateAtom(**k, m, _atom2.getCoor()); 
-		}
+		transformAtoms(moveList, RigidTransform(m, _atom2.getCoor()));
 	} else {
 		// calculate the geometric centers of the two sets
 		CartesianPoint CoM1;
@@ -808,12 +771,8 @@ bool Transforms::setBondAngle(Atom & _atom1, Atom & _atom2, Atom & _atom3, doubl
 		Matrix m1 = CartesianGeometry::getRotationMatrix(rotation * f2, rotAxis);
 		Matrix m2 = CartesianGeometry::getRotationMatrix(rotation * f1, rotAxis);
 
-		for (set<Atom*>::iterator k=moveList.begin(); k!=moveList.end(); k++) {
-			rotateAtom(**k, m1, _atom2.getCoor()); 
-		}
-		for (set<Atom*>::iterator k=secondMoveList.begin(); k!=secondMoveList.end(); k++) {
-			rotateAtom(**k, m2, _atom2.getCoor()); 
-		}
+		transformAtoms(moveList, RigidTransform(m1, _atom2.getCoor()));
+		transformAtoms(secondMoveList, RigidTransform(m2, _atom2.getCoor()));
 	}
 
 	return true;
@@ -880,9 +839,7 @@ bool Transforms::setDihedral(Atom & _atom1, Atom & _atom2, Atom & _atom3, Atom &
 		// get the rotation matrix
 		Matrix m = CartesianGeometry::getRotationMatrix(rotation, rotAxis);
 
-		for (set<Atom*>::iterator k=moveList.begin(); k!=moveList.end(); k++) {
-			rotateAtom(**k, m, _atom2.getCoor()); 
-		}
+		transformAtoms(moveList, RigidTransform(m, _atom2.getCoor()));
 	} else {
 		// calculate the geometric centers of the two sets
 		CartesianPoint CoM1;
@@ -909,12 +866,8 @@ bool Transforms::setDihedral(Atom & _atom1, Atom & _atom2, Atom & _atom3, Atom &
 		Matrix m1 = CartesianGeometry::getRotationMatrix(rotation * f2, rotAxis);
 		Matrix m2 = CartesianGeometry::getRotationMatrix(rotation * f1, rotAxis);
 
-		for (set<Atom*>::iterator k=moveList.begin(); k!=moveList.end(); k++) {
-			rotateAtom(**k, m1, _atom2.getCoor()); 
-		}
-		for (set<Atom*>::iterator k=secondMoveList.begin(); k!=secondMoveList.end(); k++) {
-			rotateAtom(**k, m2, _atom2.getCoor()); 
-		}
+		transformAtoms(moveList, RigidTransform(m1, _atom2.getCoor()));
+		transformAtoms(secondMoveList, RigidTransform(m2, _atom2.getCoor()));
 	}
 
 
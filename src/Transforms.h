@@ -36,6 +36,7 @@ You should have received a copy of the GNU Lesser General Public
 #include "Residue.h"
 #include "Quaternion.h"
 #include "SphericalPoint.h"
+#include "RigidTransform.h"
 #include <math.h>
 
 
@@ -182,6 +183,12 @@ class Transforms {
 
 	//	void findLinkedAtoms(Atom * _pAtom, const std::map<Atom*, bool> & _excluded, std::map<Atom*, bool> & _list);
 
+		// apply a transformation to the current or all coordinates of
+		// the atoms (according to transformAllCoors_flag)
+		void transformAtom(Atom & _atom, const RigidTransform & _transform);
+		void transformAtoms(AtomPointerVector & _atoms, const RigidTransform & _transform);
+		void transformAtoms(std::set<Atom*> & _atoms, const RigidTransform & _transform);
+
 		void translateAtom(Atom & _atom, const CartesianPoint & _p);
 		void rotateAtom(Atom & _atom, const Matrix & _rotMatrix, const CartesianPoint & _rotCenter=CartesianPoint(0.0, 0.0, 0.0));
 		bool alignAtom(Atom & _atom, const CartesianPoint & _target, const CartesianPoint & _rotCenter);
@@ -28,14 +28,21 @@ You should have received a copy of the GNU Lesser General Public
 */
 
 #include "VectorHashing.h"
+#include "CartesianGeometry.h"
 
 
 #include "MslOut.h"
 static MslOut MSLOUT("VectorHashing");
 
-VectorHashing::VectorHashing(){
-	archiveType = "binary";
+using namespace MSL::CartesianGeometry;
+
+// checkpoint header: magic string and format version
+static const char VECTORHASH_MAGIC[8] = {'M','S','L','V','H','A','S','H'};
+static const unsigned int VECTORHASH_VERSION = 1;
+
+const unsigned int VectorHashing::KeyTable::NOT_FOUND;
 
+VectorHashing::VectorHashing(){
 	distanceGridSize = 0.5;
 	angleGridSize    = 75;
 	dihedralGridSize = 10;
@@ -43,7 +50,6 @@ VectorHashing::VectorHashing(){
 }
 
 VectorHashing::VectorHashing(const VectorHashing &_copyThis){
-	archiveType = _copyThis.archiveType;
 	distanceGridSize = _copyThis.distanceGridSize;
 	angleGridSize = _copyThis.angleGridSize;
 	dihedralGridSize = _copyThis.dihedralGridSize;
@@ -54,6 +60,16 @@ VectorHashing::~VectorHashing(){
 
 }
 
+void VectorHashing::clear(){
+	ids.clear();
+	idLookup.clear();
+	positionIds.clear();
+	pairs.clear();
+	pairLookup.clear();
+	geometricLookup.clear();
+	geometricBins.clear();
+}
+
 
 bool VectorHashing::addToVectorHash(System &_sys, string _id, bool _printIt){
 
@@ -71,10 +87,17 @@ bool VectorHashing::addToVectorHash(Chain &_ch,string _id,bool _printIt){
 	stringstream chainSpecificId;
 	chainSpecificId << _id << ":" ;
 
-	vector<string> chainPositionIds;
+	vector<unsigned int> chainPositionIds;
 	MSLOUT.stream() << "Working on chain "<<chainSpecificId.str()<<endl;
 
-	// For each position
+	/*
+	  First pass: intern the id and store the CA/CB coordinates of every 
+	  rotamer once, so that the pair loop below does not need to switch
+	  rotamers, format ids or build pseudo C-betas over and over
+	*/
+	vector<vector<unsigned int> > rotIds(_ch.positionSize());
+	vector<vector<CartesianPoint> > rotCA(_ch.positionSize());
+	vector<vector<CartesianPoint> > rotCB(_ch.positionSize());
 	for (uint i = 0; i < _ch.positionSize();i++){
 
 		Position &posI = _ch.getPosition(i);
@@ -90,144 +113,134 @@ bool VectorHashing::addToVectorHash(Chain &_ch,string _id,bool _printIt){
 			// Skip over residues that don't have CA, CB atoms..
 			if (!posI.atomExists("CA") || (posI.getResidueName() != "GLY" && !posI.atomExists("CB") ) ) continue;
 
-
-			Atom *caI  = &posI.getAtom("CA");
-			Atom *cbI  = NULL;
+			rotCA[i].push_back(posI.getAtom("CA").getCoor());
 
 			// Compute a CB for glycines
 			if (posI.getResidueName() == "GLY"){
-				cbI = PDBTopology::getPseudoCbeta(posI.getCurrentIdentity());
+				Atom *cbI = PDBTopology::getPseudoCbeta(posI.getCurrentIdentity());
+				rotCB[i].push_back(cbI->getCoor());
+				delete cbI;
 			} else {
-				cbI = &posI.getAtom("CB");
+				rotCB[i].push_back(posI.getAtom("CB").getCoor());
 			}
 
 			stringstream posIid;
 			posIid << chainSpecificId.str()<<","<<posI.getRotamerId();
 		
-			chainPositionIds.push_back(posIid.str());
+			unsigned int id = internId(posIid.str());
+			rotIds[i].push_back(id);
+			chainPositionIds.push_back(id);
 			MSLOUT.stream() << "Adding "<<posIid.str()<< " to chainPositionIds"<<endl;
-			for (uint j = i+1; j < _ch.positionSize();j++){
-
-
-				Position &posJ = _ch.getPosition(j);
-
-				MSLOUT.stream()<<"\t\t\tPosition: "<<posJ.toString()<<endl;
-
-				
-				// For each rotamer
-				for (uint rotJ = 0; rotJ < posJ.getTotalNumberOfRotamers();rotJ++){
-
-					MSLOUT.stream()<<"\t\t\t\tRotamer: "<<rotJ<<endl;
-
-					posJ.setActiveRotamer(rotJ);
-			
-					// Skip over residues that don't have CA, CB atoms..
-					if (!posJ.atomExists("CA") || (posJ.getResidueName() != "GLY" && !posJ.atomExists("CB") ) ) continue;
-
-
-					Atom *caJ  = &posJ.getAtom("CA");
-					Atom *cbJ  = NULL;
-
-					// Compute a CB for glycines
-					if (posJ.getResidueName() == "GLY"){
-						cbJ = PDBTopology::getPseudoCbeta(posJ.getCurrentIdentity());
-					} else {
-						cbJ = &posJ.getAtom("CB");
-					}
-
+		} // POSI
+	} // I
 
-					stringstream posJid;
-					posJid << chainSpecificId.str()<<","<<posJ.getRotamerId();
+	// Second pass: the geometry of each rotamer pair (same quantities as VectorPair distance1, angle1, angle2, torsion1)
+	for (uint i = 0; i < _ch.positionSize();i++){
+		for (uint rotI = 0; rotI < rotIds[i].size();rotI++){
+			CartesianPoint &caI = rotCA[i][rotI];
+			CartesianPoint &cbI = rotCB[i][rotI];
 
-					//MSLOUT.stream() <<"\t\t\t\t\t\t"<<caI->toString()<<endl;
-					//MSLOUT.stream() <<"\t\t\t\t\t\t"<<cbI->toString()<<endl;
-					//MSLOUT.stream() <<"\t\t\t\t\t\t"<<caJ->toString()<<endl;
-					//MSLOUT.stream() <<"\t\t\t\t\t\t"<<cbJ->toString()<<endl;
-					VectorPair vp(caI->getCoor(),cbI->getCoor(),caJ->getCoor(),cbJ->getCoor(),posIid.str(),posJid.str());
-					vp.calcAll();
+			for (uint j = i+1; j < _ch.positionSize();j++){
+				for (uint rotJ = 0; rotJ < rotIds[j].size();rotJ++){
+					CartesianPoint &caJ = rotCA[j][rotJ];
+					CartesianPoint &cbJ = rotCB[j][rotJ];
 
 					// Filter VectorPair Option
 					//					if (filterVectorPairs && filterVectorPair(vp,posI.getResidueName(),posJ.getResidueName())){
 					//						continue;
 					//					}
-					
-					pairPositionHash.insert(make_pair(vp.getVectorPairId(),vp));
-					//MSLOUT.stream()<< "VP: "<<pairPositionHash[vp.getVectorPairId()].toString()<<endl;
-
-					string geometricKey = getHashKey(vp);
-					//if (_printIt) {MSLOUT.stream() << geometricKey<<endl;}
-					geometricHash[geometricKey].push_back(&pairPositionHash[vp.getVectorPairId()]);			
 
-
-					// Visualize the hash
-					//cout << getHashKey(vp)<<endl;
-	
+					addVectorPair(rotIds[i][rotI],rotIds[j][rotJ],CartesianGeometry::distance(caI,caJ),angle(cbI,caI,caJ),angle(cbJ,caJ,caI),dihedral(cbI,caI,caJ,cbJ));
 
 				} // POSJ
 			} // J
-
 		} // POSI
-
 	} // I
 
 	positionIds.push_back(chainPositionIds);
 	return true;
 }
 
-bool VectorHashing::getPositionId(VectorPair &_vp, string &_posId1, string &_posId2){
-	string id = _vp.getVectorPairId();
-	vector<string> tokens1 = MslTools::tokenize(id,"-");
-	
-	if (tokens1.size() < 2){
-		cerr << "ERROR VectorHashing::getPositionId(VectorPair) doesn't have '-' character"<<endl;
-		return false;
+unsigned int VectorHashing::internId(const string &_id){
+
+	map<string,unsigned int>::iterator it = idLookup.find(_id);
+	if (it != idLookup.end()){
+		return it->second;
 	}
-	
-	vector<string> tokens2 = MslTools::tokenize(tokens1[0],":");
-	if (tokens2.size() < 2){
-		cerr << "ERROR VectorHashing::getPositionId(VectorPair) doesn't have ':' character"<<endl;
-		return false;
-	}	
-	string rotId1 = tokens2[1];
-	
-	if (tokens2[1].substr(0,1) == ",") {
-		rotId1 = tokens2[1].substr(1,tokens2[1].size());
+
+	InternedId entry;
+	entry.id = _id;
+	entry.resnum = 0;
+	entry.parsed = false;
+
+	// "pdb:,A 37 LEU 0"
+	vector<string> tokens = MslTools::tokenize(_id,":");
+	if (tokens.size() >= 2){
+		string rotId = tokens[1];
+		if (rotId.substr(0,1) == ",") {
+			rotId = rotId.substr(1,rotId.size());
+		}
+		string identity = "";
+		unsigned int conformation = 0;
+		if (MslTools::parseRotamerId(rotId,entry.chainId,entry.resnum,entry.icode,identity,conformation)){
+			entry.pdb = tokens[0];
+			entry.parsed = true;
+		}
 	}
+	getPositionId(_id,entry.positionId);
 
-	string ch1 = "";
-	int res1   = 0;
-	string icode1 = "";
-	string identity1 = "";
-	unsigned int conformation1 = 0;
-	if (!MslTools::parseRotamerId(rotId1,ch1,res1,icode1,identity1,conformation1)){
-		return false;
+	unsigned int index = ids.size();
+	ids.push_back(entry);
+	idLookup[_id] = index;
+	return index;
+}
+
+void VectorHashing::addVectorPair(unsigned int _idA, unsigned int _idB, double _distance, double _angle1, double _angle2, double _torsion){
+
+	unsigned int pairIndex = pairs.size();
+	if (pairLookup.insert(((unsigned long long)_idA << 32) | _idB, pairIndex)){
+		PairEntry entry;
+		entry.idA = _idA;
+		entry.idB = _idB;
+		entry.distance = _distance;
+		entry.angle1 = _angle1;
+		entry.angle2 = _angle2;
+		entry.torsion = _torsion;
+		pairs.push_back(entry);
 	}
 
-	_posId1 = MslTools::getPositionId(ch1,res1,icode1);
+	unsigned int bin = geometricBins.size();
+	if (geometricLookup.insert(getHashValue(_distance,_angle1,_angle2,_torsion),bin)){
+		geometricBins.push_back(vector<unsigned int>());
+	}
+	geometricBins[bin].push_back(pairIndex);
+}
 
+bool VectorHashing::getPositionId(const string &_id, string &_posId){
 
-	tokens2 = MslTools::tokenize(tokens1[1],":");
-	if (tokens2.size() < 2){
-		cerr << "ERROR VectorHashing::getPositionId(VectorPair) doesn't have ':' character2"<<endl;
+	// "pdb:,A 37 LEU 0" -> "A,37"
+	_posId = "";
+	vector<string> tokens = MslTools::tokenize(_id,":");
+	if (tokens.size() < 2){
+		cerr << "ERROR VectorHashing::getPositionId() "<<_id<<" doesn't have ':' character"<<endl;
 		return false;
 	}	
-	string rotId2 = tokens2[1];
+	string rotId = tokens[1];
 	
-	if (tokens2[1].substr(0,1) == ",") {
-		rotId2 = tokens2[1].substr(1,tokens2[1].size());
+	if (tokens[1].substr(0,1) == ",") {
+		rotId = tokens[1].substr(1,tokens[1].size());
 	}
 
-	string ch2 = "";
-	int res2   = 0;
-	string icode2 = "";
-	string identity2 = "";
-	unsigned int conformation2 = 0;
-	if (!MslTools::parseRotamerId(rotId2,ch2,res2,icode2,identity2,conformation2)){
+	string ch = "";
+	int res   = 0;
+	string icode = "";
+	string identity = "";
+	unsigned int conformation = 0;
+	if (!MslTools::parseRotamerId(rotId,ch,res,icode,identity,conformation)){
 		return false;
 	}
 
-	_posId2 = MslTools::getPositionId(ch2,res2,icode2);
-
+	_posId = MslTools::getPositionId(ch,res,icode);
 
 	return true;
 }
@@ -246,92 +259,49 @@ bool VectorHashing::getPositionId(VectorPair &_vp, string &_posId1, string &_pos
 vector<map<string,vector<string> > > VectorHashing::searchForVectorMatchAll(VectorHashing &_vh, int _numAcceptableEdges){
 
         vector<map<string,vector<string> > > cycles;
-	map<string,map<string,map<string,vector<string> > > > edgeTrees;
 
 	for (uint chain1 = 0; chain1 < positionIds.size();chain1++){
 		
 		for (uint p1 = 0; p1 < positionIds[chain1].size();p1++){
 
-			//MSLOUT.stream() << "Parse: "<<positionIds[chain1][p1]<<" chain "<<chain1<<" pos "<<p1<<endl;
-			vector<string> tokens1 = MslTools::tokenize(positionIds[chain1][p1],":");
-			
-			string pdb1 = tokens1[0];
-			string ch1 = "";
-			int res1   = 0;
-			string icode1 = "";
-			string identity1 = "";
-			unsigned int conformation1 = 0;
-			if (!MslTools::parseRotamerId(tokens1[1],ch1,res1,icode1,identity1,conformation1)){
+			const InternedId &id1 = ids[positionIds[chain1][p1]];
+			if (!id1.parsed){
 				continue;
 			}
 
-			map<string,int> p1PositionMatches;
-			map<string,bool> p1PairMatches;
-
-			// matched.position1,matched.position2 -> [ edge1, edge2, ...]  where edges are complete inverse rotamer descriptions
-			map<string,map<string,map<string,vector<pair<string,string> > > > > p1EdgeTree;
+			// matched.position1,matched.position2 -> number of edges (inverse rotamer pairs)
+			map<string,map<string,map<string,unsigned int> > > p1EdgeTree;
 			for (uint p2 = p1+1; p2 < positionIds[chain1].size();p2++){
 
-				//MSLOUT.stream() << "Parse2: "<<positionIds[chain1][p2]<<endl;
-
-
-				vector<string> tokens2 = MslTools::tokenize(positionIds[chain1][p2],":");
-			
-				string pdb2 = tokens2[0];
-				string ch2 = "";
-				int res2   = 0;
-				string icode2 = "";
-				string identity2 = "";
-				unsigned int conformation2 = 0;
-		
-				if (!MslTools::parseRotamerId(tokens2[1],ch2,res2,icode2,identity2,conformation2)){
+				const InternedId &id2 = ids[positionIds[chain1][p2]];
+				if (!id2.parsed){
 					continue;
 				}
 
 				// Don't look for VectorPairs between pdbs, or different chains, or same position COULD ALSO HAVE RESIDUE SEPARATION SKIP HERE abs(res2-res1) > CUTOFF
 				// Or could include ONLY inter-chain but same PDB geometries.
-				if (pdb1 != pdb2 || ch1 != ch2  || (res1 == res2 && icode1 == icode2)) continue;
+				if (id1.pdb != id2.pdb || id1.chainId != id2.chainId  || (id1.resnum == id2.resnum && id1.icode == id2.icode)) continue;
 
 				// Get the VectorPair data
-				stringstream key;
-				key << pdb1 << ":"<<MslTools::getRotamerId(ch1,res1,icode1,identity1,conformation1)<<"-"<<pdb2 << ":"<<MslTools::getRotamerId(ch2,res2,icode2,identity2,conformation2);
-
-				//MSLOUT.stream() << "KEY: "<<key.str()<<endl;
-				map<string,VectorPair>::iterator itPairs;
-				itPairs = pairPositionHash.find(key.str());
-				if (itPairs == pairPositionHash.end()){
-					        MSLOUT.stream() << "KEY "<<key.str()<<" was NOT found in pairPositionHash"<<endl;
+				unsigned int pairIndex = pairLookup.find(((unsigned long long)positionIds[chain1][p1] << 32) | positionIds[chain1][p2]);
+				if (pairIndex == KeyTable::NOT_FOUND){
+					        MSLOUT.stream() << "KEY "<<id1.id<<"-"<<id2.id<<" was NOT found in pairPositionHash"<<endl;
 						continue;
 				}
 					
-				VectorPair &vp = itPairs->second;
+				const PairEntry &vp = pairs[pairIndex];
 
 				// Search this vector pair against the input VectorHashing structure
-				vector<VectorPair *> *matches = NULL;
-				map<string,vector<VectorPair *> >::iterator itGeo;
-				itGeo = _vh.geometricHash.find(getHashKey(vp));
-				if (itGeo == _vh.geometricHash.end()){
-					//MSLOUT.stream() << "Geometry: "<<getHashKey(vp)<<" was NOT found in geometricHash"<<endl;
+				unsigned int bin = _vh.geometricLookup.find(getHashValue(vp.distance,vp.angle1,vp.angle2,vp.torsion));
+				if (bin == KeyTable::NOT_FOUND){
 					continue;
-				} else {
-					matches = &itGeo->second;
 				}
+				const vector<unsigned int> &matches = _vh.geometricBins[bin];
 
-				//MSLOUT.stream() << "Geometry: "<<getHashKey(vp)<<" was found in geometricHash"<<endl;				
 				// Keep track of per-position matches
-				for (uint m = 0; m < matches->size();m++){
-
-					string matchedPos1 = "";
-					string matchedPos2 = "";
-					getPositionId(*(*matches)[m],matchedPos1,matchedPos2);
-
-					string matchedEdge1 = matchedPos1 + "-" + matchedPos2;
-					string matchedEdge2 = matchedPos2 + "-" + matchedPos1;
-
-					p1EdgeTree[positionIds[chain1][p2]][matchedPos1][matchedPos2].push_back(pair<string,string>((*matches)[m]->getVectorAid(),(*matches)[m]->getVectorBid()));
-					//p1EdgeTree[matchedPos2][matchedPos1].push_back((*matches)[m]->getVectorPairIdReverse());
-
-					//MSLOUT.stream() << "UNIQUE FOUND "<<vp.getVectorPairId()<<" and "<<matchedEdge1<<" "<<p1PositionMatches[matchedEdge1]<<" "<<_numAcceptableEdges<<endl;
+				for (uint m = 0; m < matches.size();m++){
+					const PairEntry &match = _vh.pairs[matches[m]];
+					p1EdgeTree[id2.id][_vh.ids[match.idA].positionId][_vh.ids[match.idB].positionId]++;
 				} // MATCHES END
 
 
@@ -345,39 +315,22 @@ vector<map<string,vector<string> > > VectorHashing::searchForVectorMatchAll(Vect
 			if (p1EdgeTree.size() >= _numAcceptableEdges){
 
 				// For each P2
-				map<string,map<string,map<string,vector<pair<string,string> > > > >::iterator it = p1EdgeTree.begin();
+				map<string,map<string,map<string,unsigned int> > >::iterator it = p1EdgeTree.begin();
 				for (;it != p1EdgeTree.end();it++){
 
 
 					// For each matched position1
-					map<string,map<string,vector<pair<string,string> > > >::iterator it2 = it->second.begin();
+					map<string,map<string,unsigned int> >::iterator it2 = it->second.begin();
 					for (;it2 != it->second.end();it2++){
 
 
 
 						// For each matched position 2
-						map<string,vector<pair<string, string> > >::iterator it3 = it2->second.begin();
+						map<string,unsigned int>::iterator it3 = it2->second.begin();
 						for (;it3 != it2->second.end();it3++){					
 
-						  //fprintf(stdout, "%s = %s and %s = %s  OR  %s = %s and %s = %s with %6d rotamers\n",
-						  //	positionIds[chain1][p1].c_str(),it2->first.c_str(),it->first.c_str(),it3->first.c_str(),
-						  //	positionIds[chain1][p1].c_str(),it3->first.c_str(),it->first.c_str(),it2->first.c_str(), (int)it3->second.size());
-
-							
-							stringstream ss;
-							ss << positionIds[chain1][p1] <<"--"<<it2->first;
-
-							stringstream ss2;
-							ss2 << it->first << "--"<<it3->first;
-							cycle[ss.str()].push_back(ss2.str());
-
-
-							ss.str("");
-							ss << positionIds[chain1][p1] <<"--"<<it3->first;
-							ss2.str("");
-							ss2 << it->first << "--"<<it2->first;
-							cycle[ss.str()].push_back(ss2.str());							
-
+							cycle[id1.id + "--" + it2->first].push_back(it->first + "--" + it3->first);
+							cycle[id1.id + "--" + it3->first].push_back(it->first + "--" + it2->first);
 
 						}
 					}
@@ -390,16 +343,8 @@ vector<map<string,vector<string> > > VectorHashing::searchForVectorMatchAll(Vect
 
 			  if (cycleIt->second.size() == 2){
 			    completeCycles[cycleIt->first] = cycleIt->second;
-
-			    stringstream ss;
-			    ss << "CYCLE: "<<cycleIt->first;
-			    for (uint c = 0; c < cycleIt->second.size();c++){
-			      ss << " AND "<< cycleIt->second[c];
-			    }
-			    //cout << ss.str()<<endl;
 			  }
 			}
-				//edgeTrees[positionIds[chain1][p1]] = p1EdgeTree;
 
 			cycles.push_back(completeCycles);
 		} // P1 END
@@ -470,6 +415,53 @@ string VectorHashing::getHashKey(VectorPair &_vp){
 
 }
 
+unsigned long long VectorHashing::getHashValue(VectorPair &_vp){
+	return getHashValue(_vp.getDistance1(),_vp.getAngle1(),_vp.getAngle2(),_vp.getTorsion1());
+}
+
+unsigned long long VectorHashing::getHashValue(double _distance, double _angle1, double _angle2, double _torsion) const {
+
+	/*
+	  Same bins as getHashKey.  smartRound returns multiples of 0.01, so each 
+	  bin is stored as a 21 bit integer in hundredths, offset to be positive:
+	    distance bin << 42 | angle bin << 21 | torsion bin
+	*/
+	double angle1 = _angle1;
+	if (angle1 > 180){
+		angle1 = 360 - _angle1;
+	} else if (angle1 < 0){
+		angle1 = 180 + _angle1;
+	}
+	double angle2 = _angle2;
+	if (angle2 > 180){
+		angle2 = 360 - _angle2;
+	} else if (angle2 < 0){
+		angle2 = 180 + _angle2;
+	}
+	double torsion = _torsion;
+	if (torsion > 180){
+		torsion = 360 - _torsion;
+	} else if (torsion < 0){
+		torsion = 180 + _torsion;
+	}
+
+	double bins[3];
+	bins[0] = MslTools::smartRound(_distance,distanceGridSize);
+	bins[1] = MslTools::smartRound(angle1+angle2, angleGridSize);
+	bins[2] = MslTools::smartRound(torsion,dihedralGridSize);
+
+	const long long offset = 1LL << 20;
+	const long long fieldMask = (1LL << 21) - 1;
+	unsigned long long key = 0;
+	for (uint i = 0; i < 3; i++){
+		long long value = (long long)floor(bins[i] * 100.0 + 0.5) + offset;
+		if (value < 0) value = 0;
+		if (value > fieldMask) value = fieldMask;
+		key = (key << 21) | (unsigned long long)value;
+	}
+	return key;
+}
+
 void VectorHashing::setFilterVectorPairs(bool _flag){
 	filterVectorPairs = _flag;
 }
@@ -478,17 +470,242 @@ bool VectorHashing::getFilterVectorPairs(){
 	return filterVectorPairs;
 }
 
+/*
+  Binary checkpoint
+*/
+static void writeUInt(ofstream &_fout, unsigned int _value){
+	_fout.write((const char*)&_value,sizeof(unsigned int));
+}
+static void writeDouble(ofstream &_fout, double _value){
+	_fout.write((const char*)&_value,sizeof(double));
+}
+static void writeString(ofstream &_fout, const string &_value){
+	writeUInt(_fout,_value.size());
+	_fout.write(_value.data(),_value.size());
+}
+static bool readUInt(ifstream &_fin, unsigned int &_value){
+	_fin.read((char*)&_value,sizeof(unsigned int));
+	return _fin.good();
+}
+static bool readDouble(ifstream &_fin, double &_value){
+	_fin.read((char*)&_value,sizeof(double));
+	return _fin.good();
+}
+static bool readString(ifstream &_fin, string &_value){
+	unsigned int size = 0;
+	if (!readUInt(_fin,size)) return false;
+	_value.resize(size);
+	if (size > 0) {
+		_fin.read(&_value[0],size);
+	}
+	return _fin.good();
+}
 
+bool VectorHashing::save_checkpoint(std::string filename) const {
 
+	ofstream fout(filename.c_str(),std::ios::binary);
+	if (!fout.is_open()){
+		cerr << "ERROR VectorHashing::save_checkpoint() cannot open "<<filename<<" for writing"<<endl;
+		return false;
+	}
 
-/* 
-   OLD STUFF 
+	fout.write(VECTORHASH_MAGIC,sizeof(VECTORHASH_MAGIC));
+	writeUInt(fout,VECTORHASH_VERSION);
+
+	writeDouble(fout,distanceGridSize);
+	writeDouble(fout,angleGridSize);
+	writeDouble(fout,dihedralGridSize);
+
+	writeUInt(fout,ids.size());
+	for (uint i = 0; i < ids.size();i++){
+		writeString(fout,ids[i].id);
+	}
+
+	writeUInt(fout,positionIds.size());
+	for (uint c = 0; c < positionIds.size();c++){
+		writeUInt(fout,positionIds[c].size());
+		if (positionIds[c].size() > 0){
+			fout.write((const char*)&positionIds[c][0],positionIds[c].size() * sizeof(unsigned int));
+		}
+	}
+
+	writeUInt(fout,pairs.size());
+	for (uint i = 0; i < pairs.size();i++){
+		writeUInt(fout,pairs[i].idA);
+		writeUInt(fout,pairs[i].idB);
+		writeDouble(fout,pairs[i].distance);
+		writeDouble(fout,pairs[i].angle1);
+		writeDouble(fout,pairs[i].angle2);
+		writeDouble(fout,pairs[i].torsion);
+	}
+
+	if (!fout.good()){
+		cerr << "ERROR VectorHashing::save_checkpoint() failed writing "<<filename<<endl;
+		return false;
+	}
+	return true;
+}
+
+bool VectorHashing::load_checkpoint(std::string filename){
+
+	clear();
+
+	ifstream fin(filename.c_str(),std::ios::binary);
+	if (!fin.is_open()){
+		cerr << "ERROR VectorHashing::load_checkpoint() cannot open "<<filename<<endl;
+		return false;
+	}
 
+	char magic[sizeof(VECTORHASH_MAGIC)];
+	fin.read(magic,sizeof(VECTORHASH_MAGIC));
+	unsigned int version = 0;
+	if (!fin.good() || !equal(magic,magic+sizeof(VECTORHASH_MAGIC),VECTORHASH_MAGIC) || !readUInt(fin,version) || version != VECTORHASH_VERSION){
+		cerr << "ERROR VectorHashing::load_checkpoint() "<<filename<<" is not a vector hash checkpoint (version "<<VECTORHASH_VERSION<<")"<<endl;
+		return false;
+	}
+
+	bool ok = readDouble(fin,distanceGridSize) && readDouble(fin,angleGridSize) && readDouble(fin,dihedralGridSize);
+
+	unsigned int numIds = 0;
+	ok = ok && readUInt(fin,numIds);
+	for (uint i = 0; ok && i < numIds;i++){
+		string id = "";
+		ok = readString(fin,id);
+		if (ok && internId(id) != i){
+			cerr << "ERROR VectorHashing::load_checkpoint() duplicated id "<<id<<endl;
+			ok = false;
+		}
+	}
+
+	unsigned int numChains = 0;
+	ok = ok && readUInt(fin,numChains);
+	for (uint c = 0; ok && c < numChains;c++){
+		unsigned int numPositions = 0;
+		ok = readUInt(fin,numPositions);
+		positionIds.push_back(vector<unsigned int>(numPositions));
+		if (ok && numPositions > 0){
+			fin.read((char*)&positionIds.back()[0],numPositions * sizeof(unsigned int));
+			ok = fin.good();
+		}
+		for (uint p = 0; ok && p < numPositions;p++){
+			ok = positionIds.back()[p] < numIds;
+		}
+	}
+
+	unsigned int numPairs = 0;
+	ok = ok && readUInt(fin,numPairs);
+	if (ok) {
+		pairs.reserve(numPairs);
+		pairLookup.reserve(numPairs);
+	}
+	for (uint i = 0; ok && i < numPairs;i++){
+		unsigned int idA = 0;
+		unsigned int idB = 0;
+		double dist = 0.0;
+		double ang1 = 0.0;
+		double ang2 = 0.0;
+		double tor  = 0.0;
+		ok = readUInt(fin,idA) && readUInt(fin,idB) && readDouble(fin,dist) && readDouble(fin,ang1) && readDouble(fin,ang2) && readDouble(fin,tor) && idA < numIds && idB < numIds;
+		if (ok){
+			addVectorPair(idA,idB,dist,ang1,ang2,tor);
+		}
+	}
+
+	if (!ok){
+		cerr << "ERROR VectorHashing::load_checkpoint() "<<filename<<" is truncated or corrupted"<<endl;
+		clear();
+		return false;
+	}
+
+	MSLOUT.stream() << "Loaded "<<ids.size()<<" ids, "<<pairs.size()<<" vector pairs in "<<geometricBins.size()<<" geometric bins from "<<filename<<endl;
+	return true;
+}
+
+/*
+  KeyTable
 */
+VectorHashing::KeyTable::KeyTable(){
+	numKeys = 0;
+	mask = 0;
+}
 
+void VectorHashing::KeyTable::clear(){
+	keys.clear();
+	values.clear();
+	numKeys = 0;
+	mask = 0;
+}
+
+void VectorHashing::KeyTable::reserve(unsigned int _n){
+	// keep the load factor at or below 1/2
+	unsigned int capacity = 16;
+	while (capacity < 2 * _n) capacity *= 2;
+	if (capacity > keys.size()){
+		rehash(capacity);
+	}
+}
+
+unsigned long long VectorHashing::KeyTable::mix(unsigned long long _key){
+	// 64 bit finalizer (MurmurHash3 fmix64), spreads the packed bin fields over the low bits
+	_key ^= _key >> 33;
+	_key *= 0xff51afd7ed558ccdULL;
+	_key ^= _key >> 33;
+	_key *= 0xc4ceb9fe1a85ec53ULL;
+	_key ^= _key >> 33;
+	return _key;
+}
+
+unsigned int VectorHashing::KeyTable::find(unsigned long long _key) const {
+	if (numKeys == 0) return NOT_FOUND;
+	unsigned long long slot = mix(_key) & mask;
+	while (values[slot] != NOT_FOUND){
+		if (keys[slot] == _key) return values[slot];
+		slot = (slot + 1) & mask;
+	}
+	return NOT_FOUND;
+}
 
+bool VectorHashing::KeyTable::insert(unsigned long long _key, unsigned int &_value){
+	if (2 * (numKeys + 1) > keys.size()){
+		rehash(keys.size() == 0 ? 16 : 2 * keys.size());
+	}
+	unsigned long long slot = mix(_key) & mask;
+	while (values[slot] != NOT_FOUND){
+		if (keys[slot] == _key) {
+			_value = values[slot];
+			return false;
+		}
+		slot = (slot + 1) & mask;
+	}
+	keys[slot] = _key;
+	values[slot] = _value;
+	numKeys++;
+	return true;
+}
 
+void VectorHashing::KeyTable::rehash(unsigned int _capacity){
+	vector<unsigned long long> oldKeys;
+	vector<unsigned int> oldValues;
+	oldKeys.swap(keys);
+	oldValues.swap(values);
+
+	keys.assign(_capacity,0);
+	values.assign(_capacity,NOT_FOUND);
+	mask = _capacity - 1;
+	for (uint i = 0; i < oldKeys.size();i++){
+		if (oldValues[i] == NOT_FOUND) continue;
+		unsigned long long slot = mix(oldKeys[i]) & mask;
+		while (values[slot] != NOT_FOUND){
+			slot = (slot + 1) & mask;
+		}
+		keys[slot] = oldKeys[i];
+		values[slot] = oldValues[i];
+	}
+}
 
 
 
+/* 
+   OLD STUFF 
 
+*/
@@ -30,26 +30,13 @@ You should have received a copy of the GNU Lesser General Public
 #ifndef DISTANCEHASHING_H
 #define DISTANCEHASHING_H
 
-// BOOST Includes
-#ifdef __BOOST__
-#include <boost/archive/text_oarchive.hpp>
-#include <boost/archive/text_iarchive.hpp>
-#include <boost/serialization/base_object.hpp>
-#include <boost/archive/binary_oarchive.hpp>
-#include <boost/archive/binary_iarchive.hpp>
-#include <boost/archive/xml_oarchive.hpp>
-#include <boost/archive/xml_iarchive.hpp>
-#include <boost/serialization/nvp.hpp>
-#include <boost/serialization/map.hpp>
-#include <boost/serialization/vector.hpp>
-#endif
-
 
 // STL Includes
 #include <map>
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <fstream>
 
 
 #include "AtomPointerVector.h"
@@ -81,18 +68,91 @@ class VectorHashing {
 
 		vector<map<string,vector<string> > > searchForVectorMatchAll(VectorHashing &_vh, int _numAcceptableEdges);
 
+		// Human readable "dist:angle:torsion" key, the hash itself uses getHashValue
 		string getHashKey(VectorPair &_vp);
 
+		// The same bins as getHashKey packed into a single integer
+		unsigned long long getHashValue(VectorPair &_vp);
+
+		unsigned int getNumberOfIds() const;
+		unsigned int getNumberOfVectorPairs() const;
+		unsigned int getNumberOfGeometricBins() const;
+		void clear();
+
+		/*
+		  Compact binary checkpoint: grid sizes, interned ids, per-chain position ids
+		  and the geometry of each vector pair.  The geometric hash is rebuilt on load.
+		  The byte order is the one of the machine that writes the file.
+		*/
+		bool save_checkpoint(std::string filename) const;
+		bool load_checkpoint(std::string filename);
+
 	private:
 
 		bool addToVectorHash(Chain &_ch,string _id,bool _printIt=false);
-		bool getPositionId(VectorPair &_vp, string &_posId1, string &_posId2);
+		bool getPositionId(const string &_id, string &_posId);
+
+		unsigned int internId(const string &_id);
+		unsigned long long getHashValue(double _distance, double _angle1, double _angle2, double _torsion) const;
+		void addVectorPair(unsigned int _idA, unsigned int _idB, double _distance, double _angle1, double _angle2, double _torsion);
+
+		/*
+		  Flat open-addressing (linear probing) table from a 64 bit key 
+		  to an unsigned int, used for both the pair and the geometric hashes
+		*/
+		class KeyTable {
+			public:
+				KeyTable();
+				void clear();
+				void reserve(unsigned int _n);
+				// returns NOT_FOUND if the key is not in the table
+				unsigned int find(unsigned long long _key) const;
+				// inserts if missing; returns false and sets _value to the stored value if present
+				bool insert(unsigned long long _key, unsigned int &_value);
+				unsigned int size() const { return numKeys; }
+
+				static const unsigned int NOT_FOUND = 0xffffffffu;
+			private:
+				void rehash(unsigned int _capacity);
+				static unsigned long long mix(unsigned long long _key);
+
+				vector<unsigned long long> keys;
+				vector<unsigned int> values;
+				unsigned int numKeys;
+				unsigned long long mask;
+		};
 
-		// Store a list of position ids for each chain that has been added
-		vector<vector<string> > positionIds;
+		// Everything that is needed from a rotamer/position id, parsed once
+		struct InternedId {
+			string id;          // "pdb:,A 37 LEU 0"
+			string pdb;
+			string chainId;
+			int resnum;
+			string icode;
+			string positionId;  // "A,37"
+			bool parsed;
+		};
 
-		map<string,VectorPair> pairPositionHash;
-		map<string,vector<VectorPair*> > geometricHash;
+		struct PairEntry {
+			unsigned int idA;
+			unsigned int idB;
+			double distance;
+			double angle1;
+			double angle2;
+			double torsion;
+		};
+
+		vector<InternedId> ids;
+		map<string,unsigned int> idLookup;
+
+		// Store a list of (interned) position ids for each chain that has been added
+		vector<vector<unsigned int> > positionIds;
+
+		vector<PairEntry> pairs;
+		KeyTable pairLookup;             // (idA << 32 | idB) -> index in pairs
+
+		KeyTable geometricLookup;        // getHashValue -> index in geometricBins
+		vector<vector<unsigned int> > geometricBins; // indices in pairs
 
 
 		struct CandidateCycle {
@@ -116,75 +176,12 @@ class VectorHashing {
 		
 		bool filterVectorPairs;
 
-		std::string archiveType;
-		            
-
-
-		// BOOST-RELATED FUNCTIONS , keep them away from main class def.
-#ifdef __BOOST__
-	public:
-
-		void save_checkpoint(std::string filename) const{
-
-			if (archiveType == "binary"){
-				std::ofstream fout(filename.c_str(),std::ios::binary);
-				boost::archive::binary_oarchive oa(fout);
-				oa << (*this);
-			} else if (archiveType == "xml"){
-				std::ofstream fout(filename.c_str());
-				boost::archive::xml_oarchive oa(fout);
-				oa << boost::serialization::make_nvp("Matrix",*this);
-			} else {
-				std::ofstream fout(filename.c_str());
-				boost::archive::text_oarchive oa(fout);
-				oa << (*this);
-			}
-
-		}
-
-		void load_checkpoint(std::string filename){
-
-			if (archiveType == "binary"){
-				std::ifstream fin(filename.c_str(), std::ios::binary);
-				boost::archive::binary_iarchive ia(fin);
-				ia >> (*this);
-			} else if (archiveType == "xml"){
-				std::ifstream fin(filename.c_str());
-				boost::archive::xml_iarchive ia(fin);
-				ia >> boost::serialization::make_nvp("Matrix",*this);
-			} else {
-				std::ifstream fin(filename.c_str());
-				boost::archive::text_iarchive ia(fin);
-				ia >> (*this);
-			}
-		}
-
-
-	private:
-		friend class boost::serialization::access;		
-
-
-		template<class Archive> void serialize(Archive & ar, const unsigned int version){
-			using boost::serialization::make_nvp;
-
-			//ar & make_nvp("distanceData",distanceData);
-			//			ar & make_nvp("atoms",atoms);
+};
 
-			ar & make_nvp("positionIds",positionIds);
-			ar & make_nvp("pairPositionHash",pairPositionHash);
-			//ar & make_nvp("geometricHash",geometricHash);
-		}
-#else
-	public:
-		void save_checkpoint(std::string filename) const{
-			std::cout << "NO IMPLEMENTATION OF SAVE_CHECKPOINT WITHOUT BOOST LIBRARIES INSTALLED.\n";
-		}
-		void load_checkpoint(std::string filename) const{
-			std::cout << "NO IMPLEMENTATION OF LOAD_CHECKPOINT WITHOUT BOOST LIBRARIES INSTALLED.\n";
-		}		
-#endif
+inline unsigned int VectorHashing::getNumberOfIds() const { return ids.size(); }
+inline unsigned int VectorHashing::getNumberOfVectorPairs() const { return pairs.size(); }
+inline unsigned int VectorHashing::getNumberOfGeometricBins() const { return geometricBins.size(); }
 
-};
 }
 
 #endif
@@ -27,15 +27,107 @@ You should have received a copy of the GNU Lesser General Public
 ----------------------------------------------------------------------------
 */
 
+#include <set>
 #include "AtomPointerVector.h"
 #include "AtomBondBuilder.h"
 #include "PDBReader.h"
 #include "System.h"
+#include "testData.h"
 
 using namespace std;
 
 using namespace MSL;
 
+/*******************************************************************
+ *  Reference for the bond, 1-3 and 1-4 relationships: they are
+ *  derived by walking a plain bond graph, kept by the test, and
+ *  compared (content and order) with what the atoms report
+ *******************************************************************/
+typedef map<Atom*, set<Atom*> > BondGraph;
+
+void addBonds(AtomPointerVector & _av, BondGraph & _graph) {
+	for (unsigned int i=0; i<_av.size(); i++) {
+		vector<Atom*> bonds = _av[i]->getBonds();
+		_graph[_av[i]].insert(bonds.begin(), bonds.end());
+	}
+}
+
+void removeBond(BondGraph & _graph, Atom * _pA1, Atom * _pA2) {
+	_graph[_pA1].erase(_pA2);
+	_graph[_pA2].erase(_pA1);
+}
+
+bool sameAdjacency(AtomPointerVector & _av, BondGraph & _graph, string _label) {
+	bool same = true;
+	for (unsigned int i=0; i<_av.size(); i++) {
+		Atom * a = _av[i];
+		set<Atom*> & bonds = _graph[a];
+		// the 1-3 middle atoms and the 1-4 middle atom pairs for each end atom
+		map<Atom*, set<Atom*> > oneThree;
+		map<Atom*, set<pair<Atom*, Atom*> > > oneFour;
+		// getBoundAtoms: for each bond, the 1-3 atoms through it and the 1-4 atoms through them
+		vector<vector<Atom*> > boundAtoms;
+		for (set<Atom*>::iterator b=bonds.begin(); b!=bonds.end(); b++) {
+			boundAtoms.push_back(vector<Atom*>(1, *b));
+			set<Atom*> & bBonds = _graph[*b];
+			for (set<Atom*>::iterator c=bBonds.begin(); c!=bBonds.end(); c++) {
+				if (*c == a) {
+					continue;
+				}
+				oneThree[*c].insert(*b);
+				boundAtoms.back().push_back(*c);
+				set<Atom*> & cBonds = _graph[*c];
+				for (set<Atom*>::iterator d=cBonds.begin(); d!=cBonds.end(); d++) {
+					if (*d == a || *d == *b) {
+						continue;
+					}
+					oneFour[*d].insert(pair<Atom*, Atom*>(*b, *c));
+					boundAtoms.back().push_back(*d);
+				}
+			}
+		}
+		if (a->getBonds() != vector<Atom*>(bonds.begin(), bonds.end())) {
+			cout << "NOT OK: " << _label << ": different bonds for " << a->getAtomId() << endl;
+			same = false;
+		}
+		if (a->getBoundAtoms() != boundAtoms) {
+			cout << "NOT OK: " << _label << ": different bound atoms for " << a->getAtomId() << endl;
+			same = false;
+		}
+		for (unsigned int j=0; j<_av.size(); j++) {
+			Atom * x = _av[j];
+			if (a->isBoundTo(x) != (bonds.find(x) != bonds.end())) {
+				cout << "NOT OK: " << _label << ": different 1-2 for " << a->getAtomId() << " " << x->getAtomId() << endl;
+				same = false;
+			}
+			map<Atom*, set<Atom*> >::iterator found13 = oneThree.find(x);
+			if (a->isOneThree(x) != (found13 != oneThree.end())) {
+				cout << "NOT OK: " << _label << ": different 1-3 for " << a->getAtomId() << " " << x->getAtomId() << endl;
+				same = false;
+			} else if (found13 != oneThree.end() && a->getOneThreeMiddleAtoms(x) != vector<Atom*>(found13->second.begin(), found13->second.end())) {
+				cout << "NOT OK: " << _label << ": different 1-3 middle atoms for " << a->getAtomId() << " " << x->getAtomId() << endl;
+				same = false;
+			}
+			map<Atom*, set<pair<Atom*, Atom*> > >::iterator found14 = oneFour.find(x);
+			if (a->isOneFour(x) != (found14 != oneFour.end())) {
+				cout << "NOT OK: " << _label << ": different 1-4 for " << a->getAtomId() << " " << x->getAtomId() << endl;
+				same = false;
+			} else if (found14 != oneFour.end()) {
+				vector<vector<Atom*> > middle;
+				for (set<pair<Atom*, Atom*> >::iterator k=found14->second.begin(); k!=found14->second.end(); k++) {
+					middle.push_back(vector<Atom*>(1, k->first));
+					middle.back().push_back(k->second);
+				}
+				if (a->getOneFourMiddleAtoms(x) != middle) {
+					cout << "NOT OK: " << _label << ": different 1-4 middle atoms for " << a->getAtomId() << " " << x->getAtomId() << endl;
+					same = false;
+				}
+			}
+		}
+	}
+	return same;
+}
+
 
 int main(int argc,char *argv[]) {
 
@@ -59,6 +151,38 @@ int main(int argc,char *argv[]) {
 
 	AtomBondBuilder abb;
 	abb.buildConnections(av);
+	BondGraph graph;
+	addBonds(av, graph);
+	bool pass = sameAdjacency(av, graph, "example0001");
+
+	// a larger structure, with bonds removed from atoms with many 1-3 and 1-4 relationships
+	writeString(fourHelixBundle, "/tmp/testAtomBondBuilder.pdb");
+	System bundle;
+	if (!bundle.readPdb("/tmp/testAtomBondBuilder.pdb")) {
+		cerr << "Cannot read pdb file /tmp/testAtomBondBuilder.pdb" << endl;
+		exit(1);
+	}
+	AtomPointerVector bundleAtoms = bundle.getAtomPointers();
+	abb.buildConnections(bundleAtoms);
+	BondGraph bundleGraph;
+	addBonds(bundleAtoms, bundleGraph);
+	pass = sameAdjacency(bundleAtoms, bundleGraph, "four helix bundle") && pass;
+	for (unsigned int i=1; i<bundleAtoms.size(); i+=97) {
+		vector<Atom*> bonds = bundleAtoms[i]->getBonds();
+		if (bonds.size() > 0) {
+			bundleAtoms[i]->setUnboundFrom(bonds.back());
+			removeBond(bundleGraph, bundleAtoms[i], bonds.back());
+		}
+	}
+	pass = sameAdjacency(bundleAtoms, bundleGraph, "four helix bundle, bonds removed") && pass;
+	for (unsigned int i=0; i<bundleAtoms.size(); i+=131) {
+		vector<Atom*> bonds = bundleAtoms[i]->getBonds();
+		bundleAtoms[i]->setUnboundFromAll();
+		for (unsigned int j=0; j<bonds.size(); j++) {
+			removeBond(bundleGraph, bundleAtoms[i], bonds[j]);
+		}
+	}
+	pass = sameAdjacency(bundleAtoms, bundleGraph, "four helix bundle, atoms unbound") && pass;
 	cout << "==========================" << endl;
 	for (unsigned int i=0; i<av.size(); i++) {
 		char c [1000];
@@ -91,7 +215,9 @@ int main(int argc,char *argv[]) {
 	}
 	cout << "==========================" << endl;
 
-	av[6]->setUnboundFrom(av[5]);	// 1N 2CA
+	av[6]->setUnboundFrom(av[5]);
+	removeBond(graph, av[6], av[5]);
+	pass = sameAdjacency(av, graph, "removed bond 6-5") && pass;	// 1N 2CA
 
 	cout << "==========================" << endl;
 	cout << "Let's now manually remove some bonds" << endl;
@@ -116,7 +242,9 @@ int main(int argc,char *argv[]) {
 		cout << endl;
 	}
 
-	av[7]->setUnboundFrom(av[6]);	// 2CA 2CB
+	av[7]->setUnboundFrom(av[6]);
+	removeBond(graph, av[7], av[6]);
+	pass = sameAdjacency(av, graph, "removed bond 7-6") && pass;	// 2CA 2CB
 
 	cout << "==========================" << endl;
 	cout << "Removed bond between atoms 2CA-2CB" << endl;
@@ -140,7 +268,9 @@ int main(int argc,char *argv[]) {
 		cout << endl;
 	}
 
-	av[11]->setUnboundFrom(av[6]);	// 2C 2CA
+	av[11]->setUnboundFrom(av[6]);
+	removeBond(graph, av[11], av[6]);
+	pass = sameAdjacency(av, graph, "removed bond 11-6") && pass;	// 2C 2CA
 
 	cout << "==========================" << endl;
 	cout << "Removed bond between atoms 2CA-2C" << endl;
@@ -164,7 +294,9 @@ int main(int argc,char *argv[]) {
 		cout << endl;
 	}
 
-	av[11]->setUnboundFrom(av[13]);	// 2C 3N
+	av[11]->setUnboundFrom(av[13]);
+	removeBond(graph, av[11], av[13]);
+	pass = sameAdjacency(av, graph, "removed bond 11-13") && pass;	// 2C 3N
 
 	cout << "==========================" << endl;
 	cout << "Removed bond between atoms 2C-3N" << endl;
@@ -188,6 +320,11 @@ int main(int argc,char *argv[]) {
 		cout << endl;
 	}
 
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
 
 }
 
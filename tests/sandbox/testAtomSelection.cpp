@@ -33,6 +33,8 @@ You should have received a copy of the GNU Lesser General Public
 #include "AtomSelection.h"
 #include "PDBWriter.h"
 #include "MslOut.h"
+#include "PDBReader.h"
+#include "testData.h"
 
 using namespace MSL;
 using namespace std;
@@ -40,6 +42,118 @@ using namespace std;
 // MslOut 
 static MslOut MSLOUT("testAtomSelection");
 
+/*******************************************************************
+ *  Runs the same statements on two copies of a four helix bundle,
+ *  with the compiled and cached selections and with the interpreted
+ *  LogicalCondition loop (used in debug mode, as before the cache),
+ *  and checks that the same atoms are selected and flagged.  WITHIN
+ *  selections are also compared with an all-against-all distance loop
+ *******************************************************************/
+bool compiledMatchesInterpreted() {
+	bool pass = true;
+
+	PDBReader rin1;
+	rin1.read(fourHelixBundle);
+	AtomPointerVector compiledAtoms = rin1.getAtomPointers();
+	PDBReader rin2;
+	rin2.read(fourHelixBundle);
+	AtomPointerVector interpretedAtoms = rin2.getAtomPointers();
+
+	// some atoms without coordinates
+	for (unsigned int i=0; i < compiledAtoms.size(); i++) {
+		if (i % 11 == 3) {
+			compiledAtoms[i]->wipeCoordinates();
+			interpretedAtoms[i]->wipeCoordinates();
+		}
+	}
+
+	AtomSelection compiled(compiledAtoms);
+	AtomSelection interpreted(interpretedAtoms);
+	interpreted.setDebugFlag(true);
+
+	vector<string> statements;
+	statements.push_back("ca, name CA");
+	statements.push_back("bb, name N+CA+C+O");
+	statements.push_back("res, resi 3-10 AND chain A");
+	statements.push_back("hyd, resn LEU OR resn ILE OR resn VAL");
+	statements.push_back("notbb, NOT name CA+C+O+N");
+	statements.push_back("cplx, (resn LYS AND name NZ) OR (chain B AND resi 5-8)");
+	statements.push_back("xor, HASCRD AND resn GLY XOR resi 3-8 XOR NOT NAME CB OR chain B OR NAME C");
+	statements.push_back("nocrd, HASCRD 0 and name CA+C+O+N+CB");
+	statements.push_back("stored, bb AND chain B AND NOT ca");
+	statements.push_back("near, name CA WITHIN 6 OF resi 10 AND chain A");
+	statements.push_back("near2, (resn LEU OR name CB) WITHIN 4.5 OF (name NZ OR name OE1)");
+	// the same statements again (cached), then after redefining a stored selection
+	statements.push_back("ca, name CA");
+	statements.push_back("stored, bb AND chain B AND NOT ca");
+	statements.push_back("bb, name CA+C");
+	statements.push_back("stored, bb AND chain B AND NOT ca");
+
+	for (unsigned int s=0; s < statements.size(); s++) {
+		for (unsigned int all=0; all < 2; all++) {
+			AtomPointerVector compiledSel = compiled.select(statements[s], all == 1);
+
+			// the interpreted path prints the logic of each atom in debug mode
+			streambuf * coutBuffer = cout.rdbuf();
+			stringstream debugOutput;
+			cout.rdbuf(debugOutput.rdbuf());
+			AtomPointerVector interpretedSel = interpreted.select(statements[s], all == 1);
+			cout.rdbuf(coutBuffer);
+
+			string name = MslTools::tokenizeAndTrim(statements[s], ",")[0];
+			bool same = compiledSel.size() == interpretedSel.size();
+			for (unsigned int i=0; i < compiledAtoms.size(); i++) {
+				if (compiledAtoms[i]->getSelectionFlag(name) != interpretedAtoms[i]->getSelectionFlag(name)) {
+					same = false;
+				}
+			}
+			for (unsigned int i=0; i < compiledSel.size() && same; i++) {
+				if (compiledSel[i]->getAtomId() != interpretedSel[i]->getAtomId()) {
+					same = false;
+				}
+			}
+			cout << "\"" << statements[s] << "\" (all atoms " << all << "): " << compiledSel.size() << " compiled, " << interpretedSel.size() << " interpreted" << endl;
+			if (!same) {
+				cout << "NOT OK: the compiled selection differs from the interpreted one" << endl;
+				pass = false;
+			}
+		}
+	}
+
+	// WITHIN against all the pairs
+	AtomPointerVector sele2 = compiled.select("sele2, resi 10 AND chain A", true);
+	AtomPointerVector near = compiled.select("near, name CA WITHIN 6 OF resi 10 AND chain A", true);
+	AtomPointerVector expected;
+	for (unsigned int i=0; i < compiledAtoms.size(); i++) {
+		Atom * pAtom = compiledAtoms[i];
+		if (!pAtom->hasCoor() || pAtom->getName() != "CA") {
+			continue;
+		}
+		bool within = false;
+		for (unsigned int j=0; j < sele2.size(); j++) {
+			if (pAtom == sele2[j] || (sele2[j]->hasCoor() && pAtom->distance(*sele2[j]) < 6.0)) {
+				within = true;
+			}
+		}
+		if (within) {
+			expected.push_back(pAtom);
+		}
+	}
+	if (near.size() == 0 || near.size() != expected.size()) {
+		cout << "NOT OK: WITHIN selected " << near.size() << " atoms, " << expected.size() << " expected" << endl;
+		pass = false;
+	} else {
+		for (unsigned int i=0; i < near.size(); i++) {
+			if (near[i] != expected[i]) {
+				cout << "NOT OK: WITHIN selected " << near[i]->getAtomId() << " instead of " << expected[i]->getAtomId() << endl;
+				pass = false;
+			}
+		}
+	}
+
+	return pass;
+}
+
 
 int main(int argc, char *argv[]) {
   
@@ -47,6 +161,15 @@ int main(int argc, char *argv[]) {
 	  MSLOUT.turnAllOn();
 	}
 
+	// the compiled selections must select what the interpreted loop selects
+	if (compiledMatchesInterpreted()) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
+	cout << endl;
+	cout << "=====================================" << endl;
+
 	
 	Atom a("A,1,ILE,CA", 0.3, 9.7, 5.3);
 	Atom b("A,2,LEU,CB", 0.4, 9.7, 4.3);
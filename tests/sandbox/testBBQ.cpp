@@ -336,7 +336,120 @@ ATOM    284  O   GLY E  50      12.132  14.477   5.498  1.00 24.77           O
 TER     285                                                                     \n\
 END                                                                             \n";
 
+/*
+ * Backbone of the trace above with the CA of residue 25 moved by 1 A
+ * along x (quadrilaterals 11-13 are illegal), filled in with the
+ * PiscesBBQTable by the code before the compiled lookup.
+ */
+struct BackboneAtom {
+    int residueNumber;
+    const char *name;
+    double x, y, z;
+};
+BackboneAtom illegalQuadBackbone[] = {
+    {13, "C", -7.072937234, -14.375659067, -15.821371313},
+    {13, "O", -7.023836225, -13.382553311, -16.531904100},
+    {14, "N", -7.723809668, -14.339369282, -14.796220177},
+    {14, "C", -7.221474228, -12.098395459, -14.002036181},
+    {14, "O", -7.416777738, -10.916154287, -14.213931407},
+    {15, "N", -6.036702818, -12.571435640, -13.570744469},
+    {15, "C", -4.353588972, -11.111902804, -14.610747164},
+    {15, "O", -4.050056836, -9.921826170, -14.684970399},
+    {16, "N", -4.241721585, -11.950226607, -15.618874090},
+    {16, "C", -4.679080550, -10.412483299, -17.463281650},
+    {16, "O", -4.238808370, -9.381927724, -17.970094353},
+    {17, "N", -5.962073223, -10.676792886, -17.325569569},
+    {17, "C", -6.889571244, -8.424868182, -16.964569744},
+    {17, "O", -7.017409562, -7.328387508, -17.503676583},
+    {18, "N", -6.713351633, -8.596836377, -15.724029272},
+    {18, "C", -5.392972716, -6.572186792, -15.175201424},
+    {18, "O", -5.469302059, -5.345924131, -15.154903640},
+    {19, "N", -4.370761872, -7.170767351, -15.359696444},
+    {19, "C", -3.347384416, -5.787989930, -17.128378560},
+    {19, "O", -2.661922588, -4.832599909, -17.446483770},
+    {20, "N", -4.112448629, -6.265115201, -17.991613977},
+    {20, "C", -5.081995189, -4.401049100, -19.230819942},
+    {20, "O", -4.665756398, -3.412898724, -19.829652305},
+    {21, "N", -6.159018475, -4.379423406, -18.558670711},
+    {21, "C", -6.077182802, -2.112160397, -17.607710870},
+    {21, "O", -6.091603481, -0.926914591, -17.930562397},
+    {22, "N", -5.338153671, -2.626592362, -16.639177129},
+    {22, "C", -3.424303137, -1.066272466, -16.724089021},
+    {22, "O", -3.124309810, 0.112503164, -16.551634086},
+    {23, "N", -2.807406327, -1.790337908, -17.609943924},
+    {23, "C", -2.345590496, -0.195488945, -19.468754264},
+    {23, "O", -1.626592780, 0.712796589, -19.860038494},
+    {24, "N", -3.656055503, -0.342389899, -19.755721933},
+    {27, "C", -1.344528227, 5.597592180, -21.004292883},
+    {27, "O", -0.763706905, 6.467960344, -21.639412044},
+    {28, "N", -2.537886992, 5.738546988, -20.741273228},
+    {28, "C", -2.656441197, 8.094123880, -20.160803375},
+    {28, "O", -2.586884148, 9.225040655, -20.599856258},
+    {29, "N", -2.288449127, 7.856804095, -18.970879821},
+    {29, "C", -0.165556520, 8.958600537, -18.432902360},
+    {29, "O", 0.382118328, 10.050461931, -18.360798119},
+    {30, "N", 0.516322797, 7.868906121, -18.796338916},
+    {30, "C", 2.176759002, 8.845281060, -20.320223713},
+    {30, "O", 3.127114105, 9.619947390, -20.335597319},
+    {31, "N", 1.360222660, 8.730414312, -21.287089541},
+    {31, "C", 0.972350395, 10.980137013, -22.320802725},
+    {31, "O", 1.295844391, 11.799842053, -23.087639215},
+    {32, "N", 0.163582797, 11.284285181, -21.402443597},
+    {32, "C", -0.236293757, 12.604674892, -19.655553100},
+    {32, "O", -0.630495969, 11.677023543, -18.989465460},
+    {33, "N", 0.423009052, 13.624925247, -19.059478916},
+    {33, "C", 0.073282421, 15.011999355, -17.041828953},
+    {33, "O", -0.127787793, 15.975387773, -17.728935187},
+    {34, "N", -0.146266942, 14.956602455, -15.760639986},
+    {34, "C", 0.395893105, 17.134192335, -14.638974453},
+    {34, "O", 1.469675640, 16.762031787, -14.220000131},
+    {35, "N", 0.103265555, 18.407147588, -14.771427153},
+    {35, "C", 0.678703535, 20.274545030, -13.230642385},
+    {35, "O", 0.325298062, 19.995929777, -12.716044431},
+    {36, "N", 0.912194485, 21.359672919, -12.831309179},
+    {36, "C", -0.691159643, 22.255641189, -11.166157443},
+    {36, "O", -1.416788315, 23.055770924, -11.459703716},
+    {37, "N", -1.060748470, 21.300211544, -10.389710025},
+    {37, "C", -2.651486155, 21.919597671, -8.534375833},
+    {37, "O", -3.768402878, 22.085190033, -8.166188388},
+    {38, "N", -1.624388875, 22.342985919, -7.904162104},
+    {38, "C", -0.616134751, 23.997619954, -6.411153857},
+    {38, "O", 0.431686364, 23.841149528, -6.981421411},
+    {39, "N", -0.898365759, 24.941695813, -5.415247410},
+    {39, "C", 0.570767460, 25.577655356, -3.569392466},
+    {39, "O", -0.181969575, 25.024695385, -2.790874050},
+    {40, "N", 1.764471193, 26.301793747, -3.376384472},
+    {40, "C", 1.377250024, 26.717648033, -0.960412389},
+    {40, "O", 1.319548006, 26.227233631, 0.148574943},
+    {41, "N", 0.782591561, 27.769526833, -1.195654028},
+    {41, "C", -1.408012410, 27.723222694, 0.061993753},
+    {41, "O", -1.997747183, 27.980219647, 1.100616726},
+    {42, "N", -1.811482735, 26.876599369, -0.795113245},
+    {42, "C", -2.792223532, 25.105013502, 0.576270152},
+    {42, "O", -3.531898333, 24.334262738, 0.740878499},
+    {43, "N", -1.706394722, 25.149289509, 1.326629933},
+    {43, "C", -0.622566451, 24.848258540, 3.516517118},
+    {43, "O", -0.022119425, 25.887517052, 3.369059780},
+    {44, "N", -0.667621363, 24.180320163, 4.695445169},
+    {44, "C", 1.155471563, 23.535084627, 6.124181123},
+    {44, "O", 0.904708601, 22.369888514, 6.028189472},
+    {45, "N", 2.302694936, 24.005831929, 6.516625394},
+    {45, "C", 3.351099237, 22.559311062, 8.260995010},
+    {45, "O", 3.819782752, 22.993127656, 8.956239637},
+    {46, "N", 2.948251526, 21.598847134, 8.614182689},
+    {46, "C", 3.983037176, 20.332876279, 10.577366938},
+    {46, "O", 4.118012736, 20.461241533, 11.682359570},
+    {47, "N", 4.845733001, 19.609111719, 9.949543263},
+    {47, "C", 6.806517110, 18.307946378, 9.444544513},
+    {47, "O", 6.325533581, 18.063023357, 8.379685412},
+    {48, "N", 8.045014008, 18.092013781, 9.617506523},
+    {48, "C", 8.967596735, 15.935554496, 9.042687175},
+    {48, "O", 9.242489878, 15.596669364, 10.151489533},
+    {49, "N", 8.502823670, 14.982589993, 8.203360928}
+};
+
 void getAtomsOfInterest(map<string, bool> &atomsOfInterest);
+bool testIllegalQuad(System &sys, string fileName);
 void getChainWithJustCA(vector<Residue *> &_resVec, vector<Position *> &_posVec);
 void testWriter(System &sys, string fileName);
 void testReader(System &sys, string fileName);
@@ -374,8 +487,108 @@ int main() {
     cout << "CHAIN E SIZE2: "<<justCAsys("E").getAtomPointers().size()<<endl;
 
     justCAsys.writePdb("/tmp/ChainBBQ.test.post.pdb");
+
+    if (testIllegalQuad(sys, "bbqTableTest.txt")) {
+        cout << "LEAD OK" << endl;
+    } else {
+        cout << "LEAD NOT OK" << endl;
+    }
 };
 
+/*
+ * Compares the backbone atoms of a trace (residue number, name) with the
+ * reference coordinates.
+ */
+bool sameBackbone(const map<pair<int, string>, CartesianPoint> &_atoms, string _label) {
+    unsigned int size = sizeof(illegalQuadBackbone) / sizeof(BackboneAtom);
+    bool pass = true;
+    if (_atoms.size() != size) {
+        cout << "NOT OK: " << _label << " built " << _atoms.size() << " backbone atoms instead of " << size << endl;
+        pass = false;
+    }
+    for (unsigned int i = 0; i < size; ++i) {
+        const BackboneAtom &ref = illegalQuadBackbone[i];
+        map<pair<int, string>, CartesianPoint>::const_iterator found = _atoms.find(pair<int, string>(ref.residueNumber, ref.name));
+        if (found == _atoms.end()) {
+            cout << "NOT OK: " << _label << " did not build atom " << ref.name << " of residue " << ref.residueNumber << endl;
+            pass = false;
+        } else if (found->second.distance(CartesianPoint(ref.x, ref.y, ref.z)) > 1.0e-6) {
+            cout << "NOT OK: " << _label << " atom " << ref.name << " of residue " << ref.residueNumber << " at " << found->second << " instead of " << CartesianPoint(ref.x, ref.y, ref.z) << endl;
+            pass = false;
+        }
+    }
+    return pass;
+}
+
+/*
+ * Fills in a C-alpha trace with illegal quadrilaterals with both
+ * fillInMissingBBAtoms overloads and compares the result with the
+ * coordinates built before the compiled lookup.  A table read again
+ * with openReader must not keep the lookup compiled for the old one.
+ */
+bool testIllegalQuad(System &sys, string fileName) {
+    bool pass = true;
+    BBQTable bbqTable(SYSENV.getEnv("MSL_BBQ_TABLE"));
+
+    // Chain overload
+    System caSys;
+    AtomSelection sel(sys.getAtomPointers());
+    caSys.addAtoms(sel.select("name CA"));
+    caSys.getChain("E").getResidue(13).getAtom("CA").getCoor() += CartesianPoint(1.0, 0.0, 0.0);
+    if (bbqTable.fillInMissingBBAtoms(caSys.getChain("E")) != 3) {
+        cout << "NOT OK: expected 3 illegal quadrilaterals" << endl;
+        pass = false;
+    }
+    map<pair<int, string>, CartesianPoint> chainAtoms;
+    AtomPointerVector &built = caSys.getAtomPointers();
+    for (unsigned int i = 0; i < built.size(); ++i) {
+        if (built[i]->getName() != "CA")
+            chainAtoms[pair<int, string>(built[i]->getResidueNumber(), built[i]->getName())] = built[i]->getCoor();
+    }
+    pass = sameBackbone(chainAtoms, "Chain overload") && pass;
+
+    // vector of Residues overload
+    vector<Position *> posVec = caSys.getChain("E").getPositions();
+    vector<Residue *> resVec;
+    getChainWithJustCA(resVec, posVec);
+    bbqTable.fillInMissingBBAtoms(resVec);
+    map<pair<int, string>, CartesianPoint> vectorAtoms;
+    string names[3] = {"N", "C", "O"};
+    for (unsigned int i = 0; i < resVec.size(); ++i) {
+        for (unsigned int j = 0; j < 3; ++j) {
+            if (resVec[i]->atomExists(names[j]))
+                vectorAtoms[pair<int, string>(posVec[i]->getResidueNumber(), names[j])] = resVec[i]->getAtom(names[j]).getCoor();
+        }
+        delete resVec[i];
+    }
+    pass = sameBackbone(vectorAtoms, "Residue vector overload") && pass;
+
+    // read another table in the same object
+    bbqTable.openReader(fileName);
+    BBQTable freshTable(fileName);
+    System reread;
+    System fresh;
+    reread.addAtoms(sel.select("name CA"));
+    fresh.addAtoms(sel.select("name CA"));
+    bbqTable.fillInMissingBBAtoms(reread.getChain("E"));
+    freshTable.fillInMissingBBAtoms(fresh.getChain("E"));
+    AtomPointerVector &rereadAtoms = reread.getAtomPointers();
+    AtomPointerVector &freshAtoms = fresh.getAtomPointers();
+    if (rereadAtoms.size() != freshAtoms.size()) {
+        cout << "NOT OK: the re-read table built " << rereadAtoms.size() << " atoms instead of " << freshAtoms.size() << endl;
+        pass = false;
+    } else {
+        for (unsigned int i = 0; i < rereadAtoms.size(); ++i) {
+            if (rereadAtoms[i]->getCoor().distance(freshAtoms[i]->getCoor()) > 1.0e-9) {
+                cout << "NOT OK: the re-read table placed atom " << rereadAtoms[i]->getAtomId() << " with the lookup of the previous table" << endl;
+                pass = false;
+                break;
+            }
+        }
+    }
+    return pass;
+}
+
 void testWriter(System &sys, string fileName) {
     vector<Chain *> allChains;
     BBQTable bbqTable;
@@ -30,12 +30,214 @@ You should have received a copy of the GNU Lesser General Public
 #include "BackRub.h"
 #include "testData.h"
 #include "System.h"
+#include "SysEnv.h"
+#include "PolymerSequence.h"
+#include "CharmmSystemBuilder.h"
+#include "Transforms.h"
 
 using namespace MSL;
 using namespace std;
 
+static SysEnv SYSENV;
+
+/*******************************************************************
+ *  The moves of sampleEnsemble must be identical (bit for bit) to
+ *  replaying the same window and omega with the Transforms calls of
+ *  localSample, must not depend on the number of threads, and the
+ *  energy changes must match full energy calculations
+ *******************************************************************/
+
+// doMinorRotation of localSample
+void minorRotation(Residue &_r1, Residue &_r2, CartesianPoint &_targetAtom1, CartesianPoint &_targetAtom2) {
+	CartesianPoint minorRotVector = _r2("CA").getCoor();
+	double preDihedral = _targetAtom1.dihedral(_r1("CA").getCoor(),_r2("CA").getCoor(),_targetAtom2);
+	double postDihedral = _r1("O").getCoor().dihedral(_r1("CA").getCoor(),_r2("CA").getCoor(),_targetAtom2);
+	double alpha = postDihedral - preDihedral;
+	Transforms t;
+	t.rotate(_r1("O"),alpha, minorRotVector, _r1("CA").getCoor());
+	t.rotate(_r1("C"),alpha, minorRotVector, _r1("CA").getCoor());
+	t.rotate(_r2("N"),alpha, minorRotVector, _r1("CA").getCoor());
+	if (_r2.atomExists("H")){
+		t.rotate(_r2("H"),alpha, minorRotVector, _r1("CA").getCoor());
+	}
+}
+
+// one move of localSample, with a given window and omega
+void replayMove(Chain &_ch, int _startRes, double _omega) {
+	int endRes = _startRes + 2;
+	Residue &res1 = _ch.getResidue(_startRes);
+	Residue &res2 = _ch.getResidue(_startRes+1);
+	Residue &res3 = _ch.getResidue(endRes);
+	CartesianPoint preO1 = res1("O").getCoor();
+	CartesianPoint preO2 = res2("O").getCoor();
+	CartesianPoint preAt2 = res2("N").getCoor();
+	if (endRes+1 < _ch.positionSize() && _ch.getResidue(endRes+1).atomExists("O")){
+		preAt2 = _ch.getResidue(endRes+1)("O").getCoor();
+	}
+	CartesianPoint mainRotVector = res3("CA").getCoor();
+	Transforms t;
+	t.rotate(res1("C"),_omega,mainRotVector, res1("CA").getCoor());
+	t.rotate(res1("O"),_omega,mainRotVector, res1("CA").getCoor());
+	t.rotate(res2.getAtomPointers(), _omega, mainRotVector, res1("CA").getCoor());
+	t.rotate(res3("N"),_omega,mainRotVector, res1("CA").getCoor());
+	if (res3.atomExists("H")){
+		t.rotate(res3("H"),_omega,mainRotVector, res1("CA").getCoor());
+	}
+	minorRotation(res1,res2,preO1,preO2);
+	minorRotation(res2,res3,preO2,preAt2);
+}
+
+bool samePoint(const CartesianPoint & _p1, const CartesianPoint & _p2) {
+	return _p1.getX() == _p2.getX() && _p1.getY() == _p2.getY() && _p1.getZ() == _p2.getZ();
+}
+
+void setCoor(AtomPointerVector & _atoms, const vector<CartesianPoint> & _coor) {
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		_atoms[i]->setCoor(_coor[i]);
+	}
+}
+
+bool sameAsCoor(AtomPointerVector & _atoms, const vector<CartesianPoint> & _coor) {
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		if (!samePoint(_atoms[i]->getCoor(), _coor[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ensembleMatchesLocalSample() {
+	string topFile = SYSENV.getEnv("MSL_CHARMM_TOP");
+	string parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+	System sys;
+	CharmmSystemBuilder CSB(sys, topFile, parFile);
+	if (!CSB.buildSystem(PolymerSequence("A: ALA LEU GLU LYS ALA LEU GLU LYS ALA LEU GLU LYS ALA LEU"))) {
+		cerr << "Cannot build the system with " << topFile << " " << parFile << endl;
+		exit(1);
+	}
+	sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	sys.buildAllAtoms();
+	Chain & ch = sys.getChain("A");
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	vector<CartesianPoint> start;
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		start.push_back(atoms[i]->getCoor());
+	}
+
+	bool pass = true;
+	unsigned int numMoves = 100;
+	unsigned int seed = 4321;
+	BackRub br1;
+	br1.setNumThreads(1);
+	unsigned int accepted = br1.sampleEnsemble(ch, 1, 12, numMoves, seed);
+	cout << "Accepted " << accepted << " of " << br1.getNumberOfMoves() << " moves" << endl;
+	if (accepted == 0 || !sameAsCoor(atoms, start)) {
+		cout << "NOT OK: no moves were accepted or the chain was not restored" << endl;
+		pass = false;
+	}
+
+	// each move against localSample
+	unsigned int replayed = 0;
+	for (unsigned int i=0; i<br1.getNumberOfMoves(); i++) {
+		vector<Atom*> moved = br1.getMoveAtoms(i);
+		vector<CartesianPoint> coor = br1.getMoveCoor(i);
+		if (moved.size() == 0) {
+			continue;
+		}
+		replayMove(ch, br1.getMoveStartResidue(i), br1.getMoveOmega(i));
+		for (unsigned int j=0; j<moved.size(); j++) {
+			if (!samePoint(moved[j]->getCoor(), coor[j])) {
+				cout << "NOT OK: move " << i << " atom " << moved[j]->getAtomId() << " " << coor[j] << " != " << moved[j]->getCoor() << endl;
+				pass = false;
+			}
+		}
+		// the other atoms are not moved by localSample either
+		set<Atom*> movedSet(moved.begin(), moved.end());
+		for (unsigned int j=0; j<atoms.size(); j++) {
+			if (movedSet.find(atoms[j]) == movedSet.end() && !samePoint(atoms[j]->getCoor(), start[j])) {
+				cout << "NOT OK: move " << i << " atom " << atoms[j]->getAtomId() << " is moved by localSample but not stored" << endl;
+				pass = false;
+			}
+		}
+		setCoor(atoms, start);
+		replayed++;
+	}
+	cout << "Compared " << replayed << " moves with localSample" << endl;
+
+	// the same ensemble on 4 threads
+	BackRub br4;
+	br4.setNumThreads(4);
+	if (br4.sampleEnsemble(ch, 1, 12, numMoves, seed) != accepted || br4.getNumberOfMoves() != br1.getNumberOfMoves()) {
+		cout << "NOT OK: different number of moves on 4 threads" << endl;
+		pass = false;
+	} else {
+		for (unsigned int i=0; i<br1.getNumberOfMoves(); i++) {
+			vector<CartesianPoint> coor1 = br1.getMoveCoor(i);
+			vector<CartesianPoint> coor4 = br4.getMoveCoor(i);
+			bool same = br1.getMoveStartResidue(i) == br4.getMoveStartResidue(i) && br1.getMoveOmega(i) == br4.getMoveOmega(i) && br1.getMoveAccepted(i) == br4.getMoveAccepted(i) && coor1.size() == coor4.size();
+			for (unsigned int j=0; same && j<coor1.size(); j++) {
+				same = samePoint(coor1[j], coor4[j]);
+			}
+			if (!same) {
+				cout << "NOT OK: move " << i << " is different on 4 threads" << endl;
+				pass = false;
+			}
+		}
+	}
+
+	// energy screening
+	EnergySet * pESet = sys.getEnergySet();
+	BackRub brE;
+	brE.setEnergySet(pESet);
+	brE.setEnergyCutoff(0.5);
+	brE.sampleEnsemble(ch, 1, 12, numMoves, seed);
+	if (!sameAsCoor(atoms, start)) {
+		cout << "NOT OK: the chain was not restored after the energy screening" << endl;
+		pass = false;
+	}
+	double startEnergy = sys.calcEnergy();
+	unsigned int screened = 0;
+	for (unsigned int i=0; i<brE.getNumberOfMoves(); i++) {
+		if (!br1.getMoveAccepted(i)) {
+			if (brE.getMoveAccepted(i)) {
+				cout << "NOT OK: move " << i << " accepted with energy screening only" << endl;
+				pass = false;
+			}
+			continue;
+		}
+		vector<Atom*> moved = brE.getMoveAtoms(i);
+		vector<CartesianPoint> coor = brE.getMoveCoor(i);
+		for (unsigned int j=0; j<moved.size(); j++) {
+			moved[j]->setCoor(coor[j]);
+		}
+		double delta = sys.calcEnergy() - startEnergy;
+		setCoor(atoms, start);
+		if (fabs(delta - brE.getMoveEnergy(i)) > 1.0e-10) {
+			cout << "NOT OK: move " << i << " energy change " << brE.getMoveEnergy(i) << " != " << delta << endl;
+			pass = false;
+		}
+		if (brE.getMoveAccepted(i) != (brE.getMoveEnergy(i) <= 0.5)) {
+			cout << "NOT OK: move " << i << " was not screened by the cutoff" << endl;
+			pass = false;
+		}
+		screened++;
+	}
+	unsigned int acceptedE = 0;
+	for (unsigned int i=0; i<brE.getNumberOfMoves(); i++) {
+		acceptedE += brE.getMoveAccepted(i);
+	}
+	cout << "Compared " << screened << " energy changes with full energy calculations, " << acceptedE << " moves accepted" << endl;
+	return pass;
+}
 
 int main(){
+	bool pass = ensembleMatchesLocalSample();
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
+
 	writePdbFile();
 
 	System sys;
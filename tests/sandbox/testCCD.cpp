@@ -36,6 +36,9 @@ You should have received a copy of the GNU Lesser General Public
 #include "Transforms.h"
 #include "RandomNumberGenerator.h"
 #include "CCD.h"
+#include "SysEnv.h"
+#include "PolymerSequence.h"
+#include "CharmmSystemBuilder.h"
 
 #include "testData.h"
 
@@ -43,11 +46,161 @@ using namespace std;
 
 using namespace MSL;
 
+static SysEnv SYSENV;
 
+/*******************************************************************
+ *  The fragments of sampleEnsemble must be identical (bit for bit)
+ *  to replaying the perturbation of localSample with the same random
+ *  numbers and closing it with closeFragment, must not depend on the
+ *  number of threads, and the energy changes must match full energy
+ *  calculations
+ *******************************************************************/
 
+bool samePoint(const CartesianPoint & _p1, const CartesianPoint & _p2) {
+	return _p1.getX() == _p2.getX() && _p1.getY() == _p2.getY() && _p1.getZ() == _p2.getZ();
+}
+
+bool ensembleMatchesLocalSample() {
+	string topFile = SYSENV.getEnv("MSL_CHARMM_TOP");
+	string parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+	System sys;
+	CharmmSystemBuilder CSB(sys, topFile, parFile);
+	if (!CSB.buildSystem(PolymerSequence("A: ALA LEU GLU LYS ALA LEU GLU LYS ALA LEU GLU LYS ALA LEU"))) {
+		cerr << "Cannot build the system with " << topFile << " " << parFile << endl;
+		exit(1);
+	}
+	sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	sys.buildAllAtoms();
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	vector<CartesianPoint> start;
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		start.push_back(atoms[i]->getCoor());
+	}
+	AtomSelection sel(atoms);
+	AtomPointerVector loopWithEnds = sel.select("loop, name CA and resi 3-12");
+	// the two end atoms are not moved (kept for BBQ)
+	AtomPointerVector loop;
+	for (unsigned int i=1; i<loopWithEnds.size()-1; i++) {
+		loop.push_back(loopWithEnds[i]);
+	}
+	unsigned int n = loop.size();
+
+	bool pass = true;
+	unsigned int numFragments = 40;
+	int maxDegree = 15;
+	unsigned int seed = 4321;
+	CCD ccd1;
+	ccd1.setNumThreads(1);
+	unsigned int accepted = ccd1.sampleEnsemble(loopWithEnds, numFragments, maxDegree, seed);
+	cout << "Closed " << accepted << " of " << ccd1.getNumberOfFragments() << " fragments" << endl;
+	for (unsigned int i=0; i<atoms.size(); i++) {
+		if (!samePoint(atoms[i]->getCoor(), start[i])) {
+			cout << "NOT OK: the loop was modified by sampleEnsemble" << endl;
+			pass = false;
+			break;
+		}
+	}
+
+	// each fragment against the perturbation and closure of localSample
+	for (unsigned int f=0; f<ccd1.getNumberOfFragments(); f++) {
+		RandomStream stream(seed, f);
+		AtomPointerVector av = loop;
+		bool reversed = false;
+		if (stream.getRandomDouble() > 0.5){
+			std::reverse(av.begin(), av.end());
+			reversed = true;
+		}
+		Atom fixedAtom(av(av.size()-1));
+		Transforms t;
+		for (unsigned int i = 1; i < av.size()-2;i++){
+			CartesianPoint axis = av(i+1).getCoor();
+			double angle = stream.getRandomInt(maxDegree);
+			for (unsigned int j=i+2; j < av.size();j++){
+				t.rotate(av(j),angle, axis, av(i).getCoor());
+			}
+		}
+		CCD closer;
+		closer.closeFragment(av, fixedAtom);
+		if (reversed){
+			std::reverse(av.begin(), av.end());
+		}
+		vector<CartesianPoint> coor = ccd1.getFragmentCoor(f);
+		for (unsigned int i=0; i<n; i++) {
+			if (!samePoint(av[i]->getCoor(), coor[i])) {
+				cout << "NOT OK: fragment " << f << " atom " << av[i]->getAtomId() << " " << coor[i] << " != " << av[i]->getCoor() << endl;
+				pass = false;
+			}
+		}
+		for (unsigned int i=0; i<atoms.size(); i++) {
+			atoms[i]->setCoor(start[i]);
+		}
+	}
+
+	// the same ensemble on 4 threads
+	CCD ccd4;
+	ccd4.setNumThreads(4);
+	if (ccd4.sampleEnsemble(loopWithEnds, numFragments, maxDegree, seed) != accepted) {
+		cout << "NOT OK: different number of fragments closed on 4 threads" << endl;
+		pass = false;
+	}
+	for (unsigned int f=0; f<ccd1.getNumberOfFragments(); f++) {
+		vector<CartesianPoint> coor1 = ccd1.getFragmentCoor(f);
+		vector<CartesianPoint> coor4 = ccd4.getFragmentCoor(f);
+		bool same = ccd1.getFragmentClosed(f) == ccd4.getFragmentClosed(f) && ccd1.getFragmentIterations(f) == ccd4.getFragmentIterations(f);
+		for (unsigned int i=0; same && i<n; i++) {
+			same = samePoint(coor1[i], coor4[i]);
+		}
+		if (!same) {
+			cout << "NOT OK: fragment " << f << " is different on 4 threads" << endl;
+			pass = false;
+		}
+	}
+
+	// energy screening
+	double cutoff = 1000.0;
+	CCD ccdE;
+	ccdE.setEnergySet(sys.getEnergySet());
+	ccdE.setEnergyCutoff(cutoff);
+	ccdE.sampleEnsemble(loopWithEnds, numFragments, maxDegree, seed);
+	double startEnergy = sys.calcEnergy();
+	unsigned int screened = 0;
+	unsigned int acceptedE = 0;
+	for (unsigned int f=0; f<ccdE.getNumberOfFragments(); f++) {
+		if (!ccd1.getFragmentClosed(f)) {
+			continue;
+		}
+		vector<CartesianPoint> coor = ccdE.getFragmentCoor(f);
+		for (unsigned int i=0; i<n; i++) {
+			loop[i]->setCoor(coor[i]);
+		}
+		double delta = sys.calcEnergy() - startEnergy;
+		for (unsigned int i=0; i<atoms.size(); i++) {
+			atoms[i]->setCoor(start[i]);
+		}
+		if (fabs(delta - ccdE.getFragmentEnergy(f)) > 1.0e-10) {
+			cout << "NOT OK: fragment " << f << " energy change " << ccdE.getFragmentEnergy(f) << " != " << delta << endl;
+			pass = false;
+		}
+		if (ccdE.getFragmentAccepted(f) != (ccdE.getFragmentEnergy(f) <= cutoff)) {
+			cout << "NOT OK: fragment " << f << " was not screened by the cutoff" << endl;
+			pass = false;
+		}
+		acceptedE += ccdE.getFragmentAccepted(f);
+		screened++;
+	}
+	cout << "Compared " << screened << " energy changes with full energy calculations, " << acceptedE << " fragments accepted" << endl;
+	return pass;
+}
 
 int main() {
 
+	bool pass = ensembleMatchesLocalSample();
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
+
 	// Write a test pdb file '/tmp/pdbDimer.pdb'
 	writePdbFile();
 
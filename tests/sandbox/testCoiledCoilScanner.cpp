@@ -0,0 +1,234 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include <string>
+#include <fstream>
+#include "SysEnv.h"
+#include "System.h"
+#include "PolymerSequence.h"
+#include "CharmmSystemBuilder.h"
+#include "CoiledCoils.h"
+#include "CoiledCoilScanner.h"
+
+using namespace MSL;
+using namespace std;
+
+static SysEnv SYSENV;
+
+/*******************************************************************
+ *  Scans a small grid of dimeric coiled coils, evaluated by the
+ *  CHARMM energy of the bundle with side chains built from the
+ *  IC table.  The most compact bundles are pre-screened by CA
+ *  distance.  The results must be ranked, accounted for, streamed
+ *  to the output file, and have the same energy of a serial
+ *  rebuild of the same point.  The packed backbone given to
+ *  Evaluator::prescreen, and the packed coordinates of
+ *  CoiledCoils::getCoiledCoilBundleCoordinates, must match the
+ *  atoms of CoiledCoils::getCoiledCoilBundle.
+ *******************************************************************/
+
+string topFile;
+string parFile;
+string sequence = "A: LEU LYS GLU LEU GLU ASP LYS VAL GLU GLU LEU LEU SER LYS\nB: LEU LYS GLU LEU GLU ASP LYS VAL GLU GLU LEU LEU SER LYS";
+
+class EnergyEvaluator : public CoiledCoilScanner::Evaluator {
+	public:
+		CoiledCoilScanner::Evaluator * clone() const {
+			return new EnergyEvaluator;
+		}
+		bool setup(System & _sys) {
+			CharmmSystemBuilder CSB(_sys, topFile, parFile);
+			CSB.setBuildNonBondedInteractions(true);
+			return CSB.buildSystem(PolymerSequence(sequence));
+		}
+		bool evaluate(System & _sys, const CoiledCoilScanner::Parameters & _parameters, double & _energy, string & _annotation) {
+			_sys.buildAtoms();
+			_energy = _sys.calcEnergy();
+			_annotation = "";
+			return true;
+		}
+};
+
+// an evaluator with a pre-screening that rejects phi1 above 180
+bool prescreenOK = true;
+class PrescreenEvaluator : public EnergyEvaluator {
+	public:
+		CoiledCoilScanner::Evaluator * clone() const {
+			return new PrescreenEvaluator;
+		}
+		bool prescreen(const vector<double> & _backbone, const CoiledCoilScanner::Parameters & _parameters) {
+			AtomPointerVector & bundle = cc.getCoiledCoilBundle(_parameters.r0, _parameters.rpr, _parameters.pitch, _parameters.r1, _parameters.w1, _parameters.phi1, 0.0, 14, "C", 2);
+			bool same = 3 * bundle.size() == _backbone.size();
+			for (unsigned int i=0; same && i < bundle.size(); i++) {
+				if (bundle[i]->getCoor().distance(CartesianPoint(_backbone[3*i], _backbone[3*i+1], _backbone[3*i+2])) > 1.0e-9) {
+					same = false;
+				}
+			}
+			if (!same) {
+#ifdef __OPENMP__
+				#pragma omp critical(testPrescreen)
+#endif
+				prescreenOK = false;
+			}
+			return _parameters.phi1 < 180.0;
+		}
+	private:
+		CoiledCoils cc;
+};
+
+int main() {
+
+	topFile = SYSENV.getEnv("MSL_CHARMM_TOP");
+	parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+
+	vector<string> startingPositions;
+	startingPositions.push_back("A,1");
+	startingPositions.push_back("B,1");
+
+	CoiledCoilScanner scanner;
+	scanner.setR0Range(4.5, 5.5, 0.5);
+	scanner.setR1Range(2.26, 2.26, 0.0);
+	scanner.setW1Range(102.8, 102.8, 0.0);
+	scanner.setPhi1Range(150.0, 210.0, 60.0);
+	scanner.setRprRange(1.51, 1.51, 0.0);
+	scanner.setPitchRange(120.0, 180.0, 60.0);
+	scanner.setBundle(14, "C", 2, startingPositions);
+	scanner.setMinimumCaDistance(5.2);
+	scanner.setOutputFile("/tmp/testCoiledCoilScanner.txt");
+
+	EnergyEvaluator evaluator;
+	bool pass = true;
+	if (!scanner.scan(evaluator)) {
+		cout << "NOT OK: the scan failed" << endl;
+		pass = false;
+	}
+	cout << scanner.getNumberOfPoints() << " points on " << scanner.getNumThreads() << " thread(s): " << scanner.getNumberOfResults() << " evaluated, " << scanner.getNumberOfPrescreened() << " pre-screened, " << scanner.getNumberOfRejected() << " rejected, " << scanner.getNumberOfFailed() << " failed" << endl;
+	scanner.writeResults(cout);
+
+	if (scanner.getNumberOfPoints() != 12) {
+		cout << "NOT OK: expected 12 points" << endl;
+		pass = false;
+	}
+	if (scanner.getNumberOfResults() + scanner.getNumberOfPrescreened() + scanner.getNumberOfRejected() + scanner.getNumberOfFailed() != scanner.getNumberOfPoints() || scanner.getNumberOfResults() == 0 || scanner.getNumberOfPrescreened() == 0) {
+		cout << "NOT OK: points not accounted for" << endl;
+		pass = false;
+	}
+
+	// the streamed output has a line per result
+	ifstream in_fs("/tmp/testCoiledCoilScanner.txt");
+	string line;
+	unsigned int lines = 0;
+	while (getline(in_fs, line)) {
+		lines++;
+	}
+	if (lines != scanner.getNumberOfResults()) {
+		cout << "NOT OK: " << lines << " lines in the output file" << endl;
+		pass = false;
+	}
+
+	// rebuild every result serially
+	System sys;
+	CoiledCoils cc;
+	evaluator.setup(sys);
+	for (unsigned int i=0; i < scanner.getNumberOfResults(); i++) {
+		const CoiledCoilScanner::Result & result = scanner.getResult(i);
+		if (i > 0 && result.energy < scanner.getResult(i-1).energy) {
+			cout << "NOT OK: results not sorted" << endl;
+			pass = false;
+		}
+		const CoiledCoilScanner::Parameters & p = result.parameters;
+		sys.wipeAllCoordinates();
+		cc.setSystemToCoiledCoil(p.r0, p.rpr, p.pitch, p.r1, p.w1, p.phi1, 0.0, 14, "C", 2, sys, startingPositions);
+		sys.buildAtoms();
+		double energy = sys.calcEnergy();
+		if (fabs(energy - result.energy) > 1.0e-6) {
+			cout << "NOT OK: point " << p.index << " energy " << result.energy << " != " << energy << endl;
+			pass = false;
+		}
+	}
+
+	// the evaluator pre-screening
+	unsigned int prescreened = scanner.getNumberOfPrescreened();
+	PrescreenEvaluator prescreenEvaluator;
+	scanner.setOutputFile("");
+	scanner.scan(prescreenEvaluator);
+	if (!prescreenOK) {
+		cout << "NOT OK: the packed backbone given to the prescreen differs from the bundle" << endl;
+		pass = false;
+	}
+	if (scanner.getNumberOfPrescreened() <= prescreened) {
+		cout << "NOT OK: the evaluator prescreen did not reject any point" << endl;
+		pass = false;
+	}
+	for (unsigned int i=0; i < scanner.getNumberOfResults(); i++) {
+		if (scanner.getResult(i).parameters.phi1 > 180.0) {
+			cout << "NOT OK: point " << scanner.getResult(i).parameters.index << " passed the evaluator prescreen" << endl;
+			pass = false;
+		}
+	}
+
+	// the packed coordinates are the same of the atoms of the bundle
+	for (unsigned int n=2; n <= 3; n++) {
+		for (unsigned int d=0; d < 2; d++) {
+			string symmetry = d == 0 ? "C" : "D";
+			vector<double> xyz;
+			cc.getCoiledCoilBundleCoordinates(6.0, 1.51, 150.0, 2.26, 102.8, 200.0, 0.0, 14, symmetry, n, xyz);
+			AtomPointerVector & bundle = cc.getCoiledCoilBundle(6.0, 1.51, 150.0, 2.26, 102.8, 200.0, 0.0, 14, symmetry, n);
+			if (xyz.size() != 3 * bundle.size() || bundle.size() != 4 * 14 * n * (d+1)) {
+				cout << "NOT OK: " << symmetry << n << " bundle has " << xyz.size() / 3 << " packed coordinates and " << bundle.size() << " atoms" << endl;
+				pass = false;
+				continue;
+			}
+			for (unsigned int i=0; i < bundle.size(); i++) {
+				if (bundle[i]->getCoor().distance(CartesianPoint(xyz[3*i], xyz[3*i+1], xyz[3*i+2])) > 1.0e-9) {
+					cout << "NOT OK: " << symmetry << n << " packed coordinates of atom " << bundle[i]->getAtomId() << " differ" << endl;
+					pass = false;
+					break;
+				}
+			}
+		}
+	}
+
+	// keep only the best two
+	scanner.setMaxResults(2);
+	scanner.setOutputFile("");
+	scanner.scan(evaluator);
+	if (scanner.getNumberOfResults() != 2) {
+		cout << "NOT OK: " << scanner.getNumberOfResults() << " results kept instead of 2" << endl;
+		pass = false;
+	}
+
+	if (pass) {
+		cout << "Coiled coil scanner OK" << endl;
+	} else {
+		cout << "Coiled coil scanner NOT OK" << endl;
+	}
+
+	return 0;
+}
@@ -136,6 +136,69 @@ int main(int argc, char *argv[]) {
 	  cout << "LEAD";
 	}
 
+	/******************************************************************************
+	 *
+	 *     === ANALYTIC DERIVATIVES OF THE COORDINATES VS FINITE DIFFERENCES ===
+	 *
+	 ******************************************************************************/
+	double p[6] = {shr, risePerRes, shp, ahr, ahp, ahphase};
+	string paramNames[6] = {"r0", "risePerRes", "pitch", "r1", "w1", "phi1"};
+	vector<double> xyz;
+	vector<vector<double> > gradient;
+	cc.getCoiledCoilBundleGradient(p[0], p[1], p[2], p[3], p[4], p[5], dZ, 26, "D", 2, xyz, gradient);
+	for (unsigned int k = 0; k < 6; k++) {
+		double delta = 0.00001;
+		double q[6];
+		vector<double> plus;
+		vector<double> minus;
+		for (unsigned int j = 0; j < 6; j++) {
+			q[j] = p[j];
+		}
+		q[k] += delta;
+		cc.getCoiledCoilBundleCoordinates(q[0], q[1], q[2], q[3], q[4], q[5], dZ, 26, "D", 2, plus);
+		q[k] -= 2 * delta;
+		cc.getCoiledCoilBundleCoordinates(q[0], q[1], q[2], q[3], q[4], q[5], dZ, 26, "D", 2, minus);
+		double maxError = 0.0;
+		for (unsigned int i = 0; i < xyz.size(); i++) {
+			maxError = max(maxError, fabs((plus[i] - minus[i]) / (2 * delta) - gradient[k][i]));
+		}
+		if (maxError > 0.00001) {
+			cerr << "ERROR derivative with respect to " << paramNames[k] << " is off by " << maxError << endl;
+		}
+	}
+
+	/******************************************************************************
+	 *
+	 *                   === BATCH FITTING OF C3 AND D2 BUNDLES ===
+	 *
+	 ******************************************************************************/
+	string batchSymmetry[2] = {"C", "D"};
+	int batchN[2] = {3, 2};
+	double batchParams[2][3] = {{6.5, 170.0, 20.0}, {7.2, -230.0, 250.0}}; // r0, pitch, phi1
+	vector<System*> batchSystems;
+	vector<CoiledCoilFitter*> fitters;
+	for (unsigned int b = 0; b < 2; b++) {
+		AtomPointerVector & bundle = cc.getCoiledCoilBundle(batchParams[b][0], risePerRes, batchParams[b][1], ahr, ahp, batchParams[b][2], dZ, 20, batchSymmetry[b], batchN[b]);
+		batchSystems.push_back(new System);
+		batchSystems.back()->addAtoms(bundle);
+		fitters.push_back(new CoiledCoilFitter);
+		fitters.back()->setSymmetry(batchSymmetry[b]);
+		for (unsigned int h = 0; h < batchSystems.back()->chainSize(); h++) {
+			fitters.back()->addNextHelix(&batchSystems.back()->getChain(h).getAtomPointers());
+		}
+	}
+	if (!CoiledCoilFitter::fitBatch(fitters)) {
+		cerr << "ERROR batch fitting failed" << endl;
+	}
+	for (unsigned int b = 0; b < 2; b++) {
+		vector<double> fitted = fitters[b]->getMinimizedParameters();
+		if (fitted.size() != 7 || abs(fitted[0] - batchParams[b][0]) > 0.1 || abs(fitted[2] - batchParams[b][1]) > 0.1 || abs(fitted[5] - batchParams[b][2]) > 0.1) {
+			cerr << "ERROR batch fit of the " << batchSymmetry[b] << batchN[b] << " bundle did not recover the parameters" << endl;
+		}
+		delete fitters[b];
+		delete batchSystems[b];
+	}
+
 
 
 }
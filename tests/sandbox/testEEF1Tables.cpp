@@ -0,0 +1,253 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include <string>
+#include <fstream>
+#include "SysEnv.h"
+#include "System.h"
+#include "PolymerSequence.h"
+#include "CharmmSystemBuilder.h"
+#include "Transforms.h"
+#include "RandomNumberGenerator.h"
+
+using namespace MSL;
+using namespace std;
+
+static SysEnv SYSENV;
+
+/*******************************************************************
+ *  Builds a helix with EEF1 (WATER) and with IMM1 (MEMBRANE)
+ *  solvation, evaluates every interaction with the exact kernels
+ *  and with the tabulated ones, on the helix and after shaking the
+ *  coordinates, and checks a table against EEF1Ener over its
+ *  whole range
+ *******************************************************************/
+
+// the EEF1 parameters of the aminoacid heavy atoms, with zeros for the hydrogens
+const char * solvationParameters =
+	"CHEX\n"
+	"C       14.7     0.000     0.00     0.000   0.00        3.5\n"
+	"CT1     23.7    -0.645    -0.86    -1.038   0.00        3.5\n"
+	"CT2     22.4    -0.720    -1.01    -1.160   0.00        3.5\n"
+	"CT3     30.0    -0.665    -0.92    -1.071   0.00        3.5\n"
+	"CC      14.7     0.000     0.00     0.000   0.00        3.5\n"
+	"NH1      4.4    -1.145    -1.72    -1.843   0.00        3.5\n"
+	"NR1      4.4    -1.145    -1.72    -1.843   0.00        3.5\n"
+	"NY       4.4    -1.145    -1.72    -1.843   0.00        3.5\n"
+	"NR2      4.4    -1.630    -1.71    -2.624   0.00        3.5\n"
+	"NH2     11.2    -1.145    -1.64    -1.843   0.00        3.5\n"
+	"NH3     11.2    -1.145    -1.15    -1.843   0.00        6.0\n"
+	"NC2     11.2    -0.200    -0.20    -0.322   0.00        6.0\n"
+	"N        0.0    -1.145    -1.72    -1.843   0.00        3.5\n"
+	"CPH1    18.4    -0.410    -0.57    -0.660   0.00        3.5\n"
+	"CPH2    18.4    -0.410    -0.57    -0.660   0.00        3.5\n"
+	"CA      18.4    -0.410    -0.57    -0.660   0.00        3.5\n"
+	"CY      18.4    -0.410    -0.57    -0.660   0.00        3.5\n"
+	"CPT     18.4    -0.410    -0.57    -0.660   0.00        3.5\n"
+	"CP1     23.7    -0.645    -0.86    -1.038   0.00        3.5\n"
+	"CP2     22.4    -0.720    -1.01    -1.160   0.00        3.5\n"
+	"CP3     22.4    -0.720    -1.01    -1.160   0.00        3.5\n"
+	"S       14.7    -1.780    -2.25    -2.866   0.00        3.5\n"
+	"SM      14.7    -1.780    -2.25    -2.866   0.00        3.5\n"
+	"OH1     10.8    -0.960    -1.09    -1.546   0.00        3.5\n"
+	"O       10.8    -1.270    -1.39    -2.045   0.00        3.5\n"
+	"OC      10.8    -0.900    -0.90    -1.449   0.00        6.0\n"
+	"H        0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HA       0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HB       0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HC       0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HP       0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HR1      0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HR3      0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HS       0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"END\n"
+	"WATER\n"
+	"C       14.7     0.000     0.00     0.000   0.00        3.5\n"
+	"CT1     23.7    -0.187    -0.25	    0.876   0.00 	3.5\n"
+	"CT2     22.4     0.372     0.52	   -0.610  18.60 	3.5\n"
+	"CT3     30.0     1.089     1.50	   -1.779  35.60 	3.5\n"
+	"CC      14.7     0.000     0.00	    0.000   0.00 	3.5\n"
+	"NH1      4.4    -5.950    -8.90    -9.059  -8.80        3.5\n"
+	"NR1      4.4    -5.950    -8.90    -9.059  -8.80 	3.5\n"
+	"NY       4.4    -5.950    -8.90    -9.059  -8.80 	3.5\n"
+	"NR2      4.4    -3.820    -4.00    -4.654  -8.80 	3.5\n"
+	"NH2     11.2    -5.450    -7.80    -9.028  -7.00        3.5\n"
+	"NH3     11.2   -20.000   -20.00   -25.000 -18.00        6.0\n"
+	"NC2     11.2   -10.000   -10.00   -12.000  -7.00        6.0\n"
+	"N        0.0    -1.000    -1.55    -1.250   8.80        3.5\n"
+	"CPH1    18.4     0.057     0.08    -0.973   6.90 	3.5\n"
+	"CPH2    18.4     0.057     0.08    -0.973   6.90 	3.5\n"
+	"CA      18.4     0.057     0.08    -0.973   6.90 	3.5\n"
+	"CY      18.4     0.057     0.08    -0.973   6.90 	3.5\n"
+	"CPT     18.4     0.057     0.08    -0.973   6.90 	3.5\n"
+	"CP1     23.7    -0.187    -0.25	    0.876   0.00 	3.5\n"
+	"CP2     22.4     0.372     0.52	   -0.610  18.60 	3.5\n"
+	"CP3     22.4     0.372     0.52	   -0.610  18.60 	3.5\n"
+	"S       14.7    -3.240    -4.10    -4.475 -39.90        3.5\n"
+	"SM      14.7    -3.240    -4.10    -4.475 -39.90 	3.5\n"
+	"OH1     10.8    -5.920    -6.70    -9.264 -11.20        3.5\n"
+	"O       10.8    -5.330    -5.85    -5.787  -8.80        3.5\n"
+	"OC      10.8   -10.000   -10.00   -12.000  -9.40        6.0\n"
+	"H        0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HA       0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HB       0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HC       0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HP       0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HR1      0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HR3      0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"HS       0.0     0.000     0.00     0.000   0.00        3.5\n"
+	"END\n";
+
+double compare(string _solvent, string _term, string _topFile, string _parFile, string _solvFile, unsigned int & _nonZero) {
+	System sys;
+	CharmmSystemBuilder CSB(sys, _topFile, _parFile, _solvFile);
+	CSB.setSolvent(_solvent);
+	CSB.setBuildNonBondedInteractions(false);
+	if (!CSB.buildSystem(PolymerSequence("A: SER ASN GLU LYS ARG GLN THR TYR HSD ASP TRP SER GLU LYS ARG ASN GLN THR TYR ASP"))) {
+		cerr << "Cannot build the system with " << _topFile << " " << _parFile << endl;
+		exit(1);
+	}
+	if (!sys.seed("A 1 C", "A 1 CA", "A 1 N")) {
+		cerr << "Cannot seed atoms C, CA, N on residue 1 A" << endl;
+		exit(1);
+	}
+	sys.buildAllAtoms();
+
+	Transforms tr;
+	Chain & chain = sys.getChain("A");
+	for (unsigned int i=1; i < chain.positionSize(); i++) {
+		Residue & prev = chain.getResidue(i-1);
+		Residue & res = chain.getResidue(i);
+		tr.setDihedral(prev("C"), res("N"), res("CA"), res("C"), -57.0);
+		if (i+1 < chain.positionSize()) {
+			tr.setDihedral(res("N"), res("CA"), res("C"), chain.getResidue(i+1)("N"), -47.0);
+		}
+	}
+	CSB.updateNonBonded(7.0, 8.0, 9.0);
+
+	vector<Interaction*> & interactions = (*sys.getEnergySet()->getEnergyTerms())[_term];
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	RandomNumberGenerator rng;
+	rng.setSeed(541);
+
+	double maxError = 0.0;
+	_nonZero = 0;
+	for (unsigned int trial=0; trial < 10; trial++) {
+		if (trial > 0) {
+			for (unsigned int i=0; i < atoms.size(); i++) {
+				// shake, and move across the membrane
+				CartesianPoint delta(rng.getRandomDouble(-0.4, 0.4), rng.getRandomDouble(-0.4, 0.4), rng.getRandomDouble(-0.4, 0.4) + 3.0);
+				atoms[i]->setCoor(atoms[i]->getCoor() + delta);
+			}
+		}
+		for (unsigned int i=0; i < interactions.size(); i++) {
+			double exact = 0.0;
+			double table = 0.0;
+			if (_term == "CHARMM_EEF1") {
+				CharmmEEF1Interaction * pEEF1 = (CharmmEEF1Interaction*)interactions[i];
+				pEEF1->setUseTable(false);
+				exact = pEEF1->getEnergy();
+				pEEF1->setUseTable(true, 0.2);
+				table = pEEF1->getEnergy();
+			} else {
+				CharmmIMM1Interaction * pIMM1 = (CharmmIMM1Interaction*)interactions[i];
+				pIMM1->setUseTables(false);
+				exact = pIMM1->getEnergy();
+				pIMM1->setUseTables(true, 0.2);
+				table = pIMM1->getEnergy();
+			}
+			if (fabs(table - exact) > maxError) {
+				maxError = fabs(table - exact);
+			}
+			if (exact != 0.0) {
+				_nonZero++;
+			}
+		}
+	}
+	cout << _term << ": " << interactions.size() << " interactions, " << _nonZero << " non zero evaluations, largest difference " << maxError << endl;
+	return maxError;
+}
+
+int main() {
+
+	string topFile = SYSENV.getEnv("MSL_CHARMM_TOP");
+	string parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+	string solvFile = "/tmp/testEEF1Tables_solvpar.inp";
+
+	ofstream out(solvFile.c_str());
+	out << solvationParameters;
+	out.close();
+
+	bool pass = true;
+	unsigned int nonZero = 0;
+	if (compare("WATER", "CHARMM_EEF1", topFile, parFile, solvFile, nonZero) > 1.0e-5 || nonZero == 0) {
+		cout << "NOT OK: the tabulated EEF1 energies differ from the exact ones" << endl;
+		pass = false;
+	}
+	if (compare("MEMBRANE", "CHARMM_IMM1", topFile, parFile, solvFile, nonZero) > 1.0e-5 || nonZero == 0) {
+		cout << "NOT OK: the tabulated IMM1 energies differ from the exact ones" << endl;
+		pass = false;
+	}
+
+	// a table against the exact kernel, over the whole range
+	CharmmEnergy * pEnergy = CharmmEnergy::instance();
+	double p[8] = {11.2, -5.95, 3.5, 1.85, 18.4, -6.70, 6.0, 2.06}; // an NH2 / OC pair
+	vector<double> params(p, p + 8);
+	const CharmmEnergy::EEF1Table * pTable = pEnergy->getEEF1Table(params, 0.1);
+	if (pTable == NULL || pTable != pEnergy->getEEF1Table(params, 0.1)) {
+		cout << "NOT OK: the table was not built or not shared" << endl;
+		pass = false;
+	} else {
+		vector<double> distances;
+		for (double d=0.0; d < 50.0; d += 0.0137) {
+			distances.push_back(d);
+		}
+		double maxError = 0.0;
+		for (unsigned int i=0; i < distances.size(); i++) {
+			double energy = pEnergy->EEF1EnerTable(*pTable, distances[i]);
+			double exact = pEnergy->EEF1Ener(distances[i], p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
+			if (distances[i] >= 1.0 && fabs(energy - exact) > maxError) {
+				maxError = fabs(energy - exact);
+			}
+		}
+		cout << "Table at " << distances.size() << " distances, largest difference " << maxError << " (table relative error " << pTable->maxError << ")" << endl;
+		if (maxError > 1.0e-6) {
+			cout << "NOT OK: the tabulated energy differs from the exact one by " << maxError << endl;
+			pass = false;
+		}
+	}
+
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
+
+	return 0;
+}
@@ -35,16 +35,54 @@ You should have received a copy of the GNU Lesser General Public
 #include "AtomSelection.h"
 #include "CharmmVdwInteraction.h"
 #include "CharmmBondInteraction.h"
+#include "CharmmAngleInteraction.h"
+#include "CharmmDihedralInteraction.h"
+#include "CharmmEEF1Interaction.h"
 
 using namespace std;
 
 using namespace MSL;
 
+/*******************************************************************
+ *  The gradient as calcEnergyAndEnergyGradient computed it before
+ *  the flat buffer and the scratch vector: a new vector for each
+ *  interaction (the short vectors of EEF1 read as zeros)
+ *******************************************************************/
+double referenceGradient(EnergySet & _ESet, vector<double> & _gradients) {
+	double energy = 0.0;
+	map<string, vector<Interaction*> > * terms = _ESet.getEnergyTerms();
+	for (map<string, vector<Interaction*> >::iterator k=terms->begin(); k!=terms->end(); k++) {
+		if (!_ESet.isTermActive(k->first)) {
+			continue;
+		}
+		for (vector<Interaction*>::const_iterator l=k->second.begin(); l!=k->second.end(); l++) {
+			if (!(*l)->isActive()) {
+				continue;
+			}
+			vector<Atom *> &ats = (*l)->getAtomPointers();
+			vector<double> gradient;
+			energy += (*l)->getEnergy(&gradient);
+			for (uint a = 0; a < ats.size();a++){
+				if (ats[a]->getMinimizationIndex() == -1){
+					continue;
+				}
+				for (uint c = 0; c < 3; c++) {
+					if (3*a+c < gradient.size()) {
+						_gradients[3*(ats[a]->getMinimizationIndex()-1)+c] += gradient[3*a+c];
+					}
+				}
+			}
+		}
+	}
+	return energy;
+}
+
 
 int main(){
 
 	// Coiling an ideal, Z-aligned helix
-	PDBReader pin(idealHelix);
+	PDBReader pin;
+	pin.read(idealHelix);
 	AtomPointerVector ideal;
 	ideal = pin.getAtomPointers();
 	pin.close();
@@ -79,7 +117,75 @@ int main(){
 	ESet.printSummary();
 	cout << "Total number of interactions = " << ESet.getTotalNumberOfInteractionsCalculated() << endl;
 
-	EnergySet ESet2(ESet); //Copy doesnt work as of now
-	ESet2.calcEnergy();
-	ESet2.printSummary();
+	/*******************************************************************
+	 *  The gradient accumulated in a flat buffer (with the reused
+	 *  scratch vector) must be the same as the one computed with a new
+	 *  vector for each interaction.  Some atoms are not minimized, an
+	 *  EEF1 term returns a short derivative vector and one term is
+	 *  inactive
+	 *******************************************************************/
+	cout << endl;
+	cout << "=========================" << endl;
+	bool pass = true;
+	EnergySet gradSet;
+	for (uint i = 0; i + 3 < ideal.size(); i++) {
+		gradSet.addInteraction(new CharmmBondInteraction(*ideal[i], *ideal[i+1], 300.0, 1.5));
+		gradSet.addInteraction(new CharmmAngleInteraction(*ideal[i], *ideal[i+1], *ideal[i+2], 50.0, 1.9));
+		gradSet.addInteraction(new CharmmDihedralInteraction(*ideal[i], *ideal[i+1], *ideal[i+2], *ideal[i+3], 1.5, 3.0, 0.0));
+		if (i + 6 < ideal.size()) {
+			gradSet.addInteraction(new CharmmVdwInteraction(*ideal[i], *ideal[i+6], 3.8, -0.1));
+		}
+	}
+	gradSet.addInteraction(new CharmmEEF1Interaction(*ideal[0], *ideal[5], 14.7, -1.0, 3.5, 2.0, 14.7, -1.0, 3.5, 2.0));
+	gradSet.addInteraction(new CharmmBondInteraction(*ideal[0], *ideal[8], 1000.0, 1.0));
+	gradSet.setTermActive("CHARMM_BOND", false);
+	gradSet.addInteraction(new CharmmBondInteraction(*ideal[1], *ideal[9], 1000.0, 1.0));
+
+	// every fifth atom is not minimized
+	uint numMinimized = 0;
+	for (uint i = 0; i < ideal.size(); i++) {
+		if (i % 5 == 4) {
+			ideal[i]->setMinimizationIndex(-1);
+		} else {
+			numMinimized++;
+			ideal[i]->setMinimizationIndex(numMinimized);
+		}
+	}
+
+	vector<double> reference(3 * numMinimized, 0.0);
+	double referenceEnergy = referenceGradient(gradSet, reference);
+	for (uint repeat = 0; repeat < 2; repeat++) {
+		// the second time the scratch vector is reused
+		vector<double> gradient(3 * numMinimized, 0.0);
+		double energy = gradSet.calcEnergyAndEnergyGradient(gradient);
+		cout << "Gradient " << repeat << ": energy " << energy << ", reference " << referenceEnergy << endl;
+		if (energy != referenceEnergy) {
+			cout << "NOT OK: the energy differs from the reference" << endl;
+			pass = false;
+		}
+		for (uint i = 0; i < gradient.size(); i++) {
+			if (gradient[i] != reference[i]) {
+				cout << "NOT OK: gradient component " << i << " is " << gradient[i] << ", expected " << reference[i] << endl;
+				pass = false;
+			}
+		}
+	}
+	gradSet.setTermActive("CHARMM_BOND", true);
+	vector<double> withBonds(3 * numMinimized, 0.0);
+	gradSet.calcEnergyAndEnergyGradient(withBonds);
+	vector<double> withBondsReference(3 * numMinimized, 0.0);
+	referenceGradient(gradSet, withBondsReference);
+	if (withBonds != withBondsReference || withBonds == reference) {
+		cout << "NOT OK: wrong gradient after activating the bond term" << endl;
+		pass = false;
+	}
+	for (uint i = 0; i < ideal.size(); i++) {
+		ideal[i]->setMinimizationIndex(-1);
+	}
+
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
 }
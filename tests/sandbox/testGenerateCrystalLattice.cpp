@@ -32,11 +32,13 @@ You should have received a copy of the GNU Lesser General Public
 #include "AtomPointerVector.h"
 #include "CrystalLattice.h"
 #include "Transforms.h"
+#include <algorithm>
 
 using namespace MSL;
 using namespace std;
 
 void copyAtoms(const AtomPointerVector & _atoms, AtomPointerVector *newAts) ;
+bool inContact(AtomPointerVector * _first, AtomPointerVector * _second);
 void invert(Matrix &a,Matrix &in);
 
 int main(){
@@ -49,6 +51,48 @@ int main(){
 	cl.generateCrystal();
 
 	cl.writeCrystalUnits("/tmp/E",true,true,"A",false);
+
+	// the units within 5 A of the original, pruned by bounding spheres and a grid, against a pairwise check of all atoms
+	CrystalLattice contacts("/tmp/xtalLattice.pdb");
+	vector<string> keys = contacts.generateContactingUnits(5.0);
+	CrystalLattice pairwise("/tmp/xtalLattice.pdb");
+	vector<AtomPointerVector*> units = pairwise.generateCrystal(&inContact);
+	unsigned int found = 0;
+	unsigned int pairwiseUnits = 0;
+	for (unsigned int i = 0; i < units.size(); i++) {
+		if (units[i]->getGeometricCenter().distance(pairwise.getCrystalUnit("orig")->getGeometricCenter()) < 1.0) {
+			continue; // the copy of the original unit
+		}
+		pairwiseUnits++;
+		for (unsigned int k = 0; k < keys.size(); k++) {
+			AtomPointerVector * unit = contacts.getCrystalUnit(keys[k]);
+			if (unit->getGeometricCenter().distance(units[i]->getGeometricCenter()) < 1.0 && unit->rmsd(*units[i]) < 0.00001) {
+				found++;
+				break;
+			}
+		}
+	}
+	if (found != keys.size() || pairwiseUnits != keys.size() || keys.size() == 0) {
+		cerr << "ERROR the " << keys.size() << " contacting units do not match the " << pairwiseUnits << " units found with the pairwise check (" << found << " in common)" << endl;
+	} else {
+		cout << keys.size() << " contacting units" << endl;
+	}
+
+	// a second call replaces the units of the first one
+	vector<string> farKeys = contacts.generateContactingUnits(10.0);
+	for (unsigned int k = 0; k < farKeys.size(); k++) {
+		contacts.getCrystalUnit(farKeys[k]);
+	}
+	vector<string> againKeys = contacts.generateContactingUnits(5.0);
+	if (againKeys != keys || farKeys.size() <= keys.size()) {
+		cerr << "ERROR generating the contacting units again gave " << againKeys.size() << " units instead of " << keys.size() << " (" << farKeys.size() << " within 10 A)" << endl;
+	}
+	for (unsigned int k = 0; k < farKeys.size(); k++) {
+		if (find(keys.begin(), keys.end(), farKeys[k]) == keys.end() && contacts.getCrystalUnit(farKeys[k]) != NULL) {
+			cerr << "ERROR unit " << farKeys[k] << " of the previous call was not removed" << endl;
+			break;
+		}
+	}
 	
 	exit(1);	
 
@@ -380,3 +424,14 @@ void invert(Matrix &a,Matrix &in){
     	in[2][2]=(a[0][0]*a[1][1]-a[1][0]*a[0][1])/det;
 
 }
+
+bool inContact(AtomPointerVector * _first, AtomPointerVector * _second) {
+	for (unsigned int i = 0; i < _first->size(); i++) {
+		for (unsigned int j = 0; j < _second->size(); j++) {
+			if ((*_first)[i]->distance(*(*_second)[j]) <= 5.0) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
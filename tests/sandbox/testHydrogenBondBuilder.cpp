@@ -0,0 +1,185 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include <string>
+#include "SysEnv.h"
+#include "System.h"
+#include "PolymerSequence.h"
+#include "CharmmSystemBuilder.h"
+#include "HydrogenBondBuilder.h"
+#include "Transforms.h"
+#include "RandomNumberGenerator.h"
+
+using namespace MSL;
+using namespace std;
+
+static SysEnv SYSENV;
+
+/*******************************************************************
+ *  Builds a helix with two conformations: the ideal helix as the
+ *  second conformation and a shaken copy of it as the first.
+ *
+ *  The interactions built with a cutoff at the first conformation
+ *  must include every pair that is within the cutoff in any
+ *  combination of the conformations of the hydrogen and of the
+ *  acceptor (not only in the active one), so that switching to
+ *  the second conformation gives the same energy as the interactions
+ *  built without a cutoff.  Building at either conformation must give
+ *  the same interactions
+ *******************************************************************/
+
+double hbondEnergy(System & _sys) {
+	double energy = 0.0;
+	vector<Interaction*> & interactions = (*_sys.getEnergySet()->getEnergyTerms())["SCWRL4_HBOND"];
+	for (unsigned int i=0; i < interactions.size(); i++) {
+		energy += interactions[i]->getEnergy();
+	}
+	return energy;
+}
+
+void setConformation(AtomPointerVector & _atoms, unsigned int _conf) {
+	for (unsigned int i=0; i < _atoms.size(); i++) {
+		_atoms[i]->setActiveConformation(_conf);
+	}
+}
+
+int main() {
+
+	string topFile = SYSENV.getEnv("MSL_CHARMM_TOP");
+	string parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+	string hbondFile = SYSENV.getEnv("MSL_HBOND_CA_PAR");
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, topFile, parFile);
+	CSB.setBuildNonBondedInteractions(false);
+	if (!CSB.buildSystem(PolymerSequence("A: SER ASN GLU LYS ARG GLN THR TYR HSD ASP TRP SER GLU LYS ARG ASN GLN THR TYR ASP"))) {
+		cerr << "Cannot build the system with " << topFile << " " << parFile << endl;
+		exit(1);
+	}
+	if (!sys.seed("A 1 C", "A 1 CA", "A 1 N")) {
+		cerr << "Cannot seed atoms C, CA, N on residue 1 A" << endl;
+		exit(1);
+	}
+	sys.buildAllAtoms();
+
+	Transforms tr;
+	Chain & chain = sys.getChain("A");
+	for (unsigned int i=1; i < chain.positionSize(); i++) {
+		Residue & prev = chain.getResidue(i-1);
+		Residue & res = chain.getResidue(i);
+		tr.setDihedral(prev("C"), res("N"), res("CA"), res("C"), -57.0);
+		if (i+1 < chain.positionSize()) {
+			tr.setDihedral(res("N"), res("CA"), res("C"), chain.getResidue(i+1)("N"), -47.0);
+		}
+	}
+
+	// conformation 1 is the helix, conformation 0 is shaken
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	RandomNumberGenerator rng;
+	rng.setSeed(649);
+	for (unsigned int i=0; i < atoms.size(); i++) {
+		CartesianPoint helix = atoms[i]->getCoor();
+		atoms[i]->addAltConformation(helix);
+		atoms[i]->setActiveConformation(0);
+		CartesianPoint delta(rng.getRandomDouble(-2.0, 2.0), rng.getRandomDouble(-2.0, 2.0), rng.getRandomDouble(-2.0, 2.0));
+		atoms[i]->setCoor(helix + delta);
+	}
+
+	bool pass = true;
+	double cutoff = 3.0;
+	HydrogenBondBuilder hb(sys, hbondFile);
+
+	// all pairs, and the ones within the cutoff in each conformation
+	hb.buildInteractions(-1.0);
+	vector<Interaction*> & interactions = (*sys.getEnergySet()->getEnergyTerms())["SCWRL4_HBOND"];
+	unsigned int inRange = 0;
+	unsigned int onlyInHelix = 0;
+	unsigned int onlyInHelixBonded = 0;
+	for (unsigned int i=0; i < interactions.size(); i++) {
+		vector<Atom*> & pAtoms = interactions[i]->getAtomPointers();
+		// the hydrogen is the first atom, the acceptor the third
+		bool inRange0 = CartesianGeometry::distance(*pAtoms[0]->getAllCoor()[0], *pAtoms[2]->getAllCoor()[0]) <= cutoff;
+		bool inRange1 = CartesianGeometry::distance(*pAtoms[0]->getAllCoor()[1], *pAtoms[2]->getAllCoor()[1]) <= cutoff;
+		// the conformations of different positions are independent, so the mixed ones count too
+		bool inRangeMixed = CartesianGeometry::distance(*pAtoms[0]->getAllCoor()[0], *pAtoms[2]->getAllCoor()[1]) <= cutoff ||
+		                    CartesianGeometry::distance(*pAtoms[0]->getAllCoor()[1], *pAtoms[2]->getAllCoor()[0]) <= cutoff;
+		if (inRange0 || inRange1 || inRangeMixed) {
+			inRange++;
+		}
+		if (!inRange0 && inRange1) {
+			onlyInHelix++;
+			setConformation(atoms, 1);
+			if (interactions[i]->getEnergy() != 0.0) {
+				onlyInHelixBonded++;
+			}
+			setConformation(atoms, 0);
+		}
+	}
+	setConformation(atoms, 1);
+	double allEnergy = hbondEnergy(sys);
+	setConformation(atoms, 0);
+	cout << interactions.size() << " pairs, " << inRange << " within " << cutoff << " A in any conformation, " << onlyInHelix << " only in the helix (" << onlyInHelixBonded << " hydrogen bonded)" << endl;
+	if (onlyInHelixBonded == 0) {
+		cout << "NOT OK: no hydrogen bond is formed only in the second conformation" << endl;
+		pass = false;
+	}
+
+	// built at the shaken conformation, evaluated on the helix
+	hb.update(cutoff);
+	unsigned int built0 = interactions.size();
+	setConformation(atoms, 1);
+	double cutoffEnergy = hbondEnergy(sys);
+	cout << "Built at conformation 0: " << built0 << " interactions, helix energy " << cutoffEnergy << " (all pairs " << allEnergy << ")" << endl;
+	if (built0 != inRange) {
+		cout << "NOT OK: " << built0 << " interactions built at conformation 0, expected " << inRange << endl;
+		pass = false;
+	}
+	if (fabs(cutoffEnergy - allEnergy) > 1.0e-9) {
+		cout << "NOT OK: the helix energy with the cutoff " << cutoffEnergy << " differs from the one of all pairs " << allEnergy << endl;
+		pass = false;
+	}
+
+	// built at the helix, the same pairs
+	hb.update(cutoff);
+	unsigned int built1 = interactions.size();
+	double helixEnergy = hbondEnergy(sys);
+	cout << "Built at conformation 1: " << built1 << " interactions, helix energy " << helixEnergy << endl;
+	if (built1 != built0 || helixEnergy != cutoffEnergy) {
+		cout << "NOT OK: the interactions depend on the active conformation" << endl;
+		pass = false;
+	}
+
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,158 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include <string>
+#include "SysEnv.h"
+#include "System.h"
+#include "PolymerSequence.h"
+#include "CharmmSystemBuilder.h"
+#include "IcBuildPlanner.h"
+
+using namespace MSL;
+using namespace std;
+
+static SysEnv SYSENV;
+
+/*******************************************************************
+ *  Builds a two chain system with multiple identities with
+ *  System::buildAllAtoms and with the IcBuildPlanner, which must
+ *  give the same coordinates.  The plan must be reused when the
+ *  system is rebuilt and recompiled when an identity is changed.
+ *  The parallel placement (all levels, with OpenMP) must give the
+ *  same coordinates.
+ *******************************************************************/
+
+void seed(System & _sys) {
+	_sys.wipeAllCoordinates();
+	_sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	_sys.seed("B 1 C", "B 1 CA", "B 1 N");
+}
+
+bool compare(AtomPointerVector & _atoms, vector<CartesianPoint> & _coor, string _label) {
+	bool pass = true;
+	for (unsigned int i=0; i < _atoms.size(); i++) {
+		if (!_atoms[i]->hasCoor() || _atoms[i]->getCoor().distance(_coor[i]) > 1.0e-9) {
+			cout << "NOT OK: " << _label << ": atom " << _atoms[i]->getAtomId() << " " << _atoms[i]->getCoor() << " != " << _coor[i] << endl;
+			pass = false;
+		}
+	}
+	return pass;
+}
+
+int main() {
+
+	string topFile = SYSENV.getEnv("MSL_CHARMM_TOP");
+	string parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, topFile, parFile);
+	if (!CSB.buildSystem(PolymerSequence("A: ALA ILE [LEU PHE TRP] LYS VAL\nB: GLY [SER THR] ARG MET ASP"))) {
+		cerr << "Cannot build the system with " << topFile << " " << parFile << endl;
+		exit(1);
+	}
+	AtomPointerVector & allAtoms = sys.getAllAtomPointers();
+
+	// reference coordinates from the System
+	seed(sys);
+	sys.buildAllAtoms();
+	vector<CartesianPoint> reference;
+	for (unsigned int i=0; i < allAtoms.size(); i++) {
+		reference.push_back(allAtoms[i]->getCoor());
+	}
+
+	bool pass = true;
+
+	IcBuildPlanner planner(sys);
+	for (unsigned int i=0; i < 3; i++) {
+		seed(sys);
+		planner.buildAllAtoms();
+		pass = compare(allAtoms, reference, "build") && pass;
+	}
+	cout << "Built " << planner.getNumberOfBuilds() << " times with " << planner.getNumberOfCompilations() << " plans, " << planner.getNumberOfSteps() << " atoms in " << planner.getNumberOfLevels() << " levels (last plan)" << endl;
+	if (planner.getNumberOfCompilations() != 2) {
+		cout << "NOT OK: the plans were not reused" << endl;
+		pass = false;
+	}
+
+	// change an identity, the plan for the active atoms must be recompiled
+	sys.getPosition("A,3").setActiveIdentity("PHE");
+	seed(sys);
+	sys.buildAllAtoms();
+	reference.clear();
+	for (unsigned int i=0; i < allAtoms.size(); i++) {
+		reference.push_back(allAtoms[i]->getCoor());
+	}
+	seed(sys);
+	planner.buildAllAtoms();
+	pass = compare(allAtoms, reference, "identity change") && pass;
+	if (planner.getNumberOfCompilations() != 4) {
+		cout << "NOT OK: the plans were not recompiled after an identity change" << endl;
+		pass = false;
+	}
+	// place every level on multiple threads
+	IcBuildPlanner parallelPlanner(sys);
+	parallelPlanner.setNumThreads(4);
+	parallelPlanner.setParallelThreshold(0);
+	for (unsigned int i=0; i < 2; i++) {
+		seed(sys);
+		parallelPlanner.buildAllAtoms();
+		pass = compare(allAtoms, reference, "parallel build") && pass;
+	}
+	sys.getPosition("B,2").setActiveIdentity("THR");
+	seed(sys);
+	sys.buildAllAtoms();
+	reference.clear();
+	for (unsigned int i=0; i < allAtoms.size(); i++) {
+		reference.push_back(allAtoms[i]->getCoor());
+	}
+	seed(sys);
+	parallelPlanner.buildAllAtoms();
+	pass = compare(allAtoms, reference, "parallel identity change") && pass;
+	AtomPointerVector & activeAtoms = sys.getAtomPointers();
+	seed(sys);
+	sys.buildAtoms();
+	reference.clear();
+	for (unsigned int i=0; i < activeAtoms.size(); i++) {
+		reference.push_back(activeAtoms[i]->getCoor());
+	}
+	seed(sys);
+	parallelPlanner.buildAtoms();
+	pass = compare(activeAtoms, reference, "parallel active build") && pass;
+	cout << "Built on " << parallelPlanner.getNumThreads() << " thread(s) with parallel threshold " << parallelPlanner.getParallelThreshold() << endl;
+
+	cout << "Checking " << planner.getCheckingTime() << " s, planning " << planner.getPlanningTime() << " s, placing " << planner.getPlacingTime() << " s" << endl;
+
+	if (pass) {
+		cout << "IC build planner OK" << endl;
+	} else {
+		cout << "IC build planner NOT OK" << endl;
+	}
+
+	return 0;
+}
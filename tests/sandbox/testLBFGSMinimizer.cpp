@@ -0,0 +1,155 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include <string>
+#include "SysEnv.h"
+#include "System.h"
+#include "PolymerSequence.h"
+#include "CharmmSystemBuilder.h"
+#include "AtomSelection.h"
+#include "RandomNumberGenerator.h"
+#include "LBFGSMinimizer.h"
+#include "TorsionMinimizer.h"
+
+using namespace MSL;
+using namespace std;
+
+static SysEnv SYSENV;
+
+/*******************************************************************
+ *  Builds a small peptide, shakes the coordinates and relaxes them
+ *  with the L-BFGS minimizer: once with all atoms free and once
+ *  with the backbone fixed and the CB atoms on springs. Finally
+ *  the built peptide is relaxed in torsion space, which must not
+ *  change bond lengths and angles.
+ *******************************************************************/
+
+void shake(AtomPointerVector & _atoms, RandomNumberGenerator & _rng, double _amplitude) {
+	for (unsigned int i=0; i < _atoms.size(); i++) {
+		CartesianPoint delta(_rng.getRandomDouble(-_amplitude, _amplitude), _rng.getRandomDouble(-_amplitude, _amplitude), _rng.getRandomDouble(-_amplitude, _amplitude));
+		_atoms[i]->setCoor(_atoms[i]->getCoor() + delta);
+	}
+}
+
+int main() {
+
+	string topFile = SYSENV.getEnv("MSL_CHARMM_TOP");
+	string parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, topFile, parFile);
+	CSB.setBuildNonBondedInteractions(true);
+	if (!CSB.buildSystem(PolymerSequence("A: ALA ILE LEU PHE VAL TRP"))) {
+		cerr << "Cannot build the system with " << topFile << " " << parFile << endl;
+		exit(1);
+	}
+	if (!sys.seed("A 1 C", "A 1 CA", "A 1 N")) {
+		cerr << "Cannot seed atoms C, CA, N on residue 1 A" << endl;
+		exit(1);
+	}
+	sys.buildAtoms();
+
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	atoms.saveCoor("built");
+
+	RandomNumberGenerator rng;
+	rng.setSeed(513);
+	shake(atoms, rng, 0.3);
+	atoms.saveCoor("shaken");
+
+	bool pass = true;
+
+	// 1) all atoms free
+	LBFGSMinimizer min(sys);
+	min.setMaxIterations(5000);
+	min.minimize();
+	cout << "All atoms free: " << min.getInitialEnergy() << " -> " << min.getMinimizedEnergy() << " in " << min.getNumberOfIterations() << " iterations (converged " << min.getConverged() << ")" << endl;
+	if (min.getMinimizedEnergy() >= min.getInitialEnergy() || !min.getConverged()) {
+		cout << "NOT OK: the energy was not minimized" << endl;
+		pass = false;
+	}
+
+	// 2) backbone fixed, CB restrained
+	atoms.applySavedCoor("shaken");
+	LBFGSMinimizer minFixed(sys);
+	minFixed.fixAtoms("name N or name CA or name C or name O");
+	minFixed.setConstraintForce("name CB", 10.0);
+	AtomSelection sel(atoms);
+	AtomPointerVector backbone = sel.select("bb, name N or name CA or name C or name O");
+	vector<CartesianPoint> before;
+	for (unsigned int i=0; i < backbone.size(); i++) {
+		before.push_back(backbone[i]->getCoor());
+	}
+	minFixed.minimize();
+	minFixed.removeConstraints();
+	cout << "Backbone fixed: " << minFixed.getInitialEnergy() << " -> " << minFixed.getMinimizedEnergy() << " in " << minFixed.getNumberOfIterations() << " iterations" << endl;
+	if (minFixed.getMinimizedEnergy() >= minFixed.getInitialEnergy()) {
+		cout << "NOT OK: the energy was not minimized" << endl;
+		pass = false;
+	}
+	for (unsigned int i=0; i < backbone.size(); i++) {
+		if (before[i].distance(backbone[i]->getCoor()) != 0.0) {
+			cout << "NOT OK: fixed atom " << backbone[i]->getAtomId() << " moved" << endl;
+			pass = false;
+		}
+	}
+
+	// 3) side chain torsions only
+	atoms.applySavedCoor("built");
+	EnergySet * pEset = sys.getEnergySet();
+	pEset->setAllTermsInactive();
+	pEset->setTermActive("CHARMM_BOND", true);
+	pEset->setTermActive("CHARMM_ANGL", true);
+	double geometryEnergy = pEset->calcEnergy();
+	pEset->setAllTermsActive();
+
+	TorsionMinimizer minTorsion(sys);
+	minTorsion.minimize();
+	cout << "Torsion space: " << minTorsion.getInitialEnergy() << " -> " << minTorsion.getMinimizedEnergy() << " in " << minTorsion.getNumberOfIterations() << " iterations over " << minTorsion.getNumberOfTorsions() << " torsions" << endl;
+	if (minTorsion.getMinimizedEnergy() >= minTorsion.getInitialEnergy() || !minTorsion.getConverged()) {
+		cout << "NOT OK: the energy was not minimized in torsion space" << endl;
+		pass = false;
+	}
+	pEset->setAllTermsInactive();
+	pEset->setTermActive("CHARMM_BOND", true);
+	pEset->setTermActive("CHARMM_ANGL", true);
+	if (fabs(pEset->calcEnergy() - geometryEnergy) > 1.0e-6) {
+		cout << "NOT OK: the torsion minimization changed bonds or angles" << endl;
+		pass = false;
+	}
+	pEset->setAllTermsActive();
+
+	if (pass) {
+		cout << "L-BFGS minimization OK" << endl;
+	} else {
+		cout << "L-BFGS minimization NOT OK" << endl;
+	}
+
+	return 0;
+}
@@ -28,56 +28,184 @@ You should have received a copy of the GNU Lesser General Public
 */
 #include "testData.h"
 #include "PDBFragments.h"
-#include "PDBWriter.h"
+#include "OptimalRMSDCalculator.h"
+#include "Transforms.h"
 
 using namespace MSL;
 using namespace std;
 
+/*******************************************************************
+ *  Builds a CA-only fragment database from two copies of a four
+ *  helix bundle and searches it with a perturbed helical window.
+ *
+ *  The hits are checked against a plain serial scan of the database
+ *  (the search before the threads and the structure cache), and the
+ *  search is repeated with one and with all threads and with a
+ *  structure cache of one structure, that must give the same hits
+ *  and the same coordinates
+ *******************************************************************/
+
+struct SearchResult {
+	vector<string> labels;
+	vector<vector<double> > coordinates;
+};
+
+void runSearch(PDBFragments & _fragDB, System & _query, string _start, string _end, double _tol, SearchResult & _result) {
+	_result.labels.clear();
+	_result.coordinates.clear();
+	int numFrags = _fragDB.searchForMatchingFragmentsLinear(_query, _start, _end, "", _tol);
+	vector<AtomContainer*> & results = _fragDB.getAtomContainers();
+	for (int i=0; i < numFrags; i++) {
+		AtomPointerVector & atoms = results[i]->getAtomPointers();
+		_result.labels.push_back(atoms[0]->getChainId() + "_" + MslTools::intToString(atoms[0]->getResidueNumber()));
+		vector<double> coor;
+		for (unsigned int j=0; j < atoms.size(); j++) {
+			coor.push_back(atoms[j]->getX());
+			coor.push_back(atoms[j]->getY());
+			coor.push_back(atoms[j]->getZ());
+		}
+		_result.coordinates.push_back(coor);
+	}
+}
 
+bool sameResults(const SearchResult & _a, const SearchResult & _b, string _label) {
+	if (_a.labels != _b.labels || _a.coordinates != _b.coordinates) {
+		cout << "NOT OK: the search with " << _label << " gives different hits or coordinates (" << _a.labels.size() << " vs " << _b.labels.size() << " hits)" << endl;
+		return false;
+	}
+	cout << "Same " << _a.labels.size() << " hits with " << _label << endl;
+	return true;
+}
 
 int main(){
 
-	// Write some PDBs
-	writePdbFile();
-
-	System pdb;
-	pdb.readPdb("/tmp/xtalLattice.pdb");
+	bool pass = true;
 
-	cout << "Read in fragDB"<<endl;
-	//PDBFragments fragDB("/home/dwkulp/pdbs/out2.fragdb");
-	PDBFragments fragDB("/home/dwkulp/software/mslib/trunk/nr1000.fragdb","");
-	fragDB.loadFragmentDatabase();
+	string pdbDir = "/tmp";
+	string segIds[2] = {"fragTest4HB", "fragTest4HBcopy"};
+	for (unsigned int s=0; s < 2; s++) {
+		writeString(fourHelixBundle, pdbDir + "/" + segIds[s] + ".pdb");
+	}
 
-	//fragDB.printMe();
+	// the CA-only database, one segid per structure
+	System bundle;
+	bundle.readPdb(pdbDir + "/" + segIds[0] + ".pdb");
+	AtomPointerVector db;
+	for (unsigned int s=0; s < 2; s++) {
+		for (unsigned int i=0; i < bundle.getAtomPointers().size(); i++) {
+			if (bundle.getAtomPointers()[i]->getName() == "CA") {
+				Atom * pAtom = new Atom(*bundle.getAtomPointers()[i]);
+				pAtom->setSegID(segIds[s]);
+				db.push_back(pAtom);
+			}
+		}
+	}
+	db.setName("ca-only");
+	string dbFile = "/tmp/fragTest.fragdb";
+	db.save_checkpoint(dbFile);
+
+	// the query, a helical window moved off the database coordinates
+	System query;
+	query.readPdb(pdbDir + "/" + segIds[0] + ".pdb");
+	string start = "A,10";
+	string end = "A,16";
+	double tol = 0.8;
+	AtomPointerVector queryCA;
+	for (unsigned int i=query.getPositionIndex(start); i <= query.getPositionIndex(end); i++) {
+		Atom & ca = query.getPosition(i).getAtom("CA");
+		ca.setCoor(ca.getX() + 0.1 * sin(i), ca.getY() + 0.1 * cos(i), ca.getZ() + 5.0);
+		queryCA.push_back(&ca);
+	}
 
-	vector<int> stems;
-	stems.push_back(16);
-	stems.push_back(17);
-	stems.push_back(21);
-	stems.push_back(22);
+	// the reference, a serial scan of the database
+	SearchResult reference;
+	OptimalRMSDCalculator rmsdCalc;
+	Transforms tm;
+	unsigned int separation = queryCA.size() - 1;
+	for (unsigned int i=0; i + separation < db.size(); i++) {
+		if (db[i]->getSegID() != db[i+separation]->getSegID() || db[i]->getChainId() != db[i+separation]->getChainId()) {
+			continue;
+		}
+		AtomPointerVector window;
+		for (unsigned int j=0; j <= separation; j++) {
+			window.push_back(db[i+j]);
+		}
+		bool success = false;
+		double rmsd = rmsdCalc.bestRMSD(window, queryCA, &success);
+		if (!success || rmsd > tol) {
+			continue;
+		}
+		reference.labels.push_back(db[i]->getChainId() + "_" + MslTools::intToString(db[i]->getResidueNumber()));
+		// the CA of the window after the superposition
+		AtomPointerVector copies;
+		for (unsigned int j=0; j <= separation; j++) {
+			copies.push_back(new Atom(*db[i+j]));
+		}
+		tm.rmsdAlignment(window, queryCA, copies);
+		vector<double> coor;
+		for (unsigned int j=0; j < copies.size(); j++) {
+			coor.push_back(copies[j]->getX());
+			coor.push_back(copies[j]->getY());
+			coor.push_back(copies[j]->getZ());
+		}
+		reference.coordinates.push_back(coor);
+		copies.deletePointers();
+	}
+	cout << "Serial scan: " << reference.labels.size() << " hits" << endl;
+	if (reference.labels.size() == 0) {
+		cout << "NOT OK: the serial scan found no hits" << endl;
+		pass = false;
+	}
 
-	int numFrags = fragDB.searchForMatchingFragments(pdb.getChain("A"),stems);
-	cout << "DONE SEARCHING!"<<endl;
-	System frags;
-	frags.addAtoms(fragDB.getAtomPointers());
+	// CA-only results (no pdbDir), must match the reference
+	PDBFragments fragDB(dbFile, "");
+	fragDB.loadFragmentDatabase();
+	fragDB.setNumThreads(1);
+	SearchResult caOnly;
+	runSearch(fragDB, query, start, end, tol, caOnly);
+	pass = sameResults(reference, caOnly, "the CA-only database, 1 thread") && pass;
+	fragDB.setNumThreads(0);
+	runSearch(fragDB, query, start, end, tol, caOnly);
+	pass = sameResults(reference, caOnly, "the CA-only database, all threads") && pass;
+
+	// all-atom results from pdbDir, through the structure cache
+	fragDB.setPdbDir(pdbDir);
+	fragDB.setNumThreads(1);
+	SearchResult allAtoms;
+	runSearch(fragDB, query, start, end, tol, allAtoms);
+	if (allAtoms.labels != reference.labels) {
+		cout << "NOT OK: the all-atom search gives different hits than the serial scan" << endl;
+		pass = false;
+	}
+	for (unsigned int i=0; i < allAtoms.coordinates.size() && i < reference.coordinates.size(); i++) {
+		// every residue has N CA C O first, the CA of residue j is atom 1 of the residue
+		if (allAtoms.coordinates[i].size() < 6 || fabs(allAtoms.coordinates[i][3] - reference.coordinates[i][0]) > 1.0e-8 || fabs(allAtoms.coordinates[i][4] - reference.coordinates[i][1]) > 1.0e-8 || fabs(allAtoms.coordinates[i][5] - reference.coordinates[i][2]) > 1.0e-8) {
+			cout << "NOT OK: the all-atom hit " << allAtoms.labels[i] << " is not superimposed as the serial scan" << endl;
+			pass = false;
+			break;
+		}
+	}
 
-	fprintf(stdout, "SYSTEM SIZE: %d\n",frags.chainSize());
+	SearchResult other;
+	fragDB.setNumThreads(0);
+	runSearch(fragDB, query, start, end, tol, other);
+	pass = sameResults(allAtoms, other, "the all-atom structures, all threads") && pass;
 
-	AtomPointerVector &fragAts = frags.getAtomPointers();
-	
-	PDBWriter pout;
+	fragDB.setStructureCacheSize(1);
+	runSearch(fragDB, query, start, end, tol, other);
+	pass = sameResults(allAtoms, other, "a cache of one structure") && pass;
 
+	fragDB.clearStructureCache();
+	fragDB.setStructureCacheSize(50);
+	runSearch(fragDB, query, start, end, tol, other);
+	pass = sameResults(allAtoms, other, "a cleared cache") && pass;
 
-	for (uint i = 0; i < numFrags;i++){
-		for (uint a = 0; a < fragAts.size();a++){
-			fragAts(a).setActiveConformation(i);
-		}
+	db.deletePointers();
 
-		char fname[100];
-		sprintf(fname,"/tmp/frag-%06d.pdb",i);
-		pout.open(fname);
-		pout.write(fragAts);
-		pout.close();		
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
 	}
-	
+	return 0;
 }
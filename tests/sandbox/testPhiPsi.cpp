@@ -29,10 +29,13 @@ You should have received a copy of the GNU Lesser General Public
 
 
 #include "PhiPsiReader.h"
+#include "PhiPsiWriter.h"
 #include "PhiPsiStatistics.h"
 #include "PDBReader.h"
 #include "System.h"
 #include "testData.h"
+#include <fstream>
+#include <sstream>
 
 
 using namespace std;
@@ -56,6 +59,77 @@ int main(){
 	ppr.read();
 	ppr.close();
 
+	// Save the compiled tables in binary form and read them back
+	PhiPsiWriter ppw;
+	ppw.writeBinary(ppr.getPhiPsiStatistics(), "/tmp/phiPsiCounts.bin");
+	PhiPsiReader pprBin("/tmp/phiPsiCounts.bin");
+	pprBin.open();
+	bool binaryRead = pprBin.read();
+	pprBin.close();
+	if (binaryRead && pprBin.getPhiPsiStatistics().getPhiPsiCounts() == ppr.getPhiPsiStatistics().getPhiPsiCounts() && pprBin.getPhiPsiStatistics().getGridSize() == ppr.getPhiPsiStatistics().getGridSize()) {
+		MSLOUT.stream() << "Binary phi/psi table round trip OK"<<endl;
+	} else {
+		MSLOUT.stream() << "Binary phi/psi table round trip NOT OK"<<endl;
+	}
+
+	// The binary tables give the same lookups and the same random samples of the text ones
+	PhiPsiStatistics & ppsText = ppr.getPhiPsiStatistics();
+	PhiPsiStatistics & ppsBin = pprBin.getPhiPsiStatistics();
+	map<string,int> textCounts = ppsText.getPhiPsiCounts();
+	vector<string> residueTypes;
+	for (map<string,int>::iterator c = textCounts.begin(); c != textCounts.end(); c++) {
+		if (c->first.find(':') == string::npos) {
+			residueTypes.push_back(c->first);
+		}
+	}
+	bool sameLookups = binaryRead && residueTypes.size() > 0;
+	for (uint r = 0; r < residueTypes.size() && sameLookups; r++) {
+		for (double phi = -180.0; phi < 180.0 && sameLookups; phi += 5.0) {
+			for (double psi = -180.0; psi < 180.0; psi += 5.0) {
+				if (ppsText.getProbability(residueTypes[r], phi, psi) != ppsBin.getProbability(residueTypes[r], phi, psi) || ppsText.getPropensity(residueTypes[r], phi, psi) != ppsBin.getPropensity(residueTypes[r], phi, psi)) {
+					MSLOUT.stream() << "NOT OK: the binary table gives a different probability or propensity for " << residueTypes[r] << " at " << phi << " " << psi << endl;
+					sameLookups = false;
+					break;
+				}
+			}
+		}
+		// private streams, so the two samplers do not share the global rand()
+		ppsText.getRandomNumberGenerator().setSeed(1234, r);
+		ppsBin.getRandomNumberGenerator().setSeed(1234, r);
+		for (uint i = 0; i < 100 && sameLookups; i++) {
+			if (ppsText.getRandomPhiPsi(residueTypes[r]) != ppsBin.getRandomPhiPsi(residueTypes[r])) {
+				MSLOUT.stream() << "NOT OK: the binary table gives a different random phi/psi for " << residueTypes[r] << endl;
+				sameLookups = false;
+			}
+		}
+	}
+
+	// A truncated binary table (of a different table, missing its last count)
+	// is rejected and leaves the statistics unchanged
+	PhiPsiStatistics ppsOther;
+	ppsOther.addStatisitics("ALA", "-65","-45",7);
+	ppsOther.addStatisitics("GLY", "85","5",3);
+	ppsOther.computeTotalCounts();
+	ppw.writeBinary(ppsOther, "/tmp/phiPsiOther.bin");
+	ifstream binIn("/tmp/phiPsiOther.bin", ios::binary);
+	stringstream binData;
+	binData << binIn.rdbuf();
+	binIn.close();
+	ofstream truncOut("/tmp/phiPsiCounts.trunc.bin", ios::binary);
+	truncOut << binData.str().substr(0, binData.str().size() - sizeof(int));
+	truncOut.close();
+	string ala = "ALA";
+	double alaProbability = ppsBin.getProbability(ala, -60.0, -45.0);
+	if (pprBin.readBinary("/tmp/phiPsiCounts.trunc.bin") || ppsBin.getPhiPsiCounts() != textCounts || ppsBin.getProbability(ala, -60.0, -45.0) != alaProbability) {
+		MSLOUT.stream() << "NOT OK: the truncated binary table changed the statistics" << endl;
+		sameLookups = false;
+	}
+	if (sameLookups) {
+		MSLOUT.stream() << "LEAD OK" << endl;
+	} else {
+		MSLOUT.stream() << "LEAD NOT OK" << endl;
+	}
+
 	MSLOUT.stream() << "Read a string pdb 'fourHelixBundle'"<<endl;
 	writePdbFile();
 
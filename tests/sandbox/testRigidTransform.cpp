@@ -0,0 +1,299 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include <iostream>
+#include <cstdlib>
+
+#include "SysEnv.h"
+#include "System.h"
+#include "PolymerSequence.h"
+#include "CharmmSystemBuilder.h"
+#include "CartesianGeometry.h"
+#include "RigidTransform.h"
+#include "Transforms.h"
+#include "AtomSelection.h"
+
+using namespace std;
+using namespace MSL;
+
+static SysEnv SYSENV;
+
+/*******************************************************************
+ *  The RigidTransform kernels and the Transforms functions that use
+ *  them must give coordinates identical (bit for bit) to the
+ *  CartesianPoint operators that were used before:
+ *     p -= center;  p *= rotation;  p += center;  p += translation;
+ *******************************************************************/
+
+double randomDouble(double _min, double _max) {
+	return _min + (_max - _min) * (double)rand() / (double)RAND_MAX;
+}
+
+CartesianPoint randomPoint(double _range) {
+	return CartesianPoint(randomDouble(-_range, _range), randomDouble(-_range, _range), randomDouble(-_range, _range));
+}
+
+bool samePoint(const CartesianPoint & _p1, const CartesianPoint & _p2) {
+	return _p1.getX() == _p2.getX() && _p1.getY() == _p2.getY() && _p1.getZ() == _p2.getZ();
+}
+
+// the old per-point operations
+void oldTransform(CartesianPoint & _p, const Matrix & _rotation, const CartesianPoint & _center, const CartesianPoint & _translation) {
+	_p -= _center;
+	_p *= _rotation;
+	_p += _center;
+	_p += _translation;
+}
+
+void oldRotate(AtomPointerVector & _atoms, const Matrix & _rotation, const CartesianPoint & _center) {
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		vector<CartesianPoint*> & coor = _atoms[i]->getAllCoor();
+		for (unsigned int j=0; j<coor.size(); j++) {
+			*coor[j] -= _center;
+			*coor[j] *= _rotation;
+			*coor[j] += _center;
+		}
+	}
+}
+
+void oldTranslate(AtomPointerVector & _atoms, const CartesianPoint & _translation) {
+	for (unsigned int i=0; i<_atoms.size(); i++) {
+		vector<CartesianPoint*> & coor = _atoms[i]->getAllCoor();
+		for (unsigned int j=0; j<coor.size(); j++) {
+			*coor[j] += _translation;
+		}
+	}
+}
+
+bool sameAtoms(AtomPointerVector & _atoms1, AtomPointerVector & _atoms2, string _label) {
+	for (unsigned int i=0; i<_atoms1.size(); i++) {
+		vector<CartesianPoint*> & coor1 = _atoms1[i]->getAllCoor();
+		vector<CartesianPoint*> & coor2 = _atoms2[i]->getAllCoor();
+		if (coor1.size() != coor2.size()) {
+			cout << "NOT OK: " << _label << ": different number of conformations for " << _atoms1[i]->getAtomId() << endl;
+			return false;
+		}
+		for (unsigned int j=0; j<coor1.size(); j++) {
+			if (!samePoint(*coor1[j], *coor2[j])) {
+				cout << "NOT OK: " << _label << ": atom " << _atoms1[i]->getAtomId() << " conformation " << j << " " << *coor1[j] << " != " << *coor2[j] << endl;
+				return false;
+			}
+		}
+	}
+	cout << _label << ": same coordinates" << endl;
+	return true;
+}
+
+bool kernels() {
+	bool pass = true;
+	vector<CartesianPoint> points;
+	for (unsigned int i=0; i<200; i++) {
+		points.push_back(randomPoint(50.0));
+	}
+	for (unsigned int t=0; t<30; t++) {
+		Matrix m = CartesianGeometry::getRotationMatrix(randomDouble(-180.0, 180.0), randomPoint(1.0));
+		CartesianPoint center = randomPoint(20.0);
+		// some of the transforms are pure rotations, translations or the identity
+		CartesianPoint translation = t % 3 == 0 ? CartesianPoint(0.0, 0.0, 0.0) : randomPoint(10.0);
+		RigidTransform rt;
+		if (t % 5 != 0) {
+			rt.setRotation(m, center);
+		} else {
+			m = Matrix(3, 3, 0.0);
+			m[0][0] = m[1][1] = m[2][2] = 1.0;
+			center = CartesianPoint(0.0, 0.0, 0.0);
+		}
+		if (t % 3 != 0) {
+			rt.setTranslation(translation);
+		}
+
+		vector<CartesianPoint> reference = points;
+		vector<CartesianPoint> single = points;
+		vector<CartesianPoint> copies;
+		vector<CartesianPoint> list = points;
+		vector<CartesianPoint*> pointers;
+		vector<double> packed;
+		for (unsigned int i=0; i<points.size(); i++) {
+			oldTransform(reference[i], m, center, translation);
+			rt.apply(single[i]);
+			copies.push_back(rt.transform(points[i]));
+			pointers.push_back(&list[i]);
+			packed.push_back(points[i].getX());
+			packed.push_back(points[i].getY());
+			packed.push_back(points[i].getZ());
+		}
+		rt.apply(pointers);
+		rt.apply(&packed[0], points.size());
+		for (unsigned int i=0; i<points.size(); i++) {
+			CartesianPoint p(packed[3*i], packed[3*i+1], packed[3*i+2]);
+			if (!samePoint(reference[i], single[i]) || !samePoint(reference[i], copies[i]) || !samePoint(reference[i], list[i]) || !samePoint(reference[i], p)) {
+				cout << "NOT OK: kernels differ from the CartesianPoint operators in transform " << t << " point " << i << endl;
+				pass = false;
+				break;
+			}
+		}
+	}
+	// a matrix that is not 3x3 is rejected and the transform is unchanged
+	RigidTransform rt;
+	cout << "Setting a 2x2 rotation (an error is expected)" << endl;
+	if (rt.setRotation(Matrix(2, 2, 1.0)) || !rt.isIdentity()) {
+		cout << "NOT OK: a 2x2 rotation matrix was accepted" << endl;
+		pass = false;
+	}
+	if (pass) {
+		cout << "Kernels: same coordinates" << endl;
+	}
+	return pass;
+}
+
+bool transforms(string _topFile, string _parFile) {
+	bool pass = true;
+	string sequence = "A: ALA LEU PHE LYS TRP ILE";
+	System sysNew;
+	System sysOld;
+	CharmmSystemBuilder CSBnew(sysNew, _topFile, _parFile);
+	CharmmSystemBuilder CSBold(sysOld, _topFile, _parFile);
+	if (!CSBnew.buildSystem(PolymerSequence(sequence)) || !CSBold.buildSystem(PolymerSequence(sequence))) {
+		cerr << "Cannot build the system with " << _topFile << " " << _parFile << endl;
+		exit(1);
+	}
+	sysNew.seed("A 1 C", "A 1 CA", "A 1 N");
+	sysNew.buildAllAtoms();
+	sysOld.seed("A 1 C", "A 1 CA", "A 1 N");
+	sysOld.buildAllAtoms();
+	AtomPointerVector & atomsNew = sysNew.getAllAtomPointers();
+	AtomPointerVector & atomsOld = sysOld.getAllAtomPointers();
+	// alternative conformations, all of them are moved
+	for (unsigned int i=0; i<atomsNew.size(); i+=5) {
+		CartesianPoint shift(0.3, -0.2, 0.1);
+		atomsNew[i]->addAltConformation(atomsNew[i]->getCoor() + shift);
+		atomsOld[i]->addAltConformation(atomsOld[i]->getCoor() + shift);
+	}
+	Transforms tr;
+	CartesianPoint zero(0.0, 0.0, 0.0);
+
+	CartesianPoint translation(1.3, -2.7, 0.4);
+	tr.translate(atomsNew, translation);
+	oldTranslate(atomsOld, translation);
+	pass = sameAtoms(atomsNew, atomsOld, "translate") && pass;
+
+	tr.Xrotate(atomsNew, 37.0);
+	oldRotate(atomsOld, CartesianGeometry::getXRotationMatrix(37.0), zero);
+	pass = sameAtoms(atomsNew, atomsOld, "Xrotate") && pass;
+
+	CartesianPoint axis(2.0, -1.0, 3.5);
+	CartesianPoint center(-4.0, 1.5, 2.0);
+	tr.rotate(atomsNew, 71.3, axis, center);
+	oldRotate(atomsOld, CartesianGeometry::getRotationMatrix(71.3, axis - center), center);
+	pass = sameAtoms(atomsNew, atomsOld, "rotate") && pass;
+
+	CartesianPoint reference(3.0, 4.0, -1.0);
+	CartesianPoint target(-2.0, 5.0, 1.0);
+	if (!tr.align(atomsNew, reference, target, center)) {
+		cout << "NOT OK: align failed" << endl;
+		pass = false;
+	}
+	oldRotate(atomsOld, tr.getLastRotationMatrix(), center);
+	pass = sameAtoms(atomsNew, atomsOld, "align") && pass;
+
+	CartesianPoint axis2(1.0, 7.0, -2.0);
+	if (!tr.orient(atomsNew, reference, target, center, axis2)) {
+		cout << "NOT OK: orient failed" << endl;
+		pass = false;
+	}
+	oldRotate(atomsOld, tr.getLastRotationMatrix(), center);
+	pass = sameAtoms(atomsNew, atomsOld, "orient") && pass;
+
+#ifdef __GSL__
+	// superimpose the backbone onto the untransformed system
+	System sysRef;
+	CharmmSystemBuilder CSBref(sysRef, _topFile, _parFile);
+	CSBref.buildSystem(PolymerSequence(sequence));
+	sysRef.seed("A 1 C", "A 1 CA", "A 1 N");
+	sysRef.buildAllAtoms();
+	AtomPointerVector & atomsRef = sysRef.getAllAtomPointers();
+	AtomSelection selNew(atomsNew);
+	AtomSelection selOld(atomsOld);
+	AtomSelection selRef(atomsRef);
+	AtomPointerVector alignNew = selNew.select("bb, name N+CA+C");
+	AtomPointerVector alignOld = selOld.select("bb, name N+CA+C");
+	AtomPointerVector alignRef = selRef.select("bb, name N+CA+C");
+	CartesianPoint GC1 = alignRef.getGeometricCenter();
+	CartesianPoint GC2 = alignOld.getGeometricCenter();
+	if (!tr.rmsdAlignment(alignNew, alignRef, atomsNew)) {
+		cout << "NOT OK: rmsdAlignment failed" << endl;
+		pass = false;
+	}
+	oldTranslate(atomsOld, GC1 - GC2);
+	oldRotate(atomsOld, tr.getLastRotationMatrix().getTranspose(), GC1);
+	pass = sameAtoms(atomsNew, atomsOld, "rmsdAlignment") && pass;
+#endif
+
+	// set a side chain dihedral, only the linked atoms move
+	Atom & a1 = sysNew.getAtom("A,2,N");
+	Atom & a2 = sysNew.getAtom("A,2,CA");
+	Atom & a3 = sysNew.getAtom("A,2,CB");
+	Atom & a4 = sysNew.getAtom("A,2,CG");
+	Atom & o1 = sysOld.getAtom("A,2,N");
+	Atom & o2 = sysOld.getAtom("A,2,CA");
+	Atom & o3 = sysOld.getAtom("A,2,CB");
+	Atom & o4 = sysOld.getAtom("A,2,CG");
+	double current = o1.dihedral(o2, o3, o4);
+	set<Atom*> exclude;
+	exclude.insert(&o1);
+	exclude.insert(&o2);
+	exclude.insert(&o3);
+	set<Atom*> moving = o4.findLinkedAtoms(exclude);
+	moving.insert(&o4);
+	AtomPointerVector movingOld;
+	for (set<Atom*>::iterator k=moving.begin(); k!=moving.end(); k++) {
+		movingOld.push_back(*k);
+	}
+	oldRotate(movingOld, CartesianGeometry::getRotationMatrix(-60.0 - current, o3.getCoor() - o2.getCoor()), o2.getCoor());
+	tr.setDihedral(a1, a2, a3, a4, -60.0, true);
+	pass = sameAtoms(atomsNew, atomsOld, "setDihedral") && pass;
+
+	return pass;
+}
+
+int main() {
+	srand(1234);
+	string topFile = SYSENV.getEnv("MSL_CHARMM_TOP");
+	string parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+
+	bool pass = kernels();
+	pass = transforms(topFile, parFile) && pass;
+
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
+	return 0;
+}
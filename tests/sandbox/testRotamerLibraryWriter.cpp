@@ -28,6 +28,7 @@ You should have received a copy of the GNU Lesser General Public
 */
 
 #include <iostream>
+#include <fstream>
 
 #include "RotamerLibraryReader.h"
 #include "RotamerLibraryWriter.h"
@@ -36,11 +37,214 @@ using namespace std;
 
 using namespace MSL;
 
+string textLibrary = "\
+LEVRES SER CYS\n\
+LEVEL SL-LOW 2 1\n\
+LEVEL SL-HIGH 3 2\n\
+LIBRARY TEST\n\
+RESI SER\n\
+MOBI CB HB1 HB2 OG HG\n\
+DEFI N C *CA CB\n\
+DEFI C CA CB\n\
+DEFI CA CB\n\
+DEFI OG CA *CB HB1\n\
+DEFI CA CB HB1\n\
+DEFI CB HB1\n\
+DEFI OG CA *CB HB2\n\
+DEFI CA CB HB2\n\
+DEFI CB HB2\n\
+DEFI N CA CB OG\n\
+DEFI CA CB OG\n\
+DEFI CB OG\n\
+DEFI CA CB OG HG\n\
+DEFI CB OG HG\n\
+DEFI OG HG\n\
+CONF -122.60 111.10 1.53 -117.00 109.50 1.11 117.00 109.50 1.11 62.30 110.80 1.41 180.00 109.50 0.96 1\n\
+CONF -122.61 110.97 1.53 -117.00 109.50 1.11 117.00 109.50 1.11 -65.10 111.20 1.42 60.00 109.50 0.96 2\n\
+CONF -122.62 111.03 1.53 -117.00 109.50 1.11 117.00 109.50 1.11 177.30 110.90 1.41 -60.00 109.50 0.96 3\n\
+RESI CYS\n\
+MOBI CB HB1 HB2 SG HG\n\
+DEFI N C *CA CB\n\
+DEFI C CA CB\n\
+DEFI CA CB\n\
+DEFI SG CA *CB HB1\n\
+DEFI CA CB HB1\n\
+DEFI CB HB1\n\
+DEFI SG CA *CB HB2\n\
+DEFI CA CB HB2\n\
+DEFI CB HB2\n\
+DEFI N CA CB SG\n\
+DEFI CA CB SG\n\
+DEFI CB SG\n\
+DEFI CA CB SG HG\n\
+DEFI CB SG HG\n\
+DEFI SG HG\n\
+CONF -122.60 111.10 1.53 -117.00 109.50 1.11 117.00 109.50 1.11 -64.70 114.10 1.81 180.00 96.00 1.33\n\
+CONF -122.60 111.10 1.53 -117.00 109.50 1.11 117.00 109.50 1.11 -177.20 113.60 1.81 60.00 96.00 1.33\n\
+LIBRARY SECOND\n\
+RESI CYS\n\
+MOBI CB SG\n\
+DEFI N C *CA CB\n\
+DEFI C CA CB\n\
+DEFI CA CB\n\
+DEFI N CA CB SG\n\
+DEFI CA CB SG\n\
+DEFI CB SG\n\
+CONF -122.60 111.10 1.53 -64.70 114.10 1.81\n\
+";
+
+string textBebl = "\
+LEVLABELS SL-LOW SL-HIGH\n\
+PHIBIN 10\n\
+PSIBIN 10\n\
+RESI SER\n\
+BIN * *\n\
+LEVNUM 1 3\n\
+CONFIDX 0 1 2\n\
+BIN -60 -40\n\
+LEVNUM 1 2\n\
+CONFIDX 1 0\n\
+BIN -120 130\n\
+LEVNUM 2 2\n\
+CONFIDX 2 1\n\
+";
+
+void writeString(const string & _text, const string & _filename) {
+	ofstream fs(_filename.c_str());
+	fs << _text;
+	fs.close();
+}
+
+bool sameLibraries(RotamerLibrary & _a, RotamerLibrary & _b) {
+	bool same = true;
+	vector<string> libs = _a.getLibraryNames();
+	if (libs != _b.getLibraryNames() || _a.getDefaultLibrary() != _b.getDefaultLibrary()) {
+		cout << "NOT OK: different library names" << endl;
+		return false;
+	}
+	if (_a.isBackboneDependent() != _b.isBackboneDependent() || _a.getBeblLevelLabels() != _b.getBeblLevelLabels() || _a.getPhiBinSize() != _b.getPhiBinSize() || _a.getPsiBinSize() != _b.getPsiBinSize()) {
+		cout << "NOT OK: different BEBL settings" << endl;
+		same = false;
+	}
+	vector<string> levels;
+	levels.push_back("SL-LOW");
+	levels.push_back("SL-HIGH");
+	for (unsigned int i=0; i<libs.size(); i++) {
+		set<string> resList = _a.getResList(libs[i]);
+		if (resList != _b.getResList(libs[i])) {
+			cout << "NOT OK: different residues in library " << libs[i] << endl;
+			same = false;
+			continue;
+		}
+		for (set<string>::iterator k=resList.begin(); k!=resList.end(); k++) {
+			if (_a.getMobileAtoms(libs[i], *k) != _b.getMobileAtoms(libs[i], *k) || _a.getInternalCoorDefinitionLines(libs[i], *k) != _b.getInternalCoorDefinitionLines(libs[i], *k)) {
+				cout << "NOT OK: different definitions for " << libs[i] << " " << *k << endl;
+				same = false;
+			}
+			// the conformations must be bit-for-bit identical
+			if (_a.getInternalCoor(libs[i], *k) != _b.getInternalCoor(libs[i], *k) || _a.getRotamerBins(libs[i], *k) != _b.getRotamerBins(libs[i], *k)) {
+				cout << "NOT OK: different conformations for " << libs[i] << " " << *k << endl;
+				same = false;
+			}
+			for (unsigned int l=0; l<levels.size(); l++) {
+				if (_a.getLevel(levels[l], *k) != _b.getLevel(levels[l], *k)) {
+					cout << "NOT OK: different level " << levels[l] << " for " << *k << endl;
+					same = false;
+				}
+			}
+			// the BEBL bins, the defined ones and the default
+			for (double phi=-180.0; phi<=180.0; phi+=20.0) {
+				for (double psi=-180.0; psi<=180.0; psi+=10.0) {
+					if (_a.size(libs[i], *k, phi, psi) != _b.size(libs[i], *k, phi, psi) || _a.getInternalCoor(libs[i], *k, phi, psi) != _b.getInternalCoor(libs[i], *k, phi, psi)) {
+						cout << "NOT OK: different BEBL conformations for " << libs[i] << " " << *k << " at " << phi << " " << psi << endl;
+						same = false;
+					}
+					for (unsigned int l=0; l<levels.size(); l++) {
+						if (_a.getLevel(levels[l], *k, phi, psi) != _b.getLevel(levels[l], *k, phi, psi)) {
+							cout << "NOT OK: different BEBL level " << levels[l] << " for " << *k << " at " << phi << " " << psi << endl;
+							same = false;
+						}
+					}
+				}
+			}
+		}
+	}
+	return same;
+}
+
+/*
+  Round trip of a text library with BEBL through the binary format;
+  a truncated binary file must be rejected without changing the
+  library it is read into
+*/
+bool binaryRoundTrip() {
+	bool ok = true;
+	string textFile = "/tmp/testRotamerLibraryWriter.txt";
+	string beblFile = "/tmp/testRotamerLibraryWriter.bebl";
+	string binaryFile = "/tmp/testRotamerLibraryWriter.bin";
+	string truncatedFile = "/tmp/testRotamerLibraryWriter-truncated.bin";
+	writeString(textLibrary, textFile);
+	writeString(textBebl, beblFile);
+
+	RotamerLibrary text;
+	if (!text.readFile(textFile, beblFile)) {
+		cout << "NOT OK: cannot read the text library" << endl;
+		return false;
+	}
+	if (text.getNumberOfLibraries() != 2 || text.size("TEST", "SER", -60.0, -40.0) != 2) {
+		cout << "NOT OK: unexpected text library content" << endl;
+		ok = false;
+	}
+	if (!text.writeBinaryFile(binaryFile)) {
+		cout << "NOT OK: cannot write the binary library" << endl;
+		return false;
+	}
+
+	RotamerLibrary binary;
+	if (!binary.readFile(binaryFile)) {
+		cout << "NOT OK: cannot read the binary library" << endl;
+		return false;
+	}
+	if (!sameLibraries(text, binary)) {
+		ok = false;
+	}
+
+	// cut the binary file at several points, the reads must fail and
+	// leave the (text) library untouched
+	ifstream in(binaryFile.c_str(), ios::binary);
+	string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+	in.close();
+	for (unsigned int cut=bytes.size()/4; cut<bytes.size(); cut+=bytes.size()/4) {
+		ofstream out(truncatedFile.c_str(), ios::binary);
+		out.write(bytes.data(), cut - 1);
+		out.close();
+		RotamerLibrary partial;
+		partial.readFile(textFile, beblFile);
+		cout << "Reading a binary file truncated at " << cut - 1 << " of " << bytes.size() << " bytes (an error is expected)" << endl;
+		if (partial.readFile(truncatedFile, "", true)) {
+			cout << "NOT OK: a truncated binary file was accepted" << endl;
+			ok = false;
+		}
+		if (!sameLibraries(text, partial)) {
+			cout << "NOT OK: a truncated binary file changed the library" << endl;
+			ok = false;
+		}
+	}
+	return ok;
+}
 
 int main(int argc, char* argv[]) {
 
+	if(argc == 1) {
+		if (binaryRoundTrip()) {
+			cout << "LEAD OK" << endl;
+		} else {
+			cout << "LEAD NOT OK" << endl;
+		}
+		exit(0);
+	}
 	if(argc != 3) {
-		cerr << "Usage: testRotamerLibraryWriter <rotlib file> <outputFile> " << endl;
+		cerr << "Usage: testRotamerLibraryWriter [<rotlib file> <outputFile>] " << endl;
 		exit(0);
 
 	}
@@ -28,20 +28,77 @@ You should have received a copy of the GNU Lesser General Public
 */
 
 #include <iostream>
+#include <cmath>
 
+#include "testData.h"
 #include "System.h"
 #include "SasaCalculator.h"
+#include "Transforms.h"
 
 using namespace std;
 
 using namespace MSL;
 
+/*******************************************************************
+ *  Prints the SASA table of a PDB (or of a built-in four helix 
+ *  bundle) and checks that:
+ *   - the cell list and packed occlusion give, for every atom, the
+ *     same SASA as the original SurfaceSphere path (a SasaAtom with
+ *     its own occlusion points, occluded by all the other atoms)
+ *   - the result does not depend on the number of threads
+ *   - updateSasa after side chain (rotamer) changes, and after a
+ *     residue is moved out of the original box, gives the same SASA
+ *     as a new calculation
+ *******************************************************************/
+
+// the SASA of each atom computed as before the cell list
+vector<double> referenceSasa(AtomPointerVector & _atoms, double _probeRadius, unsigned int _points) {
+	vector<double> out(_atoms.size(), 0.0);
+	for (unsigned int i = 0; i < _atoms.size(); i++) {
+		double r1 = _atoms[i]->getRadius();
+		if (r1 <= 0.0) {
+			continue;
+		}
+		SasaAtom sasaAtom(_atoms[i], _probeRadius, _points);
+		for (unsigned int j = 0; j < _atoms.size(); j++) {
+			double r2 = _atoms[j]->getRadius();
+			if (j == i || r2 <= 0.0) {
+				continue;
+			}
+			if (_atoms[i]->distance(*_atoms[j]) < r1 + r2 + 2 * _probeRadius) {
+				sasaAtom.removeOccluded(*_atoms[j]);
+			}
+		}
+		// the surface fraction only counts after the occluded points are purged
+		sasaAtom.getSurfaceSphere()->purgeOccluded();
+		out[i] = sasaAtom.calcSasa();
+	}
+	return out;
+}
+
+// compares the SASA of a calculator updated incrementally with a new calculation
+bool sameAsNewCalculation(SasaCalculator & _updated, AtomPointerVector & _atoms, string _step) {
+	SasaCalculator fresh(_atoms);
+	fresh.setNumThreads(1);
+	fresh.calcSasa();
+	unsigned int different = 0;
+	for (unsigned int i = 0; i < _atoms.size(); i++) {
+		if (_updated.getAtomPointers()[i]->getSasa() != fresh.getAtomPointers()[i]->getSasa()) {
+			if (different < 10) {
+				cout << "NOT OK: " << _step << ", atom " << _atoms[i]->getAtomId() << " SASA " << _updated.getAtomPointers()[i]->getSasa() << ", expected " << fresh.getAtomPointers()[i]->getSasa() << endl;
+			}
+			different++;
+		}
+	}
+	cout << _step << ": total SASA " << _updated.getTotalSasa() << ", new calculation " << fresh.getTotalSasa() << endl;
+	return different == 0;
+}
 
 int main(int argc, char *argv[]) {
 
-	// the program requires the location of the "exampleFiles" as an argument
-	if (argc != 2 && argc != 3) {
-		cerr << "USAGE:\ntestSasaCalculator <file.pdb> [<byAtom> T | F ]" << endl;
+	// the PDB is optional, by default a four helix bundle is used
+	if (argc > 3) {
+		cerr << "USAGE:\ntestSasaCalculator [<file.pdb> [<byAtom> T | F ]]" << endl;
 		exit(0);
 	}
 
@@ -54,21 +111,135 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
+	string pdbFile = "/tmp/testSasaCalculator.pdb";
+	if (argc >= 2) {
+		pdbFile = argv[1];
+	} else {
+		writeString(fourHelixBundle, pdbFile);
+	}
 
 	System sys;
-	if (!sys.readPdb(argv[1])) {
-		cerr << "Cannot read pdb " << argv[0] << endl;
+	if (!sys.readPdb(pdbFile)) {
+		cerr << "Cannot read pdb " << pdbFile << endl;
+		exit(1);
 	}
 
+	bool pass = true;
+
 	SasaCalculator sas(sys.getAtomPointers());
+	sas.setNumThreads(1);
 	sas.calcSasa();
 	//cout << "byAtom " << byAtom << endl;
 	sas.printSasaTable(byAtom);
 	cout << endl;
 	//sas.printResidueSasaTable();
 
-	
+	// the radii have been assigned by the calculator
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	vector<double> reference = referenceSasa(atoms, sas.getProbeRadius(), DEFAULT_OCCLUSION_POINTS);
+	double referenceTotal = 0.0;
+	unsigned int different = 0;
+	for (unsigned int i = 0; i < atoms.size(); i++) {
+		referenceTotal += reference[i];
+		if (fabs(sas.getAtomPointers()[i]->getSasa() - reference[i]) > 1.0e-10 || fabs(atoms[i]->getSasa() - reference[i]) > 1.0e-10) {
+			if (different < 10) {
+				cout << "NOT OK: atom " << atoms[i]->getAtomId() << " SASA " << sas.getAtomPointers()[i]->getSasa() << ", expected " << reference[i] << endl;
+			}
+			different++;
+		}
+	}
+	cout << "Total SASA " << sas.getTotalSasa() << ", reference " << referenceTotal << " (" << atoms.size() << " atoms, " << different << " different)" << endl;
+	if (different > 0) {
+		pass = false;
+	}
+
+	// the same with several threads (the atoms are independent)
+	SasaCalculator threaded(sys.getAtomPointers());
+	threaded.setNumThreads(4);
+	threaded.calcSasa();
+	if (threaded.getSasaTable(true) != sas.getSasaTable(true)) {
+		cout << "NOT OK: the SASA changes with 4 threads" << endl;
+		pass = false;
+	}
+
+	// side chain changes: a second conformation with chi1 rotated by 120 degrees
+	Transforms tr;
+	tr.setTransformAllCoors(false); // only the new conformation
+	vector<double> before(atoms.size());
+	for (unsigned int i = 0; i < atoms.size(); i++) {
+		before[i] = sas.getAtomPointers()[i]->getSasa();
+	}
+	AtomPointerVector allMoved;
+	unsigned int rotamers = 0;
+	for (unsigned int p = 0; p < sys.positionSize() && rotamers < 6; p += 7) {
+		Position & pos = sys.getPosition(p);
+		if (!pos.atomExists("CA") || !pos.atomExists("CB")) {
+			continue;
+		}
+		CartesianPoint ca = pos.getAtom("CA").getCoor();
+		CartesianPoint cb = pos.getAtom("CB").getCoor();
+		AtomPointerVector moved;
+		AtomPointerVector & posAtoms = pos.getAtomPointers();
+		for (unsigned int i = 0; i < posAtoms.size(); i++) {
+			string name = posAtoms[i]->getName();
+			if (name == "N" || name == "CA" || name == "C" || name == "O" || name == "CB" || name == "H" || name == "HN" || name == "HA") {
+				continue;
+			}
+			posAtoms[i]->addAltConformation();
+			posAtoms[i]->setActiveConformation(posAtoms[i]->getNumberOfAltConformations() - 1);
+			tr.rotate(*posAtoms[i], 120.0, cb, ca);
+			moved.push_back(posAtoms[i]);
+			allMoved.push_back(posAtoms[i]);
+		}
+		if (moved.size() == 0) {
+			continue;
+		}
+		rotamers++;
+		AtomPointerVector updated = sas.updateSasa(moved);
+		if (updated.size() < moved.size()) {
+			cout << "NOT OK: only " << updated.size() << " atoms updated after moving " << moved.size() << endl;
+			pass = false;
+		}
+		if (!sameAsNewCalculation(sas, atoms, "Rotamer change at " + pos.getPositionId())) {
+			pass = false;
+		}
+	}
+	if (rotamers == 0) {
+		cout << "NOT OK: no side chain was changed" << endl;
+		pass = false;
+	}
+
+	// a whole residue moved out of the box of the original calculation
+	Position & far = sys.getPosition(sys.positionSize() / 2);
+	AtomPointerVector & farAtoms = far.getAtomPointers();
+	for (unsigned int i = 0; i < farAtoms.size(); i++) {
+		farAtoms[i]->addAltConformation();
+		farAtoms[i]->setActiveConformation(farAtoms[i]->getNumberOfAltConformations() - 1);
+		tr.translate(*farAtoms[i], CartesianPoint(60.0, 0.0, 0.0));
+		allMoved.push_back(farAtoms[i]);
+	}
+	sas.updateSasa(farAtoms);
+	if (!sameAsNewCalculation(sas, atoms, "Residue " + far.getPositionId() + " out of the box")) {
+		pass = false;
+	}
+
+	// and everything back to the original conformation
+	for (unsigned int i = 0; i < allMoved.size(); i++) {
+		allMoved[i]->setActiveConformation(0);
+	}
+	sas.updateSasa(allMoved);
+	for (unsigned int i = 0; i < atoms.size(); i++) {
+		if (sas.getAtomPointers()[i]->getSasa() != before[i]) {
+			cout << "NOT OK: atom " << atoms[i]->getAtomId() << " SASA " << sas.getAtomPointers()[i]->getSasa() << " after restoring the conformations, " << before[i] << " before" << endl;
+			pass = false;
+		}
+	}
+
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
 
 	return 0;
 }
-
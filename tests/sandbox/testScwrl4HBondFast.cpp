@@ -0,0 +1,132 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include <string>
+#include "SysEnv.h"
+#include "System.h"
+#include "PolymerSequence.h"
+#include "CharmmSystemBuilder.h"
+#include "HydrogenBondBuilder.h"
+#include "Transforms.h"
+#include "RandomNumberGenerator.h"
+
+using namespace MSL;
+using namespace std;
+
+static SysEnv SYSENV;
+
+/*******************************************************************
+ *  Builds a helix with the SCWRL4 hydrogen bonds (canonical and CA
+ *  donors) and compares the fast evaluation of every interaction
+ *  with the exact one, on the helix and after shaking the
+ *  coordinates, reporting the largest difference
+ *******************************************************************/
+
+int main() {
+
+	string topFile = SYSENV.getEnv("MSL_CHARMM_TOP");
+	string parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+	string hbondFile = SYSENV.getEnv("MSL_HBOND_CA_PAR");
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, topFile, parFile);
+	CSB.setBuildNonBondedInteractions(false);
+	if (!CSB.buildSystem(PolymerSequence("A: SER ASN GLU LYS ARG GLN THR TYR HSD ASP TRP SER GLU LYS ARG ASN GLN THR TYR ASP"))) {
+		cerr << "Cannot build the system with " << topFile << " " << parFile << endl;
+		exit(1);
+	}
+	if (!sys.seed("A 1 C", "A 1 CA", "A 1 N")) {
+		cerr << "Cannot seed atoms C, CA, N on residue 1 A" << endl;
+		exit(1);
+	}
+	sys.buildAllAtoms();
+
+	Transforms tr;
+	Chain & chain = sys.getChain("A");
+	for (unsigned int i=1; i < chain.positionSize(); i++) {
+		Residue & prev = chain.getResidue(i-1);
+		Residue & res = chain.getResidue(i);
+		tr.setDihedral(prev("C"), res("N"), res("CA"), res("C"), -57.0);
+		if (i+1 < chain.positionSize()) {
+			tr.setDihedral(res("N"), res("CA"), res("C"), chain.getResidue(i+1)("N"), -47.0);
+		}
+	}
+
+	HydrogenBondBuilder hb(sys, hbondFile);
+	hb.buildInteractions(10.0);
+	vector<Interaction*> & interactions = (*sys.getEnergySet()->getEnergyTerms())["SCWRL4_HBOND"];
+
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	RandomNumberGenerator rng;
+	rng.setSeed(649);
+
+	bool pass = true;
+	double maxError = 0.0;
+	unsigned int nonZero = 0;
+	unsigned int evaluated = 0;
+	for (unsigned int trial=0; trial < 20; trial++) {
+		if (trial > 0) {
+			for (unsigned int i=0; i < atoms.size(); i++) {
+				CartesianPoint delta(rng.getRandomDouble(-0.4, 0.4), rng.getRandomDouble(-0.4, 0.4), rng.getRandomDouble(-0.4, 0.4));
+				atoms[i]->setCoor(atoms[i]->getCoor() + delta);
+			}
+		}
+		for (unsigned int i=0; i < interactions.size(); i++) {
+			Scwrl4HBondInteraction * pHb = (Scwrl4HBondInteraction*)interactions[i];
+			pHb->setFastEnergy(false);
+			double exact = pHb->getEnergy();
+			pHb->setFastEnergy(true);
+			double fast = pHb->getEnergy();
+			if (fabs(fast - exact) > maxError) {
+				maxError = fabs(fast - exact);
+			}
+			if (exact != 0.0) {
+				nonZero++;
+			}
+			evaluated++;
+		}
+	}
+	cout << "Compared " << evaluated << " evaluations (" << nonZero << " hydrogen bonds), largest difference " << maxError << endl;
+	if (nonZero == 0) {
+		cout << "NOT OK: no hydrogen bonds were evaluated" << endl;
+		pass = false;
+	}
+	if (maxError > 1.0e-6) {
+		cout << "NOT OK: the fast energy differs from the exact one by " << maxError << endl;
+		pass = false;
+	}
+
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
+
+	return 0;
+}
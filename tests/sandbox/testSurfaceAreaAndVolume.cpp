@@ -43,6 +43,10 @@ using namespace std;
 static SysEnv SYSENV;
 
 void run_1j4m_Test();
+void compareMethods(string _name, AtomPointerVector &_av, vector<double> &_radii);
+
+// set to false by compareMethods if the surface points engine is off
+bool pass = true;
 
 int main() {
 
@@ -252,6 +256,7 @@ int main() {
     double volABC = sav.getVolume();
     fprintf(stdout, " %-20s: Surface Area       %8.3f , expected 148.9890027964171\n", "TEST2-ABC", saABC);
     fprintf(stdout, " %-20s: Volume             %8.3f , expected 144.3669682217146\n", "TEST2-ABC", volABC);
+    compareMethods("TEST2-ABC", av, radii);
     //sav.setDebug(false);
 
 
@@ -341,6 +346,7 @@ int main() {
 
     fprintf(stdout, " %-20s: Surface Area       %8.3f , expected 1011.872531375812\n", "TEST3-8spheres", sav.getSurfaceArea());
     fprintf(stdout, " %-20s: Volume             %8.3f , expected 2329.934829835795\n", "TEST3-8spheres", sav.getVolume());
+    compareMethods("TEST3-8spheres", av, radii);
 
     // Test	4
     av.clear();
@@ -382,6 +388,12 @@ int main() {
 
     // Test 6
     run_1j4m_Test();
+
+    if (pass) {
+        cout << "LEAD OK" << endl;
+    } else {
+        cout << "LEAD NOT OK" << endl;
+    }
 }
 
 void run_1j4m_Test() {
@@ -1007,6 +1019,51 @@ void run_1j4m_Test() {
     sav.computeSurfaceAreaAndVolume(av, radii);
     fprintf(stdout, " %-20s: Surface Area       %8.3f , expected 1361.1362734952666\n", "TEST6b", sav.getSurfaceArea());
     fprintf(stdout, " %-20s: Volume             %8.3f , expected 1042.3727637262789\n", "TEST6b", sav.getVolume());
+    compareMethods("TEST6b", av, radii);
     
     av.deletePointers();
 }
+
+void compareMethods(string _name, AtomPointerVector &_av, vector<double> &_radii) {
+    /*
+      Accuracy of the surface points engine against the analytic one,
+      total and largest per-atom deviation.  With the default 2000 points
+      per sphere the totals must be within 0.5% and each atom within 1%
+      of the area of its sphere
+    */
+    SurfaceAreaAndVolume analytic;
+    analytic.computeSurfaceAreaAndVolume(_av, _radii);
+
+    SurfaceAreaAndVolume points;
+    points.setMethod(SurfaceAreaAndVolume::surfacePoints);
+    points.computeSurfaceAreaAndVolume(_av, _radii);
+
+    double maxAtomAreaError = 0.0;
+    double maxAtomRelativeError = 0.0;
+    for (uint i = 0; i < _av.size(); i++) {
+        double diff = fabs(points.getRadiiSurfaceAreaAndVolume(_av[i])[1] - analytic.getRadiiSurfaceAreaAndVolume(_av[i])[1]);
+        if (diff > maxAtomAreaError) {
+            maxAtomAreaError = diff;
+        }
+        double sphereArea = 4.0 * M_PI * _radii[i] * _radii[i];
+        if (sphereArea > 0.0 && diff / sphereArea > maxAtomRelativeError) {
+            maxAtomRelativeError = diff / sphereArea;
+        }
+    }
+
+    fprintf(stdout, " %-20s: Surface Area       %8.3f , analytic %8.3f (%6.3f%%, max atom error %6.3f)\n", (_name + "-points").c_str(), points.getSurfaceArea(), analytic.getSurfaceArea(), 100.0 * (points.getSurfaceArea() - analytic.getSurfaceArea()) / analytic.getSurfaceArea(), maxAtomAreaError);
+    fprintf(stdout, " %-20s: Volume             %8.3f , analytic %8.3f (%6.3f%%)\n", (_name + "-points").c_str(), points.getVolume(), analytic.getVolume(), 100.0 * (points.getVolume() - analytic.getVolume()) / analytic.getVolume());
+
+    if (fabs(points.getSurfaceArea() - analytic.getSurfaceArea()) > 0.005 * analytic.getSurfaceArea()) {
+        cout << "NOT OK: " << _name << " surface points area " << points.getSurfaceArea() << " differs from the analytic " << analytic.getSurfaceArea() << " by more than 0.5%" << endl;
+        pass = false;
+    }
+    if (fabs(points.getVolume() - analytic.getVolume()) > 0.005 * analytic.getVolume()) {
+        cout << "NOT OK: " << _name << " surface points volume " << points.getVolume() << " differs from the analytic " << analytic.getVolume() << " by more than 0.5%" << endl;
+        pass = false;
+    }
+    if (maxAtomRelativeError > 0.01) {
+        cout << "NOT OK: " << _name << " surface points area of an atom differs from the analytic by " << 100.0 * maxAtomRelativeError << "% of its sphere" << endl;
+        pass = false;
+    }
+}
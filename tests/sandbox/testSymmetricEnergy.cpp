@@ -0,0 +1,201 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include <string>
+#include "SysEnv.h"
+#include "System.h"
+#include "PolymerSequence.h"
+#include "CharmmSystemBuilder.h"
+#include "Symmetry.h"
+#include "Transforms.h"
+
+using namespace MSL;
+using namespace std;
+
+static SysEnv SYSENV;
+
+/*******************************************************************
+ *  Builds a peptide away from the symmetry axes and compares the
+ *  energy in symmetric mode (asymmetric unit + unique interfaces)
+ *  with the energy of the full oligomer built with applySymmetry,
+ *  which must be getNumberOfCopies() times larger, term by term,
+ *  with and without non-bonded cutoffs.
+ *  The gradient of the symmetric energy is checked against finite
+ *  differences.
+ *******************************************************************/
+
+string sequence = "ALA LEU LYS GLU PHE SER";
+
+bool compareWithOligomer(System & _unit, Symmetry & _sym, string _topFile, string _parFile, double _ctonnb=0.0, double _ctofnb=0.0, double _cutnb=0.0) {
+	bool pass = true;
+
+	EnergySet * pUnitSet = _unit.getEnergySet();
+	pUnitSet->calcEnergy();
+
+	// the full oligomer, one chain per copy
+	AtomPointerVector copies;
+	_sym.applySymmetry(_unit.getAtomPointers());
+	copies = _sym.getAtomPointers();
+
+	string chains = "ABCDEFGH";
+	string oligomerSeq;
+	for (unsigned int i=0; i < _sym.getNumberOfCopies(); i++) {
+		oligomerSeq += chains.substr(i, 1) + ": " + sequence + "\n";
+	}
+	System full;
+	CharmmSystemBuilder CSB(full, _topFile, _parFile);
+	CSB.buildSystem(PolymerSequence(oligomerSeq));
+	AtomPointerVector & fullAtoms = full.getAtomPointers();
+	if (fullAtoms.size() != copies.size()) {
+		cout << "NOT OK: the oligomer has " << fullAtoms.size() << " atoms, the symmetry generated " << copies.size() << endl;
+		return false;
+	}
+	for (unsigned int i=0; i < fullAtoms.size(); i++) {
+		fullAtoms[i]->setCoor(copies[i]->getCoor());
+	}
+	if (_cutnb > 0.0) {
+		CSB.updateNonBonded(_ctonnb, _ctofnb, _cutnb);
+	}
+	EnergySet * pFullSet = full.getEnergySet();
+	double Efull = pFullSet->calcEnergy();
+	double copyN = _sym.getNumberOfCopies();
+
+	cout << "Oligomer energy " << Efull << ", symmetric energy " << pUnitSet->getTotalEnergy() << " x " << copyN << " = " << pUnitSet->getTotalEnergy() * copyN << endl;
+	map<string, vector<Interaction*> > * terms = pFullSet->getEnergyTerms();
+	for (map<string, vector<Interaction*> >::iterator k=terms->begin(); k!=terms->end(); k++) {
+		double e1 = pFullSet->getTermEnergy(k->first);
+		double e2 = pUnitSet->getTermEnergy(k->first) * copyN;
+		double tolerance = 1e-8 * (fabs(e1) > 1.0 ? fabs(e1) : 1.0);
+		if (fabs(e1 - e2) > tolerance) {
+			cout << "NOT OK: term " << k->first << " oligomer " << e1 << ", symmetric x copies " << e2 << endl;
+			pass = false;
+		}
+	}
+	return pass;
+}
+
+bool checkGradient(System & _unit) {
+	bool pass = true;
+	AtomPointerVector & atoms = _unit.getAtomPointers();
+	for (unsigned int i=0; i < atoms.size(); i++) {
+		atoms[i]->setMinimizationIndex(i+1);
+	}
+	EnergySet * pESet = _unit.getEnergySet();
+	vector<double> gradient(3 * atoms.size(), 0.0);
+	pESet->calcEnergyAndEnergyGradient(gradient);
+
+	double h = 1e-5;
+	double maxError = 0.0;
+	for (unsigned int i=0; i < atoms.size(); i+=5) {
+		CartesianPoint start = atoms[i]->getCoor();
+		for (unsigned int j=0; j < 3; j++) {
+			CartesianPoint delta(0.0, 0.0, 0.0);
+			delta[j] = h;
+			atoms[i]->setCoor(start + delta);
+			double Eplus = pESet->calcEnergy();
+			atoms[i]->setCoor(start - delta);
+			double Eminus = pESet->calcEnergy();
+			atoms[i]->setCoor(start);
+			double numeric = (Eplus - Eminus) / (2.0 * h);
+			double error = fabs(numeric - gradient[3*i + j]) / (fabs(numeric) > 1.0 ? fabs(numeric) : 1.0);
+			if (error > maxError) {
+				maxError = error;
+			}
+			if (error > 1e-4) {
+				cout << "NOT OK: gradient of " << atoms[i]->getAtomId() << " [" << j << "] " << gradient[3*i + j] << ", numeric " << numeric << endl;
+				pass = false;
+			}
+		}
+	}
+	cout << "Max relative gradient error " << maxError << endl;
+	for (unsigned int i=0; i < atoms.size(); i++) {
+		atoms[i]->setMinimizationIndex(-1);
+	}
+	return pass;
+}
+
+int main() {
+
+	string topFile = SYSENV.getEnv("MSL_CHARMM_TOP");
+	string parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+
+	System sys;
+	CharmmSystemBuilder CSB(sys, topFile, parFile);
+	if (!CSB.buildSystem(PolymerSequence("A: " + sequence))) {
+		cerr << "Cannot build the system with " << topFile << " " << parFile << endl;
+		exit(1);
+	}
+	if (!sys.seed("A 1 C", "A 1 CA", "A 1 N")) {
+		cerr << "Cannot seed atoms C, CA, N on residue 1 A" << endl;
+		exit(1);
+	}
+	sys.buildAtoms();
+
+	// move the unit off the axes
+	AtomPointerVector & atoms = sys.getAtomPointers();
+	Transforms tr;
+	tr.translate(atoms, CartesianPoint(12.0, 2.0, 4.0) - atoms.getGeometricCenter());
+
+	bool pass = true;
+
+	Symmetry C3;
+	C3.setCN(3);
+	CSB.setSymmetry(&C3);
+	CSB.updateNonBonded();
+	cout << "C3: " << C3.getNumberOfUniqueOperators() << " unique operators" << endl;
+	pass = compareWithOligomer(sys, C3, topFile, parFile) && pass;
+	pass = checkGradient(sys) && pass;
+
+	CSB.updateNonBonded(7.0, 8.0, 9.0);
+	cout << "C3 with cutoffs" << endl;
+	pass = compareWithOligomer(sys, C3, topFile, parFile, 7.0, 8.0, 9.0) && pass;
+
+	Symmetry C4;
+	C4.setCN(4);
+	CSB.setSymmetry(&C4);
+	CSB.updateNonBonded();
+	cout << "C4: " << C4.getNumberOfUniqueOperators() << " unique operators" << endl;
+	pass = compareWithOligomer(sys, C4, topFile, parFile) && pass;
+
+	Symmetry D2;
+	D2.setDN(2);
+	CSB.setSymmetry(&D2);
+	CSB.updateNonBonded();
+	cout << "D2: " << D2.getNumberOfUniqueOperators() << " unique operators" << endl;
+	pass = compareWithOligomer(sys, D2, topFile, parFile) && pass;
+	pass = checkGradient(sys) && pass;
+
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,344 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+
+#include <string>
+#include "SysEnv.h"
+#include "System.h"
+#include "PolymerSequence.h"
+#include "CharmmSystemBuilder.h"
+#include "SystemRotamerLoader.h"
+#include "testData.h"
+
+using namespace MSL;
+using namespace std;
+
+static SysEnv SYSENV;
+
+/*******************************************************************
+ *  Loads rotamers (defined by all the bonds, angles, dihedrals and
+ *  impropers of the side chains) with the SystemRotamerLoader, which
+ *  replays a compiled building order, and checks that every
+ *  conformation is bit-identical to the one built as before, by
+ *  editing the IC table and calling the recursive Atom::buildFromIc
+ *  on a copy of the system
+ *******************************************************************/
+
+string rotamerLibrary = "\
+LIBRARY TEST\n\
+RESI LEU\n\
+MOBI HA CB HB1 HB2 CG HG CD1 HD11 HD12 HD13 CD2 HD21 HD22 HD23\n\
+DEFI N C *CA HA\n\
+DEFI C CA HA\n\
+DEFI CA HA\n\
+DEFI N C *CA CB\n\
+DEFI C CA CB\n\
+DEFI CA CB\n\
+DEFI CG CA *CB HB1\n\
+DEFI CA CB HB1\n\
+DEFI CB HB1\n\
+DEFI CG CA *CB HB2\n\
+DEFI CA CB HB2\n\
+DEFI CB HB2\n\
+DEFI N CA CB CG\n\
+DEFI CA CB CG\n\
+DEFI CB CG\n\
+DEFI CD1 CD2 *CG HG\n\
+DEFI CD2 CG HG\n\
+DEFI CG HG\n\
+DEFI CA CB CG CD1\n\
+DEFI CB CG CD1\n\
+DEFI CG CD1\n\
+DEFI CB CG CD1 HD11\n\
+DEFI CG CD1 HD11\n\
+DEFI CD1 HD11\n\
+DEFI HD11 CG *CD1 HD12\n\
+DEFI CG CD1 HD12\n\
+DEFI CD1 HD12\n\
+DEFI HD11 CG *CD1 HD13\n\
+DEFI CG CD1 HD13\n\
+DEFI CD1 HD13\n\
+DEFI CD1 CB *CG CD2\n\
+DEFI CB CG CD2\n\
+DEFI CG CD2\n\
+DEFI CB CG CD2 HD21\n\
+DEFI CG CD2 HD21\n\
+DEFI CD2 HD21\n\
+DEFI HD21 CG *CD2 HD22\n\
+DEFI CG CD2 HD22\n\
+DEFI CD2 HD22\n\
+DEFI HD21 CG *CD2 HD23\n\
+DEFI CG CD2 HD23\n\
+DEFI CD2 HD23\n\
+CONF -117.489 107.081 1.084 123.535 111.810 1.543 122.036 108.699 1.115 -121.343 107.007 1.114 -18.163 116.810 1.527 117.402 106.490 1.098 283.152 111.051 1.514 -5.966 113.019 1.117 119.946 110.958 1.097 -119.994 107.254 1.111 124.458 109.095 1.531 -272.142 107.455 1.108 119.967 109.875 1.124 -119.712 110.802 1.115\n\
+CONF -117.489 107.366 1.088 123.535 109.009 1.535 122.036 111.638 1.132 -121.343 110.940 1.121 -131.421 113.430 1.535 117.402 105.091 1.125 135.824 111.970 1.528 -14.661 112.314 1.091 119.946 108.523 1.127 -119.994 109.984 1.129 124.458 111.122 1.527 -132.637 111.946 1.101 119.967 107.755 1.103 -119.712 113.471 1.119\n\
+CONF -117.489 105.075 1.071 123.535 106.871 1.526 122.036 110.434 1.099 -121.343 109.255 1.111 -176.274 116.444 1.529 117.402 108.532 1.099 143.152 108.168 1.524 -10.021 112.051 1.103 119.946 112.574 1.099 -119.994 109.530 1.124 124.458 112.589 1.528 -3.093 108.554 1.100 119.967 111.868 1.103 -119.712 109.465 1.092\n\
+RESI LYS\n\
+MOBI HA CB HB1 HB2 CG HG1 HG2 CD HD1 HD2 CE HE1 HE2 NZ HZ1 HZ2 HZ3\n\
+DEFI N C *CA HA\n\
+DEFI C CA HA\n\
+DEFI CA HA\n\
+DEFI N C *CA CB\n\
+DEFI C CA CB\n\
+DEFI CA CB\n\
+DEFI CG CA *CB HB1\n\
+DEFI CA CB HB1\n\
+DEFI CB HB1\n\
+DEFI CG CA *CB HB2\n\
+DEFI CA CB HB2\n\
+DEFI CB HB2\n\
+DEFI N CA CB CG\n\
+DEFI CA CB CG\n\
+DEFI CB CG\n\
+DEFI CD CB *CG HG1\n\
+DEFI CB CG HG1\n\
+DEFI CG HG1\n\
+DEFI CD CB *CG HG2\n\
+DEFI CB CG HG2\n\
+DEFI CG HG2\n\
+DEFI CA CB CG CD\n\
+DEFI CB CG CD\n\
+DEFI CG CD\n\
+DEFI CE CG *CD HD1\n\
+DEFI CG CD HD1\n\
+DEFI CD HD1\n\
+DEFI CE CG *CD HD2\n\
+DEFI CG CD HD2\n\
+DEFI CD HD2\n\
+DEFI CB CG CD CE\n\
+DEFI CG CD CE\n\
+DEFI CD CE\n\
+DEFI NZ CD *CE HE1\n\
+DEFI CD CE HE1\n\
+DEFI CE HE1\n\
+DEFI NZ CD *CE HE2\n\
+DEFI CD CE HE2\n\
+DEFI CE HE2\n\
+DEFI CG CD CE NZ\n\
+DEFI CD CE NZ\n\
+DEFI CE NZ\n\
+DEFI CD CE NZ HZ1\n\
+DEFI CE NZ HZ1\n\
+DEFI NZ HZ1\n\
+DEFI HZ1 CE *NZ HZ2\n\
+DEFI CE NZ HZ2\n\
+DEFI NZ HZ2\n\
+DEFI HZ1 CE *NZ HZ3\n\
+DEFI CE NZ HZ3\n\
+DEFI NZ HZ3\n\
+CONF -117.265 107.733 1.102 124.141 108.468 1.548 122.193 108.268 1.104 -120.728 109.651 1.117 -136.510 113.691 1.534 121.200 110.503 1.096 -121.491 106.942 1.102 97.186 113.759 1.531 121.480 110.795 1.109 -121.565 107.339 1.121 -328.541 114.689 1.542 120.296 108.865 1.104 -120.285 111.782 1.123 -128.338 109.055 1.496 -342.718 110.476 1.041 119.955 112.325 1.044 -119.972 106.869 1.056\n\
+CONF -117.265 108.689 1.086 124.141 106.307 1.554 122.193 108.564 1.119 -120.728 111.898 1.131 -222.974 115.394 1.531 121.200 110.490 1.109 -121.491 109.071 1.110 42.415 110.905 1.543 121.480 106.064 1.098 -121.565 110.629 1.121 -161.985 109.464 1.514 120.296 108.756 1.130 -120.285 110.227 1.128 -283.541 111.204 1.487 -57.847 107.468 1.054 119.955 109.596 1.019 -119.972 109.326 1.033\n\
+CONF -117.265 108.219 1.100 124.141 109.235 1.552 122.193 108.382 1.123 -120.728 106.627 1.124 -190.015 114.220 1.521 121.200 108.058 1.100 -121.491 108.483 1.116 187.132 111.317 1.537 121.480 110.689 1.107 -121.565 109.128 1.113 -6.288 110.753 1.537 120.296 108.297 1.102 -120.285 111.249 1.114 -267.015 109.100 1.499 -224.054 111.026 1.036 119.955 110.467 1.040 -119.972 112.589 1.055\n\
+RESI PHE\n\
+MOBI HA CB HB1 HB2 CG CD1 HD1 CD2 HD2 CE1 HE1 CE2 HE2 CZ HZ\n\
+DEFI N C *CA HA\n\
+DEFI C CA HA\n\
+DEFI CA HA\n\
+DEFI N C *CA CB\n\
+DEFI C CA CB\n\
+DEFI CA CB\n\
+DEFI CG CA *CB HB1\n\
+DEFI CA CB HB1\n\
+DEFI CB HB1\n\
+DEFI CG CA *CB HB2\n\
+DEFI CA CB HB2\n\
+DEFI CB HB2\n\
+DEFI N CA CB CG\n\
+DEFI CA CB CG\n\
+DEFI CB CG\n\
+DEFI CA CB CG CD1\n\
+DEFI CB CG CD1\n\
+DEFI CG CD1\n\
+DEFI CE1 CG *CD1 HD1\n\
+DEFI CG CD1 HD1\n\
+DEFI CD1 HD1\n\
+DEFI CD1 CB *CG CD2\n\
+DEFI CB CG CD2\n\
+DEFI CG CD2\n\
+DEFI CE2 CG *CD2 HD2\n\
+DEFI CG CD2 HD2\n\
+DEFI CD2 HD2\n\
+DEFI CB CG CD1 CE1\n\
+DEFI CG CD1 CE1\n\
+DEFI CD1 CE1\n\
+DEFI CZ CD1 *CE1 HE1\n\
+DEFI CD1 CE1 HE1\n\
+DEFI CE1 HE1\n\
+DEFI CB CG CD2 CE2\n\
+DEFI CG CD2 CE2\n\
+DEFI CD2 CE2\n\
+DEFI CZ CD2 *CE2 HE2\n\
+DEFI CD2 CE2 HE2\n\
+DEFI CE2 HE2\n\
+DEFI CG CD1 CE1 CZ\n\
+DEFI CD1 CE1 CZ\n\
+DEFI CE1 CZ\n\
+DEFI CE1 CE2 *CZ HZ\n\
+DEFI CE2 CZ HZ\n\
+DEFI CZ HZ\n\
+CONF -117.882 106.641 1.090 122.496 106.012 1.537 120.927 107.113 1.114 -120.504 110.288 1.120 -92.038 115.273 1.512 -61.495 122.910 1.389 -179.689 118.331 1.084 -179.874 121.136 1.422 179.925 120.668 1.062 339.457 120.463 1.389 -179.931 121.565 1.086 -51.679 121.204 1.390 -179.784 119.957 1.079 -53.131 120.463 1.388 -179.991 118.575 1.066\n\
+CONF -117.882 105.069 1.084 122.496 109.591 1.543 120.927 112.174 1.116 -120.504 110.721 1.103 80.461 111.739 1.517 -178.236 123.381 1.410 -179.689 117.649 1.091 -179.874 118.473 1.399 179.925 118.864 1.073 129.772 118.623 1.397 -179.931 117.553 1.092 -231.972 122.169 1.397 -179.784 122.982 1.096 74.155 122.025 1.419 -179.991 122.639 1.077\n\
+CONF -117.882 108.463 1.066 122.496 107.352 1.540 120.927 110.494 1.091 -120.504 111.296 1.095 -90.935 112.562 1.517 -38.461 118.556 1.409 -179.689 117.989 1.086 -179.874 120.021 1.422 179.925 119.287 1.071 111.143 123.404 1.395 -179.931 118.449 1.082 -118.134 123.539 1.383 -179.784 119.111 1.090 -1.522 121.126 1.409 -179.991 117.611 1.063\n\
+";
+
+// the previous loadRotamers loop: edit the IC table, wipe and build recursively
+bool recursiveRotamers(System & _sys, Position & _pos, string _resName, RotamerLibrary * _pRotLib, vector<vector<CartesianPoint> > & _coor) {
+	_pos.setActiveIdentity(_resName);
+	IcTable * pIcTable = &(_sys.getIcTable());
+	vector<RotamerLibrary::InternalCoorDefi> defi = _pRotLib->getInternalCoorDefinition("TEST", _resName);
+	vector<vector<double> > icValues = _pRotLib->getInternalCoor("TEST", _resName);
+	vector<string> mobileAtoms = _pRotLib->getMobileAtoms("TEST", _resName);
+
+	vector<vector<Atom*> > defiAtoms;
+	for (unsigned int j=0; j < defi.size(); j++) {
+		defiAtoms.push_back(vector<Atom*>());
+		for (unsigned int k=0; k < defi[j].atomNames.size(); k++) {
+			defiAtoms.back().push_back(&_pos.getAtom(defi[j].atomNames[k]));
+		}
+	}
+	vector<Atom*> mobile;
+	for (unsigned int k=0; k < mobileAtoms.size(); k++) {
+		mobile.push_back(&_pos.getAtom(mobileAtoms[k]));
+	}
+
+	_coor.clear();
+	for (unsigned int i=0; i < icValues.size(); i++) {
+		for (unsigned int j=0; j < icValues[i].size(); j++) {
+			if (defiAtoms[j].size() == 2) {
+				pIcTable->editBond(defiAtoms[j][0], defiAtoms[j][1], icValues[i][j]);
+				pIcTable->editBond(defiAtoms[j][1], defiAtoms[j][0], icValues[i][j]);
+			} else if (defiAtoms[j].size() == 3) {
+				pIcTable->editAngle(defiAtoms[j][0], defiAtoms[j][1], defiAtoms[j][2], icValues[i][j]);
+				pIcTable->editAngle(defiAtoms[j][2], defiAtoms[j][1], defiAtoms[j][0], icValues[i][j]);
+			} else if (defiAtoms[j].size() == 4) {
+				pIcTable->editDihedral(defiAtoms[j][0], defiAtoms[j][1], defiAtoms[j][2], defiAtoms[j][3], icValues[i][j]);
+				pIcTable->editDihedral(defiAtoms[j][3], defiAtoms[j][1], defiAtoms[j][2], defiAtoms[j][0], -icValues[i][j]);
+			}
+		}
+		for (unsigned int k=0; k < mobile.size(); k++) {
+			mobile[k]->wipeCoordinates();
+		}
+		_coor.push_back(vector<CartesianPoint>());
+		for (unsigned int k=0; k < mobile.size(); k++) {
+			mobile[k]->buildFromIc();
+		}
+		for (unsigned int k=0; k < mobile.size(); k++) {
+			if (!mobile[k]->hasCoor()) {
+				return false;
+			}
+			_coor.back().push_back(mobile[k]->getCoor());
+		}
+	}
+	return true;
+}
+
+int main() {
+
+	string topFile = SYSENV.getEnv("MSL_CHARMM_TOP");
+	string parFile = SYSENV.getEnv("MSL_CHARMM_PAR");
+	string libFile = "/tmp/testSystemRotamerLoader.txt";
+	writeString(rotamerLibrary, libFile);
+
+	// the system that loads the rotamers and the reference built recursively
+	string sequence = "A: ALA [LEU PHE LYS] ILE [LYS LEU] [PHE LEU LYS] ALA";
+	System sys;
+	CharmmSystemBuilder CSB(sys, topFile, parFile);
+	System ref;
+	CharmmSystemBuilder refCSB(ref, topFile, parFile);
+	if (!CSB.buildSystem(PolymerSequence(sequence)) || !refCSB.buildSystem(PolymerSequence(sequence))) {
+		cerr << "Cannot build the system with " << topFile << " " << parFile << endl;
+		exit(1);
+	}
+	sys.seed("A 1 C", "A 1 CA", "A 1 N");
+	sys.buildAllAtoms();
+	ref.seed("A 1 C", "A 1 CA", "A 1 N");
+	ref.buildAllAtoms();
+
+	SystemRotamerLoader loader(sys, libFile);
+	RotamerLibrary * pRotLib = loader.getRotamerLibrary();
+
+	bool pass = true;
+	unsigned int compared = 0;
+	for (unsigned int p=0; p < sys.positionSize(); p++) {
+		Position & pos = sys.getPosition(p);
+		Position & refPos = ref.getPosition(p);
+		for (unsigned int id=0; id < pos.identitySize(); id++) {
+			string resName = pos.getIdentity(id).getResidueName();
+			if (!pRotLib->residueExists("TEST", resName)) {
+				continue;
+			}
+			unsigned int numRots = pRotLib->size("TEST", resName);
+			if (!loader.loadRotamers(&pos, resName, 0, numRots - 1, "TEST")) {
+				cout << "NOT OK: cannot load the " << resName << " rotamers at " << pos.getPositionId() << endl;
+				pass = false;
+				continue;
+			}
+			vector<vector<CartesianPoint> > refCoor;
+			if (!recursiveRotamers(ref, refPos, resName, pRotLib, refCoor)) {
+				cout << "NOT OK: cannot build the reference " << resName << " rotamers at " << pos.getPositionId() << endl;
+				pass = false;
+				continue;
+			}
+
+			vector<string> mobileAtoms = pRotLib->getMobileAtoms("TEST", resName);
+			Residue & res = pos.getIdentity(id);
+			for (unsigned int i=0; i < refCoor.size(); i++) {
+				for (unsigned int k=0; k < mobileAtoms.size(); k++) {
+					Atom & atom = res.getAtom(mobileAtoms[k]);
+					if (atom.getNumberOfAltConformations() != refCoor.size()) {
+						cout << "NOT OK: " << atom.getAtomId() << " " << resName << " has " << atom.getNumberOfAltConformations() << " conformations, expected " << refCoor.size() << endl;
+						pass = false;
+						break;
+					}
+					atom.setActiveConformation(i);
+					const CartesianPoint & c = atom.getCoor();
+					if (c.getX() != refCoor[i][k].getX() || c.getY() != refCoor[i][k].getY() || c.getZ() != refCoor[i][k].getZ()) {
+						cout << "NOT OK: " << atom.getAtomId() << " " << resName << " rotamer " << i << " " << c << " != " << refCoor[i][k] << endl;
+						pass = false;
+					}
+					compared++;
+				}
+			}
+			for (unsigned int k=0; k < mobileAtoms.size(); k++) {
+				res.getAtom(mobileAtoms[k]).setActiveConformation(0);
+			}
+		}
+	}
+	cout << "Compared " << compared << " rotamer atom coordinates" << endl;
+	if (compared == 0) {
+		pass = false;
+	}
+
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
+
+	return 0;
+}
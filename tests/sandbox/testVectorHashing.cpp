@@ -0,0 +1,155 @@
+/*
+----------------------------------------------------------------------------
+This file is part of MSL (Molecular Software Libraries) 
+ Copyright (C) 2008-2012 The MSL Developer Group (see README.TXT)
+ MSL Libraries: http://msl-libraries.org
+
+If used in a scientific publication, please cite: 
+ Kulp DW, Subramaniam S, Donald JE, Hannigan BT, Mueller BK, Grigoryan G and 
+ Senes A "Structural informatics, modeling and design with a open source 
+ Molecular Software Library (MSL)" (2012) J. Comput. Chem, 33, 1645-61 
+ DOI: 10.1002/jcc.22968
+
+This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, 
+ USA, or go to http://www.gnu.org/copyleft/lesser.txt.
+----------------------------------------------------------------------------
+*/
+#include <map>
+#include <fstream>
+#include "testData.h"
+#include "System.h"
+#include "VectorHashing.h"
+#include "VectorPair.h"
+
+using namespace MSL;
+using namespace std;
+
+/*******************************************************************
+ *  Builds a vector hash of a four helix bundle and one of its first
+ *  chain and checks that:
+ *   - the integer hash values bin the vector pairs exactly as the
+ *     "dist:angle:torsion" string keys used before
+ *   - the hashes reloaded from their binary checkpoints have the
+ *     same content and give the same matches as the original ones
+ *   - truncated checkpoints are rejected
+ *******************************************************************/
+
+int main() {
+
+	bool pass = true;
+
+	writeString(fourHelixBundle, "/tmp/fourHelixBundle.pdb");
+	System bundle;
+	bundle.readPdb("/tmp/fourHelixBundle.pdb");
+
+	VectorHashing db;
+	db.addToVectorHash(bundle, "bundle");
+
+	System helix;
+	helix.readPdb("/tmp/fourHelixBundle.pdb");
+	helix.removeChain("B");
+	VectorHashing query;
+	query.addToVectorHash(helix, "helix");
+
+	cout << "Database: " << db.getNumberOfIds() << " ids, " << db.getNumberOfVectorPairs() << " vector pairs, " << db.getNumberOfGeometricBins() << " geometric bins" << endl;
+	if (db.getNumberOfVectorPairs() == 0 || query.getNumberOfVectorPairs() == 0) {
+		cout << "NOT OK: no vector pairs were hashed" << endl;
+		pass = false;
+	}
+
+	// the integer values must partition the pairs like the string keys
+	map<string, unsigned long long> keyToValue;
+	map<unsigned long long, string> valueToKey;
+	unsigned int numVectorPairs = 0;
+	for (unsigned int i=0; i < bundle.positionSize(); i++) {
+		Position & posI = bundle.getPosition(i);
+		if (!posI.atomExists("CA") || !posI.atomExists("CB")) {
+			continue;
+		}
+		for (unsigned int j=i+1; j < bundle.positionSize(); j++) {
+			Position & posJ = bundle.getPosition(j);
+			if (!posJ.atomExists("CA") || !posJ.atomExists("CB")) {
+				continue;
+			}
+			VectorPair vp(posI.getAtom("CA").getCoor(), posI.getAtom("CB").getCoor(), posJ.getAtom("CA").getCoor(), posJ.getAtom("CB").getCoor());
+			vp.calcAll();
+			string key = db.getHashKey(vp);
+			unsigned long long value = db.getHashValue(vp);
+			numVectorPairs++;
+			if (keyToValue.find(key) != keyToValue.end() && keyToValue[key] != value) {
+				cout << "NOT OK: key " << key << " has two hash values" << endl;
+				pass = false;
+			}
+			if (valueToKey.find(value) != valueToKey.end() && valueToKey[value] != key) {
+				cout << "NOT OK: keys " << key << " and " << valueToKey[value] << " have the same hash value" << endl;
+				pass = false;
+			}
+			keyToValue[key] = value;
+			valueToKey[value] = key;
+		}
+	}
+	cout << numVectorPairs << " vector pairs, " << keyToValue.size() << " string keys, " << valueToKey.size() << " hash values" << endl;
+
+	vector<map<string, vector<string> > > matches = query.searchForVectorMatchAll(db, 3);
+	cout << "Search: " << matches.size() << " matches" << endl;
+	if (matches.size() == 0) {
+		cout << "NOT OK: the chain was not found in the bundle" << endl;
+		pass = false;
+	}
+
+	// checkpoint round trip
+	if (!db.save_checkpoint("/tmp/testVectorHashing_db.vh") || !query.save_checkpoint("/tmp/testVectorHashing_query.vh")) {
+		cout << "NOT OK: cannot write the checkpoints" << endl;
+		pass = false;
+	}
+	VectorHashing dbLoaded;
+	VectorHashing queryLoaded;
+	if (!dbLoaded.load_checkpoint("/tmp/testVectorHashing_db.vh") || !queryLoaded.load_checkpoint("/tmp/testVectorHashing_query.vh")) {
+		cout << "NOT OK: cannot read the checkpoints" << endl;
+		pass = false;
+	}
+	if (dbLoaded.getNumberOfIds() != db.getNumberOfIds() || dbLoaded.getNumberOfVectorPairs() != db.getNumberOfVectorPairs() || dbLoaded.getNumberOfGeometricBins() != db.getNumberOfGeometricBins()) {
+		cout << "NOT OK: the reloaded database has " << dbLoaded.getNumberOfIds() << " ids, " << dbLoaded.getNumberOfVectorPairs() << " vector pairs, " << dbLoaded.getNumberOfGeometricBins() << " geometric bins" << endl;
+		pass = false;
+	}
+	if (queryLoaded.searchForVectorMatchAll(dbLoaded, 3) != matches) {
+		cout << "NOT OK: the reloaded hashes give different matches" << endl;
+		pass = false;
+	}
+	if (query.searchForVectorMatchAll(dbLoaded, 3) != matches) {
+		cout << "NOT OK: the reloaded database gives different matches" << endl;
+		pass = false;
+	}
+
+	// a truncated checkpoint must be rejected
+	ifstream fin("/tmp/testVectorHashing_db.vh", std::ios::binary);
+	string content((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+	fin.close();
+	ofstream fout("/tmp/testVectorHashing_truncated.vh", std::ios::binary);
+	fout.write(content.c_str(), content.size() / 2);
+	fout.close();
+	VectorHashing truncated;
+	if (truncated.load_checkpoint("/tmp/testVectorHashing_truncated.vh")) {
+		cout << "NOT OK: a truncated checkpoint was accepted" << endl;
+		pass = false;
+	}
+
+	if (pass) {
+		cout << "LEAD OK" << endl;
+	} else {
+		cout << "LEAD NOT OK" << endl;
+	}
+	return 0;
+}